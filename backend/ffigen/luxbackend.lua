@@ -125,6 +125,10 @@ if(luxcore) then
   content = append(content,"luxcore/sortradix.h")
   content = append(content,"luxcore/handlesys.h")
   content = append(content,"luxcore/refsys.h")
+  content = append(content,"luxcore/jobpool.h")
+  content = append(content,"luxcore/scalarmisc.h")
+  content = append(content,"luxcore/contscalararray.h")
+  content = append(content,"luxcore/contscalarexpr.h")
 
   export(
     "lxc | Lux Core",
@@ -139,8 +143,15 @@ if(luxscene) then
   local content = ""
   content = append(content,"luxscene/meshbase.h")
   content = append(content,"luxscene/meshvcacheopt.h")
-  --content = append(content,"luxscene/shader.h")
-  --content = append(content,"luxscene/drawsystem.h")
+  content = append(content,"luxscene/meshopt.h")
+  content = append(content,"luxscene/meshlet.h")
+  content = append(content,"luxscene/meshgen.h")
+  content = append(content,"luxscene/meshquantize.h")
+  content = append(content,"luxscene/meshcodec.h")
+  content = append(content,"luxscene/bvh.h")
+  content = append(content,"luxscene/shader.h")
+  content = append(content,"luxscene/drawsystem.h")
+  content = append(content,"luxscene/meshfile.h")
   
   export(
     "lxs | Lux Scene",
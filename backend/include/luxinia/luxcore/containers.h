@@ -8,6 +8,7 @@
 #include "contbitarray.h"
 #include "contoctree.h"
 #include "contscalararray.h"
+#include "contscalarexpr.h"
 #include "contmap.h"
 #include "contstringmap.h"
 #include "contvector.h"
@@ -7,6 +7,7 @@
 
 #include <luxinia/luxplatform/luxplatform.h>
 #include <luxinia/luxcore/scalarmisc.h>
+#include <luxinia/luxcore/jobpool.h>
 
 #ifdef __cplusplus
 extern "C"{
@@ -136,6 +137,82 @@ LUX_API booln lxScalarArray3D_Op2(lxScalarArray3D_t *ret, uint region[3], lxScal
 LUX_API booln lxScalarArray3D_Op3(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op,
             const lxScalarArray3D_t *arg0,  const lxScalarArray3D_t *arg1,  const lxScalarArray3D_t *arg2);
 
+//////////////////////////////////////////////////////////////////////////
+// ScalarArray Kernels
+//
+// OP2/OP3 on compact arrays (stride == vectordim, last arg may be single)
+// can use AVX2/FMA kernels, when compiled with LUX_SIMD_AVX2 and
+// supported by the cpu. Best kernel is picked when the library is
+// loaded, setKernel must not be called while ops are running.
+
+typedef enum lxScalarArrayKernel_e{
+  LUX_SCALAR_KERNEL_DEFAULT,
+  LUX_SCALAR_KERNEL_AVX2,
+  LUX_SCALAR_KERNELS,
+}lxScalarArrayKernel_t;
+
+LUX_API booln lxScalarArray_isKernelSupported(lxScalarArrayKernel_t kernel);
+  // unsupported kernels are ignored, returns active kernel
+LUX_API lxScalarArrayKernel_t lxScalarArray_setKernel(lxScalarArrayKernel_t kernel);
+LUX_API lxScalarArrayKernel_t lxScalarArray_getKernel();
+
+//////////////////////////////////////////////////////////////////////////
+// ScalarArray Threading
+//
+// With a pool set, Op0..Op3 and their 3D variants cut arrays of at
+// least minScalars scalars into cache-sized chunks, which the pool
+// processes in parallel. 3D regions are cut into slices, or rows
+// if the region is a single slice.
+// pool NULL (default) keeps all work on the calling thread,
+// minScalars 0 uses LUX_SCALARARRAY_MT_MINSCALARS.
+// Ops may run from several threads or from within jobs of the same
+// pool, while the pool is busy such ops run on the calling thread.
+
+#define LUX_SCALARARRAY_MT_MINSCALARS   (1024*256)
+
+LUX_API void lxScalarArray_setJobPool(lxJobPoolPTR pool, uint minScalars);
+LUX_API lxJobPoolPTR lxScalarArray_getJobPool();
+
+//////////////////////////////////////////////////////////////////////////
+// ScalarArray Reductions
+//
+// Combine all vectors of an array per component. Supports float32
+// and the 8/16/32-bit integer types, stride and vectordim are respected,
+// unused components of the outputs are left untouched.
+// Sums are accumulated in 64-bit for integers, and in float per chunk
+// of the array (combined in double) for float32.
+// Arrays are processed in chunks, which run on the job pool if set.
+// Results do not depend on the pool. NaNs are not handled.
+// return TRUE on error (unsupported type, empty array, mismatch)
+
+LUX_API booln lxScalarArray_sum(const lxScalarArray_t *sarr, double outsum[4]);
+LUX_API booln lxScalarArray_min(const lxScalarArray_t *sarr, lxScalarVector_t *outmin);
+LUX_API booln lxScalarArray_max(const lxScalarArray_t *sarr, lxScalarVector_t *outmax);
+  // any output can be NULL, indices are of first occurrence
+  // e.g. vector3 minmax of vertex positions gives bounding box
+LUX_API booln lxScalarArray_minMax(const lxScalarArray_t *sarr, lxScalarVector_t *outmin, lxScalarVector_t *outmax,
+              uint outminidx[4], uint outmaxidx[4]);
+  // sum of all products of components
+  // arrays must match in type and vectordim
+LUX_API booln lxScalarArray_dot(const lxScalarArray_t *sarr0, const lxScalarArray_t *sarr1, double *outdot);
+  // sqrt(dot(sarr,sarr))
+LUX_API booln lxScalarArray_length(const lxScalarArray_t *sarr, double *outlength);
+
+//////////////////////////////////////////////////////////////////////////
+// ScalarArray Scans
+//
+// Prefix sums per component, sOut and sIn must match in type and
+// vectordim, they can be identical.
+// Accumulation is in the array's type, integers wrap around.
+// Arrays of more than one chunk are done in two passes: chunk sums,
+// then every chunk is scanned starting with the sum of its predecessors.
+// The passes run on the job pool if set, results do not depend on it.
+
+  // out[i] = in[0] + ... + in[i]
+LUX_API booln lxScalarArray_scanInclusive(lxScalarArray_t *sOut, const lxScalarArray_t *sIn);
+  // out[i] = in[0] + ... + in[i-1], out[0] = 0
+LUX_API booln lxScalarArray_scanExclusive(lxScalarArray_t *sOut, const lxScalarArray_t *sIn);
+
 //booln ScalarArray3D_convolute(ScalarArray3D_t *ret, const ScalarArray3D_t *arg0, const ScalarArray3D_t *weights, booln wrap);
 
 //////////////////////////////////////////////////////////////////////////
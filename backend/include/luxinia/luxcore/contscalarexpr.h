@@ -0,0 +1,69 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXCORE_CONTSCALAREXPR_H__
+#define __LUXCORE_CONTSCALAREXPR_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxcore/memorybase.h>
+#include <luxinia/luxcore/contscalararray.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// ScalarExpr
+//
+// Records ScalarArray operations into a small graph, which is evaluated
+// in one pass. Evaluation walks the arrays in chunks of
+// LUX_SCALAREXPR_CHUNK vectors, intermediate results only live in
+// per-chunk scratch buffers that stay in L1. A chain like
+// lerp -> madd -> min reads its inputs and writes its result once,
+// instead of streaming every intermediate array through memory.
+//
+// Nodes are referenced by the index the add functions return, operands
+// must be added before they are used. All inputs must be of the
+// expression's type and vectordim, or vectordim 1. Inputs with
+// vectordim 1 and stride 0 are single values used for all vectors,
+// other vectordim 1 inputs may only be the last operand of an op.
+// The graph can be re-evaluated with new arrays via setInput.
+//
+// If lxScalarArray_setJobPool is active, chunks are processed in
+// parallel.
+// NOT THREADSAFE!!
+
+#define LUX_SCALAREXPR_MAX_NODES  32
+#define LUX_SCALAREXPR_CHUNK      512
+
+typedef struct lxScalarExpr_s* lxScalarExprPTR;
+
+LUX_API lxScalarExprPTR lxScalarExpr_new(lxMemoryAllocatorPTR allocator, lxScalarType_t type, uint vectordim);
+LUX_API void  lxScalarExpr_delete(lxScalarExprPTR expr);
+  // removes all nodes
+LUX_API void  lxScalarExpr_clear(lxScalarExprPTR expr);
+LUX_API uint  lxScalarExpr_getCount(lxScalarExprPTR expr);
+
+  // all return node index or -1 on error
+LUX_API int   lxScalarExpr_input(lxScalarExprPTR expr, const lxScalarArray_t *sarr);
+  // LUX_SCALAR_OP2_*
+LUX_API int   lxScalarExpr_op2(lxScalarExprPTR expr, lxScalarArrayOp_t op, int node0, int node1);
+  // LUX_SCALAR_OP3_*
+LUX_API int   lxScalarExpr_op3(lxScalarExprPTR expr, lxScalarArrayOp_t op, int node0, int node1, int node2);
+  // float only, vectordim 2-4. arg is Matrix44 or NULL
+  // as in lxFScalarArray_op1, it is copied
+LUX_API int   lxScalarExpr_fop1(lxScalarExprPTR expr, lxFScalarArrayOp_t op, int node0, const float *arg);
+
+  // replaces array of input node, returns TRUE on error
+LUX_API booln lxScalarExpr_setInput(lxScalarExprPTR expr, int node, const lxScalarArray_t *sarr);
+
+  // writes node's result to sOut, count is minimum of
+  // sOut and all used non-single inputs. returns TRUE on error
+LUX_API booln lxScalarExpr_eval(lxScalarExprPTR expr, int node, lxScalarArray_t *sOut);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
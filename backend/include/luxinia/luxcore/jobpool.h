@@ -0,0 +1,52 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXCORE_JOBPOOL_H__
+#define __LUXCORE_JOBPOOL_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include "memorybase.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+  //////////////////////////////////////////////////////////////////////////
+  // JobPool
+  //
+  // Fixed set of worker threads that process numbered jobs.
+  // lxJobPool_run hands out job indices 0..numJobs-1 to the workers and
+  // the calling thread, and returns once all jobs have finished.
+  // Jobs are claimed one by one, so many small jobs balance better
+  // than one per thread.
+  //
+  // Only one lxJobPool_run may be active per pool at a time,
+  // func must not call lxJobPool_run on the same pool. Code that may
+  // run concurrently or from within jobs uses lxJobPool_tryRun and
+  // falls back to the calling thread when the pool is busy.
+
+  typedef struct lxJobPool_s* lxJobPoolPTR;
+
+  // threadindex is 0 for calling thread, 1..getThreadCount-1 for workers
+  typedef void (lxJobPoolFunc_fn)(void* userdata, uint jobindex, uint threadindex);
+
+  // numThreads includes calling thread, 0 uses lxCPU_getCount
+  LUX_API lxJobPoolPTR  lxJobPool_new(lxMemoryAllocatorPTR allocator, uint numThreads);
+  LUX_API void      lxJobPool_delete(lxJobPoolPTR pool);
+
+  LUX_API uint      lxJobPool_getThreadCount(lxJobPoolPTR pool);
+
+  // blocks until all jobs are done
+  // pool can be NULL, then all jobs run on the calling thread
+  LUX_API void      lxJobPool_run(lxJobPoolPTR pool, uint numJobs, lxJobPoolFunc_fn *func, void* userdata);
+
+  // same as run, but returns FALSE without running any job if the
+  // pool is busy with another run (other thread, or called from a job)
+  LUX_API booln     lxJobPool_tryRun(lxJobPoolPTR pool, uint numJobs, lxJobPoolFunc_fn *func, void* userdata);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
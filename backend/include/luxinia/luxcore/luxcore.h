@@ -13,5 +13,6 @@
 #include "sortradix.h"
 #include "refsys.h"
 #include "handlesys.h"
+#include "jobpool.h"
 
 #endif
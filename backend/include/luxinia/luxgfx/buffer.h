@@ -55,6 +55,103 @@ extern "C"{
   LUX_API void lxgBuffer_reset(lxgBufferPTR buffer, void* data);
   LUX_API void lxgBuffer_init(lxgBufferPTR buffer, lxgContextPTR ctx, lxGLBufferHint_t hint, uint size, void* data);
 
+  //////////////////////////////////////////////////////////////////////////
+  // lxgBufferRing
+  //
+  // Streams dynamic per-frame data (instances, uniforms, particles)
+  // through one buffer. Allocations are aligned suballocations of a
+  // ring, mapped unsynchronized. Each frame must follow this order:
+  //
+  //  alloc     any number, writes go to the mapped free space
+  //  flush     unmaps, GL rejects draws sourcing a mapped buffer
+  //  draws     sourcing the returned offsets
+  //  endFrame  fences the frame, so it must come after its draws
+  //
+  // alloc after flush maps the remaining free space again, so several
+  // alloc/flush/draw batches per frame are fine. Frames are recycled
+  // once their fence has passed, only when the ring is full the oldest
+  // frame is waited for.
+  //
+  // Without sync objects (LUXGFX_CAP_API3) the ring maps synchronized
+  // and does not fence, then the driver waits on maps instead.
+  //
+  // The CPU mode runs on caller memory without GL, frames complete
+  // when lxgBufferRing_signalCPU is called, waiting on an incomplete
+  // frame counts as stall and completes it.
+
+  enum{
+    LUXGFX_RING_MAXFRAMES = 8,
+  };
+
+  typedef struct lxgBufferRingFrame_s{
+    GLsync      fence;
+    uint32      id;
+      // head after the frame and bytes including padding
+    uint32      end;
+    uint32      bytes;
+  }lxgBufferRingFrame_t;
+
+  typedef struct lxgBufferRingStats_s{
+    uint64      bytesStreamed;
+      // alignment and wrap-around padding
+    uint64      bytesPadding;
+    uint        numAllocs;
+    uint        numFailed;
+    uint        numWraps;
+    uint        numFrames;
+    uint        numMaps;
+      // waits on fences
+    uint        numStalls;
+      // unsynchronized maps while older frames were in flight,
+      // a synchronized map would have waited
+    uint        stallsAvoided;
+  }lxgBufferRingStats_t;
+
+  typedef struct lxgBufferRing_s{
+    lxgBufferPTR          buffer;
+    byte*                 memory;
+    uint32                size;
+    uint32                align;
+    uint32                head;
+    uint32                tail;
+    uint32                used;
+    uint32                frameBytes;
+    uint32                frameID;
+    uint32                completedID;
+
+    uint                  firstPending;
+    uint                  numPending;
+    lxgBufferRingFrame_t  pending[LUXGFX_RING_MAXFRAMES];
+
+      // fences and unsynchronized maps are used
+    booln                 sync;
+
+    byte*                 mapped;
+    uint32                mapBegin;
+    uint32                mapEnd;
+    uint32                mapWritten;
+
+    lxgBufferRingStats_t  stats;
+  }lxgBufferRing_t;
+
+    // align must be power of 2
+  LUX_API void  lxgBufferRing_init(lxgBufferRing_t* ring, lxgBufferPTR buffer, uint align);
+  LUX_API void  lxgBufferRing_initCPU(lxgBufferRing_t* ring, void* memory, uint size, uint align);
+    // waits for all frames
+  LUX_API void  lxgBufferRing_deinit(lxgBufferRing_t* ring);
+
+    // returns pointer to write to and buffer offset, NULL if size
+    // does not fit next to the current frame's allocations or mapping
+    // fails, the ring is unchanged then
+  LUX_API void* lxgBufferRing_alloc(lxgBufferRing_t* ring, uint size, uint* offset);
+    // unmaps, must be called before draws source the allocations
+  LUX_API void  lxgBufferRing_flush(lxgBufferRing_t* ring);
+    // fences the frame's allocations, call after the frame's draws
+    // were issued, returns frame id
+  LUX_API uint32 lxgBufferRing_endFrame(lxgBufferRing_t* ring);
+    // CPU mode, frames up to id have completed
+  LUX_API void  lxgBufferRing_signalCPU(lxgBufferRing_t* ring, uint32 id);
+
   //////////////////////////////////////////////////////////////////////////
 
   LUX_INLINE void lxgBuffer_bind(lxgBufferCPTR buffer, lxGLBufferTarget_t type )
@@ -0,0 +1,199 @@
+// Copyright (C) 2010-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXLUXGFX_CMDLIST_H__
+#define __LUXLUXGFX_CMDLIST_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxplatform/debug.h>
+
+#include "context.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+  //////////////////////////////////////////////////////////////////////////
+  // lxgCmdList
+  //
+  // Records state changes and draws into caller provided memory, so
+  // traversal can run on any thread and only replay touches GL. Lists
+  // do not share anything, every worker records its own.
+  //
+  // Commands start with lxgCmd_t, size includes the header and keeps
+  // the payload pointer aligned. Objects are referenced, not copied,
+  // and must stay valid until replay. Stream hosts, texture / sampler
+  // arrays and parameter arrays are copied, parameter data is not.
+  //
+  // When memory runs out, overflow is set and further commands are
+  // dropped. Replay goes through the lxgContext_checked* functions,
+  // lxgCmdList_validate replays without GL and only counts and checks.
+
+  typedef enum lxgCmdType_e{
+    LUXGFX_CMD_PROGRAM,
+    LUXGFX_CMD_PROGRAMPARAMS,
+    LUXGFX_CMD_TEXTURES,
+    LUXGFX_CMD_SAMPLERS,
+    LUXGFX_CMD_TEXTUREIMAGES,
+    LUXGFX_CMD_VERTEXDECL,
+    LUXGFX_CMD_VERTEXSTREAM,
+    LUXGFX_CMD_VERTEXATTRIBS,
+    LUXGFX_CMD_INDEXBUFFER,
+    LUXGFX_CMD_BLEND,
+    LUXGFX_CMD_DEPTH,
+    LUXGFX_CMD_LOGIC,
+    LUXGFX_CMD_STENCIL,
+    LUXGFX_CMD_COLOR,
+    LUXGFX_CMD_RASTERIZER,
+    LUXGFX_CMD_RENDERTARGET,
+    LUXGFX_CMD_DRAW,
+    LUXGFX_CMDS,
+  }lxgCmdType_t;
+
+  typedef struct lxgCmd_s{
+    uint16      type;
+    uint16      size;
+      // textures, samplers, images: start | (num << 16)
+      // params: num, stream: index, attribs: needed
+      // rendertarget: lxgRenderTargetType_t
+    uint32      arg;
+  }lxgCmd_t;
+
+  typedef struct lxgDrawCall_s{
+    lxGLPrimitiveType_t   primitive;
+      // LUX_SCALAR_ILLEGAL for non-indexed draws
+    lxScalarType_t        indexType;
+    uint32                count;
+      // first vertex, or byte offset into the index buffer
+    uint32                first;
+    int32                 baseVertex;
+      // 0 or 1 for non-instanced
+    uint32                instances;
+  }lxgDrawCall_t;
+
+    // program, decl, index buffer, raster states and rendertarget
+  typedef struct lxgCmdObject_s{
+    lxgCmd_t          cmd;
+    const void*       obj;
+  }lxgCmdObject_t;
+
+    // textures, samplers and images, followed by num pointers
+  typedef struct lxgCmdBinds_s{
+    lxgCmd_t          cmd;
+    const void*       objs[1];
+  }lxgCmdBinds_t;
+
+    // followed by num parameters and num data pointers
+  typedef struct lxgCmdParams_s{
+    lxgCmd_t          cmd;
+    lxgProgramCPTR    prog;
+  }lxgCmdParams_t;
+
+  typedef struct lxgCmdStream_s{
+    lxgCmd_t          cmd;
+    lxgStreamHost_t   host;
+  }lxgCmdStream_t;
+
+  typedef struct lxgCmdDraw_s{
+    lxgCmd_t          cmd;
+    lxgDrawCall_t     draw;
+  }lxgCmdDraw_t;
+
+  typedef struct lxgCmdList_s{
+    byte*       begin;
+    byte*       cur;
+    byte*       end;
+    uint        numCmds;
+    uint        numDraws;
+    booln       overflow;
+  }lxgCmdList_t;
+
+  typedef struct lxgCmdStats_s{
+    uint        counts[LUXGFX_CMDS];
+    uint        numCmds;
+    uint        numDraws;
+      // sum of count * instances
+    uint64      numElements;
+    size_t      bytes;
+      // malformed commands, missing objects, draws without
+      // program / vertex decl, units or streams out of range
+    uint        numErrors;
+  }lxgCmdStats_t;
+
+  LUX_API void  lxgCmdList_init(lxgCmdList_t* list, void* memory, size_t size);
+  LUX_API void  lxgCmdList_reset(lxgCmdList_t* list);
+
+  LUX_API void  lxgCmdList_program(lxgCmdList_t* list, lxgProgramCPTR prog);
+  LUX_API void  lxgCmdList_programParameters(lxgCmdList_t* list, lxgProgramCPTR prog, uint num, lxgProgramParameterPTR *params, const void **data);
+  LUX_API void  lxgCmdList_textures(lxgCmdList_t* list, lxgTexturePTR *texs, uint start, uint num);
+  LUX_API void  lxgCmdList_samplers(lxgCmdList_t* list, lxgSamplerCPTR *samps, uint start, uint num);
+  LUX_API void  lxgCmdList_textureImages(lxgCmdList_t* list, lxgTextureImageCPTR *imgs, uint start, uint num);
+  LUX_API void  lxgCmdList_vertexDecl(lxgCmdList_t* list, lxgVertexDeclCPTR decl);
+  LUX_API void  lxgCmdList_vertexStream(lxgCmdList_t* list, uint idx, lxgStreamHostCPTR host);
+  LUX_API void  lxgCmdList_vertexAttribs(lxgCmdList_t* list, flags32 needed);
+  LUX_API void  lxgCmdList_indexBuffer(lxgCmdList_t* list, lxgBufferCPTR buffer);
+  LUX_API void  lxgCmdList_blend(lxgCmdList_t* list, lxgBlendCPTR obj);
+  LUX_API void  lxgCmdList_depth(lxgCmdList_t* list, lxgDepthCPTR obj);
+  LUX_API void  lxgCmdList_logic(lxgCmdList_t* list, lxgLogicCPTR obj);
+  LUX_API void  lxgCmdList_stencil(lxgCmdList_t* list, lxgStencilCPTR obj);
+  LUX_API void  lxgCmdList_color(lxgCmdList_t* list, lxgColorCPTR obj);
+  LUX_API void  lxgCmdList_rasterizer(lxgCmdList_t* list, lxgRasterizerCPTR obj);
+  LUX_API void  lxgCmdList_renderTarget(lxgCmdList_t* list, lxgRenderTargetPTR rt, lxgRenderTargetType_t type);
+  LUX_API void  lxgCmdList_draw(lxgCmdList_t* list, const lxgDrawCall_t* draw);
+
+  // replays on the GL thread, lists are replayed in order
+  LUX_API void  lxgCmdList_replay(lxgContextPTR ctx, const lxgCmdList_t* lists, uint numLists);
+
+  // null replay, accumulates into stats (clear before first use)
+  // returns TRUE if no errors were found
+  LUX_API booln lxgCmdList_validate(const lxgCmdList_t* list, lxgCmdStats_t* stats);
+
+  //////////////////////////////////////////////////////////////////////////
+  // Optimization
+  //
+  // Rewrites a list so that state is only set right before the draw
+  // that needs it: changes overwritten before the next draw and values
+  // equal to the ones already set are dropped. Texture, sampler and
+  // image binds of neighbouring units are merged into ranged commands,
+  // samplers are emitted before textures. Program parameters stay in
+  // place, the program they refer to is flushed before them.
+  // State is tracked within the list only, the first value of every
+  // slot is always kept. Draws see the same state as before.
+
+  typedef struct lxgCmdOptStats_s{
+    uint        countsIn[LUXGFX_CMDS];
+    uint        countsOut[LUXGFX_CMDS];
+    uint        numIn;
+    uint        numOut;
+    size_t      bytesIn;
+    size_t      bytesOut;
+  }lxgCmdOptStats_t;
+
+  // dst must not be src and needs at least the bytes used by src,
+  // output never grows. stats can be NULL, otherwise accumulates.
+  // returns FALSE if dst overflowed
+  LUX_API booln lxgCmdList_optimize(lxgCmdList_t* dst, const lxgCmdList_t* src, lxgCmdOptStats_t* stats);
+
+  //////////////////////////////////////////////////////////////////////////
+
+  LUX_INLINE const lxgCmd_t* lxgCmdList_first(const lxgCmdList_t* list)
+  {
+    return (const lxgCmd_t*)list->begin;
+  }
+
+  LUX_INLINE const lxgCmd_t* lxgCmdList_next(const lxgCmd_t* cmd)
+  {
+    return (const lxgCmd_t*)(((const byte*)cmd) + cmd->size);
+  }
+
+  LUX_INLINE booln lxgCmdList_isEnd(const lxgCmdList_t* list, const lxgCmd_t* cmd)
+  {
+    return (const byte*)cmd >= list->cur;
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
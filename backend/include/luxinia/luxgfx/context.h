@@ -263,8 +263,8 @@ extern "C"{
   LUX_INLINE void lxgContext_checkedTextures( lxgContextPTR ctx, lxgTexturePTR *texs, uint start, uint num )
   {
     LUX_ASSUME(num >= 1 && num <= LUXGFX_MAX_TEXTURE_IMAGES);
-    LUX_DEBUGASSERT(start + num < LUXGFX_MAX_TEXTURE_IMAGES);
-    if (memcmp(&ctx->textures[start],texs,sizeof(lxgTexturePTR )*num)){
+    LUX_DEBUGASSERT(start + num <= LUXGFX_MAX_TEXTURE_IMAGES);
+    if (memcmp((const void*)&ctx->textures[start],(const void*)texs,sizeof(lxgTexturePTR )*num)){
       lxgContext_applyTextures(ctx, texs,start,num);
     }
   }
@@ -272,8 +272,8 @@ extern "C"{
   LUX_INLINE void lxgContext_checkedSamplers( lxgContextPTR ctx, lxgSamplerCPTR *samps, uint start, uint num )
   {
     LUX_ASSUME(num >= 1 && num <= LUXGFX_MAX_TEXTURE_IMAGES);
-    LUX_DEBUGASSERT(start + num < LUXGFX_MAX_TEXTURE_IMAGES);
-    if (memcmp(&ctx->samplers[start],samps,sizeof(lxgSamplerPTR)*num)){
+    LUX_DEBUGASSERT(start + num <= LUXGFX_MAX_TEXTURE_IMAGES);
+    if (memcmp((const void*)&ctx->samplers[start],(const void*)samps,sizeof(lxgSamplerPTR)*num)){
       lxgContext_applySamplers(ctx, samps,start,num);
     }
   }
@@ -281,8 +281,8 @@ extern "C"{
   LUX_INLINE void lxgContext_checkedTextureImages( lxgContextPTR ctx, lxgTextureImageCPTR* imgs, uint start, uint num )
   {
     LUX_ASSUME(num >= 1 && num <= LUXGFX_MAX_RWTEXTURE_IMAGES);
-    LUX_DEBUGASSERT(start + num < LUXGFX_MAX_RWTEXTURE_IMAGES);
-    if (memcmp(&ctx->images[start],imgs,sizeof(lxgTextureImagePTR)*num)){
+    LUX_DEBUGASSERT(start + num <= LUXGFX_MAX_RWTEXTURE_IMAGES);
+    if (memcmp((const void*)&ctx->images[start],(const void*)imgs,sizeof(lxgTextureImagePTR)*num)){
       lxgContext_applyTextureImages(ctx, imgs,start,num);
     }
   }
@@ -8,5 +8,6 @@
 #include <luxinia/luxplatform/luxplatform.h>
 
 #include "context.h"
+#include "cmdlist.h"
 
 #endif
@@ -59,6 +59,44 @@ LUX_API void lxQuatGetBarycentric(lxQuat q,float f, float g, const lxQuat q1, co
 
 LUX_API void lxQuatSwizzle(lxQuat out, uint axis[3], lxVector3 dirs);
 
+//////////////////////////////////////////////////////////////////////////
+// QuatSoA
+//
+// Batch operations on many quaternions, stored as structure of arrays.
+// With LUX_SIMD_SSE four quaternions are processed per instruction,
+// all component arrays must be 16-byte aligned then. The remainder
+// (count % 4) is processed by the regular scalar functions.
+// With LUX_SIMD_AVX2 and a cpu supporting AVX, all but slerpFast
+// process eight quaternions per instruction, alignment stays 16 bytes.
+// Output may alias input arrays.
+
+typedef struct lxQuatSoA_s{
+  float*  x;
+  float*  y;
+  float*  z;
+  float*  w;
+}lxQuatSoA_t;
+
+typedef lxQuatSoA_t* LUX_RESTRICT lxQuatSoAPTR;
+typedef const lxQuatSoA_t* LUX_RESTRICT lxQuatSoACPTR;
+
+  // same order of operations as lxQuatMul
+LUX_API void lxQuatSoA_mul(lxQuatSoAPTR qout, lxQuatSoACPTR q2, lxQuatSoACPTR q1, uint count);
+LUX_API void lxQuatSoA_normalize(lxQuatSoAPTR qout, lxQuatSoACPTR q, uint count);
+
+  // shortest path, per-quaternion weights in t
+LUX_API void lxQuatSoA_nlerp(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint count);
+
+  // shortest path, per-quaternion weights in t
+  // uses polynomial acos and lxFastSinCos_ps,
+  // max component error to lxQuatSlerp is < 1e-6
+LUX_API void lxQuatSoA_slerpFast(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint count);
+
+  // q must be normalized, writes the rotation part
+  // like lxQuatToMatrix, but also clears [3],[7],[11]
+  // translation column is left untouched
+LUX_API void lxQuatSoA_toMatrix(lxQuatSoACPTR q, lxMatrix44* matrices, uint count);
+
 //////////////////////////////////////////////////////////////////////////
 
 typedef struct Quat_s {
@@ -77,7 +77,7 @@ LUX_INLINE float lxVector2LengthFast( const lxVector2 pV )
 
 LUX_INLINE float lxVector2SqLength( const lxVector2 pV )
 {
-  return pV[0] * pV[0] + pV[1] * pV[1] + pV[2];
+  return pV[0] * pV[0] + pV[1] * pV[1];
 }
 
 LUX_INLINE float lxVector2Dot( const lxVector2 pV1, const lxVector2 pV2 )
@@ -0,0 +1,37 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+
+
+#ifndef __LUXPLATFORM_CPU_H__
+#define __LUXPLATFORM_CPU_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// CPU
+
+typedef enum lxCPUFeature_e{
+  LUX_CPU_SSE2    = 1<<0,
+  LUX_CPU_SSE41   = 1<<1,
+  // AVX flags are only set if the os saves the ymm registers
+  LUX_CPU_AVX     = 1<<2,
+  LUX_CPU_AVX2    = 1<<3,
+  LUX_CPU_FMA     = 1<<4,
+}lxCPUFeature_t;
+
+  // bitmask of lxCPUFeature_t, queried once
+LUX_API uint32  lxCPU_getFeatures();
+  // number of logical processors
+LUX_API uint    lxCPU_getCount();
+
+#ifdef __cplusplus
+};  
+#endif
+
+#endif
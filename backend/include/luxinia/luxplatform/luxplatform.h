@@ -51,6 +51,8 @@
 //    if SIMD functionality can be assumed as minimum
 //    depending on compiler & architecture LUX_SIMD_SSE is set
 //    to allow xmmintrin.h functionality
+//    LUX_SIMD_AVX2 is set if the compiler provides AVX2/FMA intrinsics,
+//    their use must be checked at runtime (lxCPU_getFeatures)
 //
 //  LUX_RENDERBACKEND
 //    one of the following is legal
@@ -161,6 +163,9 @@
   // we have support for xmmintrin
   #define LUX_SIMD_SSE
   #include <xmmintrin.h>
+  #if (_MSC_VER >= 1700)
+  #define LUX_SIMD_AVX2
+  #endif
   #define LUX_ALIGNSIMD_V(x)    LUX_ALIGN_V( x, 16 )
   #define LUX_ALIGNSIMD_BEGIN   LUX_ALIGN_BEGIN( 16 )
   #define LUX_ALIGNSIMD_END     LUX_ALIGN_END( 16 )
@@ -0,0 +1,124 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXSCENE_BVH_H__
+#define __LUXSCENE_BVH_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxmath/basetypes.h>
+#include <luxinia/luxcore/memorybase.h>
+#include <luxinia/luxcore/jobpool.h>
+#include <luxinia/luxscene/meshbase.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Bounding Volume Hierarchy
+//
+// Binary tree over primitive boxes, built with the binned surface area
+// heuristic (Wald, "On fast Construction of SAH-based Bounding Volume
+// Hierarchies"). Primitives are either triangles of a mesh or a set of
+// boxes, like the bbox of lxDrawBounding_t arrays.
+//
+// Nodes are 32 bytes, min/max are at the same offsets as in
+// lxBoundingBox_t, so a node can be passed to the lxFrustum functions.
+// The children of a node are stored next to each other and always
+// after their parent. Every subtree covers a continuous range of prims.
+//
+// Builds split the upper levels on the calling thread, the remaining
+// subtrees are built as jobs of the pool (can be NULL). The depth is
+// limited to LUX_BVH_MAX_DEPTH by falling back to median splits.
+//
+// Refit keeps the topology and only updates the boxes, which is
+// sufficient for deforming content that keeps its coherence.
+// Queries are threadsafe.
+
+enum{
+  LUX_BVH_MAX_DEPTH = 64,
+  LUX_BVH_BINS      = 16,
+    // default primitives per leaf
+  LUX_BVH_LEAFSIZE  = 4,
+  LUX_BVH_NOHIT     = 0xFFFFFFFF,
+};
+
+typedef struct lxBVHNode_s{
+  float     min[3];
+    // leaf: first entry in prims, inner: left child, right is left + 1
+  uint32    first;
+  float     max[3];
+    // primitives of leaf, 0 for inner nodes
+  uint32    count;
+}lxBVHNode_t;
+
+typedef struct lxBVH_s{
+  lxMemoryAllocatorPTR  allocator;
+  lxBVHNode_t*  nodes;
+  uint32        numNodes;
+  uint32        numNodesAllocated;
+    // primitive index per leaf entry
+  uint32*       prims;
+  uint32        numPrims;
+  uint32        numPrimsAllocated;
+  uint32        depth;
+}lxBVH_t;
+
+typedef struct lxBVHTriangles_s{
+    // float[3]
+  const float*        positions;
+  size_t              posStride;
+    // can be NULL for unindexed triangles
+  const void*         indices;
+  lxMeshIndexType_t   indexType;
+  uint32              numTriangles;
+}lxBVHTriangles_t;
+
+typedef struct lxBVHHit_s{
+  float     t;
+    // barycentric weights of vertex 1 and 2, 0 for boxes
+  float     u;
+  float     v;
+    // triangle or box index, LUX_BVH_NOHIT if nothing was hit
+  uint32    prim;
+}lxBVHHit_t;
+
+LUX_API void  lxBVH_init(lxBVH_t* bvh, lxMemoryAllocatorPTR allocator);
+LUX_API void  lxBVH_deinit(lxBVH_t* bvh);
+
+  // boxes are read with boxStride bytes between them, for
+  // lxDrawBounding_t arrays pass &array[0].bbox and its size.
+  // maxLeafSize 0 uses LUX_BVH_LEAFSIZE.
+  // returns TRUE on error
+LUX_API booln lxBVH_buildBoxes(lxBVH_t* bvh, lxJobPoolPTR pool, const lxBoundingBox_t* boxes, size_t boxStride, uint32 numBoxes, int maxLeafSize);
+LUX_API booln lxBVH_buildTriangles(lxBVH_t* bvh, lxJobPoolPTR pool, const lxBVHTriangles_t* tris, int maxLeafSize);
+
+  // same primitives as in the build, with new positions
+LUX_API void  lxBVH_refitBoxes(lxBVH_t* bvh, const lxBoundingBox_t* boxes, size_t boxStride);
+LUX_API void  lxBVH_refitTriangles(lxBVH_t* bvh, const lxBVHTriangles_t* tris);
+
+  // closest hit with t in [0,maxDist], dir does not need to be
+  // normalized, t is in units of dir. Boxes are hit at their entry,
+  // or at 0 when origin is inside.
+  // returns TRUE if something was hit
+LUX_API booln lxBVH_rayTriangles(const lxBVH_t* bvh, const lxBVHTriangles_t* tris,
+  const lxVector3 origin, const lxVector3 dir, float maxDist, lxBVHHit_t* hit);
+LUX_API booln lxBVH_rayBoxes(const lxBVH_t* bvh, const lxBoundingBox_t* boxes, size_t boxStride,
+  const lxVector3 origin, const lxVector3 dir, float maxDist, lxBVHHit_t* hit);
+
+  // writes primitives whose node is not outside the frustum, subtrees
+  // completely inside are taken without further tests.
+  // frustum plane signs must be set, as by lxFrustum_update.
+  // returns number of primitives, at most maxPrims
+LUX_API uint32 lxBVH_cullFrustum(const lxBVH_t* bvh, lxFrustumCPTR frustum, uint32* prims, uint32 maxPrims);
+
+  // surface area heuristic cost of the tree, relative to the root
+  // (traversal and primitive cost are 1)
+LUX_API float lxBVH_getCost(const lxBVH_t* bvh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
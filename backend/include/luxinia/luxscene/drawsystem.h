@@ -6,8 +6,10 @@
 #define __LUXSCENE_DRAWSYS_H__
 
 
+#include <luxinia/luxgfx/vertex.h>
 #include <luxinia/luxscene/shader.h>
 #include <luxinia/luxscene/meshbase.h>
+#include <luxinia/luxscene/meshopt.h>
 #include <luxinia/luxmath/basetypes.h>
 
 #ifdef __cplusplus
@@ -19,20 +21,79 @@ extern "C"{
     lxBoundingBox_t     bbox;
   }lxDrawBounding_t;
 
+  //////////////////////////////////////////////////////////////////////////
+  // lxDrawSpatial
+  //
+  // Transform hierarchy kept in flat arrays per slot. Slots are in depth
+  // first order: a parent always precedes its children and every subtree
+  // covers a continuous range of slots. updateTree is a linear sweep
+  // over the ranges of changed nodes, world = parent world * local.
+  //
+  // Nodes are referenced by a stable id, their slot changes with the
+  // topology. Adding children to the most recently added subtree, like
+  // when loading depth first, keeps the order. Other topology changes
+  // re-sort all nodes once at the next updateTree.
+  //
+  // Draw items are stored by the spatial, grouped by the slot of their
+  // node, so every subtree also covers a continuous range of items.
+  // Each slot keeps the box of its whole subtree for hierarchical
+  // culling, subtrees completely inside the frustum are taken without
+  // further tests.
+  // World matrices, boundings and culling are valid after updateTree.
+
+  enum{
+      // created by init, cannot be removed
+    LUX_DRAWSPATIAL_ROOT  = 0,
+    LUX_DRAWSPATIAL_NONE  = 0xFFFFFFFF,
+  };
+
   typedef struct lxDrawSpatial_s{
-    lxMatrix44PTR       localMatrix;
-    lxMatrix44PTR       localMatrixInv;
-    lxDrawBounding_t*   localBounding;
-    lxMatrix44PTR       worldMatrix;
-    lxMatrix44PTR       worldMatrixInv;
-    lxDrawBounding_t*   worldBounding;
-    struct lxDrawSpatial_s*  sibling;
-    struct lxDrawSpatial_s*  children;
-    // -- 128 byte barrier in 64-bit --
-    struct lxDrawSpatial_s*  parent;
-    uint32              numChildren;
-    lxContVector_t      drawBoundings;
-    lxContVector_t      drawItems;
+    lxMemoryAllocatorPTR  allocator;
+      // per slot, matrices and boundings are 16 byte aligned
+    uint32              numSlots;
+    uint32              numSlotsAllocated;
+    lxMatrix44SIMD*     localMatrices;
+    lxMatrix44SIMD*     worldMatrices;
+    lxDrawBounding_t*   localBoundings;
+    lxDrawBounding_t*   worldBoundings;
+      // slot of parent, root is its own parent
+    uint32*             parents;
+      // slot after the last descendant
+    uint32*             subtreeEnds;
+    uint32*             slotNodes;
+    byte*               slotFlags;
+      // per node id
+    uint32              numNodes;
+    uint32              numNodesAllocated;
+    uint32*             nodeSlots;
+    uint32*             nodeParents;
+    uint32*             freeNodes;
+    uint32              numFree;
+      // slots changed since last update
+    uint32*             dirty;
+    uint32              numDirty;
+    booln               reorder;
+      // per slot, box of subtree including items
+    lxBoundingBox_t*    treeBoxes;
+      // items of slot are [itemFirst[slot],itemFirst[slot+1])
+    uint32*             itemFirst;
+    uint32*             refit;
+    uint32              numRefit;
+      // per item position, grouped by slot
+    uint32              numItems;
+    uint32              numItemsAllocated;
+    struct lxDrawItem_s*  items;
+    lxDrawBounding_t*   itemLocalBoundings;
+    lxDrawBounding_t*   itemWorldBoundings;
+    uint32*             itemIDs;
+      // per item id
+    uint32              numItemIDs;
+    uint32              numItemIDsAllocated;
+    uint32*             itemPositions;
+    uint32*             itemNodes;
+    uint32*             freeItems;
+    uint32              numFreeItems;
+    booln               itemsReorder;
   }lxDrawSpatial_t;
 
   //////////////////////////////////////////////////////////////////////////
@@ -63,21 +124,83 @@ extern "C"{
     lxDrawGeometry_t*         geometry;
     lxShaderLevel_t           itemLevel;
     lxDrawSpatial_t*          spatial;
+    uint32                    spatialNode;
   }lxDrawItem_t;
 
 
   //////////////////////////////////////////////////////////////////////////
 
+  // if allocations fail, init leaves the spatial without root, so
+  // adding nodes fails. reserve is only a hint.
   LUX_API void  lxDrawSpatial_init(lxDrawSpatial_t* spatial, lxMemoryAllocatorPTR allocator);
   LUX_API void  lxDrawSpatial_deinit(lxDrawSpatial_t* spatial);
+  LUX_API void  lxDrawSpatial_reserve(lxDrawSpatial_t* spatial, uint32 numNodes);
+
+  // new node has identity matrix and empty bounding
+  // returns node id, LUX_DRAWSPATIAL_NONE on error
+  LUX_API uint32  lxDrawSpatial_addNode(lxDrawSpatial_t* spatial, uint32 parent);
+  // removes node and its subtree, their ids become invalid at once
+  // and may be reused after the next updateTree
+  LUX_API void  lxDrawSpatial_remNode(lxDrawSpatial_t* spatial, uint32 node);
+  // returns TRUE on error, e.g. if parent is within the subtree of node
+  LUX_API booln lxDrawSpatial_setParent(lxDrawSpatial_t* spatial, uint32 node, uint32 parent);
+  LUX_API uint32  lxDrawSpatial_getParent(const lxDrawSpatial_t* spatial, uint32 node);
+
+  LUX_API void  lxDrawSpatial_setLocalMatrix(lxDrawSpatial_t* spatial, uint32 node, lxMatrix44CPTR matrix);
+  LUX_API lxMatrix44CPTR  lxDrawSpatial_getLocalMatrix(const lxDrawSpatial_t* spatial, uint32 node);
+  LUX_API lxMatrix44CPTR  lxDrawSpatial_getWorldMatrix(const lxDrawSpatial_t* spatial, uint32 node);
+
+  // boundings are in local space, a negative sphere radius marks
+  // them empty. addBounding merges into the current one.
+  LUX_API void  lxDrawSpatial_setBounding(lxDrawSpatial_t* spatial, uint32 node, const lxDrawBounding_t* bounding);
+  LUX_API void  lxDrawSpatial_addBounding(lxDrawSpatial_t* spatial, uint32 node, const lxDrawBounding_t* bounding);
+  LUX_API const lxDrawBounding_t* lxDrawSpatial_getWorldBounding(const lxDrawSpatial_t* spatial, uint32 node);
+
+  // if allocations fail, changes stay pending and the tree keeps
+  // its previous state until the next call
+  LUX_API void  lxDrawSpatial_updateTree(lxDrawSpatial_t* spatial);
+
+  // item is copied, its spatial and spatialNode are set. The bounding
+  // is in local space of the node and must not be empty.
+  // Items of removed nodes are removed at the next updateTree.
+  // returns item id, LUX_DRAWSPATIAL_NONE on error
+  LUX_API uint32  lxDrawSpatial_addItem(lxDrawSpatial_t* spatial, uint32 node, const lxDrawItem_t* item, const lxDrawBounding_t* bounding);
+  LUX_API void  lxDrawSpatial_remItem(lxDrawSpatial_t* spatial, uint32 item);
+  LUX_API void  lxDrawSpatial_setItemBounding(lxDrawSpatial_t* spatial, uint32 item, const lxDrawBounding_t* bounding);
+  // pointer is valid until the next updateTree
+  LUX_API lxDrawItem_t* lxDrawSpatial_getItem(lxDrawSpatial_t* spatial, uint32 item);
+  LUX_API const lxDrawBounding_t* lxDrawSpatial_getItemWorldBounding(const lxDrawSpatial_t* spatial, uint32 item);
 
-  LUX_API void  lxDrawSpatial_updateTree(lxDrawSpatial_t* root);
+  // items whose world sphere and box are not outside the frustum,
+  // copied or as ids, in slot order. Threadsafe.
+  // frustum plane signs must be set, as by lxFrustum_update.
+  // returns number of items, at most maxItems
+  LUX_API uint32 lxDrawSpatial_getVisibleItems(const lxDrawSpatial_t* spatial, lxFrustumCPTR frustum, lxDrawItem_t* itembuffer, uint32 maxItems);
+  LUX_API uint32 lxDrawSpatial_getVisibleIDs(const lxDrawSpatial_t* spatial, lxFrustumCPTR frustum, uint32* ids, uint32 maxItems);
 
-  LUX_API void  lxDrawSpatial_addBounding(lxDrawSpatial_t* spatial, const lxDrawBounding_t* bounding);
-  LUX_API void  lxDrawSpatial_remBounding(lxDrawSpatial_t* spatial, const lxDrawBounding_t* bounding);
-  LUX_API void  lxDrawSpatial_updateBounding(lxDrawSpatial_t* spatial);
+  //////////////////////////////////////////////////////////////////////////
+  // Multi-view culling
+  //
+  // Culls several views, like cascades and reflections, of the same
+  // spatial at once. Slots are cut into work units with about the same
+  // number of items and every (view, unit) pair is a job of the pool.
+  // Jobs write into their own chunk of scratch, the chunks are then
+  // concatenated per view in slot order, so there are no locks and the
+  // results equal those of getVisibleItems / getVisibleIDs.
+
+  typedef struct lxDrawSpatialView_s{
+    lxFrustumCPTR     frustum;
+      // either items or ids is filled
+    lxDrawItem_t*     items;
+    uint32*           ids;
+    uint32            maxItems;
+      // result
+    uint32            numItems;
+  }lxDrawSpatialView_t;
 
-  LUX_API uint32 lxDrawSpatial_getVisibleItems(lxDrawSpatial_t* root, lxFrustumCPTR frustum, lxDrawItem_t* itembuffer, size_t maxItems);
+  // pool can be NULL, scratch memory is taken from the spatial's
+  // allocator on the calling thread
+  LUX_API void  lxDrawSpatial_cullViews(const lxDrawSpatial_t* spatial, lxJobPoolPTR pool, lxDrawSpatialView_t* views, uint32 numViews);
 
   //////////////////////////////////////////////////////////////////////////
 
@@ -88,6 +211,154 @@ extern "C"{
   LUX_API void lxDrawItem_update(lxDrawItem_t* draw);
   LUX_API void lxDrawItem_deinit(lxDrawItem_t* draw);
 
+  //////////////////////////////////////////////////////////////////////////
+  // lxDrawQueue
+  //
+  // Collects the items of a frame and orders them by 64-bit keys. The
+  // layout lists the key fields from most to least significant with
+  // their bit counts, fields not listed do not affect the order. Values
+  // are masked to their bits, depth is quantized linearly between
+  // depthNear and depthFar, either front-to-back or back-to-front,
+  // separately for opaque and translucent items.
+  // Material and geometry are taken from the item's materialID and
+  // geometryID, the rest from lxDrawKeyInput_t.
+  // Keys are kept as two uint32 arrays and sorted with the luxcore
+  // radix sort (the upper half only when the layout exceeds 32 bits),
+  // which is stable and not threadsafe.
+
+  typedef enum lxDrawKeyField_e{
+    LUX_DRAWKEY_LAYER,
+    LUX_DRAWKEY_TRANSLUCENT,
+    LUX_DRAWKEY_DEPTH,
+    LUX_DRAWKEY_SHADER,
+    LUX_DRAWKEY_MATERIAL,
+    LUX_DRAWKEY_GEOMETRY,
+    LUX_DRAWKEY_FIELDS,
+  }lxDrawKeyField_t;
+
+  typedef enum lxDrawDepthOrder_e{
+    LUX_DRAWDEPTH_FRONTTOBACK,
+    LUX_DRAWDEPTH_BACKTOFRONT,
+  }lxDrawDepthOrder_t;
+
+  typedef struct lxDrawKeyLayout_s{
+    struct{
+      lxDrawKeyField_t  field;
+      uint32            bits;
+    }                   fields[LUX_DRAWKEY_FIELDS];
+    int                 numFields;
+    lxDrawDepthOrder_t  opaqueDepth;
+    lxDrawDepthOrder_t  translucentDepth;
+    float               depthNear;
+    float               depthFar;
+  }lxDrawKeyLayout_t;
+
+  typedef struct lxDrawKeyInput_s{
+    uint32    layer;
+    uint32    shader;
+    booln     translucent;
+      // view space distance
+    float     depth;
+  }lxDrawKeyInput_t;
+
+  typedef struct lxDrawQueue_s{
+    lxMemoryAllocatorPTR  allocator;
+    lxDrawKeyLayout_t     layout;
+      // compiled layout, shift and mask per field
+    uint32              shifts[LUX_DRAWKEY_FIELDS];
+    uint64              masks[LUX_DRAWKEY_FIELDS];
+    uint32              keyBits;
+    float               depthScale;
+
+    uint32              numItems;
+    uint32              numAllocated;
+    const lxDrawItem_t**  items;
+    uint32*             keysLo;
+    uint32*             keysHi;
+    uint32*             indices;
+    uint32*             indicesTemp;
+      // result of sort, points to indices or indicesTemp
+    const uint32*       sorted;
+  }lxDrawQueue_t;
+
+  // returns TRUE on error, when numFields is out of range,
+  // fields repeat or exceed 64 bits
+  LUX_API booln lxDrawQueue_init(lxDrawQueue_t* queue, lxMemoryAllocatorPTR allocator, const lxDrawKeyLayout_t* layout);
+  LUX_API void  lxDrawQueue_deinit(lxDrawQueue_t* queue);
+  LUX_API void  lxDrawQueue_reserve(lxDrawQueue_t* queue, uint32 numItems);
+  // removes all items, keeps memory
+  LUX_API void  lxDrawQueue_reset(lxDrawQueue_t* queue);
+
+  // items are referenced, not copied, and must stay valid until reset
+  LUX_API void  lxDrawQueue_addItems(lxDrawQueue_t* queue, const lxDrawItem_t* items, const lxDrawKeyInput_t* inputs, uint32 count);
+  LUX_API uint64 lxDrawQueue_makeKey(const lxDrawQueue_t* queue, const lxDrawItem_t* item, const lxDrawKeyInput_t* input);
+
+  // returns item indices (in order of adding) sorted by ascending key,
+  // valid until the next add or reset
+  LUX_API const uint32* lxDrawQueue_sort(lxDrawQueue_t* queue);
+  LUX_API uint64 lxDrawQueue_getKey(const lxDrawQueue_t* queue, uint32 index);
+  // i-th item after sort
+  LUX_API const lxDrawItem_t* lxDrawQueue_getSorted(const lxDrawQueue_t* queue, uint32 i);
+
+  //////////////////////////////////////////////////////////////////////////
+  // lxDrawBatch
+  //
+  // Merges runs of compatible items into instanced draws, run it on a
+  // sorted lxDrawQueue so equal items are next to each other. Items are
+  // compatible when geometryID, materialID, drawinfo and the parameter
+  // data of itemLevel are equal and none is instanced already.
+  // Every item writes its world matrix (float[16], identity without
+  // spatial) as instance data, a batch's instances are continuous
+  // starting at firstInstance.
+
+  typedef struct lxDrawBatch_s{
+      // first item of the run, provides geometry, material and level
+    const lxDrawItem_t*   item;
+      // instanceCount is the number of merged items
+    lxDrawInfo_t          drawinfo;
+    uint32                firstInstance;
+  }lxDrawBatch_t;
+
+  // order can be NULL, otherwise items[order[i]] are batched, as
+  // with queue->items and the result of lxDrawQueue_sort.
+  // batches and instances must hold numItems entries.
+  // returns number of batches
+  LUX_API uint32 lxDrawBatch_build(lxDrawBatch_t* batches, float* instances,
+    const lxDrawItem_t* const* items, const uint32* order, uint32 numItems);
+
+  // same as above, instances are written to the buffer from offset on
+  // through an unsynchronized lxgBuffer_mapRange, the caller must make
+  // sure the range is not in use by the GPU.
+  // returns number of batches, 0 if mapping failed
+  LUX_API uint32 lxDrawBatch_buildBuffer(lxDrawBatch_t* batches, lxgBufferPTR buffer, uint offset,
+    const lxDrawItem_t* const* items, const uint32* order, uint32 numItems);
+
+  //////////////////////////////////////////////////////////////////////////
+  // lxDrawGeometry Optimization
+  //
+  // Works on host memory: indexStream and all streams used by the
+  // vertexDecl must have NULL buffer, len is in bytes. Indices are
+  // a triangle list.
+  // Indices are optimized for the post-transform cache (tipsify),
+  // optionally clustered for overdraw (overdrawThreshold > 0 and
+  // float positions with at least 3 components), then vertices of all
+  // streams are reordered for fetch locality.
+  // ctx provides scratch and allocator, see lxVertexCacheOpt_t.
+  // returns TRUE on error, the geometry is unchanged then
+
+  LUX_API booln lxDrawGeometry_optimize(lxDrawGeometry_t* geometry, lxVertexCacheOpt_t* ctx, int vcache, float overdrawThreshold);
+
+  // welds duplicated vertices, comparing all attributes of the
+  // vertexDecl bitwise, or positions within epsilon if epsilon > 0.
+  // Streams are compacted in place and their len is updated.
+  // Run before lxDrawGeometry_optimize.
+  // returns new vertex count, -1 on error
+  LUX_API int   lxDrawGeometry_weld(lxDrawGeometry_t* geometry, lxMemoryAllocatorPTR allocator, lxJobPoolPTR pool, float epsilon);
+
+  // simulates vcache, fetch over all streams and overdraw
+  // (if positions are suitable), returns TRUE on error
+  LUX_API booln lxDrawGeometry_computeStats(const lxDrawGeometry_t* geometry, lxMemoryAllocatorPTR allocator, int vcache, lxMeshStats_t* stats);
+
 
 
 
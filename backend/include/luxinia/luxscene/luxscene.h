@@ -8,5 +8,7 @@
 #include <luxinia/luxscene/shader.h>
 #include <luxinia/luxscene/mesh.h>
 #include <luxinia/luxscene/drawsystem.h>
+#include <luxinia/luxscene/meshfile.h>
+#include <luxinia/luxscene/bvh.h>
 
 #endif
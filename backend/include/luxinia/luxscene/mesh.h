@@ -7,5 +7,10 @@
 
 #include "meshbase.h"
 #include "meshvcacheopt.h"
+#include "meshopt.h"
+#include "meshlet.h"
+#include "meshgen.h"
+#include "meshquantize.h"
+#include "meshcodec.h"
 
 #endif
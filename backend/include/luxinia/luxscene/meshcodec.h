@@ -0,0 +1,75 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXSCENE_MESHCODEC_H__
+#define __LUXSCENE_MESHCODEC_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxscene/meshbase.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Index Compression
+//
+// Triangle lists are stored as one code byte per triangle, followed by
+// at most three varints. Triangles sharing an edge with one of the last
+// 15 encoded triangles only store their third vertex, which is either
+// the next unused vertex, one of the last 14 used vertices, or a
+// zigzag varint delta. Run after the post-transform cache and vertex
+// fetch optimizations, then most triangles take a single byte.
+//
+// Triangle order and winding are kept, but triangles may be rotated.
+//
+// The stream is a version byte followed by the triangle records, no
+// count is stored. The decoder keeps its state between calls, so data
+// can be decoded while it arrives in arbitrary chunks.
+
+enum{
+  LUX_MESHCODEC_VERSION     = 0xE1,
+  LUX_MESHCODEC_EDGES       = 15,
+  LUX_MESHCODEC_VERTICES    = 14,
+    // largest triangle record in bytes
+  LUX_MESHCODEC_MAX_RECORD  = 16,
+};
+
+typedef struct lxMeshIndexDecoder_s{
+  uint32    edges[16][2];
+  uint32    vertices[16];
+  uint      edgeOffset;
+  uint      vertexOffset;
+  uint32    next;
+  uint32    last;
+  booln     started;
+    // incomplete record of previous chunk
+  uint      carrySize;
+  byte      carry[LUX_MESHCODEC_MAX_RECORD];
+}lxMeshIndexDecoder_t;
+
+  // worst case size of the encoded stream
+LUX_API size_t  lxMeshIndexCodec_getMaxSize(int numIndices);
+
+  // returns bytes written, 0 on error or when dst is too small
+LUX_API size_t  lxMeshIndexCodec_encode(void* dst, size_t dstSize, const void* indices, int numIndices, lxMeshIndexType_t type);
+
+  // decodes a complete stream of numIndices
+  // returns TRUE on error
+LUX_API booln   lxMeshIndexCodec_decode(void* dst, int numIndices, const void* src, size_t srcSize, lxMeshIndexType_t type);
+
+LUX_API void    lxMeshIndexDecoder_init(lxMeshIndexDecoder_t* dec);
+
+  // decodes complete triangles of the chunk, up to maxIndices. Partial
+  // records at the end are kept in the decoder. srcUsed returns the
+  // consumed bytes, which are less than srcSize when dst is full.
+  // returns number of indices written, -1 on error
+LUX_API int     lxMeshIndexDecoder_run(lxMeshIndexDecoder_t* dec, void* dst, int maxIndices,
+  const void* src, size_t srcSize, size_t* srcUsed, lxMeshIndexType_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXSCENE_MESHFILE_H__
+#define __LUXSCENE_MESHFILE_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxscene/drawsystem.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Mesh File
+//
+// Binary container of a host lxDrawGeometry_t, meant to be memory
+// mapped and used in place. All blocks are stored in native layout,
+// so loading only checks the header and points the geometry into
+// the data, nothing is parsed or copied.
+//
+//  header    lxMeshFileHeader_t
+//  decl      lxgVertexDecl_t
+//  lods      lxMeshLod_t[numLods]
+//  indices   uint16 or uint32 [numIndices]
+//  streams   numVertices * stride bytes, for every stream of the decl
+//
+// Blocks start at LUX_MESHFILE_ALIGN, offsets are relative to the
+// header. Files are platform specific, endianness and the bitfield
+// layout of lxgVertexElement_t are stored and must match the reader.
+// Files written with another version are rejected, rebuild them from
+// the source asset.
+
+enum{
+    // "LXMF"
+  LUX_MESHFILE_MAGIC    = 0x464D584C,
+  LUX_MESHFILE_VERSION  = 1,
+  LUX_MESHFILE_ALIGN    = 16,
+  LUX_MESHFILE_ENDIAN   = 0x01020304,
+};
+
+typedef enum lxMeshFileError_e{
+  LUX_MESHFILE_ERROR_NONE,
+    // data smaller than header or fileSize
+  LUX_MESHFILE_ERROR_SIZE,
+  LUX_MESHFILE_ERROR_MAGIC,
+  LUX_MESHFILE_ERROR_VERSION,
+    // endianness or struct layout differ
+  LUX_MESHFILE_ERROR_PLATFORM,
+    // block outside of the file or misaligned
+  LUX_MESHFILE_ERROR_RANGE,
+    // decl references missing or too small streams
+  LUX_MESHFILE_ERROR_DECL,
+  LUX_MESHFILE_ERROR_LODS,
+    // index type or index beyond numVertices
+  LUX_MESHFILE_ERROR_INDICES,
+  LUX_MESHFILE_ERRORS,
+}lxMeshFileError_t;
+
+typedef struct lxMeshFileRange_s{
+  uint64    offset;
+  uint64    size;
+}lxMeshFileRange_t;
+
+typedef struct lxMeshFileHeader_s{
+  uint32              magic;
+  uint32              version;
+  uint32              endian;
+    // bits of a reference lxgVertexElement_t
+  uint32              elementProbe;
+  uint32              headerSize;
+  uint32              indexType;
+  uint32              numIndices;
+  uint32              numVertices;
+  uint32              numLods;
+  uint32              _pad;
+  uint64              fileSize;
+  lxDrawBounding_t    bounding;
+  lxMeshFileRange_t   decl;
+  lxMeshFileRange_t   lods;
+  lxMeshFileRange_t   indices;
+  lxMeshFileRange_t   streams[LUXGFX_MAX_VERTEX_STREAMS];
+}lxMeshFileHeader_t;
+
+  // bytes needed to store geometry with numLods levels, 0 on error
+LUX_API size_t  lxMeshFile_getSize(const lxDrawGeometry_t* geometry, int numLods);
+
+  // geometry must be in host memory, as for lxDrawGeometry_optimize.
+  // numVertices is the smallest vertex count of the decl's streams,
+  // streams not used by the decl are skipped. bounding can be NULL,
+  // then it is computed from float positions. lods can be NULL.
+  // returns bytes written, 0 on error or when dst is too small
+LUX_API size_t  lxMeshFile_write(void* dst, size_t dstSize, const lxDrawGeometry_t* geometry,
+  const lxDrawBounding_t* bounding, const lxMeshLod_t* lods, int numLods);
+
+  // checks header, blocks, decl and lods, constant time.
+  // checkIndices also scans all indices against numVertices.
+LUX_API lxMeshFileError_t lxMeshFile_validate(const void* data, size_t size, booln checkIndices);
+
+  // validates (without checkIndices) and points geometry into data,
+  // geometryID is left 0. data must stay valid while geometry is used
+  // and be aligned to LUX_MESHFILE_ALIGN. Read-only mapped data must
+  // not be passed to functions modifying the geometry in place.
+  // header can be NULL.
+LUX_API lxMeshFileError_t lxMeshFile_load(const void* data, size_t size,
+  lxDrawGeometry_t* geometry, const lxMeshFileHeader_t** header);
+
+  // NULL if there are no lods
+LUX_API const lxMeshLod_t* lxMeshFile_getLods(const lxMeshFileHeader_t* header);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,69 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXSCENE_MESHGEN_H__
+#define __LUXSCENE_MESHGEN_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxmath/basetypes.h>
+#include <luxinia/luxgfx/vertex.h>
+#include <luxinia/luxscene/meshbase.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Mesh Generation
+//
+// Batched version of the meshbase primitives. Vertices and indices are
+// the same as lxMesh*_initTriangles, but written directly into the
+// interleaved streams of a vertex declaration, with any number of
+// transformed instances per call.
+//
+// Written attributes, if available in decl:
+//  POS       float32
+//  NORMAL    float32, float16, int8/int16 normalized
+//  TEXCOORD0 float32, float16, uint8/uint16 normalized
+// Other attributes are left untouched. Normals are transformed by the
+// inverse transpose of the instance matrix's upper 3x3, and are
+// renormalized if that matrix has scale or shear.
+
+typedef enum lxMeshGenShape_e{
+  LUX_MESHGEN_PLANE,      // segs = x,y
+  LUX_MESHGEN_DISC,       // segs = outer,cap
+  LUX_MESHGEN_BOX,        // segs = x,y,z
+  LUX_MESHGEN_SPHERE,     // segs = x & y,z
+  LUX_MESHGEN_CYLINDER,   // segs = outer,cap,z
+  LUX_MESHGEN_SHAPES,
+}lxMeshGenShape_t;
+
+typedef struct lxMeshGenInstance_s{
+  lxMeshGenShape_t  shape;
+  int               segs[3];
+    // lxMatrix44 or NULL for identity
+  const float*      matrix;
+}lxMeshGenInstance_t;
+
+typedef struct lxMeshGenTarget_s{
+  lxgVertexDeclCPTR   decl;
+    // first vertex of each stream of decl
+  void*               streams[LUXGFX_MAX_VERTEX_STREAMS];
+  void*               indices;
+  lxMeshIndexType_t   indexType;
+    // added to all indices
+  uint32              baseVertex;
+}lxMeshGenTarget_t;
+
+LUX_API void  lxMeshGen_getCounts(const lxMeshGenInstance_t* instances, int numInstances, int* numVertices, int* numIndices);
+
+  // instances are stored one after another
+  // returns TRUE on unsupported formats or when uint16 indices overflow
+LUX_API booln lxMeshGen_build(const lxMeshGenTarget_t* target, const lxMeshGenInstance_t* instances, int numInstances);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,100 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXSCENE_MESHLET_H__
+#define __LUXSCENE_MESHLET_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxcore/memorybase.h>
+#include <luxinia/luxmath/bounding.h>
+#include <luxinia/luxmath/frustum.h>
+#include <luxinia/luxscene/meshbase.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Meshlets
+//
+// Splits an index buffer into small clusters of at most maxVertices
+// vertices and maxTriangles triangles, which are culled individually.
+// Clusters grow over shared vertices, preferring triangles that add
+// few vertices and face like the cluster, which keeps the normal cones
+// tight.
+//
+// Meshlets are packed one after another, each owns numVertices entries
+// of meshletVertices from vertexOffset (indices into the original vertex
+// buffer) and numTriangles * 3 entries of meshletTriangles from
+// triangleOffset (local indices into its vertices).
+//
+// The normal cone is stored as "backface cone": when the camera is
+// inside it, all triangles of the meshlet face away. Front faces are
+// counter-clockwise, as in the default lxgRasterizer. Meshlets whose
+// normals spread too much get a cone that never culls.
+
+#define LUX_MESHLET_MAX_VERTICES    64
+#define LUX_MESHLET_MAX_TRIANGLES   124
+
+typedef struct lxMeshlet_s{
+  uint32              vertexOffset;
+  uint32              triangleOffset;
+  uint32              numVertices;
+  uint32              numTriangles;
+  lxBoundingSphere_t  sphere;
+  lxBoundingCone_t    cone;
+}lxMeshlet_t;
+
+typedef struct lxMeshletCullStats_s{
+  int     meshlets;
+  int     triangles;
+  int     culledFrustum;
+  int     culledBackface;
+    // triangles of culled meshlets
+  int     culledTrianglesFrustum;
+  int     culledTrianglesBackface;
+}lxMeshletCullStats_t;
+
+  // upper bound for the number of meshlets
+LUX_API int   lxMeshlet_getMaxCount(int nTriangles, int maxVertices, int maxTriangles);
+
+  // maxVertices <= 256, positions are float[3], posStride in bytes.
+  // meshlets must hold lxMeshlet_getMaxCount entries, meshletVertices
+  // that many * maxVertices and meshletTriangles * maxTriangles * 3.
+  // returns number of meshlets, -1 on error
+LUX_API int   lxMeshlet_build(lxMemoryAllocatorPTR allocator,
+  lxMeshlet_t* meshlets,
+  uint32* meshletVertices,
+  uint8* meshletTriangles,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  int maxVertices,
+  int maxTriangles,
+  lxMeshIndexType_t type);
+
+  // updates sphere and cone from the meshlet's triangles
+LUX_API void  lxMeshlet_computeBounds(lxMeshlet_t* meshlet,
+  const uint32* meshletVertices,
+  const uint8* meshletTriangles,
+  const float* positions,
+  size_t posStride);
+
+  // frustum and camera are in the space of the positions, either can
+  // be NULL. Writes indices of visible meshlets, stats can be NULL.
+  // returns number of visible meshlets
+LUX_API int   lxMeshlet_cull(uint32* visible,
+  const lxMeshlet_t* meshlets,
+  int numMeshlets,
+  lxFrustumCPTR frustum,
+  const lxVector3 camera,
+  lxMeshletCullStats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,231 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXSCENE_MESHOPT_H__
+#define __LUXSCENE_MESHOPT_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxcore/memorybase.h>
+#include <luxinia/luxcore/jobpool.h>
+#include <luxinia/luxscene/meshbase.h>
+#include <luxinia/luxscene/meshvcacheopt.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Vertex Fetch
+//
+// Run after the post-transform cache optimization. Vertices are
+// renumbered in the order of their first use, so that the fetch
+// walks the vertex buffers mostly linear. Vertices not referenced
+// by the indices are moved to the end.
+
+  // remap[old] = new, returns number of referenced vertices
+LUX_API int   lxMeshVertexFetch_remap(uint32* remap, const void* indices, int numIndices, int nVertices, lxMeshIndexType_t type);
+
+  // indices[i] = remap[indices[i]]
+LUX_API void  lxMeshIndices_remap(void* indices, int numIndices, const uint32* remap, lxMeshIndexType_t type);
+
+  // dst[remap[i]] = src[i], dst and src must not overlap
+LUX_API void  lxMeshVertices_remap(void* dst, const void* src, size_t stride, int nVertices, const uint32* remap);
+
+//////////////////////////////////////////////////////////////////////////
+// Vertex Welding
+//
+// Finds duplicated vertices and builds remap[old] = new, new vertices
+// keep the order of their first occurrence, which is the vertex whose
+// data is kept. Vertices are hashed and split into partitions by hash,
+// which are processed independently, so the work scales linear with
+// the vertex count and runs on the pool's threads (pool can be NULL).
+//
+// Each stream describes one attribute or a range of an interleaved
+// vertex, data points to the first vertex, size bytes are compared
+// bitwise.
+
+typedef struct lxMeshWeldStream_s{
+  const void*   data;
+  size_t        stride;
+  size_t        size;
+}lxMeshWeldStream_t;
+
+  // all streams must match exactly
+  // returns number of unique vertices, -1 on error
+LUX_API int   lxMeshWeld_remap(uint32* remap,
+  lxMemoryAllocatorPTR allocator,
+  lxJobPoolPTR pool,
+  const lxMeshWeldStream_t* streams,
+  int numStreams,
+  int nVertices);
+
+  // positions (float[3]) are welded if each component differs by
+  // at most epsilon, and all streams match exactly. Chains of close
+  // vertices are welded to the first one.
+  // returns number of unique vertices, -1 on error
+LUX_API int   lxMeshWeld_remapEpsilon(uint32* remap,
+  lxMemoryAllocatorPTR allocator,
+  lxJobPoolPTR pool,
+  const float* positions,
+  size_t posStride,
+  float epsilon,
+  const lxMeshWeldStream_t* streams,
+  int numStreams,
+  int nVertices);
+
+  // keeps first occurrences, dst[remap[i]] = src[i],
+  // dst may be src. returns number of written vertices
+LUX_API int   lxMeshVertices_compact(void* dst, const void* src, size_t stride, int nVertices, const uint32* remap);
+
+//////////////////////////////////////////////////////////////////////////
+// Simplification
+//
+// Quadric error metric edge collapses (Garland and Heckbert), vertices
+// are only collapsed onto other existing vertices, so all levels of
+// detail index the original vertex buffer. Vertices on borders,
+// non-manifold edges and attribute seams (several vertices sharing one
+// position, like UV or normal splits) are never removed, which keeps
+// seams intact. Weld the mesh first, so that only real seams remain.
+//
+// positions are float[3], posStride in bytes. Errors are distances in
+// the units of the positions, maxError < 0 disables the limit.
+
+typedef struct lxMeshLod_s{
+  uint32    firstIndex;
+  uint32    numIndices;
+  float     error;
+}lxMeshLod_t;
+
+  // dstIndices needs room for nTriangles * 3 indices and may be indices.
+  // Stops at targetTriangles or maxError, outError can be NULL.
+  // returns number of triangles, -1 on error
+LUX_API int   lxMeshSimplify(lxMemoryAllocatorPTR allocator,
+  void* dstIndices,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  int targetTriangles,
+  float maxError,
+  float* outError,
+  lxMeshIndexType_t type);
+
+  // Level 0 is the input, every next level has about ratio times
+  // the triangles of the previous. Levels are written one after another
+  // into dstIndices (dstCapacity indices), errors are relative to the
+  // input and increase monotonic. Stops early when maxError or the
+  // capacity is reached, or when the mesh cannot be reduced further.
+  // returns number of lods, -1 on error
+LUX_API int   lxMeshLodChain_build(lxMemoryAllocatorPTR allocator,
+  lxMeshLod_t* lods,
+  int maxLods,
+  void* dstIndices,
+  size_t dstCapacity,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  float ratio,
+  float maxError,
+  lxMeshIndexType_t type);
+
+  // coarsest level whose projected error stays below maxPixelError,
+  // pixelScale = viewport height / (2 * tan(fovy/2))
+LUX_API int   lxMeshLodChain_select(const lxMeshLod_t* lods, int numLods, float distance, float pixelScale, float maxPixelError);
+
+//////////////////////////////////////////////////////////////////////////
+// Overdraw
+//
+// Run after the post-transform cache optimization, based on
+// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+// by Sander, Nehab and Barczak.
+// Triangles are split into clusters where the cache restarts, and
+// where the cluster's ACMR drops below threshold * mesh ACMR. Clusters
+// facing away from the mesh center are drawn first, which is view
+// independent. The larger the threshold, the more clusters and the
+// less vertex cache efficiency, 1.05 is a good start.
+//
+// positions are float[3], posStride in bytes
+// returns TRUE on error
+
+LUX_API booln lxMeshOverdraw_optimize(lxMemoryAllocatorPTR allocator,
+  void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  int vcache,
+  float threshold,
+  lxMeshIndexType_t type);
+
+//////////////////////////////////////////////////////////////////////////
+// Mesh Statistics
+//
+// CPU simulation of the vertex pipeline.
+// The fetch cache is a FIFO of LUX_MESHSTATS_FETCH_LINES lines.
+// Overdraw rasterizes the mesh orthographically along the 6 major
+// axes at LUX_MESHSTATS_OVERDRAW_RES, with backface culling of
+// clockwise triangles and depth test.
+
+#define LUX_MESHSTATS_FETCH_LINE      64
+#define LUX_MESHSTATS_FETCH_LINES     128
+#define LUX_MESHSTATS_OVERDRAW_RES    256
+
+typedef struct lxMeshStats_s{
+  lxVertexCacheStats_t  vcache;
+    // cache lines loaded
+  int     fetchMisses;
+    // bytes fetched / bytes of referenced vertices
+    // 1 is optimal
+  float   overfetch;
+
+  int     pixelsCovered;
+  int     pixelsShaded;
+    // shaded / covered, 1 is optimal
+  float   overdraw;
+}lxMeshStats_t;
+
+  // vertexStride is the size of an interleaved vertex,
+  // positions can be NULL to skip overdraw.
+  // returns TRUE on error
+LUX_API booln lxMeshStats_compute(lxMeshStats_t* stats,
+  lxMemoryAllocatorPTR allocator,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  size_t vertexStride,
+  int vcache,
+  lxMeshIndexType_t type);
+
+  // only fetch part, call for each vertex stream of a mesh.
+  // Vertices are fetched on post-transform cache misses.
+  // Adds to stats->fetchMisses, sets stats->overfetch of this stream
+  // returns bytes fetched, 0 on error
+LUX_API size_t lxMeshStats_fetch(lxMeshStats_t* stats,
+  lxMemoryAllocatorPTR allocator,
+  const void* indices,
+  int numIndices,
+  int nVertices,
+  size_t vertexStride,
+  int vcache,
+  lxMeshIndexType_t type);
+
+  // only overdraw part
+LUX_API booln lxMeshStats_overdraw(lxMeshStats_t* stats,
+  lxMemoryAllocatorPTR allocator,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  lxMeshIndexType_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
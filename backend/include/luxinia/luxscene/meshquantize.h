@@ -0,0 +1,94 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXSCENE_MESHQUANTIZE_H__
+#define __LUXSCENE_MESHQUANTIZE_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxmath/basetypes.h>
+#include <luxinia/luxgfx/vertex.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Vertex Quantization
+//
+// Packs float vertices into a single interleaved stream:
+//  POS       uint16 x 4 normalized, relative to the bounding box, w = 1
+//  NORMAL    octahedral, int8 or int16 x 2 normalized
+//  ATTR14    tangent, octahedral, int8 or int16 x 4 normalized,
+//            z is the handedness (-1 or 1), w = 0
+//  TEXCOORD0 float16 x 2
+// Each attribute starts at 4 byte alignment.
+//
+// Positions are restored by the dequant matrix:
+//   pos = dequant * vec4(attr.xyz, 1)
+// which can be merged into the world matrix. It contains the box's
+// non-uniform scale, so normals must not be transformed by it.
+//
+// Octahedral normals are decoded with:
+//   n = vec3(attr.xy, 1 - abs(attr.x) - abs(attr.y))
+//   if (n.z < 0) n.xy = (1 - abs(n.yx)) * sign(n.xy)
+//   n = normalize(n)
+
+typedef enum lxMeshQuantizeNormal_e{
+  LUX_MESHQUANTIZE_OCT8,
+  LUX_MESHQUANTIZE_OCT16,
+  LUX_MESHQUANTIZE_NORMALS,
+}lxMeshQuantizeNormal_t;
+
+typedef struct lxMeshQuantizeInput_s{
+    // float[3], required
+  const float*    positions;
+  size_t          posStride;
+    // float[3], can be NULL
+  const float*    normals;
+  size_t          normalStride;
+    // float[4], w is handedness, can be NULL
+  const float*    tangents;
+  size_t          tangentStride;
+    // float[2], can be NULL
+  const float*    uvs;
+  size_t          uvStride;
+  int             numVertices;
+}lxMeshQuantizeInput_t;
+
+typedef struct lxMeshQuantizeStats_s{
+    // in units of the positions
+  float     posMaxError;
+  float     posAvgError;
+    // in degrees
+  float     normalMaxAngle;
+  float     normalAvgAngle;
+  float     tangentMaxAngle;
+  float     uvMaxError;
+    // float32 attributes vs. quantized
+  size_t    bytesInput;
+  size_t    bytesOutput;
+}lxMeshQuantizeStats_t;
+
+typedef struct lxMeshQuantize_s{
+    // stream 0
+  lxgVertexDecl_t       decl;
+  uint                  vertexSize;
+  lxBoundingBox_t       bbox;
+  lxMatrix44            dequant;
+  lxMeshQuantizeStats_t stats;
+}lxMeshQuantize_t;
+
+  // fills decl and vertexSize for the attributes present in input
+LUX_API void  lxMeshQuantize_init(lxMeshQuantize_t* quant, const lxMeshQuantizeInput_t* input, lxMeshQuantizeNormal_t normalType);
+
+  // dst needs room for numVertices * vertexSize bytes,
+  // stats are computed by decoding the written vertices.
+  // returns TRUE on error
+LUX_API booln lxMeshQuantize_run(lxMeshQuantize_t* quant, void* dst, const lxMeshQuantizeInput_t* input, lxMeshQuantizeNormal_t normalType);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
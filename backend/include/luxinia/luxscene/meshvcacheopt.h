@@ -9,6 +9,7 @@
 
 #include <luxinia/luxplatform/luxplatform.h>
 #include <luxinia/luxscene/meshbase.h>
+#include <luxinia/luxcore/memorybase.h>
 
 #ifdef __cplusplus
 extern "C"{
@@ -20,6 +21,8 @@ extern "C"{
 
 // Original Algorithm:
 // http://www.cs.princeton.edu/gfx/pubs/Sander_2007_%3ETR/tipsy.pdf
+//
+// returns NULL on error
 LUX_API void* lxVertexCacheOptimize_tipsify(
   void* indices,
   int nTriangles,
@@ -31,8 +34,7 @@ LUX_API void* lxVertexCacheOptimize_tipsify(
 // Original Algorithm:
 // http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
 //
-// NOT THREADSAFE!!
-// vcachesize <= 32
+// vcachesize <= 32, returns NULL on error
 LUX_API void* lxVertexCacheOptimize_forsyth(
   void* indices,
   int nTriangles,
@@ -55,6 +57,88 @@ LUX_API void* lxVertexCacheOptimize_grid_castano(
   lxMeshIndexType_t type,
   int *writtenTriangles);
 
+//////////////////////////////////////////////////////////////////////////
+// Vertex Cache Statistics
+//
+// Simulates a FIFO post-transform cache, no memory is allocated.
+
+#define LUX_VERTEXCACHE_MAX   64
+
+typedef struct lxVertexCacheStats_s{
+  int     misses;
+    // average cache miss ratio, misses per triangle
+    // 3 worst, 0.5 best for regular grids
+  float   acmr;
+    // average transform to vertex ratio, misses per vertex
+    // 1 is optimal
+  float   atvr;
+}lxVertexCacheStats_t;
+
+  // vcache <= LUX_VERTEXCACHE_MAX
+LUX_API void lxVertexCacheStats_compute(
+  lxVertexCacheStats_t *stats,
+  const void* indices,
+  int nTriangles,
+  int nVertices,
+  int vcache,
+  lxMeshIndexType_t type);
+
+//////////////////////////////////////////////////////////////////////////
+// Vertex Cache Optimizer Context
+//
+// Reentrant versions of the optimizers above. The context owns the
+// scratch memory, which is reused for all meshes and only grows when
+// a mesh needs more. Statistics of the index buffer before and after
+// optimization are stored in the context.
+// Scratch can be provided by the user, allocator is then used only
+// if it is too small, and can be NULL.
+// Contexts are independent, use one per thread.
+
+typedef struct lxVertexCacheOpt_s{
+  lxMemoryAllocatorPTR  allocator;
+  void*         scratch;
+  size_t        scratchSize;
+  booln         scratchOwned;
+
+  lxVertexCacheStats_t  before;
+  lxVertexCacheStats_t  after;
+}lxVertexCacheOpt_t;
+
+LUX_API void  lxVertexCacheOpt_init(lxVertexCacheOpt_t *ctx, 
+  lxMemoryAllocatorPTR allocator, void* scratch, size_t scratchSize);
+LUX_API void  lxVertexCacheOpt_deinit(lxVertexCacheOpt_t *ctx);
+
+  // bytes of scratch needed by tipsify and forsyth
+LUX_API size_t  lxVertexCacheOpt_scratchSize(int nTriangles, int nVertices);
+  // makes scratch big enough for the mesh, NULL on failure
+LUX_API void* lxVertexCacheOpt_reserve(lxVertexCacheOpt_t *ctx, int nTriangles, int nVertices);
+
+  // same as lxVertexCacheOptimize_* 
+  // return NULL on error
+LUX_API void* lxVertexCacheOpt_tipsify(lxVertexCacheOpt_t *ctx,
+  void* indices,
+  int nTriangles,
+  int nVertices,
+  int k,
+  lxMeshIndexType_t type );
+
+LUX_API void* lxVertexCacheOpt_forsyth(lxVertexCacheOpt_t *ctx,
+  void* indices,
+  int nTriangles,
+  int nVertices,
+  int vcache,
+  lxMeshIndexType_t type );
+
+  // only after statistics are set
+LUX_API void* lxVertexCacheOpt_gridCastano(lxVertexCacheOpt_t *ctx,
+  void* indices,
+  int maxTriangles,
+  int width,
+  int height,
+  int vcache,
+  lxMeshIndexType_t type,
+  int *writtenTriangles);
+
 #ifdef __cplusplus
 }
 #endif
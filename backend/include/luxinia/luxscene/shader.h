@@ -6,6 +6,7 @@
 #define __LUXSCENE_SHADER_H__
 
 #include <luxinia/luxgfx/program.h>
+#include <luxinia/luxgfx/buffer.h>
 #include <luxinia/luxcore/contstringmap.h>
 #include <luxinia/luxcore/conthash.h>
 
@@ -87,8 +88,11 @@ extern "C"{
 */
   //////////////////////////////////////////////////////////////////////////
 
+  struct lxShaderUpdate_s;
+  typedef uint (lxShaderUpdateBuild_fn)(struct lxShaderUpdate_s* update);
+
   typedef struct lxShaderUpdate_s{
-    uint                    (*funcBuildProgramParams)( struct lxShaderUpdate_s* update);
+    lxShaderUpdateBuild_fn* funcBuildProgramParams;
     lxShaderProgram_t*      shader;
     uint32                  numParams;
     uint32                  numProgParams;
@@ -104,6 +108,11 @@ extern "C"{
     lxgProgramParameter_t ** progParams;
     void **                  progDatas;
 
+    // content tracking, numParams+1 offsets into contentDatas
+    booln                   trackContent;
+    uint32                  contentSize;
+    uint32*                 contentOffsets;
+    byte*                   contentDatas;
   }lxShaderUpdate_t;
 
 
@@ -111,6 +120,13 @@ extern "C"{
   LUX_API size_t  lxShaderUpdate_getMemSize(lxShaderUpdate_t* update);
   LUX_API void    lxShaderUpdate_initMem(lxShaderUpdate_t* update, size_t size, void* buffer);
 
+    // opt-in, call after init and before getMemSize.
+    // Value parameters are compared by content against a copy of what
+    // was last built, pointers to equal values are skipped and values
+    // changed in place are caught. Other parameters compare pointers.
+    // Like before only parameters pushed since the last build are checked.
+  LUX_API void    lxShaderUpdate_trackContent(lxShaderUpdate_t* update, booln state);
+
     // data content pointers must be valid until consumption!
   LUX_API void lxShaderUpdate_pushData(lxShaderUpdate_t* update, uint num, lxShaderIndex* paramIndices, void** data);
   LUX_API void lxShaderUpdate_popData(lxShaderUpdate_t* update);
@@ -119,7 +135,45 @@ extern "C"{
     // use with lxgProgram_applyParameters
   LUX_API uint lxShaderUpdate_buildProgramParams(lxShaderUpdate_t* update);
 
-
+  //////////////////////////////////////////////////////////////////////////
+  // lxShaderBlock
+  //
+  // std140 layout of a set of value parameters, typically the ones of a
+  // lxShaderLevel_t for a shader. Source data is tightly packed as for
+  // the uniform functions, matrices column-major. Array elements and
+  // matrix columns are padded to 16 bytes in the block.
+
+  typedef struct lxShaderBlockEntry_s{
+    lxGLParameterType_t   type;
+    uint32                count;
+      // set by layout, offset is -1 for parameters not in the block
+    uint32                offset;
+    uint16                vectors;
+    uint16                vectorSize;
+  }lxShaderBlockEntry_t;
+
+  typedef struct lxShaderBlock_s{
+    uint32                numEntries;
+    lxShaderBlockEntry_t* entries;
+      // multiple of 16
+    uint32                size;
+  }lxShaderBlock_t;
+
+    // entries must have type and count set, returns block size
+  LUX_API uint32  lxShaderBlock_layout(lxShaderBlock_t* block, lxShaderBlockEntry_t* entries, uint num);
+    // entries from shader parameters, indices < 0 are skipped
+    // (e.g. lxShaderLevel_t assigns), returns block size
+  LUX_API uint32  lxShaderBlock_initShader(lxShaderBlock_t* block, lxShaderBlockEntry_t* entries, lxShaderProgram_t* shader, uint num, const lxShaderIndex* indices);
+    // datas must be numEntries wide, NULL datas leave the block untouched
+  LUX_API void    lxShaderBlock_pack(const lxShaderBlock_t* block, void** datas, void* dst);
+
+    // packs into the frame of a lxgBufferRing_t, ring align should be
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. Returns buffer offset or -1
+    // if the block did not fit. lxgBufferRing_flush the ring before
+    // drawing with the bound blocks.
+  LUX_API uint32  lxShaderBlock_packRing(const lxShaderBlock_t* block, void** datas, lxgBufferRing_t* ring);
+    // binds the block range instead of setting every uniform
+  LUX_API void    lxShaderBlock_bind(const lxShaderBlock_t* block, lxgContextPTR ctx, lxgBufferPTR buffer, uint unit, uint32 offset);
 
   //////////////////////////////////////////////////////////////////////////
 
@@ -8,6 +8,7 @@ extern "C"{
 
 #include <luxinia/luxcore/contscalararray.h>
 #include <luxinia/luxplatform/debug.h>
+#include <luxinia/luxplatform/cpu.h>
 #include <luxinia/luxmath/vector2.h>
 #include <luxinia/luxmath/matrix44.h>
 #include <luxinia/luxmath/simdmath.h>
@@ -17,6 +18,8 @@ extern "C"{
 }
 #endif
 
+#include "contscalararray_defs.h"
+
 #if defined(LUX_SIMD_SSE)
 #define SCALAR_USE_XMM
 #endif
@@ -594,6 +597,7 @@ LUX_INLINE void ScalarLoop2::checkUnrolled(void *&pOut,const void *&pArg0,const
   }
   {
 #else
+  vectordim = cnt;
   LUX_DEBUGASSERT(vectordim <= 4);
   if (vectordim){
 #endif
@@ -613,7 +617,7 @@ LUX_INLINE ScalarLoop3::ScalarLoop3(const lxScalarArray_t &sarray,
   stride0 = sarray0.stride;
   stride1 = sarray1.stride;
   stride2 = sarray2.stride;
-  cnt = LUX_MIN(LUX_MIN(LUX_MIN(sarray.count,sarray0.count),sarray1.count),sarray2.count);
+  cnt = LUX_MIN(LUX_MIN(LUX_MIN(sarray.count,sarray0.count),sarray1.count),sarray2.count) * vectordim;
 
 
   // no gaps, can maximize vectordim
@@ -1271,7 +1275,7 @@ booln LUX_FASTCALL XMMScalarArrayOp_in2_v41(lxScalarArrayOp_t op, TScalarLoop2 &
             run = loop.cnt && (loop.vectordim == 4);}
 
 #undef  XMMLOOP_FOR   
-#define XMMLOOP_FOR   for (size_t i = 0; i < loop.cntvec; i++, pOut+= loop.stride, pArg0 += loop.stride0, pArg1 += loop.stride1, pArg2 += loop.stride1)
+#define XMMLOOP_FOR   for (size_t i = 0; i < loop.cntvec; i++, pOut+= loop.stride, pArg0 += loop.stride0, pArg1 += loop.stride1, pArg2 += loop.stride2)
 
 template<class TScalarLoop3>
 booln LUX_FASTCALL XMMScalarArrayOp_in3_v44(lxScalarArrayOp_t op, TScalarLoop3 &loop, void *&pOutV,const void *&pArg0V,const void *&pArg1V,const void *&pArg2V)
@@ -1424,7 +1428,8 @@ booln LUX_FASTCALL TScalarArrayOp_in2(lxScalarArrayOp_t op, TScalarLoop2 &loop,
   const T *pArg0  = (const T*)sArg0.data.tvoid;
   const T *pArg1  = (const T*)sArg1.data.tvoid;
 
-  booln single = sArg1.vectordim == 1;
+  // vectordim 1 arrays are only single, if not compact
+  booln single = sArg1.vectordim == 1 && (sArg0.vectordim != 1 || sArg1.stride == 0);
   if (sArg0.vectordim != sArg1.vectordim){
     if (!single)
       return LUX_FALSE;
@@ -1761,7 +1766,7 @@ booln LUX_FASTCALL TScalarArrayOp_in3(lxScalarArrayOp_t op, TScalarLoop3 &loop,
   Ttemp min = (Ttemp)l_ScalarMin[sOut.type];
   Ttemp max = (Ttemp)l_ScalarMax[sOut.type];
 
-  booln single = sArg2.vectordim == 1;
+  booln single = sArg2.vectordim == 1 && (sArg0.vectordim != 1 || sArg2.stride == 0);
   if (sArg0.vectordim != sArg2.vectordim){
     if (!single)
       return LUX_FALSE;
@@ -1918,7 +1923,7 @@ booln LUX_FASTCALL FScalarArrayOp_in3(lxScalarArrayOp_t op, TScalarLoop3 &loop,
   const float *pArg1  = (const float*)sArg1.data.tvoid;
   const float *pArg2  = (const float*)sArg2.data.tvoid;
 
-  booln single = sArg2.vectordim == 1;
+  booln single = sArg2.vectordim == 1 && (sArg0.vectordim != 1 || sArg2.stride == 0);
   if (sArg0.vectordim != sArg2.vectordim){
     if (!single)
       return LUX_FALSE;
@@ -2080,6 +2085,57 @@ booln LUX_FASTCALL FScalarArrayOp_in3(lxScalarArrayOp_t op, TScalarLoop3 &loop,
 #undef SCALAR_CURRENT_PTRS
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Kernel selection
+
+LUX_API booln lxScalarArray_isKernelSupported(lxScalarArrayKernel_t kernel)
+{
+  switch(kernel){
+  case LUX_SCALAR_KERNEL_DEFAULT:
+    return LUX_TRUE;
+  case LUX_SCALAR_KERNEL_AVX2:
+#ifdef LUX_SIMD_AVX2
+    return (lxCPU_getFeatures() & (LUX_CPU_AVX2 | LUX_CPU_FMA)) == (LUX_CPU_AVX2 | LUX_CPU_FMA);
+#else
+    return LUX_FALSE;
+#endif
+  default:
+    return LUX_FALSE;
+  }
+}
+
+static lxScalarArrayKernel_t ScalarArray_bestKernel()
+{
+  return lxScalarArray_isKernelSupported(LUX_SCALAR_KERNEL_AVX2) ? 
+    LUX_SCALAR_KERNEL_AVX2 : LUX_SCALAR_KERNEL_DEFAULT;
+}
+
+  // picked at load time, before any op or worker thread can read it
+static lxScalarArrayKernel_t l_ScalarKernel = ScalarArray_bestKernel();
+
+LUX_API lxScalarArrayKernel_t lxScalarArray_getKernel()
+{
+  return l_ScalarKernel;
+}
+
+LUX_API lxScalarArrayKernel_t lxScalarArray_setKernel(lxScalarArrayKernel_t kernel)
+{
+  if (lxScalarArray_isKernelSupported(kernel)){
+    l_ScalarKernel = kernel;
+  }
+  return lxScalarArray_getKernel();
+}
+
+  // all vectors back to back, sArg may also be a single scalar
+static LUX_INLINE booln ScalarArray_isCompact(const lxScalarArray_t &sOut, const lxScalarArray_t &sArg)
+{
+  return sArg.vectordim == sOut.vectordim && sArg.stride == sOut.vectordim;
+}
+static LUX_INLINE booln ScalarArray_isSingle(const lxScalarArray_t &sArg)
+{
+  return sArg.vectordim == 1 && sArg.stride == 0;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 typedef booln (LUX_FASTCALL TScalarArrayOp_in0_fn)(lxScalarArrayOp_t op, ScalarLoop &loop, lxScalarArray_t &sRet);
@@ -2094,7 +2150,7 @@ static TScalarArrayOp_in0_fn* l_TOp0[LUX_SCALAROPS_MAX_SUPPORTED] = {
   TScalarArrayOp_in0<uint32,ScalarLoop>,
 };
 
-LUX_API booln lxScalarArray_Op0(lxScalarArray_t *ret, lxScalarArrayOp_t op)
+booln ScalarArray_Op0(lxScalarArray_t *ret, lxScalarArrayOp_t op)
 {
   ScalarLoop loop(*ret);
 
@@ -2114,7 +2170,7 @@ static TScalarArrayOp_in1_fn* l_TOp1[LUX_SCALAROPS_MAX_SUPPORTED] = {
 };
 
 
-LUX_API booln lxScalarArray_Op1(lxScalarArray_t *ret, lxScalarArrayOp_t op, 
+booln ScalarArray_Op1(lxScalarArray_t *ret, lxScalarArrayOp_t op, 
               const lxScalarArray_t *arg0)
 {
   ScalarLoop1 loop(*ret,*arg0);
@@ -2137,13 +2193,24 @@ static TScalarArrayOp_in2_fn* l_TOp2[LUX_SCALAROPS_MAX_SUPPORTED] = {
 };
 
 
-LUX_API booln lxScalarArray_Op2(lxScalarArray_t *ret, lxScalarArrayOp_t op,
+booln ScalarArray_Op2(lxScalarArray_t *ret, lxScalarArrayOp_t op,
   const lxScalarArray_t *arg0,const lxScalarArray_t *arg1)
 {
   ScalarLoop2 loop(*ret,*arg0,*arg1);
   LUX_ASSERT( ret->type == arg0->type &&
         ret->type == arg1->type);
 
+#ifdef LUX_SIMD_AVX2
+  if (lxScalarArray_getKernel() == LUX_SCALAR_KERNEL_AVX2 && loop.cnt &&
+    ScalarArray_isCompact(*ret,*ret) && ScalarArray_isCompact(*ret,*arg0) && 
+    (ScalarArray_isCompact(*ret,*arg1) || ScalarArray_isSingle(*arg1)) &&
+    !AVXScalarArrayOp_in2(op,ret->type,loop.cnt,ScalarArray_isSingle(*arg1),
+      ret->data.tvoid,arg0->data.tvoid,arg1->data.tvoid))
+  {
+    return LUX_FALSE;
+  }
+#endif
+
   return l_TOp2[ret->type](op,loop,*ret,*arg0,*arg1);
 }
 
@@ -2160,7 +2227,7 @@ static TScalarArrayOp_in3_fn* l_TOp3[LUX_SCALAROPS_MAX_SUPPORTED] = {
 };
 
 
-LUX_API booln lxScalarArray_Op3(lxScalarArray_t *ret, lxScalarArrayOp_t op, 
+booln ScalarArray_Op3(lxScalarArray_t *ret, lxScalarArrayOp_t op, 
   const lxScalarArray_t *arg0,  const lxScalarArray_t *arg1,  const lxScalarArray_t *arg2)
 {
   ScalarLoop3 loop(*ret,*arg0,*arg1,*arg2);
@@ -2168,6 +2235,17 @@ LUX_API booln lxScalarArray_Op3(lxScalarArray_t *ret, lxScalarArrayOp_t op,
   LUX_ASSERT( ret->type == arg0->type &&
         ret->type == arg1->type &&
         ret->type == arg2->type);
+
+#ifdef LUX_SIMD_AVX2
+  if (lxScalarArray_getKernel() == LUX_SCALAR_KERNEL_AVX2 && loop.cnt &&
+    ScalarArray_isCompact(*ret,*ret) && ScalarArray_isCompact(*ret,*arg0) && ScalarArray_isCompact(*ret,*arg1) && 
+    (ScalarArray_isCompact(*ret,*arg2) || ScalarArray_isSingle(*arg2)) &&
+    !AVXScalarArrayOp_in3(op,ret->type,loop.cnt,ScalarArray_isSingle(*arg2),
+      ret->data.tvoid,arg0->data.tvoid,arg1->data.tvoid,arg2->data.tvoid))
+  {
+    return LUX_FALSE;
+  }
+#endif
   
   return l_TOp3[ret->type](op,loop,*ret,*arg0,*arg1,*arg2);
 }
@@ -2190,7 +2268,7 @@ static TScalarArrayOp3D_in0_fn* l_T3DOp0[LUX_SCALAROPS_MAX_SUPPORTED] = {
   TScalarArrayOp_in0<uint32,Scalar3DLoop>,
 };
 
-LUX_API booln lxScalarArray3D_Op0(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op)
+static booln ScalarArray3D_Op0(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op)
 {
   Scalar3DLoop loop(*ret,region);
   if (!loop.valid) 
@@ -2212,7 +2290,7 @@ static TScalarArrayOp3D_in1_fn* l_T3DOp1[LUX_SCALAROPS_MAX_SUPPORTED] = {
 };
 
 
-LUX_API booln lxScalarArray3D_Op1(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op,
+static booln ScalarArray3D_Op1(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op,
             const lxScalarArray3D_t *arg0)
 {
   Scalar3DLoop1 loop(*ret,region,*arg0);
@@ -2237,7 +2315,7 @@ static TScalarArrayOp3D_in2_fn* l_T3DOp2[LUX_SCALAROPS_MAX_SUPPORTED] = {
 };
 
 
-LUX_API booln lxScalarArray3D_Op2(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op,
+static booln ScalarArray3D_Op2(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op,
             const lxScalarArray3D_t *arg0,  const lxScalarArray3D_t *arg1)
 {
   Scalar3DLoop2 loop(*ret,region,*arg0,*arg1);
@@ -2263,7 +2341,7 @@ static TScalarArrayOp3D_in3_fn* l_T3DOp3[LUX_SCALAROPS_MAX_SUPPORTED] = {
 };
 
 
-LUX_API booln lxScalarArray3D_Op3(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op, 
+static booln ScalarArray3D_Op3(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op, 
             const lxScalarArray3D_t *arg0,  const lxScalarArray3D_t *arg1,  const lxScalarArray3D_t *arg2)
 {
   Scalar3DLoop3 loop(*ret,region,*arg0,*arg1,*arg2);
@@ -2277,6 +2355,305 @@ LUX_API booln lxScalarArray3D_Op3(lxScalarArray3D_t *ret, uint region[3], lxScal
   return l_T3DOp3[ret->sarr.type](op,loop,ret->sarr,arg0->sarr,arg1->sarr,arg2->sarr);
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Threaded Operations
+//
+// Large arrays are cut into chunks of about SCALAR_CHUNK_BYTES per array,
+// so that all arguments of a chunk stay in cache. 1D chunks are multiples
+// of 32 vectors, which keeps compact chunks aligned for the AVX2 kernels.
+
+#define SCALAR_CHUNK_BYTES    (1024*64)
+#define SCALAR_CHUNK_VECTORS  32
+
+static lxJobPoolPTR l_ScalarPool = NULL;
+static uint     l_ScalarMinScalars = LUX_SCALARARRAY_MT_MINSCALARS;
+
+typedef struct ScalarArrayJob_s{
+  lxScalarArrayOp_t op;
+  uint        numArrays;
+  uint        total;
+  uint        chunk;
+  volatile booln  error;
+  lxScalarArray_t   sarr[4];
+}ScalarArrayJob_t;
+
+typedef struct ScalarArray3DJob_s{
+  lxScalarArrayOp_t op;
+  uint        numArrays;
+  uint        axis;
+  uint        chunk;
+  uint        region[3];
+  volatile booln  error;
+  lxScalarArray3D_t sarr[4];
+}ScalarArray3DJob_t;
+
+LUX_API void lxScalarArray_setJobPool(lxJobPoolPTR pool, uint minScalars)
+{
+  l_ScalarPool = pool;
+  l_ScalarMinScalars = minScalars ? minScalars : LUX_SCALARARRAY_MT_MINSCALARS;
+}
+
+LUX_API lxJobPoolPTR lxScalarArray_getJobPool()
+{
+  return l_ScalarPool;
+}
+
+booln ScalarArray_useJobs(size_t scalars)
+{
+  return l_ScalarPool && scalars >= l_ScalarMinScalars && 
+    lxJobPool_getThreadCount(l_ScalarPool) > 1;
+}
+
+void ScalarArray_dispatch(lxJobPoolPTR pool, uint numJobs, lxJobPoolFunc_fn *func, void* userdata)
+{
+  if (!lxJobPool_tryRun(pool,numJobs,func,userdata)){
+    lxJobPool_run(NULL,numJobs,func,userdata);
+  }
+}
+
+  // items that fit SCALAR_CHUNK_BYTES, at least one
+static LUX_INLINE uint ScalarArray_chunkItems(lxScalarType_t type, size_t scalarsPerItem)
+{
+  size_t items = SCALAR_CHUNK_BYTES / (lx_gScalarTypeSizes[type] * scalarsPerItem);
+  return items ? (uint)items : 1;
+}
+
+static void ScalarArray_runJob(void* userdata, uint jobindex, uint threadindex)
+{
+  ScalarArrayJob_t* job = (ScalarArrayJob_t*)userdata;
+  lxScalarArray_t sarr[4];
+  uint start = jobindex * job->chunk;
+  uint count = LUX_MIN(job->chunk, job->total - start);
+  booln err = LUX_FALSE;
+
+  for (uint i = 0; i < job->numArrays; i++){
+    const lxScalarArray_t &src = job->sarr[i];
+    sarr[i] = src;
+    sarr[i].data.tvoid = (byte*)src.data.tvoid + 
+      (size_t)start * src.stride * lx_gScalarTypeSizes[src.type];
+    sarr[i].count = count;
+  }
+
+  switch(job->numArrays){
+  case 1: err = ScalarArray_Op0(&sarr[0],job->op); break;
+  case 2: err = ScalarArray_Op1(&sarr[0],job->op,&sarr[1]); break;
+  case 3: err = ScalarArray_Op2(&sarr[0],job->op,&sarr[1],&sarr[2]); break;
+  case 4: err = ScalarArray_Op3(&sarr[0],job->op,&sarr[1],&sarr[2],&sarr[3]); break;
+  }
+  if (err){
+    job->error = LUX_TRUE;
+  }
+}
+
+static booln ScalarArray_runJobs(ScalarArrayJob_t &job, lxScalarArrayOp_t op, uint numArrays, uint total)
+{
+  uint chunk = ScalarArray_chunkItems(job.sarr[0].type, job.sarr[0].vectordim);
+  chunk = ((chunk + SCALAR_CHUNK_VECTORS - 1)/SCALAR_CHUNK_VECTORS) * SCALAR_CHUNK_VECTORS;
+
+  job.op = op;
+  job.numArrays = numArrays;
+  job.total = total;
+  job.chunk = chunk;
+  job.error = LUX_FALSE;
+
+  ScalarArray_dispatch(l_ScalarPool, (total + chunk - 1)/chunk, ScalarArray_runJob, &job);
+
+  return job.error;
+}
+
+static void ScalarArray3D_runJob(void* userdata, uint jobindex, uint threadindex)
+{
+  ScalarArray3DJob_t* job = (ScalarArray3DJob_t*)userdata;
+  lxScalarArray3D_t sarr[4];
+  uint region[3] = {job->region[0],job->region[1],job->region[2]};
+  uint axis = job->axis;
+  uint start = jobindex * job->chunk;
+  booln err = LUX_FALSE;
+
+  region[axis] = LUX_MIN(job->chunk, job->region[axis] - start);
+
+  for (uint i = 0; i < job->numArrays; i++){
+    const lxScalarArray3D_t &src = job->sarr[i];
+    sarr[i] = src;
+    if (src.sarr.stride){
+      uint step = axis == 2 ? src.size[0] * src.size[1] : src.size[0];
+      sarr[i].sarr.data.tvoid = (byte*)src.sarr.data.tvoid + 
+        (size_t)start * step * src.sarr.stride * lx_gScalarTypeSizes[src.sarr.type];
+      sarr[i].sarr.count -= start * step;
+      sarr[i].offset[axis] += start;
+    }
+  }
+
+  switch(job->numArrays){
+  case 1: err = ScalarArray3D_Op0(&sarr[0],region,job->op); break;
+  case 2: err = ScalarArray3D_Op1(&sarr[0],region,job->op,&sarr[1]); break;
+  case 3: err = ScalarArray3D_Op2(&sarr[0],region,job->op,&sarr[1],&sarr[2]); break;
+  case 4: err = ScalarArray3D_Op3(&sarr[0],region,job->op,&sarr[1],&sarr[2],&sarr[3]); break;
+  }
+  if (err){
+    job->error = LUX_TRUE;
+  }
+}
+
+  // cuts along slices, or rows if region is a single slice
+static booln ScalarArray3D_runJobs(ScalarArray3DJob_t &job, lxScalarArrayOp_t op, uint numArrays, const uint region[3])
+{
+  uint axis = region[2] > 1 ? 2 : 1;
+  size_t scalarsPerItem = (size_t)region[0] * job.sarr[0].sarr.vectordim * (axis == 2 ? region[1] : 1);
+  uint chunk = ScalarArray_chunkItems(job.sarr[0].sarr.type, scalarsPerItem);
+
+  job.op = op;
+  job.numArrays = numArrays;
+  job.axis = axis;
+  job.chunk = chunk;
+  job.region[0] = region[0];
+  job.region[1] = region[1];
+  job.region[2] = region[2];
+  job.error = LUX_FALSE;
+
+  ScalarArray_dispatch(l_ScalarPool, (region[axis] + chunk - 1)/chunk, ScalarArray3D_runJob, &job);
+
+  return job.error;
+}
+
+static LUX_INLINE size_t ScalarArray3D_regionScalars(const lxScalarArray3D_t *sarr, const uint region[3])
+{
+  return (size_t)region[0] * region[1] * region[2] * sarr->sarr.vectordim;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+LUX_API booln lxScalarArray_Op0(lxScalarArray_t *ret, lxScalarArrayOp_t op)
+{
+  if (ScalarArray_useJobs((size_t)ret->count * ret->vectordim)){
+    ScalarArrayJob_t job;
+    job.sarr[0] = *ret;
+    return ScalarArray_runJobs(job,op,1,ret->count);
+  }
+
+  return ScalarArray_Op0(ret,op);
+}
+
+LUX_API booln lxScalarArray_Op1(lxScalarArray_t *ret, lxScalarArrayOp_t op, 
+              const lxScalarArray_t *arg0)
+{
+  uint total = LUX_MIN(ret->count,arg0->count);
+
+  if (ScalarArray_useJobs((size_t)total * ret->vectordim)){
+    ScalarArrayJob_t job;
+    job.sarr[0] = *ret;
+    job.sarr[1] = *arg0;
+    return ScalarArray_runJobs(job,op,2,total);
+  }
+
+  return ScalarArray_Op1(ret,op,arg0);
+}
+
+LUX_API booln lxScalarArray_Op2(lxScalarArray_t *ret, lxScalarArrayOp_t op,
+  const lxScalarArray_t *arg0,const lxScalarArray_t *arg1)
+{
+  uint total = LUX_MIN(LUX_MIN(ret->count,arg0->count),arg1->count);
+
+  if (ScalarArray_useJobs((size_t)total * ret->vectordim)){
+    ScalarArrayJob_t job;
+    job.sarr[0] = *ret;
+    job.sarr[1] = *arg0;
+    job.sarr[2] = *arg1;
+    return ScalarArray_runJobs(job,op,3,total);
+  }
+
+  return ScalarArray_Op2(ret,op,arg0,arg1);
+}
+
+LUX_API booln lxScalarArray_Op3(lxScalarArray_t *ret, lxScalarArrayOp_t op, 
+  const lxScalarArray_t *arg0,  const lxScalarArray_t *arg1,  const lxScalarArray_t *arg2)
+{
+  uint total = LUX_MIN(LUX_MIN(ret->count,arg0->count),LUX_MIN(arg1->count,arg2->count));
+
+  if (ScalarArray_useJobs((size_t)total * ret->vectordim)){
+    ScalarArrayJob_t job;
+    job.sarr[0] = *ret;
+    job.sarr[1] = *arg0;
+    job.sarr[2] = *arg1;
+    job.sarr[3] = *arg2;
+    return ScalarArray_runJobs(job,op,4,total);
+  }
+
+  return ScalarArray_Op3(ret,op,arg0,arg1,arg2);
+}
+
+LUX_API booln lxScalarArray3D_Op0(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op)
+{
+  if (ScalarArray_useJobs(ScalarArray3D_regionScalars(ret,region))){
+    ScalarArray3DJob_t job;
+    Scalar3DLoop loop(*ret,region);
+    if (!loop.valid) 
+      return LUX_TRUE;
+
+    job.sarr[0] = *ret;
+    return ScalarArray3D_runJobs(job,op,1,region);
+  }
+
+  return ScalarArray3D_Op0(ret,region,op);
+}
+
+LUX_API booln lxScalarArray3D_Op1(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op,
+            const lxScalarArray3D_t *arg0)
+{
+  if (ScalarArray_useJobs(ScalarArray3D_regionScalars(ret,region))){
+    ScalarArray3DJob_t job;
+    Scalar3DLoop1 loop(*ret,region,*arg0);
+    if (!loop.valid) 
+      return LUX_TRUE;
+
+    job.sarr[0] = *ret;
+    job.sarr[1] = *arg0;
+    return ScalarArray3D_runJobs(job,op,2,region);
+  }
+
+  return ScalarArray3D_Op1(ret,region,op,arg0);
+}
+
+LUX_API booln lxScalarArray3D_Op2(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op,
+            const lxScalarArray3D_t *arg0,  const lxScalarArray3D_t *arg1)
+{
+  if (ScalarArray_useJobs(ScalarArray3D_regionScalars(ret,region))){
+    ScalarArray3DJob_t job;
+    Scalar3DLoop2 loop(*ret,region,*arg0,*arg1);
+    if (!loop.valid) 
+      return LUX_TRUE;
+
+    job.sarr[0] = *ret;
+    job.sarr[1] = *arg0;
+    job.sarr[2] = *arg1;
+    return ScalarArray3D_runJobs(job,op,3,region);
+  }
+
+  return ScalarArray3D_Op2(ret,region,op,arg0,arg1);
+}
+
+LUX_API booln lxScalarArray3D_Op3(lxScalarArray3D_t *ret, uint region[3], lxScalarArrayOp_t op, 
+            const lxScalarArray3D_t *arg0,  const lxScalarArray3D_t *arg1,  const lxScalarArray3D_t *arg2)
+{
+  if (ScalarArray_useJobs(ScalarArray3D_regionScalars(ret,region))){
+    ScalarArray3DJob_t job;
+    Scalar3DLoop3 loop(*ret,region,*arg0,*arg1,*arg2);
+    if (!loop.valid) 
+      return LUX_TRUE;
+
+    job.sarr[0] = *ret;
+    job.sarr[1] = *arg0;
+    job.sarr[2] = *arg1;
+    job.sarr[3] = *arg2;
+    return ScalarArray3D_runJobs(job,op,4,region);
+  }
+
+  return ScalarArray3D_Op3(ret,region,op,arg0,arg1,arg2);
+}
+
+#undef SCALAR_CHUNK_BYTES
+#undef SCALAR_CHUNK_VECTORS
+
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -3648,13 +4025,13 @@ struct FVector4 {
     return *this;
   }
 
+    // vector3 length, as in SSE version
   LUX_INLINE float Distance(const FVector4& other) const {
     float a = data[0]-other.data[0];
     float b = data[1]-other.data[1];
     float c = data[2]-other.data[2];
-    float d = data[3]-other.data[3];
 
-    return sqrtf(a*a + b*b + c*c + d*d);
+    return sqrtf(a*a + b*b + c*c);
   }
 };
 #ifdef SCALAR_USE_XMM
@@ -4051,13 +4428,14 @@ LUX_API booln lxFScalarArray_op1(lxScalarArray_t *sarray, lxFScalarArrayOp_t op,
     }else{
       l_FTransform1SSE[op](*sarray,*sarray0,arg);
     }
+    return LUX_FALSE;
   }
 #endif
 
   if (sarray->data.tvoid == sarray0->data.tvoid){
-    l_FTransform0[(sarray->vectordim - 1) + (op * 3)](*sarray,arg);
+    l_FTransform0[(sarray->vectordim - 2) + (op * 3)](*sarray,arg);
   }else{
-    l_FTransform1[(sarray->vectordim - 1) + (op * 3)](*sarray,*sarray0,arg);
+    l_FTransform1[(sarray->vectordim - 2) + (op * 3)](*sarray,*sarray0,arg);
   }
   
   return LUX_FALSE;
@@ -4065,116 +4443,61 @@ LUX_API booln lxFScalarArray_op1(lxScalarArray_t *sarray, lxFScalarArrayOp_t op,
 
 
 
-typedef float (LUX_FASTCALL TFScalarArray_relLength_fn)(lxScalarArray_t &sOut, lxScalarArray_t &sIn);
+  // writes distance to previous point, 0 for first
+typedef void (LUX_FASTCALL TFScalarArray_segLength_fn)(lxScalarArray_t &sOut, const lxScalarArray_t &sIn, uint count);
 
-template <class Tout, class Tin, int OUTVECSIZE, int INVECSIZE>
-float LUX_FASTCALL TFScalarArray_relLength(lxScalarArray_t &sOut, lxScalarArray_t &sIn)
+template <class Tin, int INVECSIZE>
+void LUX_FASTCALL TFScalarArray_segLength(lxScalarArray_t &sOut, const lxScalarArray_t &sIn, uint count)
 {
-  Tout* LUX_RESTRICT pOut = (Tout*)sOut.data.tfloat;
-  Tin*  LUX_RESTRICT pIn  = (Tin*)sIn.data.tfloat;
+  float* LUX_RESTRICT pOut = sOut.data.tfloat;
+  const Tin*  LUX_RESTRICT pIn  = (const Tin*)sIn.data.tfloat;
 
-  size_t ostride = sOut.stride / OUTVECSIZE;
+  size_t ostride = sOut.stride;
   size_t istride = sIn.stride / INVECSIZE;
-  size_t count = LUX_MIN(sOut.count,sIn.count);
-
 
-  float length = 0.0f;
+  pOut[0] = 0.0f;
+  pOut += ostride;
+  pIn += istride;
 
   if (ostride == 1 && istride == 1){
-    size_t unrollcnt = ((count-1)/8);
-
-    pOut[0].Set(0.0f);
-    pOut++;
-    pIn++;
-    for (size_t i = 0; i < unrollcnt; i++, pOut += 8, pIn += 8){
-      length += pIn[0].Distance(pIn[-1]);
-      pOut[0].Set(length);
-
-      length += pIn[1].Distance(pIn[0]);
-      pOut[1].Set(length);
-
-      length += pIn[2].Distance(pIn[1]);
-      pOut[2].Set(length);
-
-      length += pIn[3].Distance(pIn[2]);
-      pOut[3].Set(length);
-
-      length += pIn[4].Distance(pIn[3]);
-      pOut[4].Set(length);
-
-      length += pIn[5].Distance(pIn[4]);
-      pOut[5].Set(length);
-
-      length += pIn[6].Distance(pIn[5]);
-      pOut[6].Set(length);
-
-      length += pIn[7].Distance(pIn[6]);
-      pOut[7].Set(length);
-    }
-    for (size_t i = unrollcnt*8 +1; i < count; i++, pOut ++, pIn++){
-      length += pIn[0].Distance(pIn[-1]);
-      pOut[0].Set(length);
-    }
-
-
-    pOut = (Tout*)sOut.data.tfloat;
-    float invlength = 1.0f/length;
-
-    for (size_t i = 0; i < unrollcnt; i++, pOut += 8){
-      pOut[0] *= invlength;
-      pOut[1] *= invlength;
-      pOut[2] *= invlength;
-      pOut[3] *= invlength;
-      pOut[4] *= invlength;
-      pOut[5] *= invlength;
-      pOut[6] *= invlength;
-      pOut[7] *= invlength;
+    for (uint i = 1; i < count; i++, pOut++, pIn++){
+      pOut[0] = pIn[0].Distance(pIn[-1]);
     }
-    for (size_t i = unrollcnt*8 +1; i < count; i++, pOut ++){
-      pOut[0] *= invlength;
-    }
-
   }
   else{
-    pOut[0].Set(0.0f);
-    pOut += ostride;
-    pIn += istride;
-    for (size_t i = 1; i < count; i++, pOut += ostride, pIn += istride){
-      Tin* LUX_RESTRICT pInLast = pIn - istride;
-      length += pIn[0].Distance(pInLast[0]);
-      pOut[0].Set(length);
-    }
-
-    pOut = (Tout*)sOut.data.tfloat;
-    float invlength = 1.0f/length;
-    for (size_t i = 1; i < count; i++, pOut += ostride){
-      pOut[0] *= invlength;
+    for (uint i = 1; i < count; i++, pOut += ostride, pIn += istride){
+      pOut[0] = pIn[0].Distance(pIn[-(ptrdiff_t)istride]);
     }
   }
-
-  return length;
 }
 
 #ifdef SCALAR_USE_XMM
-static TFScalarArray_relLength_fn *l_FRelLengthSSE[4] = {
-  TFScalarArray_relLength<FVector1,FVector4SSE,1,4>,
-  TFScalarArray_relLength<FVector1,FVector4SSE,1,4>,
-  TFScalarArray_relLength<FVector1,FVector4SSE,1,4>,
-  TFScalarArray_relLength<FVector1,FVector4SSE,1,4>,
+static TFScalarArray_segLength_fn *l_FSegLengthSSE[4] = {
+  TFScalarArray_segLength<FVector4SSE,4>,
+  TFScalarArray_segLength<FVector4SSE,4>,
+  TFScalarArray_segLength<FVector4SSE,4>,
+  TFScalarArray_segLength<FVector4SSE,4>,
 };
 #endif
 
-static TFScalarArray_relLength_fn *l_FRelLength[4] = {
-  TFScalarArray_relLength<FVector1,FVector1,1,1>,
-  TFScalarArray_relLength<FVector1,FVector2,1,2>,
-  TFScalarArray_relLength<FVector1,FVector3,1,3>,
-  TFScalarArray_relLength<FVector1,FVector4,1,4>,
+static TFScalarArray_segLength_fn *l_FSegLength[4] = {
+  TFScalarArray_segLength<FVector1,1>,
+  TFScalarArray_segLength<FVector2,2>,
+  TFScalarArray_segLength<FVector3,3>,
+  TFScalarArray_segLength<FVector4,4>,
 };
 
+  // segment lengths, then scanned and normalized in place
 LUX_API booln lxFScalarArray_relLength(lxScalarArray_t *sarray, lxScalarArray_t *sarray0, float *outlength)
 {
+  lxScalarArray_t slen;
+  lxScalarArray_t sscale;
+  uint count;
+  float length;
+  float invlength;
+
   if (sarray->type != LUX_SCALAR_FLOAT32 || sarray->type != sarray0->type || 
-    sarray0->count < 2 || sarray->count < 2 || sarray->vectordim != 1)
+    sarray0->count < 2 || sarray->count < 2 || sarray->vectordim != 1 || !sarray->stride)
   {
     return LUX_TRUE;
   }
@@ -4182,18 +4505,32 @@ LUX_API booln lxFScalarArray_relLength(lxScalarArray_t *sarray, lxScalarArray_t
   LUX_ASSERT(sarray0->vectordim < 5);
 
   LUX_ASSUME(sarray0->vectordim < 5);
+  count = LUX_MIN(sarray->count,sarray0->count);
+  slen = *sarray;
+  slen.count = count;
+
 #ifdef SCALAR_USE_XMM
   if (sarray0->vectordim == 4 && sarray0->stride % 4 == 0 &&
     LUX_IS_ALIGNED(sarray0->data.tvoid,16) )
   {
-    float len = l_FRelLengthSSE[sarray0->vectordim](*sarray,*sarray0);
-    if (outlength) *outlength = len;
-    return LUX_FALSE;
+    l_FSegLengthSSE[sarray0->vectordim-1](slen,*sarray0,count);
   }
+  else
 #endif
+  {
+    l_FSegLength[sarray0->vectordim-1](slen,*sarray0,count);
+  }
 
-  float len = l_FRelLength[sarray0->vectordim](*sarray,*sarray0);
-  if (outlength) *outlength = len;
+  lxScalarArray_scanInclusive(&slen,&slen);
+
+  length = slen.data.tfloat[(size_t)(count-1) * slen.stride];
+  if (length > 0.0f){
+    invlength = 1.0f/length;
+    lxScalarArray_initSingle(&sscale,LUX_SCALAR_FLOAT32,&invlength,1);
+    sscale.count = count;
+    lxScalarArray_Op2(&slen,LUX_SCALAR_OP2_MUL,&slen,&sscale);
+  }
+  if (outlength) *outlength = length;
 
   return LUX_FALSE;
-}
\ No newline at end of file
+}
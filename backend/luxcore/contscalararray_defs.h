@@ -0,0 +1,54 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXCORE_CONTSCALARARRAYDEFS_H__
+#define __LUXCORE_CONTSCALARARRAYDEFS_H__
+
+#include <luxinia/luxplatform/luxplatform.h>
+#include <luxinia/luxcore/contscalararray.h>
+
+//////////////////////////////////////////////////////////////////////////
+// Single-threaded operations, also used per chunk by threaded ops
+// and ScalarExpr (contscalarexpr.cpp)
+
+booln ScalarArray_Op0(lxScalarArray_t *ret, lxScalarArrayOp_t op);
+booln ScalarArray_Op1(lxScalarArray_t *ret, lxScalarArrayOp_t op, 
+  const lxScalarArray_t *arg0);
+booln ScalarArray_Op2(lxScalarArray_t *ret, lxScalarArrayOp_t op,
+  const lxScalarArray_t *arg0, const lxScalarArray_t *arg1);
+booln ScalarArray_Op3(lxScalarArray_t *ret, lxScalarArrayOp_t op, 
+  const lxScalarArray_t *arg0, const lxScalarArray_t *arg1, const lxScalarArray_t *arg2);
+
+  // TRUE if job pool is set and scalars exceed its threshold
+booln ScalarArray_useJobs(size_t scalars);
+  // runs jobs on pool, or on the calling thread (threadindex 0)
+  // if the pool is busy with another op or we are within one of its jobs
+void  ScalarArray_dispatch(lxJobPoolPTR pool, uint numJobs, lxJobPoolFunc_fn *func, void* userdata);
+
+//////////////////////////////////////////////////////////////////////////
+// AVX2/FMA kernels (contscalararrayavx.cpp)
+//
+// operate on compact arrays, count is number of scalars.
+// if single is set the last argument is a single scalar that is
+// used for all elements. Pointers need no alignment.
+// Results are identical to the templated loops, for all ops also in
+// the single forms, except:
+// - float OP3 uses fused multiply-add, which rounds once
+// - uint16 MUL_SAT/MADD_SAT saturate products that overflow int32
+// - uint16 LERP/LERPINV use the exact (b-a)*t where the templated
+//   loops overflow int32
+// int32/uint32 LERP/LERPINV wrap (b-a)*t in 32-bit like the
+// templated loops, the division is exact in double.
+// return TRUE if op/type is not handled
+
+#ifdef LUX_SIMD_AVX2
+
+booln AVXScalarArrayOp_in2(lxScalarArrayOp_t op, lxScalarType_t type, size_t count, booln single,
+  void* pOut, const void* pArg0, const void* pArg1);
+booln AVXScalarArrayOp_in3(lxScalarArrayOp_t op, lxScalarType_t type, size_t count, booln single,
+  void* pOut, const void* pArg0, const void* pArg1, const void* pArg2);
+
+#endif
+
+#endif
@@ -0,0 +1,779 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxmath/basetypes.h>
+#include "contscalararray_defs.h"
+
+#ifdef LUX_SIMD_AVX2
+
+#include <immintrin.h>
+#include <memory.h>
+
+//////////////////////////////////////////////////////////////////////////
+// Helpers
+//
+// Integer division and the integer lerps have no native instructions,
+// they are done in float (8-bit) or double (16/32-bit) precision, which
+// is exact for the value ranges involved.
+
+static LUX_INLINE __m256i AVX_loadi(const void* ptr)
+{
+  return _mm256_loadu_si256((const __m256i*)ptr);
+}
+static LUX_INLINE void AVX_storei(void* ptr, __m256i v)
+{
+  _mm256_storeu_si256((__m256i*)ptr,v);
+}
+
+  // 8-bit products, low bits, valid for signed and unsigned
+static LUX_INLINE __m256i AVX_mullo8(__m256i a, __m256i b)
+{
+  __m256i even = _mm256_mullo_epi16(a,b);
+  __m256i odd  = _mm256_mullo_epi16(_mm256_srli_epi16(a,8),_mm256_srli_epi16(b,8));
+  return _mm256_or_si256(_mm256_and_si256(even,_mm256_set1_epi16(0xFF)),_mm256_slli_epi16(odd,8));
+}
+
+  // unsigned 16-bit products clamped to 0xFFFF
+static LUX_INLINE __m256i AVX_mulSatU16(__m256i a, __m256i b)
+{
+  __m256i lo = _mm256_mullo_epi16(a,b);
+  __m256i hi = _mm256_mulhi_epu16(a,b);
+  __m256i overflow = _mm256_andnot_si256(_mm256_cmpeq_epi16(hi,_mm256_setzero_si256()),_mm256_set1_epi16(-1));
+  return _mm256_or_si256(lo,overflow);
+}
+
+// widen 8-bit to 4x 32-bit
+static LUX_INLINE void AVX_widen8to32(__m256i out[4], __m256i v, booln sign)
+{
+  __m128i lo = _mm256_castsi256_si128(v);
+  __m128i hi = _mm256_extracti128_si256(v,1);
+  if (sign){
+    out[0] = _mm256_cvtepi8_epi32(lo);
+    out[1] = _mm256_cvtepi8_epi32(_mm_srli_si128(lo,8));
+    out[2] = _mm256_cvtepi8_epi32(hi);
+    out[3] = _mm256_cvtepi8_epi32(_mm_srli_si128(hi,8));
+  }
+  else{
+    out[0] = _mm256_cvtepu8_epi32(lo);
+    out[1] = _mm256_cvtepu8_epi32(_mm_srli_si128(lo,8));
+    out[2] = _mm256_cvtepu8_epi32(hi);
+    out[3] = _mm256_cvtepu8_epi32(_mm_srli_si128(hi,8));
+  }
+}
+// widen 8-bit to 2x 16-bit
+static LUX_INLINE void AVX_widen8to16(__m256i out[2], __m256i v, booln sign)
+{
+  __m128i lo = _mm256_castsi256_si128(v);
+  __m128i hi = _mm256_extracti128_si256(v,1);
+  if (sign){
+    out[0] = _mm256_cvtepi8_epi16(lo);
+    out[1] = _mm256_cvtepi8_epi16(hi);
+  }
+  else{
+    out[0] = _mm256_cvtepu8_epi16(lo);
+    out[1] = _mm256_cvtepu8_epi16(hi);
+  }
+}
+// widen 16-bit to 2x 32-bit
+static LUX_INLINE void AVX_widen16to32(__m256i out[2], __m256i v, booln sign)
+{
+  __m128i lo = _mm256_castsi256_si128(v);
+  __m128i hi = _mm256_extracti128_si256(v,1);
+  if (sign){
+    out[0] = _mm256_cvtepi16_epi32(lo);
+    out[1] = _mm256_cvtepi16_epi32(hi);
+  }
+  else{
+    out[0] = _mm256_cvtepu16_epi32(lo);
+    out[1] = _mm256_cvtepu16_epi32(hi);
+  }
+}
+
+// pack instructions work per 128-bit lane, restore element order
+static LUX_INLINE __m256i AVX_fixPack2(__m256i v)
+{
+  return _mm256_permute4x64_epi64(v,0xD8);
+}
+static LUX_INLINE __m256i AVX_fixPack4(__m256i v)
+{
+  return _mm256_permutevar8x32_epi32(v,_mm256_setr_epi32(0,4,1,5,2,6,3,7));
+}
+
+// narrow 32-bit to 8-bit, wrap: truncate, sat: signed/unsigned saturation
+static LUX_INLINE __m256i AVX_narrow32to8wrap(const __m256i v[4])
+{
+  __m256i mask = _mm256_set1_epi32(0xFF);
+  __m256i ab = _mm256_packus_epi32(_mm256_and_si256(v[0],mask),_mm256_and_si256(v[1],mask));
+  __m256i cd = _mm256_packus_epi32(_mm256_and_si256(v[2],mask),_mm256_and_si256(v[3],mask));
+  return AVX_fixPack4(_mm256_packus_epi16(ab,cd));
+}
+static LUX_INLINE __m256i AVX_narrow32to8sat(const __m256i v[4], booln sign)
+{
+  if (sign){
+    return AVX_fixPack4(_mm256_packs_epi16(_mm256_packs_epi32(v[0],v[1]),_mm256_packs_epi32(v[2],v[3])));
+  }
+  else{
+    return AVX_fixPack4(_mm256_packus_epi16(_mm256_packus_epi32(v[0],v[1]),_mm256_packus_epi32(v[2],v[3])));
+  }
+}
+static LUX_INLINE __m256i AVX_narrow16to8sat(const __m256i v[2], booln sign)
+{
+  return AVX_fixPack2(sign ? _mm256_packs_epi16(v[0],v[1]) : _mm256_packus_epi16(v[0],v[1]));
+}
+static LUX_INLINE __m256i AVX_narrow32to16wrap(const __m256i v[2])
+{
+  __m256i mask = _mm256_set1_epi32(0xFFFF);
+  return AVX_fixPack2(_mm256_packus_epi32(_mm256_and_si256(v[0],mask),_mm256_and_si256(v[1],mask)));
+}
+static LUX_INLINE __m256i AVX_narrow32to16sat(const __m256i v[2], booln sign)
+{
+  return AVX_fixPack2(sign ? _mm256_packs_epi32(v[0],v[1]) : _mm256_packus_epi32(v[0],v[1]));
+}
+
+// int32 lanes (values fit 16-bit) divided in float
+static LUX_INLINE __m256i AVX_divSmallEpi32(__m256i a, __m256i b)
+{
+  return _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(a),_mm256_cvtepi32_ps(b)));
+}
+// a + ((b-a)*t)/max, int32 lanes (values fit 16-bit) in float
+static LUX_INLINE __m256i AVX_lerpSmallEpi32(__m256i a, __m256i b, __m256i t, __m256 max)
+{
+  __m256 prod = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(b,a)),_mm256_cvtepi32_ps(t));
+  return _mm256_add_epi32(a,_mm256_cvttps_epi32(_mm256_div_ps(prod,max)));
+}
+
+static LUX_INLINE __m256i AVX_combine128(__m128i lo, __m128i hi)
+{
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo),hi,1);
+}
+static LUX_INLINE __m256i AVX_divEpi32(__m256i a, __m256i b)
+{
+  __m256d alo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(a));
+  __m256d ahi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(a,1));
+  __m256d blo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(b));
+  __m256d bhi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(b,1));
+  return AVX_combine128(
+    _mm256_cvttpd_epi32(_mm256_div_pd(alo,blo)),
+    _mm256_cvttpd_epi32(_mm256_div_pd(ahi,bhi)));
+}
+static LUX_INLINE __m256d AVX_cvtepu32_pd(__m128i v)
+{
+  return _mm256_add_pd(
+    _mm256_cvtepi32_pd(_mm_xor_si128(v,_mm_set1_epi32(0x80000000))),
+    _mm256_set1_pd(2147483648.0));
+}
+static LUX_INLINE __m128i AVX_cvtpd_epu32(__m256d v)
+{
+  // v is integral and positive
+  return _mm_xor_si128(
+    _mm256_cvttpd_epi32(_mm256_sub_pd(v,_mm256_set1_pd(2147483648.0))),
+    _mm_set1_epi32(0x80000000));
+}
+static LUX_INLINE __m256i AVX_divEpu32(__m256i a, __m256i b)
+{
+  __m256d alo = AVX_cvtepu32_pd(_mm256_castsi256_si128(a));
+  __m256d ahi = AVX_cvtepu32_pd(_mm256_extracti128_si256(a,1));
+  __m256d blo = AVX_cvtepu32_pd(_mm256_castsi256_si128(b));
+  __m256d bhi = AVX_cvtepu32_pd(_mm256_extracti128_si256(b,1));
+  return AVX_combine128(
+    AVX_cvtpd_epu32(_mm256_floor_pd(_mm256_div_pd(alo,blo))),
+    AVX_cvtpd_epu32(_mm256_floor_pd(_mm256_div_pd(ahi,bhi))));
+}
+// a + ((b-a)*t)/max, int32 lanes (values fit 16-bit) in double
+static LUX_INLINE __m256i AVX_lerpWideEpi32(__m256i a, __m256i b, __m256i t, __m256d max)
+{
+  __m256i diff = _mm256_sub_epi32(b,a);
+  __m256d lo = _mm256_mul_pd(
+    _mm256_cvtepi32_pd(_mm256_castsi256_si128(diff)),
+    _mm256_cvtepi32_pd(_mm256_castsi256_si128(t)));
+  __m256d hi = _mm256_mul_pd(
+    _mm256_cvtepi32_pd(_mm256_extracti128_si256(diff,1)),
+    _mm256_cvtepi32_pd(_mm256_extracti128_si256(t,1)));
+  return _mm256_add_epi32(a,AVX_combine128(
+    _mm256_cvttpd_epi32(_mm256_div_pd(lo,max)),
+    _mm256_cvttpd_epi32(_mm256_div_pd(hi,max))));
+}
+
+static LUX_INLINE __m256i AVX_clampEpi32(__m256i v, int32 min, int32 max)
+{
+  return _mm256_min_epi32(_mm256_max_epi32(v,_mm256_set1_epi32(min)),_mm256_set1_epi32(max));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Types
+//
+// saturation ranges match l_ScalarMin/l_ScalarMax of contscalararray.cpp
+
+class AVXFloat{
+public:
+  typedef float   T;
+  typedef __m256  V;
+  enum{
+    LANES = 8,
+  };
+
+  static LUX_INLINE V load(const T* ptr)      { return _mm256_loadu_ps(ptr); }
+  static LUX_INLINE void store(T* ptr, V v)   { _mm256_storeu_ps(ptr,v); }
+  static LUX_INLINE V set1(T val)             { return _mm256_set1_ps(val); }
+  static LUX_INLINE V sat(V v)                { return _mm256_min_ps(_mm256_max_ps(v,_mm256_setzero_ps()),_mm256_set1_ps(1.0f)); }
+
+  static LUX_INLINE V add(V a, V b)     { return _mm256_add_ps(a,b); }
+  static LUX_INLINE V sub(V a, V b)     { return _mm256_sub_ps(a,b); }
+  static LUX_INLINE V mul(V a, V b)     { return _mm256_mul_ps(a,b); }
+  static LUX_INLINE V div(V a, V b)     { return _mm256_div_ps(a,b); }
+  static LUX_INLINE V min(V a, V b)     { return _mm256_min_ps(a,b); }
+  static LUX_INLINE V max(V a, V b)     { return _mm256_max_ps(a,b); }
+  static LUX_INLINE V addSat(V a, V b)  { return sat(_mm256_add_ps(a,b)); }
+  static LUX_INLINE V subSat(V a, V b)  { return sat(_mm256_sub_ps(a,b)); }
+  static LUX_INLINE V mulSat(V a, V b)  { return sat(_mm256_mul_ps(a,b)); }
+  static LUX_INLINE V divSat(V a, V b)  { return sat(_mm256_div_ps(a,b)); }
+
+  static LUX_INLINE V lerp(V a, V b, V t)     { return _mm256_fmadd_ps(_mm256_sub_ps(b,a),t,a); }
+  static LUX_INLINE V lerpInv(V a, V b, V t)  { return _mm256_fmadd_ps(_mm256_sub_ps(b,a),_mm256_sub_ps(_mm256_set1_ps(1.0f),t),a); }
+  static LUX_INLINE V madd(V a, V b, V c)     { return _mm256_fmadd_ps(b,c,a); }
+  static LUX_INLINE V maddSat(V a, V b, V c)  { return sat(_mm256_fmadd_ps(b,c,a)); }
+};
+
+template <class Tscalar>
+class AVXInteger{
+public:
+  typedef Tscalar T;
+  typedef __m256i V;
+  enum{
+    LANES = 32/sizeof(T),
+  };
+
+  static LUX_INLINE V load(const T* ptr)      { return AVX_loadi(ptr); }
+  static LUX_INLINE void store(T* ptr, V v)   { AVX_storei(ptr,v); }
+};
+
+class AVXInt8 : public AVXInteger<int8>{
+public:
+  static LUX_INLINE V set1(T val)       { return _mm256_set1_epi8(val); }
+  static LUX_INLINE V satMin(V v)       { return _mm256_max_epi8(v,_mm256_set1_epi8(-127)); }
+
+  static LUX_INLINE V add(V a, V b)     { return _mm256_add_epi8(a,b); }
+  static LUX_INLINE V sub(V a, V b)     { return _mm256_sub_epi8(a,b); }
+  static LUX_INLINE V mul(V a, V b)     { return AVX_mullo8(a,b); }
+  static LUX_INLINE V div(V a, V b)
+  {
+    __m256i wa[4];
+    __m256i wb[4];
+    AVX_widen8to32(wa,a,LUX_TRUE);
+    AVX_widen8to32(wb,b,LUX_TRUE);
+    for (int i = 0; i < 4; i++){
+      wa[i] = AVX_divSmallEpi32(wa[i],wb[i]);
+    }
+    return AVX_narrow32to8wrap(wa);
+  }
+  static LUX_INLINE V min(V a, V b)     { return _mm256_min_epi8(a,b); }
+  static LUX_INLINE V max(V a, V b)     { return _mm256_max_epi8(a,b); }
+  static LUX_INLINE V addSat(V a, V b)  { return satMin(_mm256_adds_epi8(a,b)); }
+  static LUX_INLINE V subSat(V a, V b)  { return satMin(_mm256_subs_epi8(a,b)); }
+  static LUX_INLINE V mulSat(V a, V b)
+  {
+    __m256i wa[2];
+    __m256i wb[2];
+    AVX_widen8to16(wa,a,LUX_TRUE);
+    AVX_widen8to16(wb,b,LUX_TRUE);
+    wa[0] = _mm256_mullo_epi16(wa[0],wb[0]);
+    wa[1] = _mm256_mullo_epi16(wa[1],wb[1]);
+    return satMin(AVX_narrow16to8sat(wa,LUX_TRUE));
+  }
+  static LUX_INLINE V divSat(V a, V b)
+  {
+    __m256i wa[4];
+    __m256i wb[4];
+    AVX_widen8to32(wa,a,LUX_TRUE);
+    AVX_widen8to32(wb,b,LUX_TRUE);
+    for (int i = 0; i < 4; i++){
+      wa[i] = AVX_divSmallEpi32(wa[i],wb[i]);
+    }
+    return satMin(AVX_narrow32to8sat(wa,LUX_TRUE));
+  }
+
+  static LUX_INLINE V lerp(V a, V b, V t)
+  {
+    __m256 max = _mm256_set1_ps(127.0f);
+    __m256i wa[4];
+    __m256i wb[4];
+    __m256i wt[4];
+    AVX_widen8to32(wa,a,LUX_TRUE);
+    AVX_widen8to32(wb,b,LUX_TRUE);
+    AVX_widen8to32(wt,t,LUX_TRUE);
+    for (int i = 0; i < 4; i++){
+      wa[i] = AVX_lerpSmallEpi32(wa[i],wb[i],wt[i],max);
+    }
+    return AVX_narrow32to8wrap(wa);
+  }
+  static LUX_INLINE V lerpInv(V a, V b, V t)  { return lerp(a,b,_mm256_sub_epi8(_mm256_set1_epi8(127),t)); }
+  static LUX_INLINE V madd(V a, V b, V c)     { return _mm256_add_epi8(a,AVX_mullo8(b,c)); }
+  static LUX_INLINE V maddSat(V a, V b, V c)
+  {
+    __m256i wa[2];
+    __m256i wb[2];
+    __m256i wc[2];
+    AVX_widen8to16(wa,a,LUX_TRUE);
+    AVX_widen8to16(wb,b,LUX_TRUE);
+    AVX_widen8to16(wc,c,LUX_TRUE);
+    wa[0] = _mm256_add_epi16(wa[0],_mm256_mullo_epi16(wb[0],wc[0]));
+    wa[1] = _mm256_add_epi16(wa[1],_mm256_mullo_epi16(wb[1],wc[1]));
+    return satMin(AVX_narrow16to8sat(wa,LUX_TRUE));
+  }
+};
+
+class AVXUint8 : public AVXInteger<uint8>{
+public:
+  static LUX_INLINE V set1(T val)       { return _mm256_set1_epi8((char)val); }
+
+  static LUX_INLINE V add(V a, V b)     { return _mm256_add_epi8(a,b); }
+  static LUX_INLINE V sub(V a, V b)     { return _mm256_sub_epi8(a,b); }
+  static LUX_INLINE V mul(V a, V b)     { return AVX_mullo8(a,b); }
+  static LUX_INLINE V div(V a, V b)
+  {
+    __m256i wa[4];
+    __m256i wb[4];
+    AVX_widen8to32(wa,a,LUX_FALSE);
+    AVX_widen8to32(wb,b,LUX_FALSE);
+    for (int i = 0; i < 4; i++){
+      wa[i] = AVX_divSmallEpi32(wa[i],wb[i]);
+    }
+    return AVX_narrow32to8wrap(wa);
+  }
+  static LUX_INLINE V min(V a, V b)     { return _mm256_min_epu8(a,b); }
+  static LUX_INLINE V max(V a, V b)     { return _mm256_max_epu8(a,b); }
+  static LUX_INLINE V addSat(V a, V b)  { return _mm256_adds_epu8(a,b); }
+  static LUX_INLINE V subSat(V a, V b)  { return _mm256_subs_epu8(a,b); }
+  static LUX_INLINE V mulSat(V a, V b)
+  {
+    __m256i wa[2];
+    __m256i wb[2];
+    __m256i max = _mm256_set1_epi16(255);
+    AVX_widen8to16(wa,a,LUX_FALSE);
+    AVX_widen8to16(wb,b,LUX_FALSE);
+    wa[0] = _mm256_min_epu16(_mm256_mullo_epi16(wa[0],wb[0]),max);
+    wa[1] = _mm256_min_epu16(_mm256_mullo_epi16(wa[1],wb[1]),max);
+    return AVX_narrow16to8sat(wa,LUX_FALSE);
+  }
+  static LUX_INLINE V divSat(V a, V b)
+  {
+    __m256i wa[4];
+    __m256i wb[4];
+    AVX_widen8to32(wa,a,LUX_FALSE);
+    AVX_widen8to32(wb,b,LUX_FALSE);
+    for (int i = 0; i < 4; i++){
+      wa[i] = AVX_divSmallEpi32(wa[i],wb[i]);
+    }
+    return AVX_narrow32to8sat(wa,LUX_FALSE);
+  }
+
+  static LUX_INLINE V lerp(V a, V b, V t)
+  {
+    __m256 max = _mm256_set1_ps(255.0f);
+    __m256i wa[4];
+    __m256i wb[4];
+    __m256i wt[4];
+    AVX_widen8to32(wa,a,LUX_FALSE);
+    AVX_widen8to32(wb,b,LUX_FALSE);
+    AVX_widen8to32(wt,t,LUX_FALSE);
+    for (int i = 0; i < 4; i++){
+      wa[i] = AVX_lerpSmallEpi32(wa[i],wb[i],wt[i],max);
+    }
+    return AVX_narrow32to8wrap(wa);
+  }
+  static LUX_INLINE V lerpInv(V a, V b, V t)  { return lerp(a,b,_mm256_sub_epi8(_mm256_set1_epi8(-1),t)); }
+  static LUX_INLINE V madd(V a, V b, V c)     { return _mm256_add_epi8(a,AVX_mullo8(b,c)); }
+  static LUX_INLINE V maddSat(V a, V b, V c)
+  {
+    __m256i wa[2];
+    __m256i wb[2];
+    __m256i wc[2];
+    __m256i max = _mm256_set1_epi16(255);
+    AVX_widen8to16(wa,a,LUX_FALSE);
+    AVX_widen8to16(wb,b,LUX_FALSE);
+    AVX_widen8to16(wc,c,LUX_FALSE);
+    wa[0] = _mm256_min_epu16(_mm256_adds_epu16(wa[0],_mm256_mullo_epi16(wb[0],wc[0])),max);
+    wa[1] = _mm256_min_epu16(_mm256_adds_epu16(wa[1],_mm256_mullo_epi16(wb[1],wc[1])),max);
+    return AVX_narrow16to8sat(wa,LUX_FALSE);
+  }
+};
+
+class AVXInt16 : public AVXInteger<int16>{
+public:
+  static LUX_INLINE V set1(T val)       { return _mm256_set1_epi16(val); }
+  static LUX_INLINE V satMin(V v)       { return _mm256_max_epi16(v,_mm256_set1_epi16(-LUX_SHORT_SIGNEDMAX)); }
+
+  static LUX_INLINE V add(V a, V b)     { return _mm256_add_epi16(a,b); }
+  static LUX_INLINE V sub(V a, V b)     { return _mm256_sub_epi16(a,b); }
+  static LUX_INLINE V mul(V a, V b)     { return _mm256_mullo_epi16(a,b); }
+  static LUX_INLINE V div(V a, V b)
+  {
+    __m256i wa[2];
+    __m256i wb[2];
+    AVX_widen16to32(wa,a,LUX_TRUE);
+    AVX_widen16to32(wb,b,LUX_TRUE);
+    wa[0] = AVX_divEpi32(wa[0],wb[0]);
+    wa[1] = AVX_divEpi32(wa[1],wb[1]);
+    return AVX_narrow32to16wrap(wa);
+  }
+  static LUX_INLINE V min(V a, V b)     { return _mm256_min_epi16(a,b); }
+  static LUX_INLINE V max(V a, V b)     { return _mm256_max_epi16(a,b); }
+  static LUX_INLINE V addSat(V a, V b)  { return satMin(_mm256_adds_epi16(a,b)); }
+  static LUX_INLINE V subSat(V a, V b)  { return satMin(_mm256_subs_epi16(a,b)); }
+  static LUX_INLINE V mulSat(V a, V b)
+  {
+    __m256i lo = _mm256_mullo_epi16(a,b);
+    __m256i hi = _mm256_mulhi_epi16(a,b);
+    return satMin(_mm256_packs_epi32(_mm256_unpacklo_epi16(lo,hi),_mm256_unpackhi_epi16(lo,hi)));
+  }
+  static LUX_INLINE V divSat(V a, V b)
+  {
+    __m256i wa[2];
+    __m256i wb[2];
+    AVX_widen16to32(wa,a,LUX_TRUE);
+    AVX_widen16to32(wb,b,LUX_TRUE);
+    wa[0] = AVX_divEpi32(wa[0],wb[0]);
+    wa[1] = AVX_divEpi32(wa[1],wb[1]);
+    return satMin(AVX_narrow32to16sat(wa,LUX_TRUE));
+  }
+
+  static LUX_INLINE V lerp(V a, V b, V t)
+  {
+    __m256d max = _mm256_set1_pd(LUX_SHORT_SIGNEDMAX);
+    __m256i wa[2];
+    __m256i wb[2];
+    __m256i wt[2];
+    AVX_widen16to32(wa,a,LUX_TRUE);
+    AVX_widen16to32(wb,b,LUX_TRUE);
+    AVX_widen16to32(wt,t,LUX_TRUE);
+    wa[0] = AVX_lerpWideEpi32(wa[0],wb[0],wt[0],max);
+    wa[1] = AVX_lerpWideEpi32(wa[1],wb[1],wt[1],max);
+    return AVX_narrow32to16wrap(wa);
+  }
+  static LUX_INLINE V lerpInv(V a, V b, V t)  { return lerp(a,b,_mm256_sub_epi16(_mm256_set1_epi16(LUX_SHORT_SIGNEDMAX),t)); }
+  static LUX_INLINE V madd(V a, V b, V c)     { return _mm256_add_epi16(a,_mm256_mullo_epi16(b,c)); }
+  static LUX_INLINE V maddSat(V a, V b, V c)
+  {
+    __m256i wa[2];
+    __m256i wb[2];
+    __m256i wc[2];
+    AVX_widen16to32(wa,a,LUX_TRUE);
+    AVX_widen16to32(wb,b,LUX_TRUE);
+    AVX_widen16to32(wc,c,LUX_TRUE);
+    wa[0] = _mm256_add_epi32(wa[0],_mm256_mullo_epi32(wb[0],wc[0]));
+    wa[1] = _mm256_add_epi32(wa[1],_mm256_mullo_epi32(wb[1],wc[1]));
+    return satMin(AVX_narrow32to16sat(wa,LUX_TRUE));
+  }
+};
+
+class AVXUint16 : public AVXInteger<uint16>{
+public:
+  static LUX_INLINE V set1(T val)       { return _mm256_set1_epi16((short)val); }
+
+  static LUX_INLINE V add(V a, V b)     { return _mm256_add_epi16(a,b); }
+  static LUX_INLINE V sub(V a, V b)     { return _mm256_sub_epi16(a,b); }
+  static LUX_INLINE V mul(V a, V b)     { return _mm256_mullo_epi16(a,b); }
+  static LUX_INLINE V div(V a, V b)
+  {
+    __m256i wa[2];
+    __m256i wb[2];
+    AVX_widen16to32(wa,a,LUX_FALSE);
+    AVX_widen16to32(wb,b,LUX_FALSE);
+    wa[0] = AVX_divEpi32(wa[0],wb[0]);
+    wa[1] = AVX_divEpi32(wa[1],wb[1]);
+    return AVX_narrow32to16wrap(wa);
+  }
+  static LUX_INLINE V min(V a, V b)     { return _mm256_min_epu16(a,b); }
+  static LUX_INLINE V max(V a, V b)     { return _mm256_max_epu16(a,b); }
+  static LUX_INLINE V addSat(V a, V b)  { return _mm256_adds_epu16(a,b); }
+  static LUX_INLINE V subSat(V a, V b)  { return _mm256_subs_epu16(a,b); }
+  static LUX_INLINE V mulSat(V a, V b)  { return AVX_mulSatU16(a,b); }
+  static LUX_INLINE V divSat(V a, V b)
+  {
+    __m256i wa[2];
+    __m256i wb[2];
+    AVX_widen16to32(wa,a,LUX_FALSE);
+    AVX_widen16to32(wb,b,LUX_FALSE);
+    wa[0] = AVX_divEpi32(wa[0],wb[0]);
+    wa[1] = AVX_divEpi32(wa[1],wb[1]);
+    return AVX_narrow32to16sat(wa,LUX_FALSE);
+  }
+
+  static LUX_INLINE V lerp(V a, V b, V t)
+  {
+    __m256d max = _mm256_set1_pd(LUX_SHORT_UNSIGNEDMAX);
+    __m256i wa[2];
+    __m256i wb[2];
+    __m256i wt[2];
+    AVX_widen16to32(wa,a,LUX_FALSE);
+    AVX_widen16to32(wb,b,LUX_FALSE);
+    AVX_widen16to32(wt,t,LUX_FALSE);
+    wa[0] = AVX_lerpWideEpi32(wa[0],wb[0],wt[0],max);
+    wa[1] = AVX_lerpWideEpi32(wa[1],wb[1],wt[1],max);
+    return AVX_narrow32to16wrap(wa);
+  }
+  static LUX_INLINE V lerpInv(V a, V b, V t)  { return lerp(a,b,_mm256_sub_epi16(_mm256_set1_epi16(-1),t)); }
+  static LUX_INLINE V madd(V a, V b, V c)     { return _mm256_add_epi16(a,_mm256_mullo_epi16(b,c)); }
+  static LUX_INLINE V maddSat(V a, V b, V c)  { return _mm256_adds_epu16(a,AVX_mulSatU16(b,c)); }
+};
+
+class AVXInt32 : public AVXInteger<int32>{
+public:
+  static LUX_INLINE V set1(T val)       { return _mm256_set1_epi32(val); }
+  static LUX_INLINE V sat(V v)          { return AVX_clampEpi32(v,-LUX_SHORT_SIGNEDMAX,LUX_SHORT_SIGNEDMAX); }
+
+  static LUX_INLINE V add(V a, V b)     { return _mm256_add_epi32(a,b); }
+  static LUX_INLINE V sub(V a, V b)     { return _mm256_sub_epi32(a,b); }
+  static LUX_INLINE V mul(V a, V b)     { return _mm256_mullo_epi32(a,b); }
+  static LUX_INLINE V div(V a, V b)     { return AVX_divEpi32(a,b); }
+  static LUX_INLINE V min(V a, V b)     { return _mm256_min_epi32(a,b); }
+  static LUX_INLINE V max(V a, V b)     { return _mm256_max_epi32(a,b); }
+  static LUX_INLINE V addSat(V a, V b)  { return sat(_mm256_add_epi32(a,b)); }
+  static LUX_INLINE V subSat(V a, V b)  { return sat(_mm256_sub_epi32(a,b)); }
+  static LUX_INLINE V mulSat(V a, V b)  { return sat(_mm256_mullo_epi32(a,b)); }
+  static LUX_INLINE V divSat(V a, V b)  { return sat(AVX_divEpi32(a,b)); }
+
+  static LUX_INLINE V lerp(V a, V b, V t)
+  {
+    __m256i prod = _mm256_mullo_epi32(_mm256_sub_epi32(b,a),t);
+    return _mm256_add_epi32(a,AVX_divEpi32(prod,_mm256_set1_epi32(LUX_SHORT_SIGNEDMAX)));
+  }
+  static LUX_INLINE V lerpInv(V a, V b, V t)  { return lerp(a,b,_mm256_sub_epi32(_mm256_set1_epi32(LUX_SHORT_SIGNEDMAX),t)); }
+  static LUX_INLINE V madd(V a, V b, V c)     { return _mm256_add_epi32(a,_mm256_mullo_epi32(b,c)); }
+  static LUX_INLINE V maddSat(V a, V b, V c)  { return sat(madd(a,b,c)); }
+};
+
+class AVXUint32 : public AVXInteger<uint32>{
+public:
+  static LUX_INLINE V set1(T val)       { return _mm256_set1_epi32((int)val); }
+  // original code clamps in signed int32
+  static LUX_INLINE V sat(V v)          { return AVX_clampEpi32(v,0,LUX_SHORT_UNSIGNEDMAX); }
+
+  static LUX_INLINE V add(V a, V b)     { return _mm256_add_epi32(a,b); }
+  static LUX_INLINE V sub(V a, V b)     { return _mm256_sub_epi32(a,b); }
+  static LUX_INLINE V mul(V a, V b)     { return _mm256_mullo_epi32(a,b); }
+  static LUX_INLINE V div(V a, V b)     { return AVX_divEpu32(a,b); }
+  static LUX_INLINE V min(V a, V b)     { return _mm256_min_epu32(a,b); }
+  static LUX_INLINE V max(V a, V b)     { return _mm256_max_epu32(a,b); }
+  static LUX_INLINE V addSat(V a, V b)  { return sat(_mm256_add_epi32(a,b)); }
+  static LUX_INLINE V subSat(V a, V b)  { return sat(_mm256_sub_epi32(a,b)); }
+  static LUX_INLINE V mulSat(V a, V b)  { return sat(_mm256_mullo_epi32(a,b)); }
+  static LUX_INLINE V divSat(V a, V b)  { return sat(AVX_divEpu32(a,b)); }
+
+  static LUX_INLINE V lerp(V a, V b, V t)
+  {
+    __m256i prod = _mm256_mullo_epi32(_mm256_sub_epi32(b,a),t);
+    return _mm256_add_epi32(a,AVX_divEpu32(prod,_mm256_set1_epi32(LUX_SHORT_UNSIGNEDMAX)));
+  }
+  static LUX_INLINE V lerpInv(V a, V b, V t)  { return lerp(a,b,_mm256_sub_epi32(_mm256_set1_epi32(LUX_SHORT_UNSIGNEDMAX),t)); }
+  static LUX_INLINE V madd(V a, V b, V c)     { return _mm256_add_epi32(a,_mm256_mullo_epi32(b,c)); }
+  static LUX_INLINE V maddSat(V a, V b, V c)  { return sat(madd(a,b,c)); }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Loops
+
+#define AVX_FUNC2(name,fn)  \
+  template <class TOps> \
+  class name{ \
+  public: \
+    static LUX_INLINE typename TOps::V run(typename TOps::V a, typename TOps::V b){ \
+      return TOps::fn(a,b); \
+    } \
+  };
+
+#define AVX_FUNC3(name,fn)  \
+  template <class TOps> \
+  class name{ \
+  public: \
+    static LUX_INLINE typename TOps::V run(typename TOps::V a, typename TOps::V b, typename TOps::V c){ \
+      return TOps::fn(a,b,c); \
+    } \
+  };
+
+AVX_FUNC2(AVXOpAdd,add)
+AVX_FUNC2(AVXOpSub,sub)
+AVX_FUNC2(AVXOpMul,mul)
+AVX_FUNC2(AVXOpDiv,div)
+AVX_FUNC2(AVXOpMin,min)
+AVX_FUNC2(AVXOpMax,max)
+AVX_FUNC2(AVXOpAddSat,addSat)
+AVX_FUNC2(AVXOpSubSat,subSat)
+AVX_FUNC2(AVXOpMulSat,mulSat)
+AVX_FUNC2(AVXOpDivSat,divSat)
+
+AVX_FUNC3(AVXOpLerp,lerp)
+AVX_FUNC3(AVXOpLerpInv,lerpInv)
+AVX_FUNC3(AVXOpMadd,madd)
+AVX_FUNC3(AVXOpMaddSat,maddSat)
+
+#undef AVX_FUNC2
+#undef AVX_FUNC3
+
+// remainder is run through a zeroed temporary vector
+
+template <class TOps, class TFunc>
+static void AVXScalarLoop2(size_t count, booln single, void* pOutV, const void* pArg0V, const void* pArg1V)
+{
+  typedef typename TOps::T T;
+  typedef typename TOps::V V;
+
+  T* pOut = (T*)pOutV;
+  const T* pArg0 = (const T*)pArg0V;
+  const T* pArg1 = (const T*)pArg1V;
+  size_t vecs = count / TOps::LANES;
+  size_t rest = count % TOps::LANES;
+  T tempOut[TOps::LANES];
+  T temp0[TOps::LANES];
+  T temp1[TOps::LANES];
+
+  if (single){
+    V arg1 = TOps::set1(pArg1[0]);
+    for (size_t i = 0; i < vecs; i++, pOut += TOps::LANES, pArg0 += TOps::LANES){
+      TOps::store(pOut,TFunc::run(TOps::load(pArg0),arg1));
+    }
+    for (size_t i = 0; i < TOps::LANES; i++){
+      temp1[i] = pArg1[0];
+    }
+  }
+  else{
+    for (size_t i = 0; i < vecs; i++, pOut += TOps::LANES, pArg0 += TOps::LANES, pArg1 += TOps::LANES){
+      TOps::store(pOut,TFunc::run(TOps::load(pArg0),TOps::load(pArg1)));
+    }
+    memset(temp1,0,sizeof(temp1));
+    memcpy(temp1,pArg1,sizeof(T) * rest);
+  }
+
+  if (rest){
+    memset(temp0,0,sizeof(temp0));
+    memcpy(temp0,pArg0,sizeof(T) * rest);
+    TOps::store(tempOut,TFunc::run(TOps::load(temp0),TOps::load(temp1)));
+    memcpy(pOut,tempOut,sizeof(T) * rest);
+  }
+}
+
+template <class TOps, class TFunc>
+static void AVXScalarLoop3(size_t count, booln single, void* pOutV, const void* pArg0V, const void* pArg1V, const void* pArg2V)
+{
+  typedef typename TOps::T T;
+  typedef typename TOps::V V;
+
+  T* pOut = (T*)pOutV;
+  const T* pArg0 = (const T*)pArg0V;
+  const T* pArg1 = (const T*)pArg1V;
+  const T* pArg2 = (const T*)pArg2V;
+  size_t vecs = count / TOps::LANES;
+  size_t rest = count % TOps::LANES;
+  T tempOut[TOps::LANES];
+  T temp0[TOps::LANES];
+  T temp1[TOps::LANES];
+  T temp2[TOps::LANES];
+
+  if (single){
+    V arg2 = TOps::set1(pArg2[0]);
+    for (size_t i = 0; i < vecs; i++, pOut += TOps::LANES, pArg0 += TOps::LANES, pArg1 += TOps::LANES){
+      TOps::store(pOut,TFunc::run(TOps::load(pArg0),TOps::load(pArg1),arg2));
+    }
+    for (size_t i = 0; i < TOps::LANES; i++){
+      temp2[i] = pArg2[0];
+    }
+  }
+  else{
+    for (size_t i = 0; i < vecs; i++, pOut += TOps::LANES, pArg0 += TOps::LANES, pArg1 += TOps::LANES, pArg2 += TOps::LANES){
+      TOps::store(pOut,TFunc::run(TOps::load(pArg0),TOps::load(pArg1),TOps::load(pArg2)));
+    }
+    memset(temp2,0,sizeof(temp2));
+    memcpy(temp2,pArg2,sizeof(T) * rest);
+  }
+
+  if (rest){
+    memset(temp0,0,sizeof(temp0));
+    memset(temp1,0,sizeof(temp1));
+    memcpy(temp0,pArg0,sizeof(T) * rest);
+    memcpy(temp1,pArg1,sizeof(T) * rest);
+    TOps::store(tempOut,TFunc::run(TOps::load(temp0),TOps::load(temp1),TOps::load(temp2)));
+    memcpy(pOut,tempOut,sizeof(T) * rest);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Dispatch
+
+typedef void (AVXScalarLoop2_fn)(size_t count, booln single, void* pOut, const void* pArg0, const void* pArg1);
+typedef void (AVXScalarLoop3_fn)(size_t count, booln single, void* pOut, const void* pArg0, const void* pArg1, const void* pArg2);
+
+#define AVX_OP2TABLE(TOps) \
+  { \
+    AVXScalarLoop2<TOps,AVXOpAdd<TOps> >, \
+    AVXScalarLoop2<TOps,AVXOpSub<TOps> >, \
+    AVXScalarLoop2<TOps,AVXOpMul<TOps> >, \
+    AVXScalarLoop2<TOps,AVXOpDiv<TOps> >, \
+    AVXScalarLoop2<TOps,AVXOpMin<TOps> >, \
+    AVXScalarLoop2<TOps,AVXOpMax<TOps> >, \
+    AVXScalarLoop2<TOps,AVXOpAddSat<TOps> >, \
+    AVXScalarLoop2<TOps,AVXOpSubSat<TOps> >, \
+    AVXScalarLoop2<TOps,AVXOpMulSat<TOps> >, \
+    AVXScalarLoop2<TOps,AVXOpDivSat<TOps> >, \
+  }
+
+#define AVX_OP3TABLE(TOps) \
+  { \
+    AVXScalarLoop3<TOps,AVXOpLerp<TOps> >, \
+    AVXScalarLoop3<TOps,AVXOpLerpInv<TOps> >, \
+    AVXScalarLoop3<TOps,AVXOpMadd<TOps> >, \
+    AVXScalarLoop3<TOps,AVXOpMaddSat<TOps> >, \
+  }
+
+#define AVX_OP2S  (LUX_SCALAR_OP2_DIV_SAT - LUX_SCALAR_OP2_ADD + 1)
+#define AVX_OP3S  (LUX_SCALAR_OP3_MADD_SAT - LUX_SCALAR_OP3_LERP + 1)
+
+static AVXScalarLoop2_fn* l_AVXOp2[LUX_SCALAROPS_MAX_SUPPORTED][AVX_OP2S] = {
+  AVX_OP2TABLE(AVXFloat),
+  AVX_OP2TABLE(AVXInt8),
+  AVX_OP2TABLE(AVXUint8),
+  AVX_OP2TABLE(AVXInt16),
+  AVX_OP2TABLE(AVXUint16),
+  AVX_OP2TABLE(AVXInt32),
+  AVX_OP2TABLE(AVXUint32),
+};
+
+static AVXScalarLoop3_fn* l_AVXOp3[LUX_SCALAROPS_MAX_SUPPORTED][AVX_OP3S] = {
+  AVX_OP3TABLE(AVXFloat),
+  AVX_OP3TABLE(AVXInt8),
+  AVX_OP3TABLE(AVXUint8),
+  AVX_OP3TABLE(AVXInt16),
+  AVX_OP3TABLE(AVXUint16),
+  AVX_OP3TABLE(AVXInt32),
+  AVX_OP3TABLE(AVXUint32),
+};
+
+booln AVXScalarArrayOp_in2(lxScalarArrayOp_t op, lxScalarType_t type, size_t count, booln single,
+  void* pOut, const void* pArg0, const void* pArg1)
+{
+  if (op < LUX_SCALAR_OP2_ADD || op > LUX_SCALAR_OP2_DIV_SAT || type >= LUX_SCALAROPS_MAX_SUPPORTED)
+    return LUX_TRUE;
+
+  l_AVXOp2[type][op - LUX_SCALAR_OP2_ADD](count,single,pOut,pArg0,pArg1);
+  // avoid sse/avx transition penalty in following code
+  _mm256_zeroupper();
+  return LUX_FALSE;
+}
+
+booln AVXScalarArrayOp_in3(lxScalarArrayOp_t op, lxScalarType_t type, size_t count, booln single,
+  void* pOut, const void* pArg0, const void* pArg1, const void* pArg2)
+{
+  if (op < LUX_SCALAR_OP3_LERP || op > LUX_SCALAR_OP3_MADD_SAT || type >= LUX_SCALAROPS_MAX_SUPPORTED)
+    return LUX_TRUE;
+
+  l_AVXOp3[type][op - LUX_SCALAR_OP3_LERP](count,single,pOut,pArg0,pArg1,pArg2);
+  _mm256_zeroupper();
+  return LUX_FALSE;
+}
+
+#undef AVX_OP2TABLE
+#undef AVX_OP3TABLE
+#undef AVX_OP2S
+#undef AVX_OP3S
+
+#endif
@@ -0,0 +1,656 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxmath/basetypes.h>
+#include <math.h>
+#include <memory.h>
+#include "contscalararray_defs.h"
+
+//////////////////////////////////////////////////////////////////////////
+// Reductions & Scans
+//
+// Arrays are cut into chunks of about SCALAR_REDUCE_CHUNK_BYTES, every
+// chunk produces its own partial result, which are combined in chunk
+// order. Serial and threaded execution use the same chunks, so results
+// are identical with or without job pool.
+//
+// Compact arrays are processed as flat runs of SCALAR_REDUCE_LANES
+// scalars. The lane count is a multiple of every vectordim, so lane j
+// always holds component j % vectordim.
+
+#define SCALAR_REDUCE_CHUNK_BYTES (1024*64)
+#define SCALAR_REDUCE_MAXCHUNKS   128
+#define SCALAR_REDUCE_LANES       12
+
+  // accumulator for sums and dot products
+template <class T> struct TScalarSum    { typedef int64 type; };
+template <> struct TScalarSum<uint32>   { typedef uint64 type; };
+template <> struct TScalarSum<float>    { typedef float type; };
+
+template <class T>
+static LUX_INLINE const T* TScalarArray_ptr(const lxScalarArray_t &sarr, uint start)
+{
+  return (const T*)sarr.data.tvoid + (size_t)start * sarr.stride;
+}
+
+static LUX_INLINE booln ScalarArray_isFlat(const lxScalarArray_t &sarr)
+{
+  return sarr.stride == sarr.vectordim;
+}
+
+static LUX_INLINE booln ScalarArray_isReducible(const lxScalarArray_t &sarr)
+{
+  return sarr.type < LUX_SCALAROPS_MAX_SUPPORTED && sarr.count &&
+    sarr.vectordim >= 1 && sarr.vectordim <= 4;
+}
+
+  // vectors per chunk, at most SCALAR_REDUCE_MAXCHUNKS chunks
+static uint ScalarArray_reduceChunk(const lxScalarArray_t &sarr, uint total)
+{
+  size_t bytes = lx_gScalarTypeSizes[sarr.type] * sarr.vectordim;
+  uint chunk = (uint)(SCALAR_REDUCE_CHUNK_BYTES / bytes);
+  uint minchunk = (total + SCALAR_REDUCE_MAXCHUNKS - 1) / SCALAR_REDUCE_MAXCHUNKS;
+
+  return LUX_MAX(LUX_MAX(chunk,minchunk),1);
+}
+
+static void ScalarArray_reduceRun(lxJobPoolFunc_fn *func, void *job, const lxScalarArray_t &sarr, uint total, uint chunk)
+{
+  uint numChunks = (total + chunk - 1) / chunk;
+
+  if (ScalarArray_useJobs((size_t)total * sarr.vectordim)){
+    ScalarArray_dispatch(lxScalarArray_getJobPool(), numChunks, func, job);
+  }
+  else{
+    for (uint i = 0; i < numChunks; i++){
+      func(job,i,0);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Lanes
+
+template <class T, class Tacc>
+static LUX_INLINE void TScalarLanes_sum(Tacc* LUX_RESTRICT acc, const T* LUX_RESTRICT pIn, size_t blocks)
+{
+  for (size_t b = 0; b < blocks; b++, pIn += SCALAR_REDUCE_LANES){
+    for (uint j = 0; j < SCALAR_REDUCE_LANES; j++){
+      acc[j] += pIn[j];
+    }
+  }
+}
+
+template <class T, class Tacc>
+static LUX_INLINE void TScalarLanes_dot(Tacc* LUX_RESTRICT acc, const T* LUX_RESTRICT pIn0, const T* LUX_RESTRICT pIn1, size_t blocks)
+{
+  for (size_t b = 0; b < blocks; b++, pIn0 += SCALAR_REDUCE_LANES, pIn1 += SCALAR_REDUCE_LANES){
+    for (uint j = 0; j < SCALAR_REDUCE_LANES; j++){
+      acc[j] += (Tacc)pIn0[j] * (Tacc)pIn1[j];
+    }
+  }
+}
+
+template <class T>
+static LUX_INLINE void TScalarLanes_minMax(T* LUX_RESTRICT accmin, T* LUX_RESTRICT accmax, const T* LUX_RESTRICT pIn, size_t blocks)
+{
+  for (size_t b = 0; b < blocks; b++, pIn += SCALAR_REDUCE_LANES){
+    for (uint j = 0; j < SCALAR_REDUCE_LANES; j++){
+      accmin[j] = LUX_MIN(accmin[j],pIn[j]);
+      accmax[j] = LUX_MAX(accmax[j],pIn[j]);
+    }
+  }
+}
+
+#ifdef LUX_SIMD_SSE
+static LUX_INLINE void TScalarLanes_sum(float* LUX_RESTRICT acc, const float* LUX_RESTRICT pIn, size_t blocks)
+{
+  __m128 a0 = _mm_loadu_ps(acc);
+  __m128 a1 = _mm_loadu_ps(acc+4);
+  __m128 a2 = _mm_loadu_ps(acc+8);
+
+  for (size_t b = 0; b < blocks; b++, pIn += SCALAR_REDUCE_LANES){
+    a0 = _mm_add_ps(a0,_mm_loadu_ps(pIn));
+    a1 = _mm_add_ps(a1,_mm_loadu_ps(pIn+4));
+    a2 = _mm_add_ps(a2,_mm_loadu_ps(pIn+8));
+  }
+
+  _mm_storeu_ps(acc,a0);
+  _mm_storeu_ps(acc+4,a1);
+  _mm_storeu_ps(acc+8,a2);
+}
+
+static LUX_INLINE void TScalarLanes_dot(float* LUX_RESTRICT acc, const float* LUX_RESTRICT pIn0, const float* LUX_RESTRICT pIn1, size_t blocks)
+{
+  __m128 a0 = _mm_loadu_ps(acc);
+  __m128 a1 = _mm_loadu_ps(acc+4);
+  __m128 a2 = _mm_loadu_ps(acc+8);
+
+  for (size_t b = 0; b < blocks; b++, pIn0 += SCALAR_REDUCE_LANES, pIn1 += SCALAR_REDUCE_LANES){
+    a0 = _mm_add_ps(a0,_mm_mul_ps(_mm_loadu_ps(pIn0),  _mm_loadu_ps(pIn1)));
+    a1 = _mm_add_ps(a1,_mm_mul_ps(_mm_loadu_ps(pIn0+4),_mm_loadu_ps(pIn1+4)));
+    a2 = _mm_add_ps(a2,_mm_mul_ps(_mm_loadu_ps(pIn0+8),_mm_loadu_ps(pIn1+8)));
+  }
+
+  _mm_storeu_ps(acc,a0);
+  _mm_storeu_ps(acc+4,a1);
+  _mm_storeu_ps(acc+8,a2);
+}
+
+static LUX_INLINE void TScalarLanes_minMax(float* LUX_RESTRICT accmin, float* LUX_RESTRICT accmax, const float* LUX_RESTRICT pIn, size_t blocks)
+{
+  __m128 min0 = _mm_loadu_ps(accmin);
+  __m128 min1 = _mm_loadu_ps(accmin+4);
+  __m128 min2 = _mm_loadu_ps(accmin+8);
+  __m128 max0 = _mm_loadu_ps(accmax);
+  __m128 max1 = _mm_loadu_ps(accmax+4);
+  __m128 max2 = _mm_loadu_ps(accmax+8);
+
+  for (size_t b = 0; b < blocks; b++, pIn += SCALAR_REDUCE_LANES){
+    __m128 v0 = _mm_loadu_ps(pIn);
+    __m128 v1 = _mm_loadu_ps(pIn+4);
+    __m128 v2 = _mm_loadu_ps(pIn+8);
+    min0 = _mm_min_ps(min0,v0);
+    min1 = _mm_min_ps(min1,v1);
+    min2 = _mm_min_ps(min2,v2);
+    max0 = _mm_max_ps(max0,v0);
+    max1 = _mm_max_ps(max1,v1);
+    max2 = _mm_max_ps(max2,v2);
+  }
+
+  _mm_storeu_ps(accmin,min0);
+  _mm_storeu_ps(accmin+4,min1);
+  _mm_storeu_ps(accmin+8,min2);
+  _mm_storeu_ps(accmax,max0);
+  _mm_storeu_ps(accmax+4,max1);
+  _mm_storeu_ps(accmax+8,max2);
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Chunk kernels
+
+  // adds sum of vectors [start,start+count) to out
+template <class T>
+static void TScalarArray_sumRange(typename TScalarSum<T>::type out[4], const lxScalarArray_t &sarr, uint start, uint count)
+{
+  typedef typename TScalarSum<T>::type Tacc;
+  const T* LUX_RESTRICT pIn = TScalarArray_ptr<T>(sarr,start);
+  uint vectordim = sarr.vectordim;
+  Tacc acc[SCALAR_REDUCE_LANES];
+
+  for (uint j = 0; j < SCALAR_REDUCE_LANES; j++){
+    acc[j] = 0;
+  }
+
+  if (ScalarArray_isFlat(sarr)){
+    size_t scalars = (size_t)count * vectordim;
+    size_t blocks = scalars / SCALAR_REDUCE_LANES;
+    TScalarLanes_sum(acc,pIn,blocks);
+    pIn += blocks * SCALAR_REDUCE_LANES;
+    for (size_t j = 0; j < scalars - blocks * SCALAR_REDUCE_LANES; j++){
+      acc[j] += pIn[j];
+    }
+  }
+  else{
+    for (uint i = 0; i < count; i++, pIn += sarr.stride){
+      for (uint c = 0; c < vectordim; c++){
+        acc[c] += pIn[c];
+      }
+    }
+  }
+
+  for (uint c = 0; c < vectordim; c++){
+    for (uint j = c; j < SCALAR_REDUCE_LANES; j += vectordim){
+      out[c] += acc[j];
+    }
+  }
+}
+
+  // adds dot product of vectors [start,start+count) to out
+template <class T>
+static void TScalarArray_dotRange(typename TScalarSum<T>::type *out, const lxScalarArray_t &sarr0, const lxScalarArray_t &sarr1, uint start, uint count)
+{
+  typedef typename TScalarSum<T>::type Tacc;
+  const T* LUX_RESTRICT pIn0 = TScalarArray_ptr<T>(sarr0,start);
+  const T* LUX_RESTRICT pIn1 = TScalarArray_ptr<T>(sarr1,start);
+  uint vectordim = sarr0.vectordim;
+  Tacc acc[SCALAR_REDUCE_LANES];
+
+  for (uint j = 0; j < SCALAR_REDUCE_LANES; j++){
+    acc[j] = 0;
+  }
+
+  if (ScalarArray_isFlat(sarr0) && ScalarArray_isFlat(sarr1)){
+    size_t scalars = (size_t)count * vectordim;
+    size_t blocks = scalars / SCALAR_REDUCE_LANES;
+    TScalarLanes_dot(acc,pIn0,pIn1,blocks);
+    pIn0 += blocks * SCALAR_REDUCE_LANES;
+    pIn1 += blocks * SCALAR_REDUCE_LANES;
+    for (size_t j = 0; j < scalars - blocks * SCALAR_REDUCE_LANES; j++){
+      acc[j] += (Tacc)pIn0[j] * (Tacc)pIn1[j];
+    }
+  }
+  else{
+    for (uint i = 0; i < count; i++, pIn0 += sarr0.stride, pIn1 += sarr1.stride){
+      for (uint c = 0; c < vectordim; c++){
+        acc[c] += (Tacc)pIn0[c] * (Tacc)pIn1[c];
+      }
+    }
+  }
+
+  for (uint j = 0; j < SCALAR_REDUCE_LANES; j++){
+    *out += acc[j];
+  }
+}
+
+  // min/max of vectors [start,start+count)
+template <class T>
+static void TScalarArray_minMaxRange(T outmin[4], T outmax[4], const lxScalarArray_t &sarr, uint start, uint count)
+{
+  const T* LUX_RESTRICT pIn = TScalarArray_ptr<T>(sarr,start);
+  uint vectordim = sarr.vectordim;
+  T accmin[SCALAR_REDUCE_LANES];
+  T accmax[SCALAR_REDUCE_LANES];
+
+  for (uint j = 0; j < SCALAR_REDUCE_LANES; j++){
+    accmin[j] = accmax[j] = pIn[j % vectordim];
+  }
+
+  if (ScalarArray_isFlat(sarr)){
+    size_t scalars = (size_t)count * vectordim;
+    size_t blocks = scalars / SCALAR_REDUCE_LANES;
+    TScalarLanes_minMax(accmin,accmax,pIn,blocks);
+    pIn += blocks * SCALAR_REDUCE_LANES;
+    for (size_t j = 0; j < scalars - blocks * SCALAR_REDUCE_LANES; j++){
+      accmin[j] = LUX_MIN(accmin[j],pIn[j]);
+      accmax[j] = LUX_MAX(accmax[j],pIn[j]);
+    }
+  }
+  else{
+    for (uint i = 0; i < count; i++, pIn += sarr.stride){
+      for (uint c = 0; c < vectordim; c++){
+        accmin[c] = LUX_MIN(accmin[c],pIn[c]);
+        accmax[c] = LUX_MAX(accmax[c],pIn[c]);
+      }
+    }
+  }
+
+  for (uint c = 0; c < vectordim; c++){
+    T vmin = accmin[c];
+    T vmax = accmax[c];
+    for (uint j = c + vectordim; j < SCALAR_REDUCE_LANES; j += vectordim){
+      vmin = LUX_MIN(vmin,accmin[j]);
+      vmax = LUX_MAX(vmax,accmax[j]);
+    }
+    outmin[c] = vmin;
+    outmax[c] = vmax;
+  }
+}
+
+  // scan of vectors [start,start+count), beginning with offset
+template <class T, int VECSIZE>
+static void TScalarArray_scanRange(lxScalarArray_t &sOut, const lxScalarArray_t &sIn, uint start, uint count,
+                   const T offset[4], booln exclusive)
+{
+  T* LUX_RESTRICT   pOut = (T*)TScalarArray_ptr<T>(sOut,start);
+  const T* LUX_RESTRICT pIn = TScalarArray_ptr<T>(sIn,start);
+  uint ostride = sOut.stride;
+  uint istride = sIn.stride;
+  T run[VECSIZE];
+
+  for (uint c = 0; c < VECSIZE; c++){
+    run[c] = offset[c];
+  }
+
+  if (exclusive){
+    for (uint i = 0; i < count; i++, pOut += ostride, pIn += istride){
+      for (uint c = 0; c < VECSIZE; c++){
+        T val = pIn[c];
+        pOut[c] = run[c];
+        run[c] = (T)(run[c] + val);
+      }
+    }
+  }
+  else{
+    for (uint i = 0; i < count; i++, pOut += ostride, pIn += istride){
+      for (uint c = 0; c < VECSIZE; c++){
+        run[c] = (T)(run[c] + pIn[c]);
+        pOut[c] = run[c];
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Drivers
+
+template <class T>
+struct TScalarReduceJob{
+  typedef typename TScalarSum<T>::type Tacc;
+
+  const lxScalarArray_t*  sarr0;
+  const lxScalarArray_t*  sarr1;
+  lxScalarArray_t*    sOut;
+  uint          total;
+  uint          chunk;
+  booln         exclusive;
+
+  union{
+    Tacc        sums[SCALAR_REDUCE_MAXCHUNKS][4];
+    T         offsets[SCALAR_REDUCE_MAXCHUNKS][4];
+    struct{
+      T       vmin[SCALAR_REDUCE_MAXCHUNKS][4];
+      T       vmax[SCALAR_REDUCE_MAXCHUNKS][4];
+    };
+  };
+
+  LUX_INLINE uint chunkCount(uint jobindex){
+    return LUX_MIN(chunk, total - jobindex * chunk);
+  }
+};
+
+template <class T>
+static void TScalarArray_sumJob(void* userdata, uint jobindex, uint threadindex)
+{
+  TScalarReduceJob<T>* job = (TScalarReduceJob<T>*)userdata;
+  typename TScalarReduceJob<T>::Tacc* sums = job->sums[jobindex];
+
+  sums[0] = sums[1] = sums[2] = sums[3] = 0;
+  TScalarArray_sumRange<T>(sums,*job->sarr0,jobindex * job->chunk,job->chunkCount(jobindex));
+}
+
+template <class T>
+static void TScalarArray_dotJob(void* userdata, uint jobindex, uint threadindex)
+{
+  TScalarReduceJob<T>* job = (TScalarReduceJob<T>*)userdata;
+  typename TScalarReduceJob<T>::Tacc* sums = job->sums[jobindex];
+
+  sums[0] = 0;
+  TScalarArray_dotRange<T>(sums,*job->sarr0,*job->sarr1,jobindex * job->chunk,job->chunkCount(jobindex));
+}
+
+template <class T>
+static void TScalarArray_minMaxJob(void* userdata, uint jobindex, uint threadindex)
+{
+  TScalarReduceJob<T>* job = (TScalarReduceJob<T>*)userdata;
+
+  TScalarArray_minMaxRange<T>(job->vmin[jobindex],job->vmax[jobindex],*job->sarr0,
+    jobindex * job->chunk,job->chunkCount(jobindex));
+}
+
+template <class T>
+static void TScalarArray_scanJob(void* userdata, uint jobindex, uint threadindex)
+{
+  TScalarReduceJob<T>* job = (TScalarReduceJob<T>*)userdata;
+  uint start = jobindex * job->chunk;
+  uint count = job->chunkCount(jobindex);
+
+  switch(job->sarr0->vectordim){
+  case 1: TScalarArray_scanRange<T,1>(*job->sOut,*job->sarr0,start,count,job->offsets[jobindex],job->exclusive); break;
+  case 2: TScalarArray_scanRange<T,2>(*job->sOut,*job->sarr0,start,count,job->offsets[jobindex],job->exclusive); break;
+  case 3: TScalarArray_scanRange<T,3>(*job->sOut,*job->sarr0,start,count,job->offsets[jobindex],job->exclusive); break;
+  case 4: TScalarArray_scanRange<T,4>(*job->sOut,*job->sarr0,start,count,job->offsets[jobindex],job->exclusive); break;
+  }
+}
+
+template <class T>
+static void TScalarArray_sum(double outsum[4], const lxScalarArray_t &sarr)
+{
+  TScalarReduceJob<T> job;
+  double sums[4] = {0,0,0,0};
+
+  job.sarr0 = &sarr;
+  job.total = sarr.count;
+  job.chunk = ScalarArray_reduceChunk(sarr,job.total);
+  ScalarArray_reduceRun(TScalarArray_sumJob<T>,&job,sarr,job.total,job.chunk);
+
+  for (uint i = 0; i < job.total; i += job.chunk){
+    for (uint c = 0; c < sarr.vectordim; c++){
+      sums[c] += (double)job.sums[i / job.chunk][c];
+    }
+  }
+  for (uint c = 0; c < sarr.vectordim; c++){
+    outsum[c] = sums[c];
+  }
+}
+
+template <class T>
+static double TScalarArray_dot(const lxScalarArray_t &sarr0, const lxScalarArray_t &sarr1)
+{
+  TScalarReduceJob<T> job;
+  double sum = 0;
+
+  job.sarr0 = &sarr0;
+  job.sarr1 = &sarr1;
+  job.total = LUX_MIN(sarr0.count,sarr1.count);
+  job.chunk = ScalarArray_reduceChunk(sarr0,job.total);
+  ScalarArray_reduceRun(TScalarArray_dotJob<T>,&job,sarr0,job.total,job.chunk);
+
+  for (uint i = 0; i < job.total; i += job.chunk){
+    sum += (double)job.sums[i / job.chunk][0];
+  }
+  return sum;
+}
+
+template <class T>
+static void TScalarArray_minMax(void *outmin, void *outmax, uint *outminidx, uint *outmaxidx, const lxScalarArray_t &sarr)
+{
+  TScalarReduceJob<T> job;
+  uint vectordim = sarr.vectordim;
+  T vmin[4];
+  T vmax[4];
+
+  job.sarr0 = &sarr;
+  job.total = sarr.count;
+  job.chunk = ScalarArray_reduceChunk(sarr,job.total);
+  ScalarArray_reduceRun(TScalarArray_minMaxJob<T>,&job,sarr,job.total,job.chunk);
+
+  for (uint c = 0; c < vectordim; c++){
+    vmin[c] = job.vmin[0][c];
+    vmax[c] = job.vmax[0][c];
+  }
+  for (uint i = job.chunk; i < job.total; i += job.chunk){
+    for (uint c = 0; c < vectordim; c++){
+      vmin[c] = LUX_MIN(vmin[c],job.vmin[i / job.chunk][c]);
+      vmax[c] = LUX_MAX(vmax[c],job.vmax[i / job.chunk][c]);
+    }
+  }
+
+  if (outmin) memcpy(outmin,vmin,sizeof(T)*vectordim);
+  if (outmax) memcpy(outmax,vmax,sizeof(T)*vectordim);
+
+  // find first occurrences, stops once all are found
+  if (outminidx || outmaxidx){
+    const T* LUX_RESTRICT pIn = (const T*)sarr.data.tvoid;
+    uint minidx[4] = {0,0,0,0};
+    uint maxidx[4] = {0,0,0,0};
+    uint found = 0;
+    uint allfound = ((1<<vectordim)-1) | (((1<<vectordim)-1) << 4);
+
+    for (uint i = 0; i < sarr.count && found != allfound; i++, pIn += sarr.stride){
+      for (uint c = 0; c < vectordim; c++){
+        if (!(found & (1<<c)) && pIn[c] == vmin[c]){
+          minidx[c] = i;
+          found |= 1<<c;
+        }
+        if (!(found & (1<<(c+4))) && pIn[c] == vmax[c]){
+          maxidx[c] = i;
+          found |= 1<<(c+4);
+        }
+      }
+    }
+
+    for (uint c = 0; c < vectordim; c++){
+      if (outminidx) outminidx[c] = minidx[c];
+      if (outmaxidx) outmaxidx[c] = maxidx[c];
+    }
+  }
+}
+
+template <class T>
+static void TScalarArray_scan(lxScalarArray_t &sOut, const lxScalarArray_t &sIn, booln exclusive)
+{
+  TScalarReduceJob<T> job;
+  uint vectordim = sIn.vectordim;
+  T offset[4] = {0,0,0,0};
+
+  job.sarr0 = &sIn;
+  job.sOut = &sOut;
+  job.exclusive = exclusive;
+  job.total = LUX_MIN(sOut.count,sIn.count);
+  job.chunk = ScalarArray_reduceChunk(sIn,job.total);
+
+  // pass 1: chunk sums, also without pool, so that float offsets
+  // are the same. A single chunk starts at 0.
+  if (job.chunk < job.total){
+    ScalarArray_reduceRun(TScalarArray_sumJob<T>,&job,sIn,job.total,job.chunk);
+
+    // sums to starting offsets, in place, sums of chunk i are
+    // read before offsets of chunk i are written
+    for (uint i = 0; i < job.total; i += job.chunk){
+      T* chunkoffset = job.offsets[i / job.chunk];
+      T chunksum[4];
+      for (uint c = 0; c < vectordim; c++){
+        chunksum[c] = (T)job.sums[i / job.chunk][c];
+      }
+      for (uint c = 0; c < vectordim; c++){
+        chunkoffset[c] = offset[c];
+        offset[c] = (T)(offset[c] + chunksum[c]);
+      }
+    }
+  }
+  else{
+    memcpy(job.offsets[0],offset,sizeof(offset));
+  }
+
+  // pass 2: scan chunks
+  ScalarArray_reduceRun(TScalarArray_scanJob<T>,&job,sIn,job.total,job.chunk);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+typedef void (TScalarArray_sum_fn)(double outsum[4], const lxScalarArray_t &sarr);
+typedef double (TScalarArray_dot_fn)(const lxScalarArray_t &sarr0, const lxScalarArray_t &sarr1);
+typedef void (TScalarArray_minMax_fn)(void *outmin, void *outmax, uint *outminidx, uint *outmaxidx, const lxScalarArray_t &sarr);
+typedef void (TScalarArray_scan_fn)(lxScalarArray_t &sOut, const lxScalarArray_t &sIn, booln exclusive);
+
+static TScalarArray_sum_fn* l_TSum[LUX_SCALAROPS_MAX_SUPPORTED] = {
+  TScalarArray_sum<float>,
+  TScalarArray_sum<int8>,
+  TScalarArray_sum<uint8>,
+  TScalarArray_sum<int16>,
+  TScalarArray_sum<uint16>,
+  TScalarArray_sum<int32>,
+  TScalarArray_sum<uint32>,
+};
+
+static TScalarArray_dot_fn* l_TDot[LUX_SCALAROPS_MAX_SUPPORTED] = {
+  TScalarArray_dot<float>,
+  TScalarArray_dot<int8>,
+  TScalarArray_dot<uint8>,
+  TScalarArray_dot<int16>,
+  TScalarArray_dot<uint16>,
+  TScalarArray_dot<int32>,
+  TScalarArray_dot<uint32>,
+};
+
+static TScalarArray_minMax_fn* l_TMinMax[LUX_SCALAROPS_MAX_SUPPORTED] = {
+  TScalarArray_minMax<float>,
+  TScalarArray_minMax<int8>,
+  TScalarArray_minMax<uint8>,
+  TScalarArray_minMax<int16>,
+  TScalarArray_minMax<uint16>,
+  TScalarArray_minMax<int32>,
+  TScalarArray_minMax<uint32>,
+};
+
+static TScalarArray_scan_fn* l_TScan[LUX_SCALAROPS_MAX_SUPPORTED] = {
+  TScalarArray_scan<float>,
+  TScalarArray_scan<int8>,
+  TScalarArray_scan<uint8>,
+  TScalarArray_scan<int16>,
+  TScalarArray_scan<uint16>,
+  TScalarArray_scan<int32>,
+  TScalarArray_scan<uint32>,
+};
+
+LUX_API booln lxScalarArray_sum(const lxScalarArray_t *sarr, double outsum[4])
+{
+  if (!ScalarArray_isReducible(*sarr)){
+    return LUX_TRUE;
+  }
+
+  l_TSum[sarr->type](outsum,*sarr);
+  return LUX_FALSE;
+}
+
+LUX_API booln lxScalarArray_minMax(const lxScalarArray_t *sarr, lxScalarVector_t *outmin, lxScalarVector_t *outmax,
+                  uint outminidx[4], uint outmaxidx[4])
+{
+  if (!ScalarArray_isReducible(*sarr)){
+    return LUX_TRUE;
+  }
+
+  l_TMinMax[sarr->type](outmin,outmax,outminidx,outmaxidx,*sarr);
+  return LUX_FALSE;
+}
+
+LUX_API booln lxScalarArray_min(const lxScalarArray_t *sarr, lxScalarVector_t *outmin)
+{
+  return lxScalarArray_minMax(sarr,outmin,NULL,NULL,NULL);
+}
+
+LUX_API booln lxScalarArray_max(const lxScalarArray_t *sarr, lxScalarVector_t *outmax)
+{
+  return lxScalarArray_minMax(sarr,NULL,outmax,NULL,NULL);
+}
+
+LUX_API booln lxScalarArray_dot(const lxScalarArray_t *sarr0, const lxScalarArray_t *sarr1, double *outdot)
+{
+  if (!ScalarArray_isReducible(*sarr0) || !sarr1->count ||
+    sarr0->type != sarr1->type || sarr0->vectordim != sarr1->vectordim)
+  {
+    return LUX_TRUE;
+  }
+
+  *outdot = l_TDot[sarr0->type](*sarr0,*sarr1);
+  return LUX_FALSE;
+}
+
+LUX_API booln lxScalarArray_length(const lxScalarArray_t *sarr, double *outlength)
+{
+  if (!ScalarArray_isReducible(*sarr)){
+    return LUX_TRUE;
+  }
+
+  *outlength = sqrt(l_TDot[sarr->type](*sarr,*sarr));
+  return LUX_FALSE;
+}
+
+static booln ScalarArray_scan(lxScalarArray_t *sOut, const lxScalarArray_t *sIn, booln exclusive)
+{
+  if (!ScalarArray_isReducible(*sIn) || !sOut->count || !sOut->stride ||
+    sOut->type != sIn->type || sOut->vectordim != sIn->vectordim)
+  {
+    return LUX_TRUE;
+  }
+
+  l_TScan[sIn->type](*sOut,*sIn,exclusive);
+  return LUX_FALSE;
+}
+
+LUX_API booln lxScalarArray_scanInclusive(lxScalarArray_t *sOut, const lxScalarArray_t *sIn)
+{
+  return ScalarArray_scan(sOut,sIn,LUX_FALSE);
+}
+
+LUX_API booln lxScalarArray_scanExclusive(lxScalarArray_t *sOut, const lxScalarArray_t *sIn)
+{
+  return ScalarArray_scan(sOut,sIn,LUX_TRUE);
+}
+
+#undef SCALAR_REDUCE_CHUNK_BYTES
+#undef SCALAR_REDUCE_MAXCHUNKS
+#undef SCALAR_REDUCE_LANES
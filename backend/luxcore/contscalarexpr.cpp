@@ -0,0 +1,443 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxcore/contscalarexpr.h>
+#include <luxinia/luxplatform/debug.h>
+
+#include <string.h>
+
+#include "contscalararray_defs.h"
+
+//////////////////////////////////////////////////////////////////////////
+// ScalarExpr
+
+  // scratch slots are aligned for the AVX2 kernels
+#define SCALAREXPR_ALIGN      32
+
+  // slot markers
+#define SCALAREXPR_SLOT_INPUT   -1
+#define SCALAREXPR_SLOT_OUTPUT  -2
+
+enum ScalarExprNodeType_e{
+  SCALAREXPR_INPUT,
+  SCALAREXPR_OP2,
+  SCALAREXPR_OP3,
+  SCALAREXPR_FOP1,
+};
+
+typedef struct ScalarExprNode_s{
+  int         type;
+  int         op;
+  int         args[3];
+  lxScalarArray_t   sarr;
+  booln       hasMatrix;
+  float       matrix[16];
+}ScalarExprNode_t;
+
+typedef struct lxScalarExpr_s{
+  lxMemoryAllocatorPTR  allocator;
+  lxScalarType_t      type;
+  uint          vectordim;
+
+  uint          numNodes;
+  ScalarExprNode_t    nodes[LUX_SCALAREXPR_MAX_NODES];
+
+  byte*         scratch;
+  size_t          scratchSize;
+}lxScalarExpr_t;
+
+typedef struct ScalarExprEval_s{
+  lxScalarExprPTR     expr;
+  int           target;
+  uint          count;
+  lxScalarArray_t     out;
+
+  int           slots[LUX_SCALAREXPR_MAX_NODES];
+  booln         needed[LUX_SCALAREXPR_MAX_NODES];
+  uint          numSlots;
+  size_t          slotBytes;
+  size_t          threadBytes;
+
+  volatile booln      error;
+}ScalarExprEval_t;
+
+LUX_API lxScalarExprPTR lxScalarExpr_new(lxMemoryAllocatorPTR allocator, lxScalarType_t type, uint vectordim)
+{
+  lxScalarExprPTR expr;
+
+  if (type > LUX_SCALAR_UINT32 || vectordim < 1 || vectordim > 4)
+    return NULL;
+
+  expr = (lxScalarExprPTR)lxMemoryAllocator_malloc(allocator,sizeof(lxScalarExpr_t));
+  memset(expr,0,sizeof(lxScalarExpr_t));
+  expr->allocator = allocator;
+  expr->type = type;
+  expr->vectordim = vectordim;
+
+  return expr;
+}
+
+LUX_API void lxScalarExpr_delete(lxScalarExprPTR expr)
+{
+  if (expr->scratch){
+    lxMemoryAllocator_freeAligned(expr->allocator,expr->scratch,expr->scratchSize);
+  }
+  lxMemoryAllocator_free(expr->allocator,expr,sizeof(lxScalarExpr_t));
+}
+
+LUX_API void lxScalarExpr_clear(lxScalarExprPTR expr)
+{
+  expr->numNodes = 0;
+}
+
+LUX_API uint lxScalarExpr_getCount(lxScalarExprPTR expr)
+{
+  return expr->numNodes;
+}
+
+static booln ScalarExpr_isValidInput(lxScalarExprPTR expr, const lxScalarArray_t *sarr)
+{
+  return sarr->type == expr->type &&
+    (sarr->vectordim == expr->vectordim || sarr->vectordim == 1) &&
+    (sarr->stride == 0 || sarr->stride >= sarr->vectordim);
+}
+
+  // vectordim 1 arrays only work as last operand
+static booln ScalarExpr_isValidArg(lxScalarExprPTR expr, int node, booln last)
+{
+  const ScalarExprNode_t* arg;
+
+  if (node < 0 || node >= (int)expr->numNodes)
+    return LUX_FALSE;
+
+  arg = &expr->nodes[node];
+  return last || arg->type != SCALAREXPR_INPUT ||
+    arg->sarr.vectordim == expr->vectordim || arg->sarr.stride == 0;
+}
+
+static ScalarExprNode_t* ScalarExpr_addNode(lxScalarExprPTR expr, int type, int op)
+{
+  ScalarExprNode_t* node;
+
+  if (expr->numNodes >= LUX_SCALAREXPR_MAX_NODES)
+    return NULL;
+
+  node = &expr->nodes[expr->numNodes++];
+  memset(node,0,sizeof(ScalarExprNode_t));
+  node->type = type;
+  node->op = op;
+  node->args[0] = node->args[1] = node->args[2] = -1;
+
+  return node;
+}
+
+LUX_API int lxScalarExpr_input(lxScalarExprPTR expr, const lxScalarArray_t *sarr)
+{
+  ScalarExprNode_t* node;
+
+  if (!ScalarExpr_isValidInput(expr,sarr) ||
+    !(node = ScalarExpr_addNode(expr,SCALAREXPR_INPUT,0)))
+    return -1;
+
+  node->sarr = *sarr;
+  return expr->numNodes-1;
+}
+
+LUX_API int lxScalarExpr_op2(lxScalarExprPTR expr, lxScalarArrayOp_t op, int node0, int node1)
+{
+  ScalarExprNode_t* node;
+
+  if (op < LUX_SCALAR_OP2_ADD || op > LUX_SCALAR_OP2_DIV_SAT ||
+    !ScalarExpr_isValidArg(expr,node0,LUX_FALSE) ||
+    !ScalarExpr_isValidArg(expr,node1,LUX_TRUE) ||
+    !(node = ScalarExpr_addNode(expr,SCALAREXPR_OP2,op)))
+    return -1;
+
+  node->args[0] = node0;
+  node->args[1] = node1;
+  return expr->numNodes-1;
+}
+
+LUX_API int lxScalarExpr_op3(lxScalarExprPTR expr, lxScalarArrayOp_t op, int node0, int node1, int node2)
+{
+  ScalarExprNode_t* node;
+
+  if (op < LUX_SCALAR_OP3_LERP || op > LUX_SCALAR_OP3_MADD_SAT ||
+    !ScalarExpr_isValidArg(expr,node0,LUX_FALSE) ||
+    !ScalarExpr_isValidArg(expr,node1,LUX_FALSE) ||
+    !ScalarExpr_isValidArg(expr,node2,LUX_TRUE) ||
+    !(node = ScalarExpr_addNode(expr,SCALAREXPR_OP3,op)))
+    return -1;
+
+  node->args[0] = node0;
+  node->args[1] = node1;
+  node->args[2] = node2;
+  return expr->numNodes-1;
+}
+
+LUX_API int lxScalarExpr_fop1(lxScalarExprPTR expr, lxFScalarArrayOp_t op, int node0, const float *arg)
+{
+  ScalarExprNode_t* node;
+
+  if (expr->type != LUX_SCALAR_FLOAT32 || expr->vectordim < 2 ||
+    op < LUX_FSCALAR_OP1_TRANSFORM || op >= LUX_FSCALAR_OP1S ||
+    (op < LUX_FSCALAR_OP1_NORMALIZE && !arg) ||
+    !ScalarExpr_isValidArg(expr,node0,LUX_FALSE) ||
+    !(node = ScalarExpr_addNode(expr,SCALAREXPR_FOP1,op)))
+    return -1;
+
+  node->args[0] = node0;
+  if (arg){
+    node->hasMatrix = LUX_TRUE;
+    memcpy(node->matrix,arg,sizeof(float)*16);
+  }
+  return expr->numNodes-1;
+}
+
+LUX_API booln lxScalarExpr_setInput(lxScalarExprPTR expr, int node, const lxScalarArray_t *sarr)
+{
+  ScalarExprNode_t* input;
+
+  if (node < 0 || node >= (int)expr->numNodes || !ScalarExpr_isValidInput(expr,sarr))
+    return LUX_TRUE;
+
+  input = &expr->nodes[node];
+  if (input->type != SCALAREXPR_INPUT ||
+    (sarr->vectordim != input->sarr.vectordim && sarr->stride != 0))
+    return LUX_TRUE;
+
+  input->sarr = *sarr;
+  return LUX_FALSE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Evaluation
+
+  // marks nodes target depends on, assigns scratch slots to
+  // intermediates and singles. A slot is reused once its node
+  // was consumed for the last time. Returns count of vectors
+static uint ScalarExpr_schedule(ScalarExprEval_t* ev)
+{
+  lxScalarExprPTR expr = ev->expr;
+  int lastUse[LUX_SCALAREXPR_MAX_NODES];
+  int freeSlots[LUX_SCALAREXPR_MAX_NODES];
+  booln released[LUX_SCALAREXPR_MAX_NODES];
+  int numFree = 0;
+  uint count = ev->out.count;
+  int i;
+  int a;
+
+  memset(ev->needed,0,sizeof(ev->needed));
+  memset(released,0,sizeof(released));
+  ev->needed[ev->target] = LUX_TRUE;
+  for (i = ev->target; i >= 0; i--){
+    const ScalarExprNode_t* node = &expr->nodes[i];
+    lastUse[i] = i;
+    if (!ev->needed[i])
+      continue;
+    for (a = 0; a < 3; a++){
+      if (node->args[a] >= 0){
+        ev->needed[node->args[a]] = LUX_TRUE;
+      }
+    }
+  }
+  for (i = 0; i <= ev->target; i++){
+    const ScalarExprNode_t* node = &expr->nodes[i];
+    if (!ev->needed[i])
+      continue;
+    for (a = 0; a < 3; a++){
+      if (node->args[a] >= 0){
+        lastUse[node->args[a]] = i;
+      }
+    }
+  }
+
+  ev->numSlots = 0;
+  for (i = 0; i <= ev->target; i++){
+    const ScalarExprNode_t* node = &expr->nodes[i];
+    if (!ev->needed[i])
+      continue;
+
+    if (node->type == SCALAREXPR_INPUT){
+      if (node->sarr.stride == 0){
+        // singles are expanded once, slot is never released
+        ev->slots[i] = ev->numSlots++;
+      }
+      else{
+        ev->slots[i] = SCALAREXPR_SLOT_INPUT;
+        count = LUX_MIN(count,node->sarr.count);
+      }
+      continue;
+    }
+
+    // operands consumed the last time, result may reuse their slot
+    for (a = 0; a < 3; a++){
+      int arg = node->args[a];
+      if (arg >= 0 && lastUse[arg] == i && !released[arg] && 
+        expr->nodes[arg].type != SCALAREXPR_INPUT)
+      {
+        freeSlots[numFree++] = ev->slots[arg];
+        released[arg] = LUX_TRUE;
+      }
+    }
+
+    if (i == ev->target){
+      ev->slots[i] = SCALAREXPR_SLOT_OUTPUT;
+    }
+    else{
+      ev->slots[i] = numFree ? freeSlots[--numFree] : (int)ev->numSlots++;
+    }
+  }
+
+  return count;
+}
+
+  // fills scratch slot with single value for all vectors
+static void ScalarExpr_expandSingle(ScalarExprEval_t* ev, byte* scratch, const lxScalarArray_t *single)
+{
+  lxScalarExprPTR expr = ev->expr;
+  size_t size = lx_gScalarTypeSizes[expr->type];
+  size_t vectorSize = size * expr->vectordim;
+  byte vector[sizeof(double)*4];
+  uint i;
+
+  for (i = 0; i < expr->vectordim; i++){
+    memcpy(&vector[i*size],(byte*)single->data.tvoid + (single->vectordim == 1 ? 0 : i*size),size);
+  }
+  for (i = 0; i < LUX_SCALAREXPR_CHUNK; i++){
+    memcpy(scratch + i*vectorSize,vector,vectorSize);
+  }
+}
+
+static void ScalarExpr_getArray(ScalarExprEval_t* ev, lxScalarArray_t *sarr, int node, byte* scratch, uint start, uint count)
+{
+  lxScalarExprPTR expr = ev->expr;
+  int slot = ev->slots[node];
+
+  if (slot == SCALAREXPR_SLOT_INPUT){
+    const lxScalarArray_t *src = &expr->nodes[node].sarr;
+    *sarr = *src;
+    sarr->data.tvoid = (byte*)src->data.tvoid + (size_t)start * src->stride * lx_gScalarTypeSizes[src->type];
+    sarr->count = count;
+  }
+  else if (slot == SCALAREXPR_SLOT_OUTPUT){
+    *sarr = ev->out;
+    sarr->data.tvoid = (byte*)ev->out.data.tvoid + (size_t)start * ev->out.stride * lx_gScalarTypeSizes[ev->out.type];
+    sarr->count = count;
+  }
+  else{
+    lxScalarArray_init(sarr,expr->type,scratch + ev->slotBytes * slot,expr->vectordim,expr->vectordim,count);
+  }
+}
+
+static void ScalarExpr_runChunk(void* userdata, uint chunk, uint threadindex)
+{
+  ScalarExprEval_t* ev = (ScalarExprEval_t*)userdata;
+  lxScalarExprPTR expr = ev->expr;
+  byte* scratch = expr->scratch + ev->threadBytes * threadindex;
+  uint start = chunk * LUX_SCALAREXPR_CHUNK;
+  uint count = LUX_MIN(LUX_SCALAREXPR_CHUNK, ev->count - start);
+  lxScalarArray_t sarr[4];
+  booln err = LUX_FALSE;
+  int i;
+  int a;
+
+  for (i = 0; i <= ev->target && !err; i++){
+    const ScalarExprNode_t* node = &expr->nodes[i];
+    if (!ev->needed[i] || node->type == SCALAREXPR_INPUT)
+      continue;
+
+    ScalarExpr_getArray(ev,&sarr[0],i,scratch,start,count);
+    for (a = 0; a < 3 && node->args[a] >= 0; a++){
+      ScalarExpr_getArray(ev,&sarr[a+1],node->args[a],scratch,start,count);
+    }
+
+    switch(node->type){
+    case SCALAREXPR_OP2:
+      err = ScalarArray_Op2(&sarr[0],(lxScalarArrayOp_t)node->op,&sarr[1],&sarr[2]);
+      break;
+    case SCALAREXPR_OP3:
+      err = ScalarArray_Op3(&sarr[0],(lxScalarArrayOp_t)node->op,&sarr[1],&sarr[2],&sarr[3]);
+      break;
+    case SCALAREXPR_FOP1:
+      err = lxFScalarArray_op1(&sarr[0],(lxFScalarArrayOp_t)node->op,&sarr[1],
+        node->hasMatrix ? node->matrix : NULL);
+      break;
+    }
+  }
+
+  if (err){
+    ev->error = LUX_TRUE;
+  }
+}
+
+LUX_API booln lxScalarExpr_eval(lxScalarExprPTR expr, int node, lxScalarArray_t *sOut)
+{
+  ScalarExprEval_t ev;
+  lxJobPoolPTR pool;
+  uint numThreads;
+  uint numChunks;
+  size_t scratchSize;
+  uint t;
+  int i;
+
+  if (node < 0 || node >= (int)expr->numNodes || sOut->type != expr->type ||
+    sOut->vectordim != expr->vectordim || sOut->stride < sOut->vectordim)
+    return LUX_TRUE;
+
+  memset(&ev,0,sizeof(ev));
+  ev.expr = expr;
+  ev.target = node;
+  ev.out = *sOut;
+
+  if (expr->nodes[node].type == SCALAREXPR_INPUT){
+    return lxScalarArray_Op1(sOut,LUX_SCALAR_OP1_COPY,&expr->nodes[node].sarr);
+  }
+
+  ev.count = ScalarExpr_schedule(&ev);
+  if (!ev.count)
+    return LUX_FALSE;
+
+  ev.slotBytes = lx_gScalarTypeSizes[expr->type] * expr->vectordim * LUX_SCALAREXPR_CHUNK;
+  ev.slotBytes = (ev.slotBytes + SCALAREXPR_ALIGN - 1) & ~(size_t)(SCALAREXPR_ALIGN - 1);
+  ev.threadBytes = ev.slotBytes * ev.numSlots;
+
+  numChunks = (ev.count + LUX_SCALAREXPR_CHUNK - 1) / LUX_SCALAREXPR_CHUNK;
+  pool = ScalarArray_useJobs((size_t)ev.count * expr->vectordim) ? lxScalarArray_getJobPool() : NULL;
+  numThreads = pool ? lxJobPool_getThreadCount(pool) : 1;
+
+  scratchSize = ev.threadBytes * numThreads;
+  if (scratchSize > expr->scratchSize){
+    if (expr->scratch){
+      lxMemoryAllocator_freeAligned(expr->allocator,expr->scratch,expr->scratchSize);
+    }
+    expr->scratch = (byte*)lxMemoryAllocator_mallocAligned(expr->allocator,scratchSize,SCALAREXPR_ALIGN);
+    expr->scratchSize = scratchSize;
+  }
+
+  for (i = 0; i <= node; i++){
+    if (ev.needed[i] && expr->nodes[i].type == SCALAREXPR_INPUT && ev.slots[i] >= 0){
+      for (t = 0; t < numThreads; t++){
+        ScalarExpr_expandSingle(&ev,expr->scratch + ev.threadBytes * t + ev.slotBytes * ev.slots[i],
+          &expr->nodes[i].sarr);
+      }
+    }
+  }
+
+  if (pool){
+    ScalarArray_dispatch(pool,numChunks,ScalarExpr_runChunk,&ev);
+  }
+  else{
+    uint c;
+    for (c = 0; c < numChunks; c++){
+      ScalarExpr_runChunk(&ev,c,0);
+    }
+  }
+
+  return ev.error;
+}
+
+#undef SCALAREXPR_ALIGN
+#undef SCALAREXPR_SLOT_INPUT
+#undef SCALAREXPR_SLOT_OUTPUT
@@ -0,0 +1,305 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxcore/jobpool.h>
+#include <luxinia/luxplatform/cpu.h>
+#include <luxinia/luxplatform/debug.h>
+
+#include <string.h>
+
+#ifdef LUX_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define JobPool_atomicInc(ptr)    (InterlockedIncrement(ptr)-1)
+#define JobPool_acquire(ptr)      (InterlockedCompareExchange(ptr,1,0) == 0)
+#define JobPool_release(ptr)      InterlockedExchange(ptr,0)
+#else
+#include <pthread.h>
+#define JobPool_atomicInc(ptr)    __sync_fetch_and_add(ptr,1)
+#define JobPool_acquire(ptr)      __sync_bool_compare_and_swap(ptr,0,1)
+#define JobPool_release(ptr)      __sync_lock_release(ptr)
+#endif
+
+// WaitForMultipleObjects limit
+#define LUX_JOBPOOL_MAX_THREADS   64
+
+typedef struct lxJobPool_s{
+  lxMemoryAllocatorPTR  allocator;
+  uint          numThreads;
+
+  // current run
+  volatile long     busy;
+  volatile long     nextJob;
+  uint          numJobs;
+  lxJobPoolFunc_fn    *func;
+  void*         userdata;
+  booln         quit;
+
+  // workers are numThreads-1
+#ifdef LUX_PLATFORM_WINDOWS
+  HANDLE*         threads;
+  HANDLE*         wake;
+  HANDLE*         done;
+#else
+  pthread_t*        threads;
+  pthread_mutex_t     mutex;
+  pthread_cond_t      wake;
+  pthread_cond_t      done;
+  uint          generation;
+  uint          active;
+#endif
+}lxJobPool_t;
+
+typedef struct JobPoolWorker_s{
+  lxJobPoolPTR  pool;
+  uint      threadindex;
+}JobPoolWorker_t;
+
+static void JobPool_work(lxJobPoolPTR pool, uint threadindex)
+{
+  uint job;
+  while ((job = (uint)JobPool_atomicInc(&pool->nextJob)) < pool->numJobs){
+    pool->func(pool->userdata,job,threadindex);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Platform
+
+#ifdef LUX_PLATFORM_WINDOWS
+
+static DWORD WINAPI JobPool_thread(LPVOID param)
+{
+  JobPoolWorker_t* worker = (JobPoolWorker_t*)param;
+  lxJobPoolPTR pool = worker->pool;
+  uint idx = worker->threadindex-1;
+
+  for(;;){
+    WaitForSingleObject(pool->wake[idx],INFINITE);
+    if (pool->quit)
+      break;
+    JobPool_work(pool,worker->threadindex);
+    SetEvent(pool->done[idx]);
+  }
+  return 0;
+}
+
+static void JobPool_initThreads(lxJobPoolPTR pool, JobPoolWorker_t* workers)
+{
+  uint numWorkers = pool->numThreads-1;
+  uint i;
+
+  pool->threads = (HANDLE*)lxMemoryAllocator_malloc(pool->allocator,sizeof(HANDLE)*numWorkers*3);
+  pool->wake = pool->threads + numWorkers;
+  pool->done = pool->wake + numWorkers;
+
+  for (i = 0; i < numWorkers; i++){
+    pool->wake[i] = CreateEvent(NULL,FALSE,FALSE,NULL);
+    pool->done[i] = CreateEvent(NULL,FALSE,FALSE,NULL);
+    pool->threads[i] = CreateThread(NULL,0,JobPool_thread,&workers[i],0,NULL);
+  }
+}
+
+static void JobPool_deinitThreads(lxJobPoolPTR pool)
+{
+  uint numWorkers = pool->numThreads-1;
+  uint i;
+
+  pool->quit = LUX_TRUE;
+  for (i = 0; i < numWorkers; i++){
+    SetEvent(pool->wake[i]);
+  }
+  WaitForMultipleObjects(numWorkers,pool->threads,TRUE,INFINITE);
+  for (i = 0; i < numWorkers; i++){
+    CloseHandle(pool->threads[i]);
+    CloseHandle(pool->wake[i]);
+    CloseHandle(pool->done[i]);
+  }
+
+  lxMemoryAllocator_free(pool->allocator,pool->threads,sizeof(HANDLE)*numWorkers*3);
+}
+
+static void JobPool_dispatch(lxJobPoolPTR pool)
+{
+  uint numWorkers = pool->numThreads-1;
+  uint i;
+
+  for (i = 0; i < numWorkers; i++){
+    SetEvent(pool->wake[i]);
+  }
+  JobPool_work(pool,0);
+  WaitForMultipleObjects(numWorkers,pool->done,TRUE,INFINITE);
+}
+
+#else
+
+static void* JobPool_thread(void* param)
+{
+  JobPoolWorker_t* worker = (JobPoolWorker_t*)param;
+  lxJobPoolPTR pool = worker->pool;
+  uint generation = 0;
+
+  for(;;){
+    pthread_mutex_lock(&pool->mutex);
+    while (generation == pool->generation && !pool->quit){
+      pthread_cond_wait(&pool->wake,&pool->mutex);
+    }
+    generation = pool->generation;
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (pool->quit)
+      break;
+
+    JobPool_work(pool,worker->threadindex);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->active == 0){
+      pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+  }
+  return NULL;
+}
+
+static void JobPool_initThreads(lxJobPoolPTR pool, JobPoolWorker_t* workers)
+{
+  uint numWorkers = pool->numThreads-1;
+  uint i;
+
+  pthread_mutex_init(&pool->mutex,NULL);
+  pthread_cond_init(&pool->wake,NULL);
+  pthread_cond_init(&pool->done,NULL);
+
+  pool->threads = (pthread_t*)lxMemoryAllocator_malloc(pool->allocator,sizeof(pthread_t)*numWorkers);
+  for (i = 0; i < numWorkers; i++){
+    pthread_create(&pool->threads[i],NULL,JobPool_thread,&workers[i]);
+  }
+}
+
+static void JobPool_deinitThreads(lxJobPoolPTR pool)
+{
+  uint numWorkers = pool->numThreads-1;
+  uint i;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->quit = LUX_TRUE;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (i = 0; i < numWorkers; i++){
+    pthread_join(pool->threads[i],NULL);
+  }
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->mutex);
+
+  lxMemoryAllocator_free(pool->allocator,pool->threads,sizeof(pthread_t)*numWorkers);
+}
+
+static void JobPool_dispatch(lxJobPoolPTR pool)
+{
+  pthread_mutex_lock(&pool->mutex);
+  pool->active = pool->numThreads-1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+
+  JobPool_work(pool,0);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->active){
+    pthread_cond_wait(&pool->done,&pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// JobPool
+
+LUX_API lxJobPoolPTR lxJobPool_new(lxMemoryAllocatorPTR allocator, uint numThreads)
+{
+  lxJobPoolPTR pool;
+  JobPoolWorker_t* workers;
+  uint i;
+
+  if (!numThreads){
+    numThreads = lxCPU_getCount();
+  }
+  if (numThreads > LUX_JOBPOOL_MAX_THREADS){
+    numThreads = LUX_JOBPOOL_MAX_THREADS;
+  }
+
+  // worker params are stored behind pool
+  pool = (lxJobPoolPTR)lxMemoryAllocator_malloc(allocator,
+    sizeof(lxJobPool_t) + sizeof(JobPoolWorker_t)*numThreads);
+  memset(pool,0,sizeof(lxJobPool_t));
+  pool->allocator = allocator;
+  pool->numThreads = numThreads;
+
+  workers = (JobPoolWorker_t*)(pool+1);
+  for (i = 0; i < numThreads-1; i++){
+    workers[i].pool = pool;
+    workers[i].threadindex = i+1;
+  }
+
+  if (numThreads > 1){
+    JobPool_initThreads(pool,workers);
+  }
+
+  return pool;
+}
+
+LUX_API void lxJobPool_delete(lxJobPoolPTR pool)
+{
+  if (pool->numThreads > 1){
+    JobPool_deinitThreads(pool);
+  }
+  lxMemoryAllocator_free(pool->allocator,pool,
+    sizeof(lxJobPool_t) + sizeof(JobPoolWorker_t)*pool->numThreads);
+}
+
+LUX_API uint lxJobPool_getThreadCount(lxJobPoolPTR pool)
+{
+  return pool->numThreads;
+}
+
+LUX_API booln lxJobPool_tryRun(lxJobPoolPTR pool, uint numJobs, lxJobPoolFunc_fn *func, void* userdata)
+{
+  uint i;
+
+  if (!numJobs)
+    return LUX_TRUE;
+
+  if (!pool || numJobs == 1 || pool->numThreads == 1){
+    for (i = 0; i < numJobs; i++){
+      func(userdata,i,0);
+    }
+    return LUX_TRUE;
+  }
+
+  if (!JobPool_acquire(&pool->busy)){
+    return LUX_FALSE;
+  }
+
+  pool->numJobs = numJobs;
+  pool->func = func;
+  pool->userdata = userdata;
+  pool->nextJob = 0;
+
+  JobPool_dispatch(pool);
+  JobPool_release(&pool->busy);
+
+  return LUX_TRUE;
+}
+
+LUX_API void lxJobPool_run(lxJobPoolPTR pool, uint numJobs, lxJobPoolFunc_fn *func, void* userdata)
+{
+  if (!lxJobPool_tryRun(pool,numJobs,func,userdata)){
+    LUX_DEBUGASSERT(0 && "pool is busy, only one run at a time");
+    lxJobPool_run(NULL,numJobs,func,userdata);
+  }
+}
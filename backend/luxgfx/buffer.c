@@ -291,3 +291,214 @@ LUX_API booln lxgBuffer_unmap(lxgBufferPTR buffer)
   return LUX_TRUE;
 }
 
+
+//////////////////////////////////////////////////////////////////////////
+// lxgBufferRing
+
+static void lxgBufferRing_clear(lxgBufferRing_t* ring, uint32 size, uint align)
+{
+  LUX_DEBUGASSERT(align > 0 && (align & (align - 1)) == 0);
+
+  memset(ring,0,sizeof(lxgBufferRing_t));
+  ring->size = size;
+  ring->align = align;
+  ring->frameID = 1;
+}
+
+LUX_API void lxgBufferRing_init(lxgBufferRing_t* ring, lxgBufferPTR buffer, uint align)
+{
+  lxgBufferRing_clear(ring, buffer->size, align);
+  ring->buffer = buffer;
+  // sync objects are core in GL3.2
+  ring->sync = (buffer->ctxcapbits & LUXGFX_CAP_API3) ? LUX_TRUE : LUX_FALSE;
+}
+
+LUX_API void lxgBufferRing_initCPU(lxgBufferRing_t* ring, void* memory, uint size, uint align)
+{
+  lxgBufferRing_clear(ring, size, align);
+  ring->memory = (byte*)memory;
+}
+
+static void lxgBufferRing_unmap(lxgBufferRing_t* ring)
+{
+  if (ring->mapped && ring->buffer){
+    if ((ring->buffer->ctxcapbits & LUXGFX_CAP_API3) && ring->mapWritten > ring->mapBegin){
+      lxgBuffer_flushRange(ring->buffer, 0, ring->mapWritten - ring->mapBegin);
+    }
+    lxgBuffer_unmap(ring->buffer);
+  }
+  ring->mapped = NULL;
+}
+
+static booln lxgBufferRing_completed(lxgBufferRing_t* ring, lxgBufferRingFrame_t* frame, booln wait)
+{
+  if (!ring->buffer){
+    if (frame->id > ring->completedID){
+      if (!wait) 
+        return LUX_FALSE;
+      ring->completedID = frame->id;
+      ring->stats.numStalls++;
+    }
+    return LUX_TRUE;
+  }
+  else if (frame->fence){
+    GLenum result = glClientWaitSync(frame->fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED){
+      if (!wait) 
+        return LUX_FALSE;
+      ring->stats.numStalls++;
+      do {
+        result = glClientWaitSync(frame->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+      } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(frame->fence);
+    frame->fence = NULL;
+  }
+  return LUX_TRUE;
+}
+
+  // releases completed frames in order, waits for the oldest one
+  // if requested, returns number of released frames
+static uint lxgBufferRing_retire(lxgBufferRing_t* ring, booln wait)
+{
+  uint retired = 0;
+
+  while (ring->numPending){
+    lxgBufferRingFrame_t* frame = &ring->pending[ring->firstPending];
+    if (!lxgBufferRing_completed(ring, frame, wait && !retired)){
+      break;
+    }
+    ring->tail = frame->end;
+    ring->used -= frame->bytes;
+    ring->firstPending = (ring->firstPending + 1) % LUXGFX_RING_MAXFRAMES;
+    ring->numPending--;
+    retired++;
+  }
+
+  return retired;
+}
+
+LUX_API void lxgBufferRing_deinit(lxgBufferRing_t* ring)
+{
+  lxgBufferRing_unmap(ring);
+  while (lxgBufferRing_retire(ring, LUX_TRUE));
+}
+
+LUX_API void* lxgBufferRing_alloc(lxgBufferRing_t* ring, uint size, uint* offset)
+{
+  uint32 pos;
+  uint32 pad;
+  booln  wrapped = LUX_FALSE;
+
+  if (!size || size > ring->size){
+    ring->stats.numFailed++;
+    return NULL;
+  }
+
+  for (;;){
+    if (!ring->used){
+      ring->head = ring->tail = 0;
+    }
+    pos = (ring->head + ring->align - 1) & ~(ring->align - 1);
+
+    if (ring->head >= ring->tail && ring->used < ring->size){
+      // free at end and before tail
+      if (pos + size <= ring->size){
+        pad = pos - ring->head;
+        break;
+      }
+      if (size <= ring->tail){
+        pad = ring->size - ring->head;
+        pos = 0;
+        wrapped = LUX_TRUE;
+        break;
+      }
+    }
+    else if (ring->head < ring->tail && pos + size <= ring->tail){
+      pad = pos - ring->head;
+      break;
+    }
+
+    if (!lxgBufferRing_retire(ring, LUX_FALSE) && !lxgBufferRing_retire(ring, LUX_TRUE)){
+      // the current frame alone fills the ring
+      ring->stats.numFailed++;
+      return NULL;
+    }
+  }
+
+  if (!ring->mapped || pos < ring->mapBegin || pos + size > ring->mapEnd){
+    // map all free space that follows
+    uint32 end = pos < ring->tail ? ring->tail : ring->size;
+
+    lxgBufferRing_unmap(ring);
+    ring->mapped = ring->buffer ? (byte*)lxgBuffer_mapRange(ring->buffer, pos, end - pos, 
+      LUXGFX_ACCESS_WRITEDISCARD, LUX_TRUE, ring->sync, NULL) : ring->memory + pos;
+    if (!ring->mapped){
+      // nothing was allocated, the next alloc maps again
+      ring->stats.numFailed++;
+      return NULL;
+    }
+    ring->mapBegin = pos;
+    ring->mapEnd = end;
+    ring->stats.numMaps++;
+    ring->stats.stallsAvoided += ring->numPending && (ring->sync || !ring->buffer) ? 1 : 0;
+  }
+
+  // account only once the space is writable
+  ring->used += pad + size;
+  ring->frameBytes += pad + size;
+  ring->head = pos + size;
+  ring->mapWritten = pos + size;
+
+  ring->stats.bytesStreamed += size;
+  ring->stats.bytesPadding += pad;
+  ring->stats.numAllocs++;
+  ring->stats.numWraps += wrapped ? 1 : 0;
+
+  if (offset){
+    *offset = pos;
+  }
+
+  return ring->mapped + (pos - ring->mapBegin);
+}
+
+LUX_API void lxgBufferRing_flush(lxgBufferRing_t* ring)
+{
+  lxgBufferRing_unmap(ring);
+}
+
+LUX_API uint32 lxgBufferRing_endFrame(lxgBufferRing_t* ring)
+{
+  lxgBufferRingFrame_t* frame;
+  uint32 id = ring->frameID++;
+
+  // draws could not have used a still mapped range
+  LUX_DEBUGASSERT(!ring->mapped);
+  lxgBufferRing_unmap(ring);
+  ring->stats.numFrames++;
+
+  if (!ring->frameBytes){
+    return id;
+  }
+
+  lxgBufferRing_retire(ring, LUX_FALSE);
+  if (ring->numPending == LUXGFX_RING_MAXFRAMES){
+    lxgBufferRing_retire(ring, LUX_TRUE);
+  }
+
+  frame = &ring->pending[(ring->firstPending + ring->numPending) % LUXGFX_RING_MAXFRAMES];
+  frame->fence = ring->sync ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : NULL;
+  frame->id = id;
+  frame->end = ring->head;
+  frame->bytes = ring->frameBytes;
+  ring->numPending++;
+  ring->frameBytes = 0;
+
+  return id;
+}
+
+LUX_API void lxgBufferRing_signalCPU(lxgBufferRing_t* ring, uint32 id)
+{
+  LUX_DEBUGASSERT(!ring->buffer);
+  ring->completedID = LUX_MAX(ring->completedID, id);
+}
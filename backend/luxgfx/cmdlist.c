@@ -0,0 +1,665 @@
+// Copyright (C) 2010-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxgfx/luxgfx.h>
+#include <luxinia/luxgfx/cmdlist.h>
+#include <luxinia/luxplatform/debug.h>
+
+#include "state_inl.h"
+
+  // keeps pointers in payloads aligned, also on 64 bit
+#define CMD_ALIGN           8
+#define CMD_SIZE(bytes)     (((bytes) + CMD_ALIGN - 1) & ~(CMD_ALIGN - 1))
+#define CMD_BINDARG(start,num)  ((start) | ((num) << 16))
+#define CMD_BINDSTART(arg)  ((arg) & 0xFFFF)
+#define CMD_BINDNUM(arg)    ((arg) >> 16)
+
+//////////////////////////////////////////////////////////////////////////
+// Recording
+
+LUX_API void lxgCmdList_init(lxgCmdList_t* list, void* memory, size_t size)
+{
+  LUX_DEBUGASSERT(((size_t)memory & (CMD_ALIGN - 1)) == 0);
+  list->begin = (byte*)memory;
+  list->end = list->begin + size;
+  lxgCmdList_reset(list);
+}
+
+LUX_API void lxgCmdList_reset(lxgCmdList_t* list)
+{
+  list->cur = list->begin;
+  list->numCmds = 0;
+  list->numDraws = 0;
+  list->overflow = LUX_FALSE;
+}
+
+static LUX_INLINE void* lxgCmdList_alloc(lxgCmdList_t* list, lxgCmdType_t type, size_t bytes, uint32 arg)
+{
+  size_t    size = CMD_SIZE(bytes);
+  lxgCmd_t* cmd = (lxgCmd_t*)list->cur;
+
+  LUX_DEBUGASSERT(size <= 0xFFFF);
+  if (list->overflow || size > (size_t)(list->end - list->cur)){
+    list->overflow = LUX_TRUE;
+    return NULL;
+  }
+
+  cmd->type = (uint16)type;
+  cmd->size = (uint16)size;
+  cmd->arg = arg;
+  list->cur += size;
+  list->numCmds++;
+
+  return cmd;
+}
+
+static LUX_INLINE void lxgCmdList_object(lxgCmdList_t* list, lxgCmdType_t type, const void* obj, uint32 arg)
+{
+  lxgCmdObject_t* cmd = (lxgCmdObject_t*)lxgCmdList_alloc(list,type,sizeof(lxgCmdObject_t),arg);
+  if (cmd){
+    cmd->obj = obj;
+  }
+}
+
+static LUX_INLINE void lxgCmdList_binds(lxgCmdList_t* list, lxgCmdType_t type, const void* objs, uint start, uint num)
+{
+  lxgCmdBinds_t* cmd = (lxgCmdBinds_t*)lxgCmdList_alloc(list,type,
+    sizeof(lxgCmd_t) + sizeof(void*) * num,CMD_BINDARG(start,num));
+  if (cmd){
+    memcpy((void*)cmd->objs,objs,sizeof(void*) * num);
+  }
+}
+
+LUX_API void lxgCmdList_program(lxgCmdList_t* list, lxgProgramCPTR prog)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_PROGRAM,prog,0);
+}
+
+LUX_API void lxgCmdList_programParameters(lxgCmdList_t* list, lxgProgramCPTR prog, uint num, lxgProgramParameterPTR *params, const void **data)
+{
+  lxgCmdParams_t* cmd = (lxgCmdParams_t*)lxgCmdList_alloc(list,LUXGFX_CMD_PROGRAMPARAMS,
+    sizeof(lxgCmdParams_t) + sizeof(void*) * num * 2,num);
+  if (cmd){
+    const void** ptrs = (const void**)(cmd + 1);
+    cmd->prog = prog;
+    memcpy((void*)ptrs,(const void*)params,sizeof(void*) * num);
+    memcpy((void*)(ptrs + num),data,sizeof(void*) * num);
+  }
+}
+
+LUX_API void lxgCmdList_textures(lxgCmdList_t* list, lxgTexturePTR *texs, uint start, uint num)
+{
+  lxgCmdList_binds(list,LUXGFX_CMD_TEXTURES,(const void*)texs,start,num);
+}
+
+LUX_API void lxgCmdList_samplers(lxgCmdList_t* list, lxgSamplerCPTR *samps, uint start, uint num)
+{
+  lxgCmdList_binds(list,LUXGFX_CMD_SAMPLERS,(const void*)samps,start,num);
+}
+
+LUX_API void lxgCmdList_textureImages(lxgCmdList_t* list, lxgTextureImageCPTR *imgs, uint start, uint num)
+{
+  lxgCmdList_binds(list,LUXGFX_CMD_TEXTUREIMAGES,(const void*)imgs,start,num);
+}
+
+LUX_API void lxgCmdList_vertexDecl(lxgCmdList_t* list, lxgVertexDeclCPTR decl)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_VERTEXDECL,decl,0);
+}
+
+LUX_API void lxgCmdList_vertexStream(lxgCmdList_t* list, uint idx, lxgStreamHostCPTR host)
+{
+  lxgCmdStream_t* cmd = (lxgCmdStream_t*)lxgCmdList_alloc(list,LUXGFX_CMD_VERTEXSTREAM,sizeof(lxgCmdStream_t),idx);
+  if (cmd){
+    cmd->host = *host;
+  }
+}
+
+LUX_API void lxgCmdList_vertexAttribs(lxgCmdList_t* list, flags32 needed)
+{
+  lxgCmdList_alloc(list,LUXGFX_CMD_VERTEXATTRIBS,sizeof(lxgCmd_t),needed);
+}
+
+LUX_API void lxgCmdList_indexBuffer(lxgCmdList_t* list, lxgBufferCPTR buffer)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_INDEXBUFFER,buffer,0);
+}
+
+LUX_API void lxgCmdList_blend(lxgCmdList_t* list, lxgBlendCPTR obj)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_BLEND,obj,0);
+}
+
+LUX_API void lxgCmdList_depth(lxgCmdList_t* list, lxgDepthCPTR obj)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_DEPTH,obj,0);
+}
+
+LUX_API void lxgCmdList_logic(lxgCmdList_t* list, lxgLogicCPTR obj)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_LOGIC,obj,0);
+}
+
+LUX_API void lxgCmdList_stencil(lxgCmdList_t* list, lxgStencilCPTR obj)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_STENCIL,obj,0);
+}
+
+LUX_API void lxgCmdList_color(lxgCmdList_t* list, lxgColorCPTR obj)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_COLOR,obj,0);
+}
+
+LUX_API void lxgCmdList_rasterizer(lxgCmdList_t* list, lxgRasterizerCPTR obj)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_RASTERIZER,obj,0);
+}
+
+LUX_API void lxgCmdList_renderTarget(lxgCmdList_t* list, lxgRenderTargetPTR rt, lxgRenderTargetType_t type)
+{
+  lxgCmdList_object(list,LUXGFX_CMD_RENDERTARGET,rt,type);
+}
+
+LUX_API void lxgCmdList_draw(lxgCmdList_t* list, const lxgDrawCall_t* draw)
+{
+  lxgCmdDraw_t* cmd = (lxgCmdDraw_t*)lxgCmdList_alloc(list,LUXGFX_CMD_DRAW,sizeof(lxgCmdDraw_t),0);
+  if (cmd){
+    cmd->draw = *draw;
+    list->numDraws++;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Replay
+
+static LUX_INLINE void lxgCmdList_applyDraw(lxgContextPTR ctx, const lxgDrawCall_t* draw)
+{
+  GLsizei instances = LUX_MAX(draw->instances,1);
+
+  lxgContext_checkedVertex(ctx);
+
+  if (draw->indexType == LUX_SCALAR_ILLEGAL){
+    if (instances > 1){
+      glDrawArraysInstanced(draw->primitive,draw->first,draw->count,instances);
+    }
+    else{
+      glDrawArrays(draw->primitive,draw->first,draw->count);
+    }
+  }
+  else{
+    GLenum type = lxScalarType_to(draw->indexType);
+    const void* offset = (const void*)(size_t)draw->first;
+    if (instances > 1 || draw->baseVertex){
+      glDrawElementsInstancedBaseVertex(draw->primitive,draw->count,type,offset,instances,draw->baseVertex);
+    }
+    else{
+      glDrawElements(draw->primitive,draw->count,type,offset);
+    }
+  }
+}
+
+static void lxgCmdList_replaySingle(lxgContextPTR ctx, const lxgCmdList_t* list, lxgBufferCPTR* indexBuffer)
+{
+  const lxgCmd_t* cmd;
+
+  for (cmd = lxgCmdList_first(list); !lxgCmdList_isEnd(list,cmd); cmd = lxgCmdList_next(cmd)){
+    const lxgCmdObject_t* objcmd = (const lxgCmdObject_t*)cmd;
+    const lxgCmdBinds_t*  bindcmd = (const lxgCmdBinds_t*)cmd;
+
+    switch(cmd->type){
+    case LUXGFX_CMD_PROGRAM:
+      lxgContext_checkedProgramContext(ctx,(lxgProgramCPTR)objcmd->obj);
+      break;
+    case LUXGFX_CMD_PROGRAMPARAMS:
+      {
+        const lxgCmdParams_t* paramcmd = (const lxgCmdParams_t*)cmd;
+        const void** ptrs = (const void**)(paramcmd + 1);
+        lxgContext_applyProgramParameters(ctx,paramcmd->prog,cmd->arg,
+          (lxgProgramParameterPTR*)ptrs,ptrs + cmd->arg);
+      }
+      break;
+    case LUXGFX_CMD_TEXTURES:
+      lxgContext_checkedTextures(ctx,(lxgTexturePTR*)bindcmd->objs,CMD_BINDSTART(cmd->arg),CMD_BINDNUM(cmd->arg));
+      break;
+    case LUXGFX_CMD_SAMPLERS:
+      lxgContext_checkedSamplers(ctx,(lxgSamplerCPTR*)bindcmd->objs,CMD_BINDSTART(cmd->arg),CMD_BINDNUM(cmd->arg));
+      break;
+    case LUXGFX_CMD_TEXTUREIMAGES:
+      lxgContext_checkedTextureImages(ctx,(lxgTextureImageCPTR*)bindcmd->objs,CMD_BINDSTART(cmd->arg),CMD_BINDNUM(cmd->arg));
+      break;
+    case LUXGFX_CMD_VERTEXDECL:
+      lxgContext_checkedVertexDecl(ctx,(lxgVertexDeclCPTR)objcmd->obj);
+      break;
+    case LUXGFX_CMD_VERTEXSTREAM:
+      lxgContext_setVertexStream(ctx,cmd->arg,&((const lxgCmdStream_t*)cmd)->host);
+      break;
+    case LUXGFX_CMD_VERTEXATTRIBS:
+      lxgContext_checkedVertexAttrib(ctx,cmd->arg);
+      break;
+    case LUXGFX_CMD_INDEXBUFFER:
+      if (*indexBuffer != objcmd->obj){
+        *indexBuffer = (lxgBufferCPTR)objcmd->obj;
+        lxgBuffer_bind(*indexBuffer,LUXGL_BUFFER_INDEX);
+      }
+      break;
+    case LUXGFX_CMD_BLEND:
+      lxgContext_checkedBlend(ctx,(lxgBlendCPTR)objcmd->obj);
+      break;
+    case LUXGFX_CMD_DEPTH:
+      lxgContext_checkedDepth(ctx,(lxgDepthCPTR)objcmd->obj);
+      break;
+    case LUXGFX_CMD_LOGIC:
+      lxgContext_checkedLogic(ctx,(lxgLogicCPTR)objcmd->obj);
+      break;
+    case LUXGFX_CMD_STENCIL:
+      lxgContext_checkedStencil(ctx,(lxgStencilCPTR)objcmd->obj);
+      break;
+    case LUXGFX_CMD_COLOR:
+      lxgContext_checkedColor(ctx,(lxgColorCPTR)objcmd->obj);
+      break;
+    case LUXGFX_CMD_RASTERIZER:
+      lxgContext_checkedRasterizer(ctx,(lxgRasterizerCPTR)objcmd->obj);
+      break;
+    case LUXGFX_CMD_RENDERTARGET:
+      lxgContext_checkedRenderTarget(ctx,(lxgRenderTargetPTR)objcmd->obj,(lxgRenderTargetType_t)cmd->arg);
+      break;
+    case LUXGFX_CMD_DRAW:
+      lxgCmdList_applyDraw(ctx,&((const lxgCmdDraw_t*)cmd)->draw);
+      break;
+    default:
+      LUX_DEBUGASSERT(0);
+      break;
+    }
+  }
+}
+
+LUX_API void lxgCmdList_replay(lxgContextPTR ctx, const lxgCmdList_t* lists, uint numLists)
+{
+  // the context does not track the index buffer binding
+  lxgBufferCPTR indexBuffer = NULL;
+  uint i;
+
+  lxgBuffer_bind(NULL,LUXGL_BUFFER_INDEX);
+  for (i = 0; i < numLists; i++){
+    lxgCmdList_replaySingle(ctx,&lists[i],&indexBuffer);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Validation
+
+static LUX_INLINE booln lxgCmdList_checkBinds(const lxgCmd_t* cmd, uint maxUnits)
+{
+  uint start = CMD_BINDSTART(cmd->arg);
+  uint num = CMD_BINDNUM(cmd->arg);
+
+  return num && start + num <= maxUnits &&
+    cmd->size == CMD_SIZE(sizeof(lxgCmd_t) + sizeof(void*) * num);
+}
+
+LUX_API booln lxgCmdList_validate(const lxgCmdList_t* list, lxgCmdStats_t* stats)
+{
+  const lxgCmd_t* cmd;
+  const void* program = NULL;
+  const void* decl = NULL;
+  const void* indexBuffer = NULL;
+  uint  errors = 0;
+
+  for (cmd = lxgCmdList_first(list); !lxgCmdList_isEnd(list,cmd); cmd = lxgCmdList_next(cmd)){
+    const lxgCmdObject_t* objcmd = (const lxgCmdObject_t*)cmd;
+    booln ok = LUX_TRUE;
+
+    // malformed commands stop the walk, the size cannot be trusted
+    if (cmd->size < sizeof(lxgCmd_t) || (cmd->size & (CMD_ALIGN - 1)) ||
+      cmd->size > (size_t)(list->cur - (const byte*)cmd) || cmd->type >= LUXGFX_CMDS)
+    {
+      errors++;
+      break;
+    }
+
+    stats->counts[cmd->type]++;
+    stats->numCmds++;
+    stats->bytes += cmd->size;
+
+    switch(cmd->type){
+    case LUXGFX_CMD_PROGRAM:
+      ok = cmd->size == CMD_SIZE(sizeof(lxgCmdObject_t)) && objcmd->obj;
+      program = objcmd->obj;
+      break;
+    case LUXGFX_CMD_PROGRAMPARAMS:
+      {
+        const lxgCmdParams_t* paramcmd = (const lxgCmdParams_t*)cmd;
+        const void** ptrs = (const void**)(paramcmd + 1);
+        uint i;
+        ok = cmd->size == CMD_SIZE(sizeof(lxgCmdParams_t) + sizeof(void*) * cmd->arg * 2) &&
+          paramcmd->prog && paramcmd->prog == program;
+        for (i = 0; ok && i < cmd->arg; i++){
+          ok = ptrs[i] != NULL;
+        }
+      }
+      break;
+    case LUXGFX_CMD_TEXTURES:
+    case LUXGFX_CMD_SAMPLERS:
+      ok = lxgCmdList_checkBinds(cmd,LUXGFX_MAX_TEXTURE_IMAGES);
+      break;
+    case LUXGFX_CMD_TEXTUREIMAGES:
+      ok = lxgCmdList_checkBinds(cmd,LUXGFX_MAX_RWTEXTURE_IMAGES);
+      break;
+    case LUXGFX_CMD_VERTEXDECL:
+      ok = cmd->size == CMD_SIZE(sizeof(lxgCmdObject_t)) && objcmd->obj;
+      decl = objcmd->obj;
+      break;
+    case LUXGFX_CMD_VERTEXSTREAM:
+      ok = cmd->size == CMD_SIZE(sizeof(lxgCmdStream_t)) && cmd->arg < LUXGFX_MAX_VERTEX_STREAMS;
+      break;
+    case LUXGFX_CMD_VERTEXATTRIBS:
+      ok = cmd->size == CMD_SIZE(sizeof(lxgCmd_t));
+      break;
+    case LUXGFX_CMD_INDEXBUFFER:
+      ok = cmd->size == CMD_SIZE(sizeof(lxgCmdObject_t));
+      indexBuffer = objcmd->obj;
+      break;
+    case LUXGFX_CMD_BLEND:
+    case LUXGFX_CMD_DEPTH:
+    case LUXGFX_CMD_LOGIC:
+    case LUXGFX_CMD_STENCIL:
+    case LUXGFX_CMD_COLOR:
+    case LUXGFX_CMD_RASTERIZER:
+      ok = cmd->size == CMD_SIZE(sizeof(lxgCmdObject_t)) && objcmd->obj;
+      break;
+    case LUXGFX_CMD_RENDERTARGET:
+      ok = cmd->size == CMD_SIZE(sizeof(lxgCmdObject_t)) && cmd->arg < LUXGFX_RENDERTARGETS;
+      break;
+    case LUXGFX_CMD_DRAW:
+      {
+        const lxgDrawCall_t* draw = &((const lxgCmdDraw_t*)cmd)->draw;
+        booln indexed = draw->indexType != LUX_SCALAR_ILLEGAL;
+        ok = cmd->size == CMD_SIZE(sizeof(lxgCmdDraw_t)) && program && decl &&
+          (!indexed || (indexBuffer &&
+          (draw->indexType == LUX_SCALAR_UINT8 || draw->indexType == LUX_SCALAR_UINT16 || draw->indexType == LUX_SCALAR_UINT32)));
+        stats->numDraws++;
+        stats->numElements += (uint64)draw->count * LUX_MAX(draw->instances,1);
+      }
+      break;
+    }
+
+    errors += ok ? 0 : 1;
+  }
+
+  stats->numErrors += errors;
+  return errors == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Optimization
+
+  // single object commands, indexed by command type
+#define OPT_OBJECTS   LUXGFX_CMDS
+
+typedef struct CmdOptState_s{
+  const void*       objs[OPT_OBJECTS];
+  const void*       textures[LUXGFX_MAX_TEXTURE_IMAGES];
+  const void*       samplers[LUXGFX_MAX_TEXTURE_IMAGES];
+  const void*       images[LUXGFX_MAX_RWTEXTURE_IMAGES];
+  const void*       rendertargets[LUXGFX_RENDERTARGETS];
+  lxgStreamHost_t   streams[LUXGFX_MAX_VERTEX_STREAMS];
+  flags32           attribs;
+}CmdOptState_t;
+
+typedef struct CmdOptimizer_s{
+    // what replay of the output has set, valid where known
+  CmdOptState_t     applied;
+    // latest values of the input
+  CmdOptState_t     pending;
+  flags32           knownObjs;
+  flags32           knownTextures;
+  flags32           knownSamplers;
+  flags32           knownImages;
+  flags32           knownTargets;
+  flags32           knownStreams;
+  booln             knownAttribs;
+    // set since the last flush
+  flags32           dirtyObjs;
+  flags32           dirtyTextures;
+  flags32           dirtySamplers;
+  flags32           dirtyImages;
+  flags32           dirtyTargets;
+  flags32           dirtyStreams;
+  booln             dirtyAttribs;
+  lxgCmdList_t*     dst;
+  lxgCmdOptStats_t* stats;
+}CmdOptimizer_t;
+
+static LUX_INLINE void CmdOpt_emitted(CmdOptimizer_t* opt, const lxgCmd_t* cmd)
+{
+  if (cmd && opt->stats){
+    opt->stats->countsOut[cmd->type]++;
+    opt->stats->numOut++;
+    opt->stats->bytesOut += cmd->size;
+  }
+}
+
+static void CmdOpt_flushObject(CmdOptimizer_t* opt, lxgCmdType_t type)
+{
+  flags32 bit = 1 << type;
+
+  if (opt->dirtyObjs & bit){
+    opt->dirtyObjs &= ~bit;
+    if (!(opt->knownObjs & bit) || opt->applied.objs[type] != opt->pending.objs[type]){
+      lxgCmdObject_t* cmd = (lxgCmdObject_t*)lxgCmdList_alloc(opt->dst,type,sizeof(lxgCmdObject_t),0);
+      if (cmd){
+        cmd->obj = opt->pending.objs[type];
+      }
+      CmdOpt_emitted(opt,(lxgCmd_t*)cmd);
+      opt->applied.objs[type] = opt->pending.objs[type];
+      opt->knownObjs |= bit;
+    }
+  }
+}
+
+  // runs of changed units become one ranged command each
+static void CmdOpt_flushBinds(CmdOptimizer_t* opt, lxgCmdType_t type, const void** applied, const void** pending,
+  flags32* known, flags32* dirty, uint numUnits)
+{
+  flags32 changed = 0;
+  uint    i;
+
+  if (!*dirty)
+    return;
+
+  for (i = 0; i < numUnits; i++){
+    flags32 bit = (flags32)1 << i;
+    if ((*dirty & bit) && (!(*known & bit) || applied[i] != pending[i])){
+      changed |= bit;
+    }
+  }
+
+  i = 0;
+  while (i < numUnits && (changed >> i)){
+    uint start;
+    lxgCmdBinds_t* cmd;
+
+    while (!(changed & ((flags32)1 << i))){
+      i++;
+    }
+    start = i;
+    while (i < numUnits && (changed & ((flags32)1 << i))){
+      applied[i] = pending[i];
+      i++;
+    }
+
+    cmd = (lxgCmdBinds_t*)lxgCmdList_alloc(opt->dst,type,
+      sizeof(lxgCmd_t) + sizeof(void*) * (i - start),CMD_BINDARG(start,i - start));
+    if (cmd){
+      memcpy((void*)cmd->objs,&pending[start],sizeof(void*) * (i - start));
+    }
+    CmdOpt_emitted(opt,(lxgCmd_t*)cmd);
+  }
+
+  *known |= changed;
+  *dirty = 0;
+}
+
+static void CmdOpt_flush(CmdOptimizer_t* opt)
+{
+  uint i;
+
+  for (i = 0; i < LUXGFX_RENDERTARGETS; i++){
+    flags32 bit = 1 << i;
+    if ((opt->dirtyTargets & bit) &&
+      (!(opt->knownTargets & bit) || opt->applied.rendertargets[i] != opt->pending.rendertargets[i]))
+    {
+      lxgCmdObject_t* cmd = (lxgCmdObject_t*)lxgCmdList_alloc(opt->dst,LUXGFX_CMD_RENDERTARGET,sizeof(lxgCmdObject_t),i);
+      if (cmd){
+        cmd->obj = opt->pending.rendertargets[i];
+      }
+      CmdOpt_emitted(opt,(lxgCmd_t*)cmd);
+      opt->applied.rendertargets[i] = opt->pending.rendertargets[i];
+      opt->knownTargets |= bit;
+    }
+  }
+  opt->dirtyTargets = 0;
+
+  CmdOpt_flushObject(opt,LUXGFX_CMD_PROGRAM);
+  CmdOpt_flushObject(opt,LUXGFX_CMD_BLEND);
+  CmdOpt_flushObject(opt,LUXGFX_CMD_DEPTH);
+  CmdOpt_flushObject(opt,LUXGFX_CMD_LOGIC);
+  CmdOpt_flushObject(opt,LUXGFX_CMD_STENCIL);
+  CmdOpt_flushObject(opt,LUXGFX_CMD_COLOR);
+  CmdOpt_flushObject(opt,LUXGFX_CMD_RASTERIZER);
+  CmdOpt_flushObject(opt,LUXGFX_CMD_VERTEXDECL);
+
+  if (opt->dirtyAttribs && (!opt->knownAttribs || opt->applied.attribs != opt->pending.attribs)){
+    CmdOpt_emitted(opt,(const lxgCmd_t*)lxgCmdList_alloc(opt->dst,LUXGFX_CMD_VERTEXATTRIBS,sizeof(lxgCmd_t),opt->pending.attribs));
+    opt->applied.attribs = opt->pending.attribs;
+    opt->knownAttribs = LUX_TRUE;
+  }
+  opt->dirtyAttribs = LUX_FALSE;
+
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    flags32 bit = 1 << i;
+    if ((opt->dirtyStreams & bit) && (!(opt->knownStreams & bit) ||
+      memcmp(&opt->applied.streams[i],&opt->pending.streams[i],sizeof(lxgStreamHost_t))))
+    {
+      lxgCmdStream_t* cmd = (lxgCmdStream_t*)lxgCmdList_alloc(opt->dst,LUXGFX_CMD_VERTEXSTREAM,sizeof(lxgCmdStream_t),i);
+      if (cmd){
+        cmd->host = opt->pending.streams[i];
+      }
+      CmdOpt_emitted(opt,(lxgCmd_t*)cmd);
+      opt->applied.streams[i] = opt->pending.streams[i];
+      opt->knownStreams |= bit;
+    }
+  }
+  opt->dirtyStreams = 0;
+
+  CmdOpt_flushObject(opt,LUXGFX_CMD_INDEXBUFFER);
+
+  // samplers before textures
+  CmdOpt_flushBinds(opt,LUXGFX_CMD_SAMPLERS,opt->applied.samplers,opt->pending.samplers,
+    &opt->knownSamplers,&opt->dirtySamplers,LUXGFX_MAX_TEXTURE_IMAGES);
+  CmdOpt_flushBinds(opt,LUXGFX_CMD_TEXTURES,opt->applied.textures,opt->pending.textures,
+    &opt->knownTextures,&opt->dirtyTextures,LUXGFX_MAX_TEXTURE_IMAGES);
+  CmdOpt_flushBinds(opt,LUXGFX_CMD_TEXTUREIMAGES,opt->applied.images,opt->pending.images,
+    &opt->knownImages,&opt->dirtyImages,LUXGFX_MAX_RWTEXTURE_IMAGES);
+}
+
+static LUX_INLINE void CmdOpt_setBinds(const lxgCmd_t* cmd, const void** pending, flags32* dirty)
+{
+  const lxgCmdBinds_t* bindcmd = (const lxgCmdBinds_t*)cmd;
+  uint start = CMD_BINDSTART(cmd->arg);
+  uint num = CMD_BINDNUM(cmd->arg);
+  uint i;
+
+  for (i = 0; i < num; i++){
+    pending[start + i] = bindcmd->objs[i];
+    *dirty |= (flags32)1 << (start + i);
+  }
+}
+
+static LUX_INLINE void CmdOpt_copy(CmdOptimizer_t* opt, const lxgCmd_t* cmd)
+{
+  lxgCmd_t* out = (lxgCmd_t*)lxgCmdList_alloc(opt->dst,(lxgCmdType_t)cmd->type,cmd->size,cmd->arg);
+  if (out){
+    memcpy(out + 1,cmd + 1,cmd->size - sizeof(lxgCmd_t));
+  }
+  CmdOpt_emitted(opt,out);
+}
+
+LUX_API booln lxgCmdList_optimize(lxgCmdList_t* dst, const lxgCmdList_t* src, lxgCmdOptStats_t* stats)
+{
+  CmdOptimizer_t opt;
+  const lxgCmd_t* cmd;
+
+  LUX_DEBUGASSERT(dst != src && dst->begin != src->begin);
+
+  memset(&opt,0,sizeof(opt));
+  opt.dst = dst;
+  opt.stats = stats;
+
+  for (cmd = lxgCmdList_first(src); !lxgCmdList_isEnd(src,cmd); cmd = lxgCmdList_next(cmd)){
+    const lxgCmdObject_t* objcmd = (const lxgCmdObject_t*)cmd;
+
+    if (stats){
+      stats->countsIn[cmd->type]++;
+      stats->numIn++;
+      stats->bytesIn += cmd->size;
+    }
+
+    switch(cmd->type){
+    case LUXGFX_CMD_PROGRAM:
+    case LUXGFX_CMD_VERTEXDECL:
+    case LUXGFX_CMD_INDEXBUFFER:
+    case LUXGFX_CMD_BLEND:
+    case LUXGFX_CMD_DEPTH:
+    case LUXGFX_CMD_LOGIC:
+    case LUXGFX_CMD_STENCIL:
+    case LUXGFX_CMD_COLOR:
+    case LUXGFX_CMD_RASTERIZER:
+      opt.pending.objs[cmd->type] = objcmd->obj;
+      opt.dirtyObjs |= 1 << cmd->type;
+      break;
+    case LUXGFX_CMD_PROGRAMPARAMS:
+      // parameters go to the current program
+      CmdOpt_flushObject(&opt,LUXGFX_CMD_PROGRAM);
+      CmdOpt_copy(&opt,cmd);
+      break;
+    case LUXGFX_CMD_TEXTURES:
+      CmdOpt_setBinds(cmd,opt.pending.textures,&opt.dirtyTextures);
+      break;
+    case LUXGFX_CMD_SAMPLERS:
+      CmdOpt_setBinds(cmd,opt.pending.samplers,&opt.dirtySamplers);
+      break;
+    case LUXGFX_CMD_TEXTUREIMAGES:
+      CmdOpt_setBinds(cmd,opt.pending.images,&opt.dirtyImages);
+      break;
+    case LUXGFX_CMD_VERTEXSTREAM:
+      opt.pending.streams[cmd->arg] = ((const lxgCmdStream_t*)cmd)->host;
+      opt.dirtyStreams |= 1 << cmd->arg;
+      break;
+    case LUXGFX_CMD_VERTEXATTRIBS:
+      opt.pending.attribs = cmd->arg;
+      opt.dirtyAttribs = LUX_TRUE;
+      break;
+    case LUXGFX_CMD_RENDERTARGET:
+      opt.pending.rendertargets[cmd->arg] = objcmd->obj;
+      opt.dirtyTargets |= 1 << cmd->arg;
+      break;
+    case LUXGFX_CMD_DRAW:
+      CmdOpt_flush(&opt);
+      CmdOpt_copy(&opt,cmd);
+      if (!dst->overflow){
+        dst->numDraws++;
+      }
+      break;
+    default:
+      LUX_DEBUGASSERT(0);
+      break;
+    }
+  }
+
+  // following lists may rely on the final state
+  CmdOpt_flush(&opt);
+
+  return !dst->overflow;
+}
@@ -0,0 +1,434 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxmath/quaternion.h>
+#include <luxinia/luxmath/fastmath.h>
+#include <luxinia/luxplatform/cpu.h>
+#include "quaternionsoa_defs.h"
+
+// below this 1-cos(theta) slerp falls back to linear weights
+#define QUATSOA_SLERP_EPSILON   (1.0e-5f)
+
+//////////////////////////////////////////////////////////////////////////
+// scalar helpers for remainders or non-SIMD builds
+
+static LUX_INLINE void QuatSoA_get(lxQuat q, lxQuatSoACPTR soa, uint i)
+{
+  q[0] = soa->x[i];
+  q[1] = soa->y[i];
+  q[2] = soa->z[i];
+  q[3] = soa->w[i];
+}
+
+static LUX_INLINE void QuatSoA_set(lxQuatSoAPTR soa, uint i, const lxQuat q)
+{
+  soa->x[i] = q[0];
+  soa->y[i] = q[1];
+  soa->z[i] = q[2];
+  soa->w[i] = q[3];
+}
+
+static void QuatSoA_mulScalar(lxQuatSoAPTR qout, lxQuatSoACPTR q2, lxQuatSoACPTR q1, uint from, uint count)
+{
+  lxQuat a, b, res;
+  uint i;
+  for (i = from; i < count; i++){
+    QuatSoA_get(a,q2,i);
+    QuatSoA_get(b,q1,i);
+    lxQuatMul(res,a,b);
+    QuatSoA_set(qout,i,res);
+  }
+}
+
+static void QuatSoA_normalizeScalar(lxQuatSoAPTR qout, lxQuatSoACPTR q, uint from, uint count)
+{
+  lxQuat res;
+  uint i;
+  for (i = from; i < count; i++){
+    QuatSoA_get(res,q,i);
+    lxQuatNormalized(res);
+    QuatSoA_set(qout,i,res);
+  }
+}
+
+static void QuatSoA_nlerpScalar(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint from, uint count)
+{
+  lxQuat a, b, res;
+  float s0, s1;
+  uint i;
+  for (i = from; i < count; i++){
+    QuatSoA_get(a,q1,i);
+    QuatSoA_get(b,q2,i);
+    s0 = 1.0f - t[i];
+    s1 = lxQuatDot(a,b) < 0.0f ? -t[i] : t[i];
+    res[0] = s0*a[0] + s1*b[0];
+    res[1] = s0*a[1] + s1*b[1];
+    res[2] = s0*a[2] + s1*b[2];
+    res[3] = s0*a[3] + s1*b[3];
+    lxQuatNormalized(res);
+    QuatSoA_set(qout,i,res);
+  }
+}
+
+static void QuatSoA_slerpScalar(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint from, uint count)
+{
+  lxQuat a, b, res;
+  uint i;
+  for (i = from; i < count; i++){
+    QuatSoA_get(a,q1,i);
+    QuatSoA_get(b,q2,i);
+    lxQuatSlerp(res,t[i],a,b);
+    QuatSoA_set(qout,i,res);
+  }
+}
+
+static void QuatSoA_toMatrixScalar(lxQuatSoACPTR q, lxMatrix44* matrices, uint from, uint count)
+{
+  lxQuat quat;
+  uint i;
+  for (i = from; i < count; i++){
+    float* mat = matrices[i];
+    QuatSoA_get(quat,q,i);
+    lxQuatToMatrix(quat,mat);
+    mat[3] = 0.0f;
+    mat[7] = 0.0f;
+    mat[11] = 0.0f;
+  }
+}
+
+#ifdef LUX_SIMD_SSE
+//////////////////////////////////////////////////////////////////////////
+// SSE
+//
+// With LUX_SIMD_AVX2 and a cpu supporting AVX, groups of eight are
+// processed by quaternionsoaavx.c first, the SSE loops handle what is
+// left. slerpFast stays 4-wide, lxFastSinCos_ps has no AVX version.
+
+#ifdef LUX_SIMD_AVX2
+static LUX_INLINE booln QuatSoA_useAVX()
+{
+  return (lxCPU_getFeatures() & LUX_CPU_AVX) != 0;
+}
+#endif
+
+typedef struct QuatSSE_s{
+  __m128  x;
+  __m128  y;
+  __m128  z;
+  __m128  w;
+}QuatSSE_t;
+
+static LUX_INLINE void QuatSSE_load(QuatSSE_t* out, lxQuatSoACPTR soa, uint i)
+{
+  out->x = _mm_load_ps(soa->x + i);
+  out->y = _mm_load_ps(soa->y + i);
+  out->z = _mm_load_ps(soa->z + i);
+  out->w = _mm_load_ps(soa->w + i);
+}
+
+static LUX_INLINE void QuatSSE_store(lxQuatSoAPTR soa, uint i, const QuatSSE_t* q)
+{
+  _mm_store_ps(soa->x + i, q->x);
+  _mm_store_ps(soa->y + i, q->y);
+  _mm_store_ps(soa->z + i, q->z);
+  _mm_store_ps(soa->w + i, q->w);
+}
+
+static LUX_INLINE __m128 QuatSSE_dot(const QuatSSE_t* a, const QuatSSE_t* b)
+{
+  return _mm_add_ps(
+    _mm_add_ps(_mm_mul_ps(a->x,b->x),_mm_mul_ps(a->y,b->y)),
+    _mm_add_ps(_mm_mul_ps(a->z,b->z),_mm_mul_ps(a->w,b->w)));
+}
+
+// rcp sqrt with one newton-raphson step
+static LUX_INLINE __m128 QuatSSE_rsqrt(__m128 v)
+{
+  const __m128 half   = _mm_set_ps1(0.5f);
+  const __m128 three  = _mm_set_ps1(3.0f);
+  __m128 r = _mm_rsqrt_ps(v);
+  return _mm_mul_ps(_mm_mul_ps(half,r),_mm_sub_ps(three,_mm_mul_ps(_mm_mul_ps(v,r),r)));
+}
+
+static LUX_INLINE void QuatSSE_normalize(QuatSSE_t* q)
+{
+  __m128 len2 = QuatSSE_dot(q,q);
+  // same epsilon as lxQuatNormalized
+  __m128 valid = _mm_cmpge_ps(len2,_mm_set_ps1(LUX_FLOAT_EPSILON*LUX_FLOAT_EPSILON));
+  __m128 inv = QuatSSE_rsqrt(len2);
+  inv = _mm_or_ps(_mm_and_ps(valid,inv),_mm_andnot_ps(valid,_mm_set_ps1(1.0f)));
+
+  q->x = _mm_mul_ps(q->x,inv);
+  q->y = _mm_mul_ps(q->y,inv);
+  q->z = _mm_mul_ps(q->z,inv);
+  q->w = _mm_mul_ps(q->w,inv);
+}
+
+// out = a*s0 + b*s1
+static LUX_INLINE void QuatSSE_blend(QuatSSE_t* out, const QuatSSE_t* a, __m128 s0, const QuatSSE_t* b, __m128 s1)
+{
+  out->x = _mm_add_ps(_mm_mul_ps(a->x,s0),_mm_mul_ps(b->x,s1));
+  out->y = _mm_add_ps(_mm_mul_ps(a->y,s0),_mm_mul_ps(b->y,s1));
+  out->z = _mm_add_ps(_mm_mul_ps(a->z,s0),_mm_mul_ps(b->z,s1));
+  out->w = _mm_add_ps(_mm_mul_ps(a->w,s0),_mm_mul_ps(b->w,s1));
+}
+
+// acos for x in [0,1]
+// Abramowitz & Stegun 4.4.46, |error| <= 2e-8
+static LUX_INLINE __m128 QuatSSE_acosPositive(__m128 x)
+{
+  __m128 poly = _mm_set_ps1(-0.0012624911f);
+  poly = _mm_add_ps(_mm_mul_ps(poly,x),_mm_set_ps1( 0.0066700901f));
+  poly = _mm_add_ps(_mm_mul_ps(poly,x),_mm_set_ps1(-0.0170881256f));
+  poly = _mm_add_ps(_mm_mul_ps(poly,x),_mm_set_ps1( 0.0308918810f));
+  poly = _mm_add_ps(_mm_mul_ps(poly,x),_mm_set_ps1(-0.0501743046f));
+  poly = _mm_add_ps(_mm_mul_ps(poly,x),_mm_set_ps1( 0.0889789874f));
+  poly = _mm_add_ps(_mm_mul_ps(poly,x),_mm_set_ps1(-0.2145988016f));
+  poly = _mm_add_ps(_mm_mul_ps(poly,x),_mm_set_ps1( 1.5707963050f));
+
+  return _mm_mul_ps(poly,_mm_sqrt_ps(_mm_sub_ps(_mm_set_ps1(1.0f),x)));
+}
+
+LUX_API void lxQuatSoA_mul(lxQuatSoAPTR qout, lxQuatSoACPTR q2, lxQuatSoACPTR q1, uint count)
+{
+  const __m128 half = _mm_set_ps1(0.5f);
+  uint simdcount = count & ~3;
+  uint i = 0;
+
+#ifdef LUX_SIMD_AVX2
+  if (QuatSoA_useAVX()){
+    i = AVXQuatSoA_mul(qout,q2,q1,count);
+  }
+#endif
+
+  for (; i < simdcount; i+=4){
+    QuatSSE_t a,b;
+    __m128 A,B,C,D,E,F,G,H;
+
+    QuatSSE_load(&a,q2,i);
+    QuatSSE_load(&b,q1,i);
+
+    // see lxQuatMul
+    A = _mm_mul_ps(_mm_add_ps(a.w,a.x),_mm_add_ps(b.w,b.x));
+    B = _mm_mul_ps(_mm_sub_ps(a.z,a.y),_mm_sub_ps(b.y,b.z));
+    C = _mm_mul_ps(_mm_sub_ps(a.w,a.x),_mm_add_ps(b.y,b.z));
+    D = _mm_mul_ps(_mm_add_ps(a.y,a.z),_mm_sub_ps(b.w,b.x));
+    E = _mm_mul_ps(_mm_add_ps(a.x,a.z),_mm_add_ps(b.x,b.y));
+    F = _mm_mul_ps(_mm_sub_ps(a.x,a.z),_mm_sub_ps(b.x,b.y));
+    G = _mm_mul_ps(_mm_add_ps(a.w,a.y),_mm_sub_ps(b.w,b.z));
+    H = _mm_mul_ps(_mm_sub_ps(a.w,a.y),_mm_add_ps(b.w,b.z));
+
+    a.x = _mm_sub_ps(A,_mm_mul_ps(_mm_add_ps(_mm_add_ps(E,F),_mm_add_ps(G,H)),half));
+    a.y = _mm_add_ps(C,_mm_mul_ps(_mm_sub_ps(_mm_add_ps(E,G),_mm_add_ps(F,H)),half));
+    a.z = _mm_add_ps(D,_mm_mul_ps(_mm_sub_ps(_mm_add_ps(E,H),_mm_add_ps(F,G)),half));
+    a.w = _mm_add_ps(B,_mm_mul_ps(_mm_sub_ps(_mm_add_ps(G,H),_mm_add_ps(E,F)),half));
+
+    QuatSSE_store(qout,i,&a);
+  }
+
+  QuatSoA_mulScalar(qout,q2,q1,simdcount,count);
+}
+
+LUX_API void lxQuatSoA_normalize(lxQuatSoAPTR qout, lxQuatSoACPTR q, uint count)
+{
+  uint simdcount = count & ~3;
+  uint i = 0;
+
+#ifdef LUX_SIMD_AVX2
+  if (QuatSoA_useAVX()){
+    i = AVXQuatSoA_normalize(qout,q,count);
+  }
+#endif
+
+  for (; i < simdcount; i+=4){
+    QuatSSE_t a;
+    QuatSSE_load(&a,q,i);
+    QuatSSE_normalize(&a);
+    QuatSSE_store(qout,i,&a);
+  }
+
+  QuatSoA_normalizeScalar(qout,q,simdcount,count);
+}
+
+LUX_API void lxQuatSoA_nlerp(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint count)
+{
+  const __m128 signmask = _mm_set_ps1(-0.0f);
+  const __m128 one = _mm_set_ps1(1.0f);
+  uint simdcount = count & ~3;
+  uint i = 0;
+
+#ifdef LUX_SIMD_AVX2
+  if (QuatSoA_useAVX()){
+    i = AVXQuatSoA_nlerp(qout,t,q1,q2,count);
+  }
+#endif
+
+  for (; i < simdcount; i+=4){
+    QuatSSE_t a,b,res;
+    __m128 s0,s1,cosom;
+
+    QuatSSE_load(&a,q1,i);
+    QuatSSE_load(&b,q2,i);
+    cosom = QuatSSE_dot(&a,&b);
+
+    s1 = _mm_loadu_ps(t + i);
+    s0 = _mm_sub_ps(one,s1);
+    // shortest path, flip sign of t where dot < 0
+    s1 = _mm_xor_ps(s1,_mm_and_ps(cosom,signmask));
+
+    QuatSSE_blend(&res,&a,s0,&b,s1);
+    QuatSSE_normalize(&res);
+    QuatSSE_store(qout,i,&res);
+  }
+
+  QuatSoA_nlerpScalar(qout,t,q1,q2,simdcount,count);
+}
+
+LUX_API void lxQuatSoA_slerpFast(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint count)
+{
+  const __m128 signmask = _mm_set_ps1(-0.0f);
+  const __m128 one = _mm_set_ps1(1.0f);
+  const __m128 eps = _mm_set_ps1(QUATSOA_SLERP_EPSILON);
+  uint simdcount = count & ~3;
+  uint i;
+
+  for (i = 0; i < simdcount; i+=4){
+    QuatSSE_t a,b,res;
+    __m128 tv,s0,s1,cosom,sign,omega,sinom,sint,cost,linear;
+
+    QuatSSE_load(&a,q1,i);
+    QuatSSE_load(&b,q2,i);
+    tv = _mm_loadu_ps(t + i);
+
+    cosom = QuatSSE_dot(&a,&b);
+    sign  = _mm_and_ps(cosom,signmask);
+    cosom = _mm_xor_ps(cosom,sign);
+    cosom = _mm_min_ps(cosom,one);
+
+    // sin((1-t)*omega) = sin(omega)*cos(t*omega) - cos(omega)*sin(t*omega)
+    // so a single sincos evaluation is enough
+    omega = QuatSSE_acosPositive(cosom);
+    sinom = _mm_sqrt_ps(_mm_sub_ps(one,_mm_mul_ps(cosom,cosom)));
+    sinom = _mm_div_ps(one,_mm_max_ps(sinom,eps));
+    lxFastSinCos_ps(_mm_mul_ps(tv,omega),&sint,&cost);
+
+    s1 = _mm_mul_ps(sint,sinom);
+    s0 = _mm_sub_ps(cost,_mm_mul_ps(cosom,s1));
+
+    // nearly identical quaternions use linear weights
+    linear = _mm_cmple_ps(_mm_sub_ps(one,cosom),eps);
+    s0 = _mm_or_ps(_mm_and_ps(linear,_mm_sub_ps(one,tv)),_mm_andnot_ps(linear,s0));
+    s1 = _mm_or_ps(_mm_and_ps(linear,tv),_mm_andnot_ps(linear,s1));
+    s1 = _mm_xor_ps(s1,sign);
+
+    QuatSSE_blend(&res,&a,s0,&b,s1);
+    QuatSSE_store(qout,i,&res);
+  }
+
+  QuatSoA_slerpScalar(qout,t,q1,q2,simdcount,count);
+}
+
+LUX_API void lxQuatSoA_toMatrix(lxQuatSoACPTR q, lxMatrix44* matrices, uint count)
+{
+  const __m128 one = _mm_set_ps1(1.0f);
+  uint simdcount = count & ~3;
+  uint i = 0;
+
+#ifdef LUX_SIMD_AVX2
+  if (QuatSoA_useAVX()){
+    i = AVXQuatSoA_toMatrix(q,matrices,count);
+  }
+#endif
+
+  for (; i < simdcount; i+=4){
+    QuatSSE_t a;
+    __m128 x2,y2,z2,xx,xy,xz,yy,yz,zz,wx,wy,wz;
+    __m128 c0x,c0y,c0z,c1x,c1y,c1z,c2x,c2y,c2z,c0w,c1w,c2w;
+
+    QuatSSE_load(&a,q,i);
+
+    x2 = _mm_add_ps(a.x,a.x);
+    y2 = _mm_add_ps(a.y,a.y);
+    z2 = _mm_add_ps(a.z,a.z);
+    xx = _mm_mul_ps(a.x,x2);
+    xy = _mm_mul_ps(a.x,y2);
+    xz = _mm_mul_ps(a.x,z2);
+    yy = _mm_mul_ps(a.y,y2);
+    yz = _mm_mul_ps(a.y,z2);
+    zz = _mm_mul_ps(a.z,z2);
+    wx = _mm_mul_ps(a.w,x2);
+    wy = _mm_mul_ps(a.w,y2);
+    wz = _mm_mul_ps(a.w,z2);
+
+    c0x = _mm_sub_ps(one,_mm_add_ps(yy,zz));
+    c0y = _mm_add_ps(xy,wz);
+    c0z = _mm_sub_ps(xz,wy);
+    c0w = _mm_setzero_ps();
+
+    c1x = _mm_sub_ps(xy,wz);
+    c1y = _mm_sub_ps(one,_mm_add_ps(xx,zz));
+    c1z = _mm_add_ps(yz,wx);
+    c1w = _mm_setzero_ps();
+
+    c2x = _mm_add_ps(xz,wy);
+    c2y = _mm_sub_ps(yz,wx);
+    c2z = _mm_sub_ps(one,_mm_add_ps(xx,yy));
+    c2w = _mm_setzero_ps();
+
+    // SoA -> AoS, afterwards cN* holds column N of matrices i+0..3
+    _MM_TRANSPOSE4_PS(c0x,c0y,c0z,c0w);
+    _MM_TRANSPOSE4_PS(c1x,c1y,c1z,c1w);
+    _MM_TRANSPOSE4_PS(c2x,c2y,c2z,c2w);
+
+    _mm_storeu_ps(matrices[i+0]+0,c0x);
+    _mm_storeu_ps(matrices[i+0]+4,c1x);
+    _mm_storeu_ps(matrices[i+0]+8,c2x);
+
+    _mm_storeu_ps(matrices[i+1]+0,c0y);
+    _mm_storeu_ps(matrices[i+1]+4,c1y);
+    _mm_storeu_ps(matrices[i+1]+8,c2y);
+
+    _mm_storeu_ps(matrices[i+2]+0,c0z);
+    _mm_storeu_ps(matrices[i+2]+4,c1z);
+    _mm_storeu_ps(matrices[i+2]+8,c2z);
+
+    _mm_storeu_ps(matrices[i+3]+0,c0w);
+    _mm_storeu_ps(matrices[i+3]+4,c1w);
+    _mm_storeu_ps(matrices[i+3]+8,c2w);
+  }
+
+  QuatSoA_toMatrixScalar(q,matrices,simdcount,count);
+}
+
+#else
+//////////////////////////////////////////////////////////////////////////
+// Regular
+
+LUX_API void lxQuatSoA_mul(lxQuatSoAPTR qout, lxQuatSoACPTR q2, lxQuatSoACPTR q1, uint count)
+{
+  QuatSoA_mulScalar(qout,q2,q1,0,count);
+}
+
+LUX_API void lxQuatSoA_normalize(lxQuatSoAPTR qout, lxQuatSoACPTR q, uint count)
+{
+  QuatSoA_normalizeScalar(qout,q,0,count);
+}
+
+LUX_API void lxQuatSoA_nlerp(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint count)
+{
+  QuatSoA_nlerpScalar(qout,t,q1,q2,0,count);
+}
+
+LUX_API void lxQuatSoA_slerpFast(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint count)
+{
+  QuatSoA_slerpScalar(qout,t,q1,q2,0,count);
+}
+
+LUX_API void lxQuatSoA_toMatrix(lxQuatSoACPTR q, lxMatrix44* matrices, uint count)
+{
+  QuatSoA_toMatrixScalar(q,matrices,0,count);
+}
+
+#endif
+
@@ -0,0 +1,28 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXMATH_QUATERNIONSOADEFS_H__
+#define __LUXMATH_QUATERNIONSOADEFS_H__
+
+#include <luxinia/luxmath/quaternion.h>
+
+//////////////////////////////////////////////////////////////////////////
+// AVX kernels (quaternionsoaavx.c)
+//
+// process eight quaternions per iteration, with the same order of
+// operations as the SSE path. Arrays need only the 16-byte alignment
+// of lxQuatSoA_t. Return the number of processed quaternions
+// (count & ~7), the caller handles the rest.
+// Their use must be checked at runtime (LUX_CPU_AVX).
+
+#ifdef LUX_SIMD_AVX2
+
+uint  AVXQuatSoA_mul(lxQuatSoAPTR qout, lxQuatSoACPTR q2, lxQuatSoACPTR q1, uint count);
+uint  AVXQuatSoA_normalize(lxQuatSoAPTR qout, lxQuatSoACPTR q, uint count);
+uint  AVXQuatSoA_nlerp(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint count);
+uint  AVXQuatSoA_toMatrix(lxQuatSoACPTR q, lxMatrix44* matrices, uint count);
+
+#endif
+
+#endif
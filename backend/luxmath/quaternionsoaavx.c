@@ -0,0 +1,249 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include "quaternionsoa_defs.h"
+
+#ifdef LUX_SIMD_AVX2
+
+#include <immintrin.h>
+
+//////////////////////////////////////////////////////////////////////////
+// Helpers
+
+typedef struct QuatAVX_s{
+  __m256  x;
+  __m256  y;
+  __m256  z;
+  __m256  w;
+}QuatAVX_t;
+
+static LUX_INLINE void QuatAVX_load(QuatAVX_t* out, lxQuatSoACPTR soa, uint i)
+{
+  out->x = _mm256_loadu_ps(soa->x + i);
+  out->y = _mm256_loadu_ps(soa->y + i);
+  out->z = _mm256_loadu_ps(soa->z + i);
+  out->w = _mm256_loadu_ps(soa->w + i);
+}
+
+static LUX_INLINE void QuatAVX_store(lxQuatSoAPTR soa, uint i, const QuatAVX_t* q)
+{
+  _mm256_storeu_ps(soa->x + i, q->x);
+  _mm256_storeu_ps(soa->y + i, q->y);
+  _mm256_storeu_ps(soa->z + i, q->z);
+  _mm256_storeu_ps(soa->w + i, q->w);
+}
+
+static LUX_INLINE __m256 QuatAVX_dot(const QuatAVX_t* a, const QuatAVX_t* b)
+{
+  return _mm256_add_ps(
+    _mm256_add_ps(_mm256_mul_ps(a->x,b->x),_mm256_mul_ps(a->y,b->y)),
+    _mm256_add_ps(_mm256_mul_ps(a->z,b->z),_mm256_mul_ps(a->w,b->w)));
+}
+
+// rcp sqrt with one newton-raphson step
+static LUX_INLINE __m256 QuatAVX_rsqrt(__m256 v)
+{
+  const __m256 half   = _mm256_set1_ps(0.5f);
+  const __m256 three  = _mm256_set1_ps(3.0f);
+  __m256 r = _mm256_rsqrt_ps(v);
+  return _mm256_mul_ps(_mm256_mul_ps(half,r),_mm256_sub_ps(three,_mm256_mul_ps(_mm256_mul_ps(v,r),r)));
+}
+
+static LUX_INLINE void QuatAVX_normalize(QuatAVX_t* q)
+{
+  __m256 len2 = QuatAVX_dot(q,q);
+  // same epsilon as lxQuatNormalized
+  __m256 valid = _mm256_cmp_ps(len2,_mm256_set1_ps(LUX_FLOAT_EPSILON*LUX_FLOAT_EPSILON),_CMP_GE_OQ);
+  __m256 inv = _mm256_blendv_ps(_mm256_set1_ps(1.0f),QuatAVX_rsqrt(len2),valid);
+
+  q->x = _mm256_mul_ps(q->x,inv);
+  q->y = _mm256_mul_ps(q->y,inv);
+  q->z = _mm256_mul_ps(q->z,inv);
+  q->w = _mm256_mul_ps(q->w,inv);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Kernels
+
+uint AVXQuatSoA_mul(lxQuatSoAPTR qout, lxQuatSoACPTR q2, lxQuatSoACPTR q1, uint count)
+{
+  const __m256 half = _mm256_set1_ps(0.5f);
+  uint simdcount = count & ~7;
+  uint i;
+
+  for (i = 0; i < simdcount; i+=8){
+    QuatAVX_t a,b;
+    __m256 A,B,C,D,E,F,G,H;
+
+    QuatAVX_load(&a,q2,i);
+    QuatAVX_load(&b,q1,i);
+
+    // see lxQuatMul
+    A = _mm256_mul_ps(_mm256_add_ps(a.w,a.x),_mm256_add_ps(b.w,b.x));
+    B = _mm256_mul_ps(_mm256_sub_ps(a.z,a.y),_mm256_sub_ps(b.y,b.z));
+    C = _mm256_mul_ps(_mm256_sub_ps(a.w,a.x),_mm256_add_ps(b.y,b.z));
+    D = _mm256_mul_ps(_mm256_add_ps(a.y,a.z),_mm256_sub_ps(b.w,b.x));
+    E = _mm256_mul_ps(_mm256_add_ps(a.x,a.z),_mm256_add_ps(b.x,b.y));
+    F = _mm256_mul_ps(_mm256_sub_ps(a.x,a.z),_mm256_sub_ps(b.x,b.y));
+    G = _mm256_mul_ps(_mm256_add_ps(a.w,a.y),_mm256_sub_ps(b.w,b.z));
+    H = _mm256_mul_ps(_mm256_sub_ps(a.w,a.y),_mm256_add_ps(b.w,b.z));
+
+    a.x = _mm256_sub_ps(A,_mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(E,F),_mm256_add_ps(G,H)),half));
+    a.y = _mm256_add_ps(C,_mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(E,G),_mm256_add_ps(F,H)),half));
+    a.z = _mm256_add_ps(D,_mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(E,H),_mm256_add_ps(F,G)),half));
+    a.w = _mm256_add_ps(B,_mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(G,H),_mm256_add_ps(E,F)),half));
+
+    QuatAVX_store(qout,i,&a);
+  }
+
+  _mm256_zeroupper();
+  return simdcount;
+}
+
+uint AVXQuatSoA_normalize(lxQuatSoAPTR qout, lxQuatSoACPTR q, uint count)
+{
+  uint simdcount = count & ~7;
+  uint i;
+
+  for (i = 0; i < simdcount; i+=8){
+    QuatAVX_t a;
+    QuatAVX_load(&a,q,i);
+    QuatAVX_normalize(&a);
+    QuatAVX_store(qout,i,&a);
+  }
+
+  _mm256_zeroupper();
+  return simdcount;
+}
+
+uint AVXQuatSoA_nlerp(lxQuatSoAPTR qout, const float* t, lxQuatSoACPTR q1, lxQuatSoACPTR q2, uint count)
+{
+  const __m256 signmask = _mm256_set1_ps(-0.0f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  uint simdcount = count & ~7;
+  uint i;
+
+  for (i = 0; i < simdcount; i+=8){
+    QuatAVX_t a,b,res;
+    __m256 s0,s1,cosom;
+
+    QuatAVX_load(&a,q1,i);
+    QuatAVX_load(&b,q2,i);
+    cosom = QuatAVX_dot(&a,&b);
+
+    s1 = _mm256_loadu_ps(t + i);
+    s0 = _mm256_sub_ps(one,s1);
+    // shortest path, flip sign of t where dot < 0
+    s1 = _mm256_xor_ps(s1,_mm256_and_ps(cosom,signmask));
+
+    res.x = _mm256_add_ps(_mm256_mul_ps(a.x,s0),_mm256_mul_ps(b.x,s1));
+    res.y = _mm256_add_ps(_mm256_mul_ps(a.y,s0),_mm256_mul_ps(b.y,s1));
+    res.z = _mm256_add_ps(_mm256_mul_ps(a.z,s0),_mm256_mul_ps(b.z,s1));
+    res.w = _mm256_add_ps(_mm256_mul_ps(a.w,s0),_mm256_mul_ps(b.w,s1));
+
+    QuatAVX_normalize(&res);
+    QuatAVX_store(qout,i,&res);
+  }
+
+  _mm256_zeroupper();
+  return simdcount;
+}
+
+uint AVXQuatSoA_toMatrix(lxQuatSoACPTR q, lxMatrix44* matrices, uint count)
+{
+  const __m256 one = _mm256_set1_ps(1.0f);
+  uint simdcount = count & ~7;
+  uint i;
+  uint h;
+
+  for (i = 0; i < simdcount; i+=8){
+    QuatAVX_t a;
+    __m256 x2,y2,z2,xx,xy,xz,yy,yz,zz,wx,wy,wz;
+    __m256 cols[9];
+
+    QuatAVX_load(&a,q,i);
+
+    x2 = _mm256_add_ps(a.x,a.x);
+    y2 = _mm256_add_ps(a.y,a.y);
+    z2 = _mm256_add_ps(a.z,a.z);
+    xx = _mm256_mul_ps(a.x,x2);
+    xy = _mm256_mul_ps(a.x,y2);
+    xz = _mm256_mul_ps(a.x,z2);
+    yy = _mm256_mul_ps(a.y,y2);
+    yz = _mm256_mul_ps(a.y,z2);
+    zz = _mm256_mul_ps(a.z,z2);
+    wx = _mm256_mul_ps(a.w,x2);
+    wy = _mm256_mul_ps(a.w,y2);
+    wz = _mm256_mul_ps(a.w,z2);
+
+    cols[0] = _mm256_sub_ps(one,_mm256_add_ps(yy,zz));
+    cols[1] = _mm256_add_ps(xy,wz);
+    cols[2] = _mm256_sub_ps(xz,wy);
+
+    cols[3] = _mm256_sub_ps(xy,wz);
+    cols[4] = _mm256_sub_ps(one,_mm256_add_ps(xx,zz));
+    cols[5] = _mm256_add_ps(yz,wx);
+
+    cols[6] = _mm256_add_ps(xz,wy);
+    cols[7] = _mm256_sub_ps(yz,wx);
+    cols[8] = _mm256_sub_ps(one,_mm256_add_ps(xx,yy));
+
+    // SoA -> AoS per 128-bit half, afterwards cN* holds
+    // column N of matrices i+h*4+0..3
+    for (h = 0; h < 2; h++){
+      __m128 c0x,c0y,c0z,c1x,c1y,c1z,c2x,c2y,c2z,c0w,c1w,c2w;
+
+      if (h){
+        c0x = _mm256_extractf128_ps(cols[0],1);
+        c0y = _mm256_extractf128_ps(cols[1],1);
+        c0z = _mm256_extractf128_ps(cols[2],1);
+        c1x = _mm256_extractf128_ps(cols[3],1);
+        c1y = _mm256_extractf128_ps(cols[4],1);
+        c1z = _mm256_extractf128_ps(cols[5],1);
+        c2x = _mm256_extractf128_ps(cols[6],1);
+        c2y = _mm256_extractf128_ps(cols[7],1);
+        c2z = _mm256_extractf128_ps(cols[8],1);
+      }
+      else{
+        c0x = _mm256_castps256_ps128(cols[0]);
+        c0y = _mm256_castps256_ps128(cols[1]);
+        c0z = _mm256_castps256_ps128(cols[2]);
+        c1x = _mm256_castps256_ps128(cols[3]);
+        c1y = _mm256_castps256_ps128(cols[4]);
+        c1z = _mm256_castps256_ps128(cols[5]);
+        c2x = _mm256_castps256_ps128(cols[6]);
+        c2y = _mm256_castps256_ps128(cols[7]);
+        c2z = _mm256_castps256_ps128(cols[8]);
+      }
+      c0w = _mm_setzero_ps();
+      c1w = _mm_setzero_ps();
+      c2w = _mm_setzero_ps();
+
+      _MM_TRANSPOSE4_PS(c0x,c0y,c0z,c0w);
+      _MM_TRANSPOSE4_PS(c1x,c1y,c1z,c1w);
+      _MM_TRANSPOSE4_PS(c2x,c2y,c2z,c2w);
+
+      _mm_storeu_ps(matrices[i+h*4+0]+0,c0x);
+      _mm_storeu_ps(matrices[i+h*4+0]+4,c1x);
+      _mm_storeu_ps(matrices[i+h*4+0]+8,c2x);
+
+      _mm_storeu_ps(matrices[i+h*4+1]+0,c0y);
+      _mm_storeu_ps(matrices[i+h*4+1]+4,c1y);
+      _mm_storeu_ps(matrices[i+h*4+1]+8,c2y);
+
+      _mm_storeu_ps(matrices[i+h*4+2]+0,c0z);
+      _mm_storeu_ps(matrices[i+h*4+2]+4,c1z);
+      _mm_storeu_ps(matrices[i+h*4+2]+8,c2z);
+
+      _mm_storeu_ps(matrices[i+h*4+3]+0,c0w);
+      _mm_storeu_ps(matrices[i+h*4+3]+4,c1w);
+      _mm_storeu_ps(matrices[i+h*4+3]+8,c2w);
+    }
+  }
+
+  _mm256_zeroupper();
+  return simdcount;
+}
+
+#endif
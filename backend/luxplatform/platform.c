@@ -3,14 +3,23 @@
 // See copyright notice in luxplatform.h
 
 #include <luxinia/luxplatform/debug.h>
+#include <luxinia/luxplatform/cpu.h>
 #include <stdarg.h>
 
 #ifdef LUX_PLATFORM_WINDOWS
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <unistd.h>
 #endif
 #include <signal.h>
 
+#if defined(LUX_COMPILER_MSC) && (defined(LUX_ARCH_X86) || defined(LUX_ARCH_X64))
+#include <intrin.h>
+#elif defined(LUX_COMPILER_GCC) && (defined(LUX_ARCH_X86) || defined(LUX_ARCH_X64))
+#include <cpuid.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 // Debug
 
@@ -175,4 +184,81 @@ LUX_API float PF_floatPass(float  val)
 #undef PF_longPass
 
 #undef PF_floatSwap
-#undef PF_floatPass
\ No newline at end of file
+#undef PF_floatPass
+
+//////////////////////////////////////////////////////////////////////////
+// CPU
+
+#if defined(LUX_ARCH_X86) || defined(LUX_ARCH_X64)
+static void PF_cpuid(int regs[4], int leaf)
+{
+#if defined(LUX_COMPILER_MSC)
+  __cpuidex(regs,leaf,0);
+#else
+  __cpuid_count(leaf,0,regs[0],regs[1],regs[2],regs[3]);
+#endif
+}
+
+static uint32 PF_xgetbv()
+{
+#if defined(LUX_COMPILER_MSC) && (_MSC_VER >= 1600)
+  return (uint32)_xgetbv(0);
+#elif defined(LUX_COMPILER_GCC)
+  uint32 eax;
+  uint32 edx;
+  __asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax;
+#else
+  return 0;
+#endif
+}
+#endif
+
+LUX_API uint32 lxCPU_getFeatures()
+{
+  static booln  queried = LUX_FALSE;
+  static uint32 features = 0;
+
+#if defined(LUX_ARCH_X86) || defined(LUX_ARCH_X64)
+  if (!queried){
+    int regs[4];
+    int maxleaf;
+    uint32 found = 0;
+    
+    PF_cpuid(regs,0);
+    maxleaf = regs[0];
+
+    PF_cpuid(regs,1);
+    found |= (regs[3] & (1<<26)) ? LUX_CPU_SSE2 : 0;
+    found |= (regs[2] & (1<<19)) ? LUX_CPU_SSE41 : 0;
+
+    // osxsave & avx, os must preserve xmm and ymm state
+    if ((regs[2] & (1<<27)) && (regs[2] & (1<<28)) && (PF_xgetbv() & 6) == 6){
+      found |= LUX_CPU_AVX;
+      found |= (regs[2] & (1<<12)) ? LUX_CPU_FMA : 0;
+
+      if (maxleaf >= 7){
+        PF_cpuid(regs,7);
+        found |= (regs[1] & (1<<5)) ? LUX_CPU_AVX2 : 0;
+      }
+    }
+
+    features = found;
+    queried = LUX_TRUE;
+  }
+#endif
+
+  return features;
+}
+
+LUX_API uint lxCPU_getCount()
+{
+#if defined(LUX_PLATFORM_WINDOWS)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (uint)info.dwNumberOfProcessors;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (uint)count : 1;
+#endif
+}
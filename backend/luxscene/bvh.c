@@ -0,0 +1,1002 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/bvh.h>
+#include <luxinia/luxmath/frustum.h>
+#include <luxinia/luxmath/vector4.h>
+#include <string.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+
+#define BVH_GATHER_CHUNK    16384
+#define BVH_MAX_DEFERRED    1024
+  // below this the subtrees are not worth a job
+#define BVH_MIN_DEFER       1024
+  // ray directions are clamped to avoid NaNs in the slab test
+#define BVH_DIR_EPSILON     1e-20f
+
+typedef struct BVHTask_s{
+  uint32    node;
+  uint32    start;
+  uint32    end;
+  uint32    depth;
+}BVHTask_t;
+
+typedef struct BVHSubtree_s{
+  BVHTask_t task;
+    // reserved range of nodes and actually used end
+  uint32    nodeBegin;
+  uint32    nodeEnd;
+  uint32    depth;
+}BVHSubtree_t;
+
+typedef struct BVHBuild_s{
+  lxBVHNode_t*      nodes;
+  uint32*           prims;
+    // primitive bounds, centroid is min + max
+  lxBoundingBox_t*  boxes;
+  uint32            maxLeafSize;
+    // gather input
+  const lxBoundingBox_t*  inBoxes;
+  size_t                  inStride;
+  const lxBVHTriangles_t* inTris;
+  uint32                  numPrims;
+    // deferred subtrees
+  BVHSubtree_t*     subtrees;
+  uint32            numSubtrees;
+  uint32            deferSize;
+}BVHBuild_t;
+
+typedef struct BVHBin_s{
+  lxBoundingBox_t bounds;
+  uint32          count;
+}BVHBin_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Primitives
+
+static LUX_INLINE void BVH_getTriangle(const lxBVHTriangles_t* tris, uint32 tri, const float* vertices[3])
+{
+  uint32  idx[3];
+  int     i;
+
+  if (!tris->indices){
+    idx[0] = tri * 3;
+    idx[1] = tri * 3 + 1;
+    idx[2] = tri * 3 + 2;
+  }
+  else if (tris->indexType == LUX_MESH_INDEX_UINT16){
+    const uint16* indices = ((const uint16*)tris->indices) + tri * 3;
+    idx[0] = indices[0];
+    idx[1] = indices[1];
+    idx[2] = indices[2];
+  }
+  else{
+    const uint32* indices = ((const uint32*)tris->indices) + tri * 3;
+    idx[0] = indices[0];
+    idx[1] = indices[1];
+    idx[2] = indices[2];
+  }
+
+  for (i = 0; i < 3; i++){
+    vertices[i] = (const float*)(((const byte*)tris->positions) + tris->posStride * idx[i]);
+  }
+}
+
+static LUX_INLINE void BVH_getTriangleBox(const lxBVHTriangles_t* tris, uint32 tri, float minb[3], float maxb[3])
+{
+  const float* vertices[3];
+  int c;
+
+  BVH_getTriangle(tris,tri,vertices);
+  for (c = 0; c < 3; c++){
+    minb[c] = LUX_MIN(LUX_MIN(vertices[0][c],vertices[1][c]),vertices[2][c]);
+    maxb[c] = LUX_MAX(LUX_MAX(vertices[0][c],vertices[1][c]),vertices[2][c]);
+  }
+}
+
+static LUX_INLINE const lxBoundingBox_t* BVH_getBox(const lxBoundingBox_t* boxes, size_t boxStride, uint32 idx)
+{
+  return (const lxBoundingBox_t*)(((const byte*)boxes) + boxStride * idx);
+}
+
+static LUX_INLINE float BVH_area(const float minb[3], const float maxb[3])
+{
+  float x = maxb[0] - minb[0];
+  float y = maxb[1] - minb[1];
+  float z = maxb[2] - minb[2];
+  return x * y + y * z + z * x;
+}
+
+static LUX_INLINE void BVH_initBounds(float minb[3], float maxb[3])
+{
+  minb[0] = minb[1] = minb[2] = FLT_MAX;
+  maxb[0] = maxb[1] = maxb[2] = -FLT_MAX;
+}
+
+static LUX_INLINE void BVH_addBounds(float minb[3], float maxb[3], const float addmin[3], const float addmax[3])
+{
+  int c;
+  for (c = 0; c < 3; c++){
+    minb[c] = LUX_MIN(minb[c],addmin[c]);
+    maxb[c] = LUX_MAX(maxb[c],addmax[c]);
+  }
+}
+
+  // w is unused, so boxes can be processed as vectors
+static LUX_INLINE void BVH_initBox(lxBoundingBox_t* box)
+{
+  lxVector4Set(box->min,FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX);
+  lxVector4Set(box->max,-FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX);
+}
+
+static LUX_INLINE void BVH_addBox(lxBoundingBox_t* box, const lxBoundingBox_t* add)
+{
+#ifdef LUX_SIMD_SSE
+  _mm_storeu_ps(box->min,_mm_min_ps(_mm_loadu_ps(box->min),_mm_loadu_ps(add->min)));
+  _mm_storeu_ps(box->max,_mm_max_ps(_mm_loadu_ps(box->max),_mm_loadu_ps(add->max)));
+#else
+  BVH_addBounds(box->min,box->max,add->min,add->max);
+#endif
+}
+
+static void BVH_gatherJob(void* userdata, uint jobindex, uint threadindex)
+{
+  BVHBuild_t* build = (BVHBuild_t*)userdata;
+  uint32  begin = jobindex * BVH_GATHER_CHUNK;
+  uint32  end = LUX_MIN(begin + BVH_GATHER_CHUNK,build->numPrims);
+  uint32  i;
+
+  for (i = begin; i < end; i++){
+    lxBoundingBox_t* box = &build->boxes[i];
+
+    if (build->inTris){
+      BVH_getTriangleBox(build->inTris,i,box->min,box->max);
+    }
+    else{
+      const lxBoundingBox_t* in = BVH_getBox(build->inBoxes,build->inStride,i);
+      box->min[0] = in->min[0];
+      box->min[1] = in->min[1];
+      box->min[2] = in->min[2];
+      box->max[0] = in->max[0];
+      box->max[1] = in->max[1];
+      box->max[2] = in->max[2];
+    }
+    box->min[3] = 0.0f;
+    box->max[3] = 0.0f;
+    build->prims[i] = i;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Build
+
+static LUX_INLINE float BVH_centroid(const BVHBuild_t* build, uint32 prim, int axis)
+{
+  const lxBoundingBox_t* box = &build->boxes[prim];
+  return box->min[axis] + box->max[axis];
+}
+
+  // object median, rearranges prims so that mid splits them on axis
+static void BVH_select(BVHBuild_t* build, int start, int end, int mid, int axis)
+{
+  uint32* prims = build->prims;
+
+  while (end - start > 1){
+    float pivot = BVH_centroid(build,prims[start + (end - start) / 2],axis);
+    int   lo = start;
+    int   hi = end - 1;
+
+    while (lo <= hi){
+      while (BVH_centroid(build,prims[lo],axis) < pivot) lo++;
+      while (BVH_centroid(build,prims[hi],axis) > pivot) hi--;
+      if (lo <= hi){
+        uint32 tmp = prims[lo];
+        prims[lo] = prims[hi];
+        prims[hi] = tmp;
+        lo++;
+        hi--;
+      }
+    }
+
+    if (mid <= hi){
+      end = hi + 1;
+    }
+    else if (mid >= lo){
+      start = lo;
+    }
+    else{
+      break;
+    }
+  }
+}
+
+static void BVH_computeBounds(const BVHBuild_t* build, uint32 start, uint32 end, lxBoundingBox_t* bounds)
+{
+  uint32 i;
+
+  BVH_initBox(bounds);
+  for (i = start; i < end; i++){
+    BVH_addBox(bounds,&build->boxes[build->prims[i]]);
+  }
+}
+
+static LUX_INLINE void BVH_getBinIndices(int bins[3], const lxBoundingBox_t* box, const lxBoundingBox_t* centroids, const float scale[4], int numBins)
+{
+  float pos[4];
+  int   a;
+
+#ifdef LUX_SIMD_SSE
+  _mm_storeu_ps(pos,_mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(box->min),_mm_loadu_ps(box->max)),
+    _mm_loadu_ps(centroids->min)),_mm_loadu_ps(scale)));
+#else
+  for (a = 0; a < 3; a++){
+    pos[a] = (box->min[a] + box->max[a] - centroids->min[a]) * scale[a];
+  }
+#endif
+  for (a = 0; a < 3; a++){
+    bins[a] = LUX_MIN((int)pos[a],numBins - 1);
+  }
+}
+
+  // returns split position, or start if the node should be a leaf
+static uint32 BVH_split(BVHBuild_t* build, const BVHTask_t* task, lxBoundingBox_t children[2])
+{
+  const lxBVHNode_t* node = &build->nodes[task->node];
+  uint32* prims = build->prims;
+  uint32  count = task->end - task->start;
+  lxBoundingBox_t centroids;
+  float   scale[4];
+  int     bestAxis = -1;
+  int     bestBin = 0;
+  float   bestCost = FLT_MAX;
+  uint32  mid;
+  uint32  i;
+  int     a,b;
+
+  if (count <= 1)
+    return task->start;
+
+  // centroid bounds, centroids are min + max
+  BVH_initBox(&centroids);
+  for (i = task->start; i < task->end; i++){
+    const lxBoundingBox_t* box = &build->boxes[prims[i]];
+#ifdef LUX_SIMD_SSE
+    __m128 c = _mm_add_ps(_mm_loadu_ps(box->min),_mm_loadu_ps(box->max));
+    _mm_storeu_ps(centroids.min,_mm_min_ps(_mm_loadu_ps(centroids.min),c));
+    _mm_storeu_ps(centroids.max,_mm_max_ps(_mm_loadu_ps(centroids.max),c));
+#else
+    for (a = 0; a < 3; a++){
+      float c = box->min[a] + box->max[a];
+      centroids.min[a] = LUX_MIN(centroids.min[a],c);
+      centroids.max[a] = LUX_MAX(centroids.max[a],c);
+    }
+#endif
+  }
+
+  if (task->depth < LUX_BVH_MAX_DEPTH / 2){
+    // small nodes use fewer bins
+    int       numBins = (int)LUX_MIN(count,LUX_BVH_BINS);
+    BVHBin_t  bins[3][LUX_BVH_BINS];
+    float     rightArea[LUX_BVH_BINS];
+    uint32    rightCount[LUX_BVH_BINS];
+    int       idx[3];
+
+    scale[3] = 0.0f;
+    for (a = 0; a < 3; a++){
+      float extent = centroids.max[a] - centroids.min[a];
+      scale[a] = extent > 0.0f ? (float)numBins * 0.9999f / extent : 0.0f;
+      for (b = 0; b < numBins; b++){
+        BVH_initBox(&bins[a][b].bounds);
+        bins[a][b].count = 0;
+      }
+    }
+
+    for (i = task->start; i < task->end; i++){
+      const lxBoundingBox_t* box = &build->boxes[prims[i]];
+      BVH_getBinIndices(idx,box,&centroids,scale,numBins);
+      for (a = 0; a < 3; a++){
+        BVHBin_t* bin = &bins[a][idx[a]];
+        BVH_addBox(&bin->bounds,box);
+        bin->count++;
+      }
+    }
+
+    for (a = 0; a < 3; a++){
+      lxBoundingBox_t bounds;
+      uint32  leftCount = 0;
+
+      if (scale[a] == 0.0f)
+        continue;
+
+      BVH_initBox(&bounds);
+      for (b = numBins - 1; b > 0; b--){
+        const BVHBin_t* bin = &bins[a][b];
+        if (bin->count){
+          BVH_addBox(&bounds,&bin->bounds);
+        }
+        rightCount[b] = (b < numBins - 1 ? rightCount[b+1] : 0) + bin->count;
+        rightArea[b] = rightCount[b] ? BVH_area(bounds.min,bounds.max) : 0.0f;
+      }
+
+      BVH_initBox(&bounds);
+      for (b = 0; b < numBins - 1; b++){
+        const BVHBin_t* bin = &bins[a][b];
+        float cost;
+
+        if (bin->count){
+          BVH_addBox(&bounds,&bin->bounds);
+        }
+        leftCount += bin->count;
+        if (!leftCount || !rightCount[b+1])
+          continue;
+
+        cost = BVH_area(bounds.min,bounds.max) * (float)leftCount + rightArea[b+1] * (float)rightCount[b+1];
+        if (cost < bestCost){
+          bestCost = cost;
+          bestAxis = a;
+          bestBin = b;
+        }
+      }
+    }
+
+    if (bestAxis >= 0){
+      // traversal and intersection cost are 1
+      float nodeArea = BVH_area(node->min,node->max);
+      float splitCost = 1.0f + (nodeArea > 0.0f ? bestCost / nodeArea : 0.0f);
+      uint32 lo = task->start;
+      uint32 hi = task->end;
+
+      if (count <= build->maxLeafSize && splitCost >= (float)count)
+        return task->start;
+
+      // child bounds are taken from the partition itself, so that
+      // they are exact even if the bin index rounds differently
+      BVH_initBox(&children[0]);
+      BVH_initBox(&children[1]);
+      while (lo < hi){
+        const lxBoundingBox_t* box = &build->boxes[prims[lo]];
+        BVH_getBinIndices(idx,box,&centroids,scale,numBins);
+        if (idx[bestAxis] <= bestBin){
+          BVH_addBox(&children[0],box);
+          lo++;
+        }
+        else{
+          uint32 tmp = prims[lo];
+          BVH_addBox(&children[1],box);
+          prims[lo] = prims[--hi];
+          prims[hi] = tmp;
+        }
+      }
+
+      if (lo != task->start && lo != task->end)
+        return lo;
+    }
+  }
+
+  if (count <= build->maxLeafSize)
+    return task->start;
+
+  // median of the largest centroid extent, also used for
+  // identical centroids and deep trees
+  bestAxis = 0;
+  for (a = 1; a < 3; a++){
+    if (centroids.max[a] - centroids.min[a] > centroids.max[bestAxis] - centroids.min[bestAxis]){
+      bestAxis = a;
+    }
+  }
+  mid = task->start + count / 2;
+  BVH_select(build,(int)task->start,(int)task->end,(int)mid,bestAxis);
+  BVH_computeBounds(build,task->start,mid,&children[0]);
+  BVH_computeBounds(build,mid,task->end,&children[1]);
+
+  return mid;
+}
+
+  // splits all tasks of the stack, tasks smaller than deferSize are
+  // moved to the subtrees if there is room.
+  // returns maximum depth
+static uint32 BVH_buildTasks(BVHBuild_t* build, BVHTask_t* stack, uint32* nodeCounter, booln defer)
+{
+  uint32  maxDepth = 0;
+  int     sp = 1;
+
+  while (sp){
+    BVHTask_t     task = stack[--sp];
+    lxBVHNode_t*  node = &build->nodes[task.node];
+    lxBoundingBox_t children[2];
+    BVHTask_t     tasks[2];
+    uint32        split;
+    int           i;
+
+    maxDepth = LUX_MAX(maxDepth,task.depth);
+
+    split = BVH_split(build,&task,children);
+    if (split == task.start){
+      node->first = task.start;
+      node->count = task.end - task.start;
+      continue;
+    }
+
+    node->first = *nodeCounter;
+    node->count = 0;
+    *nodeCounter += 2;
+
+    tasks[0].start = task.start;
+    tasks[0].end = split;
+    tasks[1].start = split;
+    tasks[1].end = task.end;
+
+    // right is pushed first, so that left follows its parent
+    for (i = 1; i >= 0; i--){
+      lxBVHNode_t* child = &build->nodes[node->first + i];
+
+      memcpy(child->min,children[i].min,sizeof(float) * 3);
+      memcpy(child->max,children[i].max,sizeof(float) * 3);
+      child->first = 0;
+      child->count = 0;
+
+      tasks[i].node = node->first + i;
+      tasks[i].depth = task.depth + 1;
+
+      if (defer && tasks[i].end - tasks[i].start <= build->deferSize &&
+          build->numSubtrees < BVH_MAX_DEFERRED)
+      {
+        build->subtrees[build->numSubtrees++].task = tasks[i];
+      }
+      else{
+        stack[sp++] = tasks[i];
+      }
+    }
+  }
+
+  return maxDepth;
+}
+
+static void BVH_subtreeJob(void* userdata, uint jobindex, uint threadindex)
+{
+  BVHBuild_t*   build = (BVHBuild_t*)userdata;
+  BVHSubtree_t* subtree = &build->subtrees[jobindex];
+  BVHTask_t     stack[LUX_BVH_MAX_DEPTH + 2];
+  uint32        nodeCounter = subtree->nodeBegin;
+
+  stack[0] = subtree->task;
+  subtree->depth = BVH_buildTasks(build,stack,&nodeCounter,LUX_FALSE);
+  subtree->nodeEnd = nodeCounter;
+}
+
+static int BVH_compareSubtrees(const void* a, const void* b)
+{
+  const BVHSubtree_t* sa = (const BVHSubtree_t*)a;
+  const BVHSubtree_t* sb = (const BVHSubtree_t*)b;
+  uint32 ca = sa->task.end - sa->task.start;
+  uint32 cb = sb->task.end - sb->task.start;
+
+  // larger first, for better balance of the jobs
+  return ca > cb ? -1 : (ca < cb ? 1 : (int)sa->task.node - (int)sb->task.node);
+}
+
+static booln BVH_build(lxBVH_t* bvh, lxJobPoolPTR pool, BVHBuild_t* build, uint32 numPrims, int maxLeafSize)
+{
+  lxMemoryAllocatorPTR allocator = bvh->allocator;
+  uint32  maxNodes = numPrims ? numPrims * 2 - 1 : 0;
+  uint32  threads = pool ? lxJobPool_getThreadCount(pool) : 1;
+  BVHTask_t stack[LUX_BVH_MAX_DEPTH + 2];
+  uint32  nodeCounter;
+  uint32  writeNode;
+  uint32  i;
+
+  bvh->numNodes = 0;
+  bvh->numPrims = 0;
+  bvh->depth = 0;
+
+  if (!numPrims)
+    return LUX_FALSE;
+  if (numPrims > 0x7FFFFFFF)
+    return LUX_TRUE;
+
+  if (bvh->numNodesAllocated < maxNodes){
+    if (bvh->nodes){
+      lxMemoryAllocator_freeAligned(allocator,bvh->nodes,sizeof(lxBVHNode_t) * bvh->numNodesAllocated);
+    }
+    bvh->nodes = (lxBVHNode_t*)lxMemoryAllocator_mallocAligned(allocator,sizeof(lxBVHNode_t) * maxNodes,64);
+    bvh->numNodesAllocated = bvh->nodes ? maxNodes : 0;
+  }
+  if (bvh->numPrimsAllocated < numPrims){
+    if (bvh->prims){
+      lxMemoryAllocator_free(allocator,bvh->prims,sizeof(uint32) * bvh->numPrimsAllocated);
+    }
+    bvh->prims = (uint32*)lxMemoryAllocator_malloc(allocator,sizeof(uint32) * numPrims);
+    bvh->numPrimsAllocated = bvh->prims ? numPrims : 0;
+  }
+
+  build->boxes = (lxBoundingBox_t*)lxMemoryAllocator_mallocAligned(allocator,sizeof(lxBoundingBox_t) * numPrims,16);
+  build->subtrees = (BVHSubtree_t*)lxMemoryAllocator_malloc(allocator,sizeof(BVHSubtree_t) * BVH_MAX_DEFERRED);
+  if (!bvh->nodes || !bvh->prims || !build->boxes || !build->subtrees){
+    if (build->boxes){
+      lxMemoryAllocator_freeAligned(allocator,build->boxes,sizeof(lxBoundingBox_t) * numPrims);
+    }
+    if (build->subtrees){
+      lxMemoryAllocator_free(allocator,build->subtrees,sizeof(BVHSubtree_t) * BVH_MAX_DEFERRED);
+    }
+    return LUX_TRUE;
+  }
+
+  build->nodes = bvh->nodes;
+  build->prims = bvh->prims;
+  build->numPrims = numPrims;
+  build->maxLeafSize = maxLeafSize > 0 ? maxLeafSize : LUX_BVH_LEAFSIZE;
+  build->numSubtrees = 0;
+  build->deferSize = threads > 1 ? LUX_MAX(numPrims / (threads * 8),BVH_MIN_DEFER) : 0;
+
+  lxJobPool_run(pool,(numPrims + BVH_GATHER_CHUNK - 1) / BVH_GATHER_CHUNK,BVH_gatherJob,build);
+
+  // root
+  {
+    lxBoundingBox_t bounds;
+    BVH_computeBounds(build,0,numPrims,&bounds);
+    memcpy(bvh->nodes[0].min,bounds.min,sizeof(float) * 3);
+    memcpy(bvh->nodes[0].max,bounds.max,sizeof(float) * 3);
+  }
+  stack[0].node = 0;
+  stack[0].start = 0;
+  stack[0].end = numPrims;
+  stack[0].depth = 0;
+  nodeCounter = 1;
+
+  if (build->deferSize && numPrims > build->deferSize){
+    bvh->depth = BVH_buildTasks(build,stack,&nodeCounter,LUX_TRUE);
+
+    // reserve nodes below each subtree root
+    qsort(build->subtrees,build->numSubtrees,sizeof(BVHSubtree_t),BVH_compareSubtrees);
+    writeNode = nodeCounter;
+    for (i = 0; i < build->numSubtrees; i++){
+      BVHSubtree_t* subtree = &build->subtrees[i];
+      subtree->nodeBegin = writeNode;
+      writeNode += (subtree->task.end - subtree->task.start) * 2 - 2;
+    }
+
+    lxJobPool_run(pool,build->numSubtrees,BVH_subtreeJob,build);
+
+    // compact the reserved ranges
+    writeNode = nodeCounter;
+    for (i = 0; i < build->numSubtrees; i++){
+      BVHSubtree_t* subtree = &build->subtrees[i];
+      lxBVHNode_t*  root = &bvh->nodes[subtree->task.node];
+      uint32  used = subtree->nodeEnd - subtree->nodeBegin;
+      uint32  shift = subtree->nodeBegin - writeNode;
+      uint32  n;
+
+      bvh->depth = LUX_MAX(bvh->depth,subtree->depth);
+      if (!used)
+        continue;
+
+      if (shift){
+        memmove(&bvh->nodes[writeNode],&bvh->nodes[subtree->nodeBegin],sizeof(lxBVHNode_t) * used);
+        for (n = writeNode; n < writeNode + used; n++){
+          if (!bvh->nodes[n].count){
+            bvh->nodes[n].first -= shift;
+          }
+        }
+        root->first -= shift;
+      }
+      writeNode += used;
+    }
+    nodeCounter = writeNode;
+  }
+  else{
+    bvh->depth = BVH_buildTasks(build,stack,&nodeCounter,LUX_FALSE);
+  }
+
+  bvh->numNodes = nodeCounter;
+  bvh->numPrims = numPrims;
+
+  lxMemoryAllocator_freeAligned(allocator,build->boxes,sizeof(lxBoundingBox_t) * numPrims);
+  lxMemoryAllocator_free(allocator,build->subtrees,sizeof(BVHSubtree_t) * BVH_MAX_DEFERRED);
+
+  return LUX_FALSE;
+}
+
+LUX_API void lxBVH_init(lxBVH_t* bvh, lxMemoryAllocatorPTR allocator)
+{
+  memset(bvh,0,sizeof(lxBVH_t));
+  bvh->allocator = allocator;
+}
+
+LUX_API void lxBVH_deinit(lxBVH_t* bvh)
+{
+  if (bvh->nodes){
+    lxMemoryAllocator_freeAligned(bvh->allocator,bvh->nodes,sizeof(lxBVHNode_t) * bvh->numNodesAllocated);
+  }
+  if (bvh->prims){
+    lxMemoryAllocator_free(bvh->allocator,bvh->prims,sizeof(uint32) * bvh->numPrimsAllocated);
+  }
+  lxBVH_init(bvh,bvh->allocator);
+}
+
+LUX_API booln lxBVH_buildBoxes(lxBVH_t* bvh, lxJobPoolPTR pool, const lxBoundingBox_t* boxes, size_t boxStride, uint32 numBoxes, int maxLeafSize)
+{
+  BVHBuild_t build;
+
+  memset(&build,0,sizeof(BVHBuild_t));
+  build.inBoxes = boxes;
+  build.inStride = boxStride;
+
+  return BVH_build(bvh,pool,&build,numBoxes,maxLeafSize);
+}
+
+LUX_API booln lxBVH_buildTriangles(lxBVH_t* bvh, lxJobPoolPTR pool, const lxBVHTriangles_t* tris, int maxLeafSize)
+{
+  BVHBuild_t build;
+
+  memset(&build,0,sizeof(BVHBuild_t));
+  build.inTris = tris;
+
+  return BVH_build(bvh,pool,&build,tris->numTriangles,maxLeafSize);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Refit
+
+  // children are always after their parent
+static void BVH_refitInner(lxBVH_t* bvh, uint32 node)
+{
+  lxBVHNode_t* cur = &bvh->nodes[node];
+  const lxBVHNode_t* left = &bvh->nodes[cur->first];
+  const lxBVHNode_t* right = left + 1;
+  int c;
+
+  for (c = 0; c < 3; c++){
+    cur->min[c] = LUX_MIN(left->min[c],right->min[c]);
+    cur->max[c] = LUX_MAX(left->max[c],right->max[c]);
+  }
+}
+
+LUX_API void lxBVH_refitBoxes(lxBVH_t* bvh, const lxBoundingBox_t* boxes, size_t boxStride)
+{
+  uint32 n = bvh->numNodes;
+
+  while (n--){
+    lxBVHNode_t* node = &bvh->nodes[n];
+    uint32 i;
+
+    if (!node->count){
+      BVH_refitInner(bvh,n);
+      continue;
+    }
+
+    BVH_initBounds(node->min,node->max);
+    for (i = node->first; i < node->first + node->count; i++){
+      const lxBoundingBox_t* box = BVH_getBox(boxes,boxStride,bvh->prims[i]);
+      BVH_addBounds(node->min,node->max,box->min,box->max);
+    }
+  }
+}
+
+LUX_API void lxBVH_refitTriangles(lxBVH_t* bvh, const lxBVHTriangles_t* tris)
+{
+  uint32 n = bvh->numNodes;
+
+  while (n--){
+    lxBVHNode_t* node = &bvh->nodes[n];
+    uint32 i;
+
+    if (!node->count){
+      BVH_refitInner(bvh,n);
+      continue;
+    }
+
+    BVH_initBounds(node->min,node->max);
+    for (i = node->first; i < node->first + node->count; i++){
+      float minb[3];
+      float maxb[3];
+      BVH_getTriangleBox(tris,bvh->prims[i],minb,maxb);
+      BVH_addBounds(node->min,node->max,minb,maxb);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Ray
+
+typedef struct BVHRay_s{
+#ifdef LUX_SIMD_SSE
+  __m128    origin4;
+  __m128    invDir4;
+  __m128    mask4;
+#endif
+  lxVector3 origin;
+  lxVector3 dir;
+  lxVector3 invDir;
+}BVHRay_t;
+
+typedef struct BVHStackEntry_s{
+  uint32    node;
+  float     tnear;
+}BVHStackEntry_t;
+
+static void BVH_initRay(BVHRay_t* ray, const lxVector3 origin, const lxVector3 dir)
+{
+  int c;
+
+  for (c = 0; c < 3; c++){
+    float d = dir[c];
+    if (fabsf(d) < BVH_DIR_EPSILON){
+      d = d < 0.0f ? -BVH_DIR_EPSILON : BVH_DIR_EPSILON;
+    }
+    ray->origin[c] = origin[c];
+    ray->dir[c] = dir[c];
+    ray->invDir[c] = 1.0f / d;
+  }
+
+#ifdef LUX_SIMD_SSE
+  {
+    static const union { uint32 u[4]; __m128 v; } mask = {{0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFFF,0}};
+    ray->mask4 = mask.v;
+    ray->origin4 = _mm_set_ps(0.0f,origin[2],origin[1],origin[0]);
+    ray->invDir4 = _mm_set_ps(0.0f,ray->invDir[2],ray->invDir[1],ray->invDir[0]);
+  }
+#endif
+}
+
+  // slab test against min/max of a node or box, hit range is
+  // clipped to [0,tmax]
+static LUX_INLINE booln BVH_rayBox(const BVHRay_t* ray, const float* minb, const float* maxb, float tmax, float* tnear)
+{
+#ifdef LUX_SIMD_SSE
+  // the fourth lane is masked, so node indices do not enter the math
+  __m128 bmin = _mm_and_ps(_mm_loadu_ps(minb),ray->mask4);
+  __m128 bmax = _mm_and_ps(_mm_loadu_ps(maxb),ray->mask4);
+  __m128 ta = _mm_mul_ps(_mm_sub_ps(bmin,ray->origin4),ray->invDir4);
+  __m128 tb = _mm_mul_ps(_mm_sub_ps(bmax,ray->origin4),ray->invDir4);
+  // w of near is 0, w of far becomes tmax
+  __m128 vnear = _mm_min_ps(ta,tb);
+  __m128 vfar = _mm_or_ps(_mm_and_ps(_mm_max_ps(ta,tb),ray->mask4),_mm_set_ps(tmax,0.0f,0.0f,0.0f));
+
+  vnear = _mm_max_ps(vnear,_mm_shuffle_ps(vnear,vnear,_MM_SHUFFLE(1,0,3,2)));
+  vnear = _mm_max_ps(vnear,_mm_shuffle_ps(vnear,vnear,_MM_SHUFFLE(2,3,0,1)));
+  vfar = _mm_min_ps(vfar,_mm_shuffle_ps(vfar,vfar,_MM_SHUFFLE(1,0,3,2)));
+  vfar = _mm_min_ps(vfar,_mm_shuffle_ps(vfar,vfar,_MM_SHUFFLE(2,3,0,1)));
+
+  _mm_store_ss(tnear,vnear);
+  return _mm_comile_ss(vnear,vfar);
+#else
+  float t0 = 0.0f;
+  float t1 = tmax;
+  int c;
+
+  for (c = 0; c < 3; c++){
+    float ta = (minb[c] - ray->origin[c]) * ray->invDir[c];
+    float tb = (maxb[c] - ray->origin[c]) * ray->invDir[c];
+    t0 = LUX_MAX(t0,LUX_MIN(ta,tb));
+    t1 = LUX_MIN(t1,LUX_MAX(ta,tb));
+  }
+
+  *tnear = t0;
+  return t0 <= t1;
+#endif
+}
+
+  // Moeller and Trumbore, "Fast, Minimum Storage Ray/Triangle Intersection"
+static LUX_INLINE booln BVH_rayTriangle(const BVHRay_t* ray, const float* vertices[3], lxBVHHit_t* hit)
+{
+  float e1[3];
+  float e2[3];
+  float p[3];
+  float s[3];
+  float q[3];
+  float det;
+  float inv;
+  float u,v,t;
+  int c;
+
+  for (c = 0; c < 3; c++){
+    e1[c] = vertices[1][c] - vertices[0][c];
+    e2[c] = vertices[2][c] - vertices[0][c];
+    s[c] = ray->origin[c] - vertices[0][c];
+  }
+
+  p[0] = ray->dir[1] * e2[2] - ray->dir[2] * e2[1];
+  p[1] = ray->dir[2] * e2[0] - ray->dir[0] * e2[2];
+  p[2] = ray->dir[0] * e2[1] - ray->dir[1] * e2[0];
+  det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+  if (det == 0.0f)
+    return LUX_FALSE;
+
+  inv = 1.0f / det;
+  u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+  if (u < 0.0f || u > 1.0f)
+    return LUX_FALSE;
+
+  q[0] = s[1] * e1[2] - s[2] * e1[1];
+  q[1] = s[2] * e1[0] - s[0] * e1[2];
+  q[2] = s[0] * e1[1] - s[1] * e1[0];
+  v = (ray->dir[0] * q[0] + ray->dir[1] * q[1] + ray->dir[2] * q[2]) * inv;
+  if (v < 0.0f || u + v > 1.0f)
+    return LUX_FALSE;
+
+  t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+  if (t < 0.0f || t > hit->t)
+    return LUX_FALSE;
+
+  hit->t = t;
+  hit->u = u;
+  hit->v = v;
+  return LUX_TRUE;
+}
+
+static booln BVH_ray(const lxBVH_t* bvh, const lxBVHTriangles_t* tris, const lxBoundingBox_t* boxes, size_t boxStride,
+  const lxVector3 origin, const lxVector3 dir, float maxDist, lxBVHHit_t* hit)
+{
+  BVHStackEntry_t stack[LUX_BVH_MAX_DEPTH + 1];
+  const lxBVHNode_t* nodes = bvh->nodes;
+  BVHRay_t  ray;
+  uint32    node = 0;
+  int       sp = 0;
+  float     tnear;
+
+  hit->t = maxDist;
+  hit->u = 0.0f;
+  hit->v = 0.0f;
+  hit->prim = LUX_BVH_NOHIT;
+
+  BVH_initRay(&ray,origin,dir);
+  if (!bvh->numNodes || !BVH_rayBox(&ray,nodes[0].min,nodes[0].max,maxDist,&tnear))
+    return LUX_FALSE;
+
+  for (;;){
+    const lxBVHNode_t* cur = &nodes[node];
+
+    if (!cur->count){
+      uint32  left = cur->first;
+      float   tleft;
+      float   tright;
+      booln   hitLeft = BVH_rayBox(&ray,nodes[left].min,nodes[left].max,hit->t,&tleft);
+      booln   hitRight = BVH_rayBox(&ray,nodes[left+1].min,nodes[left+1].max,hit->t,&tright);
+
+      if (hitLeft && hitRight){
+        booln   leftFirst = tleft <= tright;
+        stack[sp].node = leftFirst ? left + 1 : left;
+        stack[sp].tnear = leftFirst ? tright : tleft;
+        sp++;
+        node = leftFirst ? left : left + 1;
+        continue;
+      }
+      else if (hitLeft || hitRight){
+        node = hitLeft ? left : left + 1;
+        continue;
+      }
+    }
+    else{
+      uint32 i;
+      for (i = cur->first; i < cur->first + cur->count; i++){
+        uint32 prim = bvh->prims[i];
+
+        if (tris){
+          const float* vertices[3];
+          BVH_getTriangle(tris,prim,vertices);
+          if (BVH_rayTriangle(&ray,vertices,hit)){
+            hit->prim = prim;
+          }
+        }
+        else{
+          const lxBoundingBox_t* box = BVH_getBox(boxes,boxStride,prim);
+          if (BVH_rayBox(&ray,box->min,box->max,hit->t,&tnear) && (tnear < hit->t || hit->prim == LUX_BVH_NOHIT)){
+            hit->t = tnear;
+            hit->prim = prim;
+          }
+        }
+      }
+    }
+
+    // next pending node that is still closer than the hit
+    while (sp && stack[sp-1].tnear > hit->t){
+      sp--;
+    }
+    if (!sp)
+      break;
+    node = stack[--sp].node;
+  }
+
+  return hit->prim != LUX_BVH_NOHIT;
+}
+
+LUX_API booln lxBVH_rayTriangles(const lxBVH_t* bvh, const lxBVHTriangles_t* tris,
+  const lxVector3 origin, const lxVector3 dir, float maxDist, lxBVHHit_t* hit)
+{
+  return BVH_ray(bvh,tris,NULL,0,origin,dir,maxDist,hit);
+}
+
+LUX_API booln lxBVH_rayBoxes(const lxBVH_t* bvh, const lxBoundingBox_t* boxes, size_t boxStride,
+  const lxVector3 origin, const lxVector3 dir, float maxDist, lxBVHHit_t* hit)
+{
+  return BVH_ray(bvh,NULL,boxes,boxStride,origin,dir,maxDist,hit);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Queries
+
+LUX_API uint32 lxBVH_cullFrustum(const lxBVH_t* bvh, lxFrustumCPTR frustum, uint32* prims, uint32 maxPrims)
+{
+  struct {
+    uint32  node;
+    int     mask;
+  } stack[LUX_BVH_MAX_DEPTH + 2];
+  const lxBVHNode_t* nodes = bvh->nodes;
+  uint32  count = 0;
+  int     startPlane = 0;
+  int     sp = 0;
+
+  if (!bvh->numNodes)
+    return 0;
+
+  stack[0].node = 0;
+  stack[0].mask = (1 << LUX_FRUSTUM_PLANES) - 1;
+  sp = 1;
+
+  while (sp){
+    uint32  node = stack[--sp].node;
+    int     mask = stack[sp].mask;
+    const lxBVHNode_t* cur = &nodes[node];
+
+    if (mask){
+      int outMask;
+      // node min/max match lxBoundingBox_t
+      if (lxFrustum_cullBoundingBoxMaskedCoherent(frustum,(lxBoundingBoxCPTR)cur,mask,&outMask,&startPlane) == LUX_CULL_OUTSIDE)
+        continue;
+      mask = outMask;
+    }
+
+    if (cur->count || !mask){
+      // subtrees cover a continuous range of prims
+      const lxBVHNode_t* first = cur;
+      const lxBVHNode_t* last = cur;
+      uint32  begin;
+      uint32  end;
+
+      while (!first->count) first = &nodes[first->first];
+      while (!last->count)  last = &nodes[last->first + 1];
+      begin = first->first;
+      end = LUX_MIN(last->first + last->count,begin + maxPrims - count);
+
+      memcpy(prims + count,bvh->prims + begin,sizeof(uint32) * (end - begin));
+      count += end - begin;
+      if (count == maxPrims)
+        break;
+      continue;
+    }
+
+    stack[sp].node = cur->first + 1;
+    stack[sp].mask = mask;
+    sp++;
+    stack[sp].node = cur->first;
+    stack[sp].mask = mask;
+    sp++;
+  }
+
+  return count;
+}
+
+LUX_API float lxBVH_getCost(const lxBVH_t* bvh)
+{
+  double  cost = 0.0;
+  float   rootArea;
+  uint32  n;
+
+  if (!bvh->numNodes)
+    return 0.0f;
+
+  rootArea = BVH_area(bvh->nodes[0].min,bvh->nodes[0].max);
+  if (rootArea <= 0.0f)
+    return (float)bvh->numPrims;
+
+  for (n = 0; n < bvh->numNodes; n++){
+    const lxBVHNode_t* node = &bvh->nodes[n];
+    float area = BVH_area(node->min,node->max) / rootArea;
+    cost += area * (node->count ? (float)node->count : 1.0f);
+  }
+
+  return (float)cost;
+}
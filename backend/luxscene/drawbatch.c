@@ -0,0 +1,96 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/drawsystem.h>
+#include <luxinia/luxgfx/buffer.h>
+#include <luxinia/luxmath/matrix44.h>
+#include <string.h>
+
+#define BATCH_INSTANCE_SIZE   (sizeof(float) * 16)
+
+//////////////////////////////////////////////////////////////////////////
+// lxDrawBatch
+
+static LUX_INLINE booln DrawBatch_isInstanced(const lxDrawItem_t* item)
+{
+  return item->drawinfo.instanceCount > 1;
+}
+
+static LUX_INLINE booln DrawBatch_isCompatible(const lxDrawItem_t* a, const lxDrawItem_t* b)
+{
+  const lxDrawInfo_t* ainfo = &a->drawinfo;
+  const lxDrawInfo_t* binfo = &b->drawinfo;
+
+  // per item parameters only match when the data is shared
+  return a->geometryID == b->geometryID &&
+    a->materialID == b->materialID &&
+    a->geometry == b->geometry &&
+    ainfo->primitive == binfo->primitive &&
+    ainfo->primCount == binfo->primCount &&
+    ainfo->firstOffset == binfo->firstOffset &&
+    ainfo->vertexBase == binfo->vertexBase &&
+    ainfo->vertexBaseOffset == binfo->vertexBaseOffset &&
+    a->itemLevel.numParams == b->itemLevel.numParams &&
+    a->itemLevel.datas == b->itemLevel.datas &&
+    a->itemLevel.numContainers == b->itemLevel.numContainers &&
+    a->itemLevel.containers == b->itemLevel.containers &&
+    !DrawBatch_isInstanced(b);
+}
+
+static LUX_INLINE void DrawBatch_writeMatrix(float* LUX_RESTRICT instance, const lxDrawItem_t* item)
+{
+  if (item->spatial){
+    memcpy(instance,lxDrawSpatial_getWorldMatrix(item->spatial,item->spatialNode),BATCH_INSTANCE_SIZE);
+  }
+  else{
+    lxMatrix44Identity(instance);
+  }
+}
+
+LUX_API uint32 lxDrawBatch_build(lxDrawBatch_t* batches, float* instances,
+  const lxDrawItem_t* const* items, const uint32* order, uint32 numItems)
+{
+  lxDrawBatch_t* batch = NULL;
+  uint32  numBatches = 0;
+  uint32  i;
+
+  for (i = 0; i < numItems; i++){
+    const lxDrawItem_t* item = items[order ? order[i] : i];
+
+    DrawBatch_writeMatrix(instances + i * 16,item);
+
+    if (batch && !DrawBatch_isInstanced(batch->item) && DrawBatch_isCompatible(batch->item,item)){
+      batch->drawinfo.instanceCount++;
+      continue;
+    }
+
+    batch = &batches[numBatches++];
+    batch->item = item;
+    batch->drawinfo = item->drawinfo;
+    batch->drawinfo.instanceCount = LUX_MAX(item->drawinfo.instanceCount,1);
+    batch->firstInstance = i;
+  }
+
+  return numBatches;
+}
+
+LUX_API uint32 lxDrawBatch_buildBuffer(lxDrawBatch_t* batches, lxgBufferPTR buffer, uint offset,
+  const lxDrawItem_t* const* items, const uint32* order, uint32 numItems)
+{
+  float*  instances;
+  uint32  numBatches;
+
+  if (!numItems)
+    return 0;
+
+  instances = (float*)lxgBuffer_mapRange(buffer,offset,(uint)(numItems * BATCH_INSTANCE_SIZE),
+    LUXGFX_ACCESS_WRITEDISCARD,LUX_FALSE,LUX_TRUE,NULL);
+  if (!instances)
+    return 0;
+
+  numBatches = lxDrawBatch_build(batches,instances,items,order,numItems);
+  lxgBuffer_unmap(buffer);
+
+  return numBatches;
+}
@@ -0,0 +1,247 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/drawsystem.h>
+#include <luxinia/luxcore/scalarmisc.h>
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////////////
+// lxDrawGeometry Optimization
+
+typedef struct DrawGeometryLayout_s{
+  lxMeshIndexType_t   indexType;
+  int                 numIndices;
+  int                 numVertices;
+  size_t              strides[LUXGFX_MAX_VERTEX_STREAMS];
+  const float*        positions;
+  size_t              posStride;
+}DrawGeometryLayout_t;
+
+  // returns TRUE if geometry cannot be processed on host
+static booln DrawGeometry_getLayout(const lxDrawGeometry_t* geometry, DrawGeometryLayout_t* layout)
+{
+  lxgVertexDeclCPTR decl = geometry->vertexDecl;
+  size_t  indexSize;
+  int     i;
+
+  memset(layout,0,sizeof(DrawGeometryLayout_t));
+
+  switch(geometry->indexType){
+  case LUX_SCALAR_UINT16:
+    layout->indexType = LUX_MESH_INDEX_UINT16;
+    indexSize = sizeof(uint16);
+    break;
+  case LUX_SCALAR_UINT32:
+    layout->indexType = LUX_MESH_INDEX_UINT32;
+    indexSize = sizeof(uint32);
+    break;
+  default:
+    return LUX_TRUE;
+  }
+
+  if (!decl || geometry->indexStream.buffer || !geometry->indexStream.ptr)
+    return LUX_TRUE;
+
+  layout->numIndices = (int)(geometry->indexStream.len / indexSize);
+  layout->numIndices -= layout->numIndices % 3;
+  layout->numVertices = -1;
+
+  for (i = 0; i < LUXGFX_VERTEX_ATTRIBS; i++){
+    const lxgVertexElement_t* elem = &decl->table[i];
+    const lxgStreamHost_t*    host;
+
+    if (!(decl->available & lxgVertexAttrib_bit((lxgVertexAttrib_t)i)))
+      continue;
+
+    host = &geometry->vertexStreams[elem->stream];
+    if (host->buffer || !host->ptr || !elem->stridehalf)
+      return LUX_TRUE;
+
+    layout->strides[elem->stream] = elem->stridehalf * 2;
+  }
+
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    int count;
+    if (!layout->strides[i])
+      continue;
+
+    count = (int)(geometry->vertexStreams[i].len / layout->strides[i]);
+    layout->numVertices = layout->numVertices < 0 ? count : LUX_MIN(layout->numVertices,count);
+  }
+
+  if (layout->numVertices <= 0)
+    return LUX_TRUE;
+
+  if (decl->available & lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_POS)){
+    const lxgVertexElement_t* elem = &decl->table[LUXGFX_VERTEX_ATTRIB_POS];
+    // cnt is stored minus one
+    if (elem->scalartype == LUX_SCALAR_FLOAT32 && elem->cnt >= 2 && !elem->integer){
+      layout->positions = (const float*)(((const byte*)geometry->vertexStreams[elem->stream].ptr) + elem->offset);
+      layout->posStride = layout->strides[elem->stream];
+    }
+  }
+
+  return LUX_FALSE;
+}
+
+LUX_API booln lxDrawGeometry_optimize(lxDrawGeometry_t* geometry, lxVertexCacheOpt_t* ctx, int vcache, float overdrawThreshold)
+{
+  DrawGeometryLayout_t layout;
+  void*   indices;
+  int     nTriangles;
+  size_t  indexSize;
+  size_t  scratchSize;
+  uint32* remap;
+  void*   copy;
+  size_t  maxStreamSize = 0;
+  booln   failed;
+  int     i;
+
+  if (DrawGeometry_getLayout(geometry,&layout) || !ctx->allocator)
+    return LUX_TRUE;
+
+  nTriangles = layout.numIndices / 3;
+  indexSize = layout.indexType == LUX_MESH_INDEX_UINT16 ? sizeof(uint16) : sizeof(uint32);
+
+  // index stages work on a copy, so the geometry stays untouched
+  // if one fails, the vertex stage cannot fail
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    maxStreamSize = LUX_MAX(maxStreamSize,layout.strides[i] * layout.numVertices);
+  }
+  scratchSize = sizeof(uint32) * layout.numVertices + LUX_MAX(maxStreamSize,indexSize * layout.numIndices);
+  remap = (uint32*)lxMemoryAllocator_malloc(ctx->allocator,scratchSize);
+  if (!remap)
+    return LUX_TRUE;
+  copy = (void*)(remap + layout.numVertices);
+  indices = copy;
+  memcpy(indices,geometry->indexStream.ptr,indexSize * layout.numIndices);
+
+  failed = !lxVertexCacheOpt_tipsify(ctx,indices,nTriangles,layout.numVertices,vcache,layout.indexType);
+
+  if (!failed && overdrawThreshold > 0.0f && layout.positions){
+    failed = lxMeshOverdraw_optimize(ctx->allocator,indices,nTriangles,
+      layout.positions,layout.posStride,layout.numVertices,vcache,overdrawThreshold,layout.indexType);
+  }
+
+  if (failed){
+    lxMemoryAllocator_free(ctx->allocator,remap,scratchSize);
+    return LUX_TRUE;
+  }
+
+  // vertex fetch, one remap for all streams
+  lxMeshVertexFetch_remap(remap,indices,layout.numIndices,layout.numVertices,layout.indexType);
+  lxMeshIndices_remap(indices,layout.numIndices,remap,layout.indexType);
+  memcpy(geometry->indexStream.ptr,indices,indexSize * layout.numIndices);
+
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    size_t  size = layout.strides[i] * layout.numVertices;
+    if (!size)
+      continue;
+
+    memcpy(copy,geometry->vertexStreams[i].ptr,size);
+    lxMeshVertices_remap(geometry->vertexStreams[i].ptr,copy,layout.strides[i],layout.numVertices,remap);
+  }
+
+  lxMemoryAllocator_free(ctx->allocator,remap,scratchSize);
+
+  return LUX_FALSE;
+}
+
+LUX_API int lxDrawGeometry_weld(lxDrawGeometry_t* geometry, lxMemoryAllocatorPTR allocator, lxJobPoolPTR pool, float epsilon)
+{
+  DrawGeometryLayout_t layout;
+  lxgVertexDeclCPTR   decl = geometry->vertexDecl;
+  lxMeshWeldStream_t  streams[LUXGFX_VERTEX_ATTRIBS];
+  int     numStreams = 0;
+  int     numUnique;
+  uint32* remap;
+  int     i;
+
+  if (DrawGeometry_getLayout(geometry,&layout) || (epsilon > 0.0f && !layout.positions))
+    return -1;
+
+  for (i = 0; i < LUXGFX_VERTEX_ATTRIBS; i++){
+    const lxgVertexElement_t* elem = &decl->table[i];
+
+    if (!(decl->available & lxgVertexAttrib_bit((lxgVertexAttrib_t)i)) ||
+        (epsilon > 0.0f && i == LUXGFX_VERTEX_ATTRIB_POS))
+      continue;
+
+    streams[numStreams].data = ((const byte*)geometry->vertexStreams[elem->stream].ptr) + elem->offset;
+    streams[numStreams].stride = layout.strides[elem->stream];
+    streams[numStreams].size = lxScalarType_getSize((lxScalarType_t)elem->scalartype) * (elem->cnt + 1);
+    numStreams++;
+  }
+
+  remap = (uint32*)lxMemoryAllocator_malloc(allocator,sizeof(uint32) * layout.numVertices);
+  if (!remap)
+    return -1;
+
+  if (epsilon > 0.0f){
+    numUnique = lxMeshWeld_remapEpsilon(remap,allocator,pool,layout.positions,layout.posStride,epsilon,
+      streams,numStreams,layout.numVertices);
+  }
+  else{
+    numUnique = lxMeshWeld_remap(remap,allocator,pool,streams,numStreams,layout.numVertices);
+  }
+
+  if (numUnique >= 0){
+    lxMeshIndices_remap(geometry->indexStream.ptr,layout.numIndices,remap,layout.indexType);
+
+    for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+      if (!layout.strides[i])
+        continue;
+
+      lxMeshVertices_compact(geometry->vertexStreams[i].ptr,geometry->vertexStreams[i].ptr,
+        layout.strides[i],layout.numVertices,remap);
+      geometry->vertexStreams[i].len = layout.strides[i] * numUnique;
+    }
+  }
+
+  lxMemoryAllocator_free(allocator,remap,sizeof(uint32) * layout.numVertices);
+
+  return numUnique;
+}
+
+LUX_API booln lxDrawGeometry_computeStats(const lxDrawGeometry_t* geometry, lxMemoryAllocatorPTR allocator, int vcache, lxMeshStats_t* stats)
+{
+  DrawGeometryLayout_t layout;
+  const void* indices;
+  int     nTriangles;
+  size_t  fetched = 0;
+  float   referenced = 0.0f;
+  int     i;
+
+  memset(stats,0,sizeof(lxMeshStats_t));
+
+  if (DrawGeometry_getLayout(geometry,&layout))
+    return LUX_TRUE;
+
+  indices = geometry->indexStream.ptr;
+  nTriangles = layout.numIndices / 3;
+
+  lxVertexCacheStats_compute(&stats->vcache,indices,nTriangles,layout.numVertices,vcache,layout.indexType);
+
+  if (!nTriangles)
+    return LUX_FALSE;
+
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    size_t bytes;
+    if (!layout.strides[i])
+      continue;
+
+    bytes = lxMeshStats_fetch(stats,allocator,indices,layout.numIndices,layout.numVertices,layout.strides[i],vcache,layout.indexType);
+    if (!bytes)
+      return LUX_TRUE;
+
+    fetched += bytes;
+    referenced += (float)bytes / stats->overfetch;
+  }
+  stats->overfetch = referenced > 0.0f ? (float)fetched / referenced : 0.0f;
+
+  if (layout.positions)
+    return lxMeshStats_overdraw(stats,allocator,indices,nTriangles,layout.positions,layout.posStride,layout.indexType);
+
+  return LUX_FALSE;
+}
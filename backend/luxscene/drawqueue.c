@@ -0,0 +1,218 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/drawsystem.h>
+#include <luxinia/luxcore/sortradix.h>
+#include <string.h>
+
+#define QUEUE_MIN_ALLOC   256
+
+//////////////////////////////////////////////////////////////////////////
+// Storage
+
+static void* Queue_grow(lxMemoryAllocatorPTR allocator, void* ptr, size_t elemSize, uint32 num, uint32 numNew)
+{
+  void* mem = lxMemoryAllocator_malloc(allocator,elemSize * numNew);
+  if (ptr){
+    memcpy(mem,ptr,elemSize * num);
+    lxMemoryAllocator_free(allocator,ptr,elemSize * num);
+  }
+  return mem;
+}
+
+static void Queue_freeArrays(lxDrawQueue_t* queue)
+{
+  lxMemoryAllocatorPTR allocator = queue->allocator;
+  uint32 num = queue->numAllocated;
+
+  if (!num)
+    return;
+
+  lxMemoryAllocator_free(allocator,(void*)queue->items,sizeof(lxDrawItem_t*) * num);
+  lxMemoryAllocator_free(allocator,queue->keysLo,sizeof(uint32) * num);
+  lxMemoryAllocator_free(allocator,queue->keysHi,sizeof(uint32) * num);
+  lxMemoryAllocator_free(allocator,queue->indices,sizeof(uint32) * num);
+  lxMemoryAllocator_free(allocator,queue->indicesTemp,sizeof(uint32) * num);
+}
+
+LUX_API booln lxDrawQueue_init(lxDrawQueue_t* queue, lxMemoryAllocatorPTR allocator, const lxDrawKeyLayout_t* layout)
+{
+  uint32 used = 0;
+  uint32 bits = 0;
+  int i;
+
+  memset(queue,0,sizeof(lxDrawQueue_t));
+  queue->allocator = allocator;
+  queue->layout = *layout;
+
+  if (layout->numFields < 0 || layout->numFields > LUX_DRAWKEY_FIELDS)
+    return LUX_TRUE;
+
+  for (i = 0; i < layout->numFields; i++){
+    if ((uint32)layout->fields[i].field >= LUX_DRAWKEY_FIELDS ||
+      (used & (1 << layout->fields[i].field)) ||
+      layout->fields[i].bits > 32)
+    {
+      return LUX_TRUE;
+    }
+    used |= 1 << layout->fields[i].field;
+    bits += layout->fields[i].bits;
+  }
+  if (bits > 64)
+    return LUX_TRUE;
+
+  // first field ends up in the highest bits, a layout
+  // within 32 bits only uses keysLo
+  queue->keyBits = bits;
+  for (i = 0; i < layout->numFields; i++){
+    lxDrawKeyField_t field = layout->fields[i].field;
+    bits -= layout->fields[i].bits;
+    queue->shifts[field] = bits;
+    queue->masks[field] = (((uint64)1) << layout->fields[i].bits) - 1;
+  }
+
+  if (layout->depthFar > layout->depthNear){
+    queue->depthScale = (float)queue->masks[LUX_DRAWKEY_DEPTH] / (layout->depthFar - layout->depthNear);
+  }
+
+  return LUX_FALSE;
+}
+
+LUX_API void lxDrawQueue_deinit(lxDrawQueue_t* queue)
+{
+  Queue_freeArrays(queue);
+  memset(queue,0,sizeof(lxDrawQueue_t));
+}
+
+LUX_API void lxDrawQueue_reserve(lxDrawQueue_t* queue, uint32 numItems)
+{
+  lxMemoryAllocatorPTR allocator = queue->allocator;
+  uint32 num = queue->numAllocated;
+  uint32 numNew = LUX_MAX(LUX_MAX(num * 2, numItems),QUEUE_MIN_ALLOC);
+
+  if (numItems <= num)
+    return;
+
+  // indices are rebuilt by sort, only items and keys are kept
+  queue->items    = (const lxDrawItem_t**)Queue_grow(allocator,(void*)queue->items,sizeof(lxDrawItem_t*),queue->numItems,numNew);
+  queue->keysLo   = (uint32*)Queue_grow(allocator,queue->keysLo,sizeof(uint32),queue->numItems,numNew);
+  queue->keysHi   = (uint32*)Queue_grow(allocator,queue->keysHi,sizeof(uint32),queue->numItems,numNew);
+  if (num){
+    lxMemoryAllocator_free(allocator,queue->indices,sizeof(uint32) * num);
+    lxMemoryAllocator_free(allocator,queue->indicesTemp,sizeof(uint32) * num);
+  }
+  queue->indices      = (uint32*)lxMemoryAllocator_malloc(allocator,sizeof(uint32) * numNew);
+  queue->indicesTemp  = (uint32*)lxMemoryAllocator_malloc(allocator,sizeof(uint32) * numNew);
+  queue->numAllocated = numNew;
+  queue->sorted = NULL;
+}
+
+LUX_API void lxDrawQueue_reset(lxDrawQueue_t* queue)
+{
+  queue->numItems = 0;
+  queue->sorted = NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Keys
+
+static LUX_INLINE uint32 Queue_quantizeDepth(const lxDrawQueue_t* queue, float depth, booln translucent)
+{
+  uint32  maxDepth = (uint32)queue->masks[LUX_DRAWKEY_DEPTH];
+  float   fdepth = (depth - queue->layout.depthNear) * queue->depthScale;
+  lxDrawDepthOrder_t order = translucent ? queue->layout.translucentDepth : queue->layout.opaqueDepth;
+  uint32  q;
+
+  // maxDepth as float may round up, compare before converting
+  if (fdepth >= (float)maxDepth){
+    q = maxDepth;
+  }
+  else if (fdepth > 0.0f){
+    q = (uint32)fdepth;
+  }
+  else{
+    q = 0;
+  }
+
+  return order == LUX_DRAWDEPTH_BACKTOFRONT ? maxDepth - q : q;
+}
+
+static LUX_INLINE uint64 Queue_makeKey(const lxDrawQueue_t* queue, const lxDrawItem_t* item, const lxDrawKeyInput_t* input)
+{
+  const uint32* shifts = queue->shifts;
+  const uint64* masks = queue->masks;
+  booln translucent = input->translucent ? 1 : 0;
+
+  // fields not in the layout have a zero mask
+  return
+    ((input->layer & masks[LUX_DRAWKEY_LAYER]) << shifts[LUX_DRAWKEY_LAYER]) |
+    ((translucent & masks[LUX_DRAWKEY_TRANSLUCENT]) << shifts[LUX_DRAWKEY_TRANSLUCENT]) |
+    ((uint64)Queue_quantizeDepth(queue,input->depth,translucent) << shifts[LUX_DRAWKEY_DEPTH]) |
+    ((input->shader & masks[LUX_DRAWKEY_SHADER]) << shifts[LUX_DRAWKEY_SHADER]) |
+    ((item->materialID & masks[LUX_DRAWKEY_MATERIAL]) << shifts[LUX_DRAWKEY_MATERIAL]) |
+    ((item->geometryID & masks[LUX_DRAWKEY_GEOMETRY]) << shifts[LUX_DRAWKEY_GEOMETRY]);
+}
+
+LUX_API uint64 lxDrawQueue_makeKey(const lxDrawQueue_t* queue, const lxDrawItem_t* item, const lxDrawKeyInput_t* input)
+{
+  return Queue_makeKey(queue,item,input);
+}
+
+LUX_API void lxDrawQueue_addItems(lxDrawQueue_t* queue, const lxDrawItem_t* items, const lxDrawKeyInput_t* inputs, uint32 count)
+{
+  uint32  offset = queue->numItems;
+  uint32  i;
+
+  lxDrawQueue_reserve(queue,offset + count);
+  for (i = 0; i < count; i++){
+    uint64 key = Queue_makeKey(queue,&items[i],&inputs[i]);
+    queue->items[offset + i] = &items[i];
+    queue->keysLo[offset + i] = (uint32)key;
+    queue->keysHi[offset + i] = (uint32)(key >> 32);
+  }
+  queue->numItems = offset + count;
+  queue->sorted = NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Sort
+
+LUX_API const uint32* lxDrawQueue_sort(lxDrawQueue_t* queue)
+{
+  uint32  numItems = queue->numItems;
+  uint32* sorted;
+  uint32  i;
+
+  if (queue->sorted)
+    return queue->sorted;
+  if (!numItems)
+    return queue->indices;
+
+  for (i = 0; i < numItems; i++){
+    queue->indices[i] = i;
+  }
+
+  // least significant digit first, the radix sort is stable and
+  // continues from the order of the indices passed in
+  sorted = lxSortRadixArrayInt(queue->keysLo,numItems,LUX_FALSE,queue->indices,queue->indicesTemp);
+  if (queue->keyBits > 32){
+    uint32* other = sorted == queue->indices ? queue->indicesTemp : queue->indices;
+    sorted = lxSortRadixArrayInt(queue->keysHi,numItems,LUX_FALSE,sorted,other);
+  }
+
+  queue->sorted = sorted;
+  return sorted;
+}
+
+LUX_API uint64 lxDrawQueue_getKey(const lxDrawQueue_t* queue, uint32 index)
+{
+  LUX_DEBUGASSERT(index < queue->numItems);
+  return ((uint64)queue->keysHi[index] << 32) | queue->keysLo[index];
+}
+
+LUX_API const lxDrawItem_t* lxDrawQueue_getSorted(const lxDrawQueue_t* queue, uint32 i)
+{
+  LUX_DEBUGASSERT(queue->sorted && i < queue->numItems);
+  return queue->items[queue->sorted[i]];
+}
@@ -0,0 +1,1254 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/drawsystem.h>
+#include <luxinia/luxmath/matrix44.h>
+#include <luxinia/luxmath/bounding.h>
+#include <luxinia/luxmath/vector4.h>
+#include <luxinia/luxmath/frustum.h>
+#include <luxinia/luxcore/jobpool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <float.h>
+#include <math.h>
+
+#define SPATIAL_MIN_ALLOC   64
+  // with more than numSlots / SPATIAL_FULL_SWEEP dirty slots,
+  // scanning the flags is cheaper than sorting the dirty list
+#define SPATIAL_FULL_SWEEP  32
+
+  // tree boxes deeper than this use the plane mask of an ancestor
+#define SPATIAL_CULL_DEPTH  64
+  // multi-view culling aims at this many jobs per thread, each
+  // covering at least SPATIAL_VIEW_MIN_ITEMS items
+#define SPATIAL_VIEW_JOBS       4
+#define SPATIAL_VIEW_MIN_ITEMS  1024
+
+enum{
+  SPATIAL_FLAG_DIRTY = 1<<0,
+  SPATIAL_FLAG_REFIT = 1<<1,
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Storage
+
+  // arrays of one group share their element count, extra elements
+  // are added to it (itemFirst has one more than slots)
+typedef struct SpatialArray_s{
+  size_t    offset;
+  size_t    elemSize;
+  uint32    extra;
+}SpatialArray_t;
+
+#define SPATIAL_ARRAY(name,type,extra)  {offsetof(lxDrawSpatial_t,name),sizeof(type),extra}
+#define SPATIAL_ARRAYS(list)            list,(sizeof(list)/sizeof(list[0]))
+#define SPATIAL_MAX_ARRAYS  12
+
+static const SpatialArray_t l_slotArrays[] = {
+  SPATIAL_ARRAY(localMatrices,lxMatrix44SIMD,0),
+  SPATIAL_ARRAY(worldMatrices,lxMatrix44SIMD,0),
+  SPATIAL_ARRAY(localBoundings,lxDrawBounding_t,0),
+  SPATIAL_ARRAY(worldBoundings,lxDrawBounding_t,0),
+  SPATIAL_ARRAY(parents,uint32,0),
+  SPATIAL_ARRAY(subtreeEnds,uint32,0),
+  SPATIAL_ARRAY(slotNodes,uint32,0),
+  SPATIAL_ARRAY(slotFlags,byte,0),
+  SPATIAL_ARRAY(dirty,uint32,0),
+  SPATIAL_ARRAY(treeBoxes,lxBoundingBox_t,0),
+  SPATIAL_ARRAY(itemFirst,uint32,1),
+  SPATIAL_ARRAY(refit,uint32,0),
+};
+
+static const SpatialArray_t l_nodeArrays[] = {
+  SPATIAL_ARRAY(nodeSlots,uint32,0),
+  SPATIAL_ARRAY(nodeParents,uint32,0),
+  SPATIAL_ARRAY(freeNodes,uint32,0),
+};
+
+static const SpatialArray_t l_itemArrays[] = {
+  SPATIAL_ARRAY(items,lxDrawItem_t,0),
+  SPATIAL_ARRAY(itemLocalBoundings,lxDrawBounding_t,0),
+  SPATIAL_ARRAY(itemWorldBoundings,lxDrawBounding_t,0),
+  SPATIAL_ARRAY(itemIDs,uint32,0),
+};
+
+static const SpatialArray_t l_itemIDArrays[] = {
+  SPATIAL_ARRAY(itemPositions,uint32,0),
+  SPATIAL_ARRAY(itemNodes,uint32,0),
+  SPATIAL_ARRAY(freeItems,uint32,0),
+};
+
+static LUX_INLINE void** Spatial_arrayPtr(lxDrawSpatial_t* spatial, const SpatialArray_t* array)
+{
+  return (void**)((byte*)spatial + array->offset);
+}
+
+  // grows all arrays of a group from num to numNew elements or none
+  // of them, returns TRUE on error
+static booln Spatial_growArrays(lxDrawSpatial_t* spatial, const SpatialArray_t* arrays, int numArrays, uint32 num, uint32 numNew)
+{
+  lxMemoryAllocatorPTR allocator = spatial->allocator;
+  void* mems[SPATIAL_MAX_ARRAYS];
+  int i;
+
+  LUX_DEBUGASSERT(numArrays <= SPATIAL_MAX_ARRAYS);
+
+  for (i = 0; i < numArrays; i++){
+    mems[i] = lxMemoryAllocator_mallocAligned(allocator,arrays[i].elemSize * (numNew + arrays[i].extra),16);
+    if (!mems[i]){
+      while (i--){
+        lxMemoryAllocator_freeAligned(allocator,mems[i],arrays[i].elemSize * (numNew + arrays[i].extra));
+      }
+      return LUX_TRUE;
+    }
+  }
+  for (i = 0; i < numArrays; i++){
+    void** ptr = Spatial_arrayPtr(spatial,&arrays[i]);
+    if (*ptr){
+      memcpy(mems[i],*ptr,arrays[i].elemSize * (num + arrays[i].extra));
+      lxMemoryAllocator_freeAligned(allocator,*ptr,arrays[i].elemSize * (num + arrays[i].extra));
+    }
+    *ptr = mems[i];
+  }
+  return LUX_FALSE;
+}
+
+static void Spatial_freeArrays(lxDrawSpatial_t* spatial, const SpatialArray_t* arrays, int numArrays, uint32 num)
+{
+  int i;
+  for (i = 0; i < numArrays; i++){
+    void** ptr = Spatial_arrayPtr(spatial,&arrays[i]);
+    if (*ptr){
+      lxMemoryAllocator_freeAligned(spatial->allocator,*ptr,arrays[i].elemSize * (num + arrays[i].extra));
+      *ptr = NULL;
+    }
+  }
+}
+
+  // growth functions return TRUE on error, the spatial is unchanged then
+
+static booln Spatial_growSlots(lxDrawSpatial_t* spatial, uint32 minSlots)
+{
+  uint32 num = spatial->numSlotsAllocated;
+  uint32 numNew = LUX_MAX(LUX_MAX(num * 2, minSlots),SPATIAL_MIN_ALLOC);
+
+  if (minSlots <= num)
+    return LUX_FALSE;
+  if (Spatial_growArrays(spatial,SPATIAL_ARRAYS(l_slotArrays),num,numNew))
+    return LUX_TRUE;
+
+  spatial->numSlotsAllocated = numNew;
+  return LUX_FALSE;
+}
+
+static booln Spatial_growNodes(lxDrawSpatial_t* spatial, uint32 minNodes)
+{
+  uint32 num = spatial->numNodesAllocated;
+  uint32 numNew = LUX_MAX(LUX_MAX(num * 2, minNodes),SPATIAL_MIN_ALLOC);
+
+  if (minNodes <= num)
+    return LUX_FALSE;
+  if (Spatial_growArrays(spatial,SPATIAL_ARRAYS(l_nodeArrays),num,numNew))
+    return LUX_TRUE;
+
+  spatial->numNodesAllocated = numNew;
+  return LUX_FALSE;
+}
+
+static booln Spatial_growItems(lxDrawSpatial_t* spatial, uint32 minItems)
+{
+  uint32 num = spatial->numItemsAllocated;
+  uint32 numNew = LUX_MAX(LUX_MAX(num * 2, minItems),SPATIAL_MIN_ALLOC);
+
+  if (minItems <= num)
+    return LUX_FALSE;
+  if (Spatial_growArrays(spatial,SPATIAL_ARRAYS(l_itemArrays),num,numNew))
+    return LUX_TRUE;
+
+  spatial->numItemsAllocated = numNew;
+  return LUX_FALSE;
+}
+
+static booln Spatial_growItemIDs(lxDrawSpatial_t* spatial, uint32 minIDs)
+{
+  uint32 num = spatial->numItemIDsAllocated;
+  uint32 numNew = LUX_MAX(LUX_MAX(num * 2, minIDs),SPATIAL_MIN_ALLOC);
+
+  if (minIDs <= num)
+    return LUX_FALSE;
+  if (Spatial_growArrays(spatial,SPATIAL_ARRAYS(l_itemIDArrays),num,numNew))
+    return LUX_TRUE;
+
+  spatial->numItemIDsAllocated = numNew;
+  return LUX_FALSE;
+}
+
+static void Spatial_freeSlotArrays(lxDrawSpatial_t* spatial)
+{
+  Spatial_freeArrays(spatial,SPATIAL_ARRAYS(l_slotArrays),spatial->numSlotsAllocated);
+}
+
+static void Spatial_freeItemArrays(lxDrawSpatial_t* spatial)
+{
+  Spatial_freeArrays(spatial,SPATIAL_ARRAYS(l_itemArrays),spatial->numItemsAllocated);
+}
+
+  // moves the item arrays to old and allocates new ones of the same
+  // size, returns TRUE on error, the spatial is unchanged then
+static booln Spatial_detachItems(lxDrawSpatial_t* spatial, lxDrawSpatial_t* old)
+{
+  *old = *spatial;
+  spatial->numItemsAllocated = 0;
+  spatial->items = NULL;
+  spatial->itemLocalBoundings = NULL;
+  spatial->itemWorldBoundings = NULL;
+  spatial->itemIDs = NULL;
+  if (Spatial_growItems(spatial,old->numItemsAllocated)){
+    *spatial = *old;
+    return LUX_TRUE;
+  }
+  return LUX_FALSE;
+}
+
+static void Spatial_initBounding(lxDrawBounding_t* bounding)
+{
+  lxVector4Set(bounding->bsphere.center,0.0f,0.0f,0.0f,-1.0f);
+  lxVector4Set(bounding->bbox.min,FLT_MAX,FLT_MAX,FLT_MAX,0.0f);
+  lxVector4Set(bounding->bbox.max,-FLT_MAX,-FLT_MAX,-FLT_MAX,0.0f);
+}
+
+static LUX_INLINE booln Spatial_isValidItem(const lxDrawSpatial_t* spatial, uint32 item)
+{
+  return item < spatial->numItemIDs && spatial->itemPositions[item] != LUX_DRAWSPATIAL_NONE;
+}
+
+  // removing a node only marks the node itself, until the next
+  // re-order its descendants are found through the parent chain
+static LUX_INLINE booln Spatial_isValid(const lxDrawSpatial_t* spatial, uint32 node)
+{
+  const uint32* nodeSlots = spatial->nodeSlots;
+  const uint32* nodeParents = spatial->nodeParents;
+
+  if (node >= spatial->numNodes || nodeSlots[node] == LUX_DRAWSPATIAL_NONE)
+    return LUX_FALSE;
+  if (spatial->reorder){
+    for (node = nodeParents[node]; node != LUX_DRAWSPATIAL_NONE; node = nodeParents[node]){
+      if (nodeSlots[node] == LUX_DRAWSPATIAL_NONE)
+        return LUX_FALSE;
+    }
+  }
+  return LUX_TRUE;
+}
+
+static LUX_INLINE void Spatial_setDirty(lxDrawSpatial_t* spatial, uint32 slot)
+{
+  // re-ordering updates all slots anyway
+  if (!spatial->reorder && !(spatial->slotFlags[slot] & SPATIAL_FLAG_DIRTY)){
+    spatial->slotFlags[slot] |= SPATIAL_FLAG_DIRTY;
+    spatial->dirty[spatial->numDirty++] = slot;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Transforms
+
+  // out = parent * local
+static LUX_INLINE void Spatial_multiply(float* LUX_RESTRICT out, const float* LUX_RESTRICT parent, const float* LUX_RESTRICT local)
+{
+#ifdef LUX_SIMD_SSE
+  __m128 p0 = _mm_load_ps(parent);
+  __m128 p1 = _mm_load_ps(parent + 4);
+  __m128 p2 = _mm_load_ps(parent + 8);
+  __m128 p3 = _mm_load_ps(parent + 12);
+  int c;
+
+  for (c = 0; c < 4; c++){
+    __m128 l = _mm_load_ps(local + c * 4);
+    __m128 r = _mm_mul_ps(p0,_mm_shuffle_ps(l,l,_MM_SHUFFLE(0,0,0,0)));
+    r = _mm_add_ps(r,_mm_mul_ps(p1,_mm_shuffle_ps(l,l,_MM_SHUFFLE(1,1,1,1))));
+    r = _mm_add_ps(r,_mm_mul_ps(p2,_mm_shuffle_ps(l,l,_MM_SHUFFLE(2,2,2,2))));
+    r = _mm_add_ps(r,_mm_mul_ps(p3,_mm_shuffle_ps(l,l,_MM_SHUFFLE(3,3,3,3))));
+    _mm_store_ps(out + c * 4,r);
+  }
+#else
+  lxMatrix44Multiply(out,parent,local);
+#endif
+}
+
+  // sphere radius is scaled by the largest axis, the box is the
+  // bounds of the transformed box (center and absolute extents)
+static LUX_INLINE void Spatial_transformBounding(lxDrawBounding_t* LUX_RESTRICT out, const lxDrawBounding_t* LUX_RESTRICT in, const float* LUX_RESTRICT mat)
+{
+  float scale;
+
+  if (in->bsphere.radius < 0.0f){
+    *out = *in;
+    return;
+  }
+
+  scale = LUX_MAX(mat[0]*mat[0] + mat[1]*mat[1] + mat[2]*mat[2],
+          LUX_MAX(mat[4]*mat[4] + mat[5]*mat[5] + mat[6]*mat[6],
+                  mat[8]*mat[8] + mat[9]*mat[9] + mat[10]*mat[10]));
+
+#ifdef LUX_SIMD_SSE
+  {
+    __m128 c0 = _mm_load_ps(mat);
+    __m128 c1 = _mm_load_ps(mat + 4);
+    __m128 c2 = _mm_load_ps(mat + 8);
+    __m128 c3 = _mm_load_ps(mat + 12);
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 bmin = _mm_load_ps(in->bbox.min);
+    __m128 bmax = _mm_load_ps(in->bbox.max);
+    __m128 center = _mm_mul_ps(_mm_add_ps(bmin,bmax),half);
+    __m128 extent = _mm_mul_ps(_mm_sub_ps(bmax,bmin),half);
+    __m128 sphere = _mm_load_ps(in->bsphere.center);
+    __m128 wc,we,ws;
+
+    wc = _mm_add_ps(c3,_mm_mul_ps(c0,_mm_shuffle_ps(center,center,_MM_SHUFFLE(0,0,0,0))));
+    wc = _mm_add_ps(wc,_mm_mul_ps(c1,_mm_shuffle_ps(center,center,_MM_SHUFFLE(1,1,1,1))));
+    wc = _mm_add_ps(wc,_mm_mul_ps(c2,_mm_shuffle_ps(center,center,_MM_SHUFFLE(2,2,2,2))));
+
+    we = _mm_mul_ps(_mm_andnot_ps(sign,c0),_mm_shuffle_ps(extent,extent,_MM_SHUFFLE(0,0,0,0)));
+    we = _mm_add_ps(we,_mm_mul_ps(_mm_andnot_ps(sign,c1),_mm_shuffle_ps(extent,extent,_MM_SHUFFLE(1,1,1,1))));
+    we = _mm_add_ps(we,_mm_mul_ps(_mm_andnot_ps(sign,c2),_mm_shuffle_ps(extent,extent,_MM_SHUFFLE(2,2,2,2))));
+
+    ws = _mm_add_ps(c3,_mm_mul_ps(c0,_mm_shuffle_ps(sphere,sphere,_MM_SHUFFLE(0,0,0,0))));
+    ws = _mm_add_ps(ws,_mm_mul_ps(c1,_mm_shuffle_ps(sphere,sphere,_MM_SHUFFLE(1,1,1,1))));
+    ws = _mm_add_ps(ws,_mm_mul_ps(c2,_mm_shuffle_ps(sphere,sphere,_MM_SHUFFLE(2,2,2,2))));
+
+    _mm_store_ps(out->bbox.min,_mm_sub_ps(wc,we));
+    _mm_store_ps(out->bbox.max,_mm_add_ps(wc,we));
+    _mm_store_ps(out->bsphere.center,ws);
+  }
+#else
+  {
+    lxVector3 center;
+    lxVector3 extent;
+    int i;
+
+    for (i = 0; i < 3; i++){
+      center[i] = (in->bbox.min[i] + in->bbox.max[i]) * 0.5f;
+      extent[i] = (in->bbox.max[i] - in->bbox.min[i]) * 0.5f;
+    }
+    for (i = 0; i < 3; i++){
+      float c = mat[12+i] + mat[i]*center[0] + mat[4+i]*center[1] + mat[8+i]*center[2];
+      float e = fabsf(mat[i])*extent[0] + fabsf(mat[4+i])*extent[1] + fabsf(mat[8+i])*extent[2];
+      out->bbox.min[i] = c - e;
+      out->bbox.max[i] = c + e;
+      out->bsphere.center[i] = mat[12+i] + mat[i]*in->bsphere.center[0] + mat[4+i]*in->bsphere.center[1] + mat[8+i]*in->bsphere.center[2];
+    }
+  }
+#endif
+
+  out->bsphere.radius = in->bsphere.radius * sqrtf(scale);
+}
+
+static LUX_INLINE void Spatial_initBox(lxBoundingBox_t* box)
+{
+  lxVector4Set(box->min,FLT_MAX,FLT_MAX,FLT_MAX,FLT_MAX);
+  lxVector4Set(box->max,-FLT_MAX,-FLT_MAX,-FLT_MAX,-FLT_MAX);
+}
+
+static LUX_INLINE void Spatial_addBox(lxBoundingBox_t* LUX_RESTRICT box, const lxBoundingBox_t* LUX_RESTRICT add)
+{
+#ifdef LUX_SIMD_SSE
+  _mm_store_ps(box->min,_mm_min_ps(_mm_load_ps(box->min),_mm_load_ps(add->min)));
+  _mm_store_ps(box->max,_mm_max_ps(_mm_load_ps(box->max),_mm_load_ps(add->max)));
+#else
+  lxVector3Min(box->min,box->min,add->min);
+  lxVector3Max(box->max,box->max,add->max);
+#endif
+}
+
+  // slots within [begin,end) are updated in order, so parents
+  // inside the range are always done before their children
+static void Spatial_updateRange(lxDrawSpatial_t* spatial, uint32 begin, uint32 end)
+{
+  lxMatrix44SIMD* LUX_RESTRICT localMatrices = spatial->localMatrices;
+  lxMatrix44SIMD* LUX_RESTRICT worldMatrices = spatial->worldMatrices;
+  const lxDrawBounding_t* LUX_RESTRICT localBoundings = spatial->localBoundings;
+  lxDrawBounding_t* LUX_RESTRICT worldBoundings = spatial->worldBoundings;
+  const lxDrawBounding_t* LUX_RESTRICT itemLocalBoundings = spatial->itemLocalBoundings;
+  lxDrawBounding_t* LUX_RESTRICT itemWorldBoundings = spatial->itemWorldBoundings;
+  const uint32* LUX_RESTRICT parents = spatial->parents;
+  const uint32* LUX_RESTRICT itemFirst = spatial->itemFirst;
+  uint32 s = begin;
+  uint32 i;
+
+  if (s == 0){
+    lxMatrix44Copy(worldMatrices[0],localMatrices[0]);
+    Spatial_transformBounding(&worldBoundings[0],&localBoundings[0],worldMatrices[0]);
+    for (i = itemFirst[0]; i < itemFirst[1]; i++){
+      Spatial_transformBounding(&itemWorldBoundings[i],&itemLocalBoundings[i],worldMatrices[0]);
+    }
+    s = 1;
+  }
+  for (; s < end; s++){
+    Spatial_multiply(worldMatrices[s],worldMatrices[parents[s]],localMatrices[s]);
+    Spatial_transformBounding(&worldBoundings[s],&localBoundings[s],worldMatrices[s]);
+    for (i = itemFirst[s]; i < itemFirst[s+1]; i++){
+      Spatial_transformBounding(&itemWorldBoundings[i],&itemLocalBoundings[i],worldMatrices[s]);
+    }
+  }
+}
+
+  // tree box = own bounding + items + tree boxes of children
+static void Spatial_refitSlot(lxDrawSpatial_t* spatial, uint32 slot)
+{
+  lxBoundingBox_t* box = &spatial->treeBoxes[slot];
+  const uint32* subtreeEnds = spatial->subtreeEnds;
+  uint32 end = subtreeEnds[slot];
+  uint32 i;
+
+  if (spatial->worldBoundings[slot].bsphere.radius < 0.0f){
+    Spatial_initBox(box);
+  }
+  else{
+    *box = spatial->worldBoundings[slot].bbox;
+  }
+  for (i = spatial->itemFirst[slot]; i < spatial->itemFirst[slot+1]; i++){
+    Spatial_addBox(box,&spatial->itemWorldBoundings[i].bbox);
+  }
+  for (i = slot + 1; i < end; i = subtreeEnds[i]){
+    Spatial_addBox(box,&spatial->treeBoxes[i]);
+  }
+}
+
+static void Spatial_refitRange(lxDrawSpatial_t* spatial, uint32 begin, uint32 end)
+{
+  uint32 s;
+  for (s = end; s > begin; s--){
+    Spatial_refitSlot(spatial,s - 1);
+  }
+}
+
+  // updates subtree of slot and queues the refit of its ancestors
+static uint32 Spatial_updateSubtree(lxDrawSpatial_t* spatial, uint32 slot)
+{
+  uint32 end = spatial->subtreeEnds[slot];
+  uint32 s = slot;
+
+  Spatial_updateRange(spatial,slot,end);
+  Spatial_refitRange(spatial,slot,end);
+
+  while (s){
+    s = spatial->parents[s];
+    if (spatial->slotFlags[s] & SPATIAL_FLAG_REFIT)
+      break;
+    spatial->slotFlags[s] |= SPATIAL_FLAG_REFIT;
+    spatial->refit[spatial->numRefit++] = s;
+  }
+
+  return end;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Ordering
+
+  // rebuilds depth first order from nodeParents, drops removed
+  // subtrees and rebuilds the free list. Children keep their
+  // relative order. Nodes below a removed node are not reached.
+  // returns TRUE on error, the spatial is unchanged then
+static booln Spatial_reorder(lxDrawSpatial_t* spatial)
+{
+  lxMemoryAllocatorPTR allocator = spatial->allocator;
+  uint32  numNodes = spatial->numNodes;
+  uint32  numSlots = spatial->numSlots;
+  uint32  numAllocated = spatial->numSlotsAllocated;
+  uint32* nodeSlots = spatial->nodeSlots;
+  uint32* nodeParents = spatial->nodeParents;
+  uint32* scratch;
+  uint32* firstChild;
+  uint32* nextSibling;
+  uint32* stack;
+  uint32  stackSize = 0;
+  lxDrawSpatial_t old = *spatial;
+  uint32  count = 0;
+  uint32  s;
+  uint32  n;
+
+  scratch = (uint32*)lxMemoryAllocator_malloc(allocator,sizeof(uint32) * numNodes * 3);
+  if (!scratch)
+    return LUX_TRUE;
+  firstChild = scratch;
+  nextSibling = scratch + numNodes;
+  stack = scratch + numNodes * 2;
+
+  for (n = 0; n < numNodes; n++){
+    firstChild[n] = LUX_DRAWSPATIAL_NONE;
+  }
+  // lists are in descending slot order, so the stack pops the
+  // lowest slot first
+  for (s = 1; s < numSlots; s++){
+    uint32 node = old.slotNodes[s];
+    uint32 parent;
+    if (nodeSlots[node] != s)
+      continue;
+    parent = nodeParents[node];
+    nextSibling[node] = firstChild[parent];
+    firstChild[parent] = node;
+  }
+
+  spatial->numSlotsAllocated = 0;
+  spatial->localMatrices = NULL;
+  spatial->worldMatrices = NULL;
+  spatial->localBoundings = NULL;
+  spatial->worldBoundings = NULL;
+  spatial->parents = NULL;
+  spatial->subtreeEnds = NULL;
+  spatial->slotNodes = NULL;
+  spatial->slotFlags = NULL;
+  spatial->dirty = NULL;
+  spatial->treeBoxes = NULL;
+  spatial->itemFirst = NULL;
+  spatial->refit = NULL;
+  if (Spatial_growSlots(spatial,numAllocated)){
+    *spatial = old;
+    lxMemoryAllocator_free(allocator,scratch,sizeof(uint32) * numNodes * 3);
+    return LUX_TRUE;
+  }
+
+  stack[stackSize++] = LUX_DRAWSPATIAL_ROOT;
+  while (stackSize){
+    uint32 node = stack[--stackSize];
+    uint32 oldSlot = nodeSlots[node];
+    uint32 child;
+
+    // parent was visited before and already has its new slot
+    spatial->parents[count] = node == LUX_DRAWSPATIAL_ROOT ? 0 : nodeSlots[nodeParents[node]];
+    spatial->slotNodes[count] = node;
+    spatial->slotFlags[count] = 0;
+    lxMatrix44Copy(spatial->localMatrices[count],old.localMatrices[oldSlot]);
+    spatial->localBoundings[count] = old.localBoundings[oldSlot];
+    nodeSlots[node] = count++;
+
+    for (child = firstChild[node]; child != LUX_DRAWSPATIAL_NONE; child = nextSibling[child]){
+      stack[stackSize++] = child;
+    }
+  }
+
+  for (s = 0; s < count; s++){
+    spatial->subtreeEnds[s] = s + 1;
+  }
+  for (s = count - 1; s > 0; s--){
+    uint32* end = &spatial->subtreeEnds[spatial->parents[s]];
+    *end = LUX_MAX(*end,spatial->subtreeEnds[s]);
+  }
+
+  // ids not reached are free, low ids are reused first
+  spatial->numFree = 0;
+  for (n = numNodes; n > 0; n--){
+    uint32 node = n - 1;
+    uint32 slot = nodeSlots[node];
+    if (slot >= count || spatial->slotNodes[slot] != node){
+      nodeSlots[node] = LUX_DRAWSPATIAL_NONE;
+      nodeParents[node] = LUX_DRAWSPATIAL_NONE;
+      spatial->freeNodes[spatial->numFree++] = node;
+    }
+  }
+
+  Spatial_freeSlotArrays(&old);
+  lxMemoryAllocator_free(allocator,scratch,sizeof(uint32) * numNodes * 3);
+
+  spatial->numSlots = count;
+  spatial->numDirty = 0;
+  spatial->reorder = LUX_FALSE;
+  return LUX_FALSE;
+}
+
+  // groups items by the slot of their node, drops removed items and
+  // those of removed nodes and rebuilds the free list. Items of a slot
+  // keep their relative order. Items are moved from the arrays in old,
+  // see Spatial_detachItems.
+static void Spatial_sortItems(lxDrawSpatial_t* spatial, lxDrawSpatial_t* old)
+{
+  uint32  numSlots = spatial->numSlots;
+  uint32  numItems = spatial->numItems;
+  uint32  numIDs = spatial->numItemIDs;
+  uint32* itemFirst = spatial->itemFirst;
+  uint32* itemPositions = spatial->itemPositions;
+  uint32* cursor = spatial->refit;
+  uint32  count;
+  uint32  i;
+
+  memset(itemFirst,0,sizeof(uint32) * (numSlots + 1));
+  for (i = 0; i < numItems; i++){
+    uint32 item = old->itemIDs[i];
+    uint32 slot;
+    if (itemPositions[item] != i)
+      continue;
+    slot = spatial->nodeSlots[spatial->itemNodes[item]];
+    if (slot == LUX_DRAWSPATIAL_NONE){
+      itemPositions[item] = LUX_DRAWSPATIAL_NONE;
+      continue;
+    }
+    itemFirst[slot + 1]++;
+  }
+  for (i = 0; i < numSlots; i++){
+    itemFirst[i + 1] += itemFirst[i];
+    cursor[i] = itemFirst[i];
+  }
+  count = itemFirst[numSlots];
+
+  for (i = 0; i < numItems; i++){
+    uint32 item = old->itemIDs[i];
+    uint32 pos;
+    if (itemPositions[item] != i)
+      continue;
+    pos = cursor[spatial->nodeSlots[spatial->itemNodes[item]]]++;
+    spatial->items[pos] = old->items[i];
+    spatial->itemLocalBoundings[pos] = old->itemLocalBoundings[i];
+    spatial->itemWorldBoundings[pos] = old->itemWorldBoundings[i];
+    spatial->itemIDs[pos] = item;
+    itemPositions[item] = pos;
+  }
+
+  spatial->numFreeItems = 0;
+  for (i = numIDs; i > 0; i--){
+    uint32 item = i - 1;
+    uint32 pos = itemPositions[item];
+    if (pos >= count || spatial->itemIDs[pos] != item){
+      itemPositions[item] = LUX_DRAWSPATIAL_NONE;
+      spatial->itemNodes[item] = LUX_DRAWSPATIAL_NONE;
+      spatial->freeItems[spatial->numFreeItems++] = item;
+    }
+  }
+
+  Spatial_freeItemArrays(old);
+  spatial->numItems = count;
+  spatial->itemsReorder = LUX_FALSE;
+}
+
+static int Spatial_compareSlots(const void* a, const void* b)
+{
+  uint32 sa = *(const uint32*)a;
+  uint32 sb = *(const uint32*)b;
+  return sa < sb ? -1 : (sa > sb ? 1 : 0);
+}
+
+static int Spatial_compareSlotsReverse(const void* a, const void* b)
+{
+  return Spatial_compareSlots(b,a);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Public
+
+LUX_API void lxDrawSpatial_init(lxDrawSpatial_t* spatial, lxMemoryAllocatorPTR allocator)
+{
+  memset(spatial,0,sizeof(lxDrawSpatial_t));
+  spatial->allocator = allocator;
+  // without root all nodes are invalid, adding fails
+  if (Spatial_growSlots(spatial,SPATIAL_MIN_ALLOC) ||
+      Spatial_growNodes(spatial,SPATIAL_MIN_ALLOC) ||
+      Spatial_growItems(spatial,SPATIAL_MIN_ALLOC) ||
+      Spatial_growItemIDs(spatial,SPATIAL_MIN_ALLOC))
+  {
+    return;
+  }
+
+  lxMatrix44Identity(spatial->localMatrices[0]);
+  Spatial_initBounding(&spatial->localBoundings[0]);
+  spatial->parents[0] = 0;
+  spatial->subtreeEnds[0] = 1;
+  spatial->slotNodes[0] = LUX_DRAWSPATIAL_ROOT;
+  spatial->slotFlags[0] = 0;
+  spatial->nodeSlots[LUX_DRAWSPATIAL_ROOT] = 0;
+  spatial->nodeParents[LUX_DRAWSPATIAL_ROOT] = LUX_DRAWSPATIAL_NONE;
+  spatial->itemFirst[0] = 0;
+  spatial->itemFirst[1] = 0;
+  spatial->numSlots = 1;
+  spatial->numNodes = 1;
+
+  Spatial_updateRange(spatial,0,1);
+  Spatial_refitSlot(spatial,0);
+}
+
+LUX_API void lxDrawSpatial_deinit(lxDrawSpatial_t* spatial)
+{
+  Spatial_freeSlotArrays(spatial);
+  Spatial_freeItemArrays(spatial);
+  Spatial_freeArrays(spatial,SPATIAL_ARRAYS(l_nodeArrays),spatial->numNodesAllocated);
+  Spatial_freeArrays(spatial,SPATIAL_ARRAYS(l_itemIDArrays),spatial->numItemIDsAllocated);
+  memset(spatial,0,sizeof(lxDrawSpatial_t));
+}
+
+LUX_API void lxDrawSpatial_reserve(lxDrawSpatial_t* spatial, uint32 numNodes)
+{
+  Spatial_growSlots(spatial,numNodes);
+  Spatial_growNodes(spatial,numNodes);
+}
+
+LUX_API uint32 lxDrawSpatial_addNode(lxDrawSpatial_t* spatial, uint32 parent)
+{
+  uint32 node;
+  uint32 slot;
+  uint32 parentSlot;
+
+  if (!Spatial_isValid(spatial,parent))
+    return LUX_DRAWSPATIAL_NONE;
+  if ((!spatial->numFree && Spatial_growNodes(spatial,spatial->numNodes + 1)) ||
+      Spatial_growSlots(spatial,spatial->numSlots + 1))
+  {
+    return LUX_DRAWSPATIAL_NONE;
+  }
+
+  if (spatial->numFree){
+    node = spatial->freeNodes[--spatial->numFree];
+  }
+  else{
+    node = spatial->numNodes++;
+  }
+  slot = spatial->numSlots++;
+  parentSlot = spatial->nodeSlots[parent];
+
+  lxMatrix44Identity(spatial->localMatrices[slot]);
+  Spatial_initBounding(&spatial->localBoundings[slot]);
+  spatial->parents[slot] = parentSlot;
+  spatial->subtreeEnds[slot] = slot + 1;
+  spatial->slotNodes[slot] = node;
+  spatial->slotFlags[slot] = 0;
+  spatial->itemFirst[slot + 1] = spatial->itemFirst[slot];
+  spatial->nodeSlots[node] = slot;
+  spatial->nodeParents[node] = parent;
+
+  // appending keeps depth first order only if the parent's subtree
+  // is the last one, then all its ancestors end there as well
+  if (!spatial->reorder){
+    if (spatial->subtreeEnds[parentSlot] == slot){
+      uint32 s = parentSlot;
+      while (1){
+        spatial->subtreeEnds[s] = slot + 1;
+        if (s == 0)
+          break;
+        s = spatial->parents[s];
+      }
+      Spatial_setDirty(spatial,slot);
+    }
+    else{
+      spatial->reorder = LUX_TRUE;
+    }
+  }
+
+  return node;
+}
+
+LUX_API void lxDrawSpatial_remNode(lxDrawSpatial_t* spatial, uint32 node)
+{
+  if (node == LUX_DRAWSPATIAL_ROOT || !Spatial_isValid(spatial,node))
+    return;
+
+  // descendants are dropped with the next re-order, meanwhile
+  // Spatial_isValid finds them invalid through their parent chain
+  spatial->nodeSlots[node] = LUX_DRAWSPATIAL_NONE;
+  spatial->reorder = LUX_TRUE;
+}
+
+LUX_API booln lxDrawSpatial_setParent(lxDrawSpatial_t* spatial, uint32 node, uint32 parent)
+{
+  uint32 walk;
+
+  if (node == LUX_DRAWSPATIAL_ROOT || !Spatial_isValid(spatial,node) || !Spatial_isValid(spatial,parent))
+    return LUX_TRUE;
+  if (spatial->nodeParents[node] == parent)
+    return LUX_FALSE;
+
+  for (walk = parent; walk != LUX_DRAWSPATIAL_NONE; walk = spatial->nodeParents[walk]){
+    if (walk == node)
+      return LUX_TRUE;
+  }
+
+  spatial->nodeParents[node] = parent;
+  spatial->reorder = LUX_TRUE;
+  return LUX_FALSE;
+}
+
+LUX_API uint32 lxDrawSpatial_getParent(const lxDrawSpatial_t* spatial, uint32 node)
+{
+  return Spatial_isValid(spatial,node) ? spatial->nodeParents[node] : LUX_DRAWSPATIAL_NONE;
+}
+
+LUX_API void lxDrawSpatial_setLocalMatrix(lxDrawSpatial_t* spatial, uint32 node, lxMatrix44CPTR matrix)
+{
+  uint32 slot = spatial->nodeSlots[node];
+  LUX_DEBUGASSERT(Spatial_isValid(spatial,node));
+
+  lxMatrix44Copy(spatial->localMatrices[slot],matrix);
+  Spatial_setDirty(spatial,slot);
+}
+
+LUX_API lxMatrix44CPTR lxDrawSpatial_getLocalMatrix(const lxDrawSpatial_t* spatial, uint32 node)
+{
+  LUX_DEBUGASSERT(Spatial_isValid(spatial,node));
+  return spatial->localMatrices[spatial->nodeSlots[node]];
+}
+
+LUX_API lxMatrix44CPTR lxDrawSpatial_getWorldMatrix(const lxDrawSpatial_t* spatial, uint32 node)
+{
+  LUX_DEBUGASSERT(Spatial_isValid(spatial,node));
+  return spatial->worldMatrices[spatial->nodeSlots[node]];
+}
+
+LUX_API void lxDrawSpatial_setBounding(lxDrawSpatial_t* spatial, uint32 node, const lxDrawBounding_t* bounding)
+{
+  uint32 slot = spatial->nodeSlots[node];
+  LUX_DEBUGASSERT(Spatial_isValid(spatial,node));
+
+  spatial->localBoundings[slot] = *bounding;
+  Spatial_setDirty(spatial,slot);
+}
+
+LUX_API void lxDrawSpatial_addBounding(lxDrawSpatial_t* spatial, uint32 node, const lxDrawBounding_t* bounding)
+{
+  uint32 slot = spatial->nodeSlots[node];
+  lxDrawBounding_t* local = &spatial->localBoundings[slot];
+  LUX_DEBUGASSERT(Spatial_isValid(spatial,node));
+
+  if (bounding->bsphere.radius < 0.0f)
+    return;
+
+  if (local->bsphere.radius < 0.0f){
+    *local = *bounding;
+  }
+  else{
+    lxBoundingSphere_t sphere;
+    lxBoundingSphere_mergeChange(&sphere,&local->bsphere,&bounding->bsphere);
+    local->bsphere = sphere;
+    lxVector3Min(local->bbox.min,local->bbox.min,bounding->bbox.min);
+    lxVector3Max(local->bbox.max,local->bbox.max,bounding->bbox.max);
+  }
+  Spatial_setDirty(spatial,slot);
+}
+
+LUX_API const lxDrawBounding_t* lxDrawSpatial_getWorldBounding(const lxDrawSpatial_t* spatial, uint32 node)
+{
+  LUX_DEBUGASSERT(Spatial_isValid(spatial,node));
+  return &spatial->worldBoundings[spatial->nodeSlots[node]];
+}
+
+LUX_API void lxDrawSpatial_updateTree(lxDrawSpatial_t* spatial)
+{
+  lxDrawSpatial_t old;
+  uint32* dirty;
+  uint32  numDirty;
+  uint32  i;
+
+  // on allocation failure the pending changes stay queued and
+  // the tree keeps its last state
+
+  if (spatial->reorder){
+    // items are sorted by the new slots, so they are allocated first
+    if (Spatial_detachItems(spatial,&old))
+      return;
+    if (Spatial_reorder(spatial)){
+      Spatial_freeItemArrays(spatial);
+      spatial->numItemsAllocated = old.numItemsAllocated;
+      spatial->items = old.items;
+      spatial->itemLocalBoundings = old.itemLocalBoundings;
+      spatial->itemWorldBoundings = old.itemWorldBoundings;
+      spatial->itemIDs = old.itemIDs;
+      return;
+    }
+    Spatial_sortItems(spatial,&old);
+    Spatial_updateRange(spatial,0,spatial->numSlots);
+    Spatial_refitRange(spatial,0,spatial->numSlots);
+    return;
+  }
+  // slots of changed items are dirty
+  if (spatial->itemsReorder){
+    if (Spatial_detachItems(spatial,&old))
+      return;
+    Spatial_sortItems(spatial,&old);
+  }
+
+  dirty = spatial->dirty;
+  numDirty = spatial->numDirty;
+  if (!numDirty)
+    return;
+
+  if (numDirty * SPATIAL_FULL_SWEEP >= spatial->numSlots){
+    // scan flags in slot order, skipping covered ranges
+    const byte* flags = spatial->slotFlags;
+    uint32 numSlots = spatial->numSlots;
+    uint32 slot = 0;
+
+    while (slot < numSlots){
+      if (flags[slot] & SPATIAL_FLAG_DIRTY){
+        slot = Spatial_updateSubtree(spatial,slot);
+      }
+      else{
+        slot++;
+      }
+    }
+  }
+  else{
+    // ranges of dirty descendants are contained in the
+    // range of a dirty ancestor that sorts before them
+    uint32 covered = 0;
+
+    qsort(dirty,numDirty,sizeof(uint32),Spatial_compareSlots);
+    for (i = 0; i < numDirty; i++){
+      uint32 slot = dirty[i];
+      if (slot < covered)
+        continue;
+      covered = Spatial_updateSubtree(spatial,slot);
+    }
+  }
+
+  // ancestors of updated subtrees, deepest first
+  qsort(spatial->refit,spatial->numRefit,sizeof(uint32),Spatial_compareSlotsReverse);
+  for (i = 0; i < spatial->numRefit; i++){
+    Spatial_refitSlot(spatial,spatial->refit[i]);
+    spatial->slotFlags[spatial->refit[i]] = 0;
+  }
+  spatial->numRefit = 0;
+
+  for (i = 0; i < numDirty; i++){
+    spatial->slotFlags[dirty[i]] = 0;
+  }
+  spatial->numDirty = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Items
+
+LUX_API uint32 lxDrawSpatial_addItem(lxDrawSpatial_t* spatial, uint32 node, const lxDrawItem_t* item, const lxDrawBounding_t* bounding)
+{
+  uint32 id;
+  uint32 pos;
+
+  if (!Spatial_isValid(spatial,node))
+    return LUX_DRAWSPATIAL_NONE;
+  if ((!spatial->numFreeItems && Spatial_growItemIDs(spatial,spatial->numItemIDs + 1)) ||
+      Spatial_growItems(spatial,spatial->numItems + 1))
+  {
+    return LUX_DRAWSPATIAL_NONE;
+  }
+
+  if (spatial->numFreeItems){
+    id = spatial->freeItems[--spatial->numFreeItems];
+  }
+  else{
+    id = spatial->numItemIDs++;
+  }
+  pos = spatial->numItems++;
+
+  spatial->items[pos] = *item;
+  spatial->items[pos].spatial = spatial;
+  spatial->items[pos].spatialNode = node;
+  spatial->itemLocalBoundings[pos] = *bounding;
+  spatial->itemIDs[pos] = id;
+  spatial->itemPositions[id] = pos;
+  spatial->itemNodes[id] = node;
+
+  spatial->itemsReorder = LUX_TRUE;
+  Spatial_setDirty(spatial,spatial->nodeSlots[node]);
+
+  return id;
+}
+
+LUX_API void lxDrawSpatial_remItem(lxDrawSpatial_t* spatial, uint32 item)
+{
+  uint32 slot;
+
+  if (!Spatial_isValidItem(spatial,item))
+    return;
+
+  // node may be removed already
+  slot = spatial->nodeSlots[spatial->itemNodes[item]];
+  spatial->itemPositions[item] = LUX_DRAWSPATIAL_NONE;
+  spatial->itemsReorder = LUX_TRUE;
+  if (slot != LUX_DRAWSPATIAL_NONE){
+    Spatial_setDirty(spatial,slot);
+  }
+}
+
+LUX_API void lxDrawSpatial_setItemBounding(lxDrawSpatial_t* spatial, uint32 item, const lxDrawBounding_t* bounding)
+{
+  uint32 slot;
+  LUX_DEBUGASSERT(Spatial_isValidItem(spatial,item));
+
+  spatial->itemLocalBoundings[spatial->itemPositions[item]] = *bounding;
+  slot = spatial->nodeSlots[spatial->itemNodes[item]];
+  if (slot != LUX_DRAWSPATIAL_NONE){
+    Spatial_setDirty(spatial,slot);
+  }
+}
+
+LUX_API lxDrawItem_t* lxDrawSpatial_getItem(lxDrawSpatial_t* spatial, uint32 item)
+{
+  return Spatial_isValidItem(spatial,item) ? &spatial->items[spatial->itemPositions[item]] : NULL;
+}
+
+LUX_API const lxDrawBounding_t* lxDrawSpatial_getItemWorldBounding(const lxDrawSpatial_t* spatial, uint32 item)
+{
+  LUX_DEBUGASSERT(Spatial_isValidItem(spatial,item));
+  return &spatial->itemWorldBoundings[spatial->itemPositions[item]];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Culling
+
+  // sphere against the planes of mask, only planes the sphere
+  // intersects are left for the box test
+static LUX_INLINE booln Spatial_isItemVisible(lxFrustumCPTR frustum, const lxDrawBounding_t* bounding, int mask, int* startPlane)
+{
+  const lxBoundingSphere_t* sphere = &bounding->bsphere;
+  int   boxMask = 0;
+  int   outMask;
+  int   i;
+
+  for (i = 0; i < LUX_FRUSTUM_PLANES; i++){
+    const float* plane = frustum->fplanes[i].pvec;
+    float dist;
+    if (!(mask & (1<<i)))
+      continue;
+    dist = plane[0] * sphere->center[0] + plane[1] * sphere->center[1] + plane[2] * sphere->center[2] + plane[3];
+    if (dist <= -sphere->radius)
+      return LUX_FALSE;
+    if (dist < sphere->radius)
+      boxMask |= 1<<i;
+  }
+
+  return !boxMask || lxFrustum_cullBoundingBoxMaskedCoherent(frustum,&bounding->bbox,boxMask,&outMask,startPlane) != LUX_CULL_OUTSIDE;
+}
+
+  // one of items, ids or positions is set
+typedef struct SpatialOutput_s{
+  lxDrawItem_t*   items;
+  uint32*         ids;
+  uint32*         positions;
+}SpatialOutput_t;
+
+static LUX_INLINE uint32 Spatial_appendItems(const lxDrawSpatial_t* spatial, const SpatialOutput_t* out,
+  uint32 count, uint32 maxItems, uint32 begin, uint32 end)
+{
+  end = LUX_MIN(end,begin + maxItems - count);
+  if (out->items){
+    memcpy(out->items + count,spatial->items + begin,sizeof(lxDrawItem_t) * (end - begin));
+  }
+  else if (out->ids){
+    memcpy(out->ids + count,spatial->itemIDs + begin,sizeof(uint32) * (end - begin));
+  }
+  else{
+    uint32* positions = out->positions + count;
+    uint32  i;
+    for (i = begin; i < end; i++){
+      *positions++ = i;
+    }
+  }
+  return count + end - begin;
+}
+
+  // slots of [begin,rangeEnd) are visited in depth first order, stack
+  // holds the plane masks of the open subtrees. Subtrees are clipped to
+  // the range, so any range can be culled on its own, slots whose
+  // parent is outside start with all planes.
+static uint32 Spatial_cull(const lxDrawSpatial_t* spatial, lxFrustumCPTR frustum, uint32 begin, uint32 rangeEnd,
+  const SpatialOutput_t* out, uint32 maxItems)
+{
+  struct {
+    uint32  end;
+    int     mask;
+  } stack[SPATIAL_CULL_DEPTH];
+  const lxBoundingBox_t* treeBoxes = spatial->treeBoxes;
+  const uint32* subtreeEnds = spatial->subtreeEnds;
+  const uint32* itemFirst = spatial->itemFirst;
+  const lxDrawBounding_t* itemWorldBoundings = spatial->itemWorldBoundings;
+  uint32  count = 0;
+  uint32  slot = begin;
+  int     startPlane = 0;
+  int     itemPlane = 0;
+  int     top = 0;
+
+  stack[0].end = rangeEnd;
+  stack[0].mask = (1 << LUX_FRUSTUM_PLANES) - 1;
+
+  while (slot < rangeEnd && count < maxItems){
+    const lxBoundingBox_t* box = &treeBoxes[slot];
+    uint32  end = LUX_MIN(subtreeEnds[slot],rangeEnd);
+    uint32  i;
+    int     mask;
+
+    while (slot >= stack[top].end){
+      top--;
+    }
+
+    // empty subtree
+    if (box->min[0] > box->max[0] ||
+      lxFrustum_cullBoundingBoxMaskedCoherent(frustum,box,stack[top].mask,&mask,&startPlane) == LUX_CULL_OUTSIDE)
+    {
+      slot = end;
+      continue;
+    }
+
+    if (!mask){
+      // subtrees cover a continuous range of items
+      count = Spatial_appendItems(spatial,out,count,maxItems,itemFirst[slot],itemFirst[end]);
+      slot = end;
+      continue;
+    }
+
+    for (i = itemFirst[slot]; i < itemFirst[slot + 1] && count < maxItems; i++){
+      if (Spatial_isItemVisible(frustum,&itemWorldBoundings[i],mask,&itemPlane)){
+        count = Spatial_appendItems(spatial,out,count,maxItems,i,i + 1);
+      }
+    }
+
+    // when too deep, children use the mask of an ancestor,
+    // which has more planes to test but is still correct
+    if (end > slot + 1 && top + 1 < SPATIAL_CULL_DEPTH){
+      top++;
+      stack[top].end = end;
+      stack[top].mask = mask;
+    }
+    slot++;
+  }
+
+  return count;
+}
+
+LUX_API uint32 lxDrawSpatial_getVisibleItems(const lxDrawSpatial_t* spatial, lxFrustumCPTR frustum, lxDrawItem_t* itembuffer, uint32 maxItems)
+{
+  SpatialOutput_t out = {itembuffer,NULL,NULL};
+  return Spatial_cull(spatial,frustum,0,spatial->numSlots,&out,maxItems);
+}
+
+LUX_API uint32 lxDrawSpatial_getVisibleIDs(const lxDrawSpatial_t* spatial, lxFrustumCPTR frustum, uint32* ids, uint32 maxItems)
+{
+  SpatialOutput_t out = {NULL,ids,NULL};
+  return Spatial_cull(spatial,frustum,0,spatial->numSlots,&out,maxItems);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Multi-view culling
+
+typedef struct SpatialViewJobs_s{
+  const lxDrawSpatial_t*  spatial;
+  lxDrawSpatialView_t*    views;
+  uint32                  numUnits;
+    // slot range of unit is [unitSlots[u],unitSlots[u+1])
+  uint32*                 unitSlots;
+    // per job, view major
+  uint32*                 counts;
+  uint32*                 offsets;
+    // item positions, numItems per view, unit chunks start at
+    // the first item of their range
+  uint32*                 positions;
+}SpatialViewJobs_t;
+
+static void Spatial_cullViewJob(void* userdata, uint jobindex, uint threadindex)
+{
+  SpatialViewJobs_t* jobs = (SpatialViewJobs_t*)userdata;
+  const lxDrawSpatial_t* spatial = jobs->spatial;
+  uint32 view = jobindex / jobs->numUnits;
+  uint32 unit = jobindex % jobs->numUnits;
+  uint32 begin = jobs->unitSlots[unit];
+  uint32 end = jobs->unitSlots[unit + 1];
+  SpatialOutput_t out;
+
+  out.items = NULL;
+  out.ids = NULL;
+  out.positions = jobs->positions + (size_t)view * spatial->numItems + spatial->itemFirst[begin];
+  jobs->counts[jobindex] = Spatial_cull(spatial,jobs->views[view].frustum,begin,end,&out,
+    spatial->itemFirst[end] - spatial->itemFirst[begin]);
+}
+
+static void Spatial_mergeViewJob(void* userdata, uint jobindex, uint threadindex)
+{
+  SpatialViewJobs_t* jobs = (SpatialViewJobs_t*)userdata;
+  const lxDrawSpatial_t* spatial = jobs->spatial;
+  lxDrawSpatialView_t* view = &jobs->views[jobindex / jobs->numUnits];
+  uint32 unit = jobindex % jobs->numUnits;
+  const uint32* positions = jobs->positions + (size_t)(jobindex / jobs->numUnits) * spatial->numItems +
+    spatial->itemFirst[jobs->unitSlots[unit]];
+  uint32 offset = jobs->offsets[jobindex];
+  uint32 count = jobs->counts[jobindex];
+  uint32 i;
+
+  if (view->items){
+    lxDrawItem_t* items = view->items + offset;
+    for (i = 0; i < count; i++){
+      items[i] = spatial->items[positions[i]];
+    }
+  }
+  else{
+    uint32* ids = view->ids + offset;
+    for (i = 0; i < count; i++){
+      ids[i] = spatial->itemIDs[positions[i]];
+    }
+  }
+}
+
+LUX_API void lxDrawSpatial_cullViews(const lxDrawSpatial_t* spatial, lxJobPoolPTR pool, lxDrawSpatialView_t* views, uint32 numViews)
+{
+  lxMemoryAllocatorPTR allocator = spatial->allocator;
+  uint32  numItems = spatial->numItems;
+  uint32  numThreads = pool ? lxJobPool_getThreadCount(pool) : 1;
+  uint32  numUnits;
+  uint32  numJobs;
+  size_t  scratchSize;
+  SpatialViewJobs_t jobs;
+  uint32  u;
+  uint32  v;
+
+  if (!numViews)
+    return;
+
+  // enough jobs to balance the threads, but not too small
+  numUnits = numThreads > 1 ? (numThreads * SPATIAL_VIEW_JOBS + numViews - 1) / numViews : 1;
+  numUnits = LUX_MAX(LUX_MIN(numUnits,numItems / SPATIAL_VIEW_MIN_ITEMS),1);
+  numJobs = numUnits * numViews;
+
+  scratchSize = sizeof(uint32) * ((size_t)numItems * numViews + numUnits + 1 + numJobs * 2);
+  jobs.spatial = spatial;
+  jobs.views = views;
+  jobs.numUnits = numUnits;
+  jobs.positions = (uint32*)lxMemoryAllocator_malloc(allocator,scratchSize);
+  jobs.unitSlots = jobs.positions + (size_t)numItems * numViews;
+  jobs.counts = jobs.unitSlots + numUnits + 1;
+  jobs.offsets = jobs.counts + numJobs;
+
+  // units have about the same number of items, the first slot
+  // with itemFirst >= the split is found by binary search
+  jobs.unitSlots[0] = 0;
+  for (u = 1; u < numUnits; u++){
+    uint32 split = (uint32)(((uint64)numItems * u) / numUnits);
+    uint32 lo = jobs.unitSlots[u - 1];
+    uint32 hi = spatial->numSlots;
+    while (lo < hi){
+      uint32 mid = (lo + hi) / 2;
+      if (spatial->itemFirst[mid] < split){
+        lo = mid + 1;
+      }
+      else{
+        hi = mid;
+      }
+    }
+    jobs.unitSlots[u] = lo;
+  }
+  jobs.unitSlots[numUnits] = spatial->numSlots;
+
+  lxJobPool_run(pool,numJobs,Spatial_cullViewJob,&jobs);
+
+  // chunks are concatenated in slot order, which gives the same
+  // result as the single view functions
+  for (v = 0; v < numViews; v++){
+    uint32 offset = 0;
+    for (u = 0; u < numUnits; u++){
+      uint32 job = v * numUnits + u;
+      uint32 count = LUX_MIN(jobs.counts[job],views[v].maxItems - offset);
+      jobs.counts[job] = count;
+      jobs.offsets[job] = offset;
+      offset += count;
+    }
+    views[v].numItems = offset;
+  }
+
+  lxJobPool_run(pool,numJobs,Spatial_mergeViewJob,&jobs);
+
+  lxMemoryAllocator_free(allocator,jobs.positions,scratchSize);
+}
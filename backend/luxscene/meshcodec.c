@@ -0,0 +1,394 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/meshcodec.h>
+#include <string.h>
+
+// Code byte of a triangle record:
+//  high nibble 0..14   triangle starts with edge of FIFO entry (newest
+//                      first), low nibble is the third vertex:
+//                      0 next, 1..14 vertex FIFO entry, 15 varint
+//  high nibble 15      no shared edge, bit i of the low nibble is set
+//                      when vertex i is next, others are varints
+//
+// Edges are stored in the direction a neighboring triangle with the
+// same winding traverses them.
+
+#define MESHCODEC_NOEDGE      15
+#define MESHCODEC_EXPLICIT    15
+
+static LUX_INLINE uint32 MeshCodec_zigzag(uint32 delta)
+{
+  return (delta << 1) ^ (uint32)((int32)delta >> 31);
+}
+
+static LUX_INLINE uint32 MeshCodec_unzigzag(uint32 v)
+{
+  return (v >> 1) ^ (uint32)(-(int32)(v & 1));
+}
+
+static LUX_INLINE byte* MeshCodec_writeVarint(byte* out, uint32 v)
+{
+  while (v >= 0x80){
+    *out++ = (byte)(v | 0x80);
+    v >>= 7;
+  }
+  *out++ = (byte)v;
+  return out;
+}
+
+  // at most 5 bytes are read
+static LUX_INLINE const byte* MeshCodec_readVarint(const byte* in, uint32* v)
+{
+  uint32 result = 0;
+  uint  shift;
+  for (shift = 0; shift < 35; shift += 7){
+    byte b = *in++;
+    result |= (uint32)(b & 0x7F) << shift;
+    if (!(b & 0x80)) break;
+  }
+  *v = result;
+  return in;
+}
+
+static LUX_INLINE void MeshCodec_pushEdge(lxMeshIndexDecoder_t* state, uint32 a, uint32 b)
+{
+  uint32* edge = state->edges[state->edgeOffset & 15];
+  edge[0] = a;
+  edge[1] = b;
+  state->edgeOffset++;
+}
+
+static LUX_INLINE void MeshCodec_pushVertex(lxMeshIndexDecoder_t* state, uint32 v)
+{
+  state->vertices[state->vertexOffset & 15] = v;
+  state->vertexOffset++;
+}
+
+static LUX_INLINE uint32 MeshCodec_getIndex(const void* indices, int i, lxMeshIndexType_t type)
+{
+  return type == LUX_MESH_INDEX_UINT16 ? ((const uint16*)indices)[i] : ((const uint32*)indices)[i];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Encoder
+
+LUX_API size_t lxMeshIndexCodec_getMaxSize(int numIndices)
+{
+  return 1 + (size_t)(numIndices / 3) * LUX_MESHCODEC_MAX_RECORD;
+}
+
+  // returns vertex FIFO entry + 1 or 0
+static LUX_INLINE uint MeshCodec_findVertex(const lxMeshIndexDecoder_t* state, uint32 v)
+{
+  uint i;
+  for (i = 0; i < LUX_MESHCODEC_VERTICES; i++){
+    if (state->vertices[(state->vertexOffset - 1 - i) & 15] == v){
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+LUX_API size_t lxMeshIndexCodec_encode(void* dst, size_t dstSize, const void* indices, int numIndices, lxMeshIndexType_t type)
+{
+  lxMeshIndexDecoder_t state;
+  byte* out = (byte*)dst;
+  byte* end = out + dstSize;
+  int t;
+
+  if (numIndices % 3 || dstSize < 1 ||
+      (type != LUX_MESH_INDEX_UINT16 && type != LUX_MESH_INDEX_UINT32))
+  {
+    return 0;
+  }
+
+  lxMeshIndexDecoder_init(&state);
+  *out++ = LUX_MESHCODEC_VERSION;
+
+  for (t = 0; t < numIndices; t += 3){
+    uint32 tri[3];
+    uint  bestEdge = MESHCODEC_NOEDGE;
+    uint  bestRot = 0;
+    uint  bestCost = 3;
+    uint  k,r;
+
+    if (out + LUX_MESHCODEC_MAX_RECORD > end)
+      return 0;
+
+    tri[0] = MeshCodec_getIndex(indices,t+0,type);
+    tri[1] = MeshCodec_getIndex(indices,t+1,type);
+    tri[2] = MeshCodec_getIndex(indices,t+2,type);
+
+    // shared edge with the cheapest third vertex
+    for (k = 0; k < LUX_MESHCODEC_EDGES && bestCost; k++){
+      const uint32* edge = state.edges[(state.edgeOffset - 1 - k) & 15];
+      for (r = 0; r < 3; r++){
+        if (edge[0] == tri[r] && edge[1] == tri[(r+1)%3]){
+          uint32 c = tri[(r+2)%3];
+          uint cost = c == state.next ? 0 : (MeshCodec_findVertex(&state,c) ? 1 : 2);
+          if (cost < bestCost){
+            bestCost = cost;
+            bestEdge = k;
+            bestRot = r;
+          }
+        }
+      }
+    }
+
+    if (bestEdge != MESHCODEC_NOEDGE){
+      uint32 a = tri[bestRot];
+      uint32 b = tri[(bestRot+1)%3];
+      uint32 c = tri[(bestRot+2)%3];
+      uint  fifo = MeshCodec_findVertex(&state,c);
+
+      if (c == state.next){
+        *out++ = (byte)(bestEdge << 4);
+        state.next++;
+      }
+      else if (fifo){
+        *out++ = (byte)((bestEdge << 4) | fifo);
+      }
+      else{
+        *out++ = (byte)((bestEdge << 4) | MESHCODEC_EXPLICIT);
+        out = MeshCodec_writeVarint(out,MeshCodec_zigzag(c - state.last));
+        state.last = c;
+      }
+
+      MeshCodec_pushVertex(&state,c);
+      MeshCodec_pushEdge(&state,c,b);
+      MeshCodec_pushEdge(&state,a,c);
+    }
+    else{
+      byte* code = out++;
+      uint  flags = 0;
+
+      for (r = 0; r < 3; r++){
+        if (tri[r] == state.next){
+          flags |= 1 << r;
+          state.next++;
+        }
+        else{
+          out = MeshCodec_writeVarint(out,MeshCodec_zigzag(tri[r] - state.last));
+          state.last = tri[r];
+        }
+      }
+      *code = (byte)((MESHCODEC_NOEDGE << 4) | flags);
+
+      MeshCodec_pushVertex(&state,tri[0]);
+      MeshCodec_pushVertex(&state,tri[1]);
+      MeshCodec_pushVertex(&state,tri[2]);
+      MeshCodec_pushEdge(&state,tri[1],tri[0]);
+      MeshCodec_pushEdge(&state,tri[2],tri[1]);
+      MeshCodec_pushEdge(&state,tri[0],tri[2]);
+    }
+  }
+
+  return out - (byte*)dst;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Decoder
+
+LUX_API void lxMeshIndexDecoder_init(lxMeshIndexDecoder_t* dec)
+{
+  memset(dec->edges,0xFF,sizeof(dec->edges));
+  memset(dec->vertices,0xFF,sizeof(dec->vertices));
+  dec->edgeOffset = 0;
+  dec->vertexOffset = 0;
+  dec->next = 0;
+  dec->last = 0;
+  dec->started = LUX_FALSE;
+  dec->carrySize = 0;
+}
+
+  // size of the record at in, 0 if incomplete, -1 if invalid
+static int MeshCodec_recordSize(const byte* in, size_t avail)
+{
+  uint  code;
+  uint  varints;
+  uint  size = 1;
+  uint  i,n;
+
+  if (!avail)
+    return 0;
+
+  code = in[0];
+  if ((code >> 4) != MESHCODEC_NOEDGE){
+    varints = (code & 15) == MESHCODEC_EXPLICIT;
+  }
+  else{
+    if (code & 8) return -1;
+    varints = 3 - ((code & 1) + ((code >> 1) & 1) + ((code >> 2) & 1));
+  }
+
+  for (i = 0; i < varints; i++){
+    for (n = 0; ; n++){
+      if (size >= avail) return 0;
+      if (!(in[size++] & 0x80)) break;
+      if (n == 4) return -1;
+    }
+  }
+  return size;
+}
+
+  // record must be complete, returns NULL if invalid
+static LUX_INLINE const byte* MeshCodec_decodeTriangle(lxMeshIndexDecoder_t* LUX_RESTRICT dec, const byte* in, uint32* LUX_RESTRICT tri)
+{
+  uint  code = *in++;
+
+  if ((code >> 4) != MESHCODEC_NOEDGE){
+    const uint32* edge = dec->edges[(dec->edgeOffset - 1 - (code >> 4)) & 15];
+    uint  cv = code & 15;
+    uint32 a = edge[0];
+    uint32 b = edge[1];
+    uint32 c;
+
+    if (cv == 0){
+      c = dec->next++;
+    }
+    else if (cv != MESHCODEC_EXPLICIT){
+      c = dec->vertices[(dec->vertexOffset - cv) & 15];
+    }
+    else{
+      uint32 v;
+      in = MeshCodec_readVarint(in,&v);
+      c = dec->last + MeshCodec_unzigzag(v);
+      dec->last = c;
+    }
+
+    tri[0] = a;
+    tri[1] = b;
+    tri[2] = c;
+    MeshCodec_pushVertex(dec,c);
+    MeshCodec_pushEdge(dec,c,b);
+    MeshCodec_pushEdge(dec,a,c);
+  }
+  else{
+    uint r;
+    if (code & 8)
+      return NULL;
+
+    for (r = 0; r < 3; r++){
+      if (code & (1 << r)){
+        tri[r] = dec->next++;
+      }
+      else{
+        uint32 v;
+        in = MeshCodec_readVarint(in,&v);
+        tri[r] = dec->last + MeshCodec_unzigzag(v);
+        dec->last = tri[r];
+      }
+    }
+
+    MeshCodec_pushVertex(dec,tri[0]);
+    MeshCodec_pushVertex(dec,tri[1]);
+    MeshCodec_pushVertex(dec,tri[2]);
+    MeshCodec_pushEdge(dec,tri[1],tri[0]);
+    MeshCodec_pushEdge(dec,tri[2],tri[1]);
+    MeshCodec_pushEdge(dec,tri[0],tri[2]);
+  }
+
+  return in;
+}
+
+static LUX_INLINE void MeshCodec_store(void* dst, int written, const uint32* tri, lxMeshIndexType_t type)
+{
+  if (type == LUX_MESH_INDEX_UINT16){
+    uint16* out = (uint16*)dst + written;
+    out[0] = (uint16)tri[0];
+    out[1] = (uint16)tri[1];
+    out[2] = (uint16)tri[2];
+  }
+  else{
+    uint32* out = (uint32*)dst + written;
+    out[0] = tri[0];
+    out[1] = tri[1];
+    out[2] = tri[2];
+  }
+}
+
+LUX_API int lxMeshIndexDecoder_run(lxMeshIndexDecoder_t* dec, void* dst, int maxIndices,
+  const void* src, size_t srcSize, size_t* srcUsed, lxMeshIndexType_t type)
+{
+  const byte* in = (const byte*)src;
+  const byte* end = in + srcSize;
+  int written = 0;
+  uint32 tri[3];
+
+  *srcUsed = 0;
+  if (type != LUX_MESH_INDEX_UINT16 && type != LUX_MESH_INDEX_UINT32)
+    return -1;
+
+  if (!dec->started){
+    if (in == end)
+      return 0;
+    if (*in++ != LUX_MESHCODEC_VERSION)
+      return -1;
+    dec->started = LUX_TRUE;
+  }
+
+  // complete the record left over from the previous chunk
+  if (dec->carrySize && written + 3 <= maxIndices){
+    size_t  copied = LUX_MIN((size_t)(LUX_MESHCODEC_MAX_RECORD - dec->carrySize),(size_t)(end - in));
+    int     size;
+
+    memcpy(dec->carry + dec->carrySize,in,copied);
+    size = MeshCodec_recordSize(dec->carry,dec->carrySize + copied);
+    if (size < 0)
+      return -1;
+    if (size == 0){
+      dec->carrySize += (uint)copied;
+      *srcUsed = srcSize;
+      return 0;
+    }
+    if (!MeshCodec_decodeTriangle(dec,dec->carry,tri))
+      return -1;
+    MeshCodec_store(dst,written,tri,type);
+    written += 3;
+    in += size - dec->carrySize;
+    dec->carrySize = 0;
+  }
+
+  // records that cannot cross the end need no checks
+  while (written + 3 <= maxIndices && end - in >= LUX_MESHCODEC_MAX_RECORD){
+    in = MeshCodec_decodeTriangle(dec,in,tri);
+    if (!in)
+      return -1;
+    MeshCodec_store(dst,written,tri,type);
+    written += 3;
+  }
+
+  while (written + 3 <= maxIndices && in != end){
+    int size = MeshCodec_recordSize(in,end - in);
+    if (size < 0)
+      return -1;
+    if (size == 0){
+      dec->carrySize = (uint)(end - in);
+      memcpy(dec->carry,in,dec->carrySize);
+      in = end;
+      break;
+    }
+    if (!MeshCodec_decodeTriangle(dec,in,tri))
+      return -1;
+    MeshCodec_store(dst,written,tri,type);
+    written += 3;
+    in += size;
+  }
+
+  *srcUsed = in - (const byte*)src;
+  return written;
+}
+
+LUX_API booln lxMeshIndexCodec_decode(void* dst, int numIndices, const void* src, size_t srcSize, lxMeshIndexType_t type)
+{
+  lxMeshIndexDecoder_t dec;
+  size_t used;
+  int written;
+
+  lxMeshIndexDecoder_init(&dec);
+  written = lxMeshIndexDecoder_run(&dec,dst,numIndices,src,srcSize,&used,type);
+
+  return written != numIndices || used != srcSize || dec.carrySize;
+}
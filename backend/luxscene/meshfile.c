@@ -0,0 +1,383 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/meshfile.h>
+#include <luxinia/luxcore/scalarmisc.h>
+#include <luxinia/luxmath/bounding.h>
+#include <string.h>
+
+typedef struct MeshFileLayout_s{
+  size_t    indexSize;
+  uint32    numIndices;
+  uint32    numVertices;
+  size_t    strides[LUXGFX_MAX_VERTEX_STREAMS];
+}MeshFileLayout_t;
+
+static LUX_INLINE uint64 MeshFile_align(uint64 offset)
+{
+  return (offset + (LUX_MESHFILE_ALIGN - 1)) & ~(uint64)(LUX_MESHFILE_ALIGN - 1);
+}
+
+static uint32 MeshFile_getElementProbe()
+{
+  // distinct values in every field
+  lxgVertexElement_t elem = lxgVertexElement_set(3,LUX_SCALAR_UINT16,LUX_TRUE,LUX_FALSE,180,165,9);
+  uint32  probe = 0;
+
+  memcpy(&probe,&elem,LUX_MIN(sizeof(elem),sizeof(probe)));
+  return probe;
+}
+
+  // returns TRUE if geometry cannot be stored
+static booln MeshFile_getLayout(const lxDrawGeometry_t* geometry, MeshFileLayout_t* layout)
+{
+  lxgVertexDeclCPTR decl = geometry->vertexDecl;
+  size_t  numIndices;
+  int     numVertices = -1;
+  int     i;
+
+  memset(layout,0,sizeof(MeshFileLayout_t));
+
+  switch(geometry->indexType){
+  case LUX_SCALAR_UINT16:
+  case LUX_SCALAR_UINT32:
+    layout->indexSize = lxScalarType_getSize(geometry->indexType);
+    break;
+  default:
+    return LUX_TRUE;
+  }
+
+  if (!decl || geometry->indexStream.buffer || (geometry->indexStream.len && !geometry->indexStream.ptr))
+    return LUX_TRUE;
+
+  numIndices = geometry->indexStream.len / layout->indexSize;
+  if (numIndices > 0xFFFFFFFF)
+    return LUX_TRUE;
+  layout->numIndices = (uint32)numIndices;
+
+  for (i = 0; i < LUXGFX_VERTEX_ATTRIBS; i++){
+    const lxgVertexElement_t* elem = &decl->table[i];
+    const lxgStreamHost_t*    host;
+
+    if (!(decl->available & lxgVertexAttrib_bit((lxgVertexAttrib_t)i)))
+      continue;
+
+    if (elem->stream >= LUXGFX_MAX_VERTEX_STREAMS)
+      return LUX_TRUE;
+
+    host = &geometry->vertexStreams[elem->stream];
+    if (host->buffer || !host->ptr || !elem->stridehalf)
+      return LUX_TRUE;
+
+    layout->strides[elem->stream] = elem->stridehalf * 2;
+  }
+
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    int count;
+    if (!layout->strides[i])
+      continue;
+
+    count = (int)LUX_MIN(geometry->vertexStreams[i].len / layout->strides[i],0x7FFFFFFF);
+    numVertices = numVertices < 0 ? count : LUX_MIN(numVertices,count);
+  }
+
+  if (numVertices <= 0)
+    return LUX_TRUE;
+
+  layout->numVertices = (uint32)numVertices;
+
+  return LUX_FALSE;
+}
+
+static void MeshFile_computeBounding(lxDrawBounding_t* bounding, const lxDrawGeometry_t* geometry, const MeshFileLayout_t* layout)
+{
+  lxgVertexDeclCPTR decl = geometry->vertexDecl;
+  const lxgVertexElement_t* elem = &decl->table[LUXGFX_VERTEX_ATTRIB_POS];
+  const byte* pos;
+  size_t  stride;
+  uint32  i;
+  int     c;
+
+  memset(bounding,0,sizeof(lxDrawBounding_t));
+
+  // cnt is stored minus one
+  if (!(decl->available & lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_POS)) ||
+      elem->scalartype != LUX_SCALAR_FLOAT32 || elem->cnt < 2 || elem->integer)
+  {
+    return;
+  }
+
+  pos = ((const byte*)geometry->vertexStreams[elem->stream].ptr) + elem->offset;
+  stride = layout->strides[elem->stream];
+
+  for (c = 0; c < 3; c++){
+    bounding->bbox.min[c] = bounding->bbox.max[c] = ((const float*)pos)[c];
+  }
+  for (i = 1; i < layout->numVertices; i++){
+    const float* vec = (const float*)(pos + stride * i);
+    for (c = 0; c < 3; c++){
+      bounding->bbox.min[c] = LUX_MIN(bounding->bbox.min[c],vec[c]);
+      bounding->bbox.max[c] = LUX_MAX(bounding->bbox.max[c],vec[c]);
+    }
+  }
+
+  lxBoundingBox_toSphere(&bounding->bbox,&bounding->bsphere);
+}
+
+  // fills ranges and sizes, returns total size
+static uint64 MeshFile_initHeader(lxMeshFileHeader_t* header, const MeshFileLayout_t* layout, int numLods)
+{
+  uint64  offset;
+  int     i;
+
+  memset(header,0,sizeof(lxMeshFileHeader_t));
+  header->magic = LUX_MESHFILE_MAGIC;
+  header->version = LUX_MESHFILE_VERSION;
+  header->endian = LUX_MESHFILE_ENDIAN;
+  header->elementProbe = MeshFile_getElementProbe();
+  header->headerSize = sizeof(lxMeshFileHeader_t);
+  header->indexType = layout->indexSize == sizeof(uint16) ? LUX_SCALAR_UINT16 : LUX_SCALAR_UINT32;
+  header->numIndices = layout->numIndices;
+  header->numVertices = layout->numVertices;
+  header->numLods = numLods;
+
+  offset = MeshFile_align(sizeof(lxMeshFileHeader_t));
+  header->decl.offset = offset;
+  header->decl.size = sizeof(lxgVertexDecl_t);
+  offset = MeshFile_align(offset + header->decl.size);
+
+  if (numLods){
+    header->lods.offset = offset;
+    header->lods.size = sizeof(lxMeshLod_t) * (uint64)numLods;
+    offset = MeshFile_align(offset + header->lods.size);
+  }
+  if (layout->numIndices){
+    header->indices.offset = offset;
+    header->indices.size = layout->indexSize * (uint64)layout->numIndices;
+    offset = MeshFile_align(offset + header->indices.size);
+  }
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    if (!layout->strides[i])
+      continue;
+
+    header->streams[i].offset = offset;
+    header->streams[i].size = layout->strides[i] * (uint64)layout->numVertices;
+    offset = MeshFile_align(offset + header->streams[i].size);
+  }
+
+  header->fileSize = offset;
+  return offset;
+}
+
+LUX_API size_t lxMeshFile_getSize(const lxDrawGeometry_t* geometry, int numLods)
+{
+  MeshFileLayout_t    layout;
+  lxMeshFileHeader_t  header;
+  uint64  size;
+
+  if (numLods < 0 || MeshFile_getLayout(geometry,&layout))
+    return 0;
+
+  size = MeshFile_initHeader(&header,&layout,numLods);
+  return size > (uint64)((size_t)-1) ? 0 : (size_t)size;
+}
+
+LUX_API size_t lxMeshFile_write(void* dst, size_t dstSize, const lxDrawGeometry_t* geometry,
+  const lxDrawBounding_t* bounding, const lxMeshLod_t* lods, int numLods)
+{
+  MeshFileLayout_t    layout;
+  lxMeshFileHeader_t  header;
+  byte*   out = (byte*)dst;
+  uint64  size;
+  int     i;
+
+  if (numLods < 0 || (numLods && !lods) || MeshFile_getLayout(geometry,&layout))
+    return 0;
+
+  size = MeshFile_initHeader(&header,&layout,numLods);
+  if (size > (uint64)dstSize)
+    return 0;
+
+  for (i = 0; i < numLods; i++){
+    if ((uint64)lods[i].firstIndex + lods[i].numIndices > layout.numIndices)
+      return 0;
+  }
+
+  if (bounding){
+    header.bounding = *bounding;
+  }
+  else{
+    MeshFile_computeBounding(&header.bounding,geometry,&layout);
+  }
+
+  // padding is zeroed, so files are reproducible
+  memset(out,0,(size_t)size);
+  memcpy(out,&header,sizeof(lxMeshFileHeader_t));
+  memcpy(out + header.decl.offset,geometry->vertexDecl,sizeof(lxgVertexDecl_t));
+  if (numLods){
+    memcpy(out + header.lods.offset,lods,(size_t)header.lods.size);
+  }
+  if (header.indices.size){
+    memcpy(out + header.indices.offset,geometry->indexStream.ptr,(size_t)header.indices.size);
+  }
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    if (!header.streams[i].size)
+      continue;
+
+    memcpy(out + header.streams[i].offset,geometry->vertexStreams[i].ptr,(size_t)header.streams[i].size);
+  }
+
+  return (size_t)size;
+}
+
+static booln MeshFile_badRange(const lxMeshFileRange_t* range, const lxMeshFileHeader_t* header)
+{
+  if (!range->size)
+    return range->offset != 0;
+
+  return (range->offset & (LUX_MESHFILE_ALIGN - 1)) ||
+    range->offset < header->headerSize ||
+    range->offset > header->fileSize ||
+    range->size > header->fileSize - range->offset;
+}
+
+static lxMeshFileError_t MeshFile_checkHeader(const void* data, size_t size)
+{
+  const lxMeshFileHeader_t* header = (const lxMeshFileHeader_t*)data;
+  const lxgVertexDecl_t*    decl;
+  const lxMeshLod_t*        lods;
+  size_t  indexSize;
+  uint32  i;
+
+  if (!data || size < sizeof(lxMeshFileHeader_t))
+    return LUX_MESHFILE_ERROR_SIZE;
+  if (((size_t)data) & (LUX_MESHFILE_ALIGN - 1))
+    return LUX_MESHFILE_ERROR_RANGE;
+  if (header->magic != LUX_MESHFILE_MAGIC)
+    return LUX_MESHFILE_ERROR_MAGIC;
+  if (header->version != LUX_MESHFILE_VERSION)
+    return LUX_MESHFILE_ERROR_VERSION;
+  if (header->endian != LUX_MESHFILE_ENDIAN ||
+      header->elementProbe != MeshFile_getElementProbe() ||
+      header->headerSize != sizeof(lxMeshFileHeader_t) ||
+      header->decl.size != sizeof(lxgVertexDecl_t))
+  {
+    return LUX_MESHFILE_ERROR_PLATFORM;
+  }
+  if (header->fileSize > (uint64)size)
+    return LUX_MESHFILE_ERROR_SIZE;
+
+  if (MeshFile_badRange(&header->decl,header) || !header->decl.size ||
+      MeshFile_badRange(&header->lods,header) ||
+      MeshFile_badRange(&header->indices,header))
+  {
+    return LUX_MESHFILE_ERROR_RANGE;
+  }
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    if (MeshFile_badRange(&header->streams[i],header))
+      return LUX_MESHFILE_ERROR_RANGE;
+  }
+
+  // indices
+  if (header->indexType != LUX_SCALAR_UINT16 && header->indexType != LUX_SCALAR_UINT32)
+    return LUX_MESHFILE_ERROR_INDICES;
+  indexSize = header->indexType == LUX_SCALAR_UINT16 ? sizeof(uint16) : sizeof(uint32);
+  if (header->indices.size != indexSize * (uint64)header->numIndices)
+    return LUX_MESHFILE_ERROR_INDICES;
+
+  // decl
+  decl = (const lxgVertexDecl_t*)(((const byte*)data) + header->decl.offset);
+  if (!header->numVertices)
+    return LUX_MESHFILE_ERROR_DECL;
+  for (i = 0; i < LUXGFX_VERTEX_ATTRIBS; i++){
+    const lxgVertexElement_t* elem = &decl->table[i];
+    size_t  stride = elem->stridehalf * 2;
+
+    if (!(decl->available & lxgVertexAttrib_bit((lxgVertexAttrib_t)i)))
+      continue;
+
+    if (elem->stream >= LUXGFX_MAX_VERTEX_STREAMS ||
+        elem->scalartype >= LUX_SCALAR_ILLEGAL || !stride ||
+        elem->offset + lxScalarType_getSize((lxScalarType_t)elem->scalartype) * (elem->cnt + 1) > stride ||
+        header->streams[elem->stream].size < stride * (uint64)header->numVertices)
+    {
+      return LUX_MESHFILE_ERROR_DECL;
+    }
+  }
+
+  // lods
+  if (header->lods.size != sizeof(lxMeshLod_t) * (uint64)header->numLods)
+    return LUX_MESHFILE_ERROR_LODS;
+  lods = lxMeshFile_getLods(header);
+  for (i = 0; i < header->numLods; i++){
+    if ((uint64)lods[i].firstIndex + lods[i].numIndices > header->numIndices)
+      return LUX_MESHFILE_ERROR_LODS;
+  }
+
+  return LUX_MESHFILE_ERROR_NONE;
+}
+
+LUX_API lxMeshFileError_t lxMeshFile_validate(const void* data, size_t size, booln checkIndices)
+{
+  const lxMeshFileHeader_t* header = (const lxMeshFileHeader_t*)data;
+  lxMeshFileError_t error = MeshFile_checkHeader(data,size);
+  const byte* indices;
+  uint32  maxIndex = 0;
+  uint32  i;
+
+  if (error || !checkIndices)
+    return error;
+
+  indices = ((const byte*)data) + header->indices.offset;
+  if (header->indexType == LUX_SCALAR_UINT16){
+    for (i = 0; i < header->numIndices; i++){
+      maxIndex = LUX_MAX(maxIndex,((const uint16*)indices)[i]);
+    }
+  }
+  else{
+    for (i = 0; i < header->numIndices; i++){
+      maxIndex = LUX_MAX(maxIndex,((const uint32*)indices)[i]);
+    }
+  }
+
+  return header->numIndices && maxIndex >= header->numVertices ? LUX_MESHFILE_ERROR_INDICES : LUX_MESHFILE_ERROR_NONE;
+}
+
+LUX_API lxMeshFileError_t lxMeshFile_load(const void* data, size_t size,
+  lxDrawGeometry_t* geometry, const lxMeshFileHeader_t** outHeader)
+{
+  const lxMeshFileHeader_t* header = (const lxMeshFileHeader_t*)data;
+  lxMeshFileError_t error = MeshFile_checkHeader(data,size);
+  byte*   base = (byte*)data;
+  int     i;
+
+  if (error)
+    return error;
+
+  memset(geometry,0,sizeof(lxDrawGeometry_t));
+  geometry->vertexDecl = (lxgVertexDeclPTR)(base + header->decl.offset);
+  geometry->indexType = (lxScalarType_t)header->indexType;
+  if (header->indices.size){
+    geometry->indexStream.ptr = base + header->indices.offset;
+    geometry->indexStream.len = (size_t)header->indices.size;
+  }
+  for (i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+    if (!header->streams[i].size)
+      continue;
+
+    geometry->vertexStreams[i].ptr = base + header->streams[i].offset;
+    geometry->vertexStreams[i].len = (size_t)header->streams[i].size;
+  }
+
+  if (outHeader){
+    *outHeader = header;
+  }
+
+  return LUX_MESHFILE_ERROR_NONE;
+}
+
+LUX_API const lxMeshLod_t* lxMeshFile_getLods(const lxMeshFileHeader_t* header)
+{
+  return header->numLods ? (const lxMeshLod_t*)(((const byte*)header) + header->lods.offset) : NULL;
+}
@@ -0,0 +1,684 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/meshgen.h>
+#include <luxinia/luxmath/matrix44.h>
+#include <luxinia/luxmath/fastmath.h>
+#include <luxinia/luxmath/float16.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+// Vertices are generated into small SoA chunks, which are transformed
+// and encoded into the target streams whenever full. Chunks are flushed
+// before the transform changes, so each part of a shape can use its own
+// matrix.
+
+#define MESHGEN_CHUNK   64
+
+enum MeshGenAttrib_e{
+  MESHGEN_POS,
+  MESHGEN_NORMAL,
+  MESHGEN_UV,
+  MESHGEN_ATTRIBS,
+};
+
+enum MeshGenData_e{
+  MESHGEN_PX,
+  MESHGEN_PY,
+  MESHGEN_PZ,
+  MESHGEN_NX,
+  MESHGEN_NY,
+  MESHGEN_NZ,
+  MESHGEN_U,
+  MESHGEN_V,
+  MESHGEN_DATAS,
+};
+
+typedef struct MeshGen_s{
+  byte*               attribs[MESHGEN_ATTRIBS];
+  size_t              strides[MESHGEN_ATTRIBS];
+  lxgVertexElement_t  elems[MESHGEN_ATTRIBS];
+
+  uint16*             indices16;
+  uint32*             indices32;
+
+    // vertices written to the streams
+  uint32              numVertices;
+    // index value of the first vertex of the current part
+  uint32              partVertex;
+  uint32              baseVertex;
+
+  lxMatrix44          matrix;
+    // inverse transpose of matrix, only upper 3x3 is used
+  lxMatrix44          normalmatrix;
+  booln               identity;
+    // matrix is not orthonormal, normals need renormalization
+  booln               scaled;
+
+  int                 count;
+  float               data[MESHGEN_DATAS][MESHGEN_CHUNK];
+  float               zeros[MESHGEN_CHUNK];
+  float               ones[MESHGEN_CHUNK];
+}MeshGen_t;
+
+//////////////////////////////////////////////////////////////////////////
+// Encoding
+
+static LUX_INLINE int MeshGen_round(float f)
+{
+  return (int)(f >= 0.0f ? f + 0.5f : f - 0.5f);
+}
+
+  // component wise, each loop is a plain strided store
+static void MeshGen_encode(byte* dst, size_t stride, lxgVertexElement_t elem, const float* comps[4], int count)
+{
+  int cnt = elem.cnt + 1;
+  int i,c;
+
+  for (c = 0; c < cnt; c++){
+    const float* LUX_RESTRICT in = comps[c];
+    byte* LUX_RESTRICT out = dst;
+
+    switch(elem.scalartype){
+    case LUX_SCALAR_FLOAT32:
+      out += sizeof(float) * c;
+      for (i = 0; i < count; i++, out += stride){
+        *(float*)out = in[i];
+      }
+      break;
+    case LUX_SCALAR_FLOAT16:
+      out += sizeof(float16) * c;
+      for (i = 0; i < count; i++, out += stride){
+        *(float16*)out = lxFloat32To16(in[i]);
+      }
+      break;
+    case LUX_SCALAR_INT8:
+      out += sizeof(int8) * c;
+      for (i = 0; i < count; i++, out += stride){
+        *(int8*)out = (int8)MeshGen_round(LUX_CLAMP(in[i],-1.0f,1.0f) * 127.0f);
+      }
+      break;
+    case LUX_SCALAR_INT16:
+      out += sizeof(int16) * c;
+      for (i = 0; i < count; i++, out += stride){
+        *(int16*)out = (int16)MeshGen_round(LUX_CLAMP(in[i],-1.0f,1.0f) * 32767.0f);
+      }
+      break;
+    case LUX_SCALAR_UINT8:
+      out += sizeof(uint8) * c;
+      for (i = 0; i < count; i++, out += stride){
+        *(uint8*)out = (uint8)MeshGen_round(LUX_CLAMP(in[i],0.0f,1.0f) * 255.0f);
+      }
+      break;
+    case LUX_SCALAR_UINT16:
+      out += sizeof(uint16) * c;
+      for (i = 0; i < count; i++, out += stride){
+        *(uint16*)out = (uint16)MeshGen_round(LUX_CLAMP(in[i],0.0f,1.0f) * 65535.0f);
+      }
+      break;
+    default:
+      LUX_ASSUME(0);
+    }
+  }
+}
+
+  // transforms the chunk by the part matrix, SoA so that four
+  // vertices are done at once with SSE
+static void MeshGen_transform(MeshGen_t* gen, int count)
+{
+  float* LUX_RESTRICT px = gen->data[MESHGEN_PX];
+  float* LUX_RESTRICT py = gen->data[MESHGEN_PY];
+  float* LUX_RESTRICT pz = gen->data[MESHGEN_PZ];
+  float* LUX_RESTRICT nx = gen->data[MESHGEN_NX];
+  float* LUX_RESTRICT ny = gen->data[MESHGEN_NY];
+  float* LUX_RESTRICT nz = gen->data[MESHGEN_NZ];
+  const float* m = gen->matrix;
+  const float* n = gen->normalmatrix;
+  int i;
+
+#ifdef LUX_SIMD_SSE
+  __m128 m0 = _mm_set1_ps(m[0]);
+  __m128 m1 = _mm_set1_ps(m[1]);
+  __m128 m2 = _mm_set1_ps(m[2]);
+  __m128 m4 = _mm_set1_ps(m[4]);
+  __m128 m5 = _mm_set1_ps(m[5]);
+  __m128 m6 = _mm_set1_ps(m[6]);
+  __m128 m8 = _mm_set1_ps(m[8]);
+  __m128 m9 = _mm_set1_ps(m[9]);
+  __m128 m10 = _mm_set1_ps(m[10]);
+  __m128 m12 = _mm_set1_ps(m[12]);
+  __m128 m13 = _mm_set1_ps(m[13]);
+  __m128 m14 = _mm_set1_ps(m[14]);
+  __m128 n0 = _mm_set1_ps(n[0]);
+  __m128 n1 = _mm_set1_ps(n[1]);
+  __m128 n2 = _mm_set1_ps(n[2]);
+  __m128 n4 = _mm_set1_ps(n[4]);
+  __m128 n5 = _mm_set1_ps(n[5]);
+  __m128 n6 = _mm_set1_ps(n[6]);
+  __m128 n8 = _mm_set1_ps(n[8]);
+  __m128 n9 = _mm_set1_ps(n[9]);
+  __m128 n10 = _mm_set1_ps(n[10]);
+
+  // chunk arrays have room for the last partial quad
+  for (i = 0; i < count; i += 4){
+    __m128 x = _mm_loadu_ps(px + i);
+    __m128 y = _mm_loadu_ps(py + i);
+    __m128 z = _mm_loadu_ps(pz + i);
+    _mm_storeu_ps(px + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0,x),_mm_mul_ps(m4,y)),_mm_add_ps(_mm_mul_ps(m8,z),m12)));
+    _mm_storeu_ps(py + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1,x),_mm_mul_ps(m5,y)),_mm_add_ps(_mm_mul_ps(m9,z),m13)));
+    _mm_storeu_ps(pz + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2,x),_mm_mul_ps(m6,y)),_mm_add_ps(_mm_mul_ps(m10,z),m14)));
+
+    x = _mm_loadu_ps(nx + i);
+    y = _mm_loadu_ps(ny + i);
+    z = _mm_loadu_ps(nz + i);
+    {
+      __m128 tx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n0,x),_mm_mul_ps(n4,y)),_mm_mul_ps(n8,z));
+      __m128 ty = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n1,x),_mm_mul_ps(n5,y)),_mm_mul_ps(n9,z));
+      __m128 tz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n2,x),_mm_mul_ps(n6,y)),_mm_mul_ps(n10,z));
+      if (gen->scaled){
+        __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx,tx),_mm_mul_ps(ty,ty)),_mm_mul_ps(tz,tz)));
+        len = _mm_max_ps(len,_mm_set1_ps(FLT_MIN));
+        tx = _mm_div_ps(tx,len);
+        ty = _mm_div_ps(ty,len);
+        tz = _mm_div_ps(tz,len);
+      }
+      _mm_storeu_ps(nx + i, tx);
+      _mm_storeu_ps(ny + i, ty);
+      _mm_storeu_ps(nz + i, tz);
+    }
+  }
+#else
+  for (i = 0; i < count; i++){
+    float x = px[i];
+    float y = py[i];
+    float z = pz[i];
+    px[i] = m[0]*x + m[4]*y + m[8]*z  + m[12];
+    py[i] = m[1]*x + m[5]*y + m[9]*z  + m[13];
+    pz[i] = m[2]*x + m[6]*y + m[10]*z + m[14];
+
+    x = nx[i];
+    y = ny[i];
+    z = nz[i];
+    nx[i] = n[0]*x + n[4]*y + n[8]*z;
+    ny[i] = n[1]*x + n[5]*y + n[9]*z;
+    nz[i] = n[2]*x + n[6]*y + n[10]*z;
+    if (gen->scaled){
+      float len = nx[i]*nx[i] + ny[i]*ny[i] + nz[i]*nz[i];
+      len = len > 0.0f ? 1.0f/sqrtf(len) : 0.0f;
+      nx[i] *= len;
+      ny[i] *= len;
+      nz[i] *= len;
+    }
+  }
+#endif
+}
+
+static void MeshGen_flush(MeshGen_t* gen)
+{
+  const float* comps[4];
+  int count = gen->count;
+
+  if (!count)
+    return;
+
+  if (!gen->identity){
+    MeshGen_transform(gen,count);
+  }
+
+  if (gen->attribs[MESHGEN_POS]){
+    comps[0] = gen->data[MESHGEN_PX];
+    comps[1] = gen->data[MESHGEN_PY];
+    comps[2] = gen->data[MESHGEN_PZ];
+    comps[3] = gen->ones;
+    MeshGen_encode(gen->attribs[MESHGEN_POS],gen->strides[MESHGEN_POS],gen->elems[MESHGEN_POS],comps,count);
+    gen->attribs[MESHGEN_POS] += gen->strides[MESHGEN_POS] * count;
+  }
+  if (gen->attribs[MESHGEN_NORMAL]){
+    comps[0] = gen->data[MESHGEN_NX];
+    comps[1] = gen->data[MESHGEN_NY];
+    comps[2] = gen->data[MESHGEN_NZ];
+    comps[3] = gen->zeros;
+    MeshGen_encode(gen->attribs[MESHGEN_NORMAL],gen->strides[MESHGEN_NORMAL],gen->elems[MESHGEN_NORMAL],comps,count);
+    gen->attribs[MESHGEN_NORMAL] += gen->strides[MESHGEN_NORMAL] * count;
+  }
+  if (gen->attribs[MESHGEN_UV]){
+    comps[0] = gen->data[MESHGEN_U];
+    comps[1] = gen->data[MESHGEN_V];
+    comps[2] = gen->zeros;
+    comps[3] = gen->ones;
+    MeshGen_encode(gen->attribs[MESHGEN_UV],gen->strides[MESHGEN_UV],gen->elems[MESHGEN_UV],comps,count);
+    gen->attribs[MESHGEN_UV] += gen->strides[MESHGEN_UV] * count;
+  }
+
+  gen->numVertices += count;
+  gen->count = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Generation
+
+  // flushes pending vertices, then starts a part using instance * part
+static void MeshGen_beginPart(MeshGen_t* gen, const float* instance, const float* part)
+{
+  MeshGen_flush(gen);
+  gen->partVertex = gen->baseVertex + gen->numVertices;
+
+  if (instance && part){
+    lxMatrix44Multiply(gen->matrix,instance,part);
+  }
+  else if (instance || part){
+    lxMatrix44Copy(gen->matrix,instance ? instance : part);
+  }
+  gen->identity = !instance && !part;
+  gen->scaled = LUX_FALSE;
+  if (!gen->identity){
+    const float* m = gen->matrix;
+    int c;
+    for (c = 0; c < 3; c++){
+      const float* a = m + c*4;
+      const float* b = m + ((c+1)%3)*4;
+      float sqr = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+      float dot = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+      gen->scaled |= fabsf(sqr - 1.0f) > 0.0001f || fabsf(dot) > 0.0001f;
+    }
+
+    // orthonormal rotation is its own inverse transpose
+    if (gen->scaled){
+      lxMatrix44 inv;
+      lxMatrix44Invert(inv,gen->matrix);
+      lxMatrix44TransposeRot(gen->normalmatrix,inv);
+    }
+    else{
+      lxMatrix44Copy(gen->normalmatrix,gen->matrix);
+    }
+  }
+}
+
+static LUX_INLINE void MeshGen_vertex(MeshGen_t* gen, float px, float py, float pz, float nx, float ny, float nz, float u, float v)
+{
+  int i = gen->count;
+  gen->data[MESHGEN_PX][i] = px;
+  gen->data[MESHGEN_PY][i] = py;
+  gen->data[MESHGEN_PZ][i] = pz;
+  gen->data[MESHGEN_NX][i] = nx;
+  gen->data[MESHGEN_NY][i] = ny;
+  gen->data[MESHGEN_NZ][i] = nz;
+  gen->data[MESHGEN_U][i] = u;
+  gen->data[MESHGEN_V][i] = v;
+  if (++gen->count == MESHGEN_CHUNK){
+    MeshGen_flush(gen);
+  }
+}
+
+static LUX_INLINE void MeshGen_triangle(MeshGen_t* gen, uint32 a, uint32 b, uint32 c)
+{
+  uint32 base = gen->partVertex;
+  if (gen->indices16){
+    gen->indices16[0] = (uint16)(a + base);
+    gen->indices16[1] = (uint16)(b + base);
+    gen->indices16[2] = (uint16)(c + base);
+    gen->indices16 += 3;
+  }
+  else{
+    gen->indices32[0] = a + base;
+    gen->indices32[1] = b + base;
+    gen->indices32[2] = c + base;
+    gen->indices32 += 3;
+  }
+}
+
+  // s[i] = sin(angles[i]), c[i] = cos(angles[i]), count <= MESHGEN_CHUNK
+static void MeshGen_sinCos(float* LUX_RESTRICT s, float* LUX_RESTRICT c, float* LUX_RESTRICT angles, int count)
+{
+  int i;
+#ifdef LUX_SIMD_SSE
+  for (i = count; i < ((count + 3) & ~3); i++){
+    angles[i] = 0.0f;
+  }
+  for (i = 0; i < count; i += 4){
+    __m128 vs;
+    __m128 vc;
+    lxFastSinCos_ps(_mm_loadu_ps(angles + i),&vs,&vc);
+    _mm_storeu_ps(s + i, vs);
+    _mm_storeu_ps(c + i, vc);
+  }
+#else
+  for (i = 0; i < count; i++){
+    s[i] = sinf(angles[i]);
+    c[i] = cosf(angles[i]);
+  }
+#endif
+}
+
+static void MeshGen_plane(MeshGen_t* gen, int xdim, int ydim, float z)
+{
+  float xmove = 1.0f/(float)xdim;
+  float ymove = 1.0f/(float)ydim;
+  int width = (xdim + 1);
+  int x,y;
+
+  for (y = 0; y < ydim + 1; y++){
+    float ypos = ((float)y * ymove);
+    for (x = 0; x < xdim + 1; x++){
+      float xpos = ((float)x * xmove);
+      MeshGen_vertex(gen, (xpos - 0.5f) * 2.0f, (ypos - 0.5f) * 2.0f, z, 0.0f, 0.0f, -1.0f, xpos, ypos);
+    }
+  }
+
+  for (y = 0; y < ydim; y++){
+    for (x = 0; x < xdim; x++){
+      MeshGen_triangle(gen, (x) + (y) * width, (x + 1) + (y) * width, (x + 1) + (y + 1) * width);
+      MeshGen_triangle(gen, (x + 1) + (y + 1) * width, (x) + (y + 1) * width, (x) + (y) * width);
+    }
+  }
+}
+
+static void MeshGen_disc(MeshGen_t* gen, int odim, int idim, float z)
+{
+  float angles[MESHGEN_CHUNK + 4];
+  float sins[MESHGEN_CHUNK + 4];
+  float coss[MESHGEN_CHUNK + 4];
+  float oshift = LUX_MUL_TWOPI / (float)odim;
+  float ishift = 1.0f / (float)idim;
+  int vertex;
+  int i,o,n;
+
+  // center
+  MeshGen_vertex(gen, 0.0f, 0.0f, z, 0.0f, 0.0f, -1.0f, 0.5f, 0.5f);
+
+  // rings
+  for (i = 1; i <= idim; i++){
+    for (o = 0; o < odim; o += MESHGEN_CHUNK){
+      int num = LUX_MIN(odim - o, MESHGEN_CHUNK);
+      for (n = 0; n < num; n++){
+        angles[n] = oshift * (float)(o + n);
+      }
+      MeshGen_sinCos(sins,coss,angles,num);
+      for (n = 0; n < num; n++){
+        float xpos = coss[n] * ishift * (float)i;
+        float ypos = sins[n] * ishift * (float)i;
+        MeshGen_vertex(gen, xpos, ypos, z, 0.0f, 0.0f, -1.0f, xpos * 0.5f + 0.5f, ypos * 0.5f + 0.5f);
+      }
+    }
+  }
+
+  vertex = 1;
+  for (i = 0; i < idim; i++){
+    int vertexstart = vertex;
+    for (o = 0; o < odim; o++, vertex++){
+      int vertexnext = (o != odim - 1) ? vertex + 1 : vertexstart;
+      if (i == 0){
+        MeshGen_triangle(gen, vertex, vertexnext, 0);
+      }
+      else{
+        MeshGen_triangle(gen, vertex, vertexnext, vertex - odim);
+        MeshGen_triangle(gen, vertex - odim, vertexnext, vertexnext - odim);
+      }
+    }
+  }
+}
+
+static void MeshGen_sphere(MeshGen_t* gen, int xydim, int zdim)
+{
+  float angles[MESHGEN_CHUNK + 4];
+  float sins[MESHGEN_CHUNK + 4];
+  float coss[MESHGEN_CHUNK + 4];
+  float xyshift = 1.0f / (float)xydim;
+  float zshift  = 1.0f / (float)zdim;
+  int width = xydim + 1;
+  int vertex;
+  int xy,z,n;
+
+  for (z = 0; z < zdim + 1; z++){
+    float curz    = zshift * (float)z;
+    float anglez  = (1.0f-curz) * LUX_MUL_PI;
+    float sinz    = sinf(anglez);
+    float cosz    = cosf(anglez);
+    for (xy = 0; xy < xydim + 1; xy += MESHGEN_CHUNK){
+      int num = LUX_MIN(xydim + 1 - xy, MESHGEN_CHUNK);
+      for (n = 0; n < num; n++){
+        angles[n] = (xyshift * (float)(xy + n)) * LUX_MUL_TWOPI;
+      }
+      MeshGen_sinCos(sins,coss,angles,num);
+      for (n = 0; n < num; n++){
+        float x = coss[n] * sinz;
+        float y = sins[n] * sinz;
+        MeshGen_vertex(gen, x, y, cosz, x, y, cosz, xyshift * (float)(xy + n), curz);
+      }
+    }
+  }
+
+  vertex = 0;
+  for (z = 0; z < zdim; z++){
+    for (xy = 0; xy < xydim; xy++, vertex++){
+      if (z != zdim-1){
+        MeshGen_triangle(gen, vertex, vertex + width, vertex + width + 1);
+      }
+      if (z != 0){
+        MeshGen_triangle(gen, vertex + width + 1, vertex + 1, vertex);
+      }
+    }
+    vertex++;
+  }
+}
+
+  // side of the cylinder, plane of segs z,outer bent around z
+static void MeshGen_tube(MeshGen_t* gen, int xdim, int ydim)
+{
+  float xmove = 1.0f/(float)xdim;
+  float ymove = 1.0f/(float)ydim;
+  int width = (xdim + 1);
+  int x,y;
+
+  for (y = 0; y < ydim + 1; y++){
+    float ypos  = ((float)y * ymove);
+    float angle = ypos * LUX_MUL_TWOPI;
+    float cosa  = cosf(angle);
+    float sina  = sinf(angle);
+    for (x = 0; x < xdim + 1; x++){
+      float xpos = ((float)x * xmove);
+      MeshGen_vertex(gen, cosa, sina, (xpos - 0.5f) * 2.0f, cosa, sina, 0.0f, xpos, ypos);
+    }
+  }
+
+  for (y = 0; y < ydim; y++){
+    for (x = 0; x < xdim; x++){
+      MeshGen_triangle(gen, (x) + (y) * width, (x + 1) + (y) * width, (x + 1) + (y + 1) * width);
+      MeshGen_triangle(gen, (x + 1) + (y + 1) * width, (x) + (y + 1) * width, (x) + (y) * width);
+    }
+  }
+}
+
+static void MeshGen_box(MeshGen_t* gen, const float* instance, const int segs[3])
+{
+  lxMatrix44 matrix;
+  int configs[6][2] = {
+    {segs[0],segs[1]},
+    {segs[0],segs[1]},
+
+    {segs[2],segs[1]},
+    {segs[2],segs[1]},
+
+    {segs[0],segs[2]},
+    {segs[0],segs[2]},
+  };
+  float eulers[6][3] = {
+    {0,0,0},
+    {0,LUX_MUL_PI,0},
+    {0,LUX_MUL_HALF_PI,0},
+    {0,LUX_MUL_PI * 1.5f,0},
+    {LUX_MUL_HALF_PI,0,0},
+    {LUX_MUL_PI * 1.5f,0,0},
+  };
+  int side;
+
+  lxMatrix44Identity(matrix);
+  for (side = 0; side < 6; side++){
+    lxMatrix44FromEulerXYZ(matrix,eulers[side]);
+    MeshGen_beginPart(gen, instance, side ? matrix : NULL);
+    MeshGen_plane(gen, configs[side][0], configs[side][1], -1.0f);
+  }
+}
+
+static void MeshGen_cylinder(MeshGen_t* gen, const float* instance, const int segs[3])
+{
+  lxMatrix44 matrix;
+  lxVector3 angles;
+
+  MeshGen_beginPart(gen, instance, NULL);
+  MeshGen_disc(gen, segs[0], segs[1], -1.0f);
+
+  lxMatrix44Identity(matrix);
+  lxVector3Set(angles,0,LUX_MUL_PI,0);
+  lxMatrix44FromEulerXYZ(matrix,angles);
+  MeshGen_beginPart(gen, instance, matrix);
+  MeshGen_disc(gen, segs[0], segs[1], -1.0f);
+
+  MeshGen_beginPart(gen, instance, NULL);
+  MeshGen_tube(gen, segs[2], segs[0]);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Public
+
+static void MeshGen_getInstanceCounts(const lxMeshGenInstance_t* inst, int* numVertices, int* numIndices)
+{
+  int segs[3] = {inst->segs[0],inst->segs[1],inst->segs[2]};
+  int numline;
+
+  switch(inst->shape){
+  case LUX_MESHGEN_PLANE:
+    lxMeshPlane_getCounts(segs,numVertices,numIndices,&numline);
+    break;
+  case LUX_MESHGEN_DISC:
+    lxMeshDisc_getCounts(segs,numVertices,numIndices,&numline);
+    break;
+  case LUX_MESHGEN_BOX:
+    lxMeshBox_getCounts(segs,numVertices,numIndices,&numline);
+    break;
+  case LUX_MESHGEN_SPHERE:
+    lxMeshSphere_getCounts(segs,numVertices,numIndices,&numline);
+    break;
+  case LUX_MESHGEN_CYLINDER:
+    lxMeshCylinder_getCounts(segs,numVertices,numIndices,&numline);
+    break;
+  default:
+    *numVertices = 0;
+    *numIndices = 0;
+  }
+}
+
+LUX_API void lxMeshGen_getCounts(const lxMeshGenInstance_t* instances, int numInstances, int* numVertices, int* numIndices)
+{
+  int i;
+  *numVertices = 0;
+  *numIndices = 0;
+  for (i = 0; i < numInstances; i++){
+    int numv;
+    int numi;
+    MeshGen_getInstanceCounts(&instances[i],&numv,&numi);
+    *numVertices += numv;
+    *numIndices += numi;
+  }
+}
+
+static booln MeshGen_initAttrib(MeshGen_t* gen, const lxMeshGenTarget_t* target, int attrib, lxgVertexAttrib_t vattrib)
+{
+  lxgVertexDeclCPTR decl = target->decl;
+  lxgVertexElement_t elem;
+
+  if (!(decl->available & lxgVertexAttrib_bit(vattrib)))
+    return LUX_FALSE;
+
+  elem = decl->table[vattrib];
+  switch(elem.scalartype){
+  case LUX_SCALAR_FLOAT32:
+  case LUX_SCALAR_FLOAT16:
+    break;
+  case LUX_SCALAR_INT8:
+  case LUX_SCALAR_INT16:
+    if (attrib != MESHGEN_NORMAL || !elem.normalize) return LUX_TRUE;
+    break;
+  case LUX_SCALAR_UINT8:
+  case LUX_SCALAR_UINT16:
+    if (attrib != MESHGEN_UV || !elem.normalize) return LUX_TRUE;
+    break;
+  default:
+    return LUX_TRUE;
+  }
+  if (attrib == MESHGEN_POS && elem.scalartype != LUX_SCALAR_FLOAT32)
+    return LUX_TRUE;
+  if (elem.integer || !target->streams[elem.stream])
+    return LUX_TRUE;
+
+  gen->elems[attrib] = elem;
+  gen->strides[attrib] = elem.stridehalf * 2;
+  gen->attribs[attrib] = (byte*)target->streams[elem.stream] + elem.offset;
+  return LUX_FALSE;
+}
+
+LUX_API booln lxMeshGen_build(const lxMeshGenTarget_t* target, const lxMeshGenInstance_t* instances, int numInstances)
+{
+  MeshGen_t gen;
+  int numVertices;
+  int numIndices;
+  int i;
+
+  memset(&gen,0,sizeof(MeshGen_t));
+  if (MeshGen_initAttrib(&gen,target,MESHGEN_POS,LUXGFX_VERTEX_ATTRIB_POS) ||
+      MeshGen_initAttrib(&gen,target,MESHGEN_NORMAL,LUXGFX_VERTEX_ATTRIB_NORMAL) ||
+      MeshGen_initAttrib(&gen,target,MESHGEN_UV,LUXGFX_VERTEX_ATTRIB_TEXCOORD0))
+  {
+    return LUX_TRUE;
+  }
+
+  lxMeshGen_getCounts(instances,numInstances,&numVertices,&numIndices);
+  switch(target->indexType){
+  case LUX_MESH_INDEX_UINT16:
+    if (target->baseVertex + (uint32)numVertices > 0x10000)
+      return LUX_TRUE;
+    gen.indices16 = (uint16*)target->indices;
+    break;
+  case LUX_MESH_INDEX_UINT32:
+    gen.indices32 = (uint32*)target->indices;
+    break;
+  default:
+    return LUX_TRUE;
+  }
+
+  for (i = 0; i < MESHGEN_CHUNK; i++){
+    gen.ones[i] = 1.0f;
+  }
+  gen.baseVertex = target->baseVertex;
+
+  for (i = 0; i < numInstances; i++){
+    const lxMeshGenInstance_t* inst = &instances[i];
+    switch(inst->shape){
+    case LUX_MESHGEN_PLANE:
+      MeshGen_beginPart(&gen, inst->matrix, NULL);
+      MeshGen_plane(&gen, inst->segs[0], inst->segs[1], 0.0f);
+      break;
+    case LUX_MESHGEN_DISC:
+      MeshGen_beginPart(&gen, inst->matrix, NULL);
+      MeshGen_disc(&gen, inst->segs[0], inst->segs[1], 0.0f);
+      break;
+    case LUX_MESHGEN_BOX:
+      MeshGen_box(&gen, inst->matrix, inst->segs);
+      break;
+    case LUX_MESHGEN_SPHERE:
+      MeshGen_beginPart(&gen, inst->matrix, NULL);
+      MeshGen_sphere(&gen, inst->segs[0], inst->segs[1]);
+      break;
+    case LUX_MESHGEN_CYLINDER:
+      MeshGen_cylinder(&gen, inst->matrix, inst->segs);
+      break;
+    default:
+      break;
+    }
+  }
+  MeshGen_flush(&gen);
+
+  return LUX_FALSE;
+}
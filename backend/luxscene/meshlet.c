@@ -0,0 +1,411 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/meshlet.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#define MESHLET_UNUSED    0xFFFFFFFF
+#define MESHLET_NOLOCAL   0xFFFF
+
+typedef struct MeshletBuild_s{
+  uint32*   indices;
+  float*    normals;
+  uint32*   adjOffsets;
+  uint32*   adjCounts;
+  uint32*   adjTris;
+  uint16*   local;
+  byte*     emitted;
+}MeshletBuild_t;
+
+static LUX_INLINE const float* Meshlet_getPos(const float* positions, size_t posStride, uint32 v)
+{
+  return (const float*)(((const byte*)positions) + posStride * v);
+}
+
+static void Meshlet_triangleNormal(float out[3], const float* a, const float* b, const float* c)
+{
+  float e0[3];
+  float e1[3];
+  float len;
+
+  e0[0] = b[0] - a[0];  e0[1] = b[1] - a[1];  e0[2] = b[2] - a[2];
+  e1[0] = c[0] - a[0];  e1[1] = c[1] - a[1];  e1[2] = c[2] - a[2];
+
+  out[0] = e0[1] * e1[2] - e0[2] * e1[1];
+  out[1] = e0[2] * e1[0] - e0[0] * e1[2];
+  out[2] = e0[0] * e1[1] - e0[1] * e1[0];
+
+  len = (float)sqrt(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+  if (len > 0.0f){
+    out[0] /= len;
+    out[1] /= len;
+    out[2] /= len;
+  }
+}
+
+LUX_API int lxMeshlet_getMaxCount(int nTriangles, int maxVertices, int maxTriangles)
+{
+  // a new triangle adds at most 3 vertices, so every meshlet but the
+  // last closes with at least maxVertices - 2 vertices or maxTriangles
+  int limitVertices = (nTriangles * 3) / (maxVertices - 2);
+  int limitTriangles = nTriangles / maxTriangles;
+
+  return nTriangles > 0 ? LUX_MAX(limitVertices,limitTriangles) + 1 : 0;
+}
+
+LUX_API void lxMeshlet_computeBounds(lxMeshlet_t* meshlet,
+  const uint32* meshletVertices,
+  const uint8* meshletTriangles,
+  const float* positions,
+  size_t posStride)
+{
+  const uint32* verts = meshletVertices + meshlet->vertexOffset;
+  const uint8*  tris = meshletTriangles + meshlet->triangleOffset;
+  lxBoundingCone_t* cone = &meshlet->cone;
+  float   bmin[3] = {FLT_MAX,FLT_MAX,FLT_MAX};
+  float   bmax[3] = {-FLT_MAX,-FLT_MAX,-FLT_MAX};
+  float   axis[3] = {0.0f,0.0f,0.0f};
+  float   radiusSqr = 0.0f;
+  float   minDot = 1.0f;
+  float   maxT = 0.0f;
+  float   len;
+  uint32  i;
+  int     k;
+
+  // sphere around box center
+  for (i = 0; i < meshlet->numVertices; i++){
+    const float* pos = Meshlet_getPos(positions,posStride,verts[i]);
+    for (k = 0; k < 3; k++){
+      bmin[k] = LUX_MIN(bmin[k],pos[k]);
+      bmax[k] = LUX_MAX(bmax[k],pos[k]);
+    }
+  }
+  for (k = 0; k < 3; k++){
+    meshlet->sphere.center[k] = (bmin[k] + bmax[k]) * 0.5f;
+  }
+  for (i = 0; i < meshlet->numVertices; i++){
+    float d[3];
+    lxVector3Sub(d,Meshlet_getPos(positions,posStride,verts[i]),meshlet->sphere.center);
+    radiusSqr = LUX_MAX(radiusSqr,lxVector3Dot(d,d));
+  }
+  meshlet->sphere.radius = (float)sqrt(radiusSqr);
+
+  // average normal and spread
+  for (i = 0; i < meshlet->numTriangles; i++){
+    float n[3];
+    Meshlet_triangleNormal(n,
+      Meshlet_getPos(positions,posStride,verts[tris[i*3+0]]),
+      Meshlet_getPos(positions,posStride,verts[tris[i*3+1]]),
+      Meshlet_getPos(positions,posStride,verts[tris[i*3+2]]));
+    lxVector3Add(axis,axis,n);
+  }
+  len = (float)sqrt(lxVector3Dot(axis,axis));
+  if (len > 0.0f){
+    lxVector3Scale(axis,axis,1.0f / len);
+
+    for (i = 0; i < meshlet->numTriangles && minDot > 0.0f; i++){
+      const float* p0 = Meshlet_getPos(positions,posStride,verts[tris[i*3+0]]);
+      float n[3];
+      float d[3];
+      float dn;
+
+      Meshlet_triangleNormal(n,p0,
+        Meshlet_getPos(positions,posStride,verts[tris[i*3+1]]),
+        Meshlet_getPos(positions,posStride,verts[tris[i*3+2]]));
+      dn = lxVector3Dot(axis,n);
+      minDot = LUX_MIN(minDot,dn);
+
+      // apex must lie behind every triangle plane
+      if (dn > 0.0f){
+        lxVector3Sub(d,meshlet->sphere.center,p0);
+        maxT = LUX_MAX(maxT,lxVector3Dot(d,n) / dn);
+      }
+    }
+  }
+  else{
+    minDot = 0.0f;
+  }
+
+  memset(cone,0,sizeof(lxBoundingCone_t));
+  if (minDot <= 0.0f){
+    // zero axis never passes the cone test
+    cone->cosSqr = 1.0f;
+    return;
+  }
+
+  // camera sees only backfaces when the direction from the camera to
+  // the apex is within acos(sqrt(1 - minDot^2)) of the axis
+  lxVector3ScaledAdd(cone->top,meshlet->sphere.center,-maxT,axis);
+  lxVector3Negated(axis);
+  lxVector3Copy(cone->axis,axis);
+  cone->sinSqr = minDot * minDot;
+  cone->cosSqr = 1.0f - cone->sinSqr;
+  cone->sinDiv = 1.0f / minDot;
+}
+
+  // returns new vertices the triangle adds to the meshlet
+static LUX_INLINE uint32 Meshlet_extraVertices(const MeshletBuild_t* build, uint32 tri)
+{
+  const uint32* idx = &build->indices[tri * 3];
+  return (build->local[idx[0]] == MESHLET_NOLOCAL) +
+         (build->local[idx[1]] == MESHLET_NOLOCAL) +
+         (build->local[idx[2]] == MESHLET_NOLOCAL);
+}
+
+  // best live triangle adjacent to the meshlet vertices
+static uint32 Meshlet_findAdjacent(const MeshletBuild_t* build, const uint32* verts, uint32 numVertices,
+  uint32 maxVertices, const float normal[3])
+{
+  uint32  best = MESHLET_UNUSED;
+  float   bestScore = FLT_MAX;
+  uint32  i;
+
+  for (i = 0; i < numVertices; i++){
+    uint32  v = verts[i];
+    uint32* adj = &build->adjTris[build->adjOffsets[v]];
+    uint32  a;
+
+    for (a = 0; a < build->adjCounts[v]; a++){
+      uint32  tri = adj[a];
+      uint32  extra = Meshlet_extraVertices(build,tri);
+      float   score;
+
+      if (numVertices + extra > maxVertices)
+        continue;
+
+      // fewer new vertices first, similar facing breaks ties
+      score = (float)extra + 0.5f * (1.0f - lxVector3Dot(&build->normals[tri * 3],normal));
+      if (score < bestScore){
+        bestScore = score;
+        best = tri;
+      }
+    }
+  }
+
+  return best;
+}
+
+static void Meshlet_emit(MeshletBuild_t* build, uint32 tri)
+{
+  int k;
+
+  build->emitted[tri] = 1;
+  for (k = 0; k < 3; k++){
+    uint32  v = build->indices[tri * 3 + k];
+    uint32* adj = &build->adjTris[build->adjOffsets[v]];
+    uint32  count = build->adjCounts[v];
+    uint32  a;
+
+    for (a = 0; a < count; a++){
+      if (adj[a] == tri){
+        adj[a] = adj[count - 1];
+        build->adjCounts[v] = count - 1;
+        break;
+      }
+    }
+  }
+}
+
+  // stores the meshlet, current continues behind it
+static void Meshlet_finish(MeshletBuild_t* build, lxMeshlet_t* meshlet, lxMeshlet_t* current,
+  const uint32* meshletVertices, const uint8* meshletTriangles,
+  const float* positions, size_t posStride)
+{
+  const uint32* verts = meshletVertices + current->vertexOffset;
+  uint32 i;
+
+  lxMeshlet_computeBounds(current,meshletVertices,meshletTriangles,positions,posStride);
+  for (i = 0; i < current->numVertices; i++){
+    build->local[verts[i]] = MESHLET_NOLOCAL;
+  }
+  *meshlet = *current;
+
+  current->vertexOffset += current->numVertices;
+  current->triangleOffset += current->numTriangles * 3;
+  current->numVertices = 0;
+  current->numTriangles = 0;
+}
+
+LUX_API int lxMeshlet_build(lxMemoryAllocatorPTR allocator,
+  lxMeshlet_t* meshlets,
+  uint32* meshletVertices,
+  uint8* meshletTriangles,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  int maxVertices,
+  int maxTriangles,
+  lxMeshIndexType_t type)
+{
+  MeshletBuild_t build;
+  lxMeshlet_t current;
+  size_t  scratchSize;
+  byte*   scratch;
+  uint32  numIndices = (uint32)nTriangles * 3;
+  uint32  numMeshlets = 0;
+  uint32  scan = 0;
+  float   normal[3] = {0.0f,0.0f,0.0f};
+  uint32  i;
+
+  if (nTriangles < 0 || nVertices < 0 || maxVertices < 3 || maxVertices > 256 || maxTriangles < 1)
+    return -1;
+
+  scratchSize = sizeof(uint32) * (numIndices * 2 + nVertices * 2 + 1) + sizeof(float) * numIndices +
+    sizeof(uint16) * nVertices + nTriangles;
+  scratch = (byte*)lxMemoryAllocator_malloc(allocator,scratchSize);
+  if (!scratch)
+    return -1;
+
+  build.indices = (uint32*)scratch;
+  build.adjTris = build.indices + numIndices;
+  build.adjOffsets = build.adjTris + numIndices;
+  build.adjCounts = build.adjOffsets + nVertices + 1;
+  build.normals = (float*)(build.adjCounts + nVertices);
+  build.local = (uint16*)(build.normals + numIndices);
+  build.emitted = (byte*)(build.local + nVertices);
+
+  for (i = 0; i < numIndices; i++){
+    build.indices[i] = type == LUX_MESH_INDEX_UINT16 ? ((const uint16*)indices)[i] : ((const uint32*)indices)[i];
+  }
+  for (i = 0; i < (uint32)nTriangles; i++){
+    const uint32* idx = &build.indices[i * 3];
+    Meshlet_triangleNormal(&build.normals[i * 3],
+      Meshlet_getPos(positions,posStride,idx[0]),
+      Meshlet_getPos(positions,posStride,idx[1]),
+      Meshlet_getPos(positions,posStride,idx[2]));
+  }
+
+  // vertex to triangle lists, counts shrink as triangles are emitted
+  memset(build.adjCounts,0,sizeof(uint32) * nVertices);
+  for (i = 0; i < numIndices; i++){
+    build.adjCounts[build.indices[i]]++;
+  }
+  build.adjOffsets[0] = 0;
+  for (i = 0; i < (uint32)nVertices; i++){
+    build.adjOffsets[i + 1] = build.adjOffsets[i] + build.adjCounts[i];
+    build.adjCounts[i] = 0;
+  }
+  for (i = 0; i < numIndices; i++){
+    uint32 v = build.indices[i];
+    build.adjTris[build.adjOffsets[v] + build.adjCounts[v]++] = i / 3;
+  }
+
+  memset(build.local,0xFF,sizeof(uint16) * nVertices);
+  memset(build.emitted,0,nTriangles);
+
+  memset(&current,0,sizeof(lxMeshlet_t));
+
+  for (;;){
+    uint32* verts = meshletVertices + current.vertexOffset;
+    uint8*  tris = meshletTriangles + current.triangleOffset;
+    uint32  tri = MESHLET_UNUSED;
+    int     k;
+
+    if (current.numVertices){
+      tri = Meshlet_findAdjacent(&build,verts,current.numVertices,(uint32)maxVertices,normal);
+    }
+    if (tri == MESHLET_UNUSED){
+      // continue in index order, which is local after cache optimization
+      while (scan < (uint32)nTriangles && build.emitted[scan]){
+        scan++;
+      }
+      if (scan == (uint32)nTriangles)
+        break;
+
+      tri = scan;
+      if (current.numVertices + Meshlet_extraVertices(&build,tri) > (uint32)maxVertices){
+        tri = MESHLET_UNUSED;
+      }
+    }
+
+    if (tri == MESHLET_UNUSED){
+      // full, retry with the next one
+      Meshlet_finish(&build,&meshlets[numMeshlets++],&current,meshletVertices,meshletTriangles,positions,posStride);
+      lxVector3Set(normal,0.0f,0.0f,0.0f);
+      continue;
+    }
+
+    for (k = 0; k < 3; k++){
+      uint32 v = build.indices[tri * 3 + k];
+      if (build.local[v] == MESHLET_NOLOCAL){
+        build.local[v] = (uint16)current.numVertices;
+        verts[current.numVertices++] = v;
+      }
+      tris[current.numTriangles * 3 + k] = (uint8)build.local[v];
+    }
+    current.numTriangles++;
+    Meshlet_emit(&build,tri);
+
+    // running average of the facing
+    lxVector3Add(normal,normal,&build.normals[tri * 3]);
+    lxVector3Normalized(normal);
+
+    if (current.numTriangles == (uint32)maxTriangles){
+      Meshlet_finish(&build,&meshlets[numMeshlets++],&current,meshletVertices,meshletTriangles,positions,posStride);
+      lxVector3Set(normal,0.0f,0.0f,0.0f);
+    }
+  }
+
+  if (current.numTriangles){
+    Meshlet_finish(&build,&meshlets[numMeshlets++],&current,meshletVertices,meshletTriangles,positions,posStride);
+  }
+
+  lxMemoryAllocator_free(allocator,scratch,scratchSize);
+
+  return (int)numMeshlets;
+}
+
+LUX_API int lxMeshlet_cull(uint32* visible,
+  const lxMeshlet_t* meshlets,
+  int numMeshlets,
+  lxFrustumCPTR frustum,
+  const lxVector3 camera,
+  lxMeshletCullStats_t* stats)
+{
+  lxBoundingSphere_t eye;
+  int   plane = 0;
+  int   numVisible = 0;
+  int   i;
+
+  if (camera){
+    lxVector3Copy(eye.center,camera);
+    eye.radius = 0.0f;
+  }
+  if (stats){
+    memset(stats,0,sizeof(lxMeshletCullStats_t));
+    stats->meshlets = numMeshlets;
+  }
+
+  for (i = 0; i < numMeshlets; i++){
+    const lxMeshlet_t* meshlet = &meshlets[i];
+    int   triangles = (int)meshlet->numTriangles;
+
+    if (stats){
+      stats->triangles += triangles;
+    }
+
+    if (frustum && lxFrustum_checkSphereCoherent(frustum,&meshlet->sphere,&plane)){
+      if (stats){
+        stats->culledFrustum++;
+        stats->culledTrianglesFrustum += triangles;
+      }
+      continue;
+    }
+    if (camera && lxBoundingCone_checkSphere(&meshlet->cone,&eye)){
+      if (stats){
+        stats->culledBackface++;
+        stats->culledTrianglesBackface += triangles;
+      }
+      continue;
+    }
+
+    visible[numVisible++] = (uint32)i;
+  }
+
+  return numVisible;
+}
@@ -0,0 +1,518 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/meshopt.h>
+#include <luxinia/luxmath/vector3.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#define MESHOPT_UNUSED  0xFFFFFFFF
+
+static LUX_INLINE uint32 MeshOpt_getIndex(const void* indices, int i, lxMeshIndexType_t type)
+{
+  return type == LUX_MESH_INDEX_UINT16 ? ((const uint16*)indices)[i] : ((const uint32*)indices)[i];
+}
+
+static LUX_INLINE const float* MeshOpt_getPos(const float* positions, size_t posStride, uint32 v)
+{
+  return (const float*)(((const byte*)positions) + posStride * v);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Vertex Fetch
+
+LUX_API int lxMeshVertexFetch_remap(uint32* remap, const void* indices, int numIndices, int nVertices, lxMeshIndexType_t type)
+{
+  uint32  next = 0;
+  int     used;
+  int     i;
+
+  memset(remap,0xFF,sizeof(uint32) * nVertices);
+
+  for (i = 0; i < numIndices; i++){
+    uint32 v = MeshOpt_getIndex(indices,i,type);
+    if (v < (uint32)nVertices && remap[v] == MESHOPT_UNUSED){
+      remap[v] = next++;
+    }
+  }
+
+  used = (int)next;
+  for (i = 0; i < nVertices; i++){
+    if (remap[i] == MESHOPT_UNUSED){
+      remap[i] = next++;
+    }
+  }
+
+  return used;
+}
+
+LUX_API void lxMeshIndices_remap(void* indices, int numIndices, const uint32* remap, lxMeshIndexType_t type)
+{
+  int i;
+
+  if (type == LUX_MESH_INDEX_UINT16){
+    uint16* ind = (uint16*)indices;
+    for (i = 0; i < numIndices; i++){
+      ind[i] = (uint16)remap[ind[i]];
+    }
+  }
+  else{
+    uint32* ind = (uint32*)indices;
+    for (i = 0; i < numIndices; i++){
+      ind[i] = remap[ind[i]];
+    }
+  }
+}
+
+LUX_API void lxMeshVertices_remap(void* dst, const void* src, size_t stride, int nVertices, const uint32* remap)
+{
+  const byte* bsrc = (const byte*)src;
+  byte*       bdst = (byte*)dst;
+  int i;
+
+  for (i = 0; i < nVertices; i++){
+    memcpy(bdst + stride * remap[i], bsrc + stride * i, stride);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Overdraw
+
+typedef struct MeshOptCluster_s{
+  float   key;
+  float   normal[3];
+  uint32  start;
+  uint32  count;
+}MeshOptCluster_t;
+
+static int MeshOptCluster_compare(const void* a, const void* b)
+{
+  const MeshOptCluster_t* ca = (const MeshOptCluster_t*)a;
+  const MeshOptCluster_t* cb = (const MeshOptCluster_t*)b;
+
+  // descending key, stable by start
+  if (ca->key != cb->key)
+    return ca->key > cb->key ? -1 : 1;
+  return ca->start < cb->start ? -1 : 1;
+}
+
+  // FIFO cache via stamps, a vertex is cached if less than
+  // vcache misses happened since it was stamped. Bumping time
+  // by vcache flushes the cache.
+static LUX_INLINE int MeshOpt_cacheTriangle(int* stamps, int* time, int vcache, const void* indices, int tri, lxMeshIndexType_t type)
+{
+  int misses = 0;
+  int c;
+
+  for (c = 0; c < 3; c++){
+    uint32 v = MeshOpt_getIndex(indices,tri*3+c,type);
+    if (*time - stamps[v] >= vcache){
+      (*time)++;
+      stamps[v] = *time;
+      misses++;
+    }
+  }
+
+  return misses;
+}
+
+LUX_API booln lxMeshOverdraw_optimize(lxMemoryAllocatorPTR allocator,
+  void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  int vcache,
+  float threshold,
+  lxMeshIndexType_t type)
+{
+  size_t  indexSize = type == LUX_MESH_INDEX_UINT16 ? sizeof(uint16) : sizeof(uint32);
+  size_t  scratchSize;
+  byte*   scratch;
+  int*    stamps;
+  byte*   hard;
+  MeshOptCluster_t* clusters;
+  void*   sorted;
+  int     numClusters = 0;
+  int     time;
+  int     i;
+  int     c;
+  lxVector3 meshCenter;
+  float   meshArea = 0.0f;
+
+  if (nTriangles < 2 || type >= LUX_MESH_INDICES)
+    return nTriangles < 0 || type >= LUX_MESH_INDICES;
+
+  vcache = LUX_MAX(vcache,1);
+  scratchSize = sizeof(MeshOptCluster_t) * nTriangles +
+                sizeof(int) * nVertices +
+                indexSize * 3 * nTriangles +
+                nTriangles;
+  scratch = (byte*)lxMemoryAllocator_malloc(allocator,scratchSize);
+  if (!scratch)
+    return LUX_TRUE;
+
+  clusters = (MeshOptCluster_t*)scratch;
+  stamps = (int*)(clusters + nTriangles);
+  sorted = (void*)(stamps + nVertices);
+  hard = ((byte*)sorted) + indexSize * 3 * nTriangles;
+
+  // hard boundaries, where the optimizer restarted the cache
+  for (i = 0; i < nVertices; i++){
+    stamps[i] = -vcache;
+  }
+  time = 0;
+  for (i = 0; i < nTriangles; i++){
+    hard[i] = MeshOpt_cacheTriangle(stamps,&time,vcache,indices,i,type) == 3;
+  }
+  hard[0] = LUX_TRUE;
+
+  // soft boundaries, split while ACMR of the cluster stays
+  // below threshold * ACMR of the hard cluster
+  for (i = 0; i < nTriangles;){
+    int   end = i + 1;
+    int   misses = 0;
+    int   runMisses = 0;
+    int   runTris = 0;
+    float limit;
+    int   t;
+
+    while (end < nTriangles && !hard[end]){
+      end++;
+    }
+
+    time += vcache;
+    for (t = i; t < end; t++){
+      misses += MeshOpt_cacheTriangle(stamps,&time,vcache,indices,t,type);
+    }
+    limit = threshold * (float)misses / (float)(end - i);
+
+    time += vcache;
+    clusters[numClusters].start = i;
+    for (t = i; t < end; t++){
+      runMisses += MeshOpt_cacheTriangle(stamps,&time,vcache,indices,t,type);
+      runTris++;
+      if (t + 1 < end && (float)runMisses <= limit * (float)runTris){
+        clusters[numClusters].count = t + 1 - clusters[numClusters].start;
+        numClusters++;
+        clusters[numClusters].start = t + 1;
+        runMisses = 0;
+        runTris = 0;
+        time += vcache;
+      }
+    }
+    clusters[numClusters].count = end - clusters[numClusters].start;
+    numClusters++;
+
+    i = end;
+  }
+
+  // cluster centers and normals, area weighted
+  lxVector3Clear(meshCenter);
+  for (c = 0; c < numClusters; c++){
+    MeshOptCluster_t* cluster = &clusters[c];
+    lxVector3 center;
+    lxVector3 normal;
+    float     area = 0.0f;
+
+    lxVector3Clear(center);
+    lxVector3Clear(normal);
+    for (i = cluster->start; i < (int)(cluster->start + cluster->count); i++){
+      const float* p0 = MeshOpt_getPos(positions,posStride,MeshOpt_getIndex(indices,i*3+0,type));
+      const float* p1 = MeshOpt_getPos(positions,posStride,MeshOpt_getIndex(indices,i*3+1,type));
+      const float* p2 = MeshOpt_getPos(positions,posStride,MeshOpt_getIndex(indices,i*3+2,type));
+      lxVector3 e0;
+      lxVector3 e1;
+      lxVector3 n;
+      float     triArea;
+
+      lxVector3Sub(e0,p1,p0);
+      lxVector3Sub(e1,p2,p0);
+      lxVector3Cross(n,e0,e1);
+      triArea = lxVector3Length(n);
+
+      lxVector3Add(normal,normal,n);
+      center[0] += (p0[0] + p1[0] + p2[0]) * triArea;
+      center[1] += (p0[1] + p1[1] + p2[1]) * triArea;
+      center[2] += (p0[2] + p1[2] + p2[2]) * triArea;
+      area += triArea;
+    }
+
+    lxVector3Add(meshCenter,meshCenter,center);
+    meshArea += area;
+
+    if (area > 0.0f){
+      lxVector3Scale(center,center,1.0f/(area * 3.0f));
+    }
+    lxVector3Normalized(normal);
+    lxVector3Copy(cluster->normal,normal);
+    cluster->key = lxVector3Dot(center,normal);
+  }
+
+  // clusters facing away from the center first
+  if (meshArea > 0.0f){
+    lxVector3Scale(meshCenter,meshCenter,1.0f/(meshArea * 3.0f));
+  }
+  for (c = 0; c < numClusters; c++){
+    clusters[c].key -= lxVector3Dot(meshCenter,clusters[c].normal);
+  }
+  qsort(clusters,numClusters,sizeof(MeshOptCluster_t),MeshOptCluster_compare);
+
+  for (c = 0, i = 0; c < numClusters; c++){
+    memcpy(((byte*)sorted) + indexSize * 3 * i,
+      ((byte*)indices) + indexSize * 3 * clusters[c].start,
+      indexSize * 3 * clusters[c].count);
+    i += clusters[c].count;
+  }
+  memcpy(indices,sorted,indexSize * 3 * nTriangles);
+
+  lxMemoryAllocator_free(allocator,scratch,scratchSize);
+  return LUX_FALSE;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Mesh Statistics
+
+LUX_API size_t lxMeshStats_fetch(lxMeshStats_t* stats,
+  lxMemoryAllocatorPTR allocator,
+  const void* indices,
+  int numIndices,
+  int nVertices,
+  size_t vertexStride,
+  int vcache,
+  lxMeshIndexType_t type)
+{
+  size_t  numLines = ((vertexStride * nVertices) + LUX_MESHSTATS_FETCH_LINE - 1) / LUX_MESHSTATS_FETCH_LINE;
+  size_t  scratchSize = sizeof(int) * (nVertices + numLines);
+  size_t  bytes = 0;
+  int     used = 0;
+  int*    vertexStamps;
+  int*    lineStamps;
+  int     vertexTime = 0;
+  int     lineTime = 0;
+  int     misses = 0;
+  int     i;
+
+  if (nVertices <= 0 || !vertexStride)
+    return 0;
+
+  vertexStamps = (int*)lxMemoryAllocator_malloc(allocator,scratchSize);
+  if (!vertexStamps)
+    return 0;
+  lineStamps = vertexStamps + nVertices;
+
+  vcache = LUX_MIN(vcache,LUX_VERTEXCACHE_MAX);
+  vcache = LUX_MAX(vcache,1);
+  for (i = 0; i < nVertices; i++){
+    vertexStamps[i] = INT_MIN;
+  }
+  for (i = 0; i < (int)numLines; i++){
+    lineStamps[i] = -LUX_MESHSTATS_FETCH_LINES;
+  }
+
+  for (i = 0; i < numIndices; i++){
+    uint32 v = MeshOpt_getIndex(indices,i,type);
+    size_t line;
+    size_t lineEnd;
+
+    if (v >= (uint32)nVertices)
+      continue;
+      // only post-transform cache misses are fetched
+    if (vertexStamps[v] != INT_MIN && vertexTime - vertexStamps[v] < vcache)
+      continue;
+    used += vertexStamps[v] == INT_MIN;
+    vertexTime++;
+    vertexStamps[v] = vertexTime;
+
+    line = (vertexStride * v) / LUX_MESHSTATS_FETCH_LINE;
+    lineEnd = (vertexStride * (v + 1) - 1) / LUX_MESHSTATS_FETCH_LINE;
+    for (; line <= lineEnd; line++){
+      if (lineTime - lineStamps[line] >= LUX_MESHSTATS_FETCH_LINES){
+        lineTime++;
+        lineStamps[line] = lineTime;
+        misses++;
+      }
+    }
+  }
+
+  lxMemoryAllocator_free(allocator,vertexStamps,scratchSize);
+
+  bytes = (size_t)misses * LUX_MESHSTATS_FETCH_LINE;
+  stats->fetchMisses += misses;
+  stats->overfetch = used ? (float)bytes / (float)(vertexStride * used) : 0.0f;
+
+  return bytes;
+}
+
+typedef struct MeshOptRaster_s{
+  float*  depth;
+  int     shaded;
+}MeshOptRaster_t;
+
+  // top-left fill convention for counter-clockwise triangles,
+  // so shared edges are only drawn once
+static LUX_INLINE booln MeshOpt_edgeInside(float w, float dx, float dy)
+{
+  return w > 0.0f || (w == 0.0f && (dy < 0.0f || (dy == 0.0f && dx > 0.0f)));
+}
+
+static void MeshOpt_rasterTriangle(MeshOptRaster_t* raster, const float* v0, const float* v1, const float* v2)
+{
+  float area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v1[1] - v0[1]) * (v2[0] - v0[0]);
+  float areaDiv;
+  int   minx, maxx;
+  int   miny, maxy;
+  int   x, y;
+
+  if (area == 0.0f)
+    return;
+  if (area < 0.0f){
+    const float* tmp = v1;
+    v1 = v2;
+    v2 = tmp;
+    area = -area;
+  }
+  areaDiv = 1.0f / area;
+
+  minx = LUX_MAX((int)LUX_MIN(v0[0],LUX_MIN(v1[0],v2[0])),0);
+  miny = LUX_MAX((int)LUX_MIN(v0[1],LUX_MIN(v1[1],v2[1])),0);
+  maxx = LUX_MIN((int)LUX_MAX(v0[0],LUX_MAX(v1[0],v2[0])),LUX_MESHSTATS_OVERDRAW_RES-1);
+  maxy = LUX_MIN((int)LUX_MAX(v0[1],LUX_MAX(v1[1],v2[1])),LUX_MESHSTATS_OVERDRAW_RES-1);
+
+  for (y = miny; y <= maxy; y++){
+    float py = (float)y + 0.5f;
+    for (x = minx; x <= maxx; x++){
+      float px = (float)x + 0.5f;
+      float w0 = (v2[0] - v1[0]) * (py - v1[1]) - (v2[1] - v1[1]) * (px - v1[0]);
+      float w1 = (v0[0] - v2[0]) * (py - v2[1]) - (v0[1] - v2[1]) * (px - v2[0]);
+      float w2 = (v1[0] - v0[0]) * (py - v0[1]) - (v1[1] - v0[1]) * (px - v0[0]);
+      float z;
+      float* dst;
+
+      if (!MeshOpt_edgeInside(w0,v2[0] - v1[0],v2[1] - v1[1]) ||
+          !MeshOpt_edgeInside(w1,v0[0] - v2[0],v0[1] - v2[1]) ||
+          !MeshOpt_edgeInside(w2,v1[0] - v0[0],v1[1] - v0[1]))
+        continue;
+
+      z = (w0 * v0[2] + w1 * v1[2] + w2 * v2[2]) * areaDiv;
+      dst = &raster->depth[y * LUX_MESHSTATS_OVERDRAW_RES + x];
+      if (z < *dst){
+        *dst = z;
+        raster->shaded++;
+      }
+    }
+  }
+}
+
+LUX_API booln lxMeshStats_overdraw(lxMeshStats_t* stats,
+  lxMemoryAllocatorPTR allocator,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  lxMeshIndexType_t type)
+{
+  size_t  depthSize = sizeof(float) * LUX_MESHSTATS_OVERDRAW_RES * LUX_MESHSTATS_OVERDRAW_RES;
+  MeshOptRaster_t raster;
+  lxVector3 bmin;
+  lxVector3 bmax;
+  float   scale;
+  int     covered = 0;
+  int     view;
+  int     i;
+
+  stats->pixelsCovered = 0;
+  stats->pixelsShaded = 0;
+  stats->overdraw = 0.0f;
+
+  if (nTriangles <= 0)
+    return nTriangles < 0;
+
+  raster.depth = (float*)lxMemoryAllocator_malloc(allocator,depthSize);
+  raster.shaded = 0;
+  if (!raster.depth)
+    return LUX_TRUE;
+
+  lxVector3Set(bmin,FLT_MAX,FLT_MAX,FLT_MAX);
+  lxVector3Set(bmax,-FLT_MAX,-FLT_MAX,-FLT_MAX);
+  for (i = 0; i < nTriangles * 3; i++){
+    const float* pos = MeshOpt_getPos(positions,posStride,MeshOpt_getIndex(indices,i,type));
+    lxVector3Min(bmin,bmin,pos);
+    lxVector3Max(bmax,bmax,pos);
+  }
+  scale = LUX_MAX(bmax[0]-bmin[0],LUX_MAX(bmax[1]-bmin[1],bmax[2]-bmin[2]));
+  scale = scale > 0.0f ? (float)(LUX_MESHSTATS_OVERDRAW_RES-1) / scale : 1.0f;
+
+  // +x,-x,+y,-y,+z,-z
+  for (view = 0; view < 6; view++){
+    int   axis = view / 2;
+    int   u = (axis + 1) % 3;
+    int   v = (axis + 2) % 3;
+    float dir = (view & 1) ? -1.0f : 1.0f;
+
+    for (i = 0; i < LUX_MESHSTATS_OVERDRAW_RES * LUX_MESHSTATS_OVERDRAW_RES; i++){
+      raster.depth[i] = FLT_MAX;
+    }
+
+    for (i = 0; i < nTriangles; i++){
+      lxVector3 proj[3];
+      int c;
+
+      for (c = 0; c < 3; c++){
+        const float* pos = MeshOpt_getPos(positions,posStride,MeshOpt_getIndex(indices,i*3+c,type));
+        proj[c][0] = (pos[u] - bmin[u]) * scale;
+        proj[c][1] = (pos[v] - bmin[v]) * scale;
+        proj[c][2] = (pos[axis] - bmin[axis]) * dir;
+      }
+
+      // looking along dir * axis, front faces have normal against it
+      if (dir * ((proj[1][0] - proj[0][0]) * (proj[2][1] - proj[0][1]) -
+                 (proj[1][1] - proj[0][1]) * (proj[2][0] - proj[0][0])) >= 0.0f)
+        continue;
+
+      MeshOpt_rasterTriangle(&raster,proj[0],proj[1],proj[2]);
+    }
+
+    for (i = 0; i < LUX_MESHSTATS_OVERDRAW_RES * LUX_MESHSTATS_OVERDRAW_RES; i++){
+      covered += raster.depth[i] != FLT_MAX;
+    }
+  }
+
+  lxMemoryAllocator_free(allocator,raster.depth,depthSize);
+
+  stats->pixelsCovered = covered;
+  stats->pixelsShaded = raster.shaded;
+  stats->overdraw = covered ? (float)raster.shaded / (float)covered : 0.0f;
+
+  return LUX_FALSE;
+}
+
+LUX_API booln lxMeshStats_compute(lxMeshStats_t* stats,
+  lxMemoryAllocatorPTR allocator,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  size_t vertexStride,
+  int vcache,
+  lxMeshIndexType_t type)
+{
+  memset(stats,0,sizeof(lxMeshStats_t));
+
+  if (nTriangles < 0 || type >= LUX_MESH_INDICES)
+    return LUX_TRUE;
+
+  lxVertexCacheStats_compute(&stats->vcache,indices,nTriangles,nVertices,vcache,type);
+
+  if (vertexStride && nTriangles &&
+      !lxMeshStats_fetch(stats,allocator,indices,nTriangles*3,nVertices,vertexStride,vcache,type))
+    return LUX_TRUE;
+
+  if (positions)
+    return lxMeshStats_overdraw(stats,allocator,indices,nTriangles,positions,posStride,type);
+
+  return LUX_FALSE;
+}
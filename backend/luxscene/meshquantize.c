@@ -0,0 +1,252 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/meshquantize.h>
+#include <luxinia/luxmath/matrix44.h>
+#include <luxinia/luxmath/vector3.h>
+#include <luxinia/luxmath/vector4.h>
+#include <luxinia/luxmath/float16.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#define MESHQUANTIZE_POS_MAX    65535.0f
+
+static LUX_INLINE int MeshQuantize_round(float f)
+{
+  return (int)(f >= 0.0f ? f + 0.5f : f - 0.5f);
+}
+
+static LUX_INLINE float MeshQuantize_sign(float f)
+{
+  return f >= 0.0f ? 1.0f : -1.0f;
+}
+
+static void MeshQuantize_octDecode(lxVector3 n, float x, float y)
+{
+  n[0] = x;
+  n[1] = y;
+  n[2] = 1.0f - fabsf(x) - fabsf(y);
+  if (n[2] < 0.0f){
+    n[0] = (1.0f - fabsf(y)) * MeshQuantize_sign(x);
+    n[1] = (1.0f - fabsf(x)) * MeshQuantize_sign(y);
+  }
+  lxVector3Normalized(n);
+}
+
+  // "A Survey of Efficient Representations for Independent Unit Vectors"
+  // by Cigolle et al. The projection is rounded to the best of the four
+  // neighboring grid points, which halves the error of plain rounding.
+static void MeshQuantize_octEncode(int out[2], const lxVector3 n, float maxval)
+{
+  float l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+  float x;
+  float y;
+  float best = -FLT_MAX;
+  int i;
+
+  if (l1 <= 0.0f){
+    out[0] = 0;
+    out[1] = (int)maxval;
+    return;
+  }
+
+  x = n[0] / l1;
+  y = n[1] / l1;
+  if (n[2] < 0.0f){
+    float ox = x;
+    x = (1.0f - fabsf(y))  * MeshQuantize_sign(ox);
+    y = (1.0f - fabsf(ox)) * MeshQuantize_sign(y);
+  }
+  x *= maxval;
+  y *= maxval;
+
+  for (i = 0; i < 4; i++){
+    int qx = (int)((i & 1) ? ceilf(x) : floorf(x));
+    int qy = (int)((i & 2) ? ceilf(y) : floorf(y));
+    lxVector3 dec;
+    float dot;
+
+    qx = LUX_CLAMP(qx,-(int)maxval,(int)maxval);
+    qy = LUX_CLAMP(qy,-(int)maxval,(int)maxval);
+    MeshQuantize_octDecode(dec,(float)qx / maxval,(float)qy / maxval);
+    dot = lxVector3Dot(dec,n);
+    if (dot > best){
+      best = dot;
+      out[0] = qx;
+      out[1] = qy;
+    }
+  }
+}
+
+static float MeshQuantize_angle(const lxVector3 a, const lxVector3 b)
+{
+  float lensqr = lxVector3Dot(a,a) * lxVector3Dot(b,b);
+  float cosa = lensqr > 0.0f ? lxVector3Dot(a,b) / sqrtf(lensqr) : 1.0f;
+  return LUX_RAD2DEG(acosf(LUX_CLAMP(cosa,-1.0f,1.0f)));
+}
+
+  // writes cnt snorm values, returns the decoded vector
+static void MeshQuantize_writeOct(void* dst, const lxVector3 n, float extra, int cnt, lxMeshQuantizeNormal_t normalType, lxVector3 decoded)
+{
+  float maxval = normalType == LUX_MESHQUANTIZE_OCT8 ? 127.0f : 32767.0f;
+  int oct[4];
+  int c;
+
+  MeshQuantize_octEncode(oct,n,maxval);
+  oct[2] = MeshQuantize_round(extra * maxval);
+  oct[3] = 0;
+  MeshQuantize_octDecode(decoded,(float)oct[0] / maxval,(float)oct[1] / maxval);
+
+  for (c = 0; c < cnt; c++){
+    if (normalType == LUX_MESHQUANTIZE_OCT8){
+      ((int8*)dst)[c] = (int8)oct[c];
+    }
+    else{
+      ((int16*)dst)[c] = (int16)oct[c];
+    }
+  }
+}
+
+LUX_API void lxMeshQuantize_init(lxMeshQuantize_t* quant, const lxMeshQuantizeInput_t* input, lxMeshQuantizeNormal_t normalType)
+{
+  lxScalarType_t  octType = normalType == LUX_MESHQUANTIZE_OCT8 ? LUX_SCALAR_INT8 : LUX_SCALAR_INT16;
+  uint  offsetNormal = 0;
+  uint  offsetTangent = 0;
+  uint  offsetUV = 0;
+  uint  offset = sizeof(uint16) * 4;
+
+  memset(&quant->decl,0,sizeof(lxgVertexDecl_t));
+
+  if (input->normals){
+    offsetNormal = offset;
+    offset += 4;
+  }
+  if (input->tangents){
+    offsetTangent = offset;
+    offset += normalType == LUX_MESHQUANTIZE_OCT8 ? 4 : 8;
+  }
+  if (input->uvs){
+    offsetUV = offset;
+    offset += sizeof(float16) * 2;
+  }
+
+  quant->vertexSize = offset;
+  quant->decl.streams = 1;
+  quant->decl.available = lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_POS);
+  quant->decl.table[LUXGFX_VERTEX_ATTRIB_POS] = lxgVertexElement_set(4,LUX_SCALAR_UINT16,LUX_TRUE,LUX_FALSE,offset,0,0);
+  if (input->normals){
+    quant->decl.available |= lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_NORMAL);
+    quant->decl.table[LUXGFX_VERTEX_ATTRIB_NORMAL] = lxgVertexElement_set(2,octType,LUX_TRUE,LUX_FALSE,offset,offsetNormal,0);
+  }
+  if (input->tangents){
+    quant->decl.available |= lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_ATTR14);
+    quant->decl.table[LUXGFX_VERTEX_ATTRIB_ATTR14] = lxgVertexElement_set(4,octType,LUX_TRUE,LUX_FALSE,offset,offsetTangent,0);
+  }
+  if (input->uvs){
+    quant->decl.available |= lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_TEXCOORD0);
+    quant->decl.table[LUXGFX_VERTEX_ATTRIB_TEXCOORD0] = lxgVertexElement_set(2,LUX_SCALAR_FLOAT16,LUX_FALSE,LUX_FALSE,offset,offsetUV,0);
+  }
+}
+
+LUX_API booln lxMeshQuantize_run(lxMeshQuantize_t* quant, void* dst, const lxMeshQuantizeInput_t* input, lxMeshQuantizeNormal_t normalType)
+{
+  lxMeshQuantizeStats_t* stats = &quant->stats;
+  const lxgVertexElement_t* table = quant->decl.table;
+  lxVector3 extent;
+  lxVector3 scale;
+  double  posSum = 0.0;
+  double  normalSum = 0.0;
+  byte*   out = (byte*)dst;
+  int i,c;
+
+  if (!input->positions || input->numVertices < 0 ||
+      normalType < 0 || normalType >= LUX_MESHQUANTIZE_NORMALS)
+  {
+    return LUX_TRUE;
+  }
+
+  lxMeshQuantize_init(quant,input,normalType);
+  memset(stats,0,sizeof(lxMeshQuantizeStats_t));
+
+  // bounds
+  lxVector4Set(quant->bbox.min,0,0,0,1);
+  lxVector4Set(quant->bbox.max,0,0,0,1);
+  for (i = 0; i < input->numVertices; i++){
+    const float* pos = (const float*)((const byte*)input->positions + input->posStride * i);
+    for (c = 0; c < 3; c++){
+      quant->bbox.min[c] = i ? LUX_MIN(quant->bbox.min[c],pos[c]) : pos[c];
+      quant->bbox.max[c] = i ? LUX_MAX(quant->bbox.max[c],pos[c]) : pos[c];
+    }
+  }
+
+  lxVector3Sub(extent,quant->bbox.max,quant->bbox.min);
+  for (c = 0; c < 3; c++){
+    scale[c] = extent[c] > 0.0f ? MESHQUANTIZE_POS_MAX / extent[c] : 0.0f;
+  }
+  lxMatrix44Identity(quant->dequant);
+  quant->dequant[0]  = extent[0];
+  quant->dequant[5]  = extent[1];
+  quant->dequant[10] = extent[2];
+  quant->dequant[12] = quant->bbox.min[0];
+  quant->dequant[13] = quant->bbox.min[1];
+  quant->dequant[14] = quant->bbox.min[2];
+
+  for (i = 0; i < input->numVertices; i++, out += quant->vertexSize){
+    const float* pos = (const float*)((const byte*)input->positions + input->posStride * i);
+    uint16* qpos = (uint16*)(out + table[LUXGFX_VERTEX_ATTRIB_POS].offset);
+    float   err = 0.0f;
+
+    for (c = 0; c < 3; c++){
+      int q = MeshQuantize_round((pos[c] - quant->bbox.min[c]) * scale[c]);
+      float dec;
+
+      qpos[c] = (uint16)LUX_CLAMP(q,0,0xFFFF);
+      dec = ((float)qpos[c] / MESHQUANTIZE_POS_MAX) * extent[c] + quant->bbox.min[c];
+      err = LUX_MAX(err,fabsf(dec - pos[c]));
+    }
+    qpos[3] = 0xFFFF;
+    stats->posMaxError = LUX_MAX(stats->posMaxError,err);
+    posSum += err;
+
+    if (input->normals){
+      const float* nrm = (const float*)((const byte*)input->normals + input->normalStride * i);
+      lxVector3 dec;
+      float angle;
+
+      MeshQuantize_writeOct(out + table[LUXGFX_VERTEX_ATTRIB_NORMAL].offset,nrm,0.0f,2,normalType,dec);
+      angle = MeshQuantize_angle(dec,nrm);
+      stats->normalMaxAngle = LUX_MAX(stats->normalMaxAngle,angle);
+      normalSum += angle;
+    }
+    if (input->tangents){
+      const float* tan = (const float*)((const byte*)input->tangents + input->tangentStride * i);
+      lxVector3 dec;
+
+      MeshQuantize_writeOct(out + table[LUXGFX_VERTEX_ATTRIB_ATTR14].offset,tan,MeshQuantize_sign(tan[3]),4,normalType,dec);
+      stats->tangentMaxAngle = LUX_MAX(stats->tangentMaxAngle,MeshQuantize_angle(dec,tan));
+    }
+    if (input->uvs){
+      const float* uv = (const float*)((const byte*)input->uvs + input->uvStride * i);
+      float16* quv = (float16*)(out + table[LUXGFX_VERTEX_ATTRIB_TEXCOORD0].offset);
+
+      for (c = 0; c < 2; c++){
+        quv[c] = lxFloat32To16(uv[c]);
+        stats->uvMaxError = LUX_MAX(stats->uvMaxError,fabsf(lxFloat16To32(quv[c]) - uv[c]));
+      }
+    }
+  }
+
+  if (input->numVertices){
+    stats->posAvgError = (float)(posSum / (double)input->numVertices);
+    stats->normalAvgAngle = (float)(normalSum / (double)input->numVertices);
+  }
+  stats->bytesInput = (size_t)input->numVertices * (sizeof(float) * 3 +
+    (input->normals ? sizeof(float) * 3 : 0) +
+    (input->tangents ? sizeof(float) * 4 : 0) +
+    (input->uvs ? sizeof(float) * 2 : 0));
+  stats->bytesOutput = (size_t)input->numVertices * quant->vertexSize;
+
+  return LUX_FALSE;
+}
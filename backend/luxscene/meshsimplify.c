@@ -0,0 +1,616 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/meshopt.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+//////////////////////////////////////////////////////////////////////////
+// Mesh Simplification
+//
+// Every pass finds the cheapest collapse of each free vertex along one
+// of its edges, sorts them by cost and applies them greedily. A collapse
+// locks the one-ring of the removed vertex for the rest of the pass, so
+// the flip tests and costs stay valid without updating the adjacency.
+// Positions are scaled into the unit cube for the quadrics, errors are
+// kept squared in that space until they are reported.
+
+#define MESHSIMPLIFY_SORT_BITS    11
+#define MESHSIMPLIFY_SORT_SIZE    (1<<MESHSIMPLIFY_SORT_BITS)
+
+typedef struct MeshQuadric_s{
+  float   a00,a11,a22;
+  float   a01,a02,a12;
+  float   b0,b1,b2;
+  float   c;
+  float   w;
+}MeshQuadric_t;
+
+typedef struct MeshSimplify_s{
+  lxMemoryAllocatorPTR  allocator;
+  byte*           scratch;
+  size_t          scratchSize;
+
+  uint32          nVertices;
+  uint32          numIndices;
+  uint32*         indices;
+  float*          positions;
+  float           scale;
+  float           error;
+
+  MeshQuadric_t*  quadrics;
+  byte*           locked;
+  byte*           passLocked;
+  uint32*         remap;
+  uint32*         targets;
+  float*          costs;
+  uint32*         adjOffsets;
+  uint32*         adjTris;
+  uint32*         sortKeys;
+  uint32*         sortTmp;
+}MeshSimplify_t;
+
+static LUX_INLINE uint32 MeshSimplify_getIndex(const void* indices, uint32 i, lxMeshIndexType_t type)
+{
+  return type == LUX_MESH_INDEX_UINT16 ? ((const uint16*)indices)[i] : ((const uint32*)indices)[i];
+}
+
+static void MeshQuadric_addPlane(MeshQuadric_t* q, const float n[3], float d, float w)
+{
+  q->a00 += w * n[0] * n[0];
+  q->a11 += w * n[1] * n[1];
+  q->a22 += w * n[2] * n[2];
+  q->a01 += w * n[0] * n[1];
+  q->a02 += w * n[0] * n[2];
+  q->a12 += w * n[1] * n[2];
+  q->b0 += w * n[0] * d;
+  q->b1 += w * n[1] * d;
+  q->b2 += w * n[2] * d;
+  q->c += w * d * d;
+  q->w += w;
+}
+
+static void MeshQuadric_add(MeshQuadric_t* LUX_RESTRICT q, const MeshQuadric_t* LUX_RESTRICT r)
+{
+  q->a00 += r->a00;
+  q->a11 += r->a11;
+  q->a22 += r->a22;
+  q->a01 += r->a01;
+  q->a02 += r->a02;
+  q->a12 += r->a12;
+  q->b0 += r->b0;
+  q->b1 += r->b1;
+  q->b2 += r->b2;
+  q->c += r->c;
+  q->w += r->w;
+}
+
+  // area weighted mean of squared plane distances
+static LUX_INLINE float MeshQuadric_error(const MeshQuadric_t* q, const float* p)
+{
+  float rx = q->a00 * p[0] + q->a01 * p[1] + q->a02 * p[2];
+  float ry = q->a01 * p[0] + q->a11 * p[1] + q->a12 * p[2];
+  float rz = q->a02 * p[0] + q->a12 * p[1] + q->a22 * p[2];
+  float r = rx * p[0] + ry * p[1] + rz * p[2];
+
+  r += 2.0f * (q->b0 * p[0] + q->b1 * p[1] + q->b2 * p[2]) + q->c;
+  r = (float)fabs(r);
+
+  return q->w > 0.0f ? r / q->w : r;
+}
+
+static LUX_INLINE void MeshSimplify_cross(float out[3], const float* a, const float* b, const float* c)
+{
+  float e0[3];
+  float e1[3];
+
+  e0[0] = b[0] - a[0];  e0[1] = b[1] - a[1];  e0[2] = b[2] - a[2];
+  e1[0] = c[0] - a[0];  e1[1] = c[1] - a[1];  e1[2] = c[2] - a[2];
+
+  out[0] = e0[1] * e1[2] - e0[2] * e1[1];
+  out[1] = e0[2] * e1[0] - e0[0] * e1[2];
+  out[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+  // vertex (or group) to triangle lists
+static void MeshSimplify_buildAdjacency(MeshSimplify_t* simp, const uint32* corners, uint32 numIndices, uint32 count)
+{
+  uint32* offsets = simp->adjOffsets;
+  uint32  i;
+
+  memset(offsets,0,sizeof(uint32) * (count + 1));
+  for (i = 0; i < numIndices; i++){
+    offsets[corners[i] + 1]++;
+  }
+  for (i = 0; i < count; i++){
+    offsets[i + 1] += offsets[i];
+  }
+  for (i = 0; i < numIndices; i++){
+    simp->adjTris[offsets[corners[i]]++] = i / 3;
+  }
+  // offsets were advanced to the ends, shift back
+  for (i = count; i > 0; i--){
+    offsets[i] = offsets[i - 1];
+  }
+  offsets[0] = 0;
+}
+
+  // locks vertices on borders, non-manifold edges and attribute seams
+static booln MeshSimplify_findLocked(MeshSimplify_t* simp, const float* positions, size_t posStride)
+{
+  lxMeshWeldStream_t stream;
+  uint32* groups = simp->remap;
+  uint32* groupCounts = simp->targets;
+  byte*   groupLocked = simp->passLocked;
+  uint32* corners = simp->adjTris + simp->numIndices;
+  uint32  numGroups;
+  uint32  i;
+  int     numUnique;
+
+  stream.data = positions;
+  stream.stride = posStride;
+  stream.size = sizeof(float) * 3;
+
+  numUnique = lxMeshWeld_remap(groups,simp->allocator,NULL,&stream,1,(int)simp->nVertices);
+  if (numUnique < 0)
+    return LUX_TRUE;
+  numGroups = (uint32)numUnique;
+
+  memset(groupCounts,0,sizeof(uint32) * numGroups);
+  memset(groupLocked,0,numGroups);
+  for (i = 0; i < simp->nVertices; i++){
+    groupCounts[groups[i]]++;
+  }
+
+  // corners use the second half of adjTris
+  for (i = 0; i < simp->numIndices; i++){
+    corners[i] = groups[simp->indices[i]];
+  }
+  MeshSimplify_buildAdjacency(simp,corners,simp->numIndices,numGroups);
+
+  // every directed edge must exist once in each direction
+  for (i = 0; i < simp->numIndices; i++){
+    uint32 tri = i / 3;
+    uint32 ga = corners[i];
+    uint32 gb = corners[tri * 3 + (i + 1) % 3];
+    uint32 forward = 0;
+    uint32 backward = 0;
+    uint32 a;
+
+    if (ga == gb){
+      groupLocked[ga] = 1;
+      continue;
+    }
+
+    for (a = simp->adjOffsets[ga]; a < simp->adjOffsets[ga + 1]; a++){
+      const uint32* tc = &corners[simp->adjTris[a] * 3];
+      int k;
+      for (k = 0; k < 3; k++){
+        forward  += tc[k] == ga && tc[(k + 1) % 3] == gb;
+        backward += tc[k] == gb && tc[(k + 1) % 3] == ga;
+      }
+    }
+
+    if (forward != 1 || backward != 1){
+      groupLocked[ga] = 1;
+      groupLocked[gb] = 1;
+    }
+  }
+
+  for (i = 0; i < simp->nVertices; i++){
+    simp->locked[i] = groupCounts[groups[i]] > 1 || groupLocked[groups[i]];
+  }
+
+  return LUX_FALSE;
+}
+
+static booln MeshSimplify_init(MeshSimplify_t* simp, lxMemoryAllocatorPTR allocator,
+  const void* indices, int nTriangles, const float* positions, size_t posStride, int nVertices,
+  lxMeshIndexType_t type)
+{
+  uint32  n = (uint32)nVertices;
+  uint32  numIndices = 0;
+  size_t  sizeIndices = sizeof(uint32) * 3 * nTriangles;
+  float   bmin[3];
+  float   bmax[3];
+  float   scale;
+  byte*   ptr;
+  uint32  i;
+  int     k;
+
+  memset(simp,0,sizeof(MeshSimplify_t));
+  if (nTriangles < 0 || nVertices < 0 || !positions)
+    return LUX_TRUE;
+
+  // adjacency needs room for the group corners during init
+  simp->scratchSize = sizeIndices * 3 +
+    (sizeof(float) * 3 + sizeof(MeshQuadric_t) + sizeof(uint32) * 6 + 2) * n +
+    sizeof(uint32) * 2;
+  simp->scratch = (byte*)lxMemoryAllocator_malloc(allocator,simp->scratchSize);
+  if (!simp->scratch)
+    return LUX_TRUE;
+
+  ptr = simp->scratch;
+  simp->allocator = allocator;
+  simp->nVertices = n;
+  simp->indices = (uint32*)ptr;     ptr += sizeIndices;
+  simp->adjTris = (uint32*)ptr;     ptr += sizeIndices * 2;
+  simp->quadrics = (MeshQuadric_t*)ptr; ptr += sizeof(MeshQuadric_t) * n;
+  simp->positions = (float*)ptr;    ptr += sizeof(float) * 3 * n;
+  simp->remap = (uint32*)ptr;       ptr += sizeof(uint32) * n;
+  simp->targets = (uint32*)ptr;     ptr += sizeof(uint32) * n;
+  simp->costs = (float*)ptr;        ptr += sizeof(float) * n;
+  simp->sortKeys = (uint32*)ptr;    ptr += sizeof(uint32) * n;
+  simp->sortTmp = (uint32*)ptr;     ptr += sizeof(uint32) * n;
+  simp->adjOffsets = (uint32*)ptr;  ptr += sizeof(uint32) * (n + 1);
+  simp->locked = ptr;               ptr += n;
+  simp->passLocked = ptr;
+
+  // copy without degenerate triangles
+  for (i = 0; i < (uint32)nTriangles; i++){
+    uint32 a = MeshSimplify_getIndex(indices,i * 3 + 0,type);
+    uint32 b = MeshSimplify_getIndex(indices,i * 3 + 1,type);
+    uint32 c = MeshSimplify_getIndex(indices,i * 3 + 2,type);
+    if (a == b || b == c || c == a)
+      continue;
+
+    simp->indices[numIndices++] = a;
+    simp->indices[numIndices++] = b;
+    simp->indices[numIndices++] = c;
+  }
+  simp->numIndices = numIndices;
+
+  // normalize into unit cube
+  for (k = 0; k < 3; k++){
+    bmin[k] = FLT_MAX;
+    bmax[k] = -FLT_MAX;
+  }
+  for (i = 0; i < n; i++){
+    const float* pos = (const float*)(((const byte*)positions) + posStride * i);
+    for (k = 0; k < 3; k++){
+      bmin[k] = LUX_MIN(bmin[k],pos[k]);
+      bmax[k] = LUX_MAX(bmax[k],pos[k]);
+    }
+  }
+  scale = 0.0f;
+  for (k = 0; n && k < 3; k++){
+    scale = LUX_MAX(scale,bmax[k] - bmin[k]);
+  }
+  simp->scale = scale > 0.0f ? scale : 1.0f;
+
+  for (i = 0; i < n; i++){
+    const float* pos = (const float*)(((const byte*)positions) + posStride * i);
+    for (k = 0; k < 3; k++){
+      simp->positions[i * 3 + k] = (pos[k] - bmin[k]) / simp->scale;
+    }
+  }
+
+  if (MeshSimplify_findLocked(simp,positions,posStride)){
+    lxMemoryAllocator_free(allocator,simp->scratch,simp->scratchSize);
+    return LUX_TRUE;
+  }
+
+  // plane quadrics weighted by area
+  memset(simp->quadrics,0,sizeof(MeshQuadric_t) * n);
+  for (i = 0; i < numIndices; i += 3){
+    const uint32* tri = &simp->indices[i];
+    const float*  p0 = &simp->positions[tri[0] * 3];
+    float   normal[3];
+    float   len;
+
+    MeshSimplify_cross(normal,p0,&simp->positions[tri[1] * 3],&simp->positions[tri[2] * 3]);
+    len = (float)sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    if (len <= 0.0f)
+      continue;
+
+    normal[0] /= len;
+    normal[1] /= len;
+    normal[2] /= len;
+
+    for (k = 0; k < 3; k++){
+      MeshQuadric_addPlane(&simp->quadrics[tri[k]],normal,
+        -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]),len * 0.5f);
+    }
+  }
+
+  return LUX_FALSE;
+}
+
+static void MeshSimplify_deinit(MeshSimplify_t* simp)
+{
+  lxMemoryAllocator_free(simp->allocator,simp->scratch,simp->scratchSize);
+}
+
+  // sorts vertices by their float cost, costs are positive
+  // so the bit patterns sort like unsigned integers
+static uint32* MeshSimplify_sort(MeshSimplify_t* simp, uint32* vals, uint32* tmp, uint32 count)
+{
+  uint32  hist[MESHSIMPLIFY_SORT_SIZE];
+  const uint32* keys = (const uint32*)simp->costs;
+  int     shift;
+  uint32  i;
+
+  for (shift = 0; shift < 32; shift += MESHSIMPLIFY_SORT_BITS){
+    uint32  sum = 0;
+    uint32* swap;
+
+    memset(hist,0,sizeof(hist));
+    for (i = 0; i < count; i++){
+      hist[(keys[vals[i]] >> shift) & (MESHSIMPLIFY_SORT_SIZE - 1)]++;
+    }
+    for (i = 0; i < MESHSIMPLIFY_SORT_SIZE; i++){
+      uint32 cnt = hist[i];
+      hist[i] = sum;
+      sum += cnt;
+    }
+    for (i = 0; i < count; i++){
+      tmp[hist[(keys[vals[i]] >> shift) & (MESHSIMPLIFY_SORT_SIZE - 1)]++] = vals[i];
+    }
+
+    swap = vals;
+    vals = tmp;
+    tmp = swap;
+  }
+
+  return vals;
+}
+
+  // TRUE if moving v0 onto v1 flips or degrades a remaining triangle
+static booln MeshSimplify_flips(const MeshSimplify_t* simp, uint32 v0, uint32 v1)
+{
+  const float* p1 = &simp->positions[v1 * 3];
+  uint32  a;
+
+  for (a = simp->adjOffsets[v0]; a < simp->adjOffsets[v0 + 1]; a++){
+    const uint32* tri = &simp->indices[simp->adjTris[a] * 3];
+    uint32  k = tri[0] == v0 ? 0 : (tri[1] == v0 ? 1 : 2);
+    uint32  b = tri[(k + 1) % 3];
+    uint32  c = tri[(k + 2) % 3];
+    const float* pb;
+    const float* pc;
+    float   n0[3];
+    float   n1[3];
+    float   dot;
+
+    if (b == v1 || c == v1)
+      continue;
+
+    pb = &simp->positions[b * 3];
+    pc = &simp->positions[c * 3];
+    MeshSimplify_cross(n0,&simp->positions[v0 * 3],pb,pc);
+    MeshSimplify_cross(n1,p1,pb,pc);
+
+    // reject flips and rotations beyond ~75 degrees
+    dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+    if (dot <= 0.0f ||
+        dot * dot < 0.0625f * (n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) *
+                              (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]))
+      return LUX_TRUE;
+  }
+
+  return LUX_FALSE;
+}
+
+  // returns number of collapses
+static uint32 MeshSimplify_pass(MeshSimplify_t* simp, uint32 targetTriangles, float maxError)
+{
+  uint32  n = simp->nVertices;
+  uint32  numTriangles = simp->numIndices / 3;
+  uint32  removed = 0;
+  uint32  collapses = 0;
+  uint32  numCandidates = 0;
+  uint32* candidates;
+  uint32  written;
+  uint32  i;
+
+  MeshSimplify_buildAdjacency(simp,simp->indices,simp->numIndices,n);
+
+  // cheapest edge per free vertex
+  for (i = 0; i < n; i++){
+    simp->costs[i] = FLT_MAX;
+    simp->targets[i] = i;
+    simp->remap[i] = i;
+  }
+  for (i = 0; i < simp->numIndices; i++){
+    uint32 a = simp->indices[i];
+    uint32 b = simp->indices[(i / 3) * 3 + (i + 1) % 3];
+    float  cost;
+
+    if (!simp->locked[a]){
+      cost = MeshQuadric_error(&simp->quadrics[a],&simp->positions[b * 3]);
+      if (cost < simp->costs[a]){
+        simp->costs[a] = cost;
+        simp->targets[a] = b;
+      }
+    }
+    if (!simp->locked[b]){
+      cost = MeshQuadric_error(&simp->quadrics[b],&simp->positions[a * 3]);
+      if (cost < simp->costs[b]){
+        simp->costs[b] = cost;
+        simp->targets[b] = a;
+      }
+    }
+  }
+
+  for (i = 0; i < n; i++){
+    if (simp->targets[i] != i && simp->costs[i] <= maxError){
+      simp->sortKeys[numCandidates++] = i;
+    }
+  }
+  if (!numCandidates)
+    return 0;
+
+  candidates = MeshSimplify_sort(simp,simp->sortKeys,simp->sortTmp,numCandidates);
+
+  memset(simp->passLocked,0,n);
+  for (i = 0; i < numCandidates && numTriangles - removed > targetTriangles; i++){
+    uint32 v0 = candidates[i];
+    uint32 v1 = simp->targets[v0];
+    uint32 a;
+
+    if (simp->passLocked[v0] || simp->passLocked[v1] || MeshSimplify_flips(simp,v0,v1))
+      continue;
+
+    for (a = simp->adjOffsets[v0]; a < simp->adjOffsets[v0 + 1]; a++){
+      const uint32* tri = &simp->indices[simp->adjTris[a] * 3];
+      removed += tri[0] == v1 || tri[1] == v1 || tri[2] == v1;
+      simp->passLocked[tri[0]] = 1;
+      simp->passLocked[tri[1]] = 1;
+      simp->passLocked[tri[2]] = 1;
+    }
+    simp->passLocked[v1] = 1;
+
+    simp->remap[v0] = v1;
+    MeshQuadric_add(&simp->quadrics[v1],&simp->quadrics[v0]);
+    simp->error = LUX_MAX(simp->error,simp->costs[v0]);
+    collapses++;
+  }
+
+  // targets are locked within a pass, so one lookup is final
+  written = 0;
+  for (i = 0; i < simp->numIndices; i += 3){
+    uint32 a = simp->remap[simp->indices[i + 0]];
+    uint32 b = simp->remap[simp->indices[i + 1]];
+    uint32 c = simp->remap[simp->indices[i + 2]];
+    if (a == b || b == c || c == a)
+      continue;
+
+    simp->indices[written++] = a;
+    simp->indices[written++] = b;
+    simp->indices[written++] = c;
+  }
+  simp->numIndices = written;
+
+  return collapses;
+}
+
+static void MeshSimplify_reduce(MeshSimplify_t* simp, uint32 targetTriangles, float maxError)
+{
+  while (simp->numIndices / 3 > targetTriangles &&
+         MeshSimplify_pass(simp,targetTriangles,maxError))
+  {
+  }
+}
+
+static void MeshSimplify_write(const MeshSimplify_t* simp, void* dst, lxMeshIndexType_t type)
+{
+  uint32 i;
+
+  if (type == LUX_MESH_INDEX_UINT16){
+    uint16* dst16 = (uint16*)dst;
+    for (i = 0; i < simp->numIndices; i++){
+      dst16[i] = (uint16)simp->indices[i];
+    }
+  }
+  else{
+    memcpy(dst,simp->indices,sizeof(uint32) * simp->numIndices);
+  }
+}
+
+static LUX_INLINE float MeshSimplify_getError(const MeshSimplify_t* simp)
+{
+  return (float)sqrt(simp->error) * simp->scale;
+}
+
+static LUX_INLINE float MeshSimplify_maxError(const MeshSimplify_t* simp, float maxError)
+{
+  float normalized;
+  if (maxError < 0.0f)
+    return FLT_MAX;
+
+  normalized = maxError / simp->scale;
+  return normalized * normalized;
+}
+
+LUX_API int lxMeshSimplify(lxMemoryAllocatorPTR allocator,
+  void* dstIndices,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  int targetTriangles,
+  float maxError,
+  float* outError,
+  lxMeshIndexType_t type)
+{
+  MeshSimplify_t simp;
+  int   numTriangles;
+
+  if (MeshSimplify_init(&simp,allocator,indices,nTriangles,positions,posStride,nVertices,type))
+    return -1;
+
+  MeshSimplify_reduce(&simp,(uint32)LUX_MAX(targetTriangles,0),MeshSimplify_maxError(&simp,maxError));
+  MeshSimplify_write(&simp,dstIndices,type);
+
+  if (outError){
+    *outError = MeshSimplify_getError(&simp);
+  }
+  numTriangles = (int)(simp.numIndices / 3);
+
+  MeshSimplify_deinit(&simp);
+
+  return numTriangles;
+}
+
+LUX_API int lxMeshLodChain_build(lxMemoryAllocatorPTR allocator,
+  lxMeshLod_t* lods,
+  int maxLods,
+  void* dstIndices,
+  size_t dstCapacity,
+  const void* indices,
+  int nTriangles,
+  const float* positions,
+  size_t posStride,
+  int nVertices,
+  float ratio,
+  float maxError,
+  lxMeshIndexType_t type)
+{
+  MeshSimplify_t simp;
+  size_t  indexSize = type == LUX_MESH_INDEX_UINT16 ? sizeof(uint16) : sizeof(uint32);
+  float   maxErrorSq;
+  uint32  offset = 0;
+  int     numLods = 0;
+
+  if (maxLods < 1 || !(ratio > 0.0f && ratio < 1.0f) ||
+      MeshSimplify_init(&simp,allocator,indices,nTriangles,positions,posStride,nVertices,type))
+    return -1;
+
+  maxErrorSq = MeshSimplify_maxError(&simp,maxError);
+
+  while (numLods < maxLods && offset + simp.numIndices <= dstCapacity){
+    uint32 numIndices = simp.numIndices;
+
+    MeshSimplify_write(&simp,((byte*)dstIndices) + indexSize * offset,type);
+    lods[numLods].firstIndex = offset;
+    lods[numLods].numIndices = numIndices;
+    lods[numLods].error = MeshSimplify_getError(&simp);
+    offset += numIndices;
+    numLods++;
+
+    MeshSimplify_reduce(&simp,(uint32)((float)(numIndices / 3) * ratio),maxErrorSq);
+    if (simp.numIndices == numIndices || !simp.numIndices)
+      break;
+  }
+
+  MeshSimplify_deinit(&simp);
+
+  return numLods;
+}
+
+LUX_API int lxMeshLodChain_select(const lxMeshLod_t* lods, int numLods, float distance, float pixelScale, float maxPixelError)
+{
+  int best = 0;
+  int i;
+
+  for (i = 1; i < numLods; i++){
+    if (lods[i].error * pixelScale > maxPixelError * distance)
+      break;
+    best = i;
+  }
+
+  return best;
+}
@@ -0,0 +1,146 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/meshvcacheopt.h>
+#include <string.h>
+
+#include "meshvcacheopt_defs.h"
+
+//////////////////////////////////////////////////////////////////////////
+// Vertex Cache Statistics
+
+LUX_API void lxVertexCacheStats_compute(lxVertexCacheStats_t *stats, const void* indices, int nTriangles, int nVertices, int vcache, lxMeshIndexType_t type)
+{
+  uint32  fifo[LUX_VERTEXCACHE_MAX];
+  int     fifoPos = 0;
+  int     misses = 0;
+  int     numIndices = nTriangles * 3;
+  int     i;
+  int     c;
+
+  vcache = LUX_MIN(vcache,LUX_VERTEXCACHE_MAX);
+  vcache = LUX_MAX(vcache,1);
+  memset(fifo,0xFF,sizeof(fifo));
+
+  for (i = 0; i < numIndices; i++){
+    uint32 v = type == LUX_MESH_INDEX_UINT16 ? ((const uint16*)indices)[i] : ((const uint32*)indices)[i];
+    for (c = 0; c < vcache; c++){
+      if (fifo[c] == v)
+        break;
+    }
+    if (c == vcache){
+      fifo[fifoPos] = v;
+      fifoPos = (fifoPos + 1) % vcache;
+      misses++;
+    }
+  }
+
+  stats->misses = misses;
+  stats->acmr = nTriangles ? (float)misses / (float)nTriangles : 0.0f;
+  stats->atvr = nVertices ? (float)misses / (float)nVertices : 0.0f;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Vertex Cache Optimizer Context
+
+LUX_API void lxVertexCacheOpt_init(lxVertexCacheOpt_t *ctx, lxMemoryAllocatorPTR allocator, void* scratch, size_t scratchSize)
+{
+  memset(ctx,0,sizeof(lxVertexCacheOpt_t));
+  ctx->allocator = allocator;
+  ctx->scratch = scratch;
+  ctx->scratchSize = scratch ? scratchSize : 0;
+  ctx->scratchOwned = LUX_FALSE;
+}
+
+LUX_API void lxVertexCacheOpt_deinit(lxVertexCacheOpt_t *ctx)
+{
+  if (ctx->scratchOwned){
+    lxMemoryAllocator_freeAligned(ctx->allocator,ctx->scratch,ctx->scratchSize);
+  }
+  ctx->scratch = NULL;
+  ctx->scratchSize = 0;
+  ctx->scratchOwned = LUX_FALSE;
+}
+
+LUX_API size_t lxVertexCacheOpt_scratchSize(int nTriangles, int nVertices)
+{
+  size_t tipsify = VertexCacheOpt_tipsifyScratch(nTriangles,nVertices);
+  size_t forsyth = VertexCacheOpt_forsythScratch(nTriangles,nVertices);
+
+  return LUX_MAX(tipsify,forsyth);
+}
+
+LUX_API void* lxVertexCacheOpt_reserve(lxVertexCacheOpt_t *ctx, int nTriangles, int nVertices)
+{
+  size_t needed = lxVertexCacheOpt_scratchSize(nTriangles,nVertices);
+
+  if (ctx->scratchSize >= needed){
+    return ctx->scratch;
+  }
+  if (!ctx->allocator){
+    return NULL;
+  }
+
+  lxVertexCacheOpt_deinit(ctx);
+  ctx->scratch = lxMemoryAllocator_mallocAligned(ctx->allocator,needed,VCACHEOPT_SCRATCH_ALIGN);
+  if (!ctx->scratch){
+    return NULL;
+  }
+  ctx->scratchSize = needed;
+  ctx->scratchOwned = LUX_TRUE;
+
+  return ctx->scratch;
+}
+
+  // same result as lxVertexCacheStats_compute, but O(1) per index:
+  // a vertex stamped with the miss count after its insertion is
+  // evicted by the vcache-th miss that follows
+static void VertexCacheOpt_statsStamped(lxVertexCacheStats_t *stats, const void* indices, int nTriangles, int nVertices, int vcache, lxMeshIndexType_t type, int* stamps)
+{
+  int     misses = 0;
+  int     numIndices = nTriangles * 3;
+  int     i;
+
+  vcache = LUX_MIN(vcache,LUX_VERTEXCACHE_MAX);
+  vcache = LUX_MAX(vcache,1);
+  for (i = 0; i < nVertices; i++){
+    stamps[i] = -vcache;
+  }
+
+  for (i = 0; i < numIndices; i++){
+    uint32 v = type == LUX_MESH_INDEX_UINT16 ? ((const uint16*)indices)[i] : ((const uint32*)indices)[i];
+    if (v >= (uint32)nVertices){
+      misses++;
+    }
+    else if (misses - stamps[v] >= vcache){
+      misses++;
+      stamps[v] = misses;
+    }
+  }
+
+  stats->misses = misses;
+  stats->acmr = nTriangles ? (float)misses / (float)nTriangles : 0.0f;
+  stats->atvr = nVertices ? (float)misses / (float)nVertices : 0.0f;
+}
+
+static void VertexCacheOpt_stats(lxVertexCacheOpt_t *ctx, lxVertexCacheStats_t *stats, const void* indices, int nTriangles, int nVertices, int vcache, lxMeshIndexType_t type)
+{
+  if (ctx->scratch && ctx->scratchSize >= sizeof(int) * (size_t)nVertices){
+    VertexCacheOpt_statsStamped(stats,indices,nTriangles,nVertices,vcache,type,(int*)ctx->scratch);
+  }
+  else{
+    lxVertexCacheStats_compute(stats,indices,nTriangles,nVertices,vcache,type);
+  }
+}
+
+void VertexCacheOpt_statsBefore(lxVertexCacheOpt_t *ctx, const void* indices, int nTriangles, int nVertices, int vcache, lxMeshIndexType_t type)
+{
+  VertexCacheOpt_stats(ctx,&ctx->before,indices,nTriangles,nVertices,vcache,type);
+  memset(&ctx->after,0,sizeof(lxVertexCacheStats_t));
+}
+
+void VertexCacheOpt_statsAfter(lxVertexCacheOpt_t *ctx, const void* indices, int nTriangles, int nVertices, int vcache, lxMeshIndexType_t type)
+{
+  VertexCacheOpt_stats(ctx,&ctx->after,indices,nTriangles,nVertices,vcache,type);
+}
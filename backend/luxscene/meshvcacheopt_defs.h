@@ -0,0 +1,49 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#ifndef __LUXSCENE_MESHVCACHEOPTDEFS_H__
+#define __LUXSCENE_MESHVCACHEOPTDEFS_H__
+
+#include <luxinia/luxscene/meshvcacheopt.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Scratch layout
+//
+// Each optimizer carves all its arrays from one scratch block,
+// every array starts VCACHEOPT_SCRATCH_ALIGN aligned.
+
+#define VCACHEOPT_SCRATCH_ALIGN   8
+
+size_t VertexCacheOpt_tipsifyScratch(int nTriangles, int nVertices);
+size_t VertexCacheOpt_forsythScratch(int nTriangles, int nVertices);
+
+  // computes ctx->before/after around the optimizer, uses scratch
+  // for per-vertex timestamps if large enough
+void VertexCacheOpt_statsBefore(lxVertexCacheOpt_t *ctx, const void* indices, int nTriangles, int nVertices, int vcache, lxMeshIndexType_t type);
+void VertexCacheOpt_statsAfter(lxVertexCacheOpt_t *ctx, const void* indices, int nTriangles, int nVertices, int vcache, lxMeshIndexType_t type);
+
+#ifdef __cplusplus
+}
+
+  // bytes of count elements, padded to alignment
+template <class T>
+static LUX_INLINE size_t TVertexCacheOpt_scratchBytes(size_t count)
+{
+  return ((sizeof(T) * count) + VCACHEOPT_SCRATCH_ALIGN - 1) & ~(size_t)(VCACHEOPT_SCRATCH_ALIGN - 1);
+}
+
+template <class T>
+static LUX_INLINE T* TVertexCacheOpt_scratchAlloc(byte* &scratch, size_t count)
+{
+  T* ptr = (T*)scratch;
+  scratch += TVertexCacheOpt_scratchBytes<T>(count);
+  return ptr;
+}
+#endif
+
+#endif
@@ -1,10 +1,16 @@
 /*
   Optimal Grid VertexCache, by Igancio Castano
   http://castano.ludicon.com/blog/2009/02/02/optimal-grid-rendering
+
+  Generates indices in place without allocations, reentrant
 */
 
 #include <luxinia/luxscene/meshvcacheopt.h>
 
+#include <string.h>
+
+#include "meshvcacheopt_defs.h"
+
 template<class VertexIndexType>
 VertexIndexType* TgridGen(VertexIndexType* pcurrent, VertexIndexType* pend, int x0, int x1, int y0, int y1, int width, int cacheSize)
 {
@@ -92,3 +98,19 @@ LUX_API void* lxVertexCacheOptimize_grid_castano(
   }
 }
 
+LUX_API void* lxVertexCacheOpt_gridCastano(lxVertexCacheOpt_t *ctx,
+  void* indices,  int maxTriangles,
+  int width,  int height,
+  int vcache, lxMeshIndexType_t type,
+  int *writtenTriangles)
+{
+  void* result = lxVertexCacheOptimize_grid_castano(indices,maxTriangles,width,height,vcache,type,writtenTriangles);
+
+  memset(&ctx->before,0,sizeof(lxVertexCacheStats_t));
+  memset(&ctx->after,0,sizeof(lxVertexCacheStats_t));
+  if (result){
+    VertexCacheOpt_statsAfter(ctx,indices,*writtenTriangles,(width+1)*(height+1),vcache,type);
+  }
+
+  return result;
+}
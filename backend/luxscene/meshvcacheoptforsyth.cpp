@@ -26,6 +26,8 @@
     changes.
    * Templated for different VertexIndexTypes
    * inplace operations
+   * score tables are per call and all arrays are taken from a single
+     scratch block, so it is reentrant
 
   Original Algorithm:
   http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
@@ -36,9 +38,12 @@
 #include <math.h>
 #include <string.h>
 #include <assert.h>
+#include <stdlib.h>
+
+#include "meshvcacheopt_defs.h"
 
 // Set these to adjust the performance and result quality
-#define VERTEX_CACHE_SIZE   l_vcachesize
+#define VERTEX_CACHE_SIZE   vcache
 #define VERTEX_CACHE_SIZE_MAX 32
 #define CACHE_FUNCTION_LENGTH 32
 
@@ -59,10 +64,10 @@ typedef int32 ArrayIndexType;
 #define VALENCE_SCORE_TABLE_SIZE  32
 
 // Precalculated tables
-static ScoreType l_cachePositionScore[CACHE_SCORE_TABLE_SIZE];
-static ScoreType l_valenceScore[VALENCE_SCORE_TABLE_SIZE];
-static int    l_inited = 0;
-static int    l_vcachesize = 8;
+struct ForsythScores{
+  ScoreType cachePosition[CACHE_SCORE_TABLE_SIZE];
+  ScoreType valence[VALENCE_SCORE_TABLE_SIZE];
+};
 
 #define ISADDED(x)  (triangleAdded[(x) >> 3] &  (1 << (x & 7)))
 #define SETADDED(x) (triangleAdded[(x) >> 3] |= (1 << (x & 7)))
@@ -74,7 +79,7 @@ static int    l_vcachesize = 8;
 #define VALENCE_BOOST_POWER 0.5f
 
 // Precalculate the tables
-static int initForsyth() {
+static int initForsyth(ForsythScores& scores, int vcache) {
   if (VERTEX_CACHE_SIZE > CACHE_SCORE_TABLE_SIZE   ||
     VERTEX_CACHE_SIZE > VERTEX_CACHE_SIZE_MAX)
     return 0;
@@ -94,23 +99,24 @@ static int initForsyth() {
       score = 1.0f - (i - 3) * scaler;
       score = powf(score, CACHE_DECAY_POWER);
     }
-    l_cachePositionScore[i] = (ScoreType) (SCORE_SCALING * score);
+    scores.cachePosition[i] = (ScoreType) (SCORE_SCALING * score);
   }
 
+  scores.valence[0] = 0;
   for (int i = 1; i < VALENCE_SCORE_TABLE_SIZE; i++) {
     // Bonus points for having a low number of tris still to
     // use the vert, so we get rid of lone verts quickly
     float valenceBoost = powf((float)i, -VALENCE_BOOST_POWER);
     float score = VALENCE_BOOST_SCALE * valenceBoost;
-    l_valenceScore[i] = (ScoreType) (SCORE_SCALING * score);
+    scores.valence[i] = (ScoreType) (SCORE_SCALING * score);
   }
 
-  l_inited = l_vcachesize;
   return 1;
 }
 
 // Calculate the score for a vertex
-static ScoreType findVertexScore(int numActiveTris,
+static ScoreType findVertexScore(const ForsythScores& scores,
+                          int numActiveTris,
                           int cachePosition) {
   if (numActiveTris == 0) {
     // No triangles need this vertex!
@@ -121,30 +127,41 @@ static ScoreType findVertexScore(int numActiveTris,
   if (cachePosition < 0) {
     // Vertex is not in LRU cache - no score
   } else {
-    score = l_cachePositionScore[cachePosition];
+    score = scores.cachePosition[cachePosition];
   }
 
   if (numActiveTris < VALENCE_SCORE_TABLE_SIZE)
-    score += l_valenceScore[numActiveTris];
+    score += scores.valence[numActiveTris];
   return score;
 }
 
+size_t VertexCacheOpt_forsythScratch(int nTriangles, int nVertices)
+{
+  return  TVertexCacheOpt_scratchBytes<AdjacencyType>(nVertices) +
+      TVertexCacheOpt_scratchBytes<ArrayIndexType>(nVertices) +
+      TVertexCacheOpt_scratchBytes<ScoreType>(nVertices) +
+      TVertexCacheOpt_scratchBytes<CachePosType>(nVertices) +
+      TVertexCacheOpt_scratchBytes<uint8>((nTriangles + 7)/8) +
+      TVertexCacheOpt_scratchBytes<ScoreType>(nTriangles) +
+      TVertexCacheOpt_scratchBytes<TriangleIndexType>(3*nTriangles) +
+      TVertexCacheOpt_scratchBytes<TriangleIndexType>(nTriangles);
+}
+
 // The main reordering function
 template<class VertexIndexType>
 VertexIndexType* TreorderForsyth(VertexIndexType* indices,
                                 int nTriangles,
                                 int nVertices,
-                int vcache) {
-
-  // The tables need not be inited every time this function
-  // is used. Either call initForsyth from the calling process,
-  // or just replace the score tables with precalculated values.
+                int vcache,
+                void* scratch) {
 
-  l_vcachesize = vcache;
-  if (l_inited != l_vcachesize && !initForsyth())
+  // The tables are cheap, and kept on stack to stay reentrant
+  ForsythScores scores;
+  if (!initForsyth(scores,vcache))
     return NULL;
 
-  AdjacencyType* numActiveTris = new AdjacencyType[nVertices];
+  byte* scratchPtr = (byte*)scratch;
+  AdjacencyType* numActiveTris = TVertexCacheOpt_scratchAlloc<AdjacencyType>(scratchPtr,nVertices);
   memset(numActiveTris, 0, sizeof(AdjacencyType)*nVertices);
 
   // First scan over the vertex data, count the total number of
@@ -153,20 +170,19 @@ VertexIndexType* TreorderForsyth(VertexIndexType* indices,
     if (numActiveTris[indices[i]] == MAX_ADJACENCY) {
       // Unsupported mesh,
       // vertex shared by too many triangles
-      delete [] numActiveTris;
       return NULL;
     }
     numActiveTris[indices[i]]++;
   }
 
   // Allocate the rest of the arrays
-  ArrayIndexType* offsets = new ArrayIndexType[nVertices];
-  ScoreType* lastScore = new ScoreType[nVertices];
-  CachePosType* cacheTag = new CachePosType[nVertices];
+  ArrayIndexType* offsets = TVertexCacheOpt_scratchAlloc<ArrayIndexType>(scratchPtr,nVertices);
+  ScoreType* lastScore = TVertexCacheOpt_scratchAlloc<ScoreType>(scratchPtr,nVertices);
+  CachePosType* cacheTag = TVertexCacheOpt_scratchAlloc<CachePosType>(scratchPtr,nVertices);
 
-  uint8* triangleAdded = new uint8[(nTriangles + 7)/8];
-  ScoreType* triangleScore = new ScoreType[nTriangles];
-  TriangleIndexType* triangleIndices = new TriangleIndexType[3*nTriangles];
+  uint8* triangleAdded = TVertexCacheOpt_scratchAlloc<uint8>(scratchPtr,(nTriangles + 7)/8);
+  ScoreType* triangleScore = TVertexCacheOpt_scratchAlloc<ScoreType>(scratchPtr,nTriangles);
+  TriangleIndexType* triangleIndices = TVertexCacheOpt_scratchAlloc<TriangleIndexType>(scratchPtr,3*nTriangles);
   memset(triangleAdded, 0, sizeof(uint8)*((nTriangles + 7)/8));
   memset(triangleScore, 0, sizeof(ScoreType)*nTriangles);
   memset(triangleIndices, 0, sizeof(TriangleIndexType)*3*nTriangles);
@@ -193,7 +209,7 @@ VertexIndexType* TreorderForsyth(VertexIndexType* indices,
 
   // Initialize the score for all vertices
   for (int i = 0; i < nVertices; i++) {
-    lastScore[i] = findVertexScore(numActiveTris[i], cacheTag[i]);
+    lastScore[i] = findVertexScore(scores, numActiveTris[i], cacheTag[i]);
     for (int j = 0; j < numActiveTris[i]; j++)
       triangleScore[triangleIndices[offsets[i] + j]] += lastScore[i];
   }
@@ -210,7 +226,7 @@ VertexIndexType* TreorderForsyth(VertexIndexType* indices,
   }
 
   // Allocate the output array
-  TriangleIndexType* outTriangles = new TriangleIndexType[nTriangles];
+  TriangleIndexType* outTriangles = TVertexCacheOpt_scratchAlloc<TriangleIndexType>(scratchPtr,nTriangles);
   int outPos = 0;
 
   // Initialize the cache
@@ -276,7 +292,7 @@ VertexIndexType* TreorderForsyth(VertexIndexType* indices,
         cacheTag[v] = -1;
         cache[i] = -1;
       }
-      ScoreType newScore = findVertexScore(numActiveTris[v],
+      ScoreType newScore = findVertexScore(scores, numActiveTris[v],
                                            cacheTag[v]);
       ScoreType diff = newScore - lastScore[v];
       for (int j = 0; j < numActiveTris[v]; j++)
@@ -310,17 +326,9 @@ VertexIndexType* TreorderForsyth(VertexIndexType* indices,
     }
   }
 
-  // Clean up
-  delete [] triangleIndices;
-  delete [] offsets;
-  delete [] lastScore;
-  delete [] numActiveTris;
-  delete [] cacheTag;
-  delete [] triangleAdded;
-  delete [] triangleScore;
-
-  // Convert the triangle index array into a full triangle list
-  VertexIndexType* outIndices = new VertexIndexType[3*nTriangles];
+  // Convert the triangle index array into a full triangle list,
+  // triangleIndices is no longer needed and holds 3*nTriangles
+  VertexIndexType* outIndices = (VertexIndexType*)triangleIndices;
   outPos = 0;
   for (int i = 0; i < nTriangles; i++) {
     int t = outTriangles[i];
@@ -329,33 +337,65 @@ VertexIndexType* TreorderForsyth(VertexIndexType* indices,
       outIndices[outPos++] = v;
     }
   }
-  outPos = 0;
-  for (int i = 0; i < nTriangles; i++) {
-    indices[outPos+0] = outIndices[outPos+0];
-    indices[outPos+1] = outIndices[outPos+1];
-    indices[outPos+2] = outIndices[outPos+2];
-    outPos += 3;
-  }
-
-  delete [] outIndices;
-  delete [] outTriangles;
+  memcpy(indices, outIndices, sizeof(VertexIndexType)*3*nTriangles);
 
   return indices;
 }
 
-LUX_API void* lxVertexCacheOptimize_forsyth(void* indices,
+static void* VertexCacheOpt_forsyth(void* indices,
         int nTriangles,
         int nVertices,
         int vcache,
-        lxMeshIndexType_t type )
+        lxMeshIndexType_t type,
+        void* scratch)
 {
   switch(type){
   case LUX_MESH_INDEX_UINT16:
-    return TreorderForsyth<uint16>((uint16*)indices,nTriangles,nVertices,vcache);
+    return TreorderForsyth<uint16>((uint16*)indices,nTriangles,nVertices,vcache,scratch);
     break;
   case LUX_MESH_INDEX_UINT32:
-    return TreorderForsyth<uint32>((uint32*)indices,nTriangles,nVertices,vcache);
+    return TreorderForsyth<uint32>((uint32*)indices,nTriangles,nVertices,vcache,scratch);
   default:
     return NULL;
   }
 }
+
+LUX_API void* lxVertexCacheOptimize_forsyth(void* indices,
+        int nTriangles,
+        int nVertices,
+        int vcache,
+        lxMeshIndexType_t type )
+{
+  void* scratch = malloc(VertexCacheOpt_forsythScratch(nTriangles,nVertices));
+  void* result;
+
+  if (!scratch)
+    return NULL;
+
+  result = VertexCacheOpt_forsyth(indices,nTriangles,nVertices,vcache,type,scratch);
+  free(scratch);
+
+  return result;
+}
+
+LUX_API void* lxVertexCacheOpt_forsyth(lxVertexCacheOpt_t *ctx,
+        void* indices,
+        int nTriangles,
+        int nVertices,
+        int vcache,
+        lxMeshIndexType_t type )
+{
+  void* scratch = lxVertexCacheOpt_reserve(ctx,nTriangles,nVertices);
+  void* result;
+
+  if (!scratch)
+    return NULL;
+
+  VertexCacheOpt_statsBefore(ctx,indices,nTriangles,nVertices,vcache,type);
+  result = VertexCacheOpt_forsyth(indices,nTriangles,nVertices,vcache,type,scratch);
+  if (result){
+    VertexCacheOpt_statsAfter(ctx,indices,nTriangles,nVertices,vcache,type);
+  }
+
+  return result;
+}
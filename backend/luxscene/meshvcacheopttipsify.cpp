@@ -26,6 +26,7 @@
   changes.
   * Templated for different VertexIndexTypes
   * inplace operations
+  * all arrays are taken from a single scratch block
 
   Original Algorithm:
   http://www.cs.princeton.edu/gfx/pubs/Sander_2007_%3ETR/tipsy.pdf
@@ -36,6 +37,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "meshvcacheopt_defs.h"
+
 #define DEAD_END_STACK_SIZE 128
 #define DEAD_END_STACK_MASK (DEAD_END_STACK_SIZE - 1)
 
@@ -123,24 +126,36 @@ static int TgetNextVertex(int nVertices,
   return n;
 }
 
+size_t VertexCacheOpt_tipsifyScratch(int nTriangles, int nVertices)
+{
+  return  TVertexCacheOpt_scratchBytes<AdjacencyType>(nVertices) +
+      TVertexCacheOpt_scratchBytes<ArrayIndexType>(nVertices+1) +
+      TVertexCacheOpt_scratchBytes<TriangleIndexType>(3*nTriangles) +
+      TVertexCacheOpt_scratchBytes<ArrayIndexType>(nVertices) +
+      TVertexCacheOpt_scratchBytes<uint8>((nTriangles + 7)/8) +
+      TVertexCacheOpt_scratchBytes<TriangleIndexType>(nTriangles);
+}
+
 // The main reordering function
 template<class VertexIndexType>
 VertexIndexType* Ttipsify(VertexIndexType* indices,
                          int nTriangles,
                          int nVertices,
-                         int k) 
+                         int k,
+                         void* scratch) 
 {
+  byte* scratchPtr = (byte*)scratch;
+
   // Vertex-triangle adjacency
 
   // Count the occurrances of each vertex
-  AdjacencyType* numOccurrances = new AdjacencyType[nVertices];
+  AdjacencyType* numOccurrances = TVertexCacheOpt_scratchAlloc<AdjacencyType>(scratchPtr,nVertices);
   memset(numOccurrances, 0, sizeof(AdjacencyType)*nVertices);
   for (int i = 0; i < 3*nTriangles; i++) {
     int v = indices[i];
     if (numOccurrances[v] == MAX_ADJACENCY) {
       // Unsupported mesh,
       // vertex shared by too many triangles
-      delete [] numOccurrances;
       return NULL;
     }
     numOccurrances[v]++;
@@ -148,19 +163,16 @@ VertexIndexType* Ttipsify(VertexIndexType* indices,
 
   // Find the offsets into the adjacency array for each vertex
   int sum = 0;
-  ArrayIndexType* offsets = new ArrayIndexType[nVertices+1];
-  int maxAdjacency = 0;
+  ArrayIndexType* offsets = TVertexCacheOpt_scratchAlloc<ArrayIndexType>(scratchPtr,nVertices+1);
   for (int i = 0; i < nVertices; i++) {
     offsets[i] = sum;
     sum += numOccurrances[i];
-    if (numOccurrances[i] > maxAdjacency)
-      maxAdjacency = numOccurrances[i];
     numOccurrances[i] = 0;
   }
   offsets[nVertices] = sum;
 
   // Add the triangle indices to the vertices it refers to
-  TriangleIndexType* adjacency = new TriangleIndexType[3*nTriangles];
+  TriangleIndexType* adjacency = TVertexCacheOpt_scratchAlloc<TriangleIndexType>(scratchPtr,3*nTriangles);
   for (int i = 0; i < nTriangles; i++) {
     const VertexIndexType* vptr = &indices[3*i];
     adjacency[offsets[vptr[0]] + numOccurrances[vptr[0]]] = i;
@@ -175,21 +187,21 @@ VertexIndexType* Ttipsify(VertexIndexType* indices,
   AdjacencyType* liveTriangles = numOccurrances;
 
   // Per-vertex caching time stamps
-  ArrayIndexType* cacheTime = new ArrayIndexType[nVertices];
+  ArrayIndexType* cacheTime = TVertexCacheOpt_scratchAlloc<ArrayIndexType>(scratchPtr,nVertices);
   memset(cacheTime, 0, sizeof(ArrayIndexType)*nVertices);
 
   // Dead-end vertex stack
-  VertexIndexType* deadEndStack = new VertexIndexType[DEAD_END_STACK_SIZE];
+  VertexIndexType deadEndStack[DEAD_END_STACK_SIZE];
   memset(deadEndStack, 0, sizeof(VertexIndexType)*DEAD_END_STACK_SIZE);
   int deadEndStackPos = 0;
   int deadEndStackStart = 0;
 
   // Per triangle emitted flag
-  uint8* emitted = new uint8[(nTriangles + 7)/8];
+  uint8* emitted = TVertexCacheOpt_scratchAlloc<uint8>(scratchPtr,(nTriangles + 7)/8);
   memset(emitted, 0, sizeof(uint8)*((nTriangles + 7)/8));
 
   // Empty output buffer
-  TriangleIndexType* outputTriangles = new TriangleIndexType[nTriangles];
+  TriangleIndexType* outputTriangles = TVertexCacheOpt_scratchAlloc<TriangleIndexType>(scratchPtr,nTriangles);
   int outputPos = 0;
 
   // Arbitrary starting vertex
@@ -198,7 +210,8 @@ VertexIndexType* Ttipsify(VertexIndexType* indices,
   int s = k + 1;
   int id = 0;
 
-  VertexIndexType* nextCandidates = new VertexIndexType[3*maxAdjacency];
+  // a fan emits at most MAX_ADJACENCY triangles
+  VertexIndexType nextCandidates[3*MAX_ADJACENCY];
 
   // For all valid fanning vertices
   while (f >= 0) {
@@ -242,17 +255,9 @@ VertexIndexType* Ttipsify(VertexIndexType* indices,
                       deadEndStackPos, deadEndStackStart);
   }
 
-  // Clean up
-  delete [] nextCandidates;
-  delete [] emitted;
-  delete [] deadEndStack;
-  delete [] cacheTime;
-  delete [] adjacency;
-  delete [] offsets;
-  delete [] numOccurrances;
-
-  // Convert the triangle index array into a full triangle list
-  VertexIndexType* outputIndices = new VertexIndexType[3*nTriangles];
+  // Convert the triangle index array into a full triangle list,
+  // adjacency is no longer needed and holds 3*nTriangles
+  VertexIndexType* outputIndices = (VertexIndexType*)adjacency;
   outputPos = 0;
   for (int i = 0; i < nTriangles; i++) {
     int t = outputTriangles[i];
@@ -261,34 +266,65 @@ VertexIndexType* Ttipsify(VertexIndexType* indices,
       outputIndices[outputPos++] = v;
     }
   }
-  outputPos = 0;
-  for (int i = 0; i < nTriangles; i++) {
-    indices[outputPos+0] = outputIndices[outputPos+0];
-    indices[outputPos+1] = outputIndices[outputPos+1];
-    indices[outputPos+2] = outputIndices[outputPos+2];
-    outputPos += 3;
-  }
-
-  delete [] outputTriangles;
-  delete [] outputIndices;
+  memcpy(indices, outputIndices, sizeof(VertexIndexType)*3*nTriangles);
 
   return indices;
 }
 
-
-LUX_API void* lxVertexCacheOptimize_tipsify(void* indices,
+static void* VertexCacheOpt_tipsify(void* indices,
         int nTriangles,
         int nVertices,
         int k,
-        lxMeshIndexType_t type )
+        lxMeshIndexType_t type,
+        void* scratch)
 {
   switch(type){
   case LUX_MESH_INDEX_UINT16:
-    return Ttipsify<uint16>((uint16*)indices,nTriangles,nVertices,k);
+    return Ttipsify<uint16>((uint16*)indices,nTriangles,nVertices,k,scratch);
     break;
   case LUX_MESH_INDEX_UINT32:
-    return Ttipsify<uint32>((uint32*)indices,nTriangles,nVertices,k);
+    return Ttipsify<uint32>((uint32*)indices,nTriangles,nVertices,k,scratch);
   default:
     return NULL;
   }
+}
+
+LUX_API void* lxVertexCacheOptimize_tipsify(void* indices,
+        int nTriangles,
+        int nVertices,
+        int k,
+        lxMeshIndexType_t type )
+{
+  void* scratch = malloc(VertexCacheOpt_tipsifyScratch(nTriangles,nVertices));
+  void* result;
+
+  if (!scratch)
+    return NULL;
+
+  result = VertexCacheOpt_tipsify(indices,nTriangles,nVertices,k,type,scratch);
+  free(scratch);
+
+  return result;
+}
+
+LUX_API void* lxVertexCacheOpt_tipsify(lxVertexCacheOpt_t *ctx,
+        void* indices,
+        int nTriangles,
+        int nVertices,
+        int k,
+        lxMeshIndexType_t type )
+{
+  void* scratch = lxVertexCacheOpt_reserve(ctx,nTriangles,nVertices);
+  void* result;
+
+  if (!scratch)
+    return NULL;
+
+  VertexCacheOpt_statsBefore(ctx,indices,nTriangles,nVertices,k,type);
+  result = VertexCacheOpt_tipsify(indices,nTriangles,nVertices,k,type,scratch);
+  if (result){
+    VertexCacheOpt_statsAfter(ctx,indices,nTriangles,nVertices,k,type);
+  }
+
+  return result;
 }
\ No newline at end of file
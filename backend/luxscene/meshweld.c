@@ -0,0 +1,408 @@
+// Copyright (C) 2004-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include <luxinia/luxscene/meshopt.h>
+#include <string.h>
+#include <math.h>
+
+//////////////////////////////////////////////////////////////////////////
+// Vertex Welding
+//
+// 1. hash every vertex (exact: all stream bytes, epsilon: grid cell)
+//    and count partitions per chunk
+// 2. scatter vertex indices by partition, keeping increasing order
+// 3. build one chained hash table per partition
+// 4. every vertex looks up the smallest equal vertex, read only
+// 5. sequential compaction into remap
+//
+// Chains are sorted by vertex index, so lookups stop early.
+
+#define MESHWELD_PARTITION_BITS   6
+#define MESHWELD_PARTITIONS       (1<<MESHWELD_PARTITION_BITS)
+#define MESHWELD_CHUNK            (1024*16)
+#define MESHWELD_CELL_MAX         (1<<30)
+
+typedef struct MeshWeld_s{
+  const lxMeshWeldStream_t* streams;
+  int           numStreams;
+  int           nVertices;
+  int           numChunks;
+
+  const float*  positions;
+  size_t        posStride;
+  float         epsilon;
+  float         cellScale;
+
+  uint32*       hashes;
+  uint32*       order;
+  uint32*       next;
+  uint32*       heads;
+  uint32*       chunkOffsets;
+  uint32*       remap;
+
+  uint32        partStart[MESHWELD_PARTITIONS+1];
+  uint32        tableStart[MESHWELD_PARTITIONS+1];
+}MeshWeld_t;
+
+static LUX_INLINE uint32 MeshWeld_rotl(uint32 x, int r)
+{
+  return (x << r) | (x >> (32 - r));
+}
+
+  // MurmurHash3 mixing
+static LUX_INLINE uint32 MeshWeld_mix(uint32 h, uint32 k)
+{
+  k *= 0xcc9e2d51;
+  k = MeshWeld_rotl(k,15);
+  k *= 0x1b873593;
+  h ^= k;
+  h = MeshWeld_rotl(h,13);
+  return h * 5 + 0xe6546b64;
+}
+
+static LUX_INLINE uint32 MeshWeld_final(uint32 h)
+{
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+static LUX_INLINE const byte* MeshWeld_getData(const lxMeshWeldStream_t* stream, uint32 v)
+{
+  return ((const byte*)stream->data) + stream->stride * v;
+}
+
+static LUX_INLINE const float* MeshWeld_getPos(const MeshWeld_t* weld, uint32 v)
+{
+  return (const float*)(((const byte*)weld->positions) + weld->posStride * v);
+}
+
+static uint32 MeshWeld_hashVertex(const MeshWeld_t* weld, uint32 v)
+{
+  uint32  h = 0;
+  int     s;
+
+  for (s = 0; s < weld->numStreams; s++){
+    const byte* data = MeshWeld_getData(&weld->streams[s],v);
+    size_t      size = weld->streams[s].size;
+    uint32      k;
+
+    for (; size >= 4; size -= 4, data += 4){
+      memcpy(&k,data,4);
+      h = MeshWeld_mix(h,k);
+    }
+    for (; size; size--, data++){
+      h = MeshWeld_mix(h,*data);
+    }
+  }
+
+  return MeshWeld_final(h);
+}
+
+static LUX_INLINE int MeshWeld_cellCoord(float f, float scale)
+{
+  float c = (float)floor(f * scale);
+  c = LUX_MAX(c,(float)-MESHWELD_CELL_MAX);
+  c = LUX_MIN(c,(float)MESHWELD_CELL_MAX);
+  return (int)c;
+}
+
+static LUX_INLINE uint32 MeshWeld_hashCell(const int cell[3])
+{
+  uint32 h = 0;
+  h = MeshWeld_mix(h,(uint32)cell[0]);
+  h = MeshWeld_mix(h,(uint32)cell[1]);
+  h = MeshWeld_mix(h,(uint32)cell[2]);
+  return MeshWeld_final(h);
+}
+
+static LUX_INLINE uint32 MeshWeld_partition(uint32 hash)
+{
+  return hash >> (32 - MESHWELD_PARTITION_BITS);
+}
+
+static LUX_INLINE uint32 MeshWeld_slot(const MeshWeld_t* weld, uint32 hash)
+{
+  uint32 part = MeshWeld_partition(hash);
+  uint32 mask = weld->tableStart[part+1] - weld->tableStart[part] - 1;
+  return weld->tableStart[part] + (hash & mask);
+}
+
+static booln MeshWeld_equalStreams(const MeshWeld_t* weld, uint32 a, uint32 b)
+{
+  int s;
+
+  for (s = 0; s < weld->numStreams; s++){
+    const lxMeshWeldStream_t* stream = &weld->streams[s];
+    if (memcmp(MeshWeld_getData(stream,a),MeshWeld_getData(stream,b),stream->size))
+      return LUX_FALSE;
+  }
+
+  return LUX_TRUE;
+}
+
+static void MeshWeld_getCell(const MeshWeld_t* weld, uint32 v, int cell[3])
+{
+  const float* pos = MeshWeld_getPos(weld,v);
+  cell[0] = MeshWeld_cellCoord(pos[0],weld->cellScale);
+  cell[1] = MeshWeld_cellCoord(pos[1],weld->cellScale);
+  cell[2] = MeshWeld_cellCoord(pos[2],weld->cellScale);
+}
+
+static void MeshWeld_hashJob(void* userdata, uint jobindex, uint threadindex)
+{
+  MeshWeld_t* weld = (MeshWeld_t*)userdata;
+  uint32*   counts = weld->chunkOffsets + jobindex * MESHWELD_PARTITIONS;
+  uint32    begin = jobindex * MESHWELD_CHUNK;
+  uint32    end = LUX_MIN(begin + MESHWELD_CHUNK,(uint32)weld->nVertices);
+  uint32    v;
+
+  memset(counts,0,sizeof(uint32) * MESHWELD_PARTITIONS);
+
+  for (v = begin; v < end; v++){
+    uint32 hash;
+    if (weld->positions){
+      int cell[3];
+      MeshWeld_getCell(weld,v,cell);
+      hash = MeshWeld_hashCell(cell);
+    }
+    else{
+      hash = MeshWeld_hashVertex(weld,v);
+    }
+    weld->hashes[v] = hash;
+    counts[MeshWeld_partition(hash)]++;
+  }
+}
+
+static void MeshWeld_scatterJob(void* userdata, uint jobindex, uint threadindex)
+{
+  MeshWeld_t* weld = (MeshWeld_t*)userdata;
+  uint32*   offsets = weld->chunkOffsets + jobindex * MESHWELD_PARTITIONS;
+  uint32    begin = jobindex * MESHWELD_CHUNK;
+  uint32    end = LUX_MIN(begin + MESHWELD_CHUNK,(uint32)weld->nVertices);
+  uint32    v;
+
+  for (v = begin; v < end; v++){
+    weld->order[offsets[MeshWeld_partition(weld->hashes[v])]++] = v;
+  }
+}
+
+static void MeshWeld_tableJob(void* userdata, uint jobindex, uint threadindex)
+{
+  MeshWeld_t* weld = (MeshWeld_t*)userdata;
+  uint32    begin = weld->partStart[jobindex];
+  uint32    i = weld->partStart[jobindex+1];
+
+  memset(weld->heads + weld->tableStart[jobindex],0xFF,
+    sizeof(uint32) * (weld->tableStart[jobindex+1] - weld->tableStart[jobindex]));
+
+  // reverse insertion, chains end up sorted by vertex
+  while (i > begin){
+    uint32 v = weld->order[--i];
+    uint32 slot = MeshWeld_slot(weld,weld->hashes[v]);
+    weld->next[v] = weld->heads[slot];
+    weld->heads[slot] = v;
+  }
+}
+
+static void MeshWeld_queryJob(void* userdata, uint jobindex, uint threadindex)
+{
+  MeshWeld_t* weld = (MeshWeld_t*)userdata;
+  uint32    begin = jobindex * MESHWELD_CHUNK;
+  uint32    end = LUX_MIN(begin + MESHWELD_CHUNK,(uint32)weld->nVertices);
+  uint32    v;
+
+  for (v = begin; v < end; v++){
+    uint32 hash = weld->hashes[v];
+    uint32 best = v;
+    uint32 j;
+
+    if (!weld->positions){
+      for (j = weld->heads[MeshWeld_slot(weld,hash)]; j < v; j = weld->next[j]){
+        if (weld->hashes[j] == hash && MeshWeld_equalStreams(weld,j,v)){
+          best = j;
+          break;
+        }
+      }
+    }
+    else{
+      const float* pos = MeshWeld_getPos(weld,v);
+      int lo[3];
+      int hi[3];
+      int ncell[3];
+      int c;
+
+      // cells are 2 * epsilon wide, the box around pos
+      // touches at most 2 per axis
+      for (c = 0; c < 3; c++){
+        lo[c] = MeshWeld_cellCoord(pos[c] - weld->epsilon,weld->cellScale);
+        hi[c] = MeshWeld_cellCoord(pos[c] + weld->epsilon,weld->cellScale);
+      }
+
+      for (ncell[2] = lo[2]; ncell[2] <= hi[2]; ncell[2]++)
+      for (ncell[1] = lo[1]; ncell[1] <= hi[1]; ncell[1]++)
+      for (ncell[0] = lo[0]; ncell[0] <= hi[0]; ncell[0]++){
+        uint32 nhash = MeshWeld_hashCell(ncell);
+
+        for (j = weld->heads[MeshWeld_slot(weld,nhash)]; j < best; j = weld->next[j]){
+          const float* npos;
+          if (weld->hashes[j] != nhash)
+            continue;
+
+          npos = MeshWeld_getPos(weld,j);
+          if (fabs(npos[0] - pos[0]) <= weld->epsilon &&
+              fabs(npos[1] - pos[1]) <= weld->epsilon &&
+              fabs(npos[2] - pos[2]) <= weld->epsilon &&
+              MeshWeld_equalStreams(weld,j,v))
+          {
+            best = j;
+            break;
+          }
+        }
+      }
+    }
+
+    weld->remap[v] = best;
+  }
+}
+
+static int MeshWeld_run(MeshWeld_t* weld, lxMemoryAllocatorPTR allocator, lxJobPoolPTR pool)
+{
+  uint32  nVertices = (uint32)weld->nVertices;
+  uint32  numChunks = (nVertices + MESHWELD_CHUNK - 1) / MESHWELD_CHUNK;
+  uint32  tableSize = 0;
+  uint32  next = 0;
+  size_t  scratchSize;
+  byte*   scratch;
+  uint32  p;
+  uint32  c;
+  uint32  v;
+
+  if (!nVertices)
+    return 0;
+
+  // tables are at most 4 * nVertices + 2 per partition
+  scratchSize = sizeof(uint32) * (nVertices * 3 + (nVertices * 4 + MESHWELD_PARTITIONS * 2) + numChunks * MESHWELD_PARTITIONS);
+  scratch = (byte*)lxMemoryAllocator_malloc(allocator,scratchSize);
+  if (!scratch)
+    return -1;
+
+  weld->numChunks = numChunks;
+  weld->hashes = (uint32*)scratch;
+  weld->order = weld->hashes + nVertices;
+  weld->next = weld->order + nVertices;
+  weld->chunkOffsets = weld->next + nVertices;
+  weld->heads = weld->chunkOffsets + numChunks * MESHWELD_PARTITIONS;
+
+  lxJobPool_run(pool,numChunks,MeshWeld_hashJob,weld);
+
+  // partition ranges and per chunk scatter offsets
+  for (p = 0; p < MESHWELD_PARTITIONS; p++){
+    uint32 count = 0;
+    uint32 size = 2;
+
+    weld->partStart[p] = next;
+    for (c = 0; c < numChunks; c++){
+      uint32* offset = &weld->chunkOffsets[c * MESHWELD_PARTITIONS + p];
+      uint32  chunkCount = *offset;
+      *offset = next + count;
+      count += chunkCount;
+    }
+    next += count;
+
+    while (size < count * 2){
+      size *= 2;
+    }
+    weld->tableStart[p] = tableSize;
+    tableSize += size;
+  }
+  weld->partStart[MESHWELD_PARTITIONS] = next;
+  weld->tableStart[MESHWELD_PARTITIONS] = tableSize;
+
+  lxJobPool_run(pool,numChunks,MeshWeld_scatterJob,weld);
+  lxJobPool_run(pool,MESHWELD_PARTITIONS,MeshWeld_tableJob,weld);
+  lxJobPool_run(pool,numChunks,MeshWeld_queryJob,weld);
+
+  // remap[v] <= v, earlier entries are already final
+  next = 0;
+  for (v = 0; v < nVertices; v++){
+    uint32 first = weld->remap[v];
+    weld->remap[v] = first == v ? next++ : weld->remap[first];
+  }
+
+  lxMemoryAllocator_free(allocator,scratch,scratchSize);
+
+  return (int)next;
+}
+
+LUX_API int lxMeshWeld_remap(uint32* remap,
+  lxMemoryAllocatorPTR allocator,
+  lxJobPoolPTR pool,
+  const lxMeshWeldStream_t* streams,
+  int numStreams,
+  int nVertices)
+{
+  MeshWeld_t weld;
+
+  if (nVertices < 0 || numStreams < 1)
+    return -1;
+
+  memset(&weld,0,sizeof(MeshWeld_t));
+  weld.streams = streams;
+  weld.numStreams = numStreams;
+  weld.nVertices = nVertices;
+  weld.remap = remap;
+
+  return MeshWeld_run(&weld,allocator,pool);
+}
+
+LUX_API int lxMeshWeld_remapEpsilon(uint32* remap,
+  lxMemoryAllocatorPTR allocator,
+  lxJobPoolPTR pool,
+  const float* positions,
+  size_t posStride,
+  float epsilon,
+  const lxMeshWeldStream_t* streams,
+  int numStreams,
+  int nVertices)
+{
+  MeshWeld_t weld;
+
+  if (nVertices < 0 || numStreams < 0 || !positions || !(epsilon > 0.0f))
+    return -1;
+
+  memset(&weld,0,sizeof(MeshWeld_t));
+  weld.streams = streams;
+  weld.numStreams = numStreams;
+  weld.nVertices = nVertices;
+  weld.positions = positions;
+  weld.posStride = posStride;
+  weld.epsilon = epsilon;
+  weld.cellScale = 0.5f / epsilon;
+  weld.remap = remap;
+
+  return MeshWeld_run(&weld,allocator,pool);
+}
+
+LUX_API int lxMeshVertices_compact(void* dst, const void* src, size_t stride, int nVertices, const uint32* remap)
+{
+  const byte* bsrc = (const byte*)src;
+  byte*       bdst = (byte*)dst;
+  uint32      written = 0;
+  int i;
+
+  for (i = 0; i < nVertices; i++){
+    if (remap[i] == written){
+      if (bdst + stride * written != bsrc + stride * i){
+        memmove(bdst + stride * written, bsrc + stride * i, stride);
+      }
+      written++;
+    }
+  }
+
+  return (int)written;
+}
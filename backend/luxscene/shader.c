@@ -3,6 +3,7 @@
 // See copyright notice in luxplatform.h
 
 #include <luxinia/luxscene/shader.h>
+#include <luxinia/luxgfx/context.h>
 #include <luxinia/luxplatform/debug.h>
 
 
@@ -152,6 +153,48 @@ LUX_API lxShaderIndex lxShaderProgram_getUpdateIndex( lxShaderProgram_t* shader,
   return -1;
 }
 
+//////////////////////////////////////////////////////////////////////////
+
+  // columns and rows (4 byte components) of value parameters
+static booln lxShaderParameter_valueShape(lxGLParameterType_t type, uint32* cols, uint32* rows)
+{
+  *cols = 1;
+  switch(type){
+  case LUXGL_PARAM_FLOAT  :
+  case LUXGL_PARAM_INT    :
+  case LUXGL_PARAM_UINT   :
+  case LUXGL_PARAM_BOOL   :
+    *rows = 1; return LUX_TRUE;
+  case LUXGL_PARAM_FLOAT2 :
+  case LUXGL_PARAM_INT2   :
+  case LUXGL_PARAM_UINT2  :
+  case LUXGL_PARAM_BOOL2  :
+  case LUXGL_PARAM_GPU_ADDRESS :
+    *rows = 2; return LUX_TRUE;
+  case LUXGL_PARAM_FLOAT3 :
+  case LUXGL_PARAM_INT3   :
+  case LUXGL_PARAM_UINT3  :
+  case LUXGL_PARAM_BOOL3  :
+    *rows = 3; return LUX_TRUE;
+  case LUXGL_PARAM_FLOAT4 :
+  case LUXGL_PARAM_INT4   :
+  case LUXGL_PARAM_UINT4  :
+  case LUXGL_PARAM_BOOL4  :
+    *rows = 4; return LUX_TRUE;
+  case LUXGL_PARAM_MAT2   : *cols = 2; *rows = 2; return LUX_TRUE;
+  case LUXGL_PARAM_MAT3   : *cols = 3; *rows = 3; return LUX_TRUE;
+  case LUXGL_PARAM_MAT4   : *cols = 4; *rows = 4; return LUX_TRUE;
+  case LUXGL_PARAM_MAT2x3 : *cols = 2; *rows = 3; return LUX_TRUE;
+  case LUXGL_PARAM_MAT2x4 : *cols = 2; *rows = 4; return LUX_TRUE;
+  case LUXGL_PARAM_MAT3x2 : *cols = 3; *rows = 2; return LUX_TRUE;
+  case LUXGL_PARAM_MAT3x4 : *cols = 3; *rows = 4; return LUX_TRUE;
+  case LUXGL_PARAM_MAT4x2 : *cols = 4; *rows = 2; return LUX_TRUE;
+  case LUXGL_PARAM_MAT4x3 : *cols = 4; *rows = 3; return LUX_TRUE;
+  default:
+    *rows = 0; return LUX_FALSE;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 
@@ -167,7 +210,7 @@ LUX_API void lxShaderUpdate_pushData( lxShaderUpdate_t* update, uint num, lxShad
   int max = 0;
 
   LUX_DEBUGASSERT( 0 <= level && level < LUX_SHADER_UPDATELEVELS);
-  LUX_DEBUGASSERT( level == 0 && num == update->numParams && "must provide all parameters at baselevel");
+  LUX_DEBUGASSERT( (level != 0 || num == update->numParams) && "must provide all parameters at baselevel");
 
   if ( level == 0 ){
     // TODO optimize, if separable shaders are used, check previous sub-shader programs
@@ -293,13 +336,135 @@ static uint lxShaderUpdate_buildProgramParamsSingle( lxShaderUpdate_t* update)
   return curProgParam;
 }
 
+static LUX_INLINE booln lxShaderUpdate_contentChanged(lxShaderUpdate_t* LUX_RESTRICT update, int paramidx, void* data)
+{
+  uint32 offset = update->contentOffsets[paramidx];
+  uint32 size   = update->contentOffsets[paramidx+1] - offset;
+  void*  last   = update->buildDatas[paramidx];
+
+  if (size && data && last){
+    if (memcmp(update->contentDatas + offset, data, size) == 0){
+      return LUX_FALSE;
+    }
+    memcpy(update->contentDatas + offset, data, size);
+    return LUX_TRUE;
+  }
+  else if (last != data){
+    if (size && data){
+      memcpy(update->contentDatas + offset, data, size);
+    }
+    return LUX_TRUE;
+  }
+
+  return LUX_FALSE;
+}
+
+static uint lxShaderUpdate_buildProgramParamsContentMulti( lxShaderUpdate_t* update)
+{
+  lxShaderProgram_t*  shader = update->shader;
+  int  level = update->level;
+  uint curProgParam = 0;
+  int i;
+
+  int min = update->dirtyMinMax[0];
+  int max = update->dirtyMinMax[1];
+
+  LUX_DEBUGASSERT( 0 <= level && level < LUX_SHADER_UPDATELEVELS);
+
+  for (i = min; i <= max; i++){
+    void* data = update->levelDatas[level][i];
+    if (lxShaderUpdate_contentChanged(update, i, data)){
+      curProgParam = lxShaderUpdate_appendParamMulti(update, shader, i, curProgParam, data);
+    }
+    update->buildDatas[i] = data;
+  }
+  update->dirtyMinMax[0] = update->numParams;
+  update->dirtyMinMax[1] = 0;
+
+  return curProgParam;
+}
+
+static uint lxShaderUpdate_buildProgramParamsContentSingle( lxShaderUpdate_t* update)
+{
+  lxShaderProgram_t*  shader = update->shader;
+  int  level = update->level;
+  uint curProgParam = 0;
+  int i;
+
+  int min = update->dirtyMinMax[0];
+  int max = update->dirtyMinMax[1];
+
+  LUX_DEBUGASSERT( 0 <= level && level < LUX_SHADER_UPDATELEVELS);
+
+  for (i = min; i <= max; i++){
+    void* data = update->levelDatas[level][i];
+    if (lxShaderUpdate_contentChanged(update, i, data)){
+      curProgParam = lxShaderUpdate_appendParamSingle(update, shader, i, curProgParam, data);
+    }
+    update->buildDatas[i] = data;
+  }
+  update->dirtyMinMax[0] = update->numParams;
+  update->dirtyMinMax[1] = 0;
+
+  return curProgParam;
+}
+
+  // bytes passed to the uniform functions, 0 for object parameters
+static uint32 lxShaderUpdate_contentSize(lxgProgramParameter_t* param)
+{
+  uint32 cols;
+  uint32 rows;
+
+  if (!lxShaderParameter_valueShape(param->type, &cols, &rows)){
+    return 0;
+  }
+  return LUX_MAX(param->uniform.count,1) * cols * rows * 4;
+}
+
+static uint32 lxShaderUpdate_paramContentSize(lxShaderProgram_t* shader, int paramidx)
+{
+  lxShaderParameter_t* param = &shader->params[paramidx];
+  uint32 size = 0;
+  uint i;
+  // all program parameters read the same data
+  for (i = 0; i < param->progCount; i++){
+    size = LUX_MAX(size, lxShaderUpdate_contentSize(shader->progParams[param->progOffset + i]));
+  }
+  return size;
+}
+
+LUX_API void lxShaderUpdate_trackContent(lxShaderUpdate_t* update, booln state)
+{
+  lxShaderProgram_t*  shader = update->shader;
+  uint i;
+
+  update->trackContent = state;
+  update->contentSize = 0;
+  if (!state){
+    update->funcBuildProgramParams = shader->hasMulti ? lxShaderUpdate_buildProgramParamsMulti : lxShaderUpdate_buildProgramParamsSingle;
+    return;
+  }
+
+  for (i = 0; i < update->numParams; i++){
+    update->contentSize += lxShaderUpdate_paramContentSize(shader, i);
+  }
+  update->funcBuildProgramParams = shader->hasMulti ? lxShaderUpdate_buildProgramParamsContentMulti : lxShaderUpdate_buildProgramParamsContentSingle;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 LUX_API void lxShaderUpdate_init(lxShaderUpdate_t* update, lxShaderProgram_t* shader)
 {
-  update->level = 0;
+  // first push is the base level
+  update->level = -1;
   update->numParams = shader->numParams;
   update->numProgParams = shader->numProgParams;
   update->shader = shader;
   update->funcBuildProgramParams = shader->hasMulti ? lxShaderUpdate_buildProgramParamsMulti : lxShaderUpdate_buildProgramParamsSingle;
+  update->trackContent = LUX_FALSE;
+  update->contentSize = 0;
+  update->contentOffsets = NULL;
+  update->contentDatas = NULL;
 }
 
 LUX_API size_t lxShaderUpdate_getMemSize(lxShaderUpdate_t* update)
@@ -307,7 +472,9 @@ LUX_API size_t lxShaderUpdate_getMemSize(lxShaderUpdate_t* update)
   return (sizeof(void*) + 
           sizeof(void*)*LUX_SHADER_UPDATELEVELS*2) * update->numParams +
          (sizeof(lxgProgramParameter_t*) + 
-          sizeof(void*)) * update->numProgParams;
+          sizeof(void*)) * update->numProgParams +
+         (update->trackContent ? 
+          sizeof(uint32) * (update->numParams + 1) + update->contentSize : 0);
 }
 
 LUX_API void lxShaderUpdate_initMem(lxShaderUpdate_t* update, size_t size, void* buffer)
@@ -330,10 +497,137 @@ LUX_API void lxShaderUpdate_initMem(lxShaderUpdate_t* update, size_t size, void*
   update->progDatas = (void**)bytes;
   bytes += sizeof(void*) * update->numProgParams;
 
+  if (update->trackContent){
+    uint32 offset = 0;
+
+    update->contentOffsets = (uint32*)bytes;
+    bytes += sizeof(uint32) * (update->numParams + 1);
+
+    update->contentDatas = bytes;
+    bytes += update->contentSize;
+
+    for (i = 0; i < (int)update->numParams; i++){
+      update->contentOffsets[i] = offset;
+      offset += lxShaderUpdate_paramContentSize(update->shader, i);
+    }
+    update->contentOffsets[i] = offset;
+    LUX_DEBUGASSERT(offset == update->contentSize);
+  }
+
   LUX_DEBUGASSERT(bytes == bytesend);
 }
 
 //////////////////////////////////////////////////////////////////////////
 
+LUX_API uint32 lxShaderBlock_layout(lxShaderBlock_t* block, lxShaderBlockEntry_t* entries, uint num)
+{
+  uint32 offset = 0;
+  uint i;
+
+  for (i = 0; i < num; i++){
+    lxShaderBlockEntry_t* entry = &entries[i];
+    uint32 count = LUX_MAX(entry->count,1);
+    uint32 cols;
+    uint32 rows;
+    uint32 align;
+    uint32 size;
+
+    if (!lxShaderParameter_valueShape(entry->type, &cols, &rows)){
+      entry->offset = (uint32)-1;
+      entry->vectors = 0;
+      entry->vectorSize = 0;
+      continue;
+    }
+
+    entry->vectors = (uint16)(cols * count);
+    entry->vectorSize = (uint16)(rows * 4);
+    if (entry->vectors == 1){
+      // vec3 aligns like vec4
+      align = rows == 3 ? 16 : rows * 4;
+      size  = rows * 4;
+    }
+    else{
+      // arrays and matrix columns have vec4 stride
+      align = 16;
+      size  = entry->vectors * 16;
+    }
+
+    offset = (offset + align - 1) & ~(align - 1);
+    entry->offset = offset;
+    offset += size;
+  }
+
+  block->numEntries = num;
+  block->entries = entries;
+  block->size = (offset + 15) & ~15;
+
+  return block->size;
+}
+
+LUX_API uint32 lxShaderBlock_initShader(lxShaderBlock_t* block, lxShaderBlockEntry_t* entries, lxShaderProgram_t* shader, uint num, const lxShaderIndex* indices)
+{
+  uint i;
+
+  for (i = 0; i < num; i++){
+    if (indices[i] >= 0){
+      lxShaderParameter_t* param = &shader->params[indices[i]];
+      entries[i].type  = param->type;
+      entries[i].count = shader->progParams[param->progOffset]->uniform.count;
+    }
+    else{
+      entries[i].type  = LUXGL_PARAM_USER;
+      entries[i].count = 0;
+    }
+  }
+
+  return lxShaderBlock_layout(block, entries, num);
+}
+
+LUX_API void lxShaderBlock_pack(const lxShaderBlock_t* block, void** datas, void* dst)
+{
+  const lxShaderBlockEntry_t* LUX_RESTRICT entry = block->entries;
+  byte* LUX_RESTRICT bytes = (byte*)dst;
+  uint i;
+
+  for (i = 0; i < block->numEntries; i++, entry++){
+    const byte* src = (const byte*)datas[i];
+    byte* out = bytes + entry->offset;
+    uint v;
+
+    if (!src || !entry->vectors){
+      continue;
+    }
+
+    if (entry->vectors == 1 || entry->vectorSize == 16){
+      memcpy(out, src, entry->vectors * entry->vectorSize);
+    }
+    else{
+      for (v = 0; v < entry->vectors; v++){
+        memcpy(out + v * 16, src + v * entry->vectorSize, entry->vectorSize);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+LUX_API uint32 lxShaderBlock_packRing(const lxShaderBlock_t* block, void** datas, lxgBufferRing_t* ring)
+{
+  uint offset;
+  void* dst = lxgBufferRing_alloc(ring, block->size, &offset);
+
+  if (!dst){
+    return (uint32)-1;
+  }
+  lxShaderBlock_pack(block, datas, dst);
+
+  return offset;
+}
 
+LUX_API void lxShaderBlock_bind(const lxShaderBlock_t* block, lxgContextPTR ctx, lxgBufferPTR buffer, uint unit, uint32 offset)
+{
+  lxgContext_setProgramBuffer(ctx, unit, buffer);
+  lxgBuffer_bindRanged(buffer, LUXGL_BUFFER_UNIFORM, unit, offset, block->size);
+}
 
+//////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,891 @@
+// Copyright (C) 2010-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include "../_project/project.hpp"
+#include <luxinia/luxcore/contscalararray.h>
+#include <luxinia/luxcore/contscalarexpr.h>
+#include <luxinia/luxcore/memorygeneric.h>
+#include <luxinia/luxplatform/cpu.h>
+
+// console benchmarks, run and quit after onInit
+
+//////////////////////////////////////////////////////////////////////////
+
+class AlignedBytes {
+public:
+  AlignedBytes(size_t size) : m_storage(size + 32) {
+    m_ptr = (void*)(((size_t)&m_storage[0] + 31) & ~(size_t)31);
+  }
+  inline void* get() { return m_ptr; }
+private:
+  std::vector<unsigned char>  m_storage;
+  void*                       m_ptr;
+};
+
+class ScalarArrayTest : public Project
+{
+private:
+  enum {
+    NUM_VECTORS = 1024 * 64,
+    VECTORDIM = 4,
+    NUM_SCALARS = NUM_VECTORS * VECTORDIM,
+    NUM_RUNS = 20,
+  };
+
+  AlignedBytes  m_data;
+  void*         m_out;
+  void*         m_outRef;
+  void*         m_args[3];
+
+public:
+  ScalarArrayTest()
+    : Project("scalararray","../../backend/test/")
+    , m_data(NUM_SCALARS * sizeof(double) * 5)
+  {
+    unsigned char* data = (unsigned char*)m_data.get();
+    m_out     = data;
+    m_args[0] = data + NUM_SCALARS * sizeof(double);
+    m_args[1] = data + NUM_SCALARS * sizeof(double) * 2;
+    m_args[2] = data + NUM_SCALARS * sizeof(double) * 3;
+    m_outRef  = data + NUM_SCALARS * sizeof(double) * 4;
+  }
+
+  void randomArgs(lxScalarType_t type){
+    for (int a = 0; a < 3; a++){
+      void* arg = m_args[a];
+      for (int i = 0; i < NUM_SCALARS; i++){
+        switch(type){
+        case LUX_SCALAR_FLOAT32:
+          ((float*)arg)[i] = randomFloat(0.01f,1.0f);
+          break;
+        case LUX_SCALAR_INT8:
+          ((int8*)arg)[i] = (int8)(rand() % 200 - 100);
+          break;
+        case LUX_SCALAR_UINT8:
+          ((uint8*)arg)[i] = (uint8)(rand() % 255 + 1);
+          break;
+        case LUX_SCALAR_INT16:
+          ((int16*)arg)[i] = (int16)(rand() % 20000 - 10000);
+          break;
+        case LUX_SCALAR_UINT16:
+          ((uint16*)arg)[i] = (uint16)(rand() % 65535 + 1);
+          break;
+        case LUX_SCALAR_INT32:
+          ((int32*)arg)[i] = rand() % 20000 - 10000;
+          break;
+        case LUX_SCALAR_UINT32:
+          ((uint32*)arg)[i] = rand() + 1;
+          break;
+        }
+      }
+    }
+    // no divisions by zero
+    for (int i = 0; i < NUM_SCALARS; i++){
+      switch(type){
+      case LUX_SCALAR_INT8:   if (!((int8*)m_args[1])[i])   ((int8*)m_args[1])[i] = 1; break;
+      case LUX_SCALAR_INT16:  if (!((int16*)m_args[1])[i])  ((int16*)m_args[1])[i] = 1; break;
+      case LUX_SCALAR_INT32:  if (!((int32*)m_args[1])[i])  ((int32*)m_args[1])[i] = 1; break;
+      default: break;
+      }
+    }
+  }
+
+  double run(lxScalarArrayOp_t op, lxScalarType_t type){
+    lxScalarArray_t sout;
+    lxScalarArray_t sargs[3];
+    lxScalarArray_init(&sout,type,m_out,VECTORDIM,VECTORDIM,NUM_VECTORS);
+    for (int a = 0; a < 3; a++){
+      lxScalarArray_init(&sargs[a],type,m_args[a],VECTORDIM,VECTORDIM,NUM_VECTORS);
+    }
+
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      if (op < LUX_SCALAR_OP3_LERP){
+        lxScalarArray_Op2(&sout,op,&sargs[0],&sargs[1]);
+      }
+      else{
+        lxScalarArray_Op3(&sout,op,&sargs[0],&sargs[1],&sargs[2]);
+      }
+    }
+    return glfwGetTime() - begin;
+  }
+
+  enum {
+    GUARD_SCALARS = 32,
+  };
+
+  static void runOnce(lxScalarArrayOp_t op, lxScalarArray_t *sout, lxScalarArray_t sargs[3]){
+    if (op < LUX_SCALAR_OP3_LERP){
+      lxScalarArray_Op2(sout,op,&sargs[0],&sargs[1]);
+    }
+    else{
+      lxScalarArray_Op3(sout,op,&sargs[0],&sargs[1],&sargs[2]);
+    }
+  }
+
+    // avx2 against default kernel on count vectors, with the last
+    // argument as single scalar if set. Scalars behind count must
+    // stay untouched.
+  booln compare(lxScalarArrayOp_t op, lxScalarType_t type, uint vectordim, uint count, booln single){
+    static const size_t typeSizes[LUX_SCALAR_UINT32+1] = {4,1,1,2,2,4,4};
+    size_t scalars = (size_t)count * vectordim;
+    size_t bytes = (scalars + GUARD_SCALARS) * typeSizes[type];
+    int lastArg = op < LUX_SCALAR_OP3_LERP ? 1 : 2;
+    void* outs[2] = {m_outRef,m_out};
+    lxScalarArray_t sargs[3];
+
+    for (int a = 0; a < 3; a++){
+      lxScalarArray_init(&sargs[a],type,m_args[a],vectordim,vectordim,count);
+    }
+    if (single){
+      lxScalarArray_initSingle(&sargs[lastArg],type,m_args[lastArg],1);
+      sargs[lastArg].count = count;
+    }
+
+    for (int k = 0; k < 2; k++){
+      lxScalarArray_t sout;
+      lxScalarArray_init(&sout,type,outs[k],vectordim,vectordim,count);
+      memset(outs[k],0x5A,bytes);
+      lxScalarArray_setKernel(k ? LUX_SCALAR_KERNEL_AVX2 : LUX_SCALAR_KERNEL_DEFAULT);
+      runOnce(op,&sout,sargs);
+    }
+
+    // avx2 does not overflow int32 in products, checked against int64
+    if (type == LUX_SCALAR_UINT16 && (op == LUX_SCALAR_OP2_MUL_SAT || op >= LUX_SCALAR_OP3_LERP) &&
+      op != LUX_SCALAR_OP3_MADD)
+    {
+      const uint16* out = (const uint16*)m_out;
+      const uint16* arg0 = (const uint16*)m_args[0];
+      const uint16* arg1 = (const uint16*)m_args[1];
+      const uint16* arg2 = (const uint16*)m_args[2];
+      for (size_t i = 0; i < scalars; i++){
+        int64 a = arg0[i];
+        int64 b = arg1[single && lastArg == 1 ? 0 : i];
+        int64 c = arg2[single ? 0 : i];
+        int64 res;
+        switch(op){
+        case LUX_SCALAR_OP2_MUL_SAT:  res = LUX_MIN(a * b,LUX_SHORT_UNSIGNEDMAX); break;
+        case LUX_SCALAR_OP3_LERP:     res = (uint16)(a + ((b - a) * c) / LUX_SHORT_UNSIGNEDMAX); break;
+        case LUX_SCALAR_OP3_LERPINV:  res = (uint16)(a + ((b - a) * (LUX_SHORT_UNSIGNEDMAX - c)) / LUX_SHORT_UNSIGNEDMAX); break;
+        default:                      res = LUX_MIN(a + b * c,LUX_SHORT_UNSIGNEDMAX); break;
+        }
+        if (out[i] != res){
+          return LUX_FALSE;
+        }
+      }
+      return !memcmp((const uint16*)m_outRef + scalars,out + scalars,GUARD_SCALARS * sizeof(uint16));
+    }
+    // fused multiply-add rounds once
+    if (type == LUX_SCALAR_FLOAT32 && op >= LUX_SCALAR_OP3_LERP){
+      const float* ref = (const float*)m_outRef;
+      const float* out = (const float*)m_out;
+      for (size_t i = 0; i < scalars + GUARD_SCALARS; i++){
+        if (fabs(ref[i] - out[i]) > 1e-6f * LUX_MAX(1.0f,fabs(ref[i]))){
+          return LUX_FALSE;
+        }
+      }
+      return LUX_TRUE;
+    }
+    return !memcmp(m_outRef,m_out,bytes);
+  }
+
+    // all types and ops, long arrays and tails, with and without single
+  int compareAll(lxScalarType_t type){
+    static const uint counts[] = {NUM_VECTORS,1,3,7,9,33,67};
+    static const uint dims[] = {1,VECTORDIM};
+    int failed = 0;
+
+    for (int op = LUX_SCALAR_OP2_ADD; op <= LUX_SCALAR_OP3_MADD_SAT; op++){
+      for (int d = 0; d < 2; d++){
+        for (size_t c = 0; c < sizeof(counts)/sizeof(counts[0]); c++){
+          for (int single = 0; single < 2; single++){
+            if (!compare((lxScalarArrayOp_t)op,type,dims[d],counts[c],single)){
+              failed++;
+            }
+          }
+        }
+      }
+    }
+    return failed;
+  }
+
+  int onInit(int argc, const char** argv) {
+    static const char* typeNames[LUX_SCALAR_UINT32+1] = {
+      "float","int8","uint8","int16","uint16","int32","uint32",
+    };
+    static const char* opNames[LUX_SCALAR_OPS] = {
+      "","","add","sub","mul","div","min","max","add_sat","sub_sat","mul_sat","div_sat",
+      "lerp","lerpinv","madd","madd_sat",
+    };
+
+    if (!lxScalarArray_isKernelSupported(LUX_SCALAR_KERNEL_AVX2)){
+      printf("scalararray: AVX2 kernel not supported\n");
+      return 1;
+    }
+
+    double scale = 1.0e9 / double(NUM_SCALARS * NUM_RUNS);
+    printf("scalararray: ns per scalar, %d scalars\n",NUM_SCALARS);
+    printf("  %-8s %-10s %8s %8s %8s\n","type","op","default","avx2","speedup");
+
+    for (int t = LUX_SCALAR_FLOAT32; t <= LUX_SCALAR_UINT32; t++){
+      randomArgs((lxScalarType_t)t);
+      for (int op = LUX_SCALAR_OP2_ADD; op <= LUX_SCALAR_OP3_MADD_SAT; op++){
+        lxScalarArray_setKernel(LUX_SCALAR_KERNEL_DEFAULT);
+        double timeDefault = run((lxScalarArrayOp_t)op,(lxScalarType_t)t);
+        lxScalarArray_setKernel(LUX_SCALAR_KERNEL_AVX2);
+        double timeAVX = run((lxScalarArrayOp_t)op,(lxScalarType_t)t);
+
+        printf("  %-8s %-10s %8.3f %8.3f %7.1fx\n",typeNames[t],opNames[op],
+          timeDefault * scale, timeAVX * scale, timeDefault/timeAVX);
+      }
+    }
+
+    for (int t = LUX_SCALAR_FLOAT32; t <= LUX_SCALAR_UINT32; t++){
+      randomArgs((lxScalarType_t)t);
+      int failed = compareAll((lxScalarType_t)t);
+      printf("  compare %-8s %s\n",typeNames[t],failed ? "FAILED" : "ok");
+    }
+    lxScalarArray_setKernel(LUX_SCALAR_KERNEL_AVX2);
+
+    return 1;
+  }
+
+};
+
+static ScalarArrayTest testScalarArray;
+
+//////////////////////////////////////////////////////////////////////////
+
+class ScalarArrayThreadTest : public Project
+{
+private:
+  enum {
+    NUM_SCALARS = 1024 * 1024 * 10,
+    VECTORDIM = 4,
+    NUM_VECTORS = NUM_SCALARS / VECTORDIM,
+    NUM_RUNS = 10,
+  };
+
+  AlignedBytes  m_data;
+  void*         m_out;
+  void*         m_args[3];
+
+public:
+  ScalarArrayThreadTest()
+    : Project("scalararraymt","../../backend/test/")
+    , m_data(NUM_SCALARS * sizeof(float) * 4)
+  {
+    unsigned char* data = (unsigned char*)m_data.get();
+    m_out     = data;
+    m_args[0] = data + NUM_SCALARS * sizeof(float);
+    m_args[1] = data + NUM_SCALARS * sizeof(float) * 2;
+    m_args[2] = data + NUM_SCALARS * sizeof(float) * 3;
+  }
+
+  double run(lxScalarArrayOp_t op, lxScalarType_t type){
+    lxScalarArray_t sout;
+    lxScalarArray_t sargs[3];
+    lxScalarArray_init(&sout,type,m_out,VECTORDIM,VECTORDIM,NUM_VECTORS);
+    for (int a = 0; a < 3; a++){
+      lxScalarArray_init(&sargs[a],type,m_args[a],VECTORDIM,VECTORDIM,NUM_VECTORS);
+    }
+
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      if (op < LUX_SCALAR_OP3_LERP){
+        lxScalarArray_Op2(&sout,op,&sargs[0],&sargs[1]);
+      }
+      else{
+        lxScalarArray_Op3(&sout,op,&sargs[0],&sargs[1],&sargs[2]);
+      }
+    }
+    return (glfwGetTime() - begin) / double(NUM_RUNS);
+  }
+
+  double run3D(lxScalarArrayOp_t op){
+    lxScalarArray3D_t sout;
+    lxScalarArray3D_t sargs[2];
+    lxScalarArray3D_t* arrays[3] = {&sout,&sargs[0],&sargs[1]};
+    void* data[3] = {m_out,m_args[0],m_args[1]};
+    uint region[3] = {256,256,NUM_VECTORS/(256*256)};
+
+    for (int a = 0; a < 3; a++){
+      lxScalarArray_init(&arrays[a]->sarr,LUX_SCALAR_FLOAT32,data[a],VECTORDIM,VECTORDIM,NUM_VECTORS);
+      arrays[a]->sz.width = region[0];
+      arrays[a]->sz.height = region[1];
+      arrays[a]->sz.depth = region[2];
+      lxScalarArray3D_setData(arrays[a],data[a]);
+    }
+
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxScalarArray3D_Op2(&sout,region,op,&sargs[0],&sargs[1]);
+    }
+    return (glfwGetTime() - begin) / double(NUM_RUNS);
+  }
+
+  enum {
+    NESTED_JOBS = 8,
+  };
+
+  static void nestedJob(void* userdata, uint jobindex, uint threadindex){
+    ScalarArrayThreadTest* self = (ScalarArrayThreadTest*)userdata;
+    uint count = NUM_SCALARS / NESTED_JOBS;
+    size_t offset = (size_t)jobindex * count * sizeof(float);
+    lxScalarArray_t sout;
+    lxScalarArray_t sargs[2];
+
+    lxScalarArray_init(&sout,LUX_SCALAR_FLOAT32,(byte*)self->m_out + offset,1,1,count);
+    lxScalarArray_init(&sargs[0],LUX_SCALAR_FLOAT32,(byte*)self->m_args[0] + offset,1,1,count);
+    lxScalarArray_init(&sargs[1],LUX_SCALAR_FLOAT32,(byte*)self->m_args[1] + offset,1,1,count);
+    lxScalarArray_Op2(&sout,LUX_SCALAR_OP2_ADD,&sargs[0],&sargs[1]);
+  }
+
+    // ops issued from within jobs of the pool they would use
+  booln checkNested(lxJobPoolPTR pool){
+    const float* out = (const float*)m_out;
+    const float* arg0 = (const float*)m_args[0];
+    const float* arg1 = (const float*)m_args[1];
+
+    memset(m_out,0,NUM_SCALARS * sizeof(float));
+    lxJobPool_run(pool,NESTED_JOBS,nestedJob,this);
+
+    for (int i = 0; i < NUM_SCALARS; i++){
+      if (out[i] != arg0[i] + arg1[i]){
+        return LUX_FALSE;
+      }
+    }
+    return LUX_TRUE;
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    uint maxThreads = lxCPU_getCount();
+
+    for (int a = 0; a < 3; a++){
+      float* arg = (float*)m_args[a];
+      for (int i = 0; i < NUM_SCALARS; i++){
+        arg[i] = randomFloat(0.01f,1.0f);
+      }
+    }
+
+    printf("scalararraymt: ms per op, %d scalars\n",NUM_SCALARS);
+    printf("  %7s %10s %10s %10s %10s %8s\n","threads","float add","float madd","int8 adds","3d add","speedup");
+
+    double timeBase = 0;
+    for (uint t = 1; t <= maxThreads; t++){
+      lxJobPoolPTR pool = lxJobPool_new(allocator,t);
+      lxScalarArray_setJobPool(pool,0);
+
+      double timeAdd  = run(LUX_SCALAR_OP2_ADD,LUX_SCALAR_FLOAT32);
+      double timeMadd = run(LUX_SCALAR_OP3_MADD,LUX_SCALAR_FLOAT32);
+      double timeSat  = run(LUX_SCALAR_OP2_ADD_SAT,LUX_SCALAR_INT8);
+      double time3D   = run3D(LUX_SCALAR_OP2_ADD);
+      double timeSum  = timeAdd + timeMadd + timeSat + time3D;
+      if (t == 1){
+        timeBase = timeSum;
+      }
+
+      printf("  %7d %10.3f %10.3f %10.3f %10.3f %7.2fx\n",t,
+        timeAdd * 1000.0, timeMadd * 1000.0, timeSat * 1000.0, time3D * 1000.0, timeBase/timeSum);
+
+      lxScalarArray_setJobPool(NULL,0);
+      lxJobPool_delete(pool);
+    }
+
+    {
+      lxJobPoolPTR pool = lxJobPool_new(allocator,maxThreads);
+      lxScalarArray_setJobPool(pool,1024);
+      printf("  nested ops: %s\n", checkNested(pool) ? "ok" : "FAILED");
+      lxScalarArray_setJobPool(NULL,0);
+      lxJobPool_delete(pool);
+    }
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static ScalarArrayThreadTest testScalarArrayThread;
+
+//////////////////////////////////////////////////////////////////////////
+
+class ScalarExprTest : public Project
+{
+private:
+  enum {
+    NUM_VECTORS = 1024 * 1024,
+    VECTORDIM = 4,
+    NUM_SCALARS = NUM_VECTORS * VECTORDIM,
+    NUM_ARRAYS = 8,
+    NUM_RUNS = 10,
+  };
+
+  AlignedBytes    m_data;
+  lxScalarArray_t m_arrays[NUM_ARRAYS];
+  float           m_scale;
+
+public:
+  ScalarExprTest()
+    : Project("scalarexpr","../../backend/test/")
+    , m_data(NUM_SCALARS * sizeof(float) * NUM_ARRAYS)
+  {
+    float* data = (float*)m_data.get();
+    for (int a = 0; a < NUM_ARRAYS; a++){
+      lxScalarArray_init(&m_arrays[a],LUX_SCALAR_FLOAT32,data + NUM_SCALARS * a,VECTORDIM,VECTORDIM,NUM_VECTORS);
+    }
+    m_scale = 0.5f;
+  }
+
+  // out = max(min(madd(lerp(a,b,w),c,scale),d),e) - a
+  enum Arrays {
+    ARRAY_A,
+    ARRAY_B,
+    ARRAY_W,
+    ARRAY_C,
+    ARRAY_D,
+    ARRAY_E,
+    ARRAY_TEMP,
+    ARRAY_OUT,
+  };
+
+  double runEager(){
+    lxScalarArray_t &temp = m_arrays[ARRAY_TEMP];
+    lxScalarArray_t &out = m_arrays[ARRAY_OUT];
+    lxScalarArray_t scale;
+    lxScalarArray_initSingle(&scale,LUX_SCALAR_FLOAT32,&m_scale,1);
+    scale.count = NUM_VECTORS;
+
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxScalarArray_Op3(&temp,LUX_SCALAR_OP3_LERP,&m_arrays[ARRAY_A],&m_arrays[ARRAY_B],&m_arrays[ARRAY_W]);
+      lxScalarArray_Op3(&out,LUX_SCALAR_OP3_MADD,&temp,&m_arrays[ARRAY_C],&scale);
+      lxScalarArray_Op2(&temp,LUX_SCALAR_OP2_MIN,&out,&m_arrays[ARRAY_D]);
+      lxScalarArray_Op2(&out,LUX_SCALAR_OP2_MAX,&temp,&m_arrays[ARRAY_E]);
+      lxScalarArray_Op2(&out,LUX_SCALAR_OP2_SUB,&out,&m_arrays[ARRAY_A]);
+    }
+    return (glfwGetTime() - begin) / double(NUM_RUNS);
+  }
+
+  double runFused(lxScalarExprPTR expr){
+    lxScalarArray_t scale;
+    lxScalarArray_initSingle(&scale,LUX_SCALAR_FLOAT32,&m_scale,1);
+
+    lxScalarExpr_clear(expr);
+    int a = lxScalarExpr_input(expr,&m_arrays[ARRAY_A]);
+    int n = lxScalarExpr_op3(expr,LUX_SCALAR_OP3_LERP,a,
+      lxScalarExpr_input(expr,&m_arrays[ARRAY_B]),lxScalarExpr_input(expr,&m_arrays[ARRAY_W]));
+    n = lxScalarExpr_op3(expr,LUX_SCALAR_OP3_MADD,n,
+      lxScalarExpr_input(expr,&m_arrays[ARRAY_C]),lxScalarExpr_input(expr,&scale));
+    n = lxScalarExpr_op2(expr,LUX_SCALAR_OP2_MIN,n,lxScalarExpr_input(expr,&m_arrays[ARRAY_D]));
+    n = lxScalarExpr_op2(expr,LUX_SCALAR_OP2_MAX,n,lxScalarExpr_input(expr,&m_arrays[ARRAY_E]));
+    n = lxScalarExpr_op2(expr,LUX_SCALAR_OP2_SUB,n,a);
+
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxScalarExpr_eval(expr,n,&m_arrays[ARRAY_TEMP]);
+    }
+    return (glfwGetTime() - begin) / double(NUM_RUNS);
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    lxScalarExprPTR expr = lxScalarExpr_new(allocator,LUX_SCALAR_FLOAT32,VECTORDIM);
+
+    for (int a = 0; a < ARRAY_TEMP; a++){
+      float* arg = m_arrays[a].data.tfloat;
+      for (int i = 0; i < NUM_SCALARS; i++){
+        arg[i] = randomFloat(0.01f,1.0f);
+      }
+    }
+
+    double timeEager = runEager();
+    double timeFused = runFused(expr);
+
+    double maxerr = 0;
+    for (int i = 0; i < NUM_SCALARS; i++){
+      maxerr = LUX_MAX(maxerr,fabs(m_arrays[ARRAY_OUT].data.tfloat[i] - m_arrays[ARRAY_TEMP].data.tfloat[i]));
+    }
+
+    printf("scalarexpr: 5 op chain, %d scalars, max error %g\n",NUM_SCALARS,maxerr);
+    printf("  eager %8.3f ms  fused %8.3f ms  %5.2fx\n",
+      timeEager * 1000.0, timeFused * 1000.0, timeEager/timeFused);
+
+    lxScalarExpr_delete(expr);
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static ScalarExprTest testScalarExpr;
+
+//////////////////////////////////////////////////////////////////////////
+
+class ScalarReduceTest : public Project
+{
+private:
+  enum {
+    NUM_VECTORS = 1024 * 1024 * 2,
+    VECTORDIM = 3,
+    NUM_SCALARS = NUM_VECTORS * VECTORDIM,
+    NUM_RUNS = 10,
+  };
+
+  AlignedBytes    m_data;
+  lxScalarArray_t m_points;
+  lxScalarArray_t m_prefix;
+
+public:
+  ScalarReduceTest()
+    : Project("scalarreduce","../../backend/test/")
+    , m_data(NUM_SCALARS * sizeof(float) * 2)
+  {
+    float* data = (float*)m_data.get();
+    lxScalarArray_init(&m_points,LUX_SCALAR_FLOAT32,data,VECTORDIM,VECTORDIM,NUM_VECTORS);
+    lxScalarArray_init(&m_prefix,LUX_SCALAR_FLOAT32,data + NUM_SCALARS,VECTORDIM,VECTORDIM,NUM_VECTORS);
+  }
+
+  // plain loop as reference, bounding box and centroid
+  double runLoop(float bbox[6], double sum[3]){
+    const float* points = m_points.data.tfloat;
+
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      for (int c = 0; c < VECTORDIM; c++){
+        bbox[c] = bbox[c+3] = points[c];
+        sum[c] = 0;
+      }
+      for (int i = 0; i < NUM_VECTORS; i++){
+        for (int c = 0; c < VECTORDIM; c++){
+          float val = points[i*VECTORDIM + c];
+          bbox[c] = LUX_MIN(bbox[c],val);
+          bbox[c+3] = LUX_MAX(bbox[c+3],val);
+          sum[c] += val;
+        }
+      }
+    }
+    return (glfwGetTime() - begin) / double(NUM_RUNS);
+  }
+
+  double runReduce(float bbox[6], double sum[3]){
+    lxScalarVector_t vmin;
+    lxScalarVector_t vmax;
+
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxScalarArray_minMax(&m_points,&vmin,&vmax,NULL,NULL);
+      lxScalarArray_sum(&m_points,sum);
+    }
+    double time = (glfwGetTime() - begin) / double(NUM_RUNS);
+
+    for (int c = 0; c < VECTORDIM; c++){
+      bbox[c] = vmin.tfloat[c];
+      bbox[c+3] = vmax.tfloat[c];
+    }
+    return time;
+  }
+
+  double runScan(){
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxScalarArray_scanInclusive(&m_prefix,&m_points);
+    }
+    return (glfwGetTime() - begin) / double(NUM_RUNS);
+  }
+
+  //////////////////////////////////////////////////////////////////////////
+  // checks against plain loops, without and with pool
+
+  enum {
+    CHECK_VECTORS = 200003,
+  };
+
+  struct ReduceResult{
+    double            sum[4];
+    double            dot;
+    lxScalarVector_t  vmin;
+    lxScalarVector_t  vmax;
+    lxScalarVector_t  vminSingle;
+    lxScalarVector_t  vmaxSingle;
+    uint              minidx[4];
+    uint              maxidx[4];
+  };
+
+  static uint32 randomBits(){
+    static uint32 seed = 1;
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+  }
+
+  static void randomValue(float &val)   { val = randomFloat(-100.0f,100.0f); }
+  static void randomValue(int8 &val)    { val = (int8)randomBits(); }
+  static void randomValue(uint8 &val)   { val = (uint8)randomBits(); }
+  static void randomValue(int16 &val)   { val = (int16)randomBits(); }
+  static void randomValue(uint16 &val)  { val = (uint16)randomBits(); }
+    // 16 bits keep 32-bit dot products exact in double
+  static void randomValue(int32 &val)   { val = (int32)(randomBits() & 0xFFFF) - 0x8000; }
+  static void randomValue(uint32 &val)  { val = randomBits() & 0xFFFF; }
+
+  static lxScalarType_t scalarType(float*)  { return LUX_SCALAR_FLOAT32; }
+  static lxScalarType_t scalarType(int8*)   { return LUX_SCALAR_INT8; }
+  static lxScalarType_t scalarType(uint8*)  { return LUX_SCALAR_UINT8; }
+  static lxScalarType_t scalarType(int16*)  { return LUX_SCALAR_INT16; }
+  static lxScalarType_t scalarType(uint16*) { return LUX_SCALAR_UINT16; }
+  static lxScalarType_t scalarType(int32*)  { return LUX_SCALAR_INT32; }
+  static lxScalarType_t scalarType(uint32*) { return LUX_SCALAR_UINT32; }
+
+  static booln reduce(ReduceResult &res, lxScalarArray_t *sarr0, lxScalarArray_t *sarr1,
+    lxScalarArray_t *sinclusive, lxScalarArray_t *sexclusive)
+  {
+    memset(&res,0,sizeof(res));
+    return lxScalarArray_sum(sarr0,res.sum) ||
+      lxScalarArray_dot(sarr0,sarr1,&res.dot) ||
+      lxScalarArray_minMax(sarr0,&res.vmin,&res.vmax,res.minidx,res.maxidx) ||
+      lxScalarArray_min(sarr0,&res.vminSingle) ||
+      lxScalarArray_max(sarr0,&res.vmaxSingle) ||
+      lxScalarArray_scanInclusive(sinclusive,sarr0) ||
+      lxScalarArray_scanExclusive(sexclusive,sarr0);
+  }
+
+  template <class T>
+  static booln checkScan(const std::vector<T> &data, const std::vector<T> &out, uint vectordim, uint stride, booln exclusive)
+  {
+    T run[4] = {0,0,0,0};
+    double refrun[4] = {0,0,0,0};
+    double refabs[4] = {0,0,0,0};
+
+    for (size_t i = 0; i < CHECK_VECTORS; i++){
+      const T* pIn = &data[i * stride];
+      const T* pOut = &out[i * stride];
+      for (uint c = 0; c < vectordim; c++){
+        if (!exclusive){
+          run[c] = (T)(run[c] + pIn[c]);
+          refrun[c] += pIn[c];
+          refabs[c] += fabs((double)pIn[c]);
+        }
+        if (scalarType((T*)0) == LUX_SCALAR_FLOAT32 ?
+          fabs(pOut[c] - refrun[c]) > 1e-5 * refabs[c] + 1e-3 : pOut[c] != run[c])
+        {
+          return LUX_FALSE;
+        }
+        if (exclusive){
+          run[c] = (T)(run[c] + pIn[c]);
+          refrun[c] += pIn[c];
+          refabs[c] += fabs((double)pIn[c]);
+        }
+      }
+    }
+    return LUX_TRUE;
+  }
+
+    // all reductions and scans, compact and strided, vector1 to 4
+  template <class T>
+  static booln checkType(lxJobPoolPTR pool)
+  {
+    lxScalarType_t type = scalarType((T*)0);
+    booln isfloat = type == LUX_SCALAR_FLOAT32;
+    booln ok = LUX_TRUE;
+
+    for (uint vectordim = 1; vectordim <= 4; vectordim++){
+      for (uint stride = vectordim; stride <= vectordim + 1; stride++){
+        size_t size = (size_t)CHECK_VECTORS * stride;
+        std::vector<T> data0(size);
+        std::vector<T> data1(size);
+        std::vector<T> inclusive[2];
+        std::vector<T> exclusive[2];
+        lxScalarArray_t sarr0;
+        lxScalarArray_t sarr1;
+        ReduceResult res[2];
+        double refsum[4] = {0,0,0,0};
+        double refabs[4] = {0,0,0,0};
+        double refdot = 0;
+        double refdotabs = 0;
+        T refmin[4];
+        T refmax[4];
+        uint refminidx[4] = {0,0,0,0};
+        uint refmaxidx[4] = {0,0,0,0};
+
+        for (size_t i = 0; i < size; i++){
+          randomValue(data0[i]);
+          randomValue(data1[i]);
+        }
+        lxScalarArray_init(&sarr0,type,&data0[0],vectordim,stride,CHECK_VECTORS);
+        lxScalarArray_init(&sarr1,type,&data1[0],vectordim,stride,CHECK_VECTORS);
+
+        for (uint c = 0; c < vectordim; c++){
+          refmin[c] = refmax[c] = data0[c];
+        }
+        for (uint i = 0; i < CHECK_VECTORS; i++){
+          const T* p0 = &data0[(size_t)i * stride];
+          const T* p1 = &data1[(size_t)i * stride];
+          for (uint c = 0; c < vectordim; c++){
+            refsum[c] += p0[c];
+            refabs[c] += fabs((double)p0[c]);
+            refdot += (double)p0[c] * (double)p1[c];
+            refdotabs += fabs((double)p0[c] * (double)p1[c]);
+            if (p0[c] < refmin[c]){
+              refmin[c] = p0[c];
+              refminidx[c] = i;
+            }
+            if (p0[c] > refmax[c]){
+              refmax[c] = p0[c];
+              refmaxidx[c] = i;
+            }
+          }
+        }
+
+        // 0 without pool, 1 with pool
+        for (int p = 0; p < 2; p++){
+          lxScalarArray_t sinclusive;
+          lxScalarArray_t sexclusive;
+
+          inclusive[p].resize(size);
+          exclusive[p].resize(size);
+          lxScalarArray_init(&sinclusive,type,&inclusive[p][0],vectordim,stride,CHECK_VECTORS);
+          lxScalarArray_init(&sexclusive,type,&exclusive[p][0],vectordim,stride,CHECK_VECTORS);
+
+          lxScalarArray_setJobPool(p ? pool : NULL,1);
+          if (reduce(res[p],&sarr0,&sarr1,&sinclusive,&sexclusive)){
+            return LUX_FALSE;
+          }
+          lxScalarArray_setJobPool(NULL,0);
+        }
+
+        for (uint c = 0; c < vectordim; c++){
+          ok &= isfloat ? fabs(res[0].sum[c] - refsum[c]) <= 1e-5 * refabs[c] : res[0].sum[c] == refsum[c];
+          ok &= ((T*)&res[0].vmin)[c] == refmin[c] && ((T*)&res[0].vmax)[c] == refmax[c];
+          ok &= ((T*)&res[0].vminSingle)[c] == refmin[c] && ((T*)&res[0].vmaxSingle)[c] == refmax[c];
+          ok &= res[0].minidx[c] == refminidx[c] && res[0].maxidx[c] == refmaxidx[c];
+        }
+        ok &= isfloat ? fabs(res[0].dot - refdot) <= 1e-5 * refdotabs : res[0].dot == refdot;
+        ok &= checkScan(data0,inclusive[0],vectordim,stride,LUX_FALSE);
+        ok &= checkScan(data0,exclusive[0],vectordim,stride,LUX_TRUE);
+
+        // pool must not change any bit
+        ok &= !memcmp(&res[0],&res[1],sizeof(ReduceResult));
+        ok &= !memcmp(&inclusive[0][0],&inclusive[1][0],sizeof(T) * size);
+        ok &= !memcmp(&exclusive[0][0],&exclusive[1][0],sizeof(T) * size);
+      }
+    }
+    return ok;
+  }
+
+    // relative path lengths, vector4 uses vector3 distance
+  static booln checkRelLength(lxJobPoolPTR pool)
+  {
+    booln ok = LUX_TRUE;
+
+    for (uint vectordim = 1; vectordim <= 4; vectordim++){
+      uint dims = LUX_MIN(vectordim,3);
+      std::vector<float> path((size_t)CHECK_VECTORS * vectordim);
+      std::vector<double> ref(CHECK_VECTORS);
+      std::vector<float> rel[2];
+      float length[2];
+      lxScalarArray_t spath;
+
+      for (size_t i = 0; i < path.size(); i++){
+        path[i] = randomFloat(-1.0f,1.0f);
+      }
+      lxScalarArray_init(&spath,LUX_SCALAR_FLOAT32,&path[0],vectordim,vectordim,CHECK_VECTORS);
+
+      ref[0] = 0;
+      for (uint i = 1; i < CHECK_VECTORS; i++){
+        const float* cur = &path[(size_t)i * vectordim];
+        double dist = 0;
+        for (uint c = 0; c < dims; c++){
+          double delta = cur[c] - cur[(int)c - (int)vectordim];
+          dist += delta * delta;
+        }
+        ref[i] = ref[i-1] + sqrt(dist);
+      }
+
+      for (int p = 0; p < 2; p++){
+        lxScalarArray_t slen;
+
+        rel[p].resize(CHECK_VECTORS);
+        lxScalarArray_init(&slen,LUX_SCALAR_FLOAT32,&rel[p][0],1,1,CHECK_VECTORS);
+
+        lxScalarArray_setJobPool(p ? pool : NULL,1);
+        if (lxFScalarArray_relLength(&slen,&spath,&length[p])){
+          return LUX_FALSE;
+        }
+        lxScalarArray_setJobPool(NULL,0);
+      }
+
+      ok &= fabs(length[0] - ref[CHECK_VECTORS-1]) <= 1e-5 * ref[CHECK_VECTORS-1];
+      for (uint i = 0; i < CHECK_VECTORS; i++){
+        ok &= fabs(rel[0][i] - ref[i] / ref[CHECK_VECTORS-1]) <= 1e-5;
+      }
+      ok &= length[0] == length[1] && !memcmp(&rel[0][0],&rel[1][0],sizeof(float) * CHECK_VECTORS);
+    }
+    return ok;
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    uint maxThreads = lxCPU_getCount();
+    float* points = m_points.data.tfloat;
+    float bboxLoop[6];
+    float bboxReduce[6];
+    double sumLoop[3];
+    double sumReduce[3];
+
+    for (int i = 0; i < NUM_SCALARS; i++){
+      points[i] = randomFloat(-100.0f,100.0f);
+    }
+
+    double timeLoop = runLoop(bboxLoop,sumLoop);
+
+    printf("scalarreduce: ms per op, %d vector3\n",NUM_VECTORS);
+    printf("  loop bbox+sum %8.3f\n",timeLoop * 1000.0);
+    printf("  %7s %10s %10s %8s\n","threads","bbox+sum","scan","speedup");
+
+    for (uint t = 1; t <= maxThreads; t++){
+      lxJobPoolPTR pool = lxJobPool_new(allocator,t);
+      lxScalarArray_setJobPool(pool,0);
+
+      double timeReduce = runReduce(bboxReduce,sumReduce);
+      double timeScan = runScan();
+
+      printf("  %7d %10.3f %10.3f %7.2fx\n",t,
+        timeReduce * 1000.0, timeScan * 1000.0, timeLoop/timeReduce);
+
+      lxScalarArray_setJobPool(NULL,0);
+      lxJobPool_delete(pool);
+    }
+
+    double maxerr = 0;
+    for (int c = 0; c < VECTORDIM; c++){
+      maxerr = LUX_MAX(maxerr,fabs(bboxLoop[c] - bboxReduce[c]));
+      maxerr = LUX_MAX(maxerr,fabs(bboxLoop[c+3] - bboxReduce[c+3]));
+      maxerr = LUX_MAX(maxerr,fabs(sumLoop[c] - sumReduce[c]) / NUM_VECTORS);
+    }
+    printf("  max error %g\n",maxerr);
+
+    {
+      lxJobPoolPTR pool = lxJobPool_new(allocator,LUX_MAX(maxThreads,2));
+      printf("  check float  %s\n",checkType<float>(pool) ? "ok" : "FAILED");
+      printf("  check int8   %s\n",checkType<int8>(pool) ? "ok" : "FAILED");
+      printf("  check uint8  %s\n",checkType<uint8>(pool) ? "ok" : "FAILED");
+      printf("  check int16  %s\n",checkType<int16>(pool) ? "ok" : "FAILED");
+      printf("  check uint16 %s\n",checkType<uint16>(pool) ? "ok" : "FAILED");
+      printf("  check int32  %s\n",checkType<int32>(pool) ? "ok" : "FAILED");
+      printf("  check uint32 %s\n",checkType<uint32>(pool) ? "ok" : "FAILED");
+      printf("  check relLength %s\n",checkRelLength(pool) ? "ok" : "FAILED");
+      lxJobPool_delete(pool);
+    }
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static ScalarReduceTest testScalarReduce;
+
@@ -0,0 +1,587 @@
+// Copyright (C) 2010-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include "../_project/project.hpp"
+#include <luxinia/luxgfx/luxgfx.h>
+#include <luxinia/luxcore/jobpool.h>
+#include <luxinia/luxcore/memorygeneric.h>
+
+// console benchmarks without GL, run and quit after onInit
+
+//////////////////////////////////////////////////////////////////////////
+
+class CmdListTest : public Project
+{
+private:
+  enum {
+    NUM_DRAWS = 100000,
+    NUM_PROGRAMS = 16,
+    NUM_TEXTURES = 256,
+    NUM_GEOMETRIES = 64,
+    NUM_STATES = 4,
+    MAX_LISTS = 64,
+    NUM_RUNS = 8,
+  };
+
+  // objects are only referenced, any distinct address will do
+  std::vector<double>   m_objects;
+
+  struct Record {
+    CmdListTest*        test;
+    lxgCmdList_t*       lists;
+    uint                numLists;
+  };
+
+public:
+  CmdListTest()
+    : Project("cmdlist","../../backend/test/")
+    , m_objects(16 * 256)
+  {
+
+  }
+
+  template<class T>
+  T object(int type, int idx){
+    return (T)&m_objects[(type * 256 + idx) % m_objects.size()];
+  }
+
+  // a draw as the scene would record it: program with parameters,
+  // textures, geometry and raster states, all picked per item
+  void recordDraw(lxgCmdList_t* list, uint item){
+    static const void* paramData[2];
+    uint prog = (item * 7) % NUM_PROGRAMS;
+    uint geom = (item * 13) % NUM_GEOMETRIES;
+    lxgTexturePTR  texs[2] = {object<lxgTexturePTR>(1,item % NUM_TEXTURES),object<lxgTexturePTR>(1,(item * 3) % NUM_TEXTURES)};
+    lxgSamplerCPTR samps[2] = {object<lxgSamplerCPTR>(2,0),object<lxgSamplerCPTR>(2,1)};
+    lxgProgramParameterPTR params[2] = {object<lxgProgramParameterPTR>(3,prog * 2),object<lxgProgramParameterPTR>(3,prog * 2 + 1)};
+    lxgStreamHost_t host;
+    lxgDrawCall_t draw;
+
+    host.buffer = object<lxgBufferPTR>(4,geom);
+    host.offset = 0;
+    host.len = 1024;
+    draw.primitive = LUXGL_TRIANGLES;
+    draw.indexType = LUX_SCALAR_UINT16;
+    draw.count = 36 + geom * 3;
+    draw.first = 0;
+    draw.baseVertex = 0;
+    draw.instances = 1;
+
+    lxgCmdList_program(list,object<lxgProgramCPTR>(0,prog));
+    lxgCmdList_programParameters(list,object<lxgProgramCPTR>(0,prog),2,params,paramData);
+    lxgCmdList_samplers(list,samps,0,2);
+    lxgCmdList_textures(list,texs,0,2);
+    lxgCmdList_vertexDecl(list,object<lxgVertexDeclCPTR>(5,geom % 4));
+    lxgCmdList_vertexAttribs(list,0x7);
+    lxgCmdList_vertexStream(list,0,&host);
+    lxgCmdList_indexBuffer(list,object<lxgBufferCPTR>(6,geom));
+    lxgCmdList_blend(list,object<lxgBlendCPTR>(7,item % NUM_STATES));
+    lxgCmdList_depth(list,object<lxgDepthCPTR>(8,0));
+    lxgCmdList_rasterizer(list,object<lxgRasterizerCPTR>(9,0));
+    lxgCmdList_draw(list,&draw);
+  }
+
+  static void recordJob(void* userdata, uint jobindex, uint threadindex){
+    Record* record = (Record*)userdata;
+    uint begin = (uint)((uint64)NUM_DRAWS * jobindex / record->numLists);
+    uint end = (uint)((uint64)NUM_DRAWS * (jobindex + 1) / record->numLists);
+    lxgCmdList_t* list = &record->lists[jobindex];
+
+    lxgCmdList_reset(list);
+    for (uint i = begin; i < end; i++){
+      record->test->recordDraw(list,i);
+    }
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    bool ok = true;
+
+    // draws are split evenly, so is the memory
+    std::vector<double> memory((NUM_DRAWS * 320 + MAX_LISTS * 1024) / sizeof(double));
+    lxgCmdList_t lists[MAX_LISTS];
+
+    printf("cmdlist: %d draws, 12 commands per draw\n",NUM_DRAWS);
+    for (uint t = 1; t <= 16; t *= 2){
+      lxJobPoolPTR pool = lxJobPool_new(allocator,t);
+      Record record = {this,lists,LUX_MIN(t * 4,MAX_LISTS)};
+      size_t perList = (memory.size() / record.numLists) * sizeof(double);
+
+      for (uint l = 0; l < record.numLists; l++){
+        lxgCmdList_init(&lists[l],(byte*)&memory[0] + perList * l,perList);
+      }
+
+      double begin = glfwGetTime();
+      for (int r = 0; r < NUM_RUNS; r++){
+        lxJobPool_run(pool,record.numLists,recordJob,&record);
+      }
+      double timeRecord = (glfwGetTime() - begin) / double(NUM_RUNS);
+
+      lxgCmdStats_t stats;
+      memset(&stats,0,sizeof(stats));
+      begin = glfwGetTime();
+      for (uint l = 0; l < record.numLists; l++){
+        ok &= !lists[l].overflow;
+        ok &= lxgCmdList_validate(&lists[l],&stats) == LUX_TRUE;
+      }
+      double timeValidate = glfwGetTime() - begin;
+
+      ok &= stats.numDraws == NUM_DRAWS && stats.counts[LUXGFX_CMD_DRAW] == NUM_DRAWS;
+      ok &= stats.numCmds == NUM_DRAWS * 12 && stats.numErrors == 0;
+      printf("  %2d threads %3d lists: record %.3f ms, null replay %.3f ms, %.1f bytes/draw\n",
+        t,record.numLists,timeRecord * 1000.0,timeValidate * 1000.0,double(stats.bytes) / double(NUM_DRAWS));
+
+      lxJobPool_delete(pool);
+    }
+
+    // overflow drops commands but keeps the list valid
+    {
+      lxgCmdList_t list;
+      lxgCmdStats_t stats;
+      lxgCmdList_init(&list,&memory[0],1000);
+      for (uint i = 0; i < 10; i++){
+        recordDraw(&list,i);
+      }
+      memset(&stats,0,sizeof(stats));
+      ok &= list.overflow && list.numDraws < 10;
+      lxgCmdList_validate(&list,&stats);
+      ok &= stats.bytes <= 1000;
+    }
+
+    // detected errors
+    {
+      lxgCmdList_t list;
+      lxgCmdStats_t stats;
+      lxgDrawCall_t draw = {LUXGL_TRIANGLES,LUX_SCALAR_ILLEGAL,3,0,0,1};
+      lxgTexturePTR texs[2] = {NULL,NULL};
+      lxgCmdList_init(&list,&memory[0],4096);
+      // no program and decl
+      lxgCmdList_draw(&list,&draw);
+      // out of range units
+      lxgCmdList_textures(&list,texs,LUXGFX_MAX_TEXTURE_IMAGES - 1,2);
+      lxgCmdList_program(&list,object<lxgProgramCPTR>(0,0));
+      lxgCmdList_vertexDecl(&list,object<lxgVertexDeclCPTR>(5,0));
+      lxgCmdList_draw(&list,&draw);
+      // indexed without index buffer
+      draw.indexType = LUX_SCALAR_UINT32;
+      lxgCmdList_draw(&list,&draw);
+      memset(&stats,0,sizeof(stats));
+      ok &= lxgCmdList_validate(&list,&stats) == LUX_FALSE && stats.numErrors == 3;
+    }
+
+    // binds ending at the last unit are in range
+    {
+      lxgCmdList_t list;
+      lxgCmdStats_t stats;
+      lxgTexturePTR texs[2] = {NULL,NULL};
+      lxgCmdList_init(&list,&memory[0],4096);
+      lxgCmdList_textures(&list,texs,LUXGFX_MAX_TEXTURE_IMAGES - 2,2);
+      memset(&stats,0,sizeof(stats));
+      ok &= lxgCmdList_validate(&list,&stats) == LUX_TRUE && stats.numErrors == 0;
+    }
+
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static CmdListTest testCmdList;
+
+//////////////////////////////////////////////////////////////////////////
+
+class CmdOptTest : public Project
+{
+private:
+  enum {
+    NUM_DRAWS = 100000,
+    NUM_PROGRAMS = 16,
+    NUM_MATERIALS = 64,
+    NUM_RUNS = 8,
+  };
+
+  std::vector<double>   m_objects;
+
+  // state as seen by draws
+  struct SimState {
+    const void*       objs[LUXGFX_CMDS];
+    const void*       textures[LUXGFX_MAX_TEXTURE_IMAGES];
+    const void*       samplers[LUXGFX_MAX_TEXTURE_IMAGES];
+    const void*       images[LUXGFX_MAX_RWTEXTURE_IMAGES];
+    const void*       rendertargets[LUXGFX_RENDERTARGETS];
+    lxgStreamHost_t   streams[LUXGFX_MAX_VERTEX_STREAMS];
+    flags32           attribs;
+  };
+
+public:
+  CmdOptTest()
+    : Project("cmdopt","../../backend/test/")
+    , m_objects(16 * 256)
+  {
+
+  }
+
+  template<class T>
+  T object(int type, int idx){
+    return (T)&m_objects[(type * 256 + idx) % m_objects.size()];
+  }
+
+  static uint32 hashState(const SimState& state){
+    const byte* bytes = (const byte*)&state;
+    uint32 hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(SimState); i++){
+      hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+  }
+
+  // null dispatch that tracks the state of every draw
+  static void simulate(const lxgCmdList_t* list, std::vector<uint32>& hashes){
+    SimState state;
+    memset(&state,0,sizeof(state));
+    for (const lxgCmd_t* cmd = lxgCmdList_first(list); !lxgCmdList_isEnd(list,cmd); cmd = lxgCmdList_next(cmd)){
+      const lxgCmdBinds_t* binds = (const lxgCmdBinds_t*)cmd;
+      uint start = cmd->arg & 0xFFFF;
+      uint num = cmd->arg >> 16;
+      switch(cmd->type){
+      case LUXGFX_CMD_TEXTURES:
+        memcpy(&state.textures[start],binds->objs,sizeof(void*) * num);
+        break;
+      case LUXGFX_CMD_SAMPLERS:
+        memcpy(&state.samplers[start],binds->objs,sizeof(void*) * num);
+        break;
+      case LUXGFX_CMD_TEXTUREIMAGES:
+        memcpy(&state.images[start],binds->objs,sizeof(void*) * num);
+        break;
+      case LUXGFX_CMD_VERTEXSTREAM:
+        state.streams[cmd->arg] = ((const lxgCmdStream_t*)cmd)->host;
+        break;
+      case LUXGFX_CMD_VERTEXATTRIBS:
+        state.attribs = cmd->arg;
+        break;
+      case LUXGFX_CMD_RENDERTARGET:
+        state.rendertargets[cmd->arg] = ((const lxgCmdObject_t*)cmd)->obj;
+        break;
+      case LUXGFX_CMD_PROGRAMPARAMS:
+        break;
+      case LUXGFX_CMD_DRAW:
+        hashes.push_back(hashState(state) ^ ((const lxgCmdDraw_t*)cmd)->draw.count);
+        break;
+      default:
+        state.objs[cmd->type] = ((const lxgCmdObject_t*)cmd)->obj;
+        break;
+      }
+    }
+    hashes.push_back(hashState(state));
+  }
+
+  // items sorted by program and material, recorded naively:
+  // defaults are reset per item, textures bound one unit at a time
+  void recordScene(lxgCmdList_t* list){
+    static const void* paramData[2];
+    lxgCmdList_reset(list);
+    lxgCmdList_renderTarget(list,object<lxgRenderTargetPTR>(10,0),LUXGFX_RENDERTARGET_DRAW);
+    for (uint i = 0; i < NUM_DRAWS; i++){
+      uint prog = i * NUM_PROGRAMS / NUM_DRAWS;
+      uint mtl = i * NUM_MATERIALS / NUM_DRAWS;
+      uint geom = (i * 13) % 64;
+      lxgProgramParameterPTR params[2] = {object<lxgProgramParameterPTR>(3,prog * 2),object<lxgProgramParameterPTR>(3,prog * 2 + 1)};
+      lxgSamplerCPTR samp = object<lxgSamplerCPTR>(2,0);
+      lxgStreamHost_t host;
+      lxgDrawCall_t draw = {LUXGL_TRIANGLES,LUX_SCALAR_UINT16,36 + geom * 3,0,0,1};
+
+      host.buffer = object<lxgBufferPTR>(4,geom);
+      host.offset = 0;
+      host.len = 1024;
+
+      lxgCmdList_blend(list,object<lxgBlendCPTR>(7,0));
+      lxgCmdList_depth(list,object<lxgDepthCPTR>(8,0));
+      lxgCmdList_rasterizer(list,object<lxgRasterizerCPTR>(9,0));
+      lxgCmdList_program(list,object<lxgProgramCPTR>(0,prog));
+      lxgCmdList_programParameters(list,object<lxgProgramCPTR>(0,prog),2,params,paramData);
+      for (uint u = 0; u < 3; u++){
+        lxgTexturePTR tex = object<lxgTexturePTR>(1,mtl * 3 + u);
+        lxgCmdList_samplers(list,&samp,u,1);
+        lxgCmdList_textures(list,&tex,u,1);
+      }
+      // translucent materials overwrite the default blend
+      if (mtl % 8 == 7){
+        lxgCmdList_blend(list,object<lxgBlendCPTR>(7,1));
+      }
+      lxgCmdList_vertexDecl(list,object<lxgVertexDeclCPTR>(5,geom % 4));
+      lxgCmdList_vertexAttribs(list,0x7);
+      lxgCmdList_vertexStream(list,0,&host);
+      lxgCmdList_indexBuffer(list,object<lxgBufferCPTR>(6,geom));
+      lxgCmdList_draw(list,&draw);
+    }
+  }
+
+  int onInit(int argc, const char** argv) {
+    bool ok = true;
+    std::vector<double> memory(NUM_DRAWS * 512 / sizeof(double));
+    std::vector<double> memoryOpt(NUM_DRAWS * 512 / sizeof(double));
+    lxgCmdList_t list;
+    lxgCmdList_t listOpt;
+
+    lxgCmdList_init(&list,&memory[0],memory.size() * sizeof(double));
+    lxgCmdList_init(&listOpt,&memoryOpt[0],memoryOpt.size() * sizeof(double));
+    recordScene(&list);
+    ok &= !list.overflow;
+
+    lxgCmdOptStats_t opt;
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxgCmdList_reset(&listOpt);
+      memset(&opt,0,sizeof(opt));
+      ok &= lxgCmdList_optimize(&listOpt,&list,&opt) == LUX_TRUE;
+    }
+    double timeOpt = (glfwGetTime() - begin) / double(NUM_RUNS);
+
+    lxgCmdStats_t stats;
+    lxgCmdStats_t statsOpt;
+    memset(&stats,0,sizeof(stats));
+    memset(&statsOpt,0,sizeof(statsOpt));
+    begin = glfwGetTime();
+    ok &= lxgCmdList_validate(&list,&stats) == LUX_TRUE;
+    double timeReplay = glfwGetTime() - begin;
+    begin = glfwGetTime();
+    ok &= lxgCmdList_validate(&listOpt,&statsOpt) == LUX_TRUE;
+    double timeReplayOpt = glfwGetTime() - begin;
+    ok &= statsOpt.numDraws == NUM_DRAWS && listOpt.numDraws == NUM_DRAWS;
+    ok &= statsOpt.numElements == stats.numElements;
+    ok &= opt.numOut == listOpt.numCmds && opt.bytesOut <= opt.bytesIn;
+
+    // every draw sees the same state
+    std::vector<uint32> hashes;
+    std::vector<uint32> hashesOpt;
+    simulate(&list,hashes);
+    simulate(&listOpt,hashesOpt);
+    ok &= hashes == hashesOpt;
+
+    static const char* names[LUXGFX_CMDS] = {
+      "program","params","textures","samplers","images","vertexdecl","stream","attribs",
+      "indexbuffer","blend","depth","logic","stencil","color","rasterizer","rendertarget","draw",
+    };
+    printf("cmdopt: %d draws\n",NUM_DRAWS);
+    for (int t = 0; t < LUXGFX_CMDS; t++){
+      if (opt.countsIn[t]){
+        printf("  %-12s %7d -> %7d\n",names[t],opt.countsIn[t],opt.countsOut[t]);
+      }
+    }
+    printf("  commands %d -> %d, %d eliminated (%.1f%%), bytes %.1f -> %.1f MB\n",opt.numIn,opt.numOut,
+      opt.numIn - opt.numOut,100.0 * double(opt.numIn - opt.numOut) / double(opt.numIn),
+      double(opt.bytesIn) / (1024.0 * 1024.0),double(opt.bytesOut) / (1024.0 * 1024.0));
+    printf("  optimize %.3f ms, null replay %.3f -> %.3f ms\n",timeOpt * 1000.0,timeReplay * 1000.0,timeReplayOpt * 1000.0);
+
+    // ranged binds across units, unknown units stay untouched
+    {
+      lxgCmdList_t small;
+      lxgCmdList_t smallOpt;
+      lxgCmdOptStats_t smallStats;
+      lxgTexturePTR texs[2] = {object<lxgTexturePTR>(1,0),object<lxgTexturePTR>(1,1)};
+      lxgDrawCall_t draw = {LUXGL_TRIANGLES,LUX_SCALAR_ILLEGAL,3,0,0,1};
+      lxgCmdList_init(&small,&memory[0],4096);
+      lxgCmdList_init(&smallOpt,&memoryOpt[0],4096);
+      lxgCmdList_textures(&small,&texs[0],0,1);
+      lxgCmdList_textures(&small,&texs[1],1,1);
+      lxgCmdList_textures(&small,&texs[0],4,1);
+      lxgCmdList_draw(&small,&draw);
+      // same binds again and a state without draw
+      lxgCmdList_textures(&small,&texs[0],0,2);
+      lxgCmdList_draw(&small,&draw);
+      lxgCmdList_depth(&small,object<lxgDepthCPTR>(8,1));
+      memset(&smallStats,0,sizeof(smallStats));
+      lxgCmdList_optimize(&smallOpt,&small,&smallStats);
+      const lxgCmd_t* cmd = lxgCmdList_first(&smallOpt);
+      ok &= cmd->type == LUXGFX_CMD_TEXTURES && cmd->arg == (0 | (2 << 16));
+      cmd = lxgCmdList_next(cmd);
+      ok &= cmd->type == LUXGFX_CMD_TEXTURES && cmd->arg == (4 | (1 << 16));
+      ok &= smallStats.countsOut[LUXGFX_CMD_TEXTURES] == 2 && smallStats.countsOut[LUXGFX_CMD_DEPTH] == 1;
+      ok &= smallStats.countsOut[LUXGFX_CMD_DRAW] == 2 && smallStats.numOut == 5;
+    }
+
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+    return 1;
+  }
+
+};
+
+static CmdOptTest testCmdOpt;
+
+//////////////////////////////////////////////////////////////////////////
+
+class BufferRingTest : public Project
+{
+private:
+  enum {
+    ALIGN = 256,
+  };
+
+  struct Alloc {
+    uint32  frame;
+    uint32  offset;
+    uint32  size;
+    byte    pattern;
+  };
+
+public:
+  BufferRingTest()
+    : Project("bufferring","../../backend/test/")
+  {
+
+  }
+
+  // the "gpu" reads frames once they completed, data must be intact
+  static bool consume(const lxgBufferRing_t* ring, const byte* memory, std::vector<Alloc>& live){
+    bool ok = true;
+    size_t keep = 0;
+    for (size_t i = 0; i < live.size(); i++){
+      const Alloc& alloc = live[i];
+      if (alloc.frame <= ring->completedID){
+        for (uint32 b = 0; b < alloc.size; b++){
+          ok &= memory[alloc.offset + b] == alloc.pattern;
+        }
+      }
+      else{
+        live[keep++] = alloc;
+      }
+    }
+    live.resize(keep);
+    return ok;
+  }
+
+  void runFrames(const char* name, uint32 size, uint latency, uint minSize, uint maxSize, uint perFrame, uint frames,
+    bool expectStalls, bool& ok)
+  {
+    std::vector<byte> memory(size);
+    std::vector<Alloc> live;
+    lxgBufferRing_t ring;
+    uint errors = 0;
+
+    lxgBufferRing_initCPU(&ring,&memory[0],size,ALIGN);
+    for (uint f = 0; f < frames; f++){
+      for (uint a = 0; a < perFrame; a++){
+        uint32 need = minSize + rand() % (maxSize - minSize + 1);
+        uint offset;
+        byte* ptr = (byte*)lxgBufferRing_alloc(&ring,need,&offset);
+        if (!ptr){
+          errors++;
+          continue;
+        }
+        // stalls complete frames inside alloc
+        ok &= consume(&ring,&memory[0],live);
+
+        errors += offset % ALIGN != 0 || offset + need > size || ptr != &memory[offset];
+        for (size_t i = 0; i < live.size(); i++){
+          errors += offset < live[i].offset + live[i].size && live[i].offset < offset + need;
+        }
+
+        Alloc alloc = {ring.frameID,offset,need,(byte)(rand() | 1)};
+        memset(ptr,alloc.pattern,need);
+        live.push_back(alloc);
+
+        // draw batches within the frame, alloc maps again after flush
+        if (a % 16 == 15){
+          lxgBufferRing_flush(&ring);
+        }
+      }
+      lxgBufferRing_flush(&ring);
+      uint32 id = lxgBufferRing_endFrame(&ring);
+      if (id > latency){
+        lxgBufferRing_signalCPU(&ring,id - latency);
+        ok &= consume(&ring,&memory[0],live);
+      }
+    }
+    // deinit waits for the rest
+    lxgBufferRingStats_t stats = ring.stats;
+    lxgBufferRing_deinit(&ring);
+    ok &= consume(&ring,&memory[0],live) && live.empty();
+    ok &= errors == 0 && stats.numFailed == 0;
+    ok &= stats.numWraps > 0;
+    ok &= expectStalls ? stats.numStalls > 0 : stats.numStalls == 0;
+
+    printf("  %-8s %4d KB, latency %d: streamed %.1f MB, padding %.1f%%, %d wraps, %d maps, %d stalls, %d stalls avoided\n",
+      name,size / 1024,latency,double(stats.bytesStreamed) / (1024.0 * 1024.0),
+      100.0 * double(stats.bytesPadding) / double(stats.bytesStreamed + stats.bytesPadding),
+      stats.numWraps,stats.numMaps,stats.numStalls,stats.stallsAvoided);
+  }
+
+  void testWrap(bool& ok){
+    byte memory[4096];
+    lxgBufferRing_t ring;
+    uint offset;
+
+    lxgBufferRing_initCPU(&ring,memory,sizeof(memory),ALIGN);
+    ok &= lxgBufferRing_alloc(&ring,3000,&offset) == memory && offset == 0;
+    lxgBufferRing_flush(&ring);
+    ok &= ring.mapped == NULL;
+    ok &= lxgBufferRing_endFrame(&ring) == 1;
+    ok &= lxgBufferRing_alloc(&ring,1000,&offset) != NULL && offset == 3072;
+    lxgBufferRing_flush(&ring);
+    ok &= lxgBufferRing_endFrame(&ring) == 2;
+    lxgBufferRing_signalCPU(&ring,1);
+
+    // wraps into the space of frame 1
+    ok &= lxgBufferRing_alloc(&ring,2000,&offset) != NULL && offset == 0;
+    ok &= ring.stats.numWraps == 1 && ring.stats.numStalls == 0;
+    // frame 2 is still in flight, must wait
+    ok &= lxgBufferRing_alloc(&ring,1500,&offset) != NULL && offset == 2048;
+    ok &= ring.stats.numStalls == 1 && ring.completedID == 2 && ring.numPending == 0;
+    // larger than ring, larger than what the current frame leaves
+    ok &= lxgBufferRing_alloc(&ring,5000,&offset) == NULL;
+    ok &= lxgBufferRing_alloc(&ring,4000,&offset) == NULL;
+    ok &= ring.stats.numFailed == 2;
+    ok &= ring.stats.bytesStreamed == 3000 + 1000 + 2000 + 1500;
+    ok &= ring.stats.bytesPadding == 72 + 24 + 48;
+    lxgBufferRing_flush(&ring);
+    lxgBufferRing_endFrame(&ring);
+    lxgBufferRing_deinit(&ring);
+    ok &= ring.used == 0;
+  }
+
+  int onInit(int argc, const char** argv) {
+    bool ok = true;
+
+    srand(31);
+    printf("bufferring:\n");
+    testWrap(ok);
+    // instances and uniforms, gpu two frames behind
+    runFrames("fits",1024 * 1024,2,64,4096,64,2000,false,ok);
+    // ring holds less than the frames in flight
+    runFrames("small",256 * 1024,4,64,4096,64,2000,true,ok);
+
+    // throughput of small allocations
+    {
+      const uint numAllocs = 1000000;
+      const uint perFrame = 1000;
+      std::vector<double> memory(1024 * 1024 / sizeof(double));
+      lxgBufferRing_t ring;
+      uint offset;
+
+      lxgBufferRing_initCPU(&ring,&memory[0],1024 * 1024,16);
+      double begin = glfwGetTime();
+      for (uint i = 0; i < numAllocs; i++){
+        ok &= lxgBufferRing_alloc(&ring,64,&offset) != NULL;
+        if (i % perFrame == perFrame - 1){
+          lxgBufferRing_flush(&ring);
+          uint32 id = lxgBufferRing_endFrame(&ring);
+          lxgBufferRing_signalCPU(&ring,id > 2 ? id - 2 : 0);
+        }
+      }
+      double time = glfwGetTime() - begin;
+      printf("  alloc %.1f ns, %d frames, %d stalls\n",time * 1e9 / double(numAllocs),ring.stats.numFrames,ring.stats.numStalls);
+      ok &= ring.stats.numStalls == 0;
+      lxgBufferRing_deinit(&ring);
+    }
+
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+    return 1;
+  }
+
+};
+
+static BufferRingTest testBufferRing;
@@ -0,0 +1,252 @@
+// Copyright (C) 2010-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include "../_project/project.hpp"
+
+// console benchmarks, run and quit after onInit
+
+//////////////////////////////////////////////////////////////////////////
+
+class AlignedFloats {
+public:
+  AlignedFloats(size_t count) : m_storage(count + 4) {
+    m_ptr = (float*)(((size_t)&m_storage[0] + 15) & ~(size_t)15);
+  }
+  inline float* get() { return m_ptr; }
+private:
+  std::vector<float>  m_storage;
+  float*              m_ptr;
+};
+
+class QuatSoATest : public Project
+{
+private:
+  enum {
+    NUM_QUATS = 4096,
+    NUM_RUNS = 1000,
+  };
+
+  AlignedFloats m_data;
+  lxQuatSoA_t   m_a;
+  lxQuatSoA_t   m_b;
+  lxQuatSoA_t   m_out;
+  std::vector<float>      m_t;
+  std::vector<lxCMatrix44> m_matrices;
+
+public:
+  QuatSoATest()
+    : Project("quatsoa","../../backend/test/")
+    , m_data(NUM_QUATS * 12)
+    , m_t(NUM_QUATS)
+    , m_matrices(NUM_QUATS)
+  {
+    lxQuatSoA_t* soas[3] = {&m_a,&m_b,&m_out};
+    float* data = m_data.get();
+    for (int i = 0; i < 3; i++){
+      soas[i]->x = data + NUM_QUATS * (i*4+0);
+      soas[i]->y = data + NUM_QUATS * (i*4+1);
+      soas[i]->z = data + NUM_QUATS * (i*4+2);
+      soas[i]->w = data + NUM_QUATS * (i*4+3);
+    }
+  }
+
+  void randomQuat(lxQuatSoA_t* soa, int i){
+    lxQuat q;
+    lxQuatSet(q,randomFloat(-1,1),randomFloat(-1,1),randomFloat(-1,1),randomFloat(-1,1));
+    lxQuatNormalized(q);
+    soa->x[i] = q[0];
+    soa->y[i] = q[1];
+    soa->z[i] = q[2];
+    soa->w[i] = q[3];
+  }
+
+  void getQuat(lxQuat q, const lxQuatSoA_t* soa, int i){
+    lxQuatSet(q,soa->x[i],soa->y[i],soa->z[i],soa->w[i]);
+  }
+
+  double errorSlerp(){
+    double maxerr = 0;
+    for (int i = 0; i < NUM_QUATS; i++){
+      lxQuat a,b,ref,res;
+      getQuat(a,&m_a,i);
+      getQuat(b,&m_b,i);
+      getQuat(res,&m_out,i);
+      lxQuatSlerp(ref,m_t[i],a,b);
+      for (int c = 0; c < 4; c++){
+        maxerr = LUX_MAX(maxerr,fabs(ref[c]-res[c]));
+      }
+    }
+    return maxerr;
+  }
+
+  static void maxError(double& maxerr, const float* ref, const float* res, int num){
+    for (int c = 0; c < num; c++){
+      maxerr = LUX_MAX(maxerr,fabs(ref[c]-res[c]));
+    }
+  }
+
+    // max component error of the batch functions against the scalar
+    // lxQuat functions, outputs past count must stay untouched
+  double compareOps(int count, bool& untouched){
+    const float marker = 1234.0f;
+    int tail = LUX_MIN(count + 8,(int)NUM_QUATS);
+    double maxerr = 0;
+    int i;
+
+    for (i = count; i < tail; i++){
+      m_out.x[i] = m_out.y[i] = m_out.z[i] = m_out.w[i] = marker;
+      m_matrices[i][0] = m_matrices[i][3] = m_matrices[i][11] = marker;
+    }
+
+    lxQuatSoA_mul(&m_out,&m_a,&m_b,count);
+    for (i = 0; i < count; i++){
+      lxQuat a,b,ref,res;
+      getQuat(a,&m_a,i);
+      getQuat(b,&m_b,i);
+      getQuat(res,&m_out,i);
+      lxQuatMul(ref,a,b);
+      maxError(maxerr,ref,res,4);
+    }
+
+    for (i = 0; i < count; i++){
+      m_out.x[i] = m_a.x[i] * 3.0f;
+      m_out.y[i] = m_a.y[i] * 3.0f;
+      m_out.z[i] = m_a.z[i] * 3.0f;
+      m_out.w[i] = m_a.w[i] * 3.0f;
+    }
+    lxQuatSoA_normalize(&m_out,&m_out,count);
+    for (i = 0; i < count; i++){
+      lxQuat ref,res;
+      lxQuatSet(ref,m_a.x[i] * 3.0f,m_a.y[i] * 3.0f,m_a.z[i] * 3.0f,m_a.w[i] * 3.0f);
+      lxQuatNormalized(ref);
+      getQuat(res,&m_out,i);
+      maxError(maxerr,ref,res,4);
+    }
+
+    lxQuatSoA_nlerp(&m_out,&m_t[0],&m_a,&m_b,count);
+    for (i = 0; i < count; i++){
+      lxQuat a,b,ref,res;
+      float t;
+      getQuat(a,&m_a,i);
+      getQuat(b,&m_b,i);
+      getQuat(res,&m_out,i);
+      t = lxQuatDot(a,b) < 0.0f ? -m_t[i] : m_t[i];
+      lxQuatSet(ref,
+        a[0]*(1.0f-m_t[i]) + b[0]*t,
+        a[1]*(1.0f-m_t[i]) + b[1]*t,
+        a[2]*(1.0f-m_t[i]) + b[2]*t,
+        a[3]*(1.0f-m_t[i]) + b[3]*t);
+      lxQuatNormalized(ref);
+      maxError(maxerr,ref,res,4);
+    }
+
+    lxQuatSoA_toMatrix(&m_a,(lxMatrix44*)&m_matrices[0],count);
+    for (i = 0; i < count; i++){
+      lxQuat a;
+      lxMatrix44 ref;
+      getQuat(a,&m_a,i);
+      lxQuatToMatrix(a,ref);
+      ref[3] = ref[7] = ref[11] = 0.0f;
+      maxError(maxerr,ref,m_matrices[i],12);
+    }
+
+    untouched = true;
+    for (i = count; i < tail; i++){
+      untouched = untouched && 
+        m_out.x[i] == marker && m_out.y[i] == marker && 
+        m_out.z[i] == marker && m_out.w[i] == marker &&
+        m_matrices[i][0] == marker && m_matrices[i][3] == marker && m_matrices[i][11] == marker;
+    }
+
+    return maxerr;
+  }
+
+  int onInit(int argc, const char** argv) {
+    for (int i = 0; i < NUM_QUATS; i++){
+      randomQuat(&m_a,i);
+      randomQuat(&m_b,i);
+      m_t[i] = randomFloat();
+    }
+
+    {
+      // covers the 8-wide, 4-wide and scalar parts
+      int counts[] = {NUM_QUATS,1,3,4,7,8,13,31};
+      double maxerr = 0;
+      bool ok = true;
+      for (int c = 0; c < int(sizeof(counts)/sizeof(counts[0])); c++){
+        bool untouched;
+        maxerr = LUX_MAX(maxerr,compareOps(counts[c],untouched));
+        ok = ok && untouched;
+      }
+      ok = ok && maxerr <= 1.0e-6;
+      printf("quatsoa: mul/normalize/nlerp/toMatrix max error %g\n",maxerr);
+      printf("  compare %s\n",ok ? "ok" : "FAILED");
+    }
+
+    lxQuatSoA_slerpFast(&m_out,&m_t[0],&m_a,&m_b,NUM_QUATS);
+    printf("quatsoa: slerpFast max error %g\n",errorSlerp());
+
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxQuatSoA_slerpFast(&m_out,&m_t[0],&m_a,&m_b,NUM_QUATS);
+    }
+    double slerpSoA = glfwGetTime() - begin;
+
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      for (int i = 0; i < NUM_QUATS; i++){
+        lxQuat a,b,res;
+        getQuat(a,&m_a,i);
+        getQuat(b,&m_b,i);
+        lxQuatSlerp(res,m_t[i],a,b);
+        m_out.x[i] = res[0];
+        m_out.y[i] = res[1];
+        m_out.z[i] = res[2];
+        m_out.w[i] = res[3];
+      }
+    }
+    double slerpScalar = glfwGetTime() - begin;
+
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxQuatSoA_nlerp(&m_out,&m_t[0],&m_a,&m_b,NUM_QUATS);
+    }
+    double nlerpSoA = glfwGetTime() - begin;
+
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxQuatSoA_mul(&m_out,&m_a,&m_b,NUM_QUATS);
+    }
+    double mulSoA = glfwGetTime() - begin;
+
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxQuatSoA_toMatrix(&m_a,(lxMatrix44*)&m_matrices[0],NUM_QUATS);
+    }
+    double matrixSoA = glfwGetTime() - begin;
+
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      for (int i = 0; i < NUM_QUATS; i++){
+        lxQuat a;
+        getQuat(a,&m_a,i);
+        lxQuatToMatrix(a,m_matrices[i]);
+      }
+    }
+    double matrixScalar = glfwGetTime() - begin;
+
+    double scale = 1.0e9 / double(NUM_QUATS * NUM_RUNS);
+    printf("quatsoa: ns per quaternion\n");
+    printf("  slerp    scalar %6.2f  soa %6.2f\n", slerpScalar * scale, slerpSoA * scale);
+    printf("  nlerp               soa %6.2f\n", nlerpSoA * scale);
+    printf("  mul                 soa %6.2f\n", mulSoA * scale);
+    printf("  toMatrix scalar %6.2f  soa %6.2f\n", matrixScalar * scale, matrixSoA * scale);
+
+    return 1;
+  }
+
+};
+
+static QuatSoATest testQuatSoA;
+
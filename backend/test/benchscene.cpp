@@ -0,0 +1,3113 @@
+// Copyright (C) 2010-2011 Christoph Kubisch
+// This file is part of the "Luxinia Engine".
+// See copyright notice in luxplatform.h
+
+#include "../_project/project.hpp"
+#include <luxinia/luxscene/meshvcacheopt.h>
+#include <luxinia/luxscene/drawsystem.h>
+#include <luxinia/luxscene/meshlet.h>
+#include <luxinia/luxscene/meshgen.h>
+#include <luxinia/luxscene/meshquantize.h>
+#include <luxinia/luxscene/meshcodec.h>
+#include <luxinia/luxscene/meshfile.h>
+#include <luxinia/luxscene/bvh.h>
+#include <luxinia/luxscene/shader.h>
+#include <luxinia/luxgfx/luxgfx.h>
+#include <luxinia/luxmath/float16.h>
+#include <luxinia/luxcore/jobpool.h>
+#include <luxinia/luxcore/memorygeneric.h>
+#include <luxinia/luxplatform/cpu.h>
+#include <algorithm>
+
+// console benchmarks, run and quit after onInit
+
+// forwards to base while allowed is not 0, each allocation
+// decrements it, negative never fails
+struct FailAllocator {
+  lxMemoryAllocator_t   allocator;
+  lxMemoryTracker_t     tracker;
+  lxMemoryAllocatorPTR  base;
+  int                   allowed;
+};
+
+static void* __cdecl failMalloc(lxMemoryAllocatorPTR a, size_t sz){
+  FailAllocator* f = (FailAllocator*)a;
+  if (!f->allowed)
+    return NULL;
+  if (f->allowed > 0)
+    f->allowed--;
+  return f->base->_malloc(f->base,sz);
+}
+static void* __cdecl failMallocAligned(lxMemoryAllocatorPTR a, size_t sz, size_t align){
+  FailAllocator* f = (FailAllocator*)a;
+  if (!f->allowed)
+    return NULL;
+  if (f->allowed > 0)
+    f->allowed--;
+  return f->base->_mallocAligned(f->base,sz,align);
+}
+static void __cdecl failFree(lxMemoryAllocatorPTR a, void* ptr, size_t oldsz){
+  FailAllocator* f = (FailAllocator*)a;
+  f->base->_free(f->base,ptr,oldsz);
+}
+static void __cdecl failFreeAligned(lxMemoryAllocatorPTR a, void* ptr, size_t oldsz){
+  FailAllocator* f = (FailAllocator*)a;
+  f->base->_freeAligned(f->base,ptr,oldsz);
+}
+static void* __cdecl failMallocStats(lxMemoryAllocatorPTR a, size_t sz, const char* file, int line){
+  return failMalloc(a,sz);
+}
+static void* __cdecl failMallocAlignedStats(lxMemoryAllocatorPTR a, size_t sz, size_t align, const char* file, int line){
+  return failMallocAligned(a,sz,align);
+}
+static void __cdecl failFreeStats(lxMemoryAllocatorPTR a, void* ptr, size_t oldsz, const char* file, int line){
+  failFree(a,ptr,oldsz);
+}
+static void __cdecl failFreeAlignedStats(lxMemoryAllocatorPTR a, void* ptr, size_t oldsz, const char* file, int line){
+  failFreeAligned(a,ptr,oldsz);
+}
+
+static void initFailAllocator(FailAllocator& f, lxMemoryAllocatorPTR base){
+  memset(&f,0,sizeof(f));
+  f.allocator._malloc = failMalloc;
+  f.allocator._mallocAligned = failMallocAligned;
+  f.allocator._free = failFree;
+  f.allocator._freeAligned = failFreeAligned;
+  f.allocator.tracker = &f.tracker;
+  f.tracker._malloc = failMallocStats;
+  f.tracker._mallocAligned = failMallocAlignedStats;
+  f.tracker._free = failFreeStats;
+  f.tracker._freeAligned = failFreeAlignedStats;
+  f.base = base;
+  f.allowed = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+class VertexCacheTest : public Project
+{
+private:
+  enum {
+    GRID_WIDTH = 120,
+    GRID_HEIGHT = 90,
+    NUM_VERTICES = (GRID_WIDTH+1) * (GRID_HEIGHT+1),
+    NUM_TRIANGLES = GRID_WIDTH * GRID_HEIGHT * 2,
+    NUM_MESHES = 64,
+    VCACHE = 24,
+  };
+
+  struct Job {
+    VertexCacheTest*    test;
+    lxVertexCacheOpt_t* contexts;
+    booln               forsyth;
+  };
+
+  std::vector<uint32>   m_source;
+  std::vector<uint32>   m_meshes;
+
+public:
+  VertexCacheTest()
+    : Project("vcacheopt","../../backend/test/")
+    , m_source(NUM_TRIANGLES * 3)
+    , m_meshes(NUM_TRIANGLES * 3 * NUM_MESHES)
+  {
+
+  }
+
+    // regular grid with shuffled triangle order
+  void buildGrid(){
+    uint32* indices = &m_source[0];
+    for (int y = 0; y < GRID_HEIGHT; y++){
+      for (int x = 0; x < GRID_WIDTH; x++){
+        uint32 v = y * (GRID_WIDTH+1) + x;
+        uint32* quad = indices + (y * GRID_WIDTH + x) * 6;
+        quad[0] = v;
+        quad[1] = v + 1;
+        quad[2] = v + GRID_WIDTH + 1;
+        quad[3] = v + 1;
+        quad[4] = v + GRID_WIDTH + 2;
+        quad[5] = v + GRID_WIDTH + 1;
+      }
+    }
+    for (int i = NUM_TRIANGLES-1; i > 0; i--){
+      int n = rand() % (i+1);
+      for (int c = 0; c < 3; c++){
+        uint32 tmp = indices[i*3+c];
+        indices[i*3+c] = indices[n*3+c];
+        indices[n*3+c] = tmp;
+      }
+    }
+  }
+
+  void resetMeshes(){
+    for (int m = 0; m < NUM_MESHES; m++){
+      memcpy(&m_meshes[m * NUM_TRIANGLES * 3],&m_source[0],sizeof(uint32) * NUM_TRIANGLES * 3);
+    }
+  }
+
+  static void optimizeJob(void* userdata, uint jobindex, uint threadindex){
+    Job* job = (Job*)userdata;
+    lxVertexCacheOpt_t* ctx = &job->contexts[threadindex];
+    uint32* indices = &job->test->m_meshes[jobindex * NUM_TRIANGLES * 3];
+
+    if (job->forsyth){
+      lxVertexCacheOpt_forsyth(ctx,indices,NUM_TRIANGLES,NUM_VERTICES,VCACHE,LUX_MESH_INDEX_UINT32);
+    }
+    else{
+      lxVertexCacheOpt_tipsify(ctx,indices,NUM_TRIANGLES,NUM_VERTICES,VCACHE,LUX_MESH_INDEX_UINT32);
+    }
+  }
+
+  double runLegacy(booln forsyth){
+    resetMeshes();
+
+    double begin = glfwGetTime();
+    for (int m = 0; m < NUM_MESHES; m++){
+      uint32* indices = &m_meshes[m * NUM_TRIANGLES * 3];
+      if (forsyth){
+        lxVertexCacheOptimize_forsyth(indices,NUM_TRIANGLES,NUM_VERTICES,VCACHE,LUX_MESH_INDEX_UINT32);
+      }
+      else{
+        lxVertexCacheOptimize_tipsify(indices,NUM_TRIANGLES,NUM_VERTICES,VCACHE,LUX_MESH_INDEX_UINT32);
+      }
+    }
+    return (glfwGetTime() - begin) / double(NUM_MESHES);
+  }
+
+  double runPool(lxJobPoolPTR pool, lxVertexCacheOpt_t* contexts, booln forsyth){
+    Job job = {this,contexts,forsyth};
+    resetMeshes();
+
+    double begin = glfwGetTime();
+    lxJobPool_run(pool,NUM_MESHES,optimizeJob,&job);
+    return (glfwGetTime() - begin) / double(NUM_MESHES);
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    uint maxThreads = lxCPU_getCount();
+    std::vector<lxVertexCacheOpt_t> contexts(maxThreads);
+    lxVertexCacheStats_t stats;
+
+    buildGrid();
+
+    printf("vcacheopt: ms per mesh, %d triangles, vcache %d\n",NUM_TRIANGLES,VCACHE);
+    printf("  %8s %8s %8s\n","","acmr","atvr");
+
+    lxVertexCacheStats_compute(&stats,&m_source[0],NUM_TRIANGLES,NUM_VERTICES,VCACHE,LUX_MESH_INDEX_UINT32);
+    printf("  %8s %8.3f %8.3f\n","source",stats.acmr,stats.atvr);
+
+    for (int f = 0; f < 2; f++){
+      booln forsyth = f;
+      const char* name = forsyth ? "forsyth" : "tipsify";
+      double timeLegacy = runLegacy(forsyth);
+
+      lxVertexCacheStats_compute(&stats,&m_meshes[0],NUM_TRIANGLES,NUM_VERTICES,VCACHE,LUX_MESH_INDEX_UINT32);
+      printf("  %8s %8.3f %8.3f\n",name,stats.acmr,stats.atvr);
+      printf("    legacy %8.3f\n",timeLegacy * 1000.0);
+      printf("    %7s %8s %8s\n","threads","time","speedup");
+
+      for (uint t = 1; t <= maxThreads; t++){
+        lxJobPoolPTR pool = lxJobPool_new(allocator,t);
+        for (uint i = 0; i < t; i++){
+          lxVertexCacheOpt_init(&contexts[i],allocator,NULL,0);
+        }
+
+        double timePool = runPool(pool,&contexts[0],forsyth);
+        printf("    %7d %8.3f %7.2fx\n",t,timePool * 1000.0,timeLegacy/timePool);
+
+        int bad = 0;
+        for (int m = 0; m < NUM_MESHES * NUM_TRIANGLES * 3; m++){
+          bad += m_meshes[m] != m_meshes[m % (NUM_TRIANGLES * 3)];
+        }
+        if (bad){
+          printf("    mismatch %d\n",bad);
+        }
+
+        for (uint i = 0; i < t; i++){
+          lxVertexCacheOpt_deinit(&contexts[i]);
+        }
+        lxJobPool_delete(pool);
+      }
+    }
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static VertexCacheTest testVertexCache;
+
+//////////////////////////////////////////////////////////////////////////
+
+class MeshOptTest : public Project
+{
+private:
+  enum {
+    VCACHE = 16,
+    CLUSTER = 3,
+  };
+
+  struct Mesh {
+    const char*             name;
+    std::vector<float>      posnormal;
+    std::vector<float>      uv;
+    std::vector<uint32>     indices;
+  };
+
+  lxgVertexDecl_t   m_decl;
+
+public:
+  MeshOptTest()
+    : Project("meshopt","../../backend/test/")
+  {
+    memset(&m_decl,0,sizeof(m_decl));
+    m_decl.available =  lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_POS) |
+                        lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_NORMAL) |
+                        lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_TEXCOORD0);
+    m_decl.streams = 2;
+    m_decl.table[LUXGFX_VERTEX_ATTRIB_POS] = lxgVertexElement_set(3,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(float)*6,0,0);
+    m_decl.table[LUXGFX_VERTEX_ATTRIB_NORMAL] = lxgVertexElement_set(3,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(float)*6,sizeof(float)*3,0);
+    m_decl.table[LUXGFX_VERTEX_ATTRIB_TEXCOORD0] = lxgVertexElement_set(2,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(float)*2,0,1);
+  }
+
+  typedef void (GetCounts_fn)(int* segs, int* numVertices, int* numTriangleIndices, int* numOutlineIndices);
+  typedef void (InitTriangles_fn)(int* segs, lxVector3* pos, lxVector3* normal, lxVector2* uv, uint32* indices);
+
+    // generates copies of the mesh on a CLUSTER^3 lattice, overlapping
+    // copies give depth complexity for the overdraw simulation
+  void generate(Mesh& mesh, const char* name, GetCounts_fn* getCounts, InitTriangles_fn* initTriangles, int* segs, float spacing)
+  {
+    int numVertices;
+    int numIndices;
+    int numOutline;
+
+    getCounts(segs,&numVertices,&numIndices,&numOutline);
+
+    std::vector<float>  pos(numVertices * 3);
+    std::vector<float>  normal(numVertices * 3);
+    std::vector<float>  uv(numVertices * 2);
+    std::vector<uint32> indices(numIndices);
+
+    initTriangles(segs,(lxVector3*)&pos[0],(lxVector3*)&normal[0],(lxVector2*)&uv[0],&indices[0]);
+
+    mesh.name = name;
+    for (int k = 0; k < CLUSTER * CLUSTER * CLUSTER; k++){
+      uint32 base = (uint32)mesh.uv.size() / 2;
+      float offset[3] = {
+        spacing * (float)(k % CLUSTER),
+        spacing * (float)((k / CLUSTER) % CLUSTER),
+        spacing * (float)(k / (CLUSTER * CLUSTER))};
+
+      for (int i = 0; i < numVertices; i++){
+        for (int c = 0; c < 3; c++){
+          mesh.posnormal.push_back(pos[i*3+c] + offset[c]);
+        }
+        for (int c = 0; c < 3; c++){
+          mesh.posnormal.push_back(normal[i*3+c]);
+        }
+        mesh.uv.push_back(uv[i*2+0]);
+        mesh.uv.push_back(uv[i*2+1]);
+      }
+      for (int i = 0; i < numIndices; i++){
+        mesh.indices.push_back(indices[i] + base);
+      }
+    }
+  }
+
+    // scrambled triangle and vertex order, as from a naive exporter
+  void shuffle(Mesh& mesh){
+    int numTriangles = (int)mesh.indices.size() / 3;
+    int numVertices = (int)mesh.uv.size() / 2;
+    std::vector<uint32> perm(numVertices);
+    std::vector<float>  posnormal(mesh.posnormal.size());
+    std::vector<float>  uv(mesh.uv.size());
+
+    for (int i = numTriangles-1; i > 0; i--){
+      int n = rand() % (i+1);
+      for (int c = 0; c < 3; c++){
+        uint32 tmp = mesh.indices[i*3+c];
+        mesh.indices[i*3+c] = mesh.indices[n*3+c];
+        mesh.indices[n*3+c] = tmp;
+      }
+    }
+
+    for (int i = 0; i < numVertices; i++){
+      perm[i] = i;
+    }
+    for (int i = numVertices-1; i > 0; i--){
+      int n = rand() % (i+1);
+      uint32 tmp = perm[i];
+      perm[i] = perm[n];
+      perm[n] = tmp;
+    }
+    lxMeshVertices_remap(&posnormal[0],&mesh.posnormal[0],sizeof(float)*6,numVertices,&perm[0]);
+    lxMeshVertices_remap(&uv[0],&mesh.uv[0],sizeof(float)*2,numVertices,&perm[0]);
+    lxMeshIndices_remap(&mesh.indices[0],(int)mesh.indices.size(),&perm[0],LUX_MESH_INDEX_UINT32);
+    mesh.posnormal.swap(posnormal);
+    mesh.uv.swap(uv);
+  }
+
+  void initGeometry(lxDrawGeometry_t& geometry, Mesh& mesh){
+    memset(&geometry,0,sizeof(geometry));
+    geometry.vertexDecl = &m_decl;
+    geometry.indexType = LUX_SCALAR_UINT32;
+    geometry.indexStream.ptr = &mesh.indices[0];
+    geometry.indexStream.len = sizeof(uint32) * mesh.indices.size();
+    geometry.vertexStreams[0].ptr = &mesh.posnormal[0];
+    geometry.vertexStreams[0].len = sizeof(float) * mesh.posnormal.size();
+    geometry.vertexStreams[1].ptr = &mesh.uv[0];
+    geometry.vertexStreams[1].len = sizeof(float) * mesh.uv.size();
+  }
+
+    // lets each allocation fail in turn, the geometry must stay
+    // untouched until optimize succeeds
+  bool checkAllocFailure(Mesh& mesh, lxMemoryAllocatorPTR allocator){
+    FailAllocator fail;
+    lxVertexCacheOpt_t ctx;
+    lxDrawGeometry_t geometry;
+    std::vector<float>  posnormal = mesh.posnormal;
+    std::vector<float>  uv = mesh.uv;
+    std::vector<uint32> indices = mesh.indices;
+    int numFailed = 0;
+    bool ok = true;
+
+    initFailAllocator(fail,allocator);
+    for (int allowed = 0; allowed < 16; allowed++){
+      lxVertexCacheOpt_init(&ctx,&fail.allocator,NULL,0);
+      initGeometry(geometry,mesh);
+      fail.allowed = allowed;
+      booln failed = lxDrawGeometry_optimize(&geometry,&ctx,VCACHE,1.05f);
+      fail.allowed = -1;
+      lxVertexCacheOpt_deinit(&ctx);
+      if (!failed)
+        break;
+
+      ok &= mesh.indices == indices && mesh.posnormal == posnormal && mesh.uv == uv;
+      numFailed++;
+    }
+    // scratch, tipsify and overdraw allocate
+    ok &= numFailed >= 3 && mesh.indices != indices;
+
+    mesh.posnormal = posnormal;
+    mesh.uv = uv;
+    mesh.indices = indices;
+    return ok;
+  }
+
+  void printStats(const char* name, const lxMeshStats_t& stats){
+    printf("  %-14s %7.3f %7.3f %9d %9.3f %9.3f\n",name,
+      stats.vcache.acmr,stats.vcache.atvr,stats.fetchMisses,stats.overfetch,stats.overdraw);
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    lxVertexCacheOpt_t ctx;
+    Mesh meshes[3];
+    bool ok = true;
+
+    int sphereSegs[2] = {32,24};
+    int cylinderSegs[3] = {32,4,8};
+    int boxSegs[3] = {12,12,12};
+
+    generate(meshes[0],"spheres",lxMeshSphere_getCounts,lxMeshSphere_initTriangles,sphereSegs,0.8f);
+    generate(meshes[1],"cylinders",lxMeshCylinder_getCounts,lxMeshCylinder_initTriangles,cylinderSegs,0.8f);
+    generate(meshes[2],"boxes",lxMeshBox_getCounts,lxMeshBox_initTriangles,boxSegs,0.8f);
+
+    lxVertexCacheOpt_init(&ctx,allocator,NULL,0);
+
+    printf("meshopt: vcache %d, fetch cache %d x %d bytes\n",VCACHE,LUX_MESHSTATS_FETCH_LINES,LUX_MESHSTATS_FETCH_LINE);
+    for (int m = 0; m < 3; m++){
+      Mesh& mesh = meshes[m];
+      std::vector<float>      posnormal;
+      std::vector<float>      uv;
+      std::vector<uint32>     indices;
+      lxDrawGeometry_t  geometry;
+      lxMeshStats_t     stats;
+
+      shuffle(mesh);
+      posnormal = mesh.posnormal;
+      uv = mesh.uv;
+      indices = mesh.indices;
+
+      printf(" %s: %d triangles, %d vertices\n",mesh.name,(int)mesh.indices.size()/3,(int)mesh.uv.size()/2);
+      printf("  %-14s %7s %7s %9s %9s %9s\n","","acmr","atvr","fetchmiss","overfetch","overdraw");
+
+      initGeometry(geometry,mesh);
+      lxDrawGeometry_computeStats(&geometry,allocator,VCACHE,&stats);
+      printStats("source",stats);
+
+      double begin = glfwGetTime();
+      lxDrawGeometry_optimize(&geometry,&ctx,VCACHE,0.0f);
+      double timeCache = glfwGetTime() - begin;
+      lxDrawGeometry_computeStats(&geometry,allocator,VCACHE,&stats);
+      printStats("vcache+fetch",stats);
+
+      mesh.posnormal = posnormal;
+      mesh.uv = uv;
+      mesh.indices = indices;
+      initGeometry(geometry,mesh);
+
+      begin = glfwGetTime();
+      lxDrawGeometry_optimize(&geometry,&ctx,VCACHE,1.05f);
+      double timeOverdraw = glfwGetTime() - begin;
+      lxDrawGeometry_computeStats(&geometry,allocator,VCACHE,&stats);
+      printStats("+overdraw",stats);
+
+      printf("  ms %8.3f %8.3f\n",timeCache * 1000.0,timeOverdraw * 1000.0);
+
+      mesh.posnormal = posnormal;
+      mesh.uv = uv;
+      mesh.indices = indices;
+      ok &= checkAllocFailure(mesh,allocator);
+    }
+    printf("  check %s\n",ok ? "ok" : "FAILED");
+
+    lxVertexCacheOpt_deinit(&ctx);
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static MeshOptTest testMeshOpt;
+
+//////////////////////////////////////////////////////////////////////////
+
+class MeshWeldTest : public Project
+{
+private:
+  enum {
+    NUM_RUNS = 10,
+  };
+
+  std::vector<float>  m_soup;
+  std::vector<float>  m_normals;
+  int                 m_numVertices;
+  int                 m_numIndexed;
+
+public:
+  MeshWeldTest()
+    : Project("meshweld","../../backend/test/")
+  {
+
+  }
+
+    // sphere as triangle soup, every corner is its own vertex,
+    // jitter moves every other corner by up to +/- jitter per component
+  void buildSoup(int segx, int segy, float jitter){
+    int segs[2] = {segx,segy};
+    int numVertices;
+    int numIndices;
+    int numOutline;
+    uint32 seed = 1;
+
+    lxMeshSphere_getCounts(segs,&numVertices,&numIndices,&numOutline);
+
+    std::vector<float>  pos(numVertices * 3);
+    std::vector<float>  normal(numVertices * 3);
+    std::vector<float>  uv(numVertices * 2);
+    std::vector<uint32> indices(numIndices);
+
+    lxMeshSphere_initTriangles(segs,(lxVector3*)&pos[0],(lxVector3*)&normal[0],(lxVector2*)&uv[0],&indices[0]);
+
+    m_numIndexed = numVertices;
+    m_numVertices = numIndices;
+    m_soup.resize(numIndices * 3);
+    m_normals.resize(numIndices * 3);
+    for (int i = 0; i < numIndices; i++){
+      for (int c = 0; c < 3; c++){
+        seed = seed * 1664525 + 1013904223;
+        m_soup[i*3+c] = pos[indices[i]*3+c];
+        if (i & 1){
+          m_soup[i*3+c] += jitter * (float(seed >> 8) / float(1 << 23) - 1.0f);
+        }
+        m_normals[i*3+c] = normal[indices[i]*3+c];
+      }
+    }
+  }
+
+  int runOnce(lxMemoryAllocatorPTR allocator, lxJobPoolPTR pool, uint32* remap, float epsilon){
+    lxMeshWeldStream_t streams[2] = {
+      {&m_soup[0],sizeof(float)*3,sizeof(float)*3},
+      {&m_normals[0],sizeof(float)*3,sizeof(float)*3},
+    };
+
+    if (epsilon > 0.0f){
+      return lxMeshWeld_remapEpsilon(remap,allocator,pool,&m_soup[0],sizeof(float)*3,epsilon,streams+1,1,m_numVertices);
+    }
+    else{
+      return lxMeshWeld_remap(remap,allocator,pool,streams,2,m_numVertices);
+    }
+  }
+
+  double runWeld(lxMemoryAllocatorPTR allocator, lxJobPoolPTR pool, uint32* remap, float epsilon, int* numUnique){
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      *numUnique = runOnce(allocator,pool,remap,epsilon);
+    }
+    return (glfwGetTime() - begin) / double(NUM_RUNS);
+  }
+
+    // quadratic reference, every vertex maps to the first earlier
+    // vertex it matches
+  int weldReference(uint32* remap, float epsilon){
+    int next = 0;
+    for (int v = 0; v < m_numVertices; v++){
+      const float* pos = &m_soup[v*3];
+      int best = v;
+      for (int j = 0; j < v; j++){
+        const float* npos = &m_soup[j*3];
+        bool match = epsilon > 0.0f ?
+          fabs(npos[0] - pos[0]) <= epsilon &&
+          fabs(npos[1] - pos[1]) <= epsilon &&
+          fabs(npos[2] - pos[2]) <= epsilon :
+          memcmp(npos,pos,sizeof(float)*3) == 0;
+        if (match && memcmp(&m_normals[j*3],&m_normals[v*3],sizeof(float)*3) == 0){
+          best = j;
+          break;
+        }
+      }
+      remap[v] = best == v ? next++ : remap[best];
+    }
+    return next;
+  }
+
+  bool checkReference(lxMemoryAllocatorPTR allocator, lxJobPoolPTR pool, float epsilon){
+    std::vector<uint32> remap(m_numVertices);
+    std::vector<uint32> ref(m_numVertices);
+
+    int numUnique = runOnce(allocator,pool,&remap[0],epsilon);
+    int numRef = weldReference(&ref[0],epsilon);
+
+    printf("  reference %s: %d of %d unique\n",epsilon > 0.0f ? "epsilon" : "exact",numRef,m_numVertices);
+    return numUnique == numRef && remap == ref;
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    uint maxThreads = lxCPU_getCount();
+    float epsilon = 0.0001f;
+    bool ok = true;
+
+    printf("meshweld: compare against reference\n");
+    {
+      lxJobPoolPTR pool = lxJobPool_new(allocator,LUX_MAX(maxThreads,2));
+
+      // jitter within epsilon, so exact and epsilon welds differ
+      buildSoup(64,32,epsilon * 0.4f);
+      ok = ok && checkReference(allocator,NULL,0.0f);
+      ok = ok && checkReference(allocator,NULL,epsilon);
+      ok = ok && checkReference(allocator,pool,0.0f);
+      ok = ok && checkReference(allocator,pool,epsilon);
+
+      lxJobPool_delete(pool);
+    }
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+
+    buildSoup(512,256,0.0f);
+    std::vector<uint32> remap(m_numVertices);
+    std::vector<uint32> serialExact(m_numVertices);
+    std::vector<uint32> serialEpsilon(m_numVertices);
+
+    int serialUniqueExact = runOnce(allocator,NULL,&serialExact[0],0.0f);
+    int serialUniqueEpsilon = runOnce(allocator,NULL,&serialEpsilon[0],epsilon);
+
+    printf("meshweld: ms per weld, %d vertices, %d in indexed sphere\n",m_numVertices,m_numIndexed);
+    printf("  %7s %10s %8s %10s %8s %8s\n","threads","exact","unique","epsilon","unique","serial");
+
+    for (uint t = 1; t <= maxThreads; t++){
+      lxJobPoolPTR pool = lxJobPool_new(allocator,t);
+      int uniqueExact;
+      int uniqueEpsilon;
+      bool same;
+
+      double timeExact = runWeld(allocator,pool,&remap[0],0.0f,&uniqueExact);
+      same = uniqueExact == serialUniqueExact && remap == serialExact;
+      double timeEpsilon = runWeld(allocator,pool,&remap[0],epsilon,&uniqueEpsilon);
+      same = same && uniqueEpsilon == serialUniqueEpsilon && remap == serialEpsilon;
+
+      printf("  %7d %10.3f %8d %10.3f %8d %8s\n",t,
+        timeExact * 1000.0,uniqueExact,timeEpsilon * 1000.0,uniqueEpsilon,same ? "ok" : "FAILED");
+
+      lxJobPool_delete(pool);
+    }
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static MeshWeldTest testMeshWeld;
+
+//////////////////////////////////////////////////////////////////////////
+
+class MeshSimplifyTest : public Project
+{
+private:
+  enum {
+    MAX_LODS = 8,
+  };
+
+  std::vector<float>  m_pos;
+  std::vector<uint32> m_indices;
+  int                 m_numVertices;
+
+public:
+  MeshSimplifyTest()
+    : Project("meshsimplify","../../backend/test/")
+  {
+
+  }
+
+    // ~1M triangle sphere with a bumpy surface, UV seam and poles
+    // are welded by position+uv, so they remain as real seams
+  void buildMesh(lxMemoryAllocatorPTR allocator){
+    int segs[2] = {1000,500};
+    int numIndices;
+    int numOutline;
+
+    lxMeshSphere_getCounts(segs,&m_numVertices,&numIndices,&numOutline);
+
+    std::vector<float>  normal(m_numVertices * 3);
+    std::vector<float>  uv(m_numVertices * 2);
+    std::vector<uint32> remap(m_numVertices);
+    m_pos.resize(m_numVertices * 3);
+    m_indices.resize(numIndices);
+
+    lxMeshSphere_initTriangles(segs,(lxVector3*)&m_pos[0],(lxVector3*)&normal[0],(lxVector2*)&uv[0],&m_indices[0]);
+
+    for (int i = 0; i < m_numVertices; i++){
+      float* pos = &m_pos[i*3];
+      float  scale = 1.0f + 0.05f * sinf(pos[0] * 20.0f) * sinf(pos[1] * 17.0f) * sinf(pos[2] * 13.0f);
+      pos[0] *= scale;
+      pos[1] *= scale;
+      pos[2] *= scale;
+    }
+
+    lxMeshWeldStream_t streams[2] = {
+      {&m_pos[0],sizeof(float)*3,sizeof(float)*3},
+      {&uv[0],sizeof(float)*2,sizeof(float)*2},
+    };
+    int numUnique = lxMeshWeld_remap(&remap[0],allocator,NULL,streams,2,m_numVertices);
+    lxMeshIndices_remap(&m_indices[0],numIndices,&remap[0],LUX_MESH_INDEX_UINT32);
+    lxMeshVertices_compact(&m_pos[0],&m_pos[0],sizeof(float)*3,m_numVertices,&remap[0]);
+    m_numVertices = numUnique;
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    lxMeshLod_t lods[MAX_LODS];
+
+    buildMesh(allocator);
+
+    int numTriangles = int(m_indices.size() / 3);
+    std::vector<uint32> chain(m_indices.size() * 2);
+
+    double begin = glfwGetTime();
+    int numLods = lxMeshLodChain_build(allocator,lods,MAX_LODS,&chain[0],chain.size(),
+      &m_indices[0],numTriangles,&m_pos[0],sizeof(float)*3,m_numVertices,0.5f,-1.0f,LUX_MESH_INDEX_UINT32);
+    double time = glfwGetTime() - begin;
+
+    printf("meshsimplify: %d triangles %d vertices, lod chain %.1f ms\n",numTriangles,m_numVertices,time * 1000.0);
+    printf("  %4s %10s %10s %12s %14s\n","lod","first","triangles","error","pixels@10m");
+    for (int i = 0; i < numLods; i++){
+      // 1080p at 60 degrees fov
+      float pixelScale = 1080.0f / (2.0f * tanf(LUX_DEG2RAD(30.0f)));
+      printf("  %4d %10u %10u %12.6f %14.3f\n",i,lods[i].firstIndex,lods[i].numIndices / 3,
+        lods[i].error,lods[i].error * pixelScale / 10.0f);
+    }
+
+    float error;
+    begin = glfwGetTime();
+    int reduced = lxMeshSimplify(allocator,&chain[0],&m_indices[0],numTriangles,&m_pos[0],sizeof(float)*3,m_numVertices,
+      numTriangles / 100,-1.0f,&error,LUX_MESH_INDEX_UINT32);
+    time = glfwGetTime() - begin;
+
+    printf("  simplify to 1%%: %d triangles, error %f, %.1f ms\n",reduced,error,time * 1000.0);
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static MeshSimplifyTest testMeshSimplify;
+
+//////////////////////////////////////////////////////////////////////////
+
+class MeshletTest : public Project
+{
+private:
+  enum {
+    NUM_FRAMES = 64,
+  };
+
+public:
+  MeshletTest()
+    : Project("meshlet","../../backend/test/")
+  {
+
+  }
+
+  void runMesh(lxMemoryAllocatorPTR allocator, const char* name, float bumps){
+    int segs[2] = {1000,500};
+    int numVertices;
+    int numIndices;
+    int numOutline;
+
+    lxMeshSphere_getCounts(segs,&numVertices,&numIndices,&numOutline);
+
+    std::vector<float>  pos(numVertices * 3);
+    std::vector<float>  normal(numVertices * 3);
+    std::vector<float>  uv(numVertices * 2);
+    std::vector<uint32> indices(numIndices);
+
+    lxMeshSphere_initTriangles(segs,(lxVector3*)&pos[0],(lxVector3*)&normal[0],(lxVector2*)&uv[0],&indices[0]);
+
+    for (int i = 0; i < numVertices; i++){
+      float* p = &pos[i*3];
+      float  scale = 1.0f + bumps * sinf(p[0] * 20.0f) * sinf(p[1] * 17.0f) * sinf(p[2] * 13.0f);
+      lxVector3Scale(p,p,scale);
+    }
+
+    // generator winds clockwise, cones assume counter-clockwise front faces
+    for (int i = 0; i < numIndices; i += 3){
+      std::swap(indices[i+1],indices[i+2]);
+    }
+
+    int numTriangles = numIndices / 3;
+    int maxMeshlets = lxMeshlet_getMaxCount(numTriangles,LUX_MESHLET_MAX_VERTICES,LUX_MESHLET_MAX_TRIANGLES);
+    std::vector<lxMeshlet_t>  meshlets(maxMeshlets);
+    std::vector<uint32>       meshletVertices(maxMeshlets * LUX_MESHLET_MAX_VERTICES);
+    std::vector<uint8>        meshletTriangles(maxMeshlets * LUX_MESHLET_MAX_TRIANGLES * 3);
+
+    double begin = glfwGetTime();
+    int numMeshlets = lxMeshlet_build(allocator,&meshlets[0],&meshletVertices[0],&meshletTriangles[0],
+      &indices[0],numTriangles,&pos[0],sizeof(float)*3,numVertices,
+      LUX_MESHLET_MAX_VERTICES,LUX_MESHLET_MAX_TRIANGLES,LUX_MESH_INDEX_UINT32);
+    double timeBuild = glfwGetTime() - begin;
+
+    // camera orbits close to the surface, looking at the center
+    std::vector<uint32> visible(numMeshlets);
+    lxMatrix44 proj;
+    lxMatrix44Perspective(proj,60.0f,0.01f,100.0f,16.0f/9.0f);
+
+    double  timeCull = 0.0;
+    double  culledFrustum = 0.0;
+    double  culledBackface = 0.0;
+    for (int f = 0; f < NUM_FRAMES; f++){
+      float   angle = float(f) * LUX_MUL_TWOPI / float(NUM_FRAMES);
+      lxVector3 from = {1.8f * cosf(angle), 0.5f * sinf(angle * 3.0f), 1.8f * sinf(angle)};
+      lxVector3 to = {0.0f, 0.0f, 0.0f};
+      lxVector3 up = {0.0f, 1.0f, 0.0f};
+      lxMatrix44 view;
+      lxMatrix44 viewproj;
+      lxFrustum_t frustum;
+      lxMeshletCullStats_t stats;
+
+      lxMatrix44LookAt(view,from,to,up);
+      lxMatrix44MultiplyFull(viewproj,proj,view);
+      lxFrustum_update(&frustum,viewproj);
+
+      begin = glfwGetTime();
+      lxMeshlet_cull(&visible[0],&meshlets[0],numMeshlets,&frustum,from,&stats);
+      timeCull += glfwGetTime() - begin;
+
+      culledFrustum += stats.culledTrianglesFrustum;
+      culledBackface += stats.culledTrianglesBackface;
+    }
+
+    printf("  %-8s %9d %9d %9.1f %9.1f %10.0f %10.0f %9.3f\n",name,numTriangles,numMeshlets,
+      double(numTriangles) / double(numMeshlets),timeBuild * 1000.0,
+      culledFrustum / double(NUM_FRAMES),culledBackface / double(NUM_FRAMES),
+      timeCull * 1000.0 / double(NUM_FRAMES));
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+
+    printf("meshlet: %d/%d meshlets, culled triangles per frame averaged over %d frames\n",
+      LUX_MESHLET_MAX_VERTICES,LUX_MESHLET_MAX_TRIANGLES,NUM_FRAMES);
+    printf("  %-8s %9s %9s %9s %9s %10s %10s %9s\n","mesh","triangles","meshlets","tris/mlt","build ms","frustum","backface","cull ms");
+
+    runMesh(allocator,"sphere",0.0f);
+    runMesh(allocator,"bumpy",0.05f);
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static MeshletTest testMeshlet;
+
+
+//////////////////////////////////////////////////////////////////////////
+
+class MeshGenTest : public Project
+{
+private:
+  enum {
+    NUM_INSTANCES = 4096,
+    NUM_RUNS = 10,
+  };
+
+  struct Vertex {
+    float   pos[3];
+    int8    normal[4];
+    float16 uv[2];
+  };
+
+  std::vector<lxMeshGenInstance_t>  m_instances;
+  std::vector<float>                m_matrices;
+
+public:
+  MeshGenTest()
+    : Project("meshgen","../../backend/test/")
+  {
+
+  }
+
+  void buildInstances(){
+    static const int shapes[][4] = {
+      {LUX_MESHGEN_SPHERE,    16,8,0},
+      {LUX_MESHGEN_BOX,       1,1,1},
+      {LUX_MESHGEN_CYLINDER,  16,1,1},
+      {LUX_MESHGEN_DISC,      16,1,0},
+    };
+
+    m_instances.resize(NUM_INSTANCES);
+    m_matrices.resize(NUM_INSTANCES * 16);
+    for (int i = 0; i < NUM_INSTANCES; i++){
+      const int* shape = shapes[i % 4];
+      float* matrix = &m_matrices[i * 16];
+      lxVector3 angles = {float(i) * 0.1f, float(i) * 0.7f, float(i) * 0.3f};
+
+      lxMatrix44Identity(matrix);
+      lxMatrix44FromEulerXYZ(matrix,angles);
+      // non-uniform scale, normals need the inverse transpose
+      if (i % 5 == 0){
+        for (int c = 0; c < 3; c++){
+          matrix[0 + c] *= 2.0f;
+          matrix[4 + c] *= 0.5f;
+          matrix[8 + c] *= 1.5f;
+        }
+      }
+      matrix[12] = float(i % 64);
+      matrix[13] = float(i / 64);
+
+      m_instances[i].shape = (lxMeshGenShape_t)shape[0];
+      m_instances[i].segs[0] = shape[1];
+      m_instances[i].segs[1] = shape[2];
+      m_instances[i].segs[2] = shape[3];
+      m_instances[i].matrix = matrix;
+    }
+  }
+
+    // previous path, meshbase into temporary arrays, then transform and pack
+  void runSingle(Vertex* vertices, uint16* indices){
+    std::vector<float>      pos;
+    std::vector<float>      normal;
+    std::vector<float>      uv;
+    std::vector<uint32>     tris;
+    int offset = 0;
+
+    for (int i = 0; i < NUM_INSTANCES; i++){
+      const lxMeshGenInstance_t& inst = m_instances[i];
+      int segs[3] = {inst.segs[0],inst.segs[1],inst.segs[2]};
+      int numVertices;
+      int numIndices;
+      int numOutline;
+
+      switch(inst.shape){
+      case LUX_MESHGEN_SPHERE:    lxMeshSphere_getCounts(segs,&numVertices,&numIndices,&numOutline); break;
+      case LUX_MESHGEN_BOX:       lxMeshBox_getCounts(segs,&numVertices,&numIndices,&numOutline); break;
+      case LUX_MESHGEN_CYLINDER:  lxMeshCylinder_getCounts(segs,&numVertices,&numIndices,&numOutline); break;
+      default:                    lxMeshDisc_getCounts(segs,&numVertices,&numIndices,&numOutline); break;
+      }
+      pos.resize(numVertices * 3);
+      normal.resize(numVertices * 3);
+      uv.resize(numVertices * 2);
+      tris.resize(numIndices);
+      switch(inst.shape){
+      case LUX_MESHGEN_SPHERE:    lxMeshSphere_initTriangles(segs,(lxVector3*)&pos[0],(lxVector3*)&normal[0],(lxVector2*)&uv[0],&tris[0]); break;
+      case LUX_MESHGEN_BOX:       lxMeshBox_initTriangles(segs,(lxVector3*)&pos[0],(lxVector3*)&normal[0],(lxVector2*)&uv[0],&tris[0]); break;
+      case LUX_MESHGEN_CYLINDER:  lxMeshCylinder_initTriangles(segs,(lxVector3*)&pos[0],(lxVector3*)&normal[0],(lxVector2*)&uv[0],&tris[0]); break;
+      default:                    lxMeshDisc_initTriangles(segs,(lxVector3*)&pos[0],(lxVector3*)&normal[0],(lxVector2*)&uv[0],&tris[0]); break;
+      }
+
+      lxMatrix44 inverse;
+      lxMatrix44 normalmatrix;
+      lxMatrix44Invert(inverse,inst.matrix);
+      lxMatrix44TransposeRot(normalmatrix,inverse);
+
+      for (int v = 0; v < numVertices; v++){
+        Vertex& vtx = vertices[v];
+        lxVector3 nrm;
+        lxVector3Transform(vtx.pos,&pos[v*3],inst.matrix);
+        lxVector3TransformRot(nrm,&normal[v*3],normalmatrix);
+        lxVector3Normalized(nrm);
+        for (int c = 0; c < 3; c++){
+          vtx.normal[c] = int8(floorf(nrm[c] * 127.0f + 0.5f));
+        }
+        vtx.normal[3] = 0;
+        vtx.uv[0] = lxFloat32To16(uv[v*2+0]);
+        vtx.uv[1] = lxFloat32To16(uv[v*2+1]);
+      }
+      if (offset + numVertices > 0x10000){
+        offset = 0;
+      }
+      for (int n = 0; n < numIndices; n++){
+        indices[n] = uint16(tris[n] + offset);
+      }
+
+      vertices += numVertices;
+      indices += numIndices;
+      offset += numVertices;
+    }
+  }
+
+    // batch output must match the single path
+  bool compare(const std::vector<Vertex>& vertsA, const std::vector<uint16>& indicesA,
+    const std::vector<Vertex>& vertsB, const std::vector<uint16>& indicesB)
+  {
+    float maxPos = 0;
+    int   maxNormal = 0;
+    int   mismatches = 0;
+
+    for (size_t v = 0; v < vertsA.size(); v++){
+      const Vertex& a = vertsA[v];
+      const Vertex& b = vertsB[v];
+      for (int c = 0; c < 3; c++){
+        maxPos = LUX_MAX(maxPos,fabsf(a.pos[c] - b.pos[c]));
+        maxNormal = LUX_MAX(maxNormal,abs(int(a.normal[c]) - int(b.normal[c])));
+      }
+      mismatches += a.normal[3] != b.normal[3] || a.uv[0] != b.uv[0] || a.uv[1] != b.uv[1];
+    }
+    for (size_t i = 0; i < indicesA.size(); i++){
+      mismatches += indicesA[i] != indicesB[i];
+    }
+
+    bool ok = maxPos < 0.001f && maxNormal <= 1 && !mismatches;
+    printf("  compare: pos %g, normal %d, mismatches %d, %s\n",
+      maxPos,maxNormal,mismatches,ok ? "ok" : "FAILED");
+    return ok;
+  }
+
+  int onInit(int argc, const char** argv) {
+    buildInstances();
+
+    int numVertices;
+    int numIndices;
+    lxMeshGen_getCounts(&m_instances[0],NUM_INSTANCES,&numVertices,&numIndices);
+
+    std::vector<Vertex> vertices(numVertices);
+    std::vector<uint16> indices(numIndices);
+    std::vector<Vertex> singleVertices(numVertices);
+    std::vector<uint16> singleIndices(numIndices);
+
+    lxgVertexDecl_t decl;
+    memset(&decl,0,sizeof(decl));
+    decl.available = lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_POS) |
+                     lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_NORMAL) |
+                     lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_TEXCOORD0);
+    decl.streams = 1;
+    decl.table[LUXGFX_VERTEX_ATTRIB_POS] = lxgVertexElement_set(3,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(Vertex),offsetof(Vertex,pos),0);
+    decl.table[LUXGFX_VERTEX_ATTRIB_NORMAL] = lxgVertexElement_set(4,LUX_SCALAR_INT8,LUX_TRUE,LUX_FALSE,sizeof(Vertex),offsetof(Vertex,normal),0);
+    decl.table[LUXGFX_VERTEX_ATTRIB_TEXCOORD0] = lxgVertexElement_set(2,LUX_SCALAR_FLOAT16,LUX_FALSE,LUX_FALSE,sizeof(Vertex),offsetof(Vertex,uv),0);
+
+    printf("meshgen: %d instances, %d vertices, %d triangles, ms per batch\n",
+      NUM_INSTANCES,numVertices,numIndices / 3);
+
+    double begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      runSingle(&singleVertices[0],&singleIndices[0]);
+    }
+    double timeSingle = (glfwGetTime() - begin) / double(NUM_RUNS);
+
+    // one call per 64k vertices, as uint16 indices require
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxMeshGenTarget_t target;
+      int first = 0;
+      memset(&target,0,sizeof(target));
+      target.decl = &decl;
+      target.streams[0] = &vertices[0];
+      target.indices = &indices[0];
+      target.indexType = LUX_MESH_INDEX_UINT16;
+
+      while (first < NUM_INSTANCES){
+        int last = first;
+        int batchVertices = 0;
+        int batchIndices = 0;
+        while (last < NUM_INSTANCES){
+          int numv;
+          int numi;
+          lxMeshGen_getCounts(&m_instances[last],1,&numv,&numi);
+          if (batchVertices + numv > 0x10000) break;
+          batchVertices += numv;
+          batchIndices += numi;
+          last++;
+        }
+        lxMeshGen_build(&target,&m_instances[first],last - first);
+        target.streams[0] = (Vertex*)target.streams[0] + batchVertices;
+        target.indices = (uint16*)target.indices + batchIndices;
+        first = last;
+      }
+    }
+    double timeBatch = (glfwGetTime() - begin) / double(NUM_RUNS);
+
+    printf("  %10s %10s\n","single","batch");
+    printf("  %10.3f %10.3f\n",timeSingle * 1000.0,timeBatch * 1000.0);
+
+    compare(singleVertices,singleIndices,vertices,indices);
+
+    return 1;
+  }
+
+};
+
+static MeshGenTest testMeshGen;
+
+//////////////////////////////////////////////////////////////////////////
+
+class MeshQuantizeTest : public Project
+{
+public:
+  MeshQuantizeTest()
+    : Project("meshquantize","../../backend/test/")
+  {
+
+  }
+
+  void runMesh(const char* name, lxMeshGenShape_t shape, int segs0, int segs1, int segs2, float size){
+    lxMeshGenInstance_t inst = {shape,{segs0,segs1,segs2},NULL};
+    int numVertices;
+    int numIndices;
+    lxMeshGen_getCounts(&inst,1,&numVertices,&numIndices);
+
+    struct Vertex {
+      float pos[3];
+      float normal[3];
+      float tangent[4];
+      float uv[2];
+    };
+    std::vector<Vertex> vertices(numVertices);
+    std::vector<uint32> indices(numIndices);
+
+    lxgVertexDecl_t decl;
+    memset(&decl,0,sizeof(decl));
+    decl.available = lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_POS) |
+                     lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_NORMAL) |
+                     lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_TEXCOORD0);
+    decl.streams = 1;
+    decl.table[LUXGFX_VERTEX_ATTRIB_POS] = lxgVertexElement_set(3,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(Vertex),offsetof(Vertex,pos),0);
+    decl.table[LUXGFX_VERTEX_ATTRIB_NORMAL] = lxgVertexElement_set(3,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(Vertex),offsetof(Vertex,normal),0);
+    decl.table[LUXGFX_VERTEX_ATTRIB_TEXCOORD0] = lxgVertexElement_set(2,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(Vertex),offsetof(Vertex,uv),0);
+
+    lxMeshGenTarget_t target;
+    memset(&target,0,sizeof(target));
+    target.decl = &decl;
+    target.streams[0] = &vertices[0];
+    target.indices = &indices[0];
+    target.indexType = LUX_MESH_INDEX_UINT32;
+    lxMeshGen_build(&target,&inst,1);
+
+    // scaled, off-center and a tangent perpendicular to the normal
+    for (int i = 0; i < numVertices; i++){
+      Vertex& vtx = vertices[i];
+      lxVector3 up = {0.0f, 0.0f, 1.0f};
+      lxVector3Scale(vtx.pos,vtx.pos,size);
+      vtx.pos[0] += size * 3.0f;
+      lxVector3Cross(vtx.tangent,up,vtx.normal);
+      if (lxVector3Dot(vtx.tangent,vtx.tangent) < 0.0001f){
+        lxVector3Set(vtx.tangent,1.0f,0.0f,0.0f);
+      }
+      lxVector3Normalized(vtx.tangent);
+      vtx.tangent[3] = (i & 1) ? -1.0f : 1.0f;
+    }
+
+    lxMeshQuantizeInput_t input;
+    input.positions = vertices[0].pos;
+    input.posStride = sizeof(Vertex);
+    input.normals = vertices[0].normal;
+    input.normalStride = sizeof(Vertex);
+    input.tangents = vertices[0].tangent;
+    input.tangentStride = sizeof(Vertex);
+    input.uvs = vertices[0].uv;
+    input.uvStride = sizeof(Vertex);
+    input.numVertices = numVertices;
+
+    for (int n = 0; n < LUX_MESHQUANTIZE_NORMALS; n++){
+      lxMeshQuantize_t quant;
+      lxMeshQuantize_init(&quant,&input,(lxMeshQuantizeNormal_t)n);
+      std::vector<byte> packed(quant.vertexSize * numVertices);
+
+      double begin = glfwGetTime();
+      lxMeshQuantize_run(&quant,&packed[0],&input,(lxMeshQuantizeNormal_t)n);
+      double time = glfwGetTime() - begin;
+
+      const lxMeshQuantizeStats_t& stats = quant.stats;
+      printf("  %-8s %5s %8d %4d %9.2e %9.2e %7.3f %7.3f %7.3f %9.2e %7.1f%% %8.2f\n",
+        name,n == LUX_MESHQUANTIZE_OCT8 ? "oct8" : "oct16",numVertices,quant.vertexSize,
+        stats.posMaxError / size,stats.posAvgError / size,
+        stats.normalMaxAngle,stats.normalAvgAngle,stats.tangentMaxAngle,stats.uvMaxError,
+        100.0 - double(stats.bytesOutput) * 100.0 / double(stats.bytesInput),time * 1000.0);
+    }
+  }
+
+  int onInit(int argc, const char** argv) {
+    printf("meshquantize: position error relative to mesh size, angles in degrees\n");
+    printf("  %-8s %5s %8s %4s %9s %9s %7s %7s %7s %9s %8s %8s\n","mesh","oct","vertices","size",
+      "pos max","pos avg","nrm max","nrm avg","tan max","uv max","saved","ms");
+
+    runMesh("sphere",LUX_MESHGEN_SPHERE,512,256,0,10.0f);
+    runMesh("box",LUX_MESHGEN_BOX,64,64,64,250.0f);
+    runMesh("cylinder",LUX_MESHGEN_CYLINDER,256,4,64,0.5f);
+
+    return 1;
+  }
+
+};
+
+static MeshQuantizeTest testMeshQuantize;
+
+//////////////////////////////////////////////////////////////////////////
+
+class MeshCodecTest : public Project
+{
+private:
+  enum {
+    NUM_RUNS = 20,
+    CHUNK_SIZE = 4096,
+  };
+
+public:
+  MeshCodecTest()
+    : Project("meshcodec","../../backend/test/")
+  {
+
+  }
+
+  static bool sameTriangle(const uint32* a, const uint32* b){
+    for (int r = 0; r < 3; r++){
+      if (a[0] == b[r] && a[1] == b[(r+1)%3] && a[2] == b[(r+2)%3]) return true;
+    }
+    return false;
+  }
+
+  void runMesh(const char* name, lxMeshGenShape_t shape, int segs0, int segs1, int segs2, bool optimize){
+    lxMeshGenInstance_t inst = {shape,{segs0,segs1,segs2},NULL};
+    int numVertices;
+    int numIndices;
+    lxMeshGen_getCounts(&inst,1,&numVertices,&numIndices);
+
+    std::vector<float>  pos(numVertices * 3);
+    std::vector<uint32> indices(numIndices);
+
+    lxgVertexDecl_t decl;
+    memset(&decl,0,sizeof(decl));
+    decl.available = lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_POS);
+    decl.streams = 1;
+    decl.table[LUXGFX_VERTEX_ATTRIB_POS] = lxgVertexElement_set(3,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(float)*3,0,0);
+
+    lxMeshGenTarget_t target;
+    memset(&target,0,sizeof(target));
+    target.decl = &decl;
+    target.streams[0] = &pos[0];
+    target.indices = &indices[0];
+    target.indexType = LUX_MESH_INDEX_UINT32;
+    lxMeshGen_build(&target,&inst,1);
+
+    if (optimize){
+      std::vector<uint32> remap(numVertices);
+      lxVertexCacheOptimize_tipsify(&indices[0],numIndices/3,numVertices,16,LUX_MESH_INDEX_UINT32);
+      lxMeshVertexFetch_remap(&remap[0],&indices[0],numIndices,numVertices,LUX_MESH_INDEX_UINT32);
+      lxMeshIndices_remap(&indices[0],numIndices,&remap[0],LUX_MESH_INDEX_UINT32);
+    }
+
+    std::vector<byte>   encoded(lxMeshIndexCodec_getMaxSize(numIndices));
+    std::vector<uint32> decoded(numIndices);
+    std::vector<uint16> streamed(numIndices);
+
+    double begin = glfwGetTime();
+    size_t size = lxMeshIndexCodec_encode(&encoded[0],encoded.size(),&indices[0],numIndices,LUX_MESH_INDEX_UINT32);
+    double timeEncode = glfwGetTime() - begin;
+
+    booln error = LUX_FALSE;
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      error |= lxMeshIndexCodec_decode(&decoded[0],numIndices,&encoded[0],size,LUX_MESH_INDEX_UINT32);
+    }
+    double timeDecode = (glfwGetTime() - begin) / double(NUM_RUNS);
+
+    // as if read from file in chunks
+    lxMeshIndexDecoder_t decoder;
+    lxMeshIndexDecoder_init(&decoder);
+    int numStreamed = 0;
+    for (size_t offset = 0; offset < size; offset += CHUNK_SIZE){
+      size_t used;
+      int written = lxMeshIndexDecoder_run(&decoder,&streamed[numStreamed],numIndices - numStreamed,
+        &encoded[offset],LUX_MIN(size - offset,(size_t)CHUNK_SIZE),&used,LUX_MESH_INDEX_UINT16);
+      if (written < 0){
+        error = LUX_TRUE;
+        break;
+      }
+      numStreamed += written;
+    }
+    error |= numStreamed != numIndices;
+
+    for (int i = 0; i < numIndices && !error; i += 3){
+      error |= !sameTriangle(&indices[i],&decoded[i]);
+      for (int c = 0; c < 3; c++){
+        error |= streamed[i+c] != decoded[i+c];
+      }
+    }
+
+    printf("  %-8s %3s %8d %9d %9d %8.2f %7.1f%% %9.2f %9.1f %6s\n",name,optimize ? "yes" : "no",
+      numIndices / 3,numIndices * 2,(int)size,double(size) / double(numIndices / 3),
+      double(size) * 100.0 / double(numIndices * 2),timeEncode * 1000.0,
+      double(numIndices) / timeDecode / 1000000.0,error ? "FAILED" : "ok");
+  }
+
+  int onInit(int argc, const char** argv) {
+    printf("meshcodec: encoded size vs uint16 indices, decode in million indices per second\n");
+    printf("  %-8s %3s %8s %9s %9s %8s %8s %9s %9s %6s\n","mesh","opt","tris","uint16","encoded",
+      "B/tri","ratio","enc ms","dec M/s","check");
+
+    for (int opt = 0; opt < 2; opt++){
+      runMesh("plane",LUX_MESHGEN_PLANE,250,250,0,opt != 0);
+      runMesh("disc",LUX_MESHGEN_DISC,256,64,0,opt != 0);
+      runMesh("box",LUX_MESHGEN_BOX,64,64,64,opt != 0);
+      runMesh("sphere",LUX_MESHGEN_SPHERE,256,128,0,opt != 0);
+      runMesh("cylinder",LUX_MESHGEN_CYLINDER,256,16,64,opt != 0);
+    }
+
+    return 1;
+  }
+
+};
+
+static MeshCodecTest testMeshCodec;
+
+//////////////////////////////////////////////////////////////////////////
+
+class MeshFileTest : public Project
+{
+private:
+  enum {
+    NUM_RUNS = 100,
+    MAX_LODS = 6,
+  };
+
+  struct Attribs {
+    float   normal[3];
+    float   uv[2];
+  };
+
+public:
+  MeshFileTest()
+    : Project("meshfile","../../backend/test/")
+  {
+
+  }
+
+  static const char* errorName(lxMeshFileError_t error){
+    static const char* names[LUX_MESHFILE_ERRORS] = {
+      "none","size","magic","version","platform","range","decl","lods","indices",
+    };
+    return error >= 0 && error < LUX_MESHFILE_ERRORS ? names[error] : "?";
+  }
+
+  bool expect(const char* what, const std::vector<byte>& file, size_t size, lxMeshFileError_t expected, booln checkIndices){
+    // keep alignment of the original
+    std::vector<byte> copy(file.size() + LUX_MESHFILE_ALIGN);
+    byte* data = (byte*)(((size_t)&copy[0] + LUX_MESHFILE_ALIGN - 1) & ~(size_t)(LUX_MESHFILE_ALIGN - 1));
+    memcpy(data,&file[0],file.size());
+
+    lxMeshFileError_t error = lxMeshFile_validate(data,size,checkIndices);
+    printf("  %-24s %-9s %s\n",what,errorName(error),error == expected ? "ok" : "FAILED");
+    return error == expected;
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+
+    lxMeshGenInstance_t inst = {LUX_MESHGEN_SPHERE,{512,256,0},NULL};
+    int numVertices;
+    int numIndices;
+    lxMeshGen_getCounts(&inst,1,&numVertices,&numIndices);
+
+    std::vector<float>    pos(numVertices * 3);
+    std::vector<Attribs>  attribs(numVertices);
+    std::vector<uint32>   indices(numIndices);
+
+    lxgVertexDecl_t decl;
+    memset(&decl,0,sizeof(decl));
+    decl.available = lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_POS) |
+      lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_NORMAL) |
+      lxgVertexAttrib_bit(LUXGFX_VERTEX_ATTRIB_TEXCOORD0);
+    decl.streams = 2;
+    decl.table[LUXGFX_VERTEX_ATTRIB_POS] = lxgVertexElement_set(3,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(float)*3,0,0);
+    decl.table[LUXGFX_VERTEX_ATTRIB_NORMAL] = lxgVertexElement_set(3,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(Attribs),offsetof(Attribs,normal),1);
+    decl.table[LUXGFX_VERTEX_ATTRIB_TEXCOORD0] = lxgVertexElement_set(2,LUX_SCALAR_FLOAT32,LUX_FALSE,LUX_FALSE,sizeof(Attribs),offsetof(Attribs,uv),1);
+
+    lxMeshGenTarget_t target;
+    memset(&target,0,sizeof(target));
+    target.decl = &decl;
+    target.streams[0] = &pos[0];
+    target.streams[1] = &attribs[0];
+    target.indices = &indices[0];
+    target.indexType = LUX_MESH_INDEX_UINT32;
+    lxMeshGen_build(&target,&inst,1);
+
+    lxMeshLod_t lods[MAX_LODS];
+    std::vector<uint32> chain(indices.size() * 2);
+    int numLods = lxMeshLodChain_build(allocator,lods,MAX_LODS,&chain[0],chain.size(),
+      &indices[0],numIndices/3,&pos[0],sizeof(float)*3,numVertices,0.5f,-1.0f,LUX_MESH_INDEX_UINT32);
+    int numChain = lods[numLods-1].firstIndex + lods[numLods-1].numIndices;
+
+    lxDrawGeometry_t geometry;
+    memset(&geometry,0,sizeof(geometry));
+    geometry.vertexDecl = &decl;
+    geometry.indexType = LUX_SCALAR_UINT32;
+    geometry.indexStream.ptr = &chain[0];
+    geometry.indexStream.len = sizeof(uint32) * numChain;
+    geometry.vertexStreams[0].ptr = &pos[0];
+    geometry.vertexStreams[0].len = sizeof(float) * pos.size();
+    geometry.vertexStreams[1].ptr = &attribs[0];
+    geometry.vertexStreams[1].len = sizeof(Attribs) * attribs.size();
+
+    size_t size = lxMeshFile_getSize(&geometry,numLods);
+    std::vector<byte> storage(size + LUX_MESHFILE_ALIGN);
+    byte* data = (byte*)(((size_t)&storage[0] + LUX_MESHFILE_ALIGN - 1) & ~(size_t)(LUX_MESHFILE_ALIGN - 1));
+
+    double begin = glfwGetTime();
+    size_t written = lxMeshFile_write(data,size,&geometry,NULL,lods,numLods);
+    double timeWrite = glfwGetTime() - begin;
+
+    printf("meshfile: %d vertices %d indices %d lods, %.2f MB, write %.2f ms %s\n",
+      numVertices,numChain,numLods,double(written) / (1024.0 * 1024.0),timeWrite * 1000.0,
+      written == size ? "ok" : "FAILED");
+
+    // round trip
+    lxDrawGeometry_t loaded;
+    const lxMeshFileHeader_t* header;
+    lxMeshFileError_t error = lxMeshFile_load(data,size,&loaded,&header);
+    bool same = !error &&
+      !memcmp(loaded.vertexDecl,&decl,sizeof(decl)) &&
+      loaded.indexType == LUX_SCALAR_UINT32 &&
+      loaded.indexStream.len == geometry.indexStream.len &&
+      !memcmp(loaded.indexStream.ptr,&chain[0],geometry.indexStream.len) &&
+      loaded.vertexStreams[0].len == geometry.vertexStreams[0].len &&
+      !memcmp(loaded.vertexStreams[0].ptr,&pos[0],geometry.vertexStreams[0].len) &&
+      loaded.vertexStreams[1].len == geometry.vertexStreams[1].len &&
+      !memcmp(loaded.vertexStreams[1].ptr,&attribs[0],geometry.vertexStreams[1].len) &&
+      !memcmp(lxMeshFile_getLods(header),lods,sizeof(lxMeshLod_t) * numLods) &&
+      header->numVertices == numVertices;
+    printf("  load %s, bbox %.2f %.2f %.2f - %.2f %.2f %.2f, radius %.2f\n",same ? "ok" : "FAILED",
+      header->bounding.bbox.min[0],header->bounding.bbox.min[1],header->bounding.bbox.min[2],
+      header->bounding.bbox.max[0],header->bounding.bbox.max[1],header->bounding.bbox.max[2],
+      header->bounding.bsphere.radius);
+
+    // previous path, every block copied into its own allocation
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      lxDrawGeometry_t copied = loaded;
+      void* copies[LUXGFX_MAX_VERTEX_STREAMS + 2];
+      int   numCopies = 0;
+
+      copied.vertexDecl = (lxgVertexDeclPTR)malloc(sizeof(lxgVertexDecl_t));
+      memcpy(copied.vertexDecl,loaded.vertexDecl,sizeof(lxgVertexDecl_t));
+      copies[numCopies++] = copied.vertexDecl;
+      copied.indexStream.ptr = malloc(loaded.indexStream.len);
+      memcpy(copied.indexStream.ptr,loaded.indexStream.ptr,loaded.indexStream.len);
+      copies[numCopies++] = copied.indexStream.ptr;
+      for (int i = 0; i < LUXGFX_MAX_VERTEX_STREAMS; i++){
+        if (!loaded.vertexStreams[i].len) continue;
+        copied.vertexStreams[i].ptr = malloc(loaded.vertexStreams[i].len);
+        memcpy(copied.vertexStreams[i].ptr,loaded.vertexStreams[i].ptr,loaded.vertexStreams[i].len);
+        copies[numCopies++] = copied.vertexStreams[i].ptr;
+      }
+      for (int i = 0; i < numCopies; i++){
+        free(copies[i]);
+      }
+    }
+    double timeCopy = (glfwGetTime() - begin) / double(NUM_RUNS);
+
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      error = (lxMeshFileError_t)(error | lxMeshFile_load(data,size,&loaded,NULL));
+    }
+    double timeLoad = (glfwGetTime() - begin) / double(NUM_RUNS);
+
+    begin = glfwGetTime();
+    for (int r = 0; r < NUM_RUNS; r++){
+      error = (lxMeshFileError_t)(error | lxMeshFile_validate(data,size,LUX_TRUE));
+    }
+    double timeValidate = (glfwGetTime() - begin) / double(NUM_RUNS);
+
+    printf("  copy blocks %10.3f us\n",timeCopy * 1000000.0);
+    printf("  load        %10.3f us %s\n",timeLoad * 1000000.0,error ? "FAILED" : "ok");
+    printf("  validate    %10.3f us (with indices)\n",timeValidate * 1000000.0);
+
+    // corrupted files
+    std::vector<byte> file(data,data + size);
+    lxMeshFileHeader_t* fheader = (lxMeshFileHeader_t*)&file[0];
+    bool valid = true;
+
+    valid &= expect("truncated",file,size - 1,LUX_MESHFILE_ERROR_SIZE,LUX_FALSE);
+    valid &= expect("header only",file,sizeof(lxMeshFileHeader_t) - 4,LUX_MESHFILE_ERROR_SIZE,LUX_FALSE);
+
+    fheader->magic ^= 1;
+    valid &= expect("magic",file,size,LUX_MESHFILE_ERROR_MAGIC,LUX_FALSE);
+    fheader->magic ^= 1;
+
+    fheader->version++;
+    valid &= expect("version",file,size,LUX_MESHFILE_ERROR_VERSION,LUX_FALSE);
+    fheader->version--;
+
+    fheader->elementProbe ^= 0x100;
+    valid &= expect("element layout",file,size,LUX_MESHFILE_ERROR_PLATFORM,LUX_FALSE);
+    fheader->elementProbe ^= 0x100;
+
+    fheader->streams[1].offset += 4;
+    valid &= expect("misaligned stream",file,size,LUX_MESHFILE_ERROR_RANGE,LUX_FALSE);
+    fheader->streams[1].offset -= 4;
+
+    fheader->streams[1].size += LUX_MESHFILE_ALIGN;
+    valid &= expect("stream beyond file",file,size,LUX_MESHFILE_ERROR_RANGE,LUX_FALSE);
+    fheader->streams[1].size -= LUX_MESHFILE_ALIGN;
+
+    fheader->numVertices++;
+    valid &= expect("vertex count",file,size,LUX_MESHFILE_ERROR_DECL,LUX_FALSE);
+    fheader->numVertices--;
+
+    lxMeshLod_t* flods = (lxMeshLod_t*)&file[(size_t)fheader->lods.offset];
+    flods[numLods-1].numIndices += 3;
+    valid &= expect("lod range",file,size,LUX_MESHFILE_ERROR_LODS,LUX_FALSE);
+    flods[numLods-1].numIndices -= 3;
+
+    uint32* findices = (uint32*)&file[(size_t)fheader->indices.offset];
+    findices[7] = numVertices;
+    valid &= expect("index, header only",file,size,LUX_MESHFILE_ERROR_NONE,LUX_FALSE);
+    valid &= expect("index out of range",file,size,LUX_MESHFILE_ERROR_INDICES,LUX_TRUE);
+
+    printf("  validation %s\n",valid ? "ok" : "FAILED");
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static MeshFileTest testMeshFile;
+
+//////////////////////////////////////////////////////////////////////////
+
+class BVHTest : public Project
+{
+private:
+  enum {
+    NUM_PICKS = 4096,
+    NUM_CHECKS = 64,
+    IMAGE_SIZE = 512,
+    NUM_BOXES = 100000,
+    NUM_FRAMES = 16,
+  };
+
+  std::vector<float>  m_pos;
+  std::vector<uint32> m_indices;
+  lxBVHTriangles_t    m_tris;
+
+  struct RayImage {
+    const lxBVH_t*          bvh;
+    const lxBVHTriangles_t* tris;
+    lxVector3               origin;
+    uint32                  hits[IMAGE_SIZE];
+  };
+
+public:
+  BVHTest()
+    : Project("bvh","../../backend/test/")
+  {
+
+  }
+
+  void buildMesh(){
+    int segs[2] = {1000,500};
+    int numVertices;
+    int numIndices;
+    int numOutline;
+
+    lxMeshSphere_getCounts(segs,&numVertices,&numIndices,&numOutline);
+    std::vector<float>  normal(numVertices * 3);
+    std::vector<float>  uv(numVertices * 2);
+    m_pos.resize(numVertices * 3);
+    m_indices.resize(numIndices);
+    lxMeshSphere_initTriangles(segs,(lxVector3*)&m_pos[0],(lxVector3*)&normal[0],(lxVector2*)&uv[0],&m_indices[0]);
+
+    deform(0.05f);
+
+    m_tris.positions = &m_pos[0];
+    m_tris.posStride = sizeof(float) * 3;
+    m_tris.indices = &m_indices[0];
+    m_tris.indexType = LUX_MESH_INDEX_UINT32;
+    m_tris.numTriangles = numIndices / 3;
+  }
+
+  void deform(float bumps){
+    for (size_t i = 0; i < m_pos.size(); i += 3){
+      float* p = &m_pos[i];
+      float  len = sqrtf(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+      float  scale = (1.0f + bumps * sinf(p[0] * 20.0f) * sinf(p[1] * 17.0f) * sinf(p[2] * 13.0f)) / len;
+      p[0] *= scale;
+      p[1] *= scale;
+      p[2] *= scale;
+    }
+  }
+
+  static void getRay(int i, int num, lxVector3 origin, lxVector3 dir){
+    // from a ring around the sphere towards jittered targets near the center
+    float angle = float(i) * LUX_MUL_TWOPI / float(num);
+    float jitter = float((i * 7919) % 1000) / 1000.0f - 0.5f;
+    lxVector3Set(origin,3.0f * cosf(angle),jitter * 2.0f,3.0f * sinf(angle));
+    lxVector3Set(dir,jitter * 0.5f - origin[0],jitter - origin[1],-jitter * 0.7f - origin[2]);
+  }
+
+  float bruteForce(const lxVector3 origin, const lxVector3 dir){
+    lxBVH_t     single;
+    lxBVHNode_t node;
+    uint32      prim;
+    float       closest = FLT_MAX;
+    lxBVHHit_t  hit;
+
+    // a tree with one leaf per triangle tests exactly that triangle
+    single.nodes = &node;
+    single.numNodes = 1;
+    single.prims = &prim;
+    single.numPrims = 1;
+    lxVector3Set(node.min,-FLT_MAX,-FLT_MAX,-FLT_MAX);
+    lxVector3Set(node.max,FLT_MAX,FLT_MAX,FLT_MAX);
+    node.first = 0;
+    node.count = 1;
+
+    for (prim = 0; prim < m_tris.numTriangles; prim++){
+      if (lxBVH_rayTriangles(&single,&m_tris,origin,dir,FLT_MAX,&hit)){
+        closest = LUX_MIN(closest,hit.t);
+      }
+    }
+    return closest;
+  }
+
+  bool checkRays(const lxBVH_t* bvh){
+    bool ok = true;
+    for (int i = 0; i < NUM_CHECKS; i++){
+      lxVector3 origin;
+      lxVector3 dir;
+      lxBVHHit_t hit;
+
+      getRay(i * 61,NUM_CHECKS * 61,origin,dir);
+      float expected = bruteForce(origin,dir);
+      booln found = lxBVH_rayTriangles(bvh,&m_tris,origin,dir,FLT_MAX,&hit);
+      ok &= found ? hit.t == expected : expected == FLT_MAX;
+    }
+    return ok;
+  }
+
+  static void rayImageJob(void* userdata, uint jobindex, uint threadindex){
+    RayImage* image = (RayImage*)userdata;
+    uint32 hits = 0;
+
+    for (int x = 0; x < IMAGE_SIZE; x++){
+      lxVector3 dir = {
+        -image->origin[0] + 2.4f * (float(x) / float(IMAGE_SIZE) - 0.5f),
+        -image->origin[1] + 2.4f * (float(jobindex) / float(IMAGE_SIZE) - 0.5f),
+        -image->origin[2]};
+      lxBVHHit_t hit;
+      hits += lxBVH_rayTriangles(image->bvh,image->tris,image->origin,dir,FLT_MAX,&hit);
+    }
+    image->hits[jobindex] = hits;
+  }
+
+  double runImage(lxJobPoolPTR pool, const lxBVH_t* bvh, uint32* numHits){
+    RayImage image;
+    image.bvh = bvh;
+    image.tris = &m_tris;
+    lxVector3Set(image.origin,0.0f,0.0f,3.0f);
+
+    double begin = glfwGetTime();
+    lxJobPool_run(pool,IMAGE_SIZE,rayImageJob,&image);
+    double time = glfwGetTime() - begin;
+
+    *numHits = 0;
+    for (int y = 0; y < IMAGE_SIZE; y++){
+      *numHits += image.hits[y];
+    }
+    return time;
+  }
+
+  void runBoxes(lxMemoryAllocatorPTR allocator, lxJobPoolPTR pool){
+    std::vector<lxDrawBounding_t> boundings(NUM_BOXES);
+    for (int i = 0; i < NUM_BOXES; i++){
+      lxDrawBounding_t& bounding = boundings[i];
+      float size = 0.1f + float((i * 31) % 100) / 50.0f;
+      lxVector3 center = {
+        float((i * 7919) % 10007) / 100.0f,
+        float((i * 104729) % 10009) / 100.0f,
+        float((i * 1299709) % 10037) / 100.0f};
+      memset(&bounding,0,sizeof(bounding));
+      lxVector3Set(bounding.bbox.min,center[0] - size,center[1] - size,center[2] - size);
+      lxVector3Set(bounding.bbox.max,center[0] + size,center[1] + size,center[2] + size);
+    }
+    const lxBoundingBox_t* boxes = &boundings[0].bbox;
+    size_t stride = sizeof(lxDrawBounding_t);
+
+    lxBVH_t bvh;
+    lxBVH_init(&bvh,allocator);
+    double begin = glfwGetTime();
+    lxBVH_buildBoxes(&bvh,pool,boxes,stride,NUM_BOXES,0);
+    double timeBuild = glfwGetTime() - begin;
+
+    // picking against brute force
+    bool ok = true;
+    double timePick = 0.0;
+    for (int i = 0; i < NUM_CHECKS * 4; i++){
+      lxVector3 origin = {-10.0f,float(i % 16) * 7.0f,float(i / 16) * 7.0f};
+      lxVector3 dir = {1.0f,0.1f,0.05f};
+      lxBVHHit_t hit;
+
+      begin = glfwGetTime();
+      booln found = lxBVH_rayBoxes(&bvh,boxes,stride,origin,dir,1000.0f,&hit);
+      timePick += glfwGetTime() - begin;
+
+      lxBVHHit_t single;
+      float expected = FLT_MAX;
+      for (int b = 0; b < NUM_BOXES; b++){
+        lxBVH_t one = bvh;
+        lxBVHNode_t node = {{-FLT_MAX,-FLT_MAX,-FLT_MAX},0,{FLT_MAX,FLT_MAX,FLT_MAX},1};
+        uint32 prim = b;
+        one.nodes = &node;
+        one.numNodes = 1;
+        one.prims = &prim;
+        if (lxBVH_rayBoxes(&one,boxes,stride,origin,dir,1000.0f,&single)){
+          expected = LUX_MIN(expected,single.t);
+        }
+      }
+      ok &= found ? hit.t == expected : expected == FLT_MAX;
+    }
+
+    // frustum culling, result must contain every visible box
+    std::vector<uint32> visible(NUM_BOXES);
+    std::vector<byte>   marked(NUM_BOXES);
+    lxMatrix44 proj;
+    lxMatrix44Perspective(proj,60.0f,0.1f,60.0f,16.0f/9.0f);
+    double timeCull = 0.0;
+    double numVisible = 0.0;
+    double numExact = 0.0;
+    for (int f = 0; f < NUM_FRAMES; f++){
+      float angle = float(f) * LUX_MUL_TWOPI / float(NUM_FRAMES);
+      lxVector3 from = {50.0f + 40.0f * cosf(angle),50.0f,50.0f + 40.0f * sinf(angle)};
+      lxVector3 to = {50.0f,50.0f,50.0f};
+      lxVector3 up = {0.0f,1.0f,0.0f};
+      lxMatrix44 view;
+      lxMatrix44 viewproj;
+      lxFrustum_t frustum;
+
+      lxMatrix44LookAt(view,from,to,up);
+      lxMatrix44MultiplyFull(viewproj,proj,view);
+      lxFrustum_update(&frustum,viewproj);
+
+      begin = glfwGetTime();
+      uint32 count = lxBVH_cullFrustum(&bvh,&frustum,&visible[0],NUM_BOXES);
+      timeCull += glfwGetTime() - begin;
+
+      std::fill(marked.begin(),marked.end(),0);
+      for (uint32 i = 0; i < count; i++){
+        marked[visible[i]] = 1;
+      }
+      for (int b = 0; b < NUM_BOXES; b++){
+        if (lxFrustum_cullBoundingBox(&frustum,&boundings[b].bbox) != LUX_CULL_OUTSIDE){
+          ok &= marked[b] != 0;
+          numExact += 1.0;
+        }
+      }
+      numVisible += double(count);
+    }
+
+    printf("  boxes %d: build %.2f ms, pick %.3f us, cull %.3f ms (%.0f of %.0f exact) %s\n",NUM_BOXES,
+      timeBuild * 1000.0,timePick * 1000000.0 / double(NUM_CHECKS * 4),timeCull * 1000.0 / double(NUM_FRAMES),
+      numVisible / double(NUM_FRAMES),numExact / double(NUM_FRAMES),ok ? "ok" : "FAILED");
+
+    lxBVH_deinit(&bvh);
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    uint maxThreads = LUX_MAX(lxCPU_getCount(),4);
+
+    buildMesh();
+    printf("bvh: %d triangles\n",m_tris.numTriangles);
+    printf("  %7s %10s %10s %6s %8s %10s\n","threads","build ms","nodes","depth","cost","Mrays/s");
+
+    lxBVH_t bvh;
+    lxBVH_init(&bvh,allocator);
+    uint32  hitsFirst = 0;
+    for (uint t = 1; t <= maxThreads; t *= 2){
+      lxJobPoolPTR pool = lxJobPool_new(allocator,t);
+
+      double begin = glfwGetTime();
+      lxBVH_buildTriangles(&bvh,pool,&m_tris,0);
+      double timeBuild = glfwGetTime() - begin;
+
+      uint32 hits;
+      double timeImage = runImage(pool,&bvh,&hits);
+      if (t == 1){
+        hitsFirst = hits;
+      }
+
+      printf("  %7d %10.1f %10u %6u %8.2f %10.2f %s\n",t,timeBuild * 1000.0,bvh.numNodes,bvh.depth,
+        lxBVH_getCost(&bvh),double(IMAGE_SIZE * IMAGE_SIZE) / timeImage / 1000000.0,
+        hits == hitsFirst ? "" : "FAILED");
+
+      lxJobPool_delete(pool);
+    }
+
+    double timePick = 0.0;
+    uint32 picked = 0;
+    for (int i = 0; i < NUM_PICKS; i++){
+      lxVector3 origin;
+      lxVector3 dir;
+      lxBVHHit_t hit;
+
+      getRay(i,NUM_PICKS,origin,dir);
+      double begin = glfwGetTime();
+      picked += lxBVH_rayTriangles(&bvh,&m_tris,origin,dir,FLT_MAX,&hit);
+      timePick += glfwGetTime() - begin;
+    }
+    printf("  pick %.3f us (%u of %d hit), brute force check %s\n",timePick * 1000000.0 / double(NUM_PICKS),
+      picked,NUM_PICKS,checkRays(&bvh) ? "ok" : "FAILED");
+
+    // animate the surface and refit
+    deform(0.1f);
+    double begin = glfwGetTime();
+    lxBVH_refitTriangles(&bvh,&m_tris);
+    double timeRefit = glfwGetTime() - begin;
+    float  costRefit = lxBVH_getCost(&bvh);
+    bool   refitOk = checkRays(&bvh);
+
+    lxBVH_t rebuilt;
+    lxBVH_init(&rebuilt,allocator);
+    lxBVH_buildTriangles(&rebuilt,NULL,&m_tris,0);
+    printf("  refit %.1f ms, cost %.2f (rebuild %.2f), brute force check %s\n",timeRefit * 1000.0,
+      costRefit,lxBVH_getCost(&rebuilt),refitOk ? "ok" : "FAILED");
+    lxBVH_deinit(&rebuilt);
+    lxBVH_deinit(&bvh);
+
+    runBoxes(allocator,NULL);
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static BVHTest testBVH;
+
+//////////////////////////////////////////////////////////////////////////
+
+class SpatialTest : public Project
+{
+private:
+  enum {
+    NUM_OBJECTS = 1000,
+    NUM_PER_OBJECT = 100,
+    NUM_FRAMES = 32,
+  };
+
+  std::vector<uint32> m_nodes;
+
+  static uint32 addRandomNode(lxDrawSpatial_t* spatial, uint32 parent, const lxDrawBounding_t* bounding){
+    uint32 node = lxDrawSpatial_addNode(spatial,parent);
+    if (node != LUX_DRAWSPATIAL_NONE){
+      lxMatrix44 mat;
+      randomMatrix(mat);
+      lxDrawSpatial_setLocalMatrix(spatial,node,mat);
+      lxDrawSpatial_setBounding(spatial,node,bounding);
+    }
+    return node;
+  }
+
+    // two groups below root, group 0 is removed while allocations
+    // fail, the tree must stay usable and catch up afterwards
+  bool checkAllocFailure(lxMemoryAllocatorPTR allocator, const lxDrawBounding_t* bounding){
+    FailAllocator fail;
+    lxDrawSpatial_t spatial;
+    std::vector<uint32> groups[2];
+    uint32 numSlots;
+    bool ok = true;
+
+    initFailAllocator(fail,allocator);
+    lxDrawSpatial_init(&spatial,&fail.allocator);
+    groups[0].push_back(addRandomNode(&spatial,LUX_DRAWSPATIAL_ROOT,bounding));
+    groups[1].push_back(addRandomNode(&spatial,LUX_DRAWSPATIAL_ROOT,bounding));
+    for (int i = 0; i < 16; i++){
+      std::vector<uint32>& group = groups[i % 2];
+      group.push_back(addRandomNode(&spatial,group[rand() % group.size()],bounding));
+    }
+    lxDrawSpatial_updateTree(&spatial);
+
+    // add until storage is full
+    fail.allowed = 0;
+    for (int i = 0; ; i++){
+      std::vector<uint32>& group = groups[i % 2];
+      uint32 node = addRandomNode(&spatial,group[rand() % group.size()],bounding);
+      if (node == LUX_DRAWSPATIAL_NONE)
+        break;
+      group.push_back(node);
+    }
+    numSlots = spatial.numSlots;
+
+    lxDrawSpatial_remNode(&spatial,groups[0][0]);
+    lxDrawSpatial_updateTree(&spatial);
+    ok &= spatial.numSlots == numSlots && spatial.reorder;
+    ok &= lxDrawSpatial_getParent(&spatial,groups[0].back()) == LUX_DRAWSPATIAL_NONE;
+    ok &= lxDrawSpatial_getParent(&spatial,groups[1].back()) != LUX_DRAWSPATIAL_NONE;
+
+    fail.allowed = -1;
+    lxDrawSpatial_updateTree(&spatial);
+    ok &= spatial.numSlots == groups[1].size() + 1 && checkTree(&spatial,groups[1]);
+
+    lxDrawSpatial_deinit(&spatial);
+    return ok;
+  }
+
+public:
+  SpatialTest()
+    : Project("spatial","../../backend/test/")
+  {
+
+  }
+
+  static float random(){
+    return float(rand()) / float(RAND_MAX);
+  }
+
+  static void randomMatrix(float* mat){
+    lxVector3 angles;
+    lxVector3 pos;
+    lxVector3Set(angles,random() * 360.0f,random() * 360.0f,random() * 360.0f);
+    lxVector3Set(pos,random() * 4.0f - 2.0f,random() * 4.0f - 2.0f,random() * 4.0f - 2.0f);
+    lxMatrix44Identity(mat);
+    lxMatrix44FromEulerZYXdeg(mat,angles);
+    lxMatrix44SetTranslation(mat,pos);
+  }
+
+  static bool checkTree(const lxDrawSpatial_t* spatial, const std::vector<uint32>& nodes){
+    for (size_t i = 0; i < nodes.size(); i++){
+      uint32      node = nodes[i];
+      lxMatrix44  ref;
+      lxMatrix44  tmp;
+      lxMatrix44Copy(ref,lxDrawSpatial_getLocalMatrix(spatial,node));
+      for (uint32 p = lxDrawSpatial_getParent(spatial,node); p != LUX_DRAWSPATIAL_NONE; p = lxDrawSpatial_getParent(spatial,p)){
+        lxMatrix44Multiply(tmp,lxDrawSpatial_getLocalMatrix(spatial,p),ref);
+        lxMatrix44Copy(ref,tmp);
+      }
+
+      lxMatrix44CPTR world = lxDrawSpatial_getWorldMatrix(spatial,node);
+      for (int n = 0; n < 16; n++){
+        if (fabsf(world[n] - ref[n]) > 0.001f * (1.0f + fabsf(ref[n])))
+          return false;
+      }
+
+      // the world box must contain the transformed local box corners
+      const lxDrawBounding_t* bounding = lxDrawSpatial_getWorldBounding(spatial,node);
+      lxVector3 corner;
+      lxVector3Set(corner,0.5f,-0.5f,0.5f);
+      lxVector3Transform1(corner,ref);
+      for (int n = 0; n < 3; n++){
+        if (corner[n] < bounding->bbox.min[n] - 0.001f || corner[n] > bounding->bbox.max[n] + 0.001f)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    lxDrawSpatial_t spatial;
+    lxDrawBounding_t bounding;
+
+    srand(7);
+    lxVector4Set(bounding.bsphere.center,0.0f,0.0f,0.0f,0.87f);
+    lxVector4Set(bounding.bbox.min,-0.5f,-0.5f,-0.5f,0.0f);
+    lxVector4Set(bounding.bbox.max,0.5f,0.5f,0.5f,0.0f);
+
+    // objects are created interleaved, like spawning over time,
+    // which needs one re-order
+    lxDrawSpatial_init(&spatial,allocator);
+    double begin = glfwGetTime();
+    std::vector<uint32> objects(NUM_OBJECTS * NUM_PER_OBJECT);
+    for (int i = 0; i < NUM_PER_OBJECT; i++){
+      for (int o = 0; o < NUM_OBJECTS; o++){
+        uint32 parent = i ? objects[o * NUM_PER_OBJECT + rand() % i] : LUX_DRAWSPATIAL_ROOT;
+        uint32 node = lxDrawSpatial_addNode(&spatial,parent);
+        lxMatrix44 mat;
+        randomMatrix(mat);
+        lxDrawSpatial_setLocalMatrix(&spatial,node,mat);
+        lxDrawSpatial_setBounding(&spatial,node,&bounding);
+        objects[o * NUM_PER_OBJECT + i] = node;
+      }
+    }
+    double timeAdd = glfwGetTime() - begin;
+    begin = glfwGetTime();
+    lxDrawSpatial_updateTree(&spatial);
+    double timeOrder = glfwGetTime() - begin;
+    m_nodes = objects;
+
+    printf("spatial: %d nodes\n",(int)m_nodes.size());
+    printf("  add %.2f ms, first update with re-order %.2f ms, check %s\n",timeAdd * 1000.0,timeOrder * 1000.0,
+      checkTree(&spatial,m_nodes) ? "ok" : "FAILED");
+
+    int percents[3] = {1,10,100};
+    std::vector<float> mats(m_nodes.size() * 16);
+    for (size_t i = 0; i < m_nodes.size(); i++){
+      randomMatrix(&mats[i * 16]);
+    }
+    for (int p = 0; p < 3; p++){
+      size_t numChanged = m_nodes.size() * percents[p] / 100;
+      double timeSet = 0;
+      double timeUpdate = 0;
+      for (int f = 0; f < NUM_FRAMES; f++){
+        size_t offset = rand();
+        begin = glfwGetTime();
+        for (size_t i = 0; i < numChanged; i++){
+          size_t n = (offset + i * 7919) % m_nodes.size();
+          lxDrawSpatial_setLocalMatrix(&spatial,m_nodes[n],&mats[((n + f) % m_nodes.size()) * 16]);
+        }
+        double mid = glfwGetTime();
+        lxDrawSpatial_updateTree(&spatial);
+        timeUpdate += glfwGetTime() - mid;
+        timeSet += mid - begin;
+      }
+      printf("  %3d%% changed: set %.3f ms, update %.3f ms per frame, check %s\n",percents[p],
+        timeSet * 1000.0 / double(NUM_FRAMES),timeUpdate * 1000.0 / double(NUM_FRAMES),
+        checkTree(&spatial,m_nodes) ? "ok" : "FAILED");
+    }
+
+    // move some objects below others and remove every tenth
+    bool parentOk = true;
+    for (int o = 1; o < NUM_OBJECTS; o += 2){
+      parentOk &= !lxDrawSpatial_setParent(&spatial,objects[o * NUM_PER_OBJECT],objects[(o - 1) * NUM_PER_OBJECT + 50]);
+    }
+    // cycles are rejected
+    parentOk &= !!lxDrawSpatial_setParent(&spatial,objects[0],objects[NUM_PER_OBJECT + 10]);
+
+    m_nodes.clear();
+    double timeRemove = 0;
+    for (int o = 0; o < NUM_OBJECTS; o++){
+      if (o % 10 == 9){
+        begin = glfwGetTime();
+        lxDrawSpatial_remNode(&spatial,objects[o * NUM_PER_OBJECT]);
+        timeRemove += glfwGetTime() - begin;
+      }
+      else{
+        m_nodes.insert(m_nodes.end(),objects.begin() + o * NUM_PER_OBJECT,objects.begin() + (o + 1) * NUM_PER_OBJECT);
+      }
+    }
+    // removed subtrees are invalid before the update already
+    bool remOk = true;
+    for (int o = 9; o < NUM_OBJECTS; o += 10){
+      for (int i = 1; i < NUM_PER_OBJECT; i++){
+        remOk &= lxDrawSpatial_getParent(&spatial,objects[o * NUM_PER_OBJECT + i]) == LUX_DRAWSPATIAL_NONE;
+      }
+      remOk &= lxDrawSpatial_addNode(&spatial,objects[o * NUM_PER_OBJECT + 1]) == LUX_DRAWSPATIAL_NONE;
+    }
+    begin = glfwGetTime();
+    lxDrawSpatial_updateTree(&spatial);
+    double timeReorder = glfwGetTime() - begin;
+    printf("  re-parent and remove: remove %.3f ms, update %.2f ms, %u slots, check %s\n",timeRemove * 1000.0,timeReorder * 1000.0,spatial.numSlots,
+      parentOk && remOk && spatial.numSlots == m_nodes.size() + 1 && checkTree(&spatial,m_nodes) ? "ok" : "FAILED");
+
+    // same without pending re-order, object 1 is below object 0 now
+    lxDrawSpatial_remNode(&spatial,objects[0]);
+    for (int i = 0; i < NUM_PER_OBJECT * 2; i++){
+      remOk &= lxDrawSpatial_getParent(&spatial,objects[i]) == LUX_DRAWSPATIAL_NONE;
+    }
+    remOk &= lxDrawSpatial_getParent(&spatial,objects[NUM_PER_OBJECT * 2]) == LUX_DRAWSPATIAL_ROOT;
+    remOk &= lxDrawSpatial_addNode(&spatial,objects[NUM_PER_OBJECT + 1]) == LUX_DRAWSPATIAL_NONE;
+    lxDrawSpatial_updateTree(&spatial);
+    printf("  remove subtree: %u slots, check %s\n",spatial.numSlots,
+      remOk && spatial.numSlots == m_nodes.size() + 1 - NUM_PER_OBJECT * 2 ? "ok" : "FAILED");
+
+    lxDrawSpatial_deinit(&spatial);
+
+    printf("  allocation failure: check %s\n",checkAllocFailure(allocator,&bounding) ? "ok" : "FAILED");
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static SpatialTest testSpatial;
+
+//////////////////////////////////////////////////////////////////////////
+
+class DrawCullTest : public Project
+{
+private:
+  enum {
+    NUM_OBJECTS = 1000,
+    NUM_PER_OBJECT = 100,
+    NUM_ITEMS_PER_NODE = 2,
+    NUM_FRAMES = 32,
+  };
+
+public:
+  DrawCullTest()
+    : Project("drawcull","../../backend/test/")
+  {
+
+  }
+
+  static float random(){
+    return float(rand()) / float(RAND_MAX);
+  }
+
+  static void randomMatrix(float* mat, float range){
+    lxVector3 angles;
+    lxVector3 pos;
+    lxVector3Set(angles,random() * 360.0f,random() * 360.0f,random() * 360.0f);
+    lxVector3Set(pos,(random() - 0.5f) * range,(random() - 0.5f) * range,(random() - 0.5f) * range);
+    lxMatrix44Identity(mat);
+    lxMatrix44FromEulerZYXdeg(mat,angles);
+    lxMatrix44SetTranslation(mat,pos);
+  }
+
+  static bool isVisible(lxFrustumCPTR frustum, const lxDrawBounding_t* bounding){
+    return !lxFrustum_checkSphere(frustum,&bounding->bsphere) && !lxFrustum_checkBoundingBox(frustum,&bounding->bbox);
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    lxDrawSpatial_t spatial;
+    lxDrawBounding_t bounding;
+    lxDrawItem_t item;
+
+    srand(11);
+    memset(&item,0,sizeof(item));
+    lxVector4Set(bounding.bbox.min,-0.5f,-0.25f,-0.5f,0.0f);
+    lxVector4Set(bounding.bbox.max,0.5f,0.25f,0.5f,0.0f);
+    lxBoundingBox_toSphere(&bounding.bbox,&bounding.bsphere);
+
+    // objects spread over the world, nodes and items close to them
+    lxDrawSpatial_init(&spatial,allocator);
+    std::vector<uint32> nodes(NUM_OBJECTS * NUM_PER_OBJECT);
+    std::vector<uint32> items;
+    for (int o = 0; o < NUM_OBJECTS; o++){
+      for (int i = 0; i < NUM_PER_OBJECT; i++){
+        uint32 parent = i ? nodes[o * NUM_PER_OBJECT + rand() % i] : LUX_DRAWSPATIAL_ROOT;
+        uint32 node = lxDrawSpatial_addNode(&spatial,parent);
+        lxMatrix44 mat;
+        randomMatrix(mat,i ? 2.0f : 100.0f);
+        lxDrawSpatial_setLocalMatrix(&spatial,node,mat);
+        for (int n = 0; n < NUM_ITEMS_PER_NODE; n++){
+          item.materialID = (uint32)items.size();
+          items.push_back(lxDrawSpatial_addItem(&spatial,node,&item,&bounding));
+        }
+        nodes[o * NUM_PER_OBJECT + i] = node;
+      }
+    }
+    lxDrawSpatial_updateTree(&spatial);
+
+    std::vector<uint32>       visible(items.size());
+    std::vector<lxDrawItem_t> copies(items.size());
+    std::vector<byte>         marked(spatial.numItemIDs);
+    std::vector<float>        mats(16 * nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++){
+      randomMatrix(&mats[i * 16],2.0f);
+    }
+
+    lxMatrix44 proj;
+    lxMatrix44Perspective(proj,60.0f,0.1f,80.0f,16.0f/9.0f);
+    double timeCull = 0.0;
+    double timeCopy = 0.0;
+    double timeBrute = 0.0;
+    double numVisible = 0.0;
+    bool   ok = true;
+    for (int f = 0; f < NUM_FRAMES; f++){
+      float angle = float(f) * LUX_MUL_TWOPI / float(NUM_FRAMES);
+      lxVector3 from = {40.0f * cosf(angle),10.0f,40.0f * sinf(angle)};
+      lxVector3 to = {0.0f,0.0f,0.0f};
+      lxVector3 up = {0.0f,1.0f,0.0f};
+      lxMatrix44 view;
+      lxMatrix44 viewproj;
+      lxFrustum_t frustum;
+
+      lxMatrix44LookAt(view,from,to,up);
+      lxMatrix44MultiplyFull(viewproj,proj,view);
+      lxFrustum_update(&frustum,viewproj);
+
+      // every other frame some nodes move, so culling runs on
+      // partially refitted trees
+      if (f & 1){
+        for (size_t i = 0; i < nodes.size() / 100; i++){
+          size_t n = (size_t(rand()) * 7919) % nodes.size();
+          if (n % NUM_PER_OBJECT){
+            lxDrawSpatial_setLocalMatrix(&spatial,nodes[n],&mats[n * 16]);
+          }
+        }
+        lxDrawSpatial_updateTree(&spatial);
+      }
+
+      double begin = glfwGetTime();
+      uint32 count = lxDrawSpatial_getVisibleIDs(&spatial,&frustum,&visible[0],(uint32)visible.size());
+      timeCull += glfwGetTime() - begin;
+
+      begin = glfwGetTime();
+      uint32 countCopy = lxDrawSpatial_getVisibleItems(&spatial,&frustum,&copies[0],(uint32)copies.size());
+      timeCopy += glfwGetTime() - begin;
+
+      std::fill(marked.begin(),marked.end(),0);
+      for (uint32 i = 0; i < count; i++){
+        marked[visible[i]] = 1;
+        ok &= copies[i].materialID == visible[i] && copies[i].spatialNode == nodes[visible[i] / NUM_ITEMS_PER_NODE];
+      }
+      ok &= count == countCopy;
+
+      begin = glfwGetTime();
+      uint32 countBrute = 0;
+      for (size_t i = 0; i < items.size(); i++){
+        bool vis = isVisible(&frustum,lxDrawSpatial_getItemWorldBounding(&spatial,items[i]));
+        countBrute += vis ? 1 : 0;
+        ok &= vis == (marked[items[i]] != 0);
+      }
+      timeBrute += glfwGetTime() - begin;
+      ok &= countBrute == count;
+      numVisible += double(count);
+    }
+
+    double numItems = double(items.size());
+    printf("drawcull: %d nodes, %d items\n",(int)nodes.size(),(int)items.size());
+    printf("  visible %.0f avg\n",numVisible / double(NUM_FRAMES));
+    printf("  hierarchical ids   %.3f ms, %.0f items/ms\n",timeCull * 1000.0 / double(NUM_FRAMES),
+      numItems * double(NUM_FRAMES) / (timeCull * 1000.0));
+    printf("  hierarchical items %.3f ms, %.0f items/ms\n",timeCopy * 1000.0 / double(NUM_FRAMES),
+      numItems * double(NUM_FRAMES) / (timeCopy * 1000.0));
+    printf("  brute force        %.3f ms, %.0f items/ms\n",timeBrute * 1000.0 / double(NUM_FRAMES),
+      numItems * double(NUM_FRAMES) / (timeBrute * 1000.0));
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+
+    lxDrawSpatial_deinit(&spatial);
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static DrawCullTest testDrawCull;
+
+//////////////////////////////////////////////////////////////////////////
+
+class DrawViewsTest : public Project
+{
+private:
+  enum {
+    NUM_OBJECTS = 1000,
+    NUM_PER_OBJECT = 100,
+    NUM_ITEMS_PER_NODE = 2,
+    NUM_VIEWS = 8,
+    NUM_REPEATS = 8,
+  };
+
+public:
+  DrawViewsTest()
+    : Project("drawviews","../../backend/test/")
+  {
+
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    lxDrawSpatial_t spatial;
+    lxDrawBounding_t bounding;
+    lxDrawItem_t item;
+
+    srand(13);
+    memset(&item,0,sizeof(item));
+    lxVector4Set(bounding.bbox.min,-0.5f,-0.25f,-0.5f,0.0f);
+    lxVector4Set(bounding.bbox.max,0.5f,0.25f,0.5f,0.0f);
+    lxBoundingBox_toSphere(&bounding.bbox,&bounding.bsphere);
+
+    // same scene as drawcull
+    lxDrawSpatial_init(&spatial,allocator);
+    std::vector<uint32> nodes(NUM_OBJECTS * NUM_PER_OBJECT);
+    for (int o = 0; o < NUM_OBJECTS; o++){
+      for (int i = 0; i < NUM_PER_OBJECT; i++){
+        uint32 parent = i ? nodes[o * NUM_PER_OBJECT + rand() % i] : LUX_DRAWSPATIAL_ROOT;
+        uint32 node = lxDrawSpatial_addNode(&spatial,parent);
+        lxMatrix44 mat;
+        DrawCullTest::randomMatrix(mat,i ? 2.0f : 100.0f);
+        lxDrawSpatial_setLocalMatrix(&spatial,node,mat);
+        for (int n = 0; n < NUM_ITEMS_PER_NODE; n++){
+          item.materialID = spatial.numItems;
+          lxDrawSpatial_addItem(&spatial,node,&item,&bounding);
+        }
+        nodes[o * NUM_PER_OBJECT + i] = node;
+      }
+    }
+    lxDrawSpatial_updateTree(&spatial);
+
+    // views look from the center into different directions,
+    // like the faces of a cubemap or shadow cascades
+    uint32 numItems = spatial.numItems;
+    lxFrustum_t frustums[NUM_VIEWS];
+    lxMatrix44 proj;
+    lxMatrix44Perspective(proj,90.0f,0.1f,80.0f,1.0f);
+    for (int v = 0; v < NUM_VIEWS; v++){
+      float angle = float(v) * LUX_MUL_TWOPI / float(NUM_VIEWS);
+      lxVector3 from = {0.0f,5.0f,0.0f};
+      lxVector3 to = {cosf(angle),5.0f,sinf(angle)};
+      lxVector3 up = {0.0f,1.0f,0.0f};
+      lxMatrix44 view;
+      lxMatrix44 viewproj;
+      lxMatrix44LookAt(view,from,to,up);
+      lxMatrix44MultiplyFull(viewproj,proj,view);
+      lxFrustum_update(&frustums[v],viewproj);
+    }
+
+    std::vector<uint32>       reference(size_t(numItems) * NUM_VIEWS);
+    std::vector<uint32>       referenceCounts(NUM_VIEWS);
+    std::vector<uint32>       ids(size_t(numItems) * NUM_VIEWS);
+    std::vector<lxDrawItem_t> copies(size_t(numItems) * 2);
+    for (int v = 0; v < NUM_VIEWS; v++){
+      referenceCounts[v] = lxDrawSpatial_getVisibleIDs(&spatial,&frustums[v],&reference[v * numItems],numItems);
+    }
+
+    printf("drawviews: %d nodes, %d items\n",(int)nodes.size(),(int)numItems);
+    bool ok = true;
+    for (int views = 1; views <= NUM_VIEWS; views *= 2){
+      double timeSingle = 0.0;
+      printf("  %d views\n",views);
+      for (int t = 1; t <= 16; t *= 2){
+        lxJobPoolPTR pool = lxJobPool_new(allocator,t);
+        lxDrawSpatialView_t cullviews[NUM_VIEWS];
+        for (int v = 0; v < views; v++){
+          cullviews[v].frustum = &frustums[v];
+          cullviews[v].items = NULL;
+          cullviews[v].ids = &ids[v * numItems];
+          cullviews[v].maxItems = numItems;
+          cullviews[v].numItems = 0;
+        }
+
+        double begin = glfwGetTime();
+        for (int r = 0; r < NUM_REPEATS; r++){
+          lxDrawSpatial_cullViews(&spatial,pool,cullviews,views);
+        }
+        double time = (glfwGetTime() - begin) / double(NUM_REPEATS);
+        if (t == 1){
+          timeSingle = time;
+        }
+
+        for (int v = 0; v < views; v++){
+          ok &= cullviews[v].numItems == referenceCounts[v];
+          ok &= memcmp(&ids[v * numItems],&reference[v * numItems],sizeof(uint32) * referenceCounts[v]) == 0;
+        }
+        printf("    %2d threads %.3f ms, scaling %.2f\n",t,time * 1000.0,timeSingle / time);
+
+        lxJobPool_delete(pool);
+      }
+    }
+
+    // item copies and truncation at maxItems
+    {
+      lxJobPoolPTR pool = lxJobPool_new(allocator,4);
+      lxDrawSpatialView_t cullviews[2];
+      cullviews[0].frustum = &frustums[0];
+      cullviews[0].items = &copies[0];
+      cullviews[0].ids = NULL;
+      cullviews[0].maxItems = numItems;
+      cullviews[1].frustum = &frustums[1];
+      cullviews[1].items = &copies[numItems];
+      cullviews[1].ids = NULL;
+      cullviews[1].maxItems = referenceCounts[1] / 3;
+      lxDrawSpatial_cullViews(&spatial,pool,cullviews,2);
+      ok &= cullviews[0].numItems == referenceCounts[0];
+      ok &= cullviews[1].numItems == referenceCounts[1] / 3;
+      for (int v = 0; v < 2; v++){
+        for (uint32 i = 0; i < cullviews[v].numItems; i++){
+          ok &= cullviews[v].items[i].materialID == reference[v * numItems + i];
+        }
+      }
+      lxJobPool_delete(pool);
+    }
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+
+    lxDrawSpatial_deinit(&spatial);
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static DrawViewsTest testDrawViews;
+
+//////////////////////////////////////////////////////////////////////////
+
+class DrawQueueTest : public Project
+{
+private:
+  enum {
+    MAX_ITEMS = 500000,
+    NUM_FRAMES = 16,
+  };
+
+public:
+  DrawQueueTest()
+    : Project("drawqueue","../../backend/test/")
+  {
+
+  }
+
+  static bool checkOrder(const lxDrawQueue_t* queue, const uint32* sorted){
+    bool ok = true;
+    for (uint32 i = 1; i < queue->numItems; i++){
+      uint64 prev = lxDrawQueue_getKey(queue,sorted[i-1]);
+      uint64 cur  = lxDrawQueue_getKey(queue,sorted[i]);
+      // stable for equal keys
+      ok &= prev < cur || (prev == cur && sorted[i-1] < sorted[i]);
+    }
+    return ok;
+  }
+
+  void runLayout(lxMemoryAllocatorPTR allocator, const char* name, const lxDrawKeyLayout_t* layout,
+    const std::vector<lxDrawItem_t>& items, const std::vector<lxDrawKeyInput_t>& inputs, bool& ok)
+  {
+    lxDrawQueue_t queue;
+    static const uint32 counts[] = {50000,100000,250000,500000};
+
+    ok &= !lxDrawQueue_init(&queue,allocator,layout);
+    printf("  %s, %d bits\n",name,queue.keyBits);
+    for (size_t c = 0; c < sizeof(counts)/sizeof(counts[0]); c++){
+      uint32 count = counts[c];
+      double timeBuild = 0.0;
+      double timeSort = 0.0;
+      lxDrawQueue_reserve(&queue,count);
+      for (int f = 0; f < NUM_FRAMES; f++){
+        // frames start at different items, so the previous
+        // order is not reused
+        uint32 offset = (uint32)(f * 997) % (MAX_ITEMS - count + 1);
+        lxDrawQueue_reset(&queue);
+
+        double begin = glfwGetTime();
+        lxDrawQueue_addItems(&queue,&items[offset],&inputs[offset],count);
+        timeBuild += glfwGetTime() - begin;
+
+        begin = glfwGetTime();
+        const uint32* sorted = lxDrawQueue_sort(&queue);
+        timeSort += glfwGetTime() - begin;
+
+        if (f == 0){
+          ok &= checkOrder(&queue,sorted);
+          ok &= lxDrawQueue_getSorted(&queue,0) == &items[offset + sorted[0]];
+        }
+      }
+      printf("    %6d items: build %.3f ms, sort %.3f ms\n",count,
+        timeBuild * 1000.0 / double(NUM_FRAMES),timeSort * 1000.0 / double(NUM_FRAMES));
+    }
+    lxDrawQueue_deinit(&queue);
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    std::vector<lxDrawItem_t>     items(MAX_ITEMS);
+    std::vector<lxDrawKeyInput_t> inputs(MAX_ITEMS);
+    bool ok = true;
+
+    srand(17);
+    memset(&items[0],0,sizeof(lxDrawItem_t) * MAX_ITEMS);
+    for (int i = 0; i < MAX_ITEMS; i++){
+      items[i].materialID = rand() % 2000;
+      items[i].geometryID = rand() % 5000;
+      inputs[i].layer = rand() % 4;
+      inputs[i].shader = rand() % 200;
+      inputs[i].translucent = rand() % 10 == 0;
+      inputs[i].depth = float(rand()) / float(RAND_MAX) * 1000.0f;
+    }
+
+    printf("drawqueue:\n");
+
+    // state sorted opaque, depth sorted translucent
+    lxDrawKeyLayout_t layout;
+    memset(&layout,0,sizeof(layout));
+    layout.fields[0].field = LUX_DRAWKEY_LAYER;       layout.fields[0].bits = 4;
+    layout.fields[1].field = LUX_DRAWKEY_TRANSLUCENT; layout.fields[1].bits = 1;
+    layout.fields[2].field = LUX_DRAWKEY_DEPTH;       layout.fields[2].bits = 16;
+    layout.fields[3].field = LUX_DRAWKEY_SHADER;      layout.fields[3].bits = 12;
+    layout.fields[4].field = LUX_DRAWKEY_MATERIAL;    layout.fields[4].bits = 16;
+    layout.fields[5].field = LUX_DRAWKEY_GEOMETRY;    layout.fields[5].bits = 15;
+    layout.numFields = 6;
+    layout.opaqueDepth = LUX_DRAWDEPTH_FRONTTOBACK;
+    layout.translucentDepth = LUX_DRAWDEPTH_BACKTOFRONT;
+    layout.depthNear = 0.0f;
+    layout.depthFar = 1000.0f;
+    runLayout(allocator,"full",&layout,items,inputs,ok);
+
+    // depth sorting within translucent: farther first
+    {
+      lxDrawQueue_t queue;
+      lxDrawQueue_init(&queue,allocator,&layout);
+      lxDrawKeyInput_t near = inputs[0];
+      lxDrawKeyInput_t far = inputs[0];
+      near.depth = 10.0f;
+      far.depth = 900.0f;
+      near.translucent = far.translucent = LUX_TRUE;
+      ok &= lxDrawQueue_makeKey(&queue,&items[0],&far) < lxDrawQueue_makeKey(&queue,&items[0],&near);
+      near.translucent = far.translucent = LUX_FALSE;
+      ok &= lxDrawQueue_makeKey(&queue,&items[0],&far) > lxDrawQueue_makeKey(&queue,&items[0],&near);
+      lxDrawQueue_deinit(&queue);
+    }
+
+    // fits 32 bits, single radix sort
+    layout.fields[0].field = LUX_DRAWKEY_LAYER;       layout.fields[0].bits = 2;
+    layout.fields[1].field = LUX_DRAWKEY_TRANSLUCENT; layout.fields[1].bits = 1;
+    layout.fields[2].field = LUX_DRAWKEY_SHADER;      layout.fields[2].bits = 8;
+    layout.fields[3].field = LUX_DRAWKEY_MATERIAL;    layout.fields[3].bits = 11;
+    layout.fields[4].field = LUX_DRAWKEY_DEPTH;       layout.fields[4].bits = 10;
+    layout.numFields = 5;
+    runLayout(allocator,"state",&layout,items,inputs,ok);
+
+    // invalid layouts
+    {
+      lxDrawQueue_t queue;
+      layout.fields[4].field = LUX_DRAWKEY_SHADER;
+      ok &= lxDrawQueue_init(&queue,allocator,&layout) == LUX_TRUE;
+      layout.fields[4].field = LUX_DRAWKEY_GEOMETRY;
+      layout.fields[4].bits = 32;
+      layout.fields[3].bits = 32;
+      ok &= lxDrawQueue_init(&queue,allocator,&layout) == LUX_TRUE;
+      layout.numFields = -1;
+      ok &= lxDrawQueue_init(&queue,allocator,&layout) == LUX_TRUE;
+      layout.numFields = LUX_DRAWKEY_FIELDS + 1;
+      ok &= lxDrawQueue_init(&queue,allocator,&layout) == LUX_TRUE;
+    }
+
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static DrawQueueTest testDrawQueue;
+
+//////////////////////////////////////////////////////////////////////////
+
+class DrawBatchTest : public Project
+{
+private:
+  enum {
+    NUM_OBJECTS = 10000,
+    NUM_GEOMETRIES = 32,
+    NUM_MATERIALS = 8,
+    NUM_FRAMES = 32,
+  };
+
+public:
+  DrawBatchTest()
+    : Project("drawbatch","../../backend/test/")
+  {
+
+  }
+
+  // checks runs and instance data of the recorded draws
+  static bool checkBatches(const lxDrawBatch_t* batches, uint32 numBatches, const float* instances,
+    const lxDrawItem_t* const* items, const uint32* order, uint32 numItems)
+  {
+    bool ok = true;
+    uint32 next = 0;
+    for (uint32 b = 0; b < numBatches; b++){
+      const lxDrawBatch_t& batch = batches[b];
+      ok &= batch.firstInstance == next;
+      for (uint32 i = 0; i < batch.drawinfo.instanceCount; i++){
+        const lxDrawItem_t* item = items[order ? order[next + i] : next + i];
+        ok &= item->geometryID == batch.item->geometryID && item->materialID == batch.item->materialID;
+        ok &= item->itemLevel.datas == batch.item->itemLevel.datas;
+        ok &= memcmp(&instances[(next + i) * 16],lxDrawSpatial_getWorldMatrix(item->spatial,item->spatialNode),sizeof(float) * 16) == 0;
+      }
+      next += batch.drawinfo.instanceCount;
+    }
+    return ok && next == numItems;
+  }
+
+  int onInit(int argc, const char** argv) {
+    lxMemoryGenericPTR memgeneric = lxMemoryGeneric_new(lxMemoryGenericDescr_default());
+    lxMemoryAllocatorPTR allocator = lxMemoryGeneric_allocator(memgeneric);
+    lxDrawSpatial_t spatial;
+    lxDrawBounding_t bounding;
+    bool ok = true;
+
+    srand(19);
+    lxVector4Set(bounding.bbox.min,-0.5f,-0.5f,-0.5f,0.0f);
+    lxVector4Set(bounding.bbox.max,0.5f,0.5f,0.5f,0.0f);
+    lxBoundingBox_toSphere(&bounding.bbox,&bounding.bsphere);
+
+    // objects of a few geometry and material combinations,
+    // every tenth has its own parameters and cannot be merged
+    std::vector<lxDrawItem_t>     items(NUM_OBJECTS);
+    std::vector<lxDrawKeyInput_t> inputs(NUM_OBJECTS);
+    std::vector<float>            params(NUM_OBJECTS);
+    void* paramDatas[NUM_OBJECTS];
+    lxDrawSpatial_init(&spatial,allocator);
+    memset(&items[0],0,sizeof(lxDrawItem_t) * NUM_OBJECTS);
+    memset(&inputs[0],0,sizeof(lxDrawKeyInput_t) * NUM_OBJECTS);
+    for (int i = 0; i < NUM_OBJECTS; i++){
+      lxMatrix44 mat;
+      lxDrawItem_t& item = items[i];
+      item.geometryID = rand() % NUM_GEOMETRIES;
+      item.materialID = rand() % NUM_MATERIALS;
+      item.drawinfo.primitive = LUXGL_TRIANGLES;
+      item.drawinfo.primCount = 36 + item.geometryID * 3;
+      item.spatial = &spatial;
+      item.spatialNode = lxDrawSpatial_addNode(&spatial,LUX_DRAWSPATIAL_ROOT);
+      if (i % 10 == 0){
+        paramDatas[i] = &params[i];
+        item.itemLevel.numParams = 1;
+        item.itemLevel.datas = &paramDatas[i];
+        // keeps them out of the runs of shared items
+        inputs[i].shader = 1;
+      }
+      DrawCullTest::randomMatrix(mat,100.0f);
+      lxDrawSpatial_setLocalMatrix(&spatial,item.spatialNode,mat);
+      lxDrawSpatial_setBounding(&spatial,item.spatialNode,&bounding);
+      inputs[i].depth = float(rand()) / float(RAND_MAX) * 100.0f;
+    }
+    lxDrawSpatial_updateTree(&spatial);
+
+    lxDrawKeyLayout_t layout;
+    memset(&layout,0,sizeof(layout));
+    layout.fields[0].field = LUX_DRAWKEY_MATERIAL;  layout.fields[0].bits = 8;
+    layout.fields[1].field = LUX_DRAWKEY_GEOMETRY;  layout.fields[1].bits = 8;
+    layout.fields[2].field = LUX_DRAWKEY_SHADER;    layout.fields[2].bits = 1;
+    layout.fields[3].field = LUX_DRAWKEY_DEPTH;     layout.fields[3].bits = 16;
+    layout.numFields = 4;
+    layout.depthFar = 100.0f;
+
+    lxDrawQueue_t queue;
+    lxDrawQueue_init(&queue,allocator,&layout);
+    std::vector<lxDrawBatch_t>  batches(NUM_OBJECTS);
+    std::vector<float>          instances(NUM_OBJECTS * 16);
+
+    // submission order, few neighbours match
+    lxDrawQueue_addItems(&queue,&items[0],&inputs[0],NUM_OBJECTS);
+    uint32 numUnsorted = lxDrawBatch_build(&batches[0],&instances[0],queue.items,NULL,NUM_OBJECTS);
+    ok &= checkBatches(&batches[0],numUnsorted,&instances[0],queue.items,NULL,NUM_OBJECTS);
+
+    double timeSort = 0.0;
+    double timeBatch = 0.0;
+    uint32 numBatches = 0;
+    for (int f = 0; f < NUM_FRAMES; f++){
+      lxDrawQueue_reset(&queue);
+
+      double begin = glfwGetTime();
+      lxDrawQueue_addItems(&queue,&items[0],&inputs[0],NUM_OBJECTS);
+      const uint32* sorted = lxDrawQueue_sort(&queue);
+      timeSort += glfwGetTime() - begin;
+
+      begin = glfwGetTime();
+      numBatches = lxDrawBatch_build(&batches[0],&instances[0],queue.items,sorted,NUM_OBJECTS);
+      timeBatch += glfwGetTime() - begin;
+
+      if (f == 0){
+        ok &= checkBatches(&batches[0],numBatches,&instances[0],queue.items,sorted,NUM_OBJECTS);
+      }
+    }
+
+    // 1 per item with own parameters, 1 per combination for the rest
+    uint32 numShared = 0;
+    {
+      std::vector<byte> combos(NUM_GEOMETRIES * NUM_MATERIALS);
+      for (int i = 0; i < NUM_OBJECTS; i++){
+        if (i % 10){
+          combos[items[i].geometryID * NUM_MATERIALS + items[i].materialID] = 1;
+        }
+      }
+      for (size_t c = 0; c < combos.size(); c++){
+        numShared += combos[c];
+      }
+    }
+    ok &= numBatches == numShared + NUM_OBJECTS / 10;
+
+    // same batches written through a mapped buffer range,
+    // relies on the context of the test window
+    {
+      lxgContext_t  ctx;
+      lxgBuffer_t   buffer;
+      uint          instanceBytes = NUM_OBJECTS * sizeof(float) * 16;
+      uint          offset = 256 * sizeof(float) * 16;
+      std::vector<lxDrawBatch_t>  bufferBatches(NUM_OBJECTS);
+      std::vector<float>          bufferInstances(NUM_OBJECTS * 16);
+
+      lxgContext_init(&ctx);
+      lxgBuffer_init(&buffer,&ctx,LUXGL_STREAM_DRAW,offset + instanceBytes,NULL);
+
+      uint32 numBuffer = lxDrawBatch_buildBuffer(&bufferBatches[0],&buffer,offset,queue.items,queue.sorted,NUM_OBJECTS);
+      ok &= numBuffer == numBatches && !buffer.mapped;
+      const void* written = lxgBuffer_mapRange(&buffer,offset,instanceBytes,LUXGFX_ACCESS_READ,LUX_FALSE,LUX_FALSE,NULL);
+      if (written){
+        memcpy(&bufferInstances[0],written,instanceBytes);
+        lxgBuffer_unmap(&buffer);
+      }
+      ok &= written != NULL;
+      ok &= checkBatches(&bufferBatches[0],numBuffer,&bufferInstances[0],queue.items,queue.sorted,NUM_OBJECTS);
+      // range past the end is not mapped
+      ok &= lxDrawBatch_buildBuffer(&bufferBatches[0],&buffer,offset + 64,queue.items,queue.sorted,NUM_OBJECTS) == 0;
+      ok &= lxDrawBatch_buildBuffer(&bufferBatches[0],&buffer,offset,queue.items,queue.sorted,0) == 0;
+      ok &= !buffer.mapped;
+
+      lxgBuffer_deinit(&buffer,&ctx);
+    }
+
+    printf("drawbatch: %d objects, %d geometries, %d materials\n",NUM_OBJECTS,NUM_GEOMETRIES,NUM_MATERIALS);
+    printf("  draws unsorted %d, sorted %d (%.1fx fewer)\n",numUnsorted,numBatches,double(NUM_OBJECTS) / double(numBatches));
+    printf("  key+sort %.3f ms, batch %.3f ms\n",timeSort * 1000.0 / double(NUM_FRAMES),timeBatch * 1000.0 / double(NUM_FRAMES));
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+
+    lxDrawQueue_deinit(&queue);
+    lxDrawSpatial_deinit(&spatial);
+    lxMemoryGeneric_delete(memgeneric);
+    return 1;
+  }
+
+};
+
+static DrawBatchTest testDrawBatch;
+
+//////////////////////////////////////////////////////////////////////////
+
+class ShaderDirtyTest : public Project
+{
+private:
+  enum {
+    NUM_DRAWS = 100000,
+    NUM_MATERIALS = 64,
+    NUM_FRAMES = 8,
+  };
+
+  enum Params {
+    PARAM_VIEWPROJ,
+    PARAM_DIFFUSE,
+    PARAM_SPECULAR,
+    PARAM_TEXTURE,
+    PARAM_WORLD,
+    PARAM_TINT,
+    NUM_PARAMS,
+    // diffuse is used by two stages
+    NUM_PROGPARAMS = NUM_PARAMS + 1,
+  };
+
+  lxShaderParameter_t     m_params[NUM_PARAMS];
+  lxgProgramParameter_t   m_progParams[NUM_PROGPARAMS];
+  lxgProgramParameter_t*  m_progParamPtrs[NUM_PROGPARAMS];
+  lxShaderProgram_t       m_shader;
+
+  float   m_viewproj[16];
+  float   m_materials[NUM_MATERIALS][2][4];
+  float   m_tints[NUM_DRAWS][4];
+  float   m_transforms[NUM_DRAWS][16];
+  int     m_textures[16];
+  // world matrix is computed per draw into the same memory
+  float   m_scratch[16];
+
+  struct Gpu {
+    byte    data[NUM_PROGPARAMS][64];
+  };
+
+public:
+  ShaderDirtyTest()
+    : Project("shaderdirty","../../backend/test/")
+  {
+
+  }
+
+  static uint paramSize(const lxgProgramParameter_t* param){
+    switch(param->type){
+    case LUXGL_PARAM_MAT4:    return 64;
+    case LUXGL_PARAM_FLOAT4:  return 16;
+    default:                  return sizeof(void*);
+    }
+  }
+
+  void initShader(){
+    static const lxGLParameterType_t types[NUM_PARAMS] = {
+      LUXGL_PARAM_MAT4,LUXGL_PARAM_FLOAT4,LUXGL_PARAM_FLOAT4,LUXGL_PARAM_SAMPLER_2D,LUXGL_PARAM_MAT4,LUXGL_PARAM_FLOAT4,
+    };
+    uint prog = 0;
+    memset(m_params,0,sizeof(m_params));
+    memset(m_progParams,0,sizeof(m_progParams));
+    for (uint i = 0; i < NUM_PARAMS; i++){
+      uint count = i == PARAM_DIFFUSE ? 2 : 1;
+      m_params[i].type = types[i];
+      m_params[i].progOffset = prog;
+      m_params[i].progCount = count;
+      for (uint n = 0; n < count; n++, prog++){
+        m_progParams[prog].type = types[i];
+        m_progParams[prog].uniform.count = 1;
+        m_progParamPtrs[prog] = &m_progParams[prog];
+      }
+    }
+    memset(&m_shader,0,sizeof(m_shader));
+    m_shader.numParams = NUM_PARAMS;
+    m_shader.params = m_params;
+    m_shader.numProgParams = NUM_PROGPARAMS;
+    m_shader.progParams = m_progParamPtrs;
+    m_shader.hasMulti = LUX_TRUE;
+  }
+
+  void initScene(){
+    srand(23);
+    for (int i = 0; i < 16; i++){
+      m_viewproj[i] = float(i);
+      m_textures[i] = i;
+    }
+    // many material instances, few distinct values
+    for (int m = 0; m < NUM_MATERIALS; m++){
+      for (int c = 0; c < 4; c++){
+        m_materials[m][0][c] = float((m / 8) % 4) * 0.25f;
+        m_materials[m][1][c] = float(m % 2);
+      }
+    }
+    for (int i = 0; i < NUM_DRAWS; i++){
+      // static objects at the origin come in runs
+      bool identity = (i / 16) % 4 == 0;
+      for (int c = 0; c < 16; c++){
+        m_transforms[i][c] = identity ? (c % 5 == 0 ? 1.0f : 0.0f) : float(rand());
+      }
+      for (int c = 0; c < 4; c++){
+        m_tints[i][c] = float((i / 32) % 3);
+      }
+    }
+  }
+
+  // returns uploaded program parameters, counts uploads of values
+  // already set and draws that saw stale values
+  uint runStream(lxShaderUpdate_t* update, Gpu* gpu, uint& redundant, uint& stale){
+    lxShaderIndex baseIndices[NUM_PARAMS] = {PARAM_VIEWPROJ,PARAM_DIFFUSE,PARAM_SPECULAR,PARAM_TEXTURE,PARAM_WORLD,PARAM_TINT};
+    lxShaderIndex mtlIndices[3] = {PARAM_DIFFUSE,PARAM_SPECULAR,PARAM_TEXTURE};
+    lxShaderIndex objIndices[2] = {PARAM_WORLD,PARAM_TINT};
+    void* baseDatas[NUM_PARAMS] = {m_viewproj,m_materials[0][0],m_materials[0][1],&m_textures[0],m_scratch,m_tints[0]};
+    uint uploads = 0;
+    int draw = 0;
+
+    memcpy(m_scratch,m_transforms[0],sizeof(m_scratch));
+    lxShaderUpdate_pushData(update,NUM_PARAMS,baseIndices,baseDatas);
+    for (int m = 0; m < NUM_MATERIALS; m++){
+      void* mtlDatas[3] = {m_materials[m][0],m_materials[m][1],&m_textures[m % 2]};
+      lxShaderUpdate_pushData(update,3,mtlIndices,mtlDatas);
+      for (int end = (m + 1) * NUM_DRAWS / NUM_MATERIALS; draw < end; draw++){
+        void* objDatas[2] = {m_scratch,m_tints[draw]};
+        memcpy(m_scratch,m_transforms[draw],sizeof(m_scratch));
+        lxShaderUpdate_pushData(update,2,objIndices,objDatas);
+
+        uint num = lxShaderUpdate_buildProgramParams(update);
+        uploads += num;
+        if (gpu){
+          // null apply
+          for (uint i = 0; i < num; i++){
+            redundant += memcmp(gpu->data[update->progParams[i] - m_progParams],update->progDatas[i],paramSize(update->progParams[i])) == 0;
+            memcpy(gpu->data[update->progParams[i] - m_progParams],update->progDatas[i],paramSize(update->progParams[i]));
+          }
+          // every program parameter must hold the current value
+          bool same = true;
+          for (uint i = 0; i < NUM_PARAMS; i++){
+            const void* cur = update->levelDatas[update->level][i];
+            for (uint n = 0; n < m_params[i].progCount; n++){
+              const lxgProgramParameter_t* param = &m_progParams[m_params[i].progOffset + n];
+              same &= memcmp(gpu->data[param - m_progParams],cur,paramSize(param)) == 0;
+            }
+          }
+          stale += same ? 0 : 1;
+        }
+        lxShaderUpdate_popData(update);
+      }
+      lxShaderUpdate_popData(update);
+    }
+    lxShaderUpdate_popData(update);
+
+    return uploads;
+  }
+
+  void runMode(const char* name, booln content, bool expectStale, uint& redundant, bool& ok){
+    lxShaderUpdate_t update;
+    Gpu gpu;
+    uint stale = 0;
+    uint uploads;
+
+    lxShaderUpdate_init(&update,&m_shader);
+    lxShaderUpdate_trackContent(&update,content);
+    std::vector<byte> mem(lxShaderUpdate_getMemSize(&update));
+    lxShaderUpdate_initMem(&update,mem.size(),&mem[0]);
+
+    memset(&gpu,0,sizeof(gpu));
+    redundant = 0;
+    uploads = runStream(&update,&gpu,redundant,stale);
+    ok &= update.level == -1;
+    ok &= expectStale ? stale > 0 : stale == 0;
+
+    uint dummy = 0;
+    double begin = glfwGetTime();
+    for (int f = 0; f < NUM_FRAMES; f++){
+      runStream(&update,NULL,dummy,dummy);
+    }
+    double time = (glfwGetTime() - begin) / double(NUM_FRAMES);
+
+    printf("  %-8s uploads %7d, redundant %7d, stale draws %6d, %.3f ms (%.1f ns/draw), %d bytes\n",name,uploads,redundant,stale,
+      time * 1000.0,time * 1e9 / double(NUM_DRAWS),(int)mem.size());
+  }
+
+  int onInit(int argc, const char** argv) {
+    bool ok = true;
+    uint redundantPointer;
+    uint redundantContent;
+
+    initShader();
+    initScene();
+
+    printf("shaderdirty: %d draws, %d materials\n",NUM_DRAWS,NUM_MATERIALS);
+    // pointer compare misses the in-place world matrix
+    runMode("pointer",LUX_FALSE,true,redundantPointer,ok);
+    runMode("content",LUX_TRUE,false,redundantContent,ok);
+    ok &= redundantContent < redundantPointer;
+    printf("  content tracking avoided %d uploads\n",redundantPointer - redundantContent);
+
+    // single program parameter per shader parameter
+    m_params[PARAM_DIFFUSE].progCount = 1;
+    m_shader.hasMulti = LUX_FALSE;
+    runMode("single",LUX_TRUE,false,redundantContent,ok);
+
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+    return 1;
+  }
+
+};
+
+static ShaderDirtyTest testShaderDirty;
+
+//////////////////////////////////////////////////////////////////////////
+
+class ShaderBlockTest : public Project
+{
+private:
+  enum {
+    NUM_DRAWS = 100000,
+    NUM_FRAMES = 8,
+    // typical GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    RING_ALIGN = 256,
+  };
+
+public:
+  ShaderBlockTest()
+    : Project("shaderblock","../../backend/test/")
+  {
+
+  }
+
+  // reads back every component with std140 strides
+  static bool checkPacked(const lxShaderBlockEntry_t* entry, const float* src, const float* block){
+    uint stride = entry->vectors == 1 ? 0 : 16;
+    uint rows = entry->vectorSize / 4;
+    bool ok = true;
+    for (uint v = 0; v < entry->vectors; v++){
+      for (uint r = 0; r < rows; r++){
+        ok &= block[(entry->offset + v * stride) / 4 + r] == src[v * rows + r];
+      }
+    }
+    return ok;
+  }
+
+  void testLayout(bool& ok){
+    static const struct {
+      lxGLParameterType_t type;
+      uint32              count;
+      uint32              offset;
+    } expected[] = {
+      {LUXGL_PARAM_FLOAT,       1,  0},
+      {LUXGL_PARAM_FLOAT3,      1,  16},
+      {LUXGL_PARAM_FLOAT,       1,  28},
+      {LUXGL_PARAM_MAT3,        1,  32},
+      {LUXGL_PARAM_FLOAT2,      3,  80},
+      {LUXGL_PARAM_MAT4,        1,  128},
+      {LUXGL_PARAM_INT,         1,  192},
+      {LUXGL_PARAM_FLOAT2,      1,  200},
+      {LUXGL_PARAM_MAT2x3,      1,  208},
+      {LUXGL_PARAM_SAMPLER_2D,  1,  (uint32)-1},
+      {LUXGL_PARAM_FLOAT4,      1,  240},
+      {LUXGL_PARAM_FLOAT,       2,  256},
+      {LUXGL_PARAM_FLOAT3,      1,  288},
+    };
+    const uint num = sizeof(expected)/sizeof(expected[0]);
+    lxShaderBlockEntry_t entries[num];
+    lxShaderBlock_t block;
+    float source[num][64];
+    void* datas[num];
+    float packed[512];
+
+    for (uint i = 0; i < num; i++){
+      entries[i].type = expected[i].type;
+      entries[i].count = expected[i].count;
+      for (uint c = 0; c < 64; c++){
+        source[i][c] = float(i * 64 + c + 1);
+      }
+      datas[i] = source[i];
+    }
+    ok &= lxShaderBlock_layout(&block,entries,num) == 304;
+    for (uint i = 0; i < num; i++){
+      ok &= entries[i].offset == expected[i].offset;
+    }
+
+    memset(packed,0,sizeof(packed));
+    lxShaderBlock_pack(&block,datas,packed);
+    uint components = 0;
+    for (uint i = 0; i < num; i++){
+      if (entries[i].vectors){
+        ok &= checkPacked(&entries[i],source[i],packed);
+        components += entries[i].vectors * entries[i].vectorSize / 4;
+      }
+    }
+    // padding stays untouched
+    uint written = 0;
+    for (uint i = 0; i < block.size / 4; i++){
+      written += packed[i] != 0.0f;
+    }
+    ok &= written == components;
+    ok &= packed[block.size / 4] == 0.0f;
+  }
+
+  int onInit(int argc, const char** argv) {
+    bool ok = true;
+
+    testLayout(ok);
+
+    // per-draw level of a shader: world, normal matrix, color, texture, tints
+    enum {
+      PARAM_WORLD,
+      PARAM_NORMAL,
+      PARAM_COLOR,
+      PARAM_TEXTURE,
+      PARAM_TINTS,
+      NUM_PARAMS,
+    };
+    static const lxGLParameterType_t types[NUM_PARAMS] = {
+      LUXGL_PARAM_MAT4,LUXGL_PARAM_MAT3,LUXGL_PARAM_FLOAT4,LUXGL_PARAM_SAMPLER_2D,LUXGL_PARAM_FLOAT3,
+    };
+    lxShaderParameter_t     params[NUM_PARAMS];
+    lxgProgramParameter_t   progParams[NUM_PARAMS];
+    lxgProgramParameter_t*  progParamPtrs[NUM_PARAMS];
+    lxShaderProgram_t       shader;
+
+    memset(params,0,sizeof(params));
+    memset(progParams,0,sizeof(progParams));
+    memset(&shader,0,sizeof(shader));
+    for (uint i = 0; i < NUM_PARAMS; i++){
+      params[i].type = types[i];
+      params[i].progOffset = i;
+      params[i].progCount = 1;
+      progParams[i].type = types[i];
+      progParams[i].uniform.count = i == PARAM_TINTS ? 2 : 1;
+      progParamPtrs[i] = &progParams[i];
+    }
+    shader.numParams = NUM_PARAMS;
+    shader.params = params;
+    shader.numProgParams = NUM_PARAMS;
+    shader.progParams = progParamPtrs;
+
+    // level parameters in level order, one unused by the shader
+    lxShaderIndex indices[6] = {PARAM_WORLD,PARAM_NORMAL,PARAM_COLOR,PARAM_TEXTURE,-1,PARAM_TINTS};
+    lxShaderBlockEntry_t entries[6];
+    lxShaderBlock_t block;
+    lxShaderBlock_initShader(&block,entries,&shader,6,indices);
+    ok &= entries[0].offset == 0 && entries[1].offset == 64 && entries[2].offset == 112;
+    ok &= entries[3].offset == (uint32)-1 && entries[4].offset == (uint32)-1 && entries[5].offset == 128;
+    ok &= block.size == 160;
+
+    std::vector<float> sources(NUM_DRAWS * 36);
+    for (size_t i = 0; i < sources.size(); i++){
+      sources[i] = float(i % 1000);
+    }
+    uint32 stride = (block.size + RING_ALIGN - 1) & ~(RING_ALIGN - 1);
+    std::vector<double> frame(NUM_DRAWS * stride / sizeof(double));
+    byte* frameBytes = (byte*)&frame[0];
+    int texture = 0;
+
+    double begin = glfwGetTime();
+    for (int f = 0; f < NUM_FRAMES; f++){
+      for (int d = 0; d < NUM_DRAWS; d++){
+        float* src = &sources[d * 36];
+        void* datas[6] = {src,src + 16,src + 25,&texture,NULL,src + 29};
+        lxShaderBlock_pack(&block,datas,frameBytes + d * stride);
+      }
+    }
+    double time = (glfwGetTime() - begin) / double(NUM_FRAMES);
+
+    for (int d = 0; d < NUM_DRAWS; d += 997){
+      float* src = &sources[d * 36];
+      const float* dst = (const float*)(frameBytes + d * stride);
+      ok &= checkPacked(&entries[0],src,dst) && checkPacked(&entries[1],src + 16,dst);
+      ok &= checkPacked(&entries[2],src + 25,dst) && checkPacked(&entries[5],src + 29,dst);
+    }
+
+    // streamed through a ring, gpu two frames behind
+    {
+      std::vector<double> ringMemory(NUM_DRAWS * stride * 3 / sizeof(double));
+      byte* ringBytes = (byte*)&ringMemory[0];
+      lxgBufferRing_t ring;
+      lxgBufferRing_initCPU(&ring,ringBytes,(uint)(ringMemory.size() * sizeof(double)),RING_ALIGN);
+      for (int f = 0; f < NUM_FRAMES; f++){
+        for (int d = 0; d < NUM_DRAWS; d++){
+          float* src = &sources[d * 36];
+          void* datas[6] = {src,src + 16,src + 25,&texture,NULL,src + 29};
+          uint32 offset = lxShaderBlock_packRing(&block,datas,&ring);
+          ok &= offset != (uint32)-1 && offset % RING_ALIGN == 0;
+          if (d % 997 == 0 && offset != (uint32)-1){
+            ok &= checkPacked(&entries[0],src,(const float*)(ringBytes + offset));
+          }
+        }
+        lxgBufferRing_flush(&ring);
+        uint32 id = lxgBufferRing_endFrame(&ring);
+        lxgBufferRing_signalCPU(&ring,id > 2 ? id - 2 : 0);
+      }
+      ok &= ring.stats.numStalls == 0 && ring.stats.numFailed == 0;
+      lxgBufferRing_deinit(&ring);
+    }
+
+    printf("shaderblock: %d draws, block %d bytes, stride %d\n",NUM_DRAWS,block.size,stride);
+    printf("  pack %.3f ms, %.1f ns/draw, %.1f MB/s\n",time * 1000.0,time * 1e9 / double(NUM_DRAWS),
+      double(NUM_DRAWS) * double(block.size) / (time * 1024.0 * 1024.0));
+    uint uniforms = 0;
+    for (uint i = 0; i < block.numEntries; i++){
+      uniforms += entries[i].vectors ? 1 : 0;
+    }
+    printf("  uniform calls per draw %d -> 1 ranged bind\n",uniforms);
+    printf("  compare %s\n",ok ? "ok" : "FAILED");
+    return 1;
+  }
+
+};
+
+static ShaderBlockTest testShaderBlock;
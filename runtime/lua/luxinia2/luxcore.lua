@@ -306,6 +306,135 @@ typedef struct lxObjRef_s
 lxObjRef_t ;
 void lxObjRefSys_deleteRef ( lxObjRefSysPTR sys , lxObjRefPTR cref ) ;
 void lxObjRefSys_deleteAlloc ( lxObjRefSysPTR sys , lxObjRefPTR cref ) ;
+typedef struct lxJobPool_s * lxJobPoolPTR ;
+typedef void ( lxJobPoolFunc_fn ) ( void * userdata , uint jobindex , uint threadindex ) ;
+lxJobPoolPTR lxJobPool_new ( lxMemoryAllocatorPTR allocator , uint numThreads ) ;
+void lxJobPool_delete ( lxJobPoolPTR pool ) ;
+uint lxJobPool_getThreadCount ( lxJobPoolPTR pool ) ;
+void lxJobPool_run ( lxJobPoolPTR pool , uint numJobs , lxJobPoolFunc_fn * func , void * userdata ) ;
+booln lxJobPool_tryRun ( lxJobPoolPTR pool , uint numJobs , lxJobPoolFunc_fn * func , void * userdata ) ;
+typedef union lxScalarPtr_u
+{
+    void * tvoid ;
+    float * tfloat ;
+    int8 * tint8 ;
+    uint8 * tuint8 ;
+    int16 * tint16 ;
+    uint16 * tuint16 ;
+    int32 * tint32 ;
+    uint32 * tuint32 ;
+    float16 * tfloat16 ;
+    double * tfloat64 ;
+}
+lxScalarPtr_t ;
+typedef union lxScalarVector_u
+{
+    float tfloat [ 4 ] ;
+    uint8 tuint8 [ 4 ] ;
+    int8 tint8 [ 4 ] ;
+    uint16 tuint16 [ 4 ] ;
+    int16 tint16 [ 4 ] ;
+    uint32 tuint32 [ 4 ] ;
+    int32 tint32 [ 4 ] ;
+}
+lxScalarVector_t ;
+void lxScalarType_toFloat ( float * pout , lxScalarType_t intype , const void * pin , uint vectordim ) ;
+void lxScalarType_fromFloat ( void * pout , lxScalarType_t outtype , const float * pin , uint vectordim ) ;
+void lxScalarType_toFloatNormalized ( float * pout , lxScalarType_t intype , void * pin , uint vectordim ) ;
+void lxScalarType_fromFloatNormalized ( void * pout , lxScalarType_t outtype , const float * pin , uint vectordim ) ;
+void lxScalarType_normalizedFloat ( float * pout , lxScalarType_t intype , float * pin , uint vectordim ) ;
+void lxScalarType_from32 ( lxScalarVector_t * pout , lxScalarType_t type , void * pin , uint vectordim ) ;
+void lxScalarType_to32 ( lxScalarVector_t * pout , lxScalarType_t type , void * pin , uint vectordim ) ;
+extern size_t lx_gScalarTypeSizes [ LUX_SCALARS ] ;
+typedef struct lxScalarArray_s
+{
+    lxScalarType_t type ;
+    uint vectordim ;
+    uint count ;
+    uint stride ;
+    lxScalarPtr_t data ;
+}
+lxScalarArray_t ;
+typedef struct ScalarArray3D_s
+{
+    lxScalarArray_t sarr ;
+    union
+    {
+        uint size [ 3 ] ;
+        struct
+        {
+            uint width ;
+            uint height ;
+            uint depth ;
+        }
+        sz ;
+    }
+    ;
+    uint offset [ 3 ] ;
+}
+lxScalarArray3D_t ;
+typedef enum lxScalarArrayOp_e
+{
+    LUX_SCALAR_OP0_CLEAR , LUX_SCALAR_OP1_COPY , LUX_SCALAR_OP2_ADD , LUX_SCALAR_OP2_SUB , LUX_SCALAR_OP2_MUL , LUX_SCALAR_OP2_DIV , LUX_SCALAR_OP2_MIN , LUX_SCALAR_OP2_MAX , LUX_SCALAR_OP2_ADD_SAT , LUX_SCALAR_OP2_SUB_SAT , LUX_SCALAR_OP2_MUL_SAT , LUX_SCALAR_OP2_DIV_SAT , LUX_SCALAR_OP3_LERP , LUX_SCALAR_OP3_LERPINV , LUX_SCALAR_OP3_MADD , LUX_SCALAR_OP3_MADD_SAT , LUX_SCALAR_OPS , }
+lxScalarArrayOp_t ;
+void * lxScalarArray_getPtr ( lxScalarArray_t * sarr , uint idx ) ;
+void * lxScalarArray_getPtr3D ( lxScalarArray_t * sarr , const uint size [ 3 ] , const uint coords [ 3 ] ) ;
+void * lxScalarArray3D_getPtr ( lxScalarArray3D_t * sarr , const uint coords [ 3 ] ) ;
+booln lxScalarArray3D_setDataOffset ( lxScalarArray3D_t * sarr , uint start [ 3 ] , void * data ) ;
+void lxScalarArray3D_setData ( lxScalarArray3D_t * sarr , void * data ) ;
+lxScalarArray_t * lxScalarArray_init ( lxScalarArray_t * ret , lxScalarType_t intype , void * pin , uint vectordim , uint stride , uint count ) ;
+lxScalarArray_t * lxScalarArray_initSingle ( lxScalarArray_t * ret , lxScalarType_t intype , void * pin , uint vectordim ) ;
+lxScalarArray_t lxScalarArray_newSingle ( lxScalarType_t intype , void * pin , uint vectordim ) ;
+booln lxScalarArray_Op0 ( lxScalarArray_t * ret , lxScalarArrayOp_t op ) ;
+booln lxScalarArray_Op1 ( lxScalarArray_t * ret , lxScalarArrayOp_t op , const lxScalarArray_t * arg0 ) ;
+booln lxScalarArray_Op2 ( lxScalarArray_t * ret , lxScalarArrayOp_t op , const lxScalarArray_t * arg0 , const lxScalarArray_t * arg1 ) ;
+booln lxScalarArray_Op3 ( lxScalarArray_t * ret , lxScalarArrayOp_t op , const lxScalarArray_t * arg0 , const lxScalarArray_t * arg1 , const lxScalarArray_t * arg2 ) ;
+booln lxScalarArray3D_Op0 ( lxScalarArray3D_t * ret , uint region [ 3 ] , lxScalarArrayOp_t op ) ;
+booln lxScalarArray3D_Op1 ( lxScalarArray3D_t * ret , uint region [ 3 ] , lxScalarArrayOp_t op , const lxScalarArray3D_t * arg0 ) ;
+booln lxScalarArray3D_Op2 ( lxScalarArray3D_t * ret , uint region [ 3 ] , lxScalarArrayOp_t op , const lxScalarArray3D_t * arg0 , const lxScalarArray3D_t * arg1 ) ;
+booln lxScalarArray3D_Op3 ( lxScalarArray3D_t * ret , uint region [ 3 ] , lxScalarArrayOp_t op , const lxScalarArray3D_t * arg0 , const lxScalarArray3D_t * arg1 , const lxScalarArray3D_t * arg2 ) ;
+typedef enum lxScalarArrayKernel_e
+{
+    LUX_SCALAR_KERNEL_DEFAULT , LUX_SCALAR_KERNEL_AVX2 , LUX_SCALAR_KERNELS , }
+lxScalarArrayKernel_t ;
+booln lxScalarArray_isKernelSupported ( lxScalarArrayKernel_t kernel ) ;
+lxScalarArrayKernel_t lxScalarArray_setKernel ( lxScalarArrayKernel_t kernel ) ;
+lxScalarArrayKernel_t lxScalarArray_getKernel ( ) ;
+void lxScalarArray_setJobPool ( lxJobPoolPTR pool , uint minScalars ) ;
+lxJobPoolPTR lxScalarArray_getJobPool ( ) ;
+booln lxScalarArray_sum ( const lxScalarArray_t * sarr , double outsum [ 4 ] ) ;
+booln lxScalarArray_min ( const lxScalarArray_t * sarr , lxScalarVector_t * outmin ) ;
+booln lxScalarArray_max ( const lxScalarArray_t * sarr , lxScalarVector_t * outmax ) ;
+booln lxScalarArray_minMax ( const lxScalarArray_t * sarr , lxScalarVector_t * outmin , lxScalarVector_t * outmax , uint outminidx [ 4 ] , uint outmaxidx [ 4 ] ) ;
+booln lxScalarArray_dot ( const lxScalarArray_t * sarr0 , const lxScalarArray_t * sarr1 , double * outdot ) ;
+booln lxScalarArray_length ( const lxScalarArray_t * sarr , double * outlength ) ;
+booln lxScalarArray_scanInclusive ( lxScalarArray_t * sOut , const lxScalarArray_t * sIn ) ;
+booln lxScalarArray_scanExclusive ( lxScalarArray_t * sOut , const lxScalarArray_t * sIn ) ;
+booln lxScalarArray_convert ( lxScalarArray_t * sarrayOut , const lxScalarArray_t * sarrayIn ) ;
+booln lxScalarArray_convertRanged ( lxScalarArray_t * sarrayOut , const lxScalarVector_t * outminmax , const lxScalarArray_t * sarrayIn , const lxScalarVector_t * inminmax ) ;
+booln lxScalarArray_convertNormalized ( lxScalarArray_t * sarrayOut , const lxScalarArray_t * sarrayIn ) ;
+uint lxSampleCubeTo2DCoord ( float coordsout [ 2 ] , const float coords [ 3 ] ) ;
+booln lxScalarArray_sampleLinear ( float * outvals , const lxScalarArray_t * sarray , const uint size [ 3 ] , const float coords [ 3 ] , booln notclamped [ 3 ] ) ;
+booln lxScalarArray3D_sampleLinear ( float * outvals , const lxScalarArray3D_t * sarray , const float coords [ 3 ] , booln notclamped [ 3 ] ) ;
+booln lxScalarArray_curveLinear ( lxScalarArray_t * sarray , const lxScalarArray_t * sarray0 , booln closed ) ;
+booln lxScalarArray_curveSpline ( lxScalarArray_t * sarray , const lxScalarArray_t * sarray0 , booln closed ) ;
+typedef enum lxFScalarArrayOp_e
+{
+    LUX_FSCALAR_OP1_TRANSFORM , LUX_FSCALAR_OP1_TRANSFORMROT , LUX_FSCALAR_OP1_TRANSFORMFULL , LUX_FSCALAR_OP1_NORMALIZE , LUX_FSCALAR_OP1_NORMALIZEACC , LUX_FSCALAR_OP1S , }
+lxFScalarArrayOp_t ;
+booln lxFScalarArray_op1 ( lxScalarArray_t * sarray , lxFScalarArrayOp_t op , const lxScalarArray_t * sarray0 , const float * arg ) ;
+booln lxFScalarArray_relLength ( lxScalarArray_t * sarraylen , lxScalarArray_t * sarraypath , float * outlength ) ;
+typedef struct lxScalarExpr_s * lxScalarExprPTR ;
+lxScalarExprPTR lxScalarExpr_new ( lxMemoryAllocatorPTR allocator , lxScalarType_t type , uint vectordim ) ;
+void lxScalarExpr_delete ( lxScalarExprPTR expr ) ;
+void lxScalarExpr_clear ( lxScalarExprPTR expr ) ;
+uint lxScalarExpr_getCount ( lxScalarExprPTR expr ) ;
+int lxScalarExpr_input ( lxScalarExprPTR expr , const lxScalarArray_t * sarr ) ;
+int lxScalarExpr_op2 ( lxScalarExprPTR expr , lxScalarArrayOp_t op , int node0 , int node1 ) ;
+int lxScalarExpr_op3 ( lxScalarExprPTR expr , lxScalarArrayOp_t op , int node0 , int node1 , int node2 ) ;
+int lxScalarExpr_fop1 ( lxScalarExprPTR expr , lxFScalarArrayOp_t op , int node0 , const float * arg ) ;
+booln lxScalarExpr_setInput ( lxScalarExprPTR expr , int node , const lxScalarArray_t * sarr ) ;
+booln lxScalarExpr_eval ( lxScalarExprPTR expr , int node , lxScalarArray_t * sOut ) ;
 ]]
 
 return ffi.load("luxbackend")
@@ -99,7 +99,7 @@ typedef enum lxGLBufferTarget_e
 lxGLBufferTarget_t ;
 typedef enum lxGLShaderType_e
 {
-    LUXGL_SHADER_VERTEX = GL_VERTEX_SHADER , LUXGL_SHADER_FRAGMENT = GL_FRAGMENT_SHADER , LUXGL_SHADER_GEOMETRY = GL_GEOMETRY_SHADER , LUXGL_SHADER_TESSCTRL = GL_TESS_CONTROL_SHADER , LUXGL_SHADER_TESSEVAL = GL_TESS_EVALUATION_SHADER , }
+    LUXGL_SHADER_VERTEX = GL_VERTEX_SHADER , LUXGL_SHADER_FRAGMENT = GL_FRAGMENT_SHADER , LUXGL_SHADER_GEOMETRY = GL_GEOMETRY_SHADER , LUXGL_SHADER_TESSCTRL = GL_TESS_CONTROL_SHADER , LUXGL_SHADER_TESSEVAL = GL_TESS_EVALUATION_SHADER , LUXGL_SHADER_COMPUTE = GL_COMPUTE_SHADER , }
 lxGLShaderType_t ;
 typedef enum lxGLProgramType_e
 {
@@ -153,6 +153,61 @@ void lxgBuffer_unresidentNV ( lxgBufferPTR buffer ) ;
 void lxgBuffer_deinit ( lxgBufferPTR buffer , lxgContextPTR ctx ) ;
 void lxgBuffer_reset ( lxgBufferPTR buffer , void * data ) ;
 void lxgBuffer_init ( lxgBufferPTR buffer , lxgContextPTR ctx , lxGLBufferHint_t hint , uint size , void * data ) ;
+enum
+{
+    LUXGFX_RING_MAXFRAMES = 8 , }
+;
+typedef struct lxgBufferRingFrame_s
+{
+    GLsync fence ;
+    uint32 id ;
+    uint32 end ;
+    uint32 bytes ;
+}
+lxgBufferRingFrame_t ;
+typedef struct lxgBufferRingStats_s
+{
+    uint64 bytesStreamed ;
+    uint64 bytesPadding ;
+    uint numAllocs ;
+    uint numFailed ;
+    uint numWraps ;
+    uint numFrames ;
+    uint numMaps ;
+    uint numStalls ;
+    uint stallsAvoided ;
+}
+lxgBufferRingStats_t ;
+typedef struct lxgBufferRing_s
+{
+    lxgBufferPTR buffer ;
+    byte * memory ;
+    uint32 size ;
+    uint32 align ;
+    uint32 head ;
+    uint32 tail ;
+    uint32 used ;
+    uint32 frameBytes ;
+    uint32 frameID ;
+    uint32 completedID ;
+    uint firstPending ;
+    uint numPending ;
+    lxgBufferRingFrame_t pending [ LUXGFX_RING_MAXFRAMES ] ;
+    booln sync ;
+    byte * mapped ;
+    uint32 mapBegin ;
+    uint32 mapEnd ;
+    uint32 mapWritten ;
+    lxgBufferRingStats_t stats ;
+}
+lxgBufferRing_t ;
+void lxgBufferRing_init ( lxgBufferRing_t * ring , lxgBufferPTR buffer , uint align ) ;
+void lxgBufferRing_initCPU ( lxgBufferRing_t * ring , void * memory , uint size , uint align ) ;
+void lxgBufferRing_deinit ( lxgBufferRing_t * ring ) ;
+void * lxgBufferRing_alloc ( lxgBufferRing_t * ring , uint size , uint * offset ) ;
+void lxgBufferRing_flush ( lxgBufferRing_t * ring ) ;
+uint32 lxgBufferRing_endFrame ( lxgBufferRing_t * ring ) ;
+void lxgBufferRing_signalCPU ( lxgBufferRing_t * ring , uint32 id ) ;
 typedef enum lxgVertexAttrib_e
 {
     LUXGFX_VERTEX_ATTRIB_POS , LUXGFX_VERTEX_ATTRIB_ATTR1 , LUXGFX_VERTEX_ATTRIB_NORMAL , LUXGFX_VERTEX_ATTRIB_COLOR , LUXGFX_VERTEX_ATTRIB_ATTR4 , LUXGFX_VERTEX_ATTRIB_ATTR5 , LUXGFX_VERTEX_ATTRIB_ATTR6 , LUXGFX_VERTEX_ATTRIB_ATTR7 , LUXGFX_VERTEX_ATTRIB_TEXCOORD0 , LUXGFX_VERTEX_ATTRIB_TEXCOORD1 , LUXGFX_VERTEX_ATTRIB_TEXCOORD2 , LUXGFX_VERTEX_ATTRIB_TEXCOORD3 , LUXGFX_VERTEX_ATTRIB_ATTR12 , LUXGFX_VERTEX_ATTRIB_ATTR13 , LUXGFX_VERTEX_ATTRIB_ATTR14 , LUXGFX_VERTEX_ATTRIB_ATTR15 , LUXGFX_VERTEX_ATTRIBS , }
@@ -207,11 +262,6 @@ typedef struct lxgVertexState_s
 lxgVertexState_t ;
 typedef struct lxgFeedbackState_s
 {
-    lxGLPrimitiveType_t capture ;
-    int active ;
-    flags32 usedvalid ;
-    flags32 streamvalid ;
-    flags32 streamchange ;
     lxgStreamHost_t streams [ LUXGFX_MAX_VERTEX_STREAMS ] ;
 }
 lxgFeedbackState_t ;
@@ -219,24 +269,17 @@ flags32 lxgVertexAttrib_bit ( lxgVertexAttrib_t attrib ) ;
 lxgVertexElement_t lxgVertexElement_set ( uint cnt , enum lxScalarType_e type , booln normalize , booln integer , uint stride , uint offset , uint stream ) ;
 void lxgVertexAttrib_applyFloat ( lxgVertexAttrib_t attrib , const float * vec4 ) ;
 void lxgVertexAttrib_applyInteger ( lxgVertexAttrib_t attrib , const int * vec4 ) ;
-void lxgVertexAttrib_applyFloatFIXED ( lxgVertexAttrib_t attrib , const float * vec4 ) ;
 void lxgContext_applyVertexAttribs ( lxgContextPTR ctx , flags32 attribs , flags32 changed ) ;
-void lxgContext_applyVertexAttribsFIXED ( lxgContextPTR ctx , flags32 attribs , flags32 changed ) ;
 void lxgContext_clearVertexState ( lxgContextPTR ctx ) ;
 void lxgContext_setVertexDecl ( lxgContextPTR ctx , lxgVertexDeclCPTR decl ) ;
 void lxgContext_setVertexDeclStreams ( lxgContextPTR ctx , lxgVertexDeclCPTR decl , lxgStreamHostCPTR hosts ) ;
 void lxgContext_setVertexStream ( lxgContextPTR ctx , uint idx , lxgStreamHostCPTR host ) ;
 void lxgContext_invalidateVertexStreams ( lxgContextPTR ctx ) ;
 void lxgContext_applyVertexState ( lxgContextPTR ctx ) ;
-void lxgContext_applyVertexStateFIXED ( lxgContextPTR ctx ) ;
 void lxgContext_applyVertexStateNV ( lxgContextPTR ctx ) ;
-void lxgContext_applyVertexStateFIXEDNV ( lxgContextPTR ctx ) ;
+void lxgContext_applyFeedbackStreams ( lxgContextPTR ctx , lxgStreamHostCPTR hosts , int numStreams ) ;
+void lxgContext_applyFeedbackStream ( lxgContextPTR ctx , uint idx , lxgStreamHostCPTR host ) ;
 void lxgContext_clearFeedbackState ( lxgContextPTR ctx ) ;
-void lxgContext_applyFeedbackStreams ( lxgContextPTR ctx ) ;
-void lxgContext_setFeedbackStreams ( lxgContextPTR ctx , lxgStreamHostCPTR hosts , int numStreams ) ;
-void lxgContext_setFeedbackStream ( lxgContextPTR ctx , uint idx , lxgStreamHostCPTR host ) ;
-void lxgContext_enableFeedback ( lxgContextPTR ctx , lxGLPrimitiveType_t type , int numStreams ) ;
-void lxgContext_disableFeedback ( lxgContextPTR ctx ) ;
 typedef enum lxgSamplerFilter_e
 {
     LUXGFX_SAMPLERFILTER_NEAREST , LUXGFX_SAMPLERFILTER_LINEAR , LUXGFX_SAMPLERFILTER_MIPMAP_NEAREST , LUXGFX_SAMPLERFILTER_MIPMAP_LINEAR , LUXGFX_SAMPLERFILTERS , }
@@ -338,8 +381,6 @@ typedef struct lxgTextureImage_s
 }
 lxgTextureImage_t ;
 void lxgContext_clearTextureState ( lxgContextPTR ctx ) ;
-void lxgContext_setTextureSampler ( lxgContextPTR ctx , uint imageunit , flags32 what ) ;
-void lxgContext_changedTextureSampler ( lxgContextPTR ctx , uint imageunit , flags32 what ) ;
 void lxgContext_applyTexture ( lxgContextPTR ctx , lxgTexturePTR obj , uint imageunit ) ;
 void lxgContext_applyTextures ( lxgContextPTR ctx , lxgTexturePTR * texs , uint start , uint num ) ;
 void lxgContext_applySampler ( lxgContextPTR ctx , lxgSamplerCPTR obj , uint imageunit ) ;
@@ -353,6 +394,7 @@ GLenum lxgTextureChannel_getFormat ( lxgTextureChannel_t type , booln rev , bool
 GLenum lxgTextureChannel_getInternal ( lxgTextureChannel_t type , lxgTextureDataType_t data ) ;
 void lxgTexture_init ( lxgTexturePTR tex , lxgContextPTR ctx ) ;
 void lxgTexture_deinit ( lxgTexturePTR tex , lxgContextPTR ctx ) ;
+void lxgTexture_generateMipMaps ( lxgTexturePTR tex ) ;
 booln lxgTexture_setup ( lxgTexturePTR tex , lxGLTextureTarget_t type , lxgTextureChannel_t format , lxgTextureDataType_t data , int width , int height , int depth , int arraysize , flags32 flags ) ;
 booln lxgTexture_resize ( lxgTexturePTR tex , int width , int height , int depth , int arraysize ) ;
 booln lxgTexture_readFrame ( lxgTexturePTR tex , lxgContextPTR ctx , const lxgTextureUpdate_t * update , uint miplevel ) ;
@@ -439,10 +481,13 @@ typedef struct lxgBlend_s
 lxgBlend_t ;
 typedef struct lxgRasterizer_s
 {
+    enum32 fill ;
     bool8 cull ;
     bool8 cullfront ;
     bool8 ccw ;
-    enum32 fill ;
+    bool8 polyoffset ;
+    float polyoffsetFactor ;
+    float polyoffsetUnits ;
 }
 lxgRasterizer_t ;
 typedef struct lxgRasterState_s
@@ -520,15 +565,15 @@ typedef enum lxgRenderTargetType_e
 lxgRenderTargetType_t ;
 typedef struct lxgRenderAssign_s
 {
-    lxgTexturePTR tex ;
-    lxgRenderBufferPTR rbuf ;
+    lxgTextureCPTR tex ;
+    lxgRenderBufferCPTR rbuf ;
     uint mip ;
     uint layer ;
 }
 lxgRenderAssign_t ;
 typedef enum lxgRenderAssignType_e
 {
-    LUXGFX_RENDERASSIGN_DEPTH , LUXGFX_RENDERASSIGN_STENCIL , LUXGFX_RENDERASSIGN_COLOR0 , LUXGFX_RENDERASSIGNS = LUXGFX_RENDERASSIGN_COLOR0 + LUXGFX_MAX_RENDERTARGETS , }
+    LUXGFX_RENDERASSIGN_DEPTH , LUXGFX_RENDERASSIGN_STENCIL , LUXGFX_RENDERASSIGN_COLOR0 , LUXGFX_RENDERASSIGN_COLOR1 , LUXGFX_RENDERASSIGN_COLOR2 , LUXGFX_RENDERASSIGN_COLOR3 , LUXGFX_RENDERASSIGN_COLOR4 , LUXGFX_RENDERASSIGN_COLOR5 , LUXGFX_RENDERASSIGN_COLOR6 , LUXGFX_RENDERASSIGN_COLOR7 , LUXGFX_RENDERASSIGN_COLOR8 , LUXGFX_RENDERASSIGN_COLOR9 , LUXGFX_RENDERASSIGN_COLOR10 , LUXGFX_RENDERASSIGN_COLOR11 , LUXGFX_RENDERASSIGN_COLOR12 , LUXGFX_RENDERASSIGN_COLOR13 , LUXGFX_RENDERASSIGN_COLOR14 , LUXGFX_RENDERASSIGN_COLOR15 , LUXGFX_RENDERASSIGNS , }
 lxgRenderAssignType_t ;
 typedef struct lxgRenderTarget_s
 {
@@ -550,10 +595,11 @@ typedef struct lxgRenderTargetBlit_s
 }
 lxgRenderTargetBlit_t ;
 typedef struct lxgRenderTargetBlit_s * lxgRenderTargetBlitPTR ;
+void lxgRenderAssign_set ( lxgRenderAssignPTR rt , lxgTextureCPTR tex , lxgRenderBufferCPTR rb , uint mip , uint layer ) ;
 void lxgRenderTarget_init ( lxgRenderTargetPTR rt , lxgContextPTR ctx ) ;
 void lxgRenderTarget_deinit ( lxgRenderTargetPTR rt , lxgContextPTR ctx ) ;
 void lxgRenderTarget_applyAssigns ( lxgRenderTargetPTR rt , lxgRenderTargetType_t mode ) ;
-void lxgRenderTarget_setAssign ( lxgRenderTargetPTR rt , uint assigntype , lxgRenderAssignPTR assign ) ;
+void lxgRenderTarget_setAssign ( lxgRenderTargetPTR rt , lxgRenderAssignType_t assigntype , lxgRenderAssignCPTR assign ) ;
 booln lxgRenderTarget_checkSize ( lxgRenderTargetPTR rt ) ;
 lxgFrameBoundsCPTR lxgRenderTarget_getBounds ( lxgRenderTargetPTR rt ) ;
 void lxgViewPort_sync ( lxgViewPortPTR obj , lxgContextPTR ctx ) ;
@@ -565,13 +611,14 @@ booln lxgContext_applyViewPortRect ( lxgContextPTR ctx , lxRectangleiCPTR rect )
 booln lxgContext_applyViewPortScissorState ( lxgContextPTR ctx , booln state ) ;
 booln lxgContext_applyViewPort ( lxgContextPTR ctx , lxgViewPortPTR obj ) ;
 void lxgContext_applyViewPortMrt ( lxgContextPTR ctx , lxgViewPortMrtPTR obj ) ;
+void lxgContext_setWindowBounds ( lxgContextPTR ctx , int width , int height ) ;
 typedef enum lxgProgramType_e
 {
-    LUXGFX_PROGRAM_NONE , LUXGFX_PROGRAM_GLSL , LUXGFX_PROGRAM_GLSLSEP , LUXGFX_PROGRAM_NV , }
+    LUXGFX_PROGRAM_NONE , LUXGFX_PROGRAM_GLSL , LUXGFX_PROGRAM_GLSLSEP , }
 lxgProgramType_t ;
 typedef enum lxgProgramStage_e
 {
-    LUXGFX_STAGE_VERTEX , LUXGFX_STAGE_FRAGMENT , LUXGFX_STAGE_GEOMETRY , LUXGFX_STAGE_TESSCTRL , LUXGFX_STAGE_TESSEVAL , LUXGFX_STAGES , }
+    LUXGFX_STAGE_VERTEX , LUXGFX_STAGE_FRAGMENT , LUXGFX_STAGE_GEOMETRY , LUXGFX_STAGE_TESSCTRL , LUXGFX_STAGE_TESSEVAL , LUXGFX_STAGE_COMPUTE , LUXGFX_STAGES , }
 lxgProgramStage_t ;
 typedef void ( * lxgParmeterUpdate_fn ) ( lxgProgramParameterPTR param , lxgContextPTR ctx , const void * data ) ;
 typedef uint32 lxgSubroutineKey ;
@@ -695,26 +742,14 @@ void lxgProgram_initSEP ( lxgProgramPTR prog , lxgContextPTR ctx ) ;
 void lxgProgram_deinitSEP ( lxgProgramPTR prog , lxgContextPTR ctx ) ;
 void lxgProgram_setSEP ( lxgProgramPTR prog , lxgProgramPTR stage ) ;
 const char * lxgProgram_logSEP ( lxgProgramPTR prog , char * buffer , int len ) ;
-void lxgProgramParameter_initFuncNV ( lxgProgramParameterPTR param , lxgProgramStage_t domain ) ;
-void lxgStageProgram_initNV ( lxgStageProgramPTR stage , lxgContextPTR ctx , lxgProgramStage_t type ) ;
-void lxgStageProgram_deinitNV ( lxgStageProgramPTR stage , lxgContextPTR ctx ) ;
-int lxgStageProgram_compileNV ( lxgStageProgramPTR stage , const char * src , int len ) ;
-const char * lxgStageProgram_errorNV ( lxgStageProgramPTR stage , char * buffer , int len ) ;
-void lxgProgram_initNV ( lxgProgramPTR prog , lxgContextPTR ctx ) ;
-void lxgProgram_deinitNV ( lxgProgramPTR prog , lxgContextPTR ctx ) ;
-void lxgProgram_setStageNV ( lxgProgramPTR prog , lxgProgramStage_t type , lxgStageProgramPTR stage ) ;
 enum lxgCapability_e
 {
-    LUXGFX_CAP_POINTSPRITE = 1 << 0 , LUXGFX_CAP_STENCILWRAP = 1 << 1 , LUXGFX_CAP_BLENDSEP = 1 << 2 , LUXGFX_CAP_OCCQUERY = 1 << 3 , LUXGFX_CAP_FBO = 1 << 4 , LUXGFX_CAP_FBOMS = 1 << 5 , LUXGFX_CAP_DEPTHFLOAT = 1 << 6 , LUXGFX_CAP_VBO = 1 << 7 , LUXGFX_CAP_PBO = 1 << 8 , LUXGFX_CAP_UBO = 1 << 9 , LUXGFX_CAP_TEX3D = 1 << 10 , LUXGFX_CAP_TEXRECT = 1 << 11 , LUXGFX_CAP_TEXNP2 = 1 << 12 , LUXGFX_CAP_TEXCUBEARRAY = 1 << 13 , LUXGFX_CAP_TEXS3TC = 1 << 14 , LUXGFX_CAP_TEXRGTC = 1 << 15 , LUXGFX_CAP_TEXRW = 1 << 16 , LUXGFX_CAP_BUFMAPRANGE = 1 << 17 , LUXGFX_CAP_BUFCOPY = 1 << 18 , LUXGFX_CAP_DEPTHCLAMP = 1 << 19 , LUXGFX_CAP_SM0 = 1 << 20 , LUXGFX_CAP_SM1 = 1 << 21 , LUXGFX_CAP_SM2 = 1 << 22 , LUXGFX_CAP_SM2EXT = 1 << 23 , LUXGFX_CAP_SM3 = 1 << 24 , LUXGFX_CAP_SM4 = 1 << 25 , LUXGFX_CAP_SM5 = 1 << 26 , }
+    LUXGFX_CAP_BLENDSEP = 1 << 2 , LUXGFX_CAP_OCCQUERY = 1 << 3 , LUXGFX_CAP_TEXS3TC = 1 << 14 , LUXGFX_CAP_TEXRGTC = 1 << 15 , LUXGFX_CAP_DEPTHCLAMP = 1 << 19 , LUXGFX_CAP_API2 = 1 << 23 , LUXGFX_CAP_API3 = 1 << 25 , LUXGFX_CAP_API4 = 1 << 26 , }
 ;
 typedef enum lxgGPUVendor_e
 {
     LUXGFX_GPUVENDOR_UNKNOWN , LUXGFX_GPUVENDOR_NVIDIA , LUXGFX_GPUVENDOR_ATI , LUXGFX_GPUVENDOR_INTEL , }
 lxgGPUVendor_t ;
-typedef enum lxgGPUMode_e
-{
-    LUXGFX_GPUMODE_FIXED , LUXGFX_GPUMODE_ASM , LUXGFX_GPUMODE_HL , }
-lxgGPUMode_t ;
 typedef struct lxgCapabilites_s
 {
     int texsize ;
@@ -754,28 +789,20 @@ void lxgContext_syncRasterStates ( lxgContextPTR ctx ) ;
 booln lxgContext_checkStates ( lxgContextPTR ctx ) ;
 void lxgContext_clearVertexState ( lxgContextPTR ctx ) ;
 void lxgContext_applyVertexAttribs ( lxgContextPTR ctx , flags32 attribs , flags32 changed ) ;
-void lxgContext_applyVertexAttribsFIXED ( lxgContextPTR ctx , flags32 attribs , flags32 changed ) ;
 void lxgContext_applyVertexState ( lxgContextPTR ctx ) ;
-void lxgContext_applyVertexStateFIXED ( lxgContextPTR ctx ) ;
 void lxgContext_applyVertexStateNV ( lxgContextPTR ctx ) ;
-void lxgContext_applyVertexStateFIXEDNV ( lxgContextPTR ctx ) ;
 void lxgContext_setVertexDecl ( lxgContextPTR ctx , lxgVertexDeclCPTR decl ) ;
 void lxgContext_setVertexDeclStreams ( lxgContextPTR ctx , lxgVertexDeclCPTR decl , lxgStreamHostCPTR hosts ) ;
 void lxgContext_setVertexStream ( lxgContextPTR ctx , uint idx , lxgStreamHostCPTR host ) ;
 void lxgContext_invalidateVertexStreams ( lxgContextPTR ctx ) ;
+void lxgContext_applyFeedbackStreams ( lxgContextPTR ctx , lxgStreamHostCPTR hosts , int numStreams ) ;
+void lxgContext_applyFeedbackStream ( lxgContextPTR ctx , uint idx , lxgStreamHostCPTR host ) ;
 void lxgContext_clearFeedbackState ( lxgContextPTR ctx ) ;
-void lxgContext_applyFeedbackStreams ( lxgContextPTR ctx ) ;
-void lxgContext_setFeedbackStreams ( lxgContextPTR ctx , lxgStreamHostCPTR hosts , int numStreams ) ;
-void lxgContext_setFeedbackStream ( lxgContextPTR ctx , uint idx , lxgStreamHostCPTR host ) ;
-void lxgContext_enableFeedback ( lxgContextPTR ctx , lxGLPrimitiveType_t type , int numStreams ) ;
-void lxgContext_disableFeedback ( lxgContextPTR ctx ) ;
 void lxgContext_clearProgramState ( lxgContextPTR ctx ) ;
 void lxgContext_applyProgram ( lxgContextPTR ctx , lxgProgramCPTR prog ) ;
 void lxgContext_applyProgramParameters ( lxgContextPTR ctx , lxgProgramCPTR prog , uint num , lxgProgramParameterPTR * params , const void * * data ) ;
 void lxgContext_updateProgramSubroutines ( lxgContextPTR ctx , lxgProgramCPTR prog ) ;
 void lxgContext_clearTextureState ( lxgContextPTR ctx ) ;
-void lxgContext_setTextureSampler ( lxgContextPTR ctx , uint imageunit , flags32 what ) ;
-void lxgContext_changedTextureSampler ( lxgContextPTR ctx , uint imageunit , flags32 what ) ;
 void lxgContext_applyTexture ( lxgContextPTR ctx , lxgTexturePTR obj , uint imageunit ) ;
 void lxgContext_applyTextures ( lxgContextPTR ctx , lxgTexturePTR * texs , uint start , uint num ) ;
 void lxgContext_applySampler ( lxgContextPTR ctx , lxgSamplerCPTR obj , uint imageunit ) ;
@@ -811,15 +838,11 @@ void lxgContext_checkedTextureImages ( lxgContextPTR ctx , lxgTextureImageCPTR *
 void lxgContext_checkedRenderFlag ( lxgContextPTR ctx , flags32 needed ) ;
 void lxgContext_checkedVertexDecl ( lxgContextPTR ctx , lxgVertexDeclCPTR decl ) ;
 void lxgContext_checkedVertexAttrib ( lxgContextPTR ctx , flags32 needed ) ;
-void lxgContext_checkedVertexAttribFIXED ( lxgContextPTR ctx , flags32 needed ) ;
 void lxgContext_checkedRenderTarget ( lxgContextPTR ctx , lxgRenderTargetPTR rt , lxgRenderTargetType_t type ) ;
 void lxgContext_checkedProgram ( lxgContextPTR ctx , lxgProgramPTR prog ) ;
 void lxgContext_checkedVertex ( lxgContextPTR ctx ) ;
 void lxgContext_checkedVertexNV ( lxgContextPTR ctx ) ;
-void lxgContext_checkedVertexFIXED ( lxgContextPTR ctx ) ;
-void lxgContext_checkedVertexFIXEDNV ( lxgContextPTR ctx ) ;
-void lxgContext_checkedViewPortScissor ( lxgContextPTR ctx , lxRectangleiCPTR rect ) ;
-void lxgContext_checkedTextureSampler ( lxgContextPTR ctx , uint imageunit ) ;
+void lxgContext_checkedBoundTextureSampler ( lxgContextPTR ctx , uint imageunit ) ;
 booln lxgContext_setProgramBuffer ( lxgContextPTR ctx , uint idx , lxgBufferCPTR buffer ) ;
 ]]
 
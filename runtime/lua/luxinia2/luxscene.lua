@@ -28,6 +28,564 @@ void lxMeshCylinder_initOutline ( int segs [ 3 ] , uint32 * indices ) ;
 void * lxVertexCacheOptimize_tipsify ( void * indices , int nTriangles , int nVertices , int k , lxMeshIndexType_t type ) ;
 void * lxVertexCacheOptimize_forsyth ( void * indices , int nTriangles , int nVertices , int vcache , lxMeshIndexType_t type ) ;
 void * lxVertexCacheOptimize_grid_castano ( void * indices , int maxTriangles , int width , int height , int vcache , lxMeshIndexType_t type , int * writtenTriangles ) ;
+typedef struct lxVertexCacheStats_s
+{
+    int misses ;
+    float acmr ;
+    float atvr ;
+}
+lxVertexCacheStats_t ;
+void lxVertexCacheStats_compute ( lxVertexCacheStats_t * stats , const void * indices , int nTriangles , int nVertices , int vcache , lxMeshIndexType_t type ) ;
+typedef struct lxVertexCacheOpt_s
+{
+    lxMemoryAllocatorPTR allocator ;
+    void * scratch ;
+    size_t scratchSize ;
+    booln scratchOwned ;
+    lxVertexCacheStats_t before ;
+    lxVertexCacheStats_t after ;
+}
+lxVertexCacheOpt_t ;
+void lxVertexCacheOpt_init ( lxVertexCacheOpt_t * ctx , lxMemoryAllocatorPTR allocator , void * scratch , size_t scratchSize ) ;
+void lxVertexCacheOpt_deinit ( lxVertexCacheOpt_t * ctx ) ;
+size_t lxVertexCacheOpt_scratchSize ( int nTriangles , int nVertices ) ;
+void * lxVertexCacheOpt_reserve ( lxVertexCacheOpt_t * ctx , int nTriangles , int nVertices ) ;
+void * lxVertexCacheOpt_tipsify ( lxVertexCacheOpt_t * ctx , void * indices , int nTriangles , int nVertices , int k , lxMeshIndexType_t type ) ;
+void * lxVertexCacheOpt_forsyth ( lxVertexCacheOpt_t * ctx , void * indices , int nTriangles , int nVertices , int vcache , lxMeshIndexType_t type ) ;
+void * lxVertexCacheOpt_gridCastano ( lxVertexCacheOpt_t * ctx , void * indices , int maxTriangles , int width , int height , int vcache , lxMeshIndexType_t type , int * writtenTriangles ) ;
+int lxMeshVertexFetch_remap ( uint32 * remap , const void * indices , int numIndices , int nVertices , lxMeshIndexType_t type ) ;
+void lxMeshIndices_remap ( void * indices , int numIndices , const uint32 * remap , lxMeshIndexType_t type ) ;
+void lxMeshVertices_remap ( void * dst , const void * src , size_t stride , int nVertices , const uint32 * remap ) ;
+typedef struct lxMeshWeldStream_s
+{
+    const void * data ;
+    size_t stride ;
+    size_t size ;
+}
+lxMeshWeldStream_t ;
+int lxMeshWeld_remap ( uint32 * remap , lxMemoryAllocatorPTR allocator , lxJobPoolPTR pool , const lxMeshWeldStream_t * streams , int numStreams , int nVertices ) ;
+int lxMeshWeld_remapEpsilon ( uint32 * remap , lxMemoryAllocatorPTR allocator , lxJobPoolPTR pool , const float * positions , size_t posStride , float epsilon , const lxMeshWeldStream_t * streams , int numStreams , int nVertices ) ;
+int lxMeshVertices_compact ( void * dst , const void * src , size_t stride , int nVertices , const uint32 * remap ) ;
+typedef struct lxMeshLod_s
+{
+    uint32 firstIndex ;
+    uint32 numIndices ;
+    float error ;
+}
+lxMeshLod_t ;
+int lxMeshSimplify ( lxMemoryAllocatorPTR allocator , void * dstIndices , const void * indices , int nTriangles , const float * positions , size_t posStride , int nVertices , int targetTriangles , float maxError , float * outError , lxMeshIndexType_t type ) ;
+int lxMeshLodChain_build ( lxMemoryAllocatorPTR allocator , lxMeshLod_t * lods , int maxLods , void * dstIndices , size_t dstCapacity , const void * indices , int nTriangles , const float * positions , size_t posStride , int nVertices , float ratio , float maxError , lxMeshIndexType_t type ) ;
+int lxMeshLodChain_select ( const lxMeshLod_t * lods , int numLods , float distance , float pixelScale , float maxPixelError ) ;
+booln lxMeshOverdraw_optimize ( lxMemoryAllocatorPTR allocator , void * indices , int nTriangles , const float * positions , size_t posStride , int nVertices , int vcache , float threshold , lxMeshIndexType_t type ) ;
+typedef struct lxMeshStats_s
+{
+    lxVertexCacheStats_t vcache ;
+    int fetchMisses ;
+    float overfetch ;
+    int pixelsCovered ;
+    int pixelsShaded ;
+    float overdraw ;
+}
+lxMeshStats_t ;
+booln lxMeshStats_compute ( lxMeshStats_t * stats , lxMemoryAllocatorPTR allocator , const void * indices , int nTriangles , const float * positions , size_t posStride , int nVertices , size_t vertexStride , int vcache , lxMeshIndexType_t type ) ;
+size_t lxMeshStats_fetch ( lxMeshStats_t * stats , lxMemoryAllocatorPTR allocator , const void * indices , int numIndices , int nVertices , size_t vertexStride , int vcache , lxMeshIndexType_t type ) ;
+booln lxMeshStats_overdraw ( lxMeshStats_t * stats , lxMemoryAllocatorPTR allocator , const void * indices , int nTriangles , const float * positions , size_t posStride , lxMeshIndexType_t type ) ;
+typedef struct lxMeshlet_s
+{
+    uint32 vertexOffset ;
+    uint32 triangleOffset ;
+    uint32 numVertices ;
+    uint32 numTriangles ;
+    lxBoundingSphere_t sphere ;
+    lxBoundingCone_t cone ;
+}
+lxMeshlet_t ;
+typedef struct lxMeshletCullStats_s
+{
+    int meshlets ;
+    int triangles ;
+    int culledFrustum ;
+    int culledBackface ;
+    int culledTrianglesFrustum ;
+    int culledTrianglesBackface ;
+}
+lxMeshletCullStats_t ;
+int lxMeshlet_getMaxCount ( int nTriangles , int maxVertices , int maxTriangles ) ;
+int lxMeshlet_build ( lxMemoryAllocatorPTR allocator , lxMeshlet_t * meshlets , uint32 * meshletVertices , uint8 * meshletTriangles , const void * indices , int nTriangles , const float * positions , size_t posStride , int nVertices , int maxVertices , int maxTriangles , lxMeshIndexType_t type ) ;
+void lxMeshlet_computeBounds ( lxMeshlet_t * meshlet , const uint32 * meshletVertices , const uint8 * meshletTriangles , const float * positions , size_t posStride ) ;
+int lxMeshlet_cull ( uint32 * visible , const lxMeshlet_t * meshlets , int numMeshlets , lxFrustumCPTR frustum , const lxVector3 camera , lxMeshletCullStats_t * stats ) ;
+typedef enum lxMeshGenShape_e
+{
+    LUX_MESHGEN_PLANE , LUX_MESHGEN_DISC , LUX_MESHGEN_BOX , LUX_MESHGEN_SPHERE , LUX_MESHGEN_CYLINDER , LUX_MESHGEN_SHAPES , }
+lxMeshGenShape_t ;
+typedef struct lxMeshGenInstance_s
+{
+    lxMeshGenShape_t shape ;
+    int segs [ 3 ] ;
+    const float * matrix ;
+}
+lxMeshGenInstance_t ;
+typedef struct lxMeshGenTarget_s
+{
+    lxgVertexDeclCPTR decl ;
+    void * streams [ LUXGFX_MAX_VERTEX_STREAMS ] ;
+    void * indices ;
+    lxMeshIndexType_t indexType ;
+    uint32 baseVertex ;
+}
+lxMeshGenTarget_t ;
+void lxMeshGen_getCounts ( const lxMeshGenInstance_t * instances , int numInstances , int * numVertices , int * numIndices ) ;
+booln lxMeshGen_build ( const lxMeshGenTarget_t * target , const lxMeshGenInstance_t * instances , int numInstances ) ;
+typedef enum lxMeshQuantizeNormal_e
+{
+    LUX_MESHQUANTIZE_OCT8 , LUX_MESHQUANTIZE_OCT16 , LUX_MESHQUANTIZE_NORMALS , }
+lxMeshQuantizeNormal_t ;
+typedef struct lxMeshQuantizeInput_s
+{
+    const float * positions ;
+    size_t posStride ;
+    const float * normals ;
+    size_t normalStride ;
+    const float * tangents ;
+    size_t tangentStride ;
+    const float * uvs ;
+    size_t uvStride ;
+    int numVertices ;
+}
+lxMeshQuantizeInput_t ;
+typedef struct lxMeshQuantizeStats_s
+{
+    float posMaxError ;
+    float posAvgError ;
+    float normalMaxAngle ;
+    float normalAvgAngle ;
+    float tangentMaxAngle ;
+    float uvMaxError ;
+    size_t bytesInput ;
+    size_t bytesOutput ;
+}
+lxMeshQuantizeStats_t ;
+typedef struct lxMeshQuantize_s
+{
+    lxgVertexDecl_t decl ;
+    uint vertexSize ;
+    lxBoundingBox_t bbox ;
+    lxMatrix44 dequant ;
+    lxMeshQuantizeStats_t stats ;
+}
+lxMeshQuantize_t ;
+void lxMeshQuantize_init ( lxMeshQuantize_t * quant , const lxMeshQuantizeInput_t * input , lxMeshQuantizeNormal_t normalType ) ;
+booln lxMeshQuantize_run ( lxMeshQuantize_t * quant , void * dst , const lxMeshQuantizeInput_t * input , lxMeshQuantizeNormal_t normalType ) ;
+enum
+{
+    LUX_MESHCODEC_VERSION = 0xE1 , LUX_MESHCODEC_EDGES = 15 , LUX_MESHCODEC_VERTICES = 14 , LUX_MESHCODEC_MAX_RECORD = 16 , }
+;
+typedef struct lxMeshIndexDecoder_s
+{
+    uint32 edges [ 16 ] [ 2 ] ;
+    uint32 vertices [ 16 ] ;
+    uint edgeOffset ;
+    uint vertexOffset ;
+    uint32 next ;
+    uint32 last ;
+    booln started ;
+    uint carrySize ;
+    byte carry [ LUX_MESHCODEC_MAX_RECORD ] ;
+}
+lxMeshIndexDecoder_t ;
+size_t lxMeshIndexCodec_getMaxSize ( int numIndices ) ;
+size_t lxMeshIndexCodec_encode ( void * dst , size_t dstSize , const void * indices , int numIndices , lxMeshIndexType_t type ) ;
+booln lxMeshIndexCodec_decode ( void * dst , int numIndices , const void * src , size_t srcSize , lxMeshIndexType_t type ) ;
+void lxMeshIndexDecoder_init ( lxMeshIndexDecoder_t * dec ) ;
+int lxMeshIndexDecoder_run ( lxMeshIndexDecoder_t * dec , void * dst , int maxIndices , const void * src , size_t srcSize , size_t * srcUsed , lxMeshIndexType_t type ) ;
+enum
+{
+    LUX_BVH_MAX_DEPTH = 64 , LUX_BVH_BINS = 16 , LUX_BVH_LEAFSIZE = 4 , LUX_BVH_NOHIT = 0xFFFFFFFF , }
+;
+typedef struct lxBVHNode_s
+{
+    float min [ 3 ] ;
+    uint32 first ;
+    float max [ 3 ] ;
+    uint32 count ;
+}
+lxBVHNode_t ;
+typedef struct lxBVH_s
+{
+    lxMemoryAllocatorPTR allocator ;
+    lxBVHNode_t * nodes ;
+    uint32 numNodes ;
+    uint32 numNodesAllocated ;
+    uint32 * prims ;
+    uint32 numPrims ;
+    uint32 numPrimsAllocated ;
+    uint32 depth ;
+}
+lxBVH_t ;
+typedef struct lxBVHTriangles_s
+{
+    const float * positions ;
+    size_t posStride ;
+    const void * indices ;
+    lxMeshIndexType_t indexType ;
+    uint32 numTriangles ;
+}
+lxBVHTriangles_t ;
+typedef struct lxBVHHit_s
+{
+    float t ;
+    float u ;
+    float v ;
+    uint32 prim ;
+}
+lxBVHHit_t ;
+void lxBVH_init ( lxBVH_t * bvh , lxMemoryAllocatorPTR allocator ) ;
+void lxBVH_deinit ( lxBVH_t * bvh ) ;
+booln lxBVH_buildBoxes ( lxBVH_t * bvh , lxJobPoolPTR pool , const lxBoundingBox_t * boxes , size_t boxStride , uint32 numBoxes , int maxLeafSize ) ;
+booln lxBVH_buildTriangles ( lxBVH_t * bvh , lxJobPoolPTR pool , const lxBVHTriangles_t * tris , int maxLeafSize ) ;
+void lxBVH_refitBoxes ( lxBVH_t * bvh , const lxBoundingBox_t * boxes , size_t boxStride ) ;
+void lxBVH_refitTriangles ( lxBVH_t * bvh , const lxBVHTriangles_t * tris ) ;
+booln lxBVH_rayTriangles ( const lxBVH_t * bvh , const lxBVHTriangles_t * tris , const lxVector3 origin , const lxVector3 dir , float maxDist , lxBVHHit_t * hit ) ;
+booln lxBVH_rayBoxes ( const lxBVH_t * bvh , const lxBoundingBox_t * boxes , size_t boxStride , const lxVector3 origin , const lxVector3 dir , float maxDist , lxBVHHit_t * hit ) ;
+uint32 lxBVH_cullFrustum ( const lxBVH_t * bvh , lxFrustumCPTR frustum , uint32 * prims , uint32 maxPrims ) ;
+float lxBVH_getCost ( const lxBVH_t * bvh ) ;
+enum
+{
+    LUX_SHADER_UPDATELEVELS = 4 , LUX_SHADER_ASSIGNS = 4 , }
+;
+typedef struct lxShaderParameter_s
+{
+    lxStrDictKey namekey ;
+    lxGLParameterType_t type ;
+    uint progOffset ;
+    uint progCount ;
+}
+lxShaderParameter_t ;
+typedef int32 lxShaderIndex ;
+typedef struct lxShaderProgram_s
+{
+    lxgProgramPTR program ;
+    booln hasMulti ;
+    uint numParams ;
+    lxShaderParameter_t * params ;
+    uint numProgParams ;
+    lxgProgramParameter_t * * progParams ;
+    lxStrDictPTR dict ;
+    lxContHashPTR paramHash ;
+    uint numGpuProgParams ;
+    lxgProgramParameter_t * * gpuProgParams ;
+    uint numAddProgParams ;
+    lxgProgramParameter_t * * addProgParams ;
+}
+lxShaderProgram_t ;
+void lxShaderProgram_init ( lxShaderProgram_t * shader , lxStrDictPTR dict , lxgProgramPTR program , int numProgParams , lxgProgramParameterPTR * gpuProgParams ) ;
+uint lxShaderProgram_getParameterCount ( lxShaderProgram_t * shader ) ;
+size_t lxShaderProgram_getMemSize ( lxShaderProgram_t * shader ) ;
+void lxShaderProgram_initMem ( lxShaderProgram_t * shader , size_t size , void * buffer ) ;
+void lxShaderProgram_initParameters ( lxShaderProgram_t * shader , lxgProgramParameter_t * * optionalSort ) ;
+lxContHashPTR lxShaderProgram_useHash ( lxShaderProgram_t * shader , lxContHashPTR hash ) ;
+lxShaderIndex lxShaderProgram_getUpdateIndex ( lxShaderProgram_t * shader , lxStrDictKey namekey , lxGLParameterType_t type ) ;
+typedef struct lxShaderAssign_s
+{
+    uint32 shaderID ;
+    lxShaderIndex * indices ;
+}
+lxShaderAssign_t ;
+typedef struct lxShaderParameterContainer_s
+{
+    uint32 numParams ;
+    lxStrDictKey * keys ;
+    void * * datas ;
+    lxGLParameterType_t * types ;
+}
+lxShaderParameterContainer_t ;
+typedef struct lxShaderLevel_s
+{
+    uint32 numParams ;
+    void * * datas ;
+    lxShaderAssign_t assigns [ LUX_SHADER_ASSIGNS ] ;
+    uint32 numContainers ;
+    lxShaderParameterContainer_t * * containers ;
+}
+lxShaderLevel_t ;
+struct lxShaderUpdate_s ;
+typedef uint ( lxShaderUpdateBuild_fn ) ( struct lxShaderUpdate_s * update ) ;
+typedef struct lxShaderUpdate_s
+{
+    lxShaderUpdateBuild_fn * funcBuildProgramParams ;
+    lxShaderProgram_t * shader ;
+    uint32 numParams ;
+    uint32 numProgParams ;
+    int32 level ;
+    void * * buildDatas ;
+    void * * levelDatas [ LUX_SHADER_UPDATELEVELS * 2 ] ;
+    int32 dirtyMinMax [ 2 ] ;
+    int32 levelMinMax [ LUX_SHADER_UPDATELEVELS ] [ 2 ] ;
+    lxgProgramParameter_t * * progParams ;
+    void * * progDatas ;
+    booln trackContent ;
+    uint32 contentSize ;
+    uint32 * contentOffsets ;
+    byte * contentDatas ;
+}
+lxShaderUpdate_t ;
+void lxShaderUpdate_init ( lxShaderUpdate_t * update , lxShaderProgram_t * program ) ;
+size_t lxShaderUpdate_getMemSize ( lxShaderUpdate_t * update ) ;
+void lxShaderUpdate_initMem ( lxShaderUpdate_t * update , size_t size , void * buffer ) ;
+void lxShaderUpdate_trackContent ( lxShaderUpdate_t * update , booln state ) ;
+void lxShaderUpdate_pushData ( lxShaderUpdate_t * update , uint num , lxShaderIndex * paramIndices , void * * data ) ;
+void lxShaderUpdate_popData ( lxShaderUpdate_t * update ) ;
+uint lxShaderUpdate_buildProgramParams ( lxShaderUpdate_t * update ) ;
+typedef struct lxShaderBlockEntry_s
+{
+    lxGLParameterType_t type ;
+    uint32 count ;
+    uint32 offset ;
+    uint16 vectors ;
+    uint16 vectorSize ;
+}
+lxShaderBlockEntry_t ;
+typedef struct lxShaderBlock_s
+{
+    uint32 numEntries ;
+    lxShaderBlockEntry_t * entries ;
+    uint32 size ;
+}
+lxShaderBlock_t ;
+uint32 lxShaderBlock_layout ( lxShaderBlock_t * block , lxShaderBlockEntry_t * entries , uint num ) ;
+uint32 lxShaderBlock_initShader ( lxShaderBlock_t * block , lxShaderBlockEntry_t * entries , lxShaderProgram_t * shader , uint num , const lxShaderIndex * indices ) ;
+void lxShaderBlock_pack ( const lxShaderBlock_t * block , void * * datas , void * dst ) ;
+uint32 lxShaderBlock_packRing ( const lxShaderBlock_t * block , void * * datas , lxgBufferRing_t * ring ) ;
+void lxShaderBlock_bind ( const lxShaderBlock_t * block , lxgContextPTR ctx , lxgBufferPTR buffer , uint unit , uint32 offset ) ;
+typedef struct lxDrawBounding_s
+{
+    lxBoundingSphere_t bsphere ;
+    lxBoundingBox_t bbox ;
+}
+lxDrawBounding_t ;
+enum
+{
+    LUX_DRAWSPATIAL_ROOT = 0 , LUX_DRAWSPATIAL_NONE = 0xFFFFFFFF , }
+;
+typedef struct lxDrawSpatial_s
+{
+    lxMemoryAllocatorPTR allocator ;
+    uint32 numSlots ;
+    uint32 numSlotsAllocated ;
+    lxMatrix44SIMD * localMatrices ;
+    lxMatrix44SIMD * worldMatrices ;
+    lxDrawBounding_t * localBoundings ;
+    lxDrawBounding_t * worldBoundings ;
+    uint32 * parents ;
+    uint32 * subtreeEnds ;
+    uint32 * slotNodes ;
+    byte * slotFlags ;
+    uint32 numNodes ;
+    uint32 numNodesAllocated ;
+    uint32 * nodeSlots ;
+    uint32 * nodeParents ;
+    uint32 * freeNodes ;
+    uint32 numFree ;
+    uint32 * dirty ;
+    uint32 numDirty ;
+    booln reorder ;
+    lxBoundingBox_t * treeBoxes ;
+    uint32 * itemFirst ;
+    uint32 * refit ;
+    uint32 numRefit ;
+    uint32 numItems ;
+    uint32 numItemsAllocated ;
+    struct lxDrawItem_s * items ;
+    lxDrawBounding_t * itemLocalBoundings ;
+    lxDrawBounding_t * itemWorldBoundings ;
+    uint32 * itemIDs ;
+    uint32 numItemIDs ;
+    uint32 numItemIDsAllocated ;
+    uint32 * itemPositions ;
+    uint32 * itemNodes ;
+    uint32 * freeItems ;
+    uint32 numFreeItems ;
+    booln itemsReorder ;
+}
+lxDrawSpatial_t ;
+typedef struct lxDrawInfo_s
+{
+    lxGLPrimitiveType_t primitive ;
+    uint32 instanceCount ;
+    uint32 primCount ;
+    uint32 firstOffset ;
+    int32 vertexBase ;
+    uint32 vertexBaseOffset ;
+}
+lxDrawInfo_t ;
+typedef struct lxDrawGeometry_s
+{
+    uint32 geometryID ;
+    lxgVertexDeclPTR vertexDecl ;
+    lxScalarType_t indexType ;
+    lxgStreamHost_t indexStream ;
+    lxgStreamHost_t vertexStreams [ LUXGFX_MAX_VERTEX_STREAMS ] ;
+}
+lxDrawGeometry_t ;
+typedef struct lxDrawItem_s
+{
+    flags32 userFlags ;
+    uint32 sortKey ;
+    uint32 geometryID ;
+    uint32 materialID ;
+    lxDrawInfo_t drawinfo ;
+    lxDrawGeometry_t * geometry ;
+    lxShaderLevel_t itemLevel ;
+    lxDrawSpatial_t * spatial ;
+    uint32 spatialNode ;
+}
+lxDrawItem_t ;
+void lxDrawSpatial_init ( lxDrawSpatial_t * spatial , lxMemoryAllocatorPTR allocator ) ;
+void lxDrawSpatial_deinit ( lxDrawSpatial_t * spatial ) ;
+void lxDrawSpatial_reserve ( lxDrawSpatial_t * spatial , uint32 numNodes ) ;
+uint32 lxDrawSpatial_addNode ( lxDrawSpatial_t * spatial , uint32 parent ) ;
+void lxDrawSpatial_remNode ( lxDrawSpatial_t * spatial , uint32 node ) ;
+booln lxDrawSpatial_setParent ( lxDrawSpatial_t * spatial , uint32 node , uint32 parent ) ;
+uint32 lxDrawSpatial_getParent ( const lxDrawSpatial_t * spatial , uint32 node ) ;
+void lxDrawSpatial_setLocalMatrix ( lxDrawSpatial_t * spatial , uint32 node , lxMatrix44CPTR matrix ) ;
+lxMatrix44CPTR lxDrawSpatial_getLocalMatrix ( const lxDrawSpatial_t * spatial , uint32 node ) ;
+lxMatrix44CPTR lxDrawSpatial_getWorldMatrix ( const lxDrawSpatial_t * spatial , uint32 node ) ;
+void lxDrawSpatial_setBounding ( lxDrawSpatial_t * spatial , uint32 node , const lxDrawBounding_t * bounding ) ;
+void lxDrawSpatial_addBounding ( lxDrawSpatial_t * spatial , uint32 node , const lxDrawBounding_t * bounding ) ;
+const lxDrawBounding_t * lxDrawSpatial_getWorldBounding ( const lxDrawSpatial_t * spatial , uint32 node ) ;
+void lxDrawSpatial_updateTree ( lxDrawSpatial_t * spatial ) ;
+uint32 lxDrawSpatial_addItem ( lxDrawSpatial_t * spatial , uint32 node , const lxDrawItem_t * item , const lxDrawBounding_t * bounding ) ;
+void lxDrawSpatial_remItem ( lxDrawSpatial_t * spatial , uint32 item ) ;
+void lxDrawSpatial_setItemBounding ( lxDrawSpatial_t * spatial , uint32 item , const lxDrawBounding_t * bounding ) ;
+lxDrawItem_t * lxDrawSpatial_getItem ( lxDrawSpatial_t * spatial , uint32 item ) ;
+const lxDrawBounding_t * lxDrawSpatial_getItemWorldBounding ( const lxDrawSpatial_t * spatial , uint32 item ) ;
+uint32 lxDrawSpatial_getVisibleItems ( const lxDrawSpatial_t * spatial , lxFrustumCPTR frustum , lxDrawItem_t * itembuffer , uint32 maxItems ) ;
+uint32 lxDrawSpatial_getVisibleIDs ( const lxDrawSpatial_t * spatial , lxFrustumCPTR frustum , uint32 * ids , uint32 maxItems ) ;
+typedef struct lxDrawSpatialView_s
+{
+    lxFrustumCPTR frustum ;
+    lxDrawItem_t * items ;
+    uint32 * ids ;
+    uint32 maxItems ;
+    uint32 numItems ;
+}
+lxDrawSpatialView_t ;
+void lxDrawSpatial_cullViews ( const lxDrawSpatial_t * spatial , lxJobPoolPTR pool , lxDrawSpatialView_t * views , uint32 numViews ) ;
+void lxDrawItem_init ( lxDrawItem_t * draw , lxDrawGeometry_t * geometry , uint32 materialID , lxDrawSpatial_t * spatial ) ;
+void lxDrawItem_setGeometry ( lxDrawItem_t * draw ) ;
+void lxDrawItem_setMaterialID ( lxDrawItem_t * draw ) ;
+void lxDrawItem_setSpatial ( lxDrawItem_t * draw ) ;
+void lxDrawItem_update ( lxDrawItem_t * draw ) ;
+void lxDrawItem_deinit ( lxDrawItem_t * draw ) ;
+typedef enum lxDrawKeyField_e
+{
+    LUX_DRAWKEY_LAYER , LUX_DRAWKEY_TRANSLUCENT , LUX_DRAWKEY_DEPTH , LUX_DRAWKEY_SHADER , LUX_DRAWKEY_MATERIAL , LUX_DRAWKEY_GEOMETRY , LUX_DRAWKEY_FIELDS , }
+lxDrawKeyField_t ;
+typedef enum lxDrawDepthOrder_e
+{
+    LUX_DRAWDEPTH_FRONTTOBACK , LUX_DRAWDEPTH_BACKTOFRONT , }
+lxDrawDepthOrder_t ;
+typedef struct lxDrawKeyLayout_s
+{
+    struct
+    {
+        lxDrawKeyField_t field ;
+        uint32 bits ;
+    }
+    fields [ LUX_DRAWKEY_FIELDS ] ;
+    int numFields ;
+    lxDrawDepthOrder_t opaqueDepth ;
+    lxDrawDepthOrder_t translucentDepth ;
+    float depthNear ;
+    float depthFar ;
+}
+lxDrawKeyLayout_t ;
+typedef struct lxDrawKeyInput_s
+{
+    uint32 layer ;
+    uint32 shader ;
+    booln translucent ;
+    float depth ;
+}
+lxDrawKeyInput_t ;
+typedef struct lxDrawQueue_s
+{
+    lxMemoryAllocatorPTR allocator ;
+    lxDrawKeyLayout_t layout ;
+    uint32 shifts [ LUX_DRAWKEY_FIELDS ] ;
+    uint64 masks [ LUX_DRAWKEY_FIELDS ] ;
+    uint32 keyBits ;
+    float depthScale ;
+    uint32 numItems ;
+    uint32 numAllocated ;
+    const lxDrawItem_t * * items ;
+    uint32 * keysLo ;
+    uint32 * keysHi ;
+    uint32 * indices ;
+    uint32 * indicesTemp ;
+    const uint32 * sorted ;
+}
+lxDrawQueue_t ;
+booln lxDrawQueue_init ( lxDrawQueue_t * queue , lxMemoryAllocatorPTR allocator , const lxDrawKeyLayout_t * layout ) ;
+void lxDrawQueue_deinit ( lxDrawQueue_t * queue ) ;
+void lxDrawQueue_reserve ( lxDrawQueue_t * queue , uint32 numItems ) ;
+void lxDrawQueue_reset ( lxDrawQueue_t * queue ) ;
+void lxDrawQueue_addItems ( lxDrawQueue_t * queue , const lxDrawItem_t * items , const lxDrawKeyInput_t * inputs , uint32 count ) ;
+uint64 lxDrawQueue_makeKey ( const lxDrawQueue_t * queue , const lxDrawItem_t * item , const lxDrawKeyInput_t * input ) ;
+const uint32 * lxDrawQueue_sort ( lxDrawQueue_t * queue ) ;
+uint64 lxDrawQueue_getKey ( const lxDrawQueue_t * queue , uint32 index ) ;
+const lxDrawItem_t * lxDrawQueue_getSorted ( const lxDrawQueue_t * queue , uint32 i ) ;
+typedef struct lxDrawBatch_s
+{
+    const lxDrawItem_t * item ;
+    lxDrawInfo_t drawinfo ;
+    uint32 firstInstance ;
+}
+lxDrawBatch_t ;
+uint32 lxDrawBatch_build ( lxDrawBatch_t * batches , float * instances , const lxDrawItem_t * const * items , const uint32 * order , uint32 numItems ) ;
+uint32 lxDrawBatch_buildBuffer ( lxDrawBatch_t * batches , lxgBufferPTR buffer , uint offset , const lxDrawItem_t * const * items , const uint32 * order , uint32 numItems ) ;
+booln lxDrawGeometry_optimize ( lxDrawGeometry_t * geometry , lxVertexCacheOpt_t * ctx , int vcache , float overdrawThreshold ) ;
+int lxDrawGeometry_weld ( lxDrawGeometry_t * geometry , lxMemoryAllocatorPTR allocator , lxJobPoolPTR pool , float epsilon ) ;
+booln lxDrawGeometry_computeStats ( const lxDrawGeometry_t * geometry , lxMemoryAllocatorPTR allocator , int vcache , lxMeshStats_t * stats ) ;
+enum
+{
+    LUX_MESHFILE_MAGIC = 0x464D584C , LUX_MESHFILE_VERSION = 1 , LUX_MESHFILE_ALIGN = 16 , LUX_MESHFILE_ENDIAN = 0x01020304 , }
+;
+typedef enum lxMeshFileError_e
+{
+    LUX_MESHFILE_ERROR_NONE , LUX_MESHFILE_ERROR_SIZE , LUX_MESHFILE_ERROR_MAGIC , LUX_MESHFILE_ERROR_VERSION , LUX_MESHFILE_ERROR_PLATFORM , LUX_MESHFILE_ERROR_RANGE , LUX_MESHFILE_ERROR_DECL , LUX_MESHFILE_ERROR_LODS , LUX_MESHFILE_ERROR_INDICES , LUX_MESHFILE_ERRORS , }
+lxMeshFileError_t ;
+typedef struct lxMeshFileRange_s
+{
+    uint64 offset ;
+    uint64 size ;
+}
+lxMeshFileRange_t ;
+typedef struct lxMeshFileHeader_s
+{
+    uint32 magic ;
+    uint32 version ;
+    uint32 endian ;
+    uint32 elementProbe ;
+    uint32 headerSize ;
+    uint32 indexType ;
+    uint32 numIndices ;
+    uint32 numVertices ;
+    uint32 numLods ;
+    uint32 _pad ;
+    uint64 fileSize ;
+    lxDrawBounding_t bounding ;
+    lxMeshFileRange_t decl ;
+    lxMeshFileRange_t lods ;
+    lxMeshFileRange_t indices ;
+    lxMeshFileRange_t streams [ LUXGFX_MAX_VERTEX_STREAMS ] ;
+}
+lxMeshFileHeader_t ;
+size_t lxMeshFile_getSize ( const lxDrawGeometry_t * geometry , int numLods ) ;
+size_t lxMeshFile_write ( void * dst , size_t dstSize , const lxDrawGeometry_t * geometry , const lxDrawBounding_t * bounding , const lxMeshLod_t * lods , int numLods ) ;
+lxMeshFileError_t lxMeshFile_validate ( const void * data , size_t size , booln checkIndices ) ;
+lxMeshFileError_t lxMeshFile_load ( const void * data , size_t size , lxDrawGeometry_t * geometry , const lxMeshFileHeader_t * * header ) ;
+const lxMeshLod_t * lxMeshFile_getLods ( const lxMeshFileHeader_t * header ) ;
 ]]
 
 return ffi.load("luxbackend")